@@ -1,5 +1,9 @@
 #include "TestApp.h"
 
+#include "../engine/core/FrameArena.h"
+#include "../engine/core/Profiler.h"
+#include "../engine/opengl/GpuProfiler.h"
+
 test::TestMenu::TestMenu(TestApp *&currentTestPointer)
     : m_currentTest(currentTestPointer) 
 {
@@ -18,4 +22,73 @@ void test::TestMenu::onGuiRender()
             m_currentTest = test.second();
         }
     }
-}
\ No newline at end of file
+}
+
+test::TestApp* test::TestMenu::create(const std::string &name) const
+{
+    for (auto &test : m_tests) {
+        if (test.first == name) {
+            return test.second();
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> test::TestMenu::names() const
+{
+    std::vector<std::string> result;
+    for (auto &test : m_tests) {
+        result.push_back(test.first);
+    }
+    return result;
+}
+
+void test::runFrame(TestApp &app, FramePipeline &pipeline, float deltaTime, const std::function<void()> &gui)
+{
+    if (!pipeline.enabled() || !app.pipelined()) {
+        FrameArena::get().nextFrame();
+        {
+            PROFILE_SCOPE("onUpdate");
+            app.onUpdate(deltaTime);
+        }
+        app.onPublish();
+        {
+            PROFILE_SCOPE("onRender");
+            PROFILE_GPU_SCOPE("onRender");
+            app.onRender();
+        }
+        if (gui) {
+            gui();
+        }
+        return;
+    }
+
+    if (pipeline.pending()) {
+        PROFILE_SCOPE("syncUpdate");
+        pipeline.sync();
+    }
+    else {
+        PROFILE_SCOPE("onUpdate");
+        app.onUpdate(deltaTime);
+    }
+    // no update is running: frame arenas can flip, the update's allocations stay valid for the render
+    FrameArena::get().nextFrame();
+    app.onPublish();
+
+    // the app is not shared with a worker until the kick
+    if (gui) {
+        gui();
+    }
+
+    TestApp *next = &app;
+    pipeline.kick([next, deltaTime]() {
+        PROFILE_SCOPE("onUpdate");
+        next->onUpdate(deltaTime);
+    });
+
+    {
+        PROFILE_SCOPE("onRender");
+        PROFILE_GPU_SCOPE("onRender");
+        app.onRender();
+    }
+}
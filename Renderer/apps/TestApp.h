@@ -1,8 +1,10 @@
 #pragma once
 
 #include "../engine/Gui/gui.h"
+#include "../engine/core/FramePipeline.h"
 
 #include <functional>
+#include <string>
 #include <vector>
 
 namespace test {
@@ -37,6 +39,23 @@ namespace test {
          * 
          */
         virtual void onGuiRender() {}
+
+        /**
+         * @brief True when onUpdate may run on a worker while onRender draws the frame before
+         * 
+         * onUpdate must then leave GL alone and only write the next frame packet (see
+         * FramePackets); onRender and onGuiRender only read the published one.
+         * 
+         */
+        virtual bool pipelined() const { return false; }
+
+        /**
+         * @brief Called on the render thread once the update finished, before onRender
+         * 
+         * This is where the packet written by onUpdate becomes the one to render
+         * 
+         */
+        virtual void onPublish() {}
     };
 
     class TestMenu  : public TestApp
@@ -52,11 +71,38 @@ namespace test {
             std::cout << "Registering test " << name << std::endl;
             m_tests.push_back(std::make_pair(name, []() { return new T(); }));
         }
-        
+
+        /**
+         * @brief Creates the test registered as `name`
+         * 
+         * @return the new test (owned by the caller) or nullptr if there is no such test
+         */
+        TestApp* create(const std::string &name) const;
+
+        std::vector<std::string> names() const;
+
 
     private:
         TestApp *&m_currentTest;
         std::vector<std::pair<std::string, std::function<TestApp *()>>> m_tests;
     };
 
+    /**
+     * @brief Registers every test with the menu, shared by all front-ends
+     */
+    void registerTests(TestMenu &menu);
+
+    /**
+     * @brief Runs one frame of `app`, shared by all front-ends
+     * 
+     * Serially: onUpdate, onPublish, onRender, then `gui`. Pipelined (the pipeline is enabled and the
+     * app supports it): wait for the update of this frame, publish it, run `gui`, start the
+     * update of the next frame on the job system and render this one meanwhile. An app
+     * without an update in flight (its first frame) gets one inline first.
+     * Either way the FrameArena starts its next frame here, at a point no update is running.
+     * 
+     * Sync the pipeline before deleting an app that went through here.
+     */
+    void runFrame(TestApp &app, FramePipeline &pipeline, float deltaTime, const std::function<void()> &gui = {});
+
 } // namespace test
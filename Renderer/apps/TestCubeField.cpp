@@ -0,0 +1,172 @@
+#include "TestCubeField.h"
+
+#include "../engine/core/ThreadPool.h"
+#include "../engine/math/Frustum.h"
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+
+test::TestCubeField::TestCubeField()
+    : m_cube(std::make_unique<Cube>(CubeType::POS_TEX)),
+      m_scene(),
+      m_entities(),
+      m_radii(),
+      m_speeds(),
+      m_phases(),
+      m_heights(),
+      m_spinAxes(),
+      m_packets(),
+      m_recordLists(false),
+      m_lists(),
+      m_queue(),
+      m_executor(),
+      m_recordWallMs(0.0),
+
+      m_time(0.0f),
+      m_fov(60.0f),
+      m_cameraSpeed(0.1f)
+{
+    std::filesystem::path path = std::filesystem::current_path();
+    std::string texturePath = path.string() + "/assets/images/container.jpg";
+    std::string vertPath = path.string() + "/assets/shaders/texture/cube.vert";
+    std::string fragPath = path.string() + "/assets/shaders/texture/cube.frag";
+
+    m_cube->setShaders(vertPath, fragPath);
+    m_cube->setTexture(texturePath);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    m_scene.reserve(kCubes);
+    m_entities.reserve(kCubes);
+    for (size_t i = 0; i < kCubes; i++) {
+        Entity entity = m_scene.create();
+        m_scene.transforms().add(entity, { glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.4f) });
+        m_scene.bounds().add(entity, Bounds());
+        m_entities.push_back(entity);
+
+        m_radii.push_back(4.0f + 56.0f * std::sqrt(unit(rng)));
+        m_speeds.push_back((0.2f + unit(rng)) * (unit(rng) < 0.5f ? -1.0f : 1.0f) / std::sqrt(m_radii.back()));
+        m_phases.push_back(6.2831853f * unit(rng));
+        m_heights.push_back(8.0f * (unit(rng) - 0.5f));
+        m_spinAxes.push_back(glm::normalize(glm::vec3(unit(rng) - 0.5f, 1.0f, unit(rng) - 0.5f)));
+    }
+
+    for (int i = 0; i < 2; i++) {
+        m_packets.write().mvps.reserve(kCubes);
+        m_packets.publish();
+    }
+
+    for (unsigned int i = 0; i < ThreadPool::get().threadCount(); i++) {
+        m_lists.push_back(std::make_unique<CommandList>());
+    }
+}
+
+test::TestCubeField::~TestCubeField() {}
+
+void test::TestCubeField::onUpdate(float deltaTime) {
+    m_time += deltaTime;
+
+    const float time = m_time;
+    // two captures keep the std::function from allocating
+    ThreadPool::get().parallelFor(m_entities.size(), 1024, [this, time](size_t begin, size_t end) {
+        TransformStorage& transforms = m_scene.transforms();
+        for (size_t e = begin; e < end; e++) {
+            const uint32_t i = transforms.index(m_entities[e]);
+            const float angle = m_phases[e] + m_speeds[e] * time;
+            transforms.positions[i] = glm::vec3(m_radii[e] * std::cos(angle), m_heights[e] + std::sin(angle * 3.0f), m_radii[e] * std::sin(angle));
+            transforms.rotations[i] = glm::angleAxis(angle * 4.0f, m_spinAxes[e]);
+        }
+    });
+    m_scene.updateTransforms();
+    m_scene.updateBounds();
+
+    const TransformStorage& transforms = m_scene.transforms();
+
+    const float cameraAngle = m_cameraSpeed * time;
+    const glm::vec3 eye(70.0f * std::cos(cameraAngle), 30.0f, 70.0f * std::sin(cameraAngle));
+    const glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(m_fov), (float)1200 / (float)900, 0.1f, 200.0f);
+    const glm::mat4 viewProjection = projection * view;
+    const Frustum frustum(viewProjection);
+
+    CubeFieldPacket& packet = m_packets.write();
+    packet.mvps.clear();
+    packet.simulated = m_entities.size();
+    packet.time = time;
+
+    const BoundsStorage& bounds = m_scene.bounds();
+    const Entity* entities = bounds.entities();
+    for (size_t i = 0; i < bounds.size(); i++) {
+        if (frustum.intersectsBox(bounds.worldMins[i], bounds.worldMaxs[i])) {
+            packet.mvps.push_back(viewProjection * transforms.worlds[transforms.index(entities[i])]);
+        }
+    }
+}
+
+void test::TestCubeField::onRender() {
+    const CubeFieldPacket& packet = m_packets.read();
+    if (m_recordLists) {
+        _renderRecorded(packet);
+        return;
+    }
+
+    m_cube->bindTexture();
+    m_cube->useShader();
+    for (const glm::mat4& mvp : packet.mvps) {
+        m_cube->getShader().setUniform("mvp", mvp);
+        m_cube->draw();
+    }
+}
+
+void test::TestCubeField::onGuiRender() {
+    const CubeFieldPacket& packet = m_packets.read();
+    ImGui::Text("%zu cubes, %zu visible", packet.simulated, packet.mvps.size());
+    ImGui::SliderFloat("FOV", &m_fov, 20.0f, 120.0f);
+    ImGui::SliderFloat("Camera speed", &m_cameraSpeed, 0.0f, 1.0f);
+
+    ImGui::Checkbox("Record command lists", &m_recordLists);
+    if (m_recordLists) {
+        const CommandReplayStats& stats = m_executor.stats();
+        ImGui::Text("record %.3f ms wall (%.3f ms over %zu lists), sort %.3f ms, replay %.3f ms",
+                    m_recordWallMs, m_queue.recordMs(), m_queue.listCount(), m_queue.sortMs(), stats.replayMs);
+        ImGui::Text("%llu draws, %llu uniform uploads, %llu redundant changes skipped",
+                    (unsigned long long)stats.draws, (unsigned long long)stats.uniformUploads,
+                    (unsigned long long)stats.redundantSkipped);
+    }
+}
+
+void test::TestCubeField::_renderRecorded(const CubeFieldPacket& packet) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t chunks = m_lists.size();
+    const CubeFieldPacket* source = &packet;
+    ThreadPool::get().parallelFor(chunks, 1, [this, source](size_t begin, size_t end) {
+        const size_t chunks = m_lists.size();
+        const size_t count = source->mvps.size();
+        const uint32_t shader = m_cube->getShader().id();
+        for (size_t c = begin; c < end; c++) {
+            CommandList& list = *m_lists[c];
+            list.begin();
+            m_cube->bindTexture(list);
+            m_cube->useShader(list);
+            for (size_t i = count * c / chunks; i < count * (c + 1) / chunks; i++) {
+                const glm::mat4& mvp = source->mvps[i];
+                // clip w of the cube center is its view depth: front to back
+                list.setSortKey(make_sort_key(0, shader, 0, mvp[3][3] / 200.0f));
+                list.setUniform("mvp", mvp);
+                m_cube->draw(list);
+            }
+            list.end();
+        }
+    });
+    m_recordWallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    m_queue.clear();
+    for (const std::unique_ptr<CommandList>& list : m_lists) {
+        m_queue.submit(*list);
+    }
+    m_queue.sort();
+    m_executor.execute(m_queue);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../engine/Gui/gui.h"
+#include "../engine/opengl/OpenGLApp.h"
+#include "TestApp.h"
+
+#include "../engine/core/Cube.hpp"
+#include "../engine/core/FramePipeline.h"
+#include "../engine/opengl/GLCommandExecutor.h"
+#include "../engine/render/CommandList.h"
+#include "../engine/scene/Scene.h"
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace test {
+
+    /**
+     * @brief What the update hands to the render: one MVP per cube that passed culling
+     */
+    struct CubeFieldPacket {
+        std::vector<glm::mat4> mvps;
+        size_t simulated = 0;
+        float time = 0.0f;
+    };
+
+    /**
+     * @brief Thousands of orbiting cubes, CPU-bound on simulation, culling and draw submission
+     * 
+     * onUpdate moves every cube, updates the scene transforms and bounds, culls against
+     * the frustum and writes the MVPs of the survivors into the frame packet. It never
+     * touches GL, so it can run pipelined: onRender submits the previous packet meanwhile.
+     * With "Record command lists" onRender records the draws on the thread pool, one list
+     * per chunk, and replays them front to back instead of issuing them directly.
+     */
+    class TestCubeField : public TestApp {
+    public:
+        static constexpr size_t kCubes = 16384;
+
+        TestCubeField();
+        ~TestCubeField();
+
+        void onUpdate(float deltaTime) override;
+
+        void onRender() override;
+
+        void onGuiRender() override;
+
+        bool pipelined() const override { return true; }
+
+        void onPublish() override { m_packets.publish(); }
+
+    private:
+        std::unique_ptr<Cube> m_cube;
+        Scene m_scene;
+        std::vector<Entity> m_entities;
+
+        // per cube orbit, in scene transform order
+        std::vector<float> m_radii;
+        std::vector<float> m_speeds;
+        std::vector<float> m_phases;
+        std::vector<float> m_heights;
+        std::vector<glm::vec3> m_spinAxes;
+
+        FramePackets<CubeFieldPacket> m_packets;
+
+        bool m_recordLists;
+        std::vector<std::unique_ptr<CommandList>> m_lists;
+        CommandQueue m_queue;
+        GLCommandExecutor m_executor;
+        double m_recordWallMs;
+
+        float m_time;
+        float m_fov;
+        float m_cameraSpeed;
+
+        void _renderRecorded(const CubeFieldPacket& packet);
+    };
+}
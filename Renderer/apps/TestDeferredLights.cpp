@@ -0,0 +1,114 @@
+#include "TestDeferredLights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+test::TestDeferredLights::TestDeferredLights()
+    : m_cube(std::make_unique<Cube>(CubeType::POS_NORM)),
+      m_renderer(),
+      m_boxes(),
+      m_radii(),
+      m_speeds(),
+      m_phases(),
+      m_heights(),
+      m_colors(),
+      m_lights(),
+
+      m_path(ShadingPath::DeferredVolumes),
+      m_lightCount(64),
+      m_lightRadius(4.0f),
+      m_time(0.0f),
+      m_fov(60.0f)
+{
+    m_renderer.init();
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const float spacing = 2.0f;
+    const float extent = kGrid * spacing;
+    m_boxes.push_back({ glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(extent + 2.0f, 0.2f, extent + 2.0f)),
+                        glm::vec3(0.55f), 0.1f, 8.0f });
+    for (int z = 0; z < kGrid; z++) {
+        for (int x = 0; x < kGrid; x++) {
+            const float height = 1.0f + 5.0f * unit(rng) * unit(rng);
+            const glm::vec3 center((x - (kGrid - 1) * 0.5f) * spacing, height * 0.5f, (z - (kGrid - 1) * 0.5f) * spacing);
+            const glm::mat4 model = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), glm::vec3(1.4f, height, 1.4f));
+            const glm::vec3 albedo(0.4f + 0.5f * unit(rng), 0.4f + 0.5f * unit(rng), 0.4f + 0.5f * unit(rng));
+            m_boxes.push_back({ model, albedo, 0.2f + 0.6f * unit(rng), 8.0f + 120.0f * unit(rng) });
+        }
+    }
+
+    for (int i = 0; i < kMaxLights; i++) {
+        m_radii.push_back(0.55f * extent * std::sqrt(unit(rng)));
+        m_speeds.push_back((0.1f + 0.4f * unit(rng)) * (unit(rng) < 0.5f ? -1.0f : 1.0f));
+        m_phases.push_back(6.2831853f * unit(rng));
+        m_heights.push_back(0.3f + 2.5f * unit(rng));
+        m_colors.push_back(glm::vec3(unit(rng), unit(rng), unit(rng)) * 0.7f + 0.3f);
+    }
+    m_lights.reserve(kMaxLights);
+}
+
+test::TestDeferredLights::~TestDeferredLights() {}
+
+void test::TestDeferredLights::onUpdate(float deltaTime) {
+    m_time += deltaTime;
+
+    // past a handful of lights they overlap, keep the scene about as bright whatever the count
+    const float intensity = 2.0f * std::min(1.0f, 16.0f / (float)m_lightCount);
+    m_lights.clear();
+    for (int i = 0; i < m_lightCount; i++) {
+        const float angle = m_phases[i] + m_speeds[i] * m_time;
+        const glm::vec3 position(m_radii[i] * std::cos(angle), m_heights[i], m_radii[i] * std::sin(angle));
+        if (i % 4 == 3) {
+            // spots look down and a little outwards, their cone reaches the ground
+            const glm::vec3 direction(0.3f * std::cos(angle), -1.0f, 0.3f * std::sin(angle));
+            m_lights.push_back(spot_light(position, m_lightRadius * 1.5f, m_colors[i] * intensity * 2.0f, direction, 0.35f, 0.6f));
+        }
+        else {
+            m_lights.push_back(point_light(position, m_lightRadius, m_colors[i] * intensity));
+        }
+    }
+}
+
+ShadingView test::TestDeferredLights::view() const {
+    const glm::vec3 eye(0.0f, 14.0f, 30.0f);
+    ShadingView view;
+    view.view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    view.projection = glm::perspective(glm::radians(m_fov), (float)1200 / (float)900, 0.1f, 100.0f);
+    view.position = eye;
+    return view;
+}
+
+void test::TestDeferredLights::onRender() {
+    if (!m_renderer.initialized()) {
+        return;
+    }
+
+    m_renderer.setLights(m_lights);
+    m_renderer.render(m_path, view(), [this](const Shader& shader) {
+        for (const Box& box : m_boxes) {
+            shader.setUniform("model", box.model);
+            DeferredRenderer::setMaterial(shader, box.albedo, box.specular, box.shininess);
+            m_cube->draw();
+        }
+    });
+}
+
+void test::TestDeferredLights::onGuiRender() {
+    static const char* paths[] = { "Forward", "Deferred, full-screen", "Deferred, light volumes", "Clustered forward" };
+    int path = (int)m_path;
+    if (ImGui::Combo("Shading", &path, paths, IM_ARRAYSIZE(paths))) {
+        m_path = (ShadingPath)path;
+    }
+    ImGui::SliderInt("Lights", &m_lightCount, 1, kMaxLights);
+    ImGui::SliderFloat("Light radius", &m_lightRadius, 0.5f, 16.0f);
+    ImGui::SliderFloat("FOV", &m_fov, 20.0f, 120.0f);
+    ImGui::Text("%zu boxes, G-buffer %.1f MB", m_boxes.size(), m_renderer.gbufferBytes() / (1024.0 * 1024.0));
+    if (m_path == ShadingPath::Clustered) {
+        const ClusterGridConfig& config = m_renderer.clusterGrid().config();
+        ImGui::Text("%ux%ux%u froxels, light lists %.1f MB", config.tilesX, config.tilesY, config.slices,
+                    m_renderer.clusterer().byteSize() / (1024.0 * 1024.0));
+    }
+}
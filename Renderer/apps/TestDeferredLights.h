@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../engine/Gui/gui.h"
+#include "../engine/opengl/OpenGLApp.h"
+#include "TestApp.h"
+
+#include "../engine/core/Cube.hpp"
+#include "../engine/render/DeferredRenderer.h"
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace test {
+
+    /**
+     * @brief A city block of boxes lit by up to a few thousand orbiting lights, one in four a spot
+     * 
+     * The boxes stand in rows, so the ones at the back are mostly hidden behind the front
+     * ones: forward shading pays for that overdraw with every light, the deferred paths
+     * light each visible pixel once, clustered forward only with the lights of its froxel.
+     * The shading path is picked in the GUI, or with setPath by the benchmarks.
+     */
+    class TestDeferredLights : public TestApp {
+    public:
+        static constexpr int kGrid = 16;
+        static constexpr int kMaxLights = 4096;
+
+        TestDeferredLights();
+        ~TestDeferredLights();
+
+        void onUpdate(float deltaTime) override;
+
+        void onRender() override;
+
+        void onGuiRender() override;
+
+        void setPath(ShadingPath path) { m_path = path; }
+
+        void setLightCount(int count) { m_lightCount = count < 1 ? 1 : (count > kMaxLights ? kMaxLights : count); }
+
+        /// The lights of the last onUpdate
+        const std::vector<Light>& lights() const { return m_lights; }
+
+        /// Camera of every frame, for the benchmarks' CPU references
+        ShadingView view() const;
+
+        const DeferredRenderer& renderer() const { return m_renderer; }
+
+        DeferredRenderer& renderer() { return m_renderer; }
+
+    private:
+        struct Box {
+            glm::mat4 model;
+            glm::vec3 albedo;
+            float specular;
+            float shininess;
+        };
+
+        std::unique_ptr<Cube> m_cube;
+        DeferredRenderer m_renderer;
+        std::vector<Box> m_boxes;
+
+        // per light orbit around the block center
+        std::vector<float> m_radii;
+        std::vector<float> m_speeds;
+        std::vector<float> m_phases;
+        std::vector<float> m_heights;
+        std::vector<glm::vec3> m_colors;
+        std::vector<Light> m_lights;
+
+        ShadingPath m_path;
+        int m_lightCount;
+        float m_lightRadius;
+        float m_time;
+        float m_fov;
+    };
+}
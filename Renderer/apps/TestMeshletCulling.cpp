@@ -0,0 +1,146 @@
+#include "TestMeshletCulling.h"
+
+#include "../engine/asset/model.h"
+#include "../engine/opengl/utils.h"
+
+#include <cmath>
+
+namespace {
+
+const float kSpacing = 3.0f;
+const float kNear = 0.1f;
+const float kFar = 100.0f;
+const int kRings = 48;
+const int kSegments = 64;
+const float kPi = 3.14159265f;
+const glm::vec3 kSunDirection(-0.4f, -1.0f, -0.25f);
+
+}
+
+test::TestMeshletCulling::TestMeshletCulling()
+    : m_shader(std::make_unique<asset::Shader>("assets/shaders/culling/meshlet.vert", "assets/shaders/culling/meshlet.frag")),
+      m_model(),
+      m_culler(),
+      m_camera(glm::vec3(0.0f, 2.5f, 0.0f)),
+      m_cpuStats(),
+      m_stats(),
+
+      m_mode(MeshletCullMode::Cpu),
+      m_turning(true),
+      m_time(0.0f)
+{
+    if (!m_culler.init("assets/shaders/culling/meshlet_cull.comp")) {
+        gl_log_err("ERROR: no GPU meshlet culling, that mode draws everything\n");
+    }
+    _createModel();
+    onUpdate(0.0f);
+}
+
+test::TestMeshletCulling::~TestMeshletCulling() {}
+
+void test::TestMeshletCulling::_createModel() {
+    // a unit UV sphere, counter-clockwise seen from outside so the meshlet cones face out
+    std::vector<asset::Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (int ring = 0; ring <= kRings; ring++) {
+        const float theta = kPi * ring / kRings;
+        for (int segment = 0; segment <= kSegments; segment++) {
+            const float phi = 2.0f * kPi * segment / kSegments;
+            asset::Vertex vertex{};
+            vertex.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertex.Position = vertex.Normal;
+            vertices.push_back(vertex);
+        }
+    }
+    for (int ring = 0; ring < kRings; ring++) {
+        for (int segment = 0; segment < kSegments; segment++) {
+            const unsigned int a = (unsigned int)(ring * (kSegments + 1) + segment);
+            const unsigned int b = a + kSegments + 1;
+            // the triangles touching a pole with two corners have no area
+            if (ring > 0) {
+                indices.insert(indices.end(), { a, a + 1, b });
+            }
+            if (ring < kRings - 1) {
+                indices.insert(indices.end(), { a + 1, b + 1, b });
+            }
+        }
+    }
+
+    const std::vector<asset::Mesh> meshes = { asset::Mesh(vertices, indices, {}) };
+    m_model = std::make_unique<asset::Model>(meshes, true);
+}
+
+void test::TestMeshletCulling::onUpdate(float deltaTime) {
+    if (m_turning) {
+        m_time += deltaTime;
+    }
+
+    m_camera.Yaw = -90.0f + 20.0f * m_time;
+    m_camera.Pitch = -15.0f;
+    m_camera.Update();
+}
+
+void test::TestMeshletCulling::onRender() {
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const float aspect = viewport[3] > 0 ? (float)viewport[2] / (float)viewport[3] : 1200.0f / 900.0f;
+    const glm::mat4 view = m_camera.GetViewMatrix();
+    const glm::mat4 projection = glm::perspective(glm::radians(m_camera.Zoom), aspect, kNear, kFar);
+    const glm::mat4 viewProjection = projection * view;
+    const MeshletCullMode mode = m_mode == MeshletCullMode::Gpu && !m_culler.initialized() ? MeshletCullMode::None : m_mode;
+
+    glEnable(GL_DEPTH_TEST);
+    m_shader->use();
+    m_shader->setMat4("view", view);
+    m_shader->setMat4("projection", projection);
+    m_shader->setVec3("sunDirection", glm::normalize(kSunDirection));
+
+    m_cpuStats = ClusterCullStats();
+    for (int z = 0; z < kGrid; z++) {
+        for (int x = 0; x < kGrid; x++) {
+            const glm::vec3 center((x - 0.5f * (kGrid - 1)) * kSpacing, 0.0f, (z - 0.5f * (kGrid - 1)) * kSpacing);
+            const glm::mat4 world = glm::translate(glm::mat4(1.0f), center);
+            const float cell = (float)(z * kGrid + x);
+            const glm::vec3 albedo(std::fmod(cell * 0.37f, 1.0f), std::fmod(cell * 0.61f, 1.0f), std::fmod(cell * 0.83f, 1.0f));
+            m_shader->use();
+            m_shader->setVec3("albedo", 0.35f + 0.5f * albedo);
+
+            switch (mode) {
+            case MeshletCullMode::None:
+                m_model->Draw(*m_shader, world);
+                break;
+            case MeshletCullMode::Cpu:
+                m_model->DrawCulled(*m_shader, world, viewProjection, m_camera.Position, m_cpuStats);
+                break;
+            case MeshletCullMode::Gpu:
+                m_model->DrawCulledGpu(*m_shader, world, viewProjection, m_camera.Position, m_culler);
+                break;
+            }
+        }
+    }
+}
+
+void test::TestMeshletCulling::onGuiRender() {
+    static const char* modes[] = { "None", "CPU", "GPU (compute)" };
+    int mode = (int)m_mode;
+    if (ImGui::Combo("Meshlet culling", &mode, modes, IM_ARRAYSIZE(modes))) {
+        m_mode = (MeshletCullMode)mode;
+    }
+    ImGui::Checkbox("Turn", &m_turning);
+
+    // the GPU counters of this frame's passes, read back once per frame
+    if (m_mode == MeshletCullMode::Gpu && m_culler.initialized()) {
+        m_stats = m_culler.readStats();
+        m_culler.resetStats();
+    } else if (m_mode == MeshletCullMode::Cpu) {
+        m_stats = m_cpuStats;
+    } else {
+        m_stats = ClusterCullStats();
+        m_stats.clusters = kGrid * kGrid * m_model->meshes[0].meshlets.meshlets.size();
+        m_stats.triangles = kGrid * kGrid * m_model->meshes[0].meshlets.triangleCount();
+    }
+    ImGui::Text("%zu meshlets: %zu outside the frustum, %zu facing away", m_stats.clusters, m_stats.frustumRejected,
+                m_stats.backfaceRejected);
+    ImGui::Text("%zu of %zu triangles rejected (%.1f%%)", m_stats.trianglesRejected, m_stats.triangles,
+                m_stats.rejectionRate() * 100.0);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+
+#include "../engine/Gui/gui.h"
+#include "../engine/opengl/OpenGLApp.h"
+#include "TestApp.h"
+
+#include "../engine/core/Camera.hpp"
+#include "../engine/geometry/ClusterCulling.h"
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace asset {
+    class Model;
+    class Shader;
+}
+
+namespace test {
+
+    enum class MeshletCullMode {
+        None,           // every sphere whole, one draw each
+        Cpu,            // Model::DrawCulled, the survivors uploaded as indirect commands
+        Gpu             // Model::DrawCulledGpu, a compute pass writes the commands
+    };
+
+    /**
+     * @brief A field of dense spheres split into meshlets, culled per meshlet before drawing
+     *
+     * The sphere is an asset::Model built in code with its meshlets made at load; every grid
+     * cell draws it through the model's culled paths. The camera stands in the middle of the
+     * field and turns, so the frustum rejects most of it, and about half of every sphere it
+     * sees faces away. The GUI switches between no culling, the CPU and the GPU culler and
+     * shows what each rejected. The camera turns unless told otherwise (GUI, or setTurning
+     * by the benchmarks).
+     */
+    class TestMeshletCulling : public TestApp {
+    public:
+        static constexpr int kGrid = 8;
+
+        TestMeshletCulling();
+        ~TestMeshletCulling();
+
+        void onUpdate(float deltaTime) override;
+
+        void onRender() override;
+
+        void onGuiRender() override;
+
+        void setMode(MeshletCullMode mode) { m_mode = mode; }
+
+        void setTurning(bool turning) { m_turning = turning; }
+
+        /// Of the last CPU culled frame
+        const ClusterCullStats& cpuStats() const { return m_cpuStats; }
+
+    private:
+        std::unique_ptr<asset::Shader> m_shader;
+        std::unique_ptr<asset::Model> m_model;
+        GpuClusterCuller m_culler;
+        Camera m_camera;
+        ClusterCullStats m_cpuStats;
+        ClusterCullStats m_stats;
+
+        MeshletCullMode m_mode;
+        bool m_turning;
+        float m_time;
+
+        void _createModel();
+    };
+}
@@ -0,0 +1,282 @@
+#include "TestOcclusion.h"
+
+#include "../engine/core/Profiler.h"
+#include "../engine/opengl/GpuProfiler.h"
+#include "../engine/opengl/RenderStats.h"
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+const float kRoomSize = 12.0f;
+const float kWallHeight = 5.0f;
+const float kWallThickness = 0.4f;
+const float kDoorWidth = 2.0f;
+const float kDoorHeight = 2.6f;
+const float kNear = 0.1f;
+const float kFar = 200.0f;
+const int kWalkColumn = 3;
+const glm::vec3 kSunDirection(-0.4f, -1.0f, -0.25f);
+
+}
+
+test::TestOcclusion::TestOcclusion()
+    : m_shader(std::make_unique<Shader>("assets/shaders/culling/instance.vert", "assets/shaders/culling/instance.frag")),
+      m_vao(),
+      m_vertices(),
+      m_indices(),
+      m_instances(),
+      m_culler(),
+      m_target(),
+      m_camera(glm::vec3(0.0f, 1.7f, 0.0f)),
+      m_boxes(),
+      m_bounds(),
+      m_stats(),
+
+      m_mode(OcclusionMode::TwoPhase),
+      m_walking(true),
+      m_time(0.0f)
+{
+    m_culler.init();
+    _buildLevel();
+    _createMesh();
+    m_culler.setInstances(m_bounds, 36);
+    onUpdate(0.0f);
+}
+
+test::TestOcclusion::~TestOcclusion() {}
+
+void test::TestOcclusion::_buildLevel() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const float extent = kRooms * kRoomSize;
+    const float origin = -0.5f * extent;
+    const glm::vec3 wallAlbedo(0.75f, 0.72f, 0.68f);
+
+    m_boxes.push_back({ glm::vec3(0.0f, -0.1f, 0.0f), glm::vec3(extent + 1.0f, 0.2f, extent + 1.0f), glm::vec3(0.45f, 0.4f, 0.35f) });
+
+    // walls along x at every z line and along z at every x line, a doorway in the middle of the inner ones
+    auto addWall = [&](float a, float b, float line, bool alongX, float bottom, float top) {
+        const float along = 0.5f * (a + b);
+        const glm::vec3 center = alongX ? glm::vec3(along, 0.5f * (bottom + top), line) : glm::vec3(line, 0.5f * (bottom + top), along);
+        const glm::vec3 size = alongX ? glm::vec3(b - a, top - bottom, kWallThickness) : glm::vec3(kWallThickness, top - bottom, b - a);
+        m_boxes.push_back({ center, size, wallAlbedo });
+    };
+    for (int line = 0; line <= kRooms; line++) {
+        const float position = origin + line * kRoomSize;
+        const bool outer = line == 0 || line == kRooms;
+        for (int room = 0; room < kRooms; room++) {
+            const float a = origin + room * kRoomSize;
+            const float b = a + kRoomSize;
+            for (bool alongX : { true, false }) {
+                if (outer) {
+                    addWall(a, b, position, alongX, 0.0f, kWallHeight);
+                    continue;
+                }
+                const float door = 0.5f * (a + b);
+                addWall(a, door - 0.5f * kDoorWidth, position, alongX, 0.0f, kWallHeight);
+                addWall(door + 0.5f * kDoorWidth, b, position, alongX, 0.0f, kWallHeight);
+                addWall(door - 0.5f * kDoorWidth, door + 0.5f * kDoorWidth, position, alongX, kDoorHeight, kWallHeight);
+            }
+        }
+    }
+
+    // props clear of the walls and of the walk through the doorways, lifted off the floor against z-fighting
+    const float margin = 0.6f + 0.5f * kWallThickness;
+    for (int rz = 0; rz < kRooms; rz++) {
+        for (int rx = 0; rx < kRooms; rx++) {
+            const glm::vec2 corner(origin + rx * kRoomSize, origin + rz * kRoomSize);
+            for (int i = 0; i < kPropsPerRoom; i++) {
+                glm::vec2 position;
+                do {
+                    position = corner + glm::vec2(margin) + glm::vec2(unit(rng), unit(rng)) * (kRoomSize - 2.0f * margin);
+                } while (std::abs(position.x - (corner.x + 0.5f * kRoomSize)) < 1.2f);
+                const float height = 0.2f + 1.4f * unit(rng) * unit(rng);
+                const glm::vec3 size(0.2f + 0.7f * unit(rng), height, 0.2f + 0.7f * unit(rng));
+                const glm::vec3 albedo(0.3f + 0.6f * unit(rng), 0.3f + 0.6f * unit(rng), 0.3f + 0.6f * unit(rng));
+                m_boxes.push_back({ glm::vec3(position.x, 0.01f + 0.5f * height, position.y), size, albedo });
+            }
+        }
+    }
+
+    m_bounds.clear();
+    for (const Box& box : m_boxes) {
+        m_bounds.push_back({ glm::vec4(box.center - 0.5f * box.size, 1.0f), glm::vec4(box.center + 0.5f * box.size, 1.0f) });
+    }
+}
+
+void test::TestOcclusion::_createMesh() {
+    // a unit box with a normal per face: 4 vertices and 2 triangles each
+    BufferInfo<float> vertices{};
+    vertices.type = VERTEX_BUFFER;
+    vertices.target = GL_ARRAY_BUFFER;
+    vertices.usage = GL_STATIC_DRAW;
+    BufferInfo<unsigned int> indices{};
+    indices.type = INDEX_BUFFER;
+    indices.target = GL_ELEMENT_ARRAY_BUFFER;
+    indices.usage = GL_STATIC_DRAW;
+    for (int axis = 0; axis < 3; axis++) {
+        for (float side : { -1.0f, 1.0f }) {
+            glm::vec3 normal(0.0f);
+            normal[axis] = side;
+            const glm::vec3 u = axis == 0 ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+            const glm::vec3 v = glm::cross(normal, u);
+            const unsigned int first = (unsigned int)(vertices.data.size() / 6);
+            for (int corner = 0; corner < 4; corner++) {
+                const glm::vec3 position = 0.5f * (normal + (corner & 1 ? u : -u) + (corner & 2 ? v : -v));
+                vertices.data.insert(vertices.data.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z });
+            }
+            indices.data.insert(indices.data.end(), { first, first + 1, first + 3, first, first + 3, first + 2 });
+        }
+    }
+    vertices.size = (unsigned long)(vertices.data.size() * sizeof(float));
+    indices.size = (unsigned long)(indices.data.size() * sizeof(unsigned int));
+
+    BufferInfo<float> instances{};
+    instances.type = VERTEX_BUFFER;
+    instances.target = GL_ARRAY_BUFFER;
+    instances.usage = GL_STATIC_DRAW;
+    for (const Box& box : m_boxes) {
+        instances.data.insert(instances.data.end(), { box.center.x, box.center.y, box.center.z, box.size.x, box.size.y, box.size.z,
+                                                      box.albedo.x, box.albedo.y, box.albedo.z });
+    }
+    instances.size = (unsigned long)(instances.data.size() * sizeof(float));
+
+    m_vao.bind();
+    m_vertices.setBuffer(vertices);
+    m_indices.setBuffer(indices);
+    m_vao.linkAttribFast({ 0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0 });
+    m_vao.linkAttribFast({ 1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 3 });
+    // per instance: the indirect commands' baseInstance offsets these
+    m_instances.setBuffer(instances);
+    for (GLuint attribute = 2; attribute <= 4; attribute++) {
+        m_vao.linkAttribFast({ attribute, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), 3 * (attribute - 2) });
+        GL_CALL(glVertexAttribDivisor(attribute, 1));
+    }
+    m_vao.unbind();
+}
+
+bool test::TestOcclusion::_fitTarget(int width, int height) {
+    if (m_target.id() && m_target.width() == width && m_target.height() == height) {
+        return true;
+    }
+
+    FramebufferConfig config{};
+    config.width = width;
+    config.height = height;
+    config.colorAttachments = { Framebuffer::rgba8() };
+    config.depth = true;
+    config.depthFormat = GL_DEPTH_COMPONENT32F;
+    return m_target.create(config);
+}
+
+void test::TestOcclusion::onUpdate(float deltaTime) {
+    if (m_walking) {
+        m_time += deltaTime;
+    }
+
+    // down the line of doorways of one column of rooms, looking around a little
+    const float extent = kRooms * kRoomSize;
+    const float x = -0.5f * extent + (kWalkColumn + 0.5f) * kRoomSize;
+    const float z = -0.5f * extent + 2.0f + std::fmod(1.5f * m_time, extent - 4.0f);
+    m_camera.Position = glm::vec3(x, 1.7f, z);
+    m_camera.Yaw = 90.0f + 25.0f * std::sin(0.5f * m_time);
+    m_camera.Pitch = -8.0f;
+    m_camera.Update();
+}
+
+glm::mat4 test::TestOcclusion::viewProjection() const {
+    const float aspect = m_target.id() ? (float)m_target.width() / (float)m_target.height() : 1200.0f / 900.0f;
+    const glm::mat4 view = glm::lookAt(m_camera.Position, m_camera.Position + m_camera.Front, m_camera.Up);
+    return glm::perspective(glm::radians(m_camera.Zoom), aspect, kNear, kFar) * view;
+}
+
+void test::TestOcclusion::onRender() {
+    GLint target = 0;
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (!m_culler.initialized() || !_fitTarget(viewport[2], viewport[3])) {
+        return;
+    }
+
+    const glm::mat4 viewProjection = this->viewProjection();
+    auto bindShader = [&]() {
+        m_shader->use();
+        m_shader->setUniform("viewProjection", viewProjection);
+        m_shader->setUniform("sunDirection", glm::normalize(kSunDirection));
+        m_vao.bind();
+    };
+
+    m_target.bind();
+    glClearColor(0.55f, 0.65f, 0.8f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    switch (m_mode) {
+    case OcclusionMode::None:
+        bindShader();
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr, (GLsizei)m_boxes.size());
+        RenderStats::get().recordDraw(GL_TRIANGLES, 36, m_boxes.size());
+        break;
+    case OcclusionMode::Frustum:
+        m_culler.cull(OcclusionPass::FrustumOnly, viewProjection);
+        bindShader();
+        m_culler.draw(OcclusionPass::FrustumOnly);
+        break;
+    case OcclusionMode::TwoPhase:
+        {
+            PROFILE_SCOPE("occlusion early");
+            PROFILE_GPU_SCOPE("occlusion early");
+            m_culler.cull(OcclusionPass::Early, viewProjection);
+            bindShader();
+            m_culler.draw(OcclusionPass::Early);
+        }
+        {
+            PROFILE_SCOPE("hi-z pyramid");
+            PROFILE_GPU_SCOPE("hi-z pyramid");
+            m_culler.buildPyramid(m_target.depthTexture(), m_target.width(), m_target.height());
+        }
+        {
+            PROFILE_SCOPE("occlusion late");
+            PROFILE_GPU_SCOPE("occlusion late");
+            m_culler.cull(OcclusionPass::Late, viewProjection);
+            bindShader();
+            m_culler.draw(OcclusionPass::Late);
+        }
+        break;
+    }
+    glBindVertexArray(0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_target.id());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)target);
+    glBlitFramebuffer(0, 0, m_target.width(), m_target.height(), viewport[0], viewport[1], viewport[0] + viewport[2],
+                      viewport[1] + viewport[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)target);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void test::TestOcclusion::onGuiRender() {
+    static const char* modes[] = { "None", "Frustum", "Frustum + Hi-Z, two-phase" };
+    int mode = (int)m_mode;
+    if (ImGui::Combo("Culling", &mode, modes, IM_ARRAYSIZE(modes))) {
+        m_mode = (OcclusionMode)mode;
+    }
+    ImGui::Checkbox("Walk", &m_walking);
+
+    // the counters of this frame's passes, read back once per frame
+    if (m_mode != OcclusionMode::None) {
+        m_stats = m_culler.readStats();
+        m_culler.resetStats();
+    } else {
+        m_stats = OcclusionStats();
+        m_stats.instances = m_boxes.size();
+        m_stats.drawnEarly = m_boxes.size();
+    }
+    ImGui::Text("%zu instances: %zu outside the frustum, %zu occluded", m_stats.instances, m_stats.frustumCulled, m_stats.occluded);
+    ImGui::Text("%zu drawn, %zu early and %zu late", m_stats.drawn(), m_stats.drawnEarly, m_stats.drawnLate);
+    ImGui::Text("culling buffers and pyramid %.2f MB", m_culler.byteSize() / (1024.0 * 1024.0));
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../engine/Gui/gui.h"
+#include "../engine/opengl/OpenGLApp.h"
+#include "TestApp.h"
+
+#include "../engine/core/Camera.hpp"
+#include "../engine/core/Shader.h"
+#include "../engine/opengl/Framebuffer.h"
+#include "../engine/opengl/OpenGLPipeline.h"
+#include "../engine/render/OcclusionCulling.h"
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace test {
+
+    enum class OcclusionMode {
+        None,           // every instance, one instanced draw
+        Frustum,        // frustum culled on the GPU
+        TwoPhase        // frustum and Hi-Z, early and late pass
+    };
+
+    /**
+     * @brief A grid of rooms full of props, walked through along a line of doorways
+     *
+     * Walls are tall and the doorways narrow, so from inside a room most of the level is
+     * hidden although it is in the frustum. Every box is an instance of one indexed box mesh
+     * drawn through GpuOcclusionCuller; the frame renders into a framebuffer of its own, whose
+     * depth feeds the pyramid, and is blitted into the caller's.
+     * The camera walks unless told otherwise (GUI, or setWalking by the benchmarks).
+     */
+    class TestOcclusion : public TestApp {
+    public:
+        static constexpr int kRooms = 8;
+        static constexpr int kPropsPerRoom = 80;
+
+        TestOcclusion();
+        ~TestOcclusion();
+
+        void onUpdate(float deltaTime) override;
+
+        void onRender() override;
+
+        void onGuiRender() override;
+
+        void setMode(OcclusionMode mode) { m_mode = mode; }
+
+        void setWalking(bool walking) { m_walking = walking; }
+
+        /// Puts the camera where it is `time` seconds into the walk
+        void setTime(float time) { m_time = time; onUpdate(0.0f); }
+
+        /// Camera of every frame, for the aspect of the last render
+        glm::mat4 viewProjection() const;
+
+        const std::vector<OcclusionBounds>& bounds() const { return m_bounds; }
+
+        const GpuOcclusionCuller& culler() const { return m_culler; }
+
+        GpuOcclusionCuller& culler() { return m_culler; }
+
+        /// What the last frame drew, before the blit
+        const Framebuffer& target() const { return m_target; }
+
+    private:
+        struct Box {
+            glm::vec3 center;
+            glm::vec3 size;
+            glm::vec3 albedo;
+        };
+
+        std::unique_ptr<Shader> m_shader;
+        VertexArray m_vao;
+        Buffer<float> m_vertices;
+        Buffer<unsigned int> m_indices;
+        Buffer<float> m_instances;
+        GpuOcclusionCuller m_culler;
+        Framebuffer m_target;
+        Camera m_camera;
+        std::vector<Box> m_boxes;
+        std::vector<OcclusionBounds> m_bounds;
+        OcclusionStats m_stats;
+
+        OcclusionMode m_mode;
+        bool m_walking;
+        float m_time;
+
+        void _buildLevel();
+
+        void _createMesh();
+
+        bool _fitTarget(int width, int height);
+    };
+}
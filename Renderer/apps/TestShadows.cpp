@@ -0,0 +1,158 @@
+#include "TestShadows.h"
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+const float kAspect = 1200.0f / 900.0f;
+const float kNear = 0.1f;
+const float kFar = 100.0f;
+
+}
+
+test::TestShadows::TestShadows(const ShadowSettings& settings)
+    : m_cube(std::make_unique<Cube>(CubeType::POS_NORM)),
+      m_renderer(),
+      m_shadows(),
+      m_camera(glm::vec3(0.0f, 7.0f, 16.0f)),
+      m_boxes(),
+      m_staticCount(0),
+      m_casters(),
+      m_lights(),
+      m_sunDirection(glm::normalize(glm::vec3(-0.5f, -1.0f, -0.35f))),
+
+      m_path(ShadingPath::Forward),
+      m_orbit(true),
+      m_cacheStatic(settings.cacheStatic),
+      m_time(0.0f),
+      m_cameraAngle(0.0f)
+{
+    m_renderer.init();
+    m_shadows.init(settings);
+    m_renderer.setAmbient(glm::vec3(0.04f));
+    m_renderer.setSun(m_sunDirection, glm::vec3(0.9f, 0.85f, 0.75f));
+    m_renderer.setShadows(&m_shadows);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const float spacing = 3.0f;
+    const float extent = kGrid * spacing;
+    m_boxes.push_back({ glm::vec3(0.0f, -0.1f, 0.0f), glm::vec3(extent + 4.0f, 0.2f, extent + 4.0f), glm::vec3(0.6f), 0.1f, 8.0f });
+    for (int z = 0; z < kGrid; z++) {
+        for (int x = 0; x < kGrid; x++) {
+            if (unit(rng) < 0.35f) {
+                continue;
+            }
+            const float height = 0.5f + 4.0f * unit(rng) * unit(rng);
+            const glm::vec3 size(0.6f + 1.2f * unit(rng), height, 0.6f + 1.2f * unit(rng));
+            const glm::vec3 center((x - (kGrid - 1) * 0.5f) * spacing, height * 0.5f, (z - (kGrid - 1) * 0.5f) * spacing);
+            const glm::vec3 albedo(0.4f + 0.5f * unit(rng), 0.4f + 0.5f * unit(rng), 0.4f + 0.5f * unit(rng));
+            m_boxes.push_back({ center, size, albedo, 0.2f + 0.6f * unit(rng), 8.0f + 120.0f * unit(rng) });
+        }
+    }
+    m_staticCount = m_boxes.size();
+    for (int i = 0; i < 6; i++) {
+        m_boxes.push_back({ glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.9f, 0.3f + 0.1f * i, 0.2f), 0.6f, 64.0f });
+    }
+
+    m_casters.resize(m_boxes.size());
+    for (size_t i = 0; i < m_boxes.size(); i++) {
+        m_casters[i].isStatic = i < m_staticCount;
+    }
+    onUpdate(0.0f);
+}
+
+test::TestShadows::~TestShadows() {}
+
+void test::TestShadows::onUpdate(float deltaTime) {
+    m_time += deltaTime;
+    if (m_orbit) {
+        m_cameraAngle += 0.1f * deltaTime;
+    }
+
+    // looks at the yard's center from a slow orbit
+    const glm::vec3 target(0.0f, 1.0f, 0.0f);
+    m_camera.Position = glm::vec3(16.0f * std::sin(m_cameraAngle), 7.0f, 16.0f * std::cos(m_cameraAngle));
+    const glm::vec3 front = glm::normalize(target - m_camera.Position);
+    m_camera.Yaw = glm::degrees(std::atan2(front.z, front.x));
+    m_camera.Pitch = glm::degrees(std::asin(front.y));
+    m_camera.Update();
+
+    for (size_t i = m_staticCount; i < m_boxes.size(); i++) {
+        const float phase = 1.0471976f * (float)(i - m_staticCount);
+        const float angle = phase + 0.4f * m_time;
+        m_boxes[i].center = glm::vec3(9.0f * std::cos(angle), 1.0f + 0.8f * std::sin(2.0f * angle + phase), 9.0f * std::sin(angle));
+    }
+    for (size_t i = 0; i < m_boxes.size(); i++) {
+        m_casters[i].boundsMin = m_boxes[i].center - m_boxes[i].size * 0.5f;
+        m_casters[i].boundsMax = m_boxes[i].center + m_boxes[i].size * 0.5f;
+    }
+
+    // two spots sweeping the yard and two point lights between the boxes, all shadowed
+    m_lights.clear();
+    for (int i = 0; i < 2; i++) {
+        const float side = i == 0 ? -1.0f : 1.0f;
+        const glm::vec3 position(side * 8.0f, 7.0f, side * 4.0f);
+        const glm::vec3 direction(-side * 0.5f + 0.3f * std::sin(0.5f * m_time + i), -1.0f, 0.2f);
+        m_lights.push_back(spot_light(position, 18.0f, glm::vec3(2.5f, 2.2f, 1.6f), direction, 0.3f, 0.5f).castShadows());
+    }
+    m_lights.push_back(point_light(glm::vec3(-4.5f, 1.5f, 6.0f), 8.0f, glm::vec3(0.4f, 0.8f, 2.0f)).castShadows());
+    m_lights.push_back(point_light(glm::vec3(5.0f, 1.2f, -5.5f), 8.0f, glm::vec3(2.0f, 0.6f, 0.3f)).castShadows());
+}
+
+ShadingView test::TestShadows::view() const {
+    ShadingView view;
+    view.view = shadow_camera_view(m_camera, kAspect, kNear, kFar).view;
+    view.projection = glm::perspective(glm::radians(m_camera.Zoom), kAspect, kNear, kFar);
+    view.position = m_camera.Position;
+    return view;
+}
+
+void test::TestShadows::onRender() {
+    if (!m_renderer.initialized() || !m_shadows.initialized()) {
+        return;
+    }
+
+    auto drawBox = [this](const Shader& shader, size_t i) {
+        const Box& box = m_boxes[i];
+        shader.setUniform("model", glm::translate(glm::mat4(1.0f), box.center) * glm::scale(glm::mat4(1.0f), box.size));
+        m_cube->draw();
+    };
+
+    m_shadows.setCacheStatic(m_cacheStatic);
+    m_shadows.update(shadow_camera_view(m_camera, kAspect, kNear, kFar), m_sunDirection, m_lights);
+    m_shadows.render(m_casters, drawBox);
+
+    m_renderer.setLights(m_lights);
+    m_renderer.render(m_path, view(), [&](const Shader& shader) {
+        for (size_t i = 0; i < m_boxes.size(); i++) {
+            const Box& box = m_boxes[i];
+            DeferredRenderer::setMaterial(shader, box.albedo, box.specular, box.shininess);
+            drawBox(shader, i);
+        }
+    });
+}
+
+void test::TestShadows::onGuiRender() {
+    static const char* paths[] = { "Forward", "Deferred, full-screen", "Deferred, light volumes", "Clustered forward" };
+    int path = (int)m_path;
+    if (ImGui::Combo("Shading", &path, paths, IM_ARRAYSIZE(paths))) {
+        m_path = (ShadingPath)path;
+    }
+    ImGui::Checkbox("Orbit", &m_orbit);
+    ImGui::Checkbox("Cache static casters", &m_cacheStatic);
+
+    const ShadowStats& stats = m_shadows.stats();
+    ImGui::Text("shadow pass %.3f ms CPU, %.3f ms GPU", stats.cpuMs, stats.gpuMs);
+    ImGui::Text("%u views: %u drawn, %u from the cache", stats.views, stats.viewsRendered, stats.viewsCached);
+    ImGui::Text("%llu casters drawn, %llu culled", (unsigned long long)stats.castersDrawn, (unsigned long long)stats.castersCulled);
+    for (size_t i = 0; i < m_shadows.cascadeCount(); i++) {
+        const Cascade& cascade = m_shadows.cascade(i);
+        ImGui::Text("cascade %zu: %.1f to %.1f, %.3f per texel, %llu casters", i, cascade.splitNear, cascade.splitFar,
+                    cascade.texelSize, (unsigned long long)stats.cascadeCasters[i]);
+    }
+    ImGui::Text("%u lights shadowed, %u dropped, atlas %.0f%% used, %.1f MB", stats.lightsShadowed, stats.lightsDropped,
+                stats.atlasUsage * 100.0f, m_shadows.byteSize() / (1024.0 * 1024.0));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../engine/Gui/gui.h"
+#include "../engine/opengl/OpenGLApp.h"
+#include "TestApp.h"
+
+#include "../engine/core/Camera.hpp"
+#include "../engine/core/Cube.hpp"
+#include "../engine/render/DeferredRenderer.h"
+#include "../engine/render/Shadows.h"
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace test {
+
+    /**
+     * @brief A yard of static boxes and a few moving ones under a sun and shadowed local lights
+     *
+     * The sun casts cascaded shadows fitted to the camera; two spot lights and two point
+     * lights have their tiles in the same atlas. The boxes that don't move are static
+     * casters: while the camera stays in the cascades' snapping cells and the lights keep
+     * still, their depth comes from the cache and only the moving boxes are drawn again.
+     * The camera orbits unless told otherwise (GUI, or setOrbit by the benchmarks).
+     */
+    class TestShadows : public TestApp {
+    public:
+        static constexpr int kGrid = 12;
+
+        /// `settings` sizes the atlas, the benchmarks use a small one
+        explicit TestShadows(const ShadowSettings& settings = ShadowSettings());
+        ~TestShadows();
+
+        void onUpdate(float deltaTime) override;
+
+        void onRender() override;
+
+        void onGuiRender() override;
+
+        void setPath(ShadingPath path) { m_path = path; }
+
+        void setOrbit(bool orbit) { m_orbit = orbit; }
+
+        void setCacheStatic(bool enable) { m_cacheStatic = enable; }
+
+        /// Camera of every frame
+        ShadingView view() const;
+
+        const Camera& camera() const { return m_camera; }
+
+        const std::vector<ShadowCaster>& casters() const { return m_casters; }
+
+        const ShadowRenderer& shadows() const { return m_shadows; }
+
+        ShadowRenderer& shadows() { return m_shadows; }
+
+        const DeferredRenderer& renderer() const { return m_renderer; }
+
+        DeferredRenderer& renderer() { return m_renderer; }
+
+    private:
+        struct Box {
+            glm::vec3 center;
+            glm::vec3 size;
+            glm::vec3 albedo;
+            float specular;
+            float shininess;
+        };
+
+        std::unique_ptr<Cube> m_cube;
+        DeferredRenderer m_renderer;
+        ShadowRenderer m_shadows;
+        Camera m_camera;
+        std::vector<Box> m_boxes;           // the static ones first
+        size_t m_staticCount;
+        std::vector<ShadowCaster> m_casters;
+        std::vector<Light> m_lights;
+        glm::vec3 m_sunDirection;
+
+        ShadingPath m_path;
+        bool m_orbit;
+        bool m_cacheStatic;
+        float m_time;
+        float m_cameraAngle;
+    };
+}
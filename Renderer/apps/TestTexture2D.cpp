@@ -8,9 +8,10 @@ test::TestTexture2D::TestTexture2D()
     : m_cube(std::make_unique<Cube>(CubeType::POS_TEX)),
       m_shader(std::make_unique<Shader>()),
       m_texture(std::make_unique<Texture>()),
-      m_model(std::make_unique<glm::mat4>(glm::mat4(1.0f))),
       m_view(std::make_unique<glm::mat4>(glm::mat4(1.0f))),
       m_projection(std::make_unique<glm::mat4>(glm::mat4(1.0f))),
+      m_scene(),
+      m_entity(kNullEntity),
 
       m_fov(45),
       m_cubeRotation(0),
@@ -32,35 +33,34 @@ test::TestTexture2D::TestTexture2D()
     // Note that we're using glm::perspective instead of glm::ortho
     // glm::perspective takes in fov in degrees, so we convert it to radians
     *m_projection = glm::perspective(glm::radians(m_fov), (float)1200 / (float)900, 0.1f, 100.0f);
-    
+
+    // the cube is the one renderable of the scene
+    m_entity = m_scene.create();
+    m_scene.transforms().add(m_entity, Transform());
+    m_scene.bounds().add(m_entity, Bounds());
+    m_scene.renderables().add(m_entity, { RenderableKind::Cube, m_cube.get(), nullptr, nullptr });
 }
 
 test::TestTexture2D::~TestTexture2D() {}
 
 void test::TestTexture2D::onUpdate(float deltaTime) {
     (void)deltaTime;
-    
-}
 
-void test::TestTexture2D::onRender() {
-    m_cube->bindTexture();
-    m_cube->useShader();
+    uint32_t i = m_scene.transforms().index(m_entity);
+    m_scene.transforms().positions[i] = m_cubeTranslation;
+    m_scene.transforms().rotations[i] = glm::angleAxis(glm::radians(m_cubeRotation), glm::vec3(0.0f, 1.0f, 0.0f));
+    m_scene.updateTransforms();
+    m_scene.updateBounds();
 
-    m_cube->getShader().setUniform("model", *m_model);
-    m_cube->getShader().setUniform("view", *m_view);
-    m_cube->getShader().setUniform("projection", *m_projection);
+    *m_projection = glm::perspective(glm::radians(m_fov), (float)1200 / (float)900, 0.1f, 100.0f);
+}
 
-    m_cube->draw();
+void test::TestTexture2D::onRender() {
+    m_scene.draw(*m_view, *m_projection);
 }
 
 void test::TestTexture2D::onGuiRender() {
     ImGui::SliderFloat("FOV", &m_fov, 0.0f, 180.0f);
     ImGui::SliderFloat3("Cube Translation", glm::value_ptr(m_cubeTranslation), -1.0f, 1.0f);
     ImGui::SliderFloat("Cube Rotation Y-axis ", &m_cubeRotation, 0.0f, 360.0f);
-
-    *m_model = glm::mat4(1.0f);
-    *m_model = glm::translate(*m_model, m_cubeTranslation);
-    *m_model = glm::rotate(*m_model, glm::radians(m_cubeRotation), glm::vec3(0.0f, 1.0f, 0.0f));
-
-    *m_projection = glm::perspective(glm::radians(m_fov), (float)1200 / (float)900, 0.1f, 100.0f);
 }
@@ -10,6 +10,7 @@
 #include "../engine/core/Shader.h"
 #include "../engine/core/Texture.h"
 #include "../engine/core/Cube.hpp"
+#include "../engine/scene/Scene.h"
 
 // GLM
 #include <glm/glm.hpp>
@@ -32,9 +33,10 @@ namespace test {
         std::unique_ptr<Cube> m_cube;
         std::unique_ptr<Shader> m_shader;
         std::unique_ptr<Texture> m_texture;
-        std::unique_ptr<glm::mat4> m_model;
         std::unique_ptr<glm::mat4> m_view;
         std::unique_ptr<glm::mat4> m_projection;
+        Scene m_scene;
+        Entity m_entity;
         
         float m_fov;
         float m_cubeRotation;
@@ -0,0 +1,21 @@
+#include "TestApp.h"
+
+// tests
+#include "TestClearColor.h"
+#include "TestTexture2D.h"
+#include "TestCubeField.h"
+#include "TestDeferredLights.h"
+#include "TestShadows.h"
+#include "TestOcclusion.h"
+#include "TestMeshletCulling.h"
+
+void test::registerTests(TestMenu &menu)
+{
+    menu.registerTest<TestClearColor>("Clear Color");
+    menu.registerTest<TestTexture2D>("Container Cube");
+    menu.registerTest<TestCubeField>("Cube Field");
+    menu.registerTest<TestDeferredLights>("Deferred Lights");
+    menu.registerTest<TestShadows>("Shadows");
+    menu.registerTest<TestOcclusion>("Occlusion Culling");
+    menu.registerTest<TestMeshletCulling>("Meshlet Culling");
+}
@@ -0,0 +1,655 @@
+/*
+ * glrenderer-bench: runs the registered tests headless and reports per-frame costs
+ *
+ *   glrenderer-bench [--test NAME]... [--warmup N] [--frames N] [--size WxH]
+ *                    [--output FILE] [--baseline FILE] [--tolerance T] [--pipelined] [--list]
+ *                    [--budget SPEC]... [--budget-fail SPEC]...
+ *
+ * Every test gets `warmup` unmeasured frames, then `frames` measured frames with a fixed
+ * 1/60 s time step. Results go to a JSON file (bench_results.json by default). Given a
+ * baseline written by an earlier run, the results are compared against it and the
+ * process exits with 1 when a test got slower, draws more or allocates more.
+ * With --pipelined, tests that support it run a second time with their update overlapped
+ * with the render (see FramePipeline), reported as "NAME [pipelined]".
+ * Each test also gets a memory section: peak CPU and GPU bytes per MemoryTag from its
+ * creation to its last frame, and what it allocated while measured. A memory budget
+ * ("gpu.Texture=64", MiB) over its peak prints a warning, or fails the run with 1 when
+ * given with --budget-fail.
+ *
+ * Only built where EGL is found, see CMakeLists.txt; glengine then defines HEADLESS_ENABLED.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "engine/wrapper/egl-wrapper.h"
+#include "engine/core/Window.h"
+#include "engine/core/Memory.h"
+#include "engine/core/FrameArena.h"
+#include "engine/core/FramePipeline.h"
+#include "engine/core/JobSystem.h"
+#include "engine/core/Profiler.h"
+#include "engine/opengl/OpenGLApp.h"
+#include "engine/opengl/GpuProfiler.h"
+#include "engine/opengl/RenderStats.h"
+
+#include "apps/TestApp.h"
+
+struct BenchOptions {
+    std::vector<std::string> tests;
+    uint64_t warmup = 120;
+    uint64_t frames = 600;
+    int width = 1280;
+    int height = 720;
+    std::string output = "bench_results.json";
+    std::string baseline;
+    double tolerance = 0.10;    // relative slack before a metric counts as regressed
+    double slackMs = 0.05;      // absolute slack on times, sub-0.1 ms frames are mostly noise
+    bool pipelined = false;
+    bool list = false;
+};
+
+struct Distribution {
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+    size_t samples;
+};
+
+struct BenchResult {
+    std::string name;
+    Distribution cpu;
+    Distribution gpu;
+    double drawCalls;       // per frame, averaged
+    double triangles;
+    double allocations;
+    double allocatedBytes;
+    uint64_t maxAllocations;
+    double arenaBytes;      // FrameArena bytes per frame, the transient data that stays off the heap
+    MemorySnapshot memoryStart;     // first measured frame
+    MemorySnapshot memory;          // last frame, peaks since the test was created
+};
+
+static Distribution distribution(std::vector<double> samples) {
+    Distribution result{};
+    result.samples = samples.size();
+    if (samples.empty()) {
+        return result;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+
+    // nearest rank, same as FrameStats
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)std::ceil(p * samples.size());
+        return samples[rank > 0 ? rank - 1 : 0];
+    };
+
+    result.mean = sum / samples.size();
+    result.p50 = percentile(0.50);
+    result.p95 = percentile(0.95);
+    result.p99 = percentile(0.99);
+    result.max = samples.back();
+    return result;
+}
+
+static BenchResult run_test(const std::string& name, test::TestApp* test, OpenGLApp& app,
+                            Window<EGLWrapper, EGLWrapperConfig>& window, FramePipeline& pipeline,
+                            const BenchOptions& options)
+{
+    const float step = 1.0f / 60.0f;
+    std::vector<double> cpuTimes, gpuTimes;
+    cpuTimes.reserve(options.frames);
+    gpuTimes.reserve(options.frames);
+
+    BenchResult result{};
+    result.name = name;
+
+    uint64_t firstMeasured = UINT64_MAX;
+    uint64_t resolved = GpuProfiler::get().resolvedFrames();
+    // every frame resolved since the last call, oldest first: one collect may resolve several
+    auto sampleGpu = [&]() {
+        GpuProfiler& gpu = GpuProfiler::get();
+        const uint64_t count = std::min<uint64_t>(gpu.resolvedFrames() - resolved, GpuProfiler::kBufferCount);
+        for (uint64_t age = count; age-- > 0;) {
+            const GpuProfiler::ResolvedFrame frame = gpu.resolvedFrame((unsigned int)age);
+            if (frame.frameIndex >= firstMeasured) {
+                gpuTimes.push_back(frame.ms);
+            }
+        }
+        resolved = gpu.resolvedFrames();
+    };
+
+    for (uint64_t frame = 0; frame < options.warmup + options.frames; frame++) {
+        bool measured = frame >= options.warmup;
+        if (frame == options.warmup) {
+            firstMeasured = Profiler::get().frameIndex();
+            result.memoryStart = Memory::snapshot();
+        }
+
+        AllocationCounters before = Memory::counters();
+        auto frameStart = std::chrono::steady_clock::now();
+
+        Profiler::get().beginFrame();
+        GpuProfiler::get().beginFrame(Profiler::get().frameIndex());
+        sampleGpu();
+        RenderStats::get().reset();
+
+        app.setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        app.clear();
+
+        test::runFrame(*test, pipeline, step);
+
+        GpuProfiler::get().endFrame();
+        window.swapBuffers();
+        Profiler::get().endFrame();
+
+        auto frameEnd = std::chrono::steady_clock::now();
+        AllocationCounters allocated = Memory::delta(before, Memory::counters());
+
+        if (measured) {
+            cpuTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+            result.drawCalls += (double)RenderStats::get().drawCalls();
+            result.triangles += (double)RenderStats::get().triangles();
+            result.allocations += (double)allocated.allocations;
+            result.allocatedBytes += (double)allocated.bytes;
+            result.maxAllocations = std::max(result.maxAllocations, allocated.allocations);
+            result.arenaBytes += (double)FrameArena::get().lastFrameBytes();
+        }
+    }
+
+    // the last frames are still in flight
+    pipeline.sync();
+    glFinish();
+    GpuProfiler::get().collect();
+    sampleGpu();
+    result.memory = Memory::snapshot();
+
+    if (options.frames > 0) {
+        result.drawCalls /= options.frames;
+        result.triangles /= options.frames;
+        result.allocations /= options.frames;
+        result.allocatedBytes /= options.frames;
+        result.arenaBytes /= options.frames;
+    }
+    result.cpu = distribution(cpuTimes);
+    result.gpu = distribution(gpuTimes);
+    return result;
+}
+
+// ---- JSON output
+
+static std::string json_escape(const std::string& text) {
+    std::string result;
+    for (char c : text) {
+        switch (c)
+        {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                result += escaped;
+            }
+            else {
+                result += c;
+            }
+        }
+    }
+    return result;
+}
+
+static void write_distribution(FILE* file, const char* key, const Distribution& d) {
+    fprintf(file, "      \"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"samples\": %zu },\n",
+        key, d.mean, d.p50, d.p95, d.p99, d.max, d.samples);
+}
+
+static bool write_results(const std::string& path, const std::vector<BenchResult>& results,
+                          const BenchOptions& options, const OpenGLApp& app)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "ERROR: could not open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"renderer\": \"%s\",\n", json_escape(app.getRenderer()).c_str());
+    fprintf(file, "  \"version\": \"%s\",\n", json_escape(app.getOpenGLVersion()).c_str());
+    fprintf(file, "  \"width\": %d,\n  \"height\": %d,\n", options.width, options.height);
+    fprintf(file, "  \"warmup\": %llu,\n  \"frames\": %llu,\n", (unsigned long long)options.warmup, (unsigned long long)options.frames);
+    fprintf(file, "  \"tests\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"name\": \"%s\",\n", json_escape(r.name).c_str());
+        write_distribution(file, "cpu_ms", r.cpu);
+        write_distribution(file, "gpu_ms", r.gpu);
+        fprintf(file, "      \"draw_calls\": %.2f,\n", r.drawCalls);
+        fprintf(file, "      \"triangles\": %.2f,\n", r.triangles);
+        fprintf(file, "      \"allocations\": %.2f,\n", r.allocations);
+        fprintf(file, "      \"allocated_bytes\": %.2f,\n", r.allocatedBytes);
+        fprintf(file, "      \"max_allocations\": %llu,\n", (unsigned long long)r.maxAllocations);
+        fprintf(file, "      \"arena_bytes\": %.2f,\n", r.arenaBytes);
+        fprintf(file, "      \"memory\": ");
+        Memory::writeJson(file, r.memory, r.memoryStart, options.frames, "      ");
+        fprintf(file, "\n");
+        fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    fclose(file);
+    return true;
+}
+
+// ---- baseline input: a small JSON reader, enough for what write_results produces
+
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& member : object) {
+            if (member.first == key) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+
+    double numberAt(const std::string& key, double fallback = 0.0) const {
+        const JsonValue* value = find(key);
+        return value && value->type == Type::Number ? value->number : fallback;
+    }
+};
+
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : m_text(text), m_pos(0) {}
+
+    bool parse(JsonValue& value) {
+        return _value(value) && (_skip(), m_pos == m_text.size());
+    }
+
+private:
+    const std::string& m_text;
+    size_t m_pos;
+
+    void _skip() {
+        while (m_pos < m_text.size() && isspace((unsigned char)m_text[m_pos])) {
+            m_pos++;
+        }
+    }
+
+    bool _consume(char c) {
+        _skip();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool _string(std::string& out) {
+        if (!_consume('"')) {
+            return false;
+        }
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            char c = m_text[m_pos++];
+            if (c == '\\' && m_pos < m_text.size()) {
+                char e = m_text[m_pos++];
+                switch (e)
+                {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'u': out += '?'; m_pos = std::min(m_pos + 4, m_text.size()); break;
+                default:  out += e; break;
+                }
+            }
+            else {
+                out += c;
+            }
+        }
+        return m_pos++ < m_text.size();
+    }
+
+    bool _value(JsonValue& value) {
+        _skip();
+        if (m_pos >= m_text.size()) {
+            return false;
+        }
+
+        char c = m_text[m_pos];
+        if (c == '{') {
+            value.type = JsonValue::Type::Object;
+            m_pos++;
+            if (_consume('}')) {
+                return true;
+            }
+            do {
+                std::pair<std::string, JsonValue> member;
+                if (!_string(member.first) || !_consume(':') || !_value(member.second)) {
+                    return false;
+                }
+                value.object.push_back(std::move(member));
+            } while (_consume(','));
+            return _consume('}');
+        }
+        if (c == '[') {
+            value.type = JsonValue::Type::Array;
+            m_pos++;
+            if (_consume(']')) {
+                return true;
+            }
+            do {
+                value.array.emplace_back();
+                if (!_value(value.array.back())) {
+                    return false;
+                }
+            } while (_consume(','));
+            return _consume(']');
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::String;
+            return _string(value.string);
+        }
+        if (m_text.compare(m_pos, 4, "true") == 0 || m_text.compare(m_pos, 5, "false") == 0) {
+            value.type = JsonValue::Type::Bool;
+            value.number = c == 't' ? 1.0 : 0.0;
+            m_pos += c == 't' ? 4 : 5;
+            return true;
+        }
+        if (m_text.compare(m_pos, 4, "null") == 0) {
+            m_pos += 4;
+            return true;
+        }
+
+        const char* begin = m_text.c_str() + m_pos;
+        char* end = nullptr;
+        value.type = JsonValue::Type::Number;
+        value.number = strtod(begin, &end);
+        m_pos += end - begin;
+        return end != begin;
+    }
+};
+
+static bool read_file(const std::string& path, std::string& contents) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, read);
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Compares results to a baseline run, prints one line per metric
+ *
+ * @return number of regressed metrics, -1 if the baseline could not be read
+ */
+static int compare_baseline(const std::string& path, const std::vector<BenchResult>& results, const BenchOptions& options) {
+    std::string text;
+    JsonValue baseline;
+    if (!read_file(path, text) || !JsonReader(text).parse(baseline) || !baseline.find("tests")) {
+        fprintf(stderr, "ERROR: could not read baseline %s\n", path.c_str());
+        return -1;
+    }
+
+    int regressions = 0;
+    printf("\n%-24s %-16s %12s %12s %9s\n", "test", "metric", "baseline", "current", "change");
+
+    for (const BenchResult& result : results) {
+        const JsonValue* base = nullptr;
+        for (const JsonValue& test : baseline.find("tests")->array) {
+            const JsonValue* name = test.find("name");
+            if (name && name->string == result.name) {
+                base = &test;
+            }
+        }
+        if (!base) {
+            printf("%-24s (not in baseline)\n", result.name.c_str());
+            continue;
+        }
+
+        // times get relative + absolute slack, counts are deterministic and only get the relative one
+        auto check = [&](const char* metric, double before, double now, double slack) {
+            bool regressed = now > before * (1.0 + options.tolerance) + slack;
+            double change = before > 0.0 ? (now - before) / before * 100.0 : 0.0;
+            printf("%-24s %-16s %12.4f %12.4f %+8.1f%% %s\n", result.name.c_str(), metric, before, now, change, regressed ? "REGRESSED" : "");
+            regressions += regressed ? 1 : 0;
+        };
+
+        const JsonValue* cpu = base->find("cpu_ms");
+        const JsonValue* gpu = base->find("gpu_ms");
+        if (cpu) {
+            check("cpu p50 ms", cpu->numberAt("p50"), result.cpu.p50, options.slackMs);
+            check("cpu p95 ms", cpu->numberAt("p95"), result.cpu.p95, options.slackMs);
+        }
+        if (gpu && gpu->numberAt("samples") > 0 && result.gpu.samples > 0) {
+            check("gpu p50 ms", gpu->numberAt("p50"), result.gpu.p50, options.slackMs);
+        }
+        check("draw calls", base->numberAt("draw_calls"), result.drawCalls, 0.5);
+        check("allocations", base->numberAt("allocations"), result.allocations, 0.5);
+    }
+
+    return regressions;
+}
+
+// ---- driver
+
+static void print_usage(const char* program) {
+    std::cout << "usage: " << program << " [--test NAME]... [--warmup N] [--frames N] [--size WxH]\n"
+              << "       [--output FILE] [--baseline FILE] [--tolerance T] [--pipelined] [--list]\n"
+              << "       [--budget SPEC]... [--budget-fail SPEC]...\n"
+              << "  --test NAME      test to run, may be repeated (default: all)\n"
+              << "  --warmup N       unmeasured frames per test (default 120)\n"
+              << "  --frames N       measured frames per test (default 600)\n"
+              << "  --size WxH       offscreen target size (default 1280x720)\n"
+              << "  --output FILE    results JSON (default bench_results.json)\n"
+              << "  --baseline FILE  results JSON of an earlier run, exit 1 on regressions\n"
+              << "  --tolerance T    relative slack for the baseline comparison (default 0.10)\n"
+              << "  --pipelined      also run pipelined tests with the update overlapping the render\n"
+              << "  --list           print the registered tests and exit\n"
+              << "  --budget SPEC    warn when a test's peak goes over SPEC: cpu|gpu.TAG=MiB, TAG one of\n"
+              << "                   Untagged Mesh Texture Shader Model GUI total, e.g. gpu.Texture=64\n"
+              << "  --budget-fail SPEC  same, exit 1 when it goes over" << std::endl;
+}
+
+static bool parse_options(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "--test") && hasValue) {
+            options.tests.push_back(argv[++i]);
+        }
+        else if (!strcmp(arg, "--warmup") && hasValue) {
+            options.warmup = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(arg, "--frames") && hasValue) {
+            options.frames = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(arg, "--size") && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0) {
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--output") && hasValue) {
+            options.output = argv[++i];
+        }
+        else if (!strcmp(arg, "--baseline") && hasValue) {
+            options.baseline = argv[++i];
+        }
+        else if (!strcmp(arg, "--tolerance") && hasValue) {
+            options.tolerance = strtod(argv[++i], nullptr);
+        }
+        else if (!strcmp(arg, "--pipelined")) {
+            options.pipelined = true;
+        }
+        else if (!strcmp(arg, "--list")) {
+            options.list = true;
+        }
+        else if ((!strcmp(arg, "--budget") || !strcmp(arg, "--budget-fail")) && hasValue) {
+            MemoryBudget budget;
+            if (!Memory::parseBudget(argv[++i], !strcmp(arg, "--budget-fail") ? BudgetAction::Fail : BudgetAction::Warn, budget)) {
+                std::cerr << "Invalid budget " << argv[i] << std::endl;
+                return false;
+            }
+            Memory::setBudget(budget);
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if (!restart_gl_log("logs/bench.log", LogLevel::Warn)) {
+        std::cerr << "Failed to open log file logs/bench.log" << std::endl;
+    }
+
+    EGLWrapperConfig egl_config{};
+    egl_config.majorVersion = 4;
+    egl_config.minorVersion = 5;
+    egl_config.coreProfile = true;
+
+    Window<EGLWrapper, EGLWrapperConfig> window(egl_config, options.width, options.height, "glrenderer-bench");
+    window.makeContextCurrent();
+    if (!window.initialized()) {
+        std::cerr << "Failed to create a headless context" << std::endl;
+        return -1;
+    }
+
+    OpenGLApp app({ true, GL_LESS, false, GL_BACK, false, false });
+    if (!app.initialized()) {
+        std::cerr << "Failed to initialize OpenGLApp" << std::endl;
+        return -1;
+    }
+
+    Profiler::get().setThreadName("Main");
+    if (!GpuProfiler::get().init()) {
+        std::cerr << "GPU timer queries unavailable, GPU times will be empty" << std::endl;
+    }
+
+    test::TestApp* currentTest = nullptr;
+    test::TestMenu testMenu(currentTest);
+    test::registerTests(testMenu);
+
+    if (options.list) {
+        for (const auto& name : testMenu.names()) {
+            std::cout << name << std::endl;
+        }
+        return 0;
+    }
+    if (options.tests.empty()) {
+        options.tests = testMenu.names();
+    }
+
+    printf("%s, %s, %dx%d, %llu warm-up + %llu measured frames\n\n",
+        app.getRenderer().c_str(), app.getOpenGLVersion().c_str(), options.width, options.height,
+        (unsigned long long)options.warmup, (unsigned long long)options.frames);
+    printf("%-24s %9s %9s %9s %9s %7s %11s %9s %9s %8s %8s\n", "test", "cpu p50", "cpu p95", "cpu p99", "gpu p50", "draws",
+        "triangles", "allocs", "arena KB", "cpu MB", "gpu MB");
+
+    std::vector<BenchResult> results;
+    int budgetFailures = 0;
+    FramePipeline pipeline(JobSystem::get());
+    for (const auto& name : options.tests) {
+        for (int pass = 0; pass < (options.pipelined ? 2 : 1); pass++) {
+            // peaks count from here, loading included
+            Memory::resetPeaks();
+            test::TestApp* test = testMenu.create(name);
+            if (!test) {
+                std::cerr << "Unknown test '" << name << "'" << std::endl;
+                return -1;
+            }
+            if (pass == 1 && !test->pipelined()) {
+                delete test;
+                break;
+            }
+
+            pipeline.setEnabled(pass == 1);
+            results.push_back(run_test(pass == 1 ? name + " [pipelined]" : name, test, app, window, pipeline, options));
+            delete test;
+
+            const BenchResult& r = results.back();
+            printf("%-24s %9.3f %9.3f %9.3f %9.3f %7.1f %11.1f %9.1f %9.1f %8.2f %8.2f\n", r.name.c_str(),
+                r.cpu.p50, r.cpu.p95, r.cpu.p99, r.gpu.p50, r.drawCalls, r.triangles, r.allocations, r.arenaBytes / 1024.0,
+                r.memory.cpu[MemorySnapshot::kTags].peakBytes / 1048576.0, r.memory.gpu[MemorySnapshot::kTags].peakBytes / 1048576.0);
+
+            BudgetViolation violations[2 * (MemorySnapshot::kTags + 1)];
+            const size_t count = Memory::checkBudgets(r.memory, violations, sizeof(violations) / sizeof(violations[0]));
+            for (size_t i = 0; i < count; i++) {
+                const MemoryBudget& budget = violations[i].budget;
+                const bool fail = budget.action == BudgetAction::Fail;
+                printf("  %s: %s.%s peak %.2f MB over its %.2f MB budget\n", fail ? "BUDGET EXCEEDED" : "warning",
+                    budget.domain == MemoryDomain::Cpu ? "cpu" : "gpu", memory_tag_name(budget.tag),
+                    violations[i].peakBytes / 1048576.0, budget.bytes / 1048576.0);
+                budgetFailures += fail ? 1 : 0;
+            }
+        }
+    }
+
+    GpuProfiler::get().shutdown();
+
+    if (!write_results(options.output, results, options, app)) {
+        return -1;
+    }
+    printf("\nresults written to %s\n", options.output.c_str());
+
+    int status = 0;
+    if (!options.baseline.empty()) {
+        int regressions = compare_baseline(options.baseline, results, options);
+        if (regressions < 0) {
+            return -1;
+        }
+        if (regressions > 0) {
+            printf("\n%d metric(s) regressed beyond %.0f%% of %s\n", regressions, options.tolerance * 100.0, options.baseline.c_str());
+            status = 1;
+        }
+        else {
+            printf("\nno regressions against %s\n", options.baseline.c_str());
+        }
+    }
+    if (budgetFailures > 0) {
+        printf("\n%d memory budget(s) exceeded\n", budgetFailures);
+        status = 1;
+    }
+
+    return status;
+}
@@ -5,7 +5,16 @@
 #include "imgui/imgui_impl_opengl3.h"
 
 #include "../core/Window.h"
+#include "../core/Profiler.h"
+#include "../core/FrameStats.h"
+#include "../core/Memory.h"
+#include "../render/DynamicResolution.h"
+#include "../render/PostProcess.h"
+#include "../render/RenderGraph.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
 #include <functional>
 
 enum class GraphicsFramework
@@ -25,8 +34,11 @@ static GraphicsFramework fm = GraphicsFramework::OPENGL;
 class EngineGui
 {
 public:
-    EngineGui(GLFWwindow *window) : m_window(window), m_windowFlags(0) {
+    EngineGui(GLFWwindow *window)
+        : m_window(window), m_windowFlags(0), m_profilerFrame(0), m_profilerPaused(false), m_memoryLast(), m_memoryChurn() {
         IMGUI_CHECKVERSION();
+        // before the context exists, everything ImGui allocates is charged to MemoryTag::GUI
+        ImGui::SetAllocatorFunctions(_allocate, _free);
         ImGui::CreateContext();
         m_io = &ImGui::GetIO();
 
@@ -100,8 +112,403 @@ public:
         ImGui::End();
     }
 
+    /**
+     * @brief Frame time section of the main UI: live graph, percentiles and distribution
+     *
+     * @note Call between `beginMainUI` and `endMainUI`
+     */
+    inline void drawFrameStats(FrameStats& stats) {
+        if (!ImGui::CollapsingHeader("Frame statistics", ImGuiTreeNodeFlags_DefaultOpen) || stats.count() == 0)
+            return;
+
+        FrameStatsSummary summary = stats.summary();
+
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.2f ms (budget %.2f ms)", stats.samples()[(stats.offset() + stats.count() - 1) % FrameStats::kCapacity], stats.budget());
+        ImGui::PlotLines("##frametime", stats.samples(), (int)stats.count(), (int)stats.offset(), overlay,
+            0.0f, (float)std::max(summary.max, stats.budget() * 2.0), ImVec2(0, 80));
+
+        ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", summary.p50, summary.p95, summary.p99, summary.max);
+        ImGui::Text("mean %.2f ms (%.1f fps), hitches %llu / %zu in window, %llu / %llu total",
+            summary.mean, summary.mean > 0.0 ? 1000.0 / summary.mean : 0.0,
+            (unsigned long long)summary.hitches, summary.count,
+            (unsigned long long)stats.totalHitches(), (unsigned long long)stats.totalFrames());
+
+        float bins[FrameStats::kHistogramBins];
+        float binWidth = 1.0f;
+        stats.histogram(bins, binWidth);
+        snprintf(overlay, sizeof(overlay), "distribution, %.2f ms/bin", binWidth);
+        ImGui::PlotHistogram("##framehistogram", bins, (int)FrameStats::kHistogramBins, 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+        float budget = (float)stats.budget();
+        if (ImGui::SliderFloat("Budget (ms)", &budget, 1.0f, 50.0f)) {
+            stats.setBudget(budget);
+        }
+    }
+
+    /**
+     * @brief Profiler window: frame time history, CPU and GPU flame graphs of the selected frame
+     * and a Chrome trace export.
+     */
+    inline void drawProfiler(bool* p_open) {
+        if (!ImGui::Begin("Profiler", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        Profiler& profiler = Profiler::get();
+
+        if (ImGui::Checkbox("Pause", &m_profilerPaused)) {
+            profiler.setEnabled(!m_profilerPaused);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export Chrome trace")) {
+            profiler.exportChromeTrace("profile.json");
+        }
+
+        int frames = (int)profiler.completedFrames();
+        if (frames == 0) {
+            ImGui::Text("No frames recorded yet");
+            ImGui::End();
+            return;
+        }
+
+        // oldest frame on the left
+        float times[Profiler::kFrameHistory];
+        for (int i = 0; i < frames; i++) {
+            times[i] = (float)profiler.frame(frames - 1 - i).durationMs();
+        }
+        ImGui::PlotHistogram("##frametimes", times, frames, 0, "CPU frame (ms)", 0.0f, FLT_MAX, ImVec2(0, 60));
+
+        if (m_profilerFrame >= frames) {
+            m_profilerFrame = frames - 1;
+        }
+        ImGui::SliderInt("Frames ago", &m_profilerFrame, 0, frames - 1);
+
+        const ProfileFrame& frame = profiler.frame((size_t)m_profilerFrame);
+        ImGui::Text("Frame %llu  CPU %.3f ms  GPU %s%.3f ms", (unsigned long long)frame.index,
+            frame.durationMs(), frame.gpuResolved ? "" : "(pending) ", frame.gpuMs());
+
+        ImGui::SeparatorText("CPU");
+        _drawFlameGraph("cpu", frame.cpuScopes, frame.start, frame.end);
+        ImGui::SeparatorText("GPU");
+        _drawFlameGraph("gpu", frame.gpuScopes, frame.start, frame.end);
+
+        ImGui::End();
+    }
+
+    /**
+     * @brief Memory window: live and peak bytes per tag on the CPU and the GPU, allocations
+     * per frame, GPU bytes per format, budgets and a JSON dump
+     *
+     * Peaks over a budget are drawn red.
+     */
+    inline void drawMemory(bool* p_open) {
+        if (!ImGui::Begin("Memory", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        const MemorySnapshot snapshot = Memory::snapshot();
+
+        if (ImGui::Button("Reset peaks")) {
+            Memory::resetPeaks();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Write memory.json")) {
+            Memory::writeReport("memory.json", (uint64_t)ImGui::GetFrameCount());
+        }
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+        if (ImGui::BeginTable("##memorytags", 7, flags)) {
+            for (const char* column : { "tag", "cpu live", "cpu peak", "allocs/frame", "KB/frame", "gpu live", "gpu peak" })
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+
+            for (size_t tag = 0; tag <= MemorySnapshot::kTags; tag++) {
+                const MemoryTagStats& cpu = snapshot.cpu[tag];
+                const MemoryTagStats& gpu = snapshot.gpu[tag];
+                const MemoryTagStats& last = m_memoryLast.cpu[tag];
+                MemoryBudget budget;
+                // smoothed, a single frame says little
+                if (m_memoryLast.cpu[MemorySnapshot::kTags].allocations > 0) {
+                    m_memoryChurn[tag][0] += 0.1f * ((float)(cpu.allocations - last.allocations) - m_memoryChurn[tag][0]);
+                    m_memoryChurn[tag][1] += 0.1f * ((float)(cpu.allocatedBytes - last.allocatedBytes) - m_memoryChurn[tag][1]);
+                }
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(memory_tag_name((MemoryTag)tag));
+                ImGui::TableNextColumn();
+                _drawBytes(cpu.liveBytes);
+                ImGui::TableNextColumn();
+                _drawBytes(cpu.peakBytes, Memory::budget(MemoryDomain::Cpu, (MemoryTag)tag, budget) ? &budget : nullptr);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", m_memoryChurn[tag][0]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", m_memoryChurn[tag][1] / 1024.0f);
+                ImGui::TableNextColumn();
+                _drawBytes(gpu.liveBytes);
+                ImGui::TableNextColumn();
+                _drawBytes(gpu.peakBytes, Memory::budget(MemoryDomain::Gpu, (MemoryTag)tag, budget) ? &budget : nullptr);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::SeparatorText("GPU formats");
+        if (snapshot.formatCount > 0 && ImGui::BeginTable("##memoryformats", 4, flags)) {
+            for (const char* column : { "format", "objects", "live", "peak" })
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+
+            for (size_t i = 0; i < snapshot.formatCount; i++) {
+                const GpuFormatStats& format = snapshot.formats[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(format.format);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", format.resources);
+                ImGui::TableNextColumn();
+                _drawBytes(format.liveBytes);
+                ImGui::TableNextColumn();
+                _drawBytes(format.peakBytes);
+            }
+            ImGui::EndTable();
+        }
+
+        m_memoryLast = snapshot;
+        ImGui::End();
+    }
+
+    /**
+     * @brief Post-processing window: the chain's settings, GPU time per pass and the render
+     * target pool's memory, allocated versus reused by the last frame
+     */
+    inline void drawPostProcessing(bool* p_open, PostSettings& settings, const PostStats& stats, const RenderTargetPool& pool) {
+        if (!ImGui::Begin("Post-processing", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Checkbox("Bloom", &settings.bloom);
+        if (settings.bloom) {
+            ImGui::SliderFloat("Threshold", &settings.bloomThreshold, 0.0f, 4.0f);
+            ImGui::SliderFloat("Knee", &settings.bloomKnee, 0.0f, 1.0f);
+            ImGui::SliderFloat("Intensity", &settings.bloomIntensity, 0.0f, 2.0f);
+            ImGui::SliderFloat("Radius", &settings.bloomRadius, 0.5f, 3.0f);
+            ImGui::SliderInt("Levels", &settings.bloomLevels, 1, 8);
+        }
+        ImGui::Checkbox("Tone mapping", &settings.toneMap);
+        if (settings.toneMap) {
+            int toneMapper = (int)settings.toneMapper;
+            ImGui::Combo("Curve", &toneMapper, "clamp\0Reinhard\0ACES\0");
+            settings.toneMapper = (ToneMapper)toneMapper;
+            ImGui::SliderFloat("Exposure", &settings.exposure, 0.1f, 4.0f);
+        }
+        ImGui::Checkbox("Color grading", &settings.grading);
+        if (settings.grading) {
+            ImGui::ColorEdit3("Tint", &settings.tint.x);
+            ImGui::SliderFloat("Contrast", &settings.contrast, 0.5f, 1.5f);
+            ImGui::SliderFloat("Saturation", &settings.saturation, 0.0f, 2.0f);
+        }
+        ImGui::Checkbox("FXAA", &settings.fxaa);
+
+        ImGui::SeparatorText("GPU");
+        for (size_t pass = 0; pass < PostStats::kPasses; pass++) {
+            ImGui::Text("%-10s %.3f ms", post_pass_name((PostPass)pass), stats.gpuMs[pass]);
+        }
+        ImGui::Text("%u passes, %u draws, %.3f ms CPU", stats.passes, stats.draws, stats.cpuMs);
+
+        const RenderTargetPoolStats& frame = pool.lastFrameStats();
+        ImGui::SeparatorText("Render targets");
+        ImGui::Text("%zu targets, %zu in use, %.2f MB", pool.targetCount(), pool.inUseCount(), pool.byteSize() / 1048576.0);
+        ImGui::Text("last frame: %u allocated (%.2f MB), %u reused (%.2f MB)", frame.allocated, frame.allocatedBytes / 1048576.0,
+                    frame.reused, frame.reusedBytes / 1048576.0);
+
+        ImGui::End();
+    }
+
+    /**
+     * @brief Dynamic resolution window: controller parameters, upscale filter, and the scale
+     * and GPU time of the frames measured
+     */
+    inline void drawDynamicResolution(bool* p_open, DynamicResolutionSettings& settings, const DynamicResolutionStats& stats) {
+        if (!ImGui::Begin("Dynamic resolution", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Checkbox("Controller", &settings.enabled);
+        if (settings.enabled) {
+            ImGui::SliderFloat("Target (ms)", &settings.targetMs, 2.0f, 50.0f);
+            ImGui::SliderFloat("Headroom", &settings.headroom, 0.0f, 0.5f);
+            ImGui::SliderFloat("Smoothing", &settings.smoothing, 0.01f, 1.0f);
+            ImGui::SliderInt("Raise delay", &settings.raiseDelay, 1, 120);
+        }
+        else {
+            ImGui::SliderFloat("Scale", &settings.scale, settings.minScale, settings.maxScale);
+        }
+        ImGui::DragFloatRange2("Scale range", &settings.minScale, &settings.maxScale, 0.01f, 0.25f, 1.0f, "min %.2f", "max %.2f");
+        ImGui::SliderFloat("Step", &settings.step, 0.01f, 0.25f);
+        int filter = (int)settings.filter;
+        ImGui::Combo("Upscale", &filter, "bilinear\0sharpen\0");
+        settings.filter = (UpscaleFilter)filter;
+        if (settings.filter == UpscaleFilter::Sharpen) {
+            ImGui::SliderFloat("Sharpness", &settings.sharpness, 0.0f, 2.0f);
+        }
+
+        ImGui::SeparatorText("Telemetry");
+        ImGui::Text("scale %.2f, %dx%d, %u changes", stats.scale, stats.width, stats.height, stats.changes);
+        ImGui::Text("GPU %.3f ms at %.2f, %.3f ms estimated at full resolution", stats.gpuMs, stats.gpuScale, stats.fullMs);
+        if (stats.historyCount > 0) {
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "GPU ms (target %.2f)", settings.targetMs);
+            ImGui::PlotLines("##resolutiongpu", stats.gpuHistory, (int)stats.historyCount, (int)stats.historyOffset, overlay,
+                0.0f, settings.targetMs * 2.0f, ImVec2(0, 60));
+            ImGui::PlotLines("##resolutionscale", stats.scaleHistory, (int)stats.historyCount, (int)stats.historyOffset, "scale",
+                0.0f, 1.0f, ImVec2(0, 60));
+        }
+
+        ImGui::End();
+    }
+
+    /**
+     * @brief Passes of the last frame graph in schedule order, the culled ones after, and its transients
+     */
+    inline void drawRenderGraph(bool* p_open, const RenderGraph& graph) {
+        if (!ImGui::Begin("Render graph", p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        const RenderGraphStats& stats = graph.stats();
+        ImGui::Text("%u passes, %u culled, %u barriers", stats.passes, stats.culled, stats.barriers);
+        ImGui::Text("%u transient targets, %u buffers: %.2f MB, %.2f MB aliased", stats.transientTextures, stats.transientBuffers,
+                    stats.transientBytes / 1048576.0, stats.aliasedBytes / 1048576.0);
+        ImGui::Text("compile %.3f ms, execute %.3f ms CPU", stats.compileMs, stats.executeMs);
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+        if (ImGui::BeginTable("##graphpasses", 4, flags)) {
+            for (const char* column : { "pass", "cpu ms", "gpu ms", "barrier" })
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+            auto row = [](const RenderGraphPassInfo& pass) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (pass.culled)
+                    ImGui::TextDisabled("%s (culled)", pass.name);
+                else
+                    ImGui::TextUnformatted(pass.name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", pass.cpuMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", pass.gpuMs);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(memory_barrier_names(pass.barriers).c_str());
+            };
+            for (size_t order = 0; order < graph.passCount(); order++) {
+                for (size_t i = 0; i < graph.passCount(); i++) {
+                    if (!graph.pass(i).culled && graph.pass(i).order == order)
+                        row(graph.pass(i));
+                }
+            }
+            for (size_t i = 0; i < graph.passCount(); i++) {
+                if (graph.pass(i).culled)
+                    row(graph.pass(i));
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::Button("Write render_graph.dot")) {
+            graph.writeDot("render_graph.dot");
+        }
+
+        ImGui::End();
+    }
+
 private:
     GLFWwindow *m_window;
     ImGuiIO* m_io;
     ImGuiWindowFlags m_windowFlags;
+    int m_profilerFrame;
+    bool m_profilerPaused;
+    MemorySnapshot m_memoryLast;
+    float m_memoryChurn[MemorySnapshot::kTags + 1][2];     // allocations and bytes per frame
+
+    static void* _allocate(size_t size, void*) {
+        return Memory::allocate(size, MemoryTag::GUI);
+    }
+
+    static void _free(void* ptr, void*) {
+        Memory::deallocate(ptr);
+    }
+
+    /// Red when over `budget`
+    inline void _drawBytes(uint64_t bytes, const MemoryBudget* budget = nullptr) {
+        const bool over = budget && bytes > budget->bytes;
+        if (over)
+            ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(255, 80, 80, 255));
+        if (bytes >= 1024 * 1024)
+            ImGui::Text("%.2f MB", bytes / (1024.0 * 1024.0));
+        else
+            ImGui::Text("%.1f KB", bytes / 1024.0);
+        if (over) {
+            ImGui::PopStyleColor();
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("budget %.2f MB", budget->bytes / (1024.0 * 1024.0));
+        }
+    }
+
+    /// One row per nesting level, threads stacked below each other
+    inline void _drawFlameGraph(const char* id, const std::vector<ProfileScopeRecord>& scopes, uint64_t start, uint64_t end) {
+        int depthPerThread[Profiler::kMaxThreads] = {};
+        for (const auto& scope : scopes) {
+            if (scope.depth + 1 > depthPerThread[scope.thread])
+                depthPerThread[scope.thread] = scope.depth + 1;
+        }
+        int firstRow[Profiler::kMaxThreads] = {};
+        int rows = 0;
+        for (size_t t = 0; t < Profiler::kMaxThreads; t++) {
+            firstRow[t] = rows;
+            rows += depthPerThread[t];
+        }
+
+        const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float width = ImGui::GetContentRegionAvail().x;
+        const double span = end > start ? (double)(end - start) : 1.0;
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+        ImGui::PushID(id);
+        for (const auto& scope : scopes) {
+            float x0 = origin.x + (float)((double)(scope.start - start) / span) * width;
+            float x1 = origin.x + (float)((double)(scope.end - start) / span) * width;
+            float y0 = origin.y + (firstRow[scope.thread] + scope.depth) * rowHeight;
+            ImVec2 min(x0, y0), max(x1 > x0 + 1.0f ? x1 : x0 + 1.0f, y0 + rowHeight - 1.0f);
+
+            // stable color per scope name
+            unsigned int hash = 2166136261u;
+            for (const char* c = scope.name; *c; c++)
+                hash = (hash ^ (unsigned char)*c) * 16777619u;
+            ImU32 color = IM_COL32(80 + (hash & 0x7f), 80 + ((hash >> 8) & 0x7f), 80 + ((hash >> 16) & 0x7f), 255);
+
+            drawList->AddRectFilled(min, max, color);
+            if (max.x - min.x > ImGui::CalcTextSize(scope.name).x + 4.0f) {
+                drawList->PushClipRect(min, max, true);
+                drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_WHITE, scope.name);
+                drawList->PopClipRect();
+            }
+            if (ImGui::IsMouseHoveringRect(min, max)) {
+                ImGui::SetTooltip("%s\n%.3f ms", scope.name, (scope.end - scope.start) * 1e-6);
+            }
+        }
+        ImGui::PopID();
+
+        ImGui::Dummy(ImVec2(width, (rows > 0 ? rows : 1) * rowHeight));
+    }
 };
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "AnimationClip.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Skeleton.h"
+#include "../math/BatchMath.h"
+
+/// Index of the last key at or before `time`, and the blend towards the next one
+static size_t find_key(const std::vector<float>& times, float time, float& blend) {
+    auto next = std::upper_bound(times.begin(), times.end(), time);
+    if (next == times.begin()) {
+        blend = 0.0f;
+        return 0;
+    }
+    if (next == times.end()) {
+        blend = 0.0f;
+        return times.size() - 1;
+    }
+
+    size_t key = (size_t)(next - times.begin()) - 1;
+    float span = times[key + 1] - times[key];
+    blend = span > 0.0f ? (time - times[key]) / span : 0.0f;
+    return key;
+}
+
+static glm::vec3 evaluate(const std::vector<float>& times, const std::vector<glm::vec3>& keys, float time, const glm::vec3& fallback) {
+    if (keys.empty()) {
+        return fallback;
+    }
+
+    float blend;
+    size_t key = find_key(times, time, blend);
+    if (blend == 0.0f) {
+        return keys[key];
+    }
+    return keys[key] + (keys[key + 1] - keys[key]) * blend;
+}
+
+static glm::quat evaluate(const std::vector<float>& times, const std::vector<glm::quat>& keys, float time, const glm::quat& fallback) {
+    if (keys.empty()) {
+        return fallback;
+    }
+
+    float blend;
+    size_t key = find_key(times, time, blend);
+    if (blend == 0.0f) {
+        return keys[key];
+    }
+    return glm::normalize(glm::slerp(keys[key], keys[key + 1], blend));
+}
+
+AnimationClip::AnimationClip()
+    : m_name(),
+      m_duration(0.0f),
+      m_sampleRate(kDefaultSampleRate),
+      m_frameCount(0),
+      m_jointCount(0),
+      m_translations(),
+      m_rotations(),
+      m_scales()
+{
+}
+
+static float smallest_interval(const std::vector<float>& times, float smallest) {
+    for (size_t i = 1; i < times.size(); i++) {
+        float interval = times[i] - times[i - 1];
+        if (interval > 0.0f && interval < smallest) {
+            smallest = interval;
+        }
+    }
+    return smallest;
+}
+
+float AnimationClip::suggestedSampleRate(const std::vector<JointTrack>& tracks) {
+    float smallest = 1.0f / kDefaultSampleRate;
+    for (const JointTrack& track : tracks) {
+        smallest = smallest_interval(track.positionTimes, smallest);
+        smallest = smallest_interval(track.rotationTimes, smallest);
+        smallest = smallest_interval(track.scaleTimes, smallest);
+    }
+    return std::min(std::ceil(1.0f / smallest), kMaxSampleRate);
+}
+
+bool AnimationClip::build(const std::string& name, float duration, const Skeleton& skeleton,
+                          const std::vector<JointTrack>& tracks, float sampleRate)
+{
+    if (skeleton.empty() || duration < 0.0f || sampleRate <= 0.0f) {
+        return false;
+    }
+
+    m_name = name;
+    m_duration = duration;
+    m_sampleRate = sampleRate;
+    m_jointCount = skeleton.jointCount();
+    // both ends are sampled, a looping clip blends from the last frame back into the first
+    m_frameCount = (size_t)std::ceil(duration * sampleRate) + 1;
+
+    const size_t count = m_frameCount * m_jointCount;
+    m_translations.resize(count);
+    m_rotations.resize(count);
+    m_scales.resize(count);
+
+    static const JointTrack bindPose;
+
+    for (size_t frame = 0; frame < m_frameCount; frame++) {
+        float time = std::min((float)frame / sampleRate, duration);
+        size_t base = frame * m_jointCount;
+
+        for (size_t joint = 0; joint < m_jointCount; joint++) {
+            const JointTrack& track = joint < tracks.size() ? tracks[joint] : bindPose;
+
+            m_translations[base + joint] = evaluate(track.positionTimes, track.positions, time, skeleton.bindTranslations()[joint]);
+            m_scales[base + joint] = evaluate(track.scaleTimes, track.scales, time, skeleton.bindScales()[joint]);
+
+            glm::quat rotation = evaluate(track.rotationTimes, track.rotations, time, skeleton.bindRotations()[joint]);
+            if (frame > 0 && glm::dot(rotation, m_rotations[base - m_jointCount + joint]) < 0.0f) {
+                rotation = -rotation;
+            }
+            m_rotations[base + joint] = rotation;
+        }
+    }
+
+    return true;
+}
+
+void AnimationClip::sample(float time, bool loop, glm::vec3* translations, glm::quat* rotations, glm::vec3* scales) const {
+    if (m_frameCount == 0) {
+        return;
+    }
+
+    if (loop && m_duration > 0.0f) {
+        time = std::fmod(time, m_duration);
+        if (time < 0.0f) {
+            time += m_duration;
+        }
+    }
+    else {
+        time = std::clamp(time, 0.0f, m_duration);
+    }
+
+    size_t frame = std::min((size_t)(time * m_sampleRate), m_frameCount - 1);
+    size_t next = std::min(frame + 1, m_frameCount - 1);
+    // build samples the last frame at the duration, less than a frame after the one before it
+    // when the clip is not a whole number of frames long: blend over the same times
+    float from = (float)frame / m_sampleRate;
+    float to = std::min((float)next / m_sampleRate, m_duration);
+    float blend = to > from ? std::clamp((time - from) / (to - from), 0.0f, 1.0f) : 0.0f;
+
+    const size_t a = frame * m_jointCount;
+    const size_t b = next * m_jointCount;
+
+    // translation and scale are plain float lerps, which the compiler vectorizes
+    const float* ta = &m_translations[a].x;
+    const float* tb = &m_translations[b].x;
+    const float* sa = &m_scales[a].x;
+    const float* sb = &m_scales[b].x;
+    float* t = &translations[0].x;
+    float* s = &scales[0].x;
+    for (size_t i = 0; i < m_jointCount * 3; i++) {
+        t[i] = ta[i] + (tb[i] - ta[i]) * blend;
+        s[i] = sa[i] + (sb[i] - sa[i]) * blend;
+    }
+
+    quat_nlerp_batch(&m_rotations[a], &m_rotations[b], blend, rotations, m_jointCount);
+}
+
+size_t AnimationClip::byteSize() const {
+    return m_translations.size() * sizeof(glm::vec3) + m_rotations.size() * sizeof(glm::quat) + m_scales.size() * sizeof(glm::vec3);
+}
@@ -0,0 +1,87 @@
+#ifndef _ANIMATION_CLIP_H_
+#define _ANIMATION_CLIP_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Skeleton;
+
+/**
+ * @brief Keyframes of one joint as they come out of the importer, times in seconds
+ *
+ * Channels without keys fall back to the bind pose.
+ */
+struct JointTrack {
+    std::vector<float> positionTimes;
+    std::vector<glm::vec3> positions;
+    std::vector<float> rotationTimes;
+    std::vector<glm::quat> rotations;
+    std::vector<float> scaleTimes;
+    std::vector<glm::vec3> scales;
+};
+
+/**
+ * @brief An animation resampled to a fixed rate, one pose per frame
+ *
+ * Imported tracks have their own key times per channel; evaluating them means a search per
+ * joint per channel. `build` resamples every joint at `sampleRate` into frame-major arrays
+ * so that `sample` is two contiguous reads and a blend over the whole skeleton, which the
+ * batch kernels can vectorize. Rotations are kept in the hemisphere of the previous frame,
+ * so a normalized lerp between neighbours never takes the long way around.
+ */
+class AnimationClip {
+public:
+    static constexpr float kDefaultSampleRate = 30.0f;
+    static constexpr float kMaxSampleRate = 120.0f;
+
+    /**
+     * @brief A rate that puts a sample at least as often as the densest keys
+     *
+     * Resampling below the key rate cuts the corners off keys that fall between samples.
+     * Clamped to [kDefaultSampleRate, kMaxSampleRate].
+     */
+    static float suggestedSampleRate(const std::vector<JointTrack>& tracks);
+
+    AnimationClip();
+
+    /**
+     * @brief Resamples `tracks` (indexed by joint, may be shorter than the skeleton)
+     */
+    bool build(const std::string& name, float duration, const Skeleton& skeleton,
+               const std::vector<JointTrack>& tracks, float sampleRate = kDefaultSampleRate);
+
+    /**
+     * @brief Local pose at `time` seconds, one entry per joint in each array
+     */
+    void sample(float time, bool loop, glm::vec3* translations, glm::quat* rotations, glm::vec3* scales) const;
+
+    const std::string& name() const { return m_name; }
+
+    float duration() const { return m_duration; }
+
+    float sampleRate() const { return m_sampleRate; }
+
+    size_t frameCount() const { return m_frameCount; }
+
+    size_t jointCount() const { return m_jointCount; }
+
+    size_t byteSize() const;
+
+private:
+    std::string m_name;
+    float m_duration;
+    float m_sampleRate;
+    size_t m_frameCount;
+    size_t m_jointCount;
+
+    // [frame * jointCount + joint]
+    std::vector<glm::vec3> m_translations;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
+};
+
+#endif // !_ANIMATION_CLIP_H_
@@ -0,0 +1,122 @@
+#include "AnimationSystem.h"
+
+#include "AnimationClip.h"
+#include "Skeleton.h"
+#include "../core/ThreadPool.h"
+#include "../math/BatchMath.h"
+#include "../opengl/utils.h"
+
+namespace {
+
+/// Per-thread pose buffers, sized for the largest skeleton seen so far
+struct PoseScratch {
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+
+    void reserve(size_t joints) {
+        if (translations.size() < joints) {
+            translations.resize(joints);
+            rotations.resize(joints);
+            scales.resize(joints);
+            locals.resize(joints);
+            worlds.resize(joints);
+        }
+    }
+};
+
+thread_local PoseScratch t_scratch;
+
+}
+
+AnimationSystem::AnimationSystem()
+    : m_instances(), m_palettes(), m_buffer(0), m_bufferSize(0)
+{}
+
+AnimationSystem::~AnimationSystem() {}
+
+uint32_t AnimationSystem::add(const Skeleton& skeleton, const AnimationClip& clip, float startTime, float speed, bool loop) {
+    AnimationInstance instance{ &skeleton, &clip, startTime, speed, loop, (uint32_t)m_palettes.size() };
+    m_palettes.resize(m_palettes.size() + skeleton.jointCount(), glm::mat4(1.0f));
+    m_instances.push_back(instance);
+    return (uint32_t)m_instances.size() - 1;
+}
+
+void AnimationSystem::clear() {
+    m_instances.clear();
+    m_palettes.clear();
+}
+
+void AnimationSystem::_evaluate(AnimationInstance& instance, float dt) {
+    const Skeleton& skeleton = *instance.skeleton;
+    const size_t joints = skeleton.jointCount();
+
+    PoseScratch& pose = t_scratch;
+    pose.reserve(joints);
+
+    instance.time += dt * instance.speed;
+    instance.clip->sample(instance.time, instance.loop, pose.translations.data(), pose.rotations.data(), pose.scales.data());
+    compose_transform_batch(pose.translations.data(), pose.rotations.data(), pose.scales.data(), pose.locals.data(), joints);
+
+    // depth first: every parent is resolved before its children
+    const uint32_t* parents = skeleton.parents();
+    glm::mat4* worlds = pose.worlds.data();
+    const glm::mat4* locals = pose.locals.data();
+    for (size_t joint = 0; joint < joints; joint++) {
+        worlds[joint] = parents[joint] == Skeleton::kNoJoint ? locals[joint] : worlds[parents[joint]] * locals[joint];
+    }
+
+    mat4_mul_batch(worlds, skeleton.inverseBinds(), m_palettes.data() + instance.paletteOffset, joints);
+}
+
+void AnimationSystem::update(float dt) {
+    for (AnimationInstance& instance : m_instances) {
+        _evaluate(instance, dt);
+    }
+}
+
+void AnimationSystem::update(float dt, ThreadPool& pool) {
+    pool.parallelFor(m_instances.size(), 8, [this, dt](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            _evaluate(m_instances[i], dt);
+        }
+    });
+}
+
+bool AnimationSystem::upload() {
+    const size_t size = m_palettes.size() * sizeof(glm::mat4);
+    if (size == 0) {
+        return false;
+    }
+
+    if (!m_buffer) {
+        GL_CALL(glGenBuffers(1, &m_buffer));
+    }
+
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer));
+    if (size != m_bufferSize) {
+        GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, size, m_palettes.data(), GL_STREAM_DRAW));
+        m_bufferSize = size;
+    }
+    else {
+        // orphan the old storage so the upload does not wait for last frame's draws
+        GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_STREAM_DRAW));
+        GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, m_palettes.data()));
+    }
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    return true;
+}
+
+void AnimationSystem::bind() const {
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kPaletteBinding, m_buffer));
+}
+
+void AnimationSystem::releaseGpu() {
+    if (m_buffer) {
+        GL_CALL(glDeleteBuffers(1, &m_buffer));
+        m_buffer = 0;
+        m_bufferSize = 0;
+    }
+}
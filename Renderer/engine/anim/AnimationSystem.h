@@ -0,0 +1,98 @@
+#ifndef _ANIMATION_SYSTEM_H_
+#define _ANIMATION_SYSTEM_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class AnimationClip;
+class Skeleton;
+class ThreadPool;
+
+/// One animated character: which clip it plays and where its palette lives
+struct AnimationInstance {
+    const Skeleton* skeleton;
+    const AnimationClip* clip;
+    float time;
+    float speed;
+    bool loop;
+    uint32_t paletteOffset;     // first matrix of this instance in `palettes()`
+};
+
+/**
+ * @brief Samples clips and builds skinning palettes for every animated instance
+ *
+ * Per instance and frame: sample the clip into a local pose, compose local matrices,
+ * resolve them down the joint hierarchy and multiply by the inverse bind matrices. The
+ * resulting palettes of all instances sit back to back in one array, which `upload`
+ * copies into a single shader storage buffer; a skinned draw only needs its instance's
+ * `paletteOffset` (see assets/shaders/anim/skinned.vert).
+ *
+ * Instances are independent, `update(dt, pool)` spreads them over the thread pool.
+ */
+class AnimationSystem {
+public:
+    /// Binding point of the palette storage buffer, matches skinned.vert
+    static constexpr unsigned int kPaletteBinding = 0;
+
+    AnimationSystem();
+
+    AnimationSystem(const AnimationSystem& other) = delete;
+
+    AnimationSystem& operator=(const AnimationSystem& other) = delete;
+
+    ~AnimationSystem();
+
+    /**
+     * @brief Adds an instance, returns its index
+     *
+     * The skeleton and clip are not owned and must outlive the system.
+     */
+    uint32_t add(const Skeleton& skeleton, const AnimationClip& clip, float startTime = 0.0f, float speed = 1.0f, bool loop = true);
+
+    void clear();
+
+    size_t instanceCount() const { return m_instances.size(); }
+
+    AnimationInstance& instance(uint32_t index) { return m_instances[index]; }
+    const AnimationInstance& instance(uint32_t index) const { return m_instances[index]; }
+
+    /**
+     * @brief Advances every instance by `dt` seconds and rebuilds its palette
+     */
+    void update(float dt);
+
+    void update(float dt, ThreadPool& pool);
+
+    const std::vector<glm::mat4>& palettes() const { return m_palettes; }
+
+    const glm::mat4* palette(uint32_t index) const { return m_palettes.data() + m_instances[index].paletteOffset; }
+
+    /// Joints sampled and skinned by the last update
+    size_t jointsEvaluated() const { return m_palettes.size(); }
+
+    /**
+     * @brief Copies every palette into the storage buffer, needs a current context
+     */
+    bool upload();
+
+    /// Binds the storage buffer to kPaletteBinding
+    void bind() const;
+
+    /// Frees the storage buffer, needs a current context; the destructor does not touch GL
+    void releaseGpu();
+
+    size_t gpuBytes() const { return m_bufferSize; }
+
+private:
+    std::vector<AnimationInstance> m_instances;
+    std::vector<glm::mat4> m_palettes;
+    unsigned int m_buffer;
+    size_t m_bufferSize;
+
+    void _evaluate(AnimationInstance& instance, float dt);
+};
+
+#endif // !_ANIMATION_SYSTEM_H_
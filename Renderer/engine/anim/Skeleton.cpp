@@ -0,0 +1,41 @@
+#include "Skeleton.h"
+
+#include "../scene/Components.h"
+
+uint32_t Skeleton::addJoint(const std::string& name, uint32_t parent, const glm::mat4& local) {
+    uint32_t joint = (uint32_t)m_parents.size();
+
+    glm::vec3 translation, scale;
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    decompose_transform(local, translation, rotation, scale);
+
+    m_names.push_back(name);
+    m_parents.push_back(parent);
+    m_bindTranslations.push_back(translation);
+    m_bindRotations.push_back(rotation);
+    m_bindScales.push_back(scale);
+    m_inverseBinds.push_back(glm::mat4(1.0f));
+
+    // the first joint of a name wins, like Assimp's own lookups
+    m_lookup.emplace(name, joint);
+    return joint;
+}
+
+void Skeleton::setInverseBind(uint32_t joint, const glm::mat4& inverseBind) {
+    m_inverseBinds[joint] = inverseBind;
+}
+
+uint32_t Skeleton::find(const std::string& name) const {
+    auto it = m_lookup.find(name);
+    return it == m_lookup.end() ? kNoJoint : it->second;
+}
+
+void Skeleton::clear() {
+    m_names.clear();
+    m_parents.clear();
+    m_bindTranslations.clear();
+    m_bindRotations.clear();
+    m_bindScales.clear();
+    m_inverseBinds.clear();
+    m_lookup.clear();
+}
@@ -0,0 +1,62 @@
+#ifndef _SKELETON_H_
+#define _SKELETON_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Joint hierarchy and bind pose of a skinned model
+ *
+ * Joints are stored depth first (a parent always comes before its children), so a pose
+ * is resolved to world space in a single front-to-back pass. Every node of the imported
+ * hierarchy is a joint; the ones no vertex is bound to keep an identity inverse bind
+ * matrix and only carry transforms down to their children.
+ */
+class Skeleton {
+public:
+    static constexpr uint32_t kNoJoint = UINT32_MAX;
+
+    /**
+     * @brief Appends a joint; `parent` must already exist (or be kNoJoint)
+     */
+    uint32_t addJoint(const std::string& name, uint32_t parent, const glm::mat4& local);
+
+    void setInverseBind(uint32_t joint, const glm::mat4& inverseBind);
+
+    /// kNoJoint if there is no joint with that name
+    uint32_t find(const std::string& name) const;
+
+    size_t jointCount() const { return m_parents.size(); }
+
+    bool empty() const { return m_parents.empty(); }
+
+    void clear();
+
+    const std::string& name(uint32_t joint) const { return m_names[joint]; }
+
+    const uint32_t* parents() const { return m_parents.data(); }
+
+    const glm::vec3* bindTranslations() const { return m_bindTranslations.data(); }
+    const glm::quat* bindRotations() const { return m_bindRotations.data(); }
+    const glm::vec3* bindScales() const { return m_bindScales.data(); }
+
+    /// Mesh space to joint space, per joint
+    const glm::mat4* inverseBinds() const { return m_inverseBinds.data(); }
+
+private:
+    std::vector<std::string> m_names;
+    std::vector<uint32_t> m_parents;
+    std::vector<glm::vec3> m_bindTranslations;
+    std::vector<glm::quat> m_bindRotations;
+    std::vector<glm::vec3> m_bindScales;
+    std::vector<glm::mat4> m_inverseBinds;
+    std::unordered_map<std::string, uint32_t> m_lookup;
+};
+
+#endif // !_SKELETON_H_
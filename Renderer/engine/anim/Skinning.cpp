@@ -0,0 +1,47 @@
+#include "Skinning.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+void skin_vertices(const void* vertices, size_t count, const SkinningLayout& layout, const glm::mat4* palette,
+                   glm::vec3* outPositions, glm::vec3* outNormals)
+{
+    const uint8_t* base = (const uint8_t*)vertices;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* vertex = base + i * layout.stride;
+
+        glm::vec3 position, normal;
+        int joints[4];
+        float weights[4];
+        std::memcpy(&position, vertex + layout.position, sizeof(position));
+        std::memcpy(&normal, vertex + layout.normal, sizeof(normal));
+        std::memcpy(joints, vertex + layout.joints, sizeof(joints));
+        std::memcpy(weights, vertex + layout.weights, sizeof(weights));
+
+        glm::mat4 skin(0.0f);
+        float total = 0.0f;
+        for (int k = 0; k < 4; k++) {
+            if (joints[k] < 0 || weights[k] == 0.0f) {
+                continue;
+            }
+            const glm::mat4& m = palette[joints[k]];
+            skin[0] += m[0] * weights[k];
+            skin[1] += m[1] * weights[k];
+            skin[2] += m[2] * weights[k];
+            skin[3] += m[3] * weights[k];
+            total += weights[k];
+        }
+        if (total == 0.0f) {
+            skin = glm::mat4(1.0f);
+        }
+
+        outPositions[i] = glm::vec3(skin * glm::vec4(position, 1.0f));
+        if (outNormals) {
+            glm::vec3 n = glm::vec3(skin * glm::vec4(normal, 0.0f));
+            float length = std::sqrt(glm::dot(n, n));
+            outNormals[i] = length > 0.0f ? n / length : n;
+        }
+    }
+}
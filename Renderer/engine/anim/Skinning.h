@@ -0,0 +1,31 @@
+#ifndef _SKINNING_H_
+#define _SKINNING_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/**
+ * @brief Where the skinning inputs sit inside an interleaved vertex, in bytes
+ *
+ * Joints are four ints (negative = unused slot), weights four floats.
+ */
+struct SkinningLayout {
+    size_t stride;
+    size_t position;
+    size_t normal;
+    size_t joints;
+    size_t weights;
+};
+
+/**
+ * @brief Linear blend skinning on the CPU
+ *
+ * Same math as skinned.vert; it exists to validate the GPU path and for tools that need
+ * posed geometry (picking, bounds). Normals go through the 3x3 part of the blended
+ * matrix and are renormalized, which is exact for rotations and uniform scale.
+ */
+void skin_vertices(const void* vertices, size_t count, const SkinningLayout& layout, const glm::mat4* palette,
+                   glm::vec3* outPositions, glm::vec3* outNormals);
+
+#endif // !_SKINNING_H_
@@ -7,6 +7,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.h"
+#include "../opengl/RenderStats.h"
+#include "../opengl/utils.h"
+#include "../core/Memory.h"
+#include "../anim/Skinning.h"
+#include "../geometry/VertexCompression.h"
+#include "../geometry/Meshlets.h"
+#include "../geometry/ClusterCulling.h"
+#include "../render/CommandList.h"
 
 #include <string>
 #include <vector>
@@ -14,6 +22,8 @@ using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
 
+namespace asset {
+
 struct Vertex {
     // position
     glm::vec3 Position;
@@ -31,6 +41,12 @@ struct Vertex {
 	float m_Weights[MAX_BONE_INFLUENCE];
 };
 
+// how a mesh stores its vertices on the GPU
+enum class VertexFormat {
+    Full,       // Vertex as is, 88 bytes
+    Compressed  // PackedVertex (+ skin), decoded by shaders built with the COMPRESSED_VERTICES define
+};
+
 struct Texture {
     unsigned int id;
     string type;
@@ -44,13 +60,24 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    VertexFormat format;
+    // compressed positions decode as positionOffset + aPos.xyz * positionScale
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    // bytes per vertex in the vertex buffer
+    size_t gpuVertexStride = sizeof(Vertex);
+    // filled by BuildMeshlets; indices are then in meshlet order
+    MeshletMesh meshlets;
+    unsigned int meshletBuffer = 0, meshletBoundsBuffer = 0, commandBuffer = 0;
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexFormat format = VertexFormat::Full)
     {
+        MemoryScope scope(MemoryTag::Mesh);
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->format = format;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
@@ -59,48 +86,210 @@ public:
     // render the mesh
     void Draw(Shader &shader) 
     {
-        // bind appropriate textures
+        bindMaterial(shader);
+
+        // draw mesh
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        RenderStats::get().recordDraw(GL_TRIANGLES, indices.size());
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // records the same draw into a command list, no GL calls: safe on any thread
+    void Draw(Shader &shader, CommandList &list) const
+    {
+        list.bindPipeline(shader.ID);
+
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
+        for(unsigned int i = 0; i < textures.size() && i < CommandList::kMaxTextureUnits; i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
+            const string &name = textures[i].type;
+            unsigned int number = 0;
             if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
+                number = diffuseNr++;
             else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
+                number = specularNr++;
             else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
+                number = normalNr++;
+            else if(name == "texture_height")
+                number = heightNr++;
 
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            char sampler[64];
+            if(number)
+                snprintf(sampler, sizeof(sampler), "%s%u", name.c_str(), number);
+            else
+                snprintf(sampler, sizeof(sampler), "%s", name.c_str());
+            list.setUniform(sampler, (int)i);
+            list.bindTexture(i, textures[i].id);
         }
-        
-        // draw mesh
+
+        if(format == VertexFormat::Compressed)
+        {
+            list.setUniform("positionOffset", positionOffset);
+            list.setUniform("positionScale", positionScale);
+            // see bindMaterial: 5 is the integer joint input, 6 the float weights
+            list.setZeroAttributes(compressedSkin ? 0 : 1 << 6, compressedSkin ? 0 : 1 << 5);
+        }
+        else
+        {
+            list.setZeroAttributes(0, 0);
+        }
+
+        list.bindVertexArray(VAO);
+        list.drawElements(PrimitiveType::Triangles, static_cast<uint32_t>(indices.size()), IndexType::UInt32);
+    }
+
+    // splits the mesh into meshlets, reorders the index buffer to match and uploads what culling needs
+    void BuildMeshlets()
+    {
+        if(vertices.empty() || indices.empty())
+            return;
+        MemoryScope scope(MemoryTag::Mesh);
+        build_meshlets(&vertices[0].Position, sizeof(Vertex), vertices.size(), indices.data(), indices.size(), meshlets);
+        indices = meshlets.indices;
+
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        gl_track_buffer(EBO, GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int));
         glBindVertexArray(0);
 
-        // always good practice to set everything back to defaults once configured.
+        if(!meshletBuffer)
+        {
+            glGenBuffers(1, &meshletBuffer);
+            glGenBuffers(1, &meshletBoundsBuffer);
+            glGenBuffers(1, &commandBuffer);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, meshlets.meshlets.size() * sizeof(Meshlet), meshlets.meshlets.data(), GL_STATIC_DRAW);
+        gl_track_buffer(meshletBuffer, GL_SHADER_STORAGE_BUFFER, meshlets.meshlets.size() * sizeof(Meshlet));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletBoundsBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, meshlets.bounds.size() * sizeof(MeshletBounds), meshlets.bounds.data(), GL_STATIC_DRAW);
+        gl_track_buffer(meshletBoundsBuffer, GL_SHADER_STORAGE_BUFFER, meshlets.bounds.size() * sizeof(MeshletBounds));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        // one command per meshlet: written by GpuClusterCuller, or the CPU survivors by DrawMeshlets
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, meshlets.meshlets.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+        gl_track_buffer(commandBuffer, GL_DRAW_INDIRECT_BUFFER, meshlets.meshlets.size() * sizeof(DrawElementsIndirectCommand));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // draws the meshlets that survived cull_meshlets
+    void DrawMeshlets(Shader &shader, const vector<DrawElementsIndirectCommand> &commands)
+    {
+        if(commands.empty())
+            return;
+        bindMaterial(shader);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+        glBindVertexArray(VAO);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)commands.size(), 0);
+        for(const DrawElementsIndirectCommand &command : commands)
+            RenderStats::get().recordDraw(GL_TRIANGLES, command.count);
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // draws the commands a GpuClusterCuller wrote into commandBuffer, one per meshlet
+    void DrawMeshletsIndirect(Shader &shader)
+    {
+        if(meshlets.meshlets.empty())
+            return;
+        bindMaterial(shader);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBindVertexArray(VAO);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)meshlets.meshlets.size(), 0);
+        // the survivors are only known on the GPU: count the upper bound
+        RenderStats::get().recordDraw(GL_TRIANGLES, indices.size());
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
         glActiveTexture(GL_TEXTURE0);
     }
 
+    // skins the vertices on the CPU with the same math as the GPU path, for validation
+    void SkinOnCpu(const glm::mat4 *palette, vector<glm::vec3> &positions, vector<glm::vec3> &normals) const
+    {
+        const SkinningLayout layout = { sizeof(Vertex), offsetof(Vertex, Position), offsetof(Vertex, Normal),
+                                        offsetof(Vertex, m_BoneIDs), offsetof(Vertex, m_Weights) };
+        positions.resize(vertices.size());
+        normals.resize(vertices.size());
+        skin_vertices(vertices.data(), vertices.size(), layout, palette, positions.data(), normals.data());
+    }
+
+    size_t gpuVertexBytes() const { return vertices.size() * gpuVertexStride; }
+
 private:
     // render data 
     unsigned int VBO, EBO;
+    bool compressedSkin = false;
+
+    // textures and per-mesh decode uniforms
+    void bindMaterial(Shader &shader)
+    {
+        // bind appropriate textures
+        unsigned int diffuseNr  = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr   = 1;
+        unsigned int heightNr   = 1;
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+            // retrieve texture number (the N in diffuse_textureN)
+            unsigned int number = 0;
+            const string &name = textures[i].type;
+            if(name == "texture_diffuse")
+                number = diffuseNr++;
+            else if(name == "texture_specular")
+                number = specularNr++;
+            else if(name == "texture_normal")
+                number = normalNr++;
+            else if(name == "texture_height")
+                number = heightNr++;
+
+            // now set the sampler to the correct texture unit; built on the stack, name + number
+            // outgrows the small string buffer and would hit the heap every draw
+            char sampler[64];
+            if(number)
+                snprintf(sampler, sizeof(sampler), "%s%u", name.c_str(), number);
+            else
+                snprintf(sampler, sizeof(sampler), "%s", name.c_str());
+            glUniform1i(glGetUniformLocation(shader.ID, sampler), i);
+            // and finally bind the texture
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+        
+        if(format == VertexFormat::Compressed)
+        {
+            shader.setVec3("positionOffset", positionOffset);
+            shader.setVec3("positionScale", positionScale);
+            // no skin stream: locations 5/6 read the current (context, not VAO) values, make those "unskinned"
+            if(!compressedSkin)
+            {
+                glVertexAttribI4i(5, 0, 0, 0, 0);
+                glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+            }
+        }
+
+    }
 
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
+        if(format == VertexFormat::Compressed)
+        {
+            setupCompressedMesh();
+            return;
+        }
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -113,9 +302,11 @@ private:
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        gl_track_buffer(VBO, GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex));
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        gl_track_buffer(EBO, GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int));
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -142,5 +333,57 @@ private:
 		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
         glBindVertexArray(0);
     }
+
+    // same attribute locations, normalized integer / half formats; see PackedVertex for the layout
+    void setupCompressedMesh()
+    {
+        const VertexSourceLayout layout = { sizeof(Vertex), offsetof(Vertex, Position), offsetof(Vertex, Normal),
+                                            offsetof(Vertex, TexCoords), offsetof(Vertex, Tangent), offsetof(Vertex, Bitangent),
+                                            offsetof(Vertex, m_BoneIDs), offsetof(Vertex, m_Weights) };
+        CompressedVertices packed;
+        compress_vertices(vertices.data(), vertices.size(), layout, packed);
+        positionOffset = packed.positionOffset;
+        positionScale = packed.positionScale;
+        gpuVertexStride = packed.stride;
+        const GLsizei stride = (GLsizei)packed.stride;
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, packed.data.size(), packed.data.data(), GL_STATIC_DRAW);
+        gl_track_buffer(VBO, GL_ARRAY_BUFFER, packed.data.size());
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        gl_track_buffer(EBO, GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int));
+
+        // positions in the mesh bounds, w carries the bitangent sign
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, position));
+        // octahedral normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+        // half float texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texCoord));
+        // octahedral tangents; the bitangent is rebuilt in the shader
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, tangent));
+        if(packed.skinned())
+        {
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, packed.jointBytes == 1 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT, stride, (void*)packed.jointOffset);
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)packed.weightOffset);
+        }
+        compressedSkin = packed.skinned();
+        glBindVertexArray(0);
+    }
 };
-#endif
\ No newline at end of file
+
+} // namespace asset
+
+#endif
@@ -6,7 +6,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <ext/stb_image/stb_image.h>
+#include <stb_image/stb_image.h>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -14,6 +14,9 @@
 
 #include "mesh.h"
 #include "shader.h"
+#include "../scene/TransformHierarchy.h"
+#include "../anim/AnimationClip.h"
+#include "../anim/Skeleton.h"
 
 #include <string>
 #include <fstream>
@@ -23,7 +26,18 @@
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+namespace asset {
+
+inline unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+
+// assimp matrices are row-major, glm's are column-major
+inline glm::mat4 toGlm(const aiMatrix4x4 &m)
+{
+    return glm::mat4(m.a1, m.b1, m.c1, m.d1,
+                     m.a2, m.b2, m.c2, m.d2,
+                     m.a3, m.b3, m.c3, m.d3,
+                     m.a4, m.b4, m.c4, m.d4);
+}
 
 class Model 
 {
@@ -31,26 +45,187 @@ public:
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
     vector<Mesh>    meshes;
+    // node hierarchy, depth first: node i draws meshes[nodeMeshes[i][...]] with nodes.world(i)
+    TransformHierarchy nodes;
+    vector<vector<unsigned int>> nodeMeshes;
+    vector<string> nodeNames;
+    // one joint per node, in the same order; vertex bone IDs index these joints
+    Skeleton skeleton;
+    vector<AnimationClip> animations;
+    bool skinned = false;
     string directory;
     bool gammaCorrection;
+    VertexFormat vertexFormat;
+    // split meshes into meshlets at load, for DrawCulled / DrawCulledGpu
+    bool buildMeshlets;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, VertexFormat format = VertexFormat::Full, bool meshlets = false)
+        : gammaCorrection(gamma), vertexFormat(format), buildMeshlets(meshlets)
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
+    // wraps meshes made in code, procedural test geometry say, as the single node of a model
+    Model(vector<Mesh> const &meshList, bool meshlets = false)
+        : gammaCorrection(false), vertexFormat(VertexFormat::Full), buildMeshlets(meshlets)
+    {
+        MemoryScope scope(MemoryTag::Model);
+        nodes.add(TransformHierarchy::kNoParent, glm::mat4(1.0f));
+        skeleton.addJoint("root", TransformHierarchy::kNoParent, glm::mat4(1.0f));
+        nodeNames.push_back("root");
+        nodeMeshes.emplace_back();
+        for(const Mesh &mesh : meshList)
+        {
+            nodeMeshes[0].push_back((unsigned int)meshes.size());
+            meshes.push_back(mesh);
+            if(buildMeshlets)
+                meshes.back().BuildMeshlets();
+        }
+        nodes.update();
+    }
+
+    // draws the model, and thus all its meshes, with whatever "model" matrix the shader has
     void Draw(Shader &shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // draws each node's meshes with "model" set to world * the node's world matrix
+    void Draw(Shader &shader, const glm::mat4 &world)
+    {
+        nodes.update();
+        for(unsigned int node = 0; node < nodes.size(); node++)
+        {
+            if(nodeMeshes[node].empty())
+                continue;
+            shader.setMat4("model", world * nodes.world(node));
+            for(unsigned int mesh : nodeMeshes[node])
+                meshes[mesh].Draw(shader);
+        }
+    }
+
+    // the two above recorded into a command list; world transforms are updated here, so
+    // record a given model from one thread at a time
+    void Draw(Shader &shader, CommandList &list)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, list);
+    }
+
+    void Draw(Shader &shader, const glm::mat4 &world, CommandList &list)
+    {
+        nodes.update();
+        list.bindPipeline(shader.ID);
+        for(unsigned int node = 0; node < nodes.size(); node++)
+        {
+            if(nodeMeshes[node].empty())
+                continue;
+            list.setUniform("model", world * nodes.world(node));
+            for(unsigned int mesh : nodeMeshes[node])
+                meshes[mesh].Draw(shader, list);
+        }
+    }
+
+    // draws a skinned model whose palette starts at paletteOffset in the bound AnimationSystem buffer
+    void DrawSkinned(Shader &shader, const glm::mat4 &world, const glm::mat4 &viewProjection, unsigned int paletteOffset)
+    {
+        shader.setMat4("model", world);
+        shader.setMat4("mvp", viewProjection * world);
+        shader.setInt("paletteOffset", (int)paletteOffset);
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader);
+    }
+
+    // like Draw(shader, world), culling meshlets on the CPU first; eye is the camera position in world space
+    void DrawCulled(Shader &shader, const glm::mat4 &world, const glm::mat4 &viewProjection, const glm::vec3 &eye, ClusterCullStats &stats)
+    {
+        nodes.update();
+        for(unsigned int node = 0; node < nodes.size(); node++)
+        {
+            if(nodeMeshes[node].empty())
+                continue;
+            const glm::mat4 model = world * nodes.world(node);
+            const ClusterView view(viewProjection, model, eye);
+            shader.setMat4("model", model);
+            for(unsigned int mesh : nodeMeshes[node])
+            {
+                if(meshes[mesh].meshlets.meshlets.empty())
+                {
+                    meshes[mesh].Draw(shader);
+                    continue;
+                }
+                cullCommands.clear();
+                cull_meshlets(meshes[mesh].meshlets, view, cullCommands, stats);
+                meshes[mesh].DrawMeshlets(shader, cullCommands);
+            }
+        }
+    }
+
+    // like DrawCulled with the culling done by a compute pass; the culler's counters collect the stats
+    void DrawCulledGpu(Shader &shader, const glm::mat4 &world, const glm::mat4 &viewProjection, const glm::vec3 &eye, GpuClusterCuller &culler)
+    {
+        nodes.update();
+        for(unsigned int node = 0; node < nodes.size(); node++)
+        {
+            if(nodeMeshes[node].empty())
+                continue;
+            const glm::mat4 model = world * nodes.world(node);
+            const ClusterView view(viewProjection, model, eye);
+            for(unsigned int mesh : nodeMeshes[node])
+            {
+                Mesh &m = meshes[mesh];
+                if(m.meshlets.meshlets.empty())
+                {
+                    shader.use();
+                    shader.setMat4("model", model);
+                    m.Draw(shader);
+                    continue;
+                }
+                // a mesh has one command buffer, so each instance is culled right before it is drawn
+                culler.cull(m.meshletBuffer, m.meshletBoundsBuffer, m.commandBuffer, (uint32_t)m.meshlets.meshlets.size(), view);
+                shader.use();
+                shader.setMat4("model", model);
+                m.DrawMeshletsIndirect(shader);
+            }
+        }
+    }
+
+    size_t vertexCount() const
+    {
+        size_t count = 0;
+        for(const Mesh &mesh : meshes)
+            count += mesh.vertices.size();
+        return count;
+    }
+
+    // vertex buffer bytes as uploaded, in vertexFormat
+    size_t gpuVertexBytes() const
+    {
+        size_t bytes = 0;
+        for(const Mesh &mesh : meshes)
+            bytes += mesh.gpuVertexBytes();
+        return bytes;
+    }
+
+    // index of the first node with that name, or TransformHierarchy::kNoParent
+    uint32_t findNode(const string &name) const
+    {
+        for(uint32_t i = 0; i < nodeNames.size(); i++)
+            if(nodeNames[i] == name)
+                return i;
+        return TransformHierarchy::kNoParent;
+    }
     
 private:
+    // scratch for DrawCulled
+    vector<DrawElementsIndirectCommand> cullCommands;
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        MemoryScope scope(MemoryTag::Model);
         // read file via ASSIMP
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -63,25 +238,104 @@ private:
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
 
+        // the node hierarchy first: bones name the nodes they attach to, which may come after the meshes using them
+        loadNodes(scene->mRootNode, TransformHierarchy::kNoParent);
+        nodes.update();
+
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        uint32_t nodeIndex = 0;
+        processNode(scene->mRootNode, scene, nodeIndex);
+
+        loadAnimations(scene);
+
+        if(vertexFormat == VertexFormat::Compressed && vertexCount() > 0)
+        {
+            const size_t count = vertexCount();
+            const size_t full = count * sizeof(Vertex);
+            const size_t packed = gpuVertexBytes();
+            cout << "Model " << path << ": " << count << " vertices, " << (double)packed / count << " bytes/vertex (full "
+                 << sizeof(Vertex) << "), " << (full - packed) / 1024 << " KB of " << full / 1024 << " KB saved" << endl;
+        }
+    }
+
+    // adds the node and its children depth first, to the transform hierarchy and the skeleton alike
+    void loadNodes(aiNode *node, uint32_t parent)
+    {
+        glm::mat4 local = toGlm(node->mTransformation);
+        uint32_t index = nodes.add(parent, local);
+        skeleton.addJoint(node->mName.C_Str(), parent, local);
+        nodeNames.push_back(node->mName.C_Str());
+        nodeMeshes.emplace_back();
+
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+            loadNodes(node->mChildren[i], index);
+    }
+
+    // converts every animation to a clip over the skeleton, key times from ticks to seconds
+    void loadAnimations(const aiScene *scene)
+    {
+        for(unsigned int a = 0; a < scene->mNumAnimations; a++)
+        {
+            const aiAnimation* animation = scene->mAnimations[a];
+            double ticksPerSecond = animation->mTicksPerSecond != 0.0 ? animation->mTicksPerSecond : 25.0;
+
+            vector<JointTrack> tracks(skeleton.jointCount());
+            for(unsigned int c = 0; c < animation->mNumChannels; c++)
+            {
+                const aiNodeAnim* channel = animation->mChannels[c];
+                uint32_t joint = skeleton.find(channel->mNodeName.C_Str());
+                if(joint == Skeleton::kNoJoint)
+                    continue;
+
+                JointTrack& track = tracks[joint];
+                for(unsigned int k = 0; k < channel->mNumPositionKeys; k++)
+                {
+                    const aiVectorKey& key = channel->mPositionKeys[k];
+                    track.positionTimes.push_back((float)(key.mTime / ticksPerSecond));
+                    track.positions.push_back(glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+                for(unsigned int k = 0; k < channel->mNumRotationKeys; k++)
+                {
+                    const aiQuatKey& key = channel->mRotationKeys[k];
+                    track.rotationTimes.push_back((float)(key.mTime / ticksPerSecond));
+                    track.rotations.push_back(glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+                for(unsigned int k = 0; k < channel->mNumScalingKeys; k++)
+                {
+                    const aiVectorKey& key = channel->mScalingKeys[k];
+                    track.scaleTimes.push_back((float)(key.mTime / ticksPerSecond));
+                    track.scales.push_back(glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+            }
+
+            AnimationClip clip;
+            float duration = (float)(animation->mDuration / ticksPerSecond);
+            if(clip.build(animation->mName.C_Str(), duration, skeleton, tracks, AnimationClip::suggestedSampleRate(tracks)))
+                animations.push_back(std::move(clip));
+            else
+                cout << "ERROR::ASSIMP:: could not build animation " << animation->mName.C_Str() << endl;
+        }
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    // the recursion visits nodes in the same depth first order as loadNodes, nodeIndex counts them.
+    void processNode(aiNode *node, const aiScene *scene, uint32_t &nodeIndex)
     {
+        uint32_t index = nodeIndex++;
+
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            nodeMeshes[index].push_back((unsigned int)meshes.size());
             meshes.push_back(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, nodeIndex);
         }
     }
 
@@ -132,9 +386,16 @@ private:
             }
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+            // no bone influences until extractBoneWeights says otherwise
+            for(int k = 0; k < MAX_BONE_INFLUENCE; k++)
+            {
+                vertex.m_BoneIDs[k] = -1;
+                vertex.m_Weights[k] = 0.0f;
+            }
 
             vertices.push_back(vertex);
         }
+        extractBoneWeights(vertices, mesh);
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
@@ -166,7 +427,56 @@ private:
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        Mesh result(vertices, indices, textures, vertexFormat);
+        if(buildMeshlets)
+            result.BuildMeshlets();
+        return result;
+    }
+
+    // keeps the MAX_BONE_INFLUENCE strongest influences per vertex, bone IDs are skeleton joints
+    void extractBoneWeights(vector<Vertex> &vertices, aiMesh *mesh)
+    {
+        for(unsigned int b = 0; b < mesh->mNumBones; b++)
+        {
+            const aiBone* bone = mesh->mBones[b];
+            uint32_t joint = skeleton.find(bone->mName.C_Str());
+            if(joint == Skeleton::kNoJoint)
+            {
+                cout << "ERROR::ASSIMP:: bone " << bone->mName.C_Str() << " has no node" << endl;
+                continue;
+            }
+            skeleton.setInverseBind(joint, toGlm(bone->mOffsetMatrix));
+            skinned = true;
+
+            for(unsigned int w = 0; w < bone->mNumWeights; w++)
+            {
+                Vertex& vertex = vertices[bone->mWeights[w].mVertexId];
+                float weight = bone->mWeights[w].mWeight;
+
+                int slot = 0;
+                for(int k = 1; k < MAX_BONE_INFLUENCE; k++)
+                    if(vertex.m_Weights[k] < vertex.m_Weights[slot])
+                        slot = k;
+                if(weight > vertex.m_Weights[slot])
+                {
+                    vertex.m_BoneIDs[slot] = (int)joint;
+                    vertex.m_Weights[slot] = weight;
+                }
+            }
+        }
+
+        // dropped influences would otherwise shrink the vertex towards the origin
+        if(mesh->mNumBones == 0)
+            return;
+        for(Vertex& vertex : vertices)
+        {
+            float total = 0.0f;
+            for(int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                total += vertex.m_Weights[k];
+            if(total > 0.0f)
+                for(int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                    vertex.m_Weights[k] /= total;
+        }
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -204,8 +514,10 @@ private:
 };
 
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+inline unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
+    (void)gamma;
+    MemoryScope scope(MemoryTag::Texture);
     string filename = string(path);
     filename = directory + '/' + filename;
 
@@ -216,7 +528,7 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
+        GLenum format = GL_RGBA;
         if (nrComponents == 1)
             format = GL_RED;
         else if (nrComponents == 3)
@@ -227,6 +539,7 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
         glBindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        gl_track_texture(textureID, width, height, format, true);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -243,4 +556,7 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
 
     return textureID;
 }
-#endif
\ No newline at end of file
+
+} // namespace asset
+
+#endif
@@ -8,15 +8,24 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+
+#include "../core/Memory.h"
+#include "../core/ShaderDefines.h"
+
+namespace asset {
 
 class Shader
 {
 public:
     unsigned int ID;
     // constructor generates the shader on the fly
+    // defines select a permutation, e.g. {"COMPRESSED_VERTICES"} for meshes built with VertexFormat::Compressed
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+           const std::vector<std::string> &defines = {})
     {
+        MemoryScope scope(MemoryTag::Shader);
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -57,6 +66,10 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        vertexCode = shader_inject_defines(vertexCode, defines);
+        fragmentCode = shader_inject_defines(fragmentCode, defines);
+        if(geometryPath != nullptr)
+            geometryCode = shader_inject_defines(geometryCode, defines);
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
@@ -188,4 +201,7 @@ private:
         }
     }
 };
-#endif
\ No newline at end of file
+
+} // namespace asset
+
+#endif
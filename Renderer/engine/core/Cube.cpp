@@ -1,8 +1,12 @@
 #include "Cube.hpp"
 
+#include "../opengl/RenderStats.h"
+#include "FrameArena.h"
+
 Cube::Cube(CubeType type) 
     : Mesh(), m_VAO(),  m_VBOInfo(), m_Shader(), m_Texture()
 {
+    MemoryScope scope(MemoryTag::Mesh);
     // set vertex data
     if(type == CubeType::POS_ONLY) {
         _posOnlyCube();
@@ -25,23 +29,42 @@ void Cube::draw() const
 {
     m_VAO.bind();
     glDrawArrays(GL_TRIANGLES, 0, 36);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 36);
     m_VAO.unbind();
 }
 
+void Cube::draw(CommandList& list) const
+{
+    list.bindVertexArray(m_VAO.id());
+    list.drawArrays(PrimitiveType::Triangles, 0, 36);
+}
+
+void Cube::_logVertexData()
+{
+#if GL_LOG_LEVEL <= GL_LOG_LEVEL_TRACE
+    // one message per vertex instead of one per float, and flatten the vertices only once
+    const std::pmr::vector<float> vertexData = data(FrameArena::get().resource());
+    const size_t stride = perVertexCount();
+
+    GL_LOG_TRACE("Vertex data: \n");
+    for (size_t i = 0; i + stride <= vertexData.size(); i += stride)
+    {
+        char line[Logger::kMessageSize];
+        int length = 0;
+        for (size_t j = 0; j < stride && length < (int)sizeof(line); j++)
+            length += snprintf(line + length, sizeof(line) - length, "%f ", vertexData[i + j]);
+        GL_LOG_TRACE("%s\n", line);
+    }
+    GL_LOG_TRACE("\n");
+#endif
+}
+
 void Cube::_posOnlyCube()
 {
     setVertices(CUBE_VERTICES_POS_ONLY);
     m_posInfo = VertexArrayInfo{};
 
-    // log vertex data
-    GL_LOG( "Vertex data: \n");
-    for (size_t i = 0; i < vertexByteCount() / sizeof(float); i++)
-    {
-        GL_LOG("%f ", data().data()[i]);
-        if ((i + 1) % 5 == 0)
-            GL_LOG("\n");
-    }
-    GL_LOG("\n");
+    _logVertexData();
 
     m_VAO.bind();
     GL_LOG("Created VAO with ID: %d\n", m_VAO.id());
@@ -70,15 +93,7 @@ void Cube::_posTexCube()
     m_posInfo = VertexArrayInfo{};
     m_texInfo = VertexArrayInfo{};
 
-    // log vertex data
-    GL_LOG("Vertex data: \n");
-    for (size_t i = 0; i < vertexByteCount() / sizeof(float); i++)
-    {
-        GL_LOG("%f ", data().data()[i]);
-        if ((i + 1) % 5 == 0)
-            GL_LOG("\n");
-    }
-    GL_LOG("\n");
+    _logVertexData();
 
     m_VAO.bind();
     GL_LOG("Created VAO with ID: %d\n", m_VAO.id());
@@ -115,15 +130,7 @@ void Cube::_posNormCube()
     m_posInfo = VertexArrayInfo{};
     m_normInfo = VertexArrayInfo{};
 
-    // log vertex data
-    GL_LOG("Vertex data: \n");
-    for (size_t i = 0; i < vertexByteCount() / sizeof(float); i++)
-    {
-        GL_LOG("%f ", data().data()[i]);
-        if ((i + 1) % 5 == 0)
-            GL_LOG("\n");
-    }
-    GL_LOG("\n");
+    _logVertexData();
 
     m_VAO.bind();
     GL_LOG("Created VAO with ID: %d\n", m_VAO.id());
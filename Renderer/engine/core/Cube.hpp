@@ -10,6 +10,7 @@
 #include "Shader.h"
 
 #include "../opengl/OpenGLPipeline.h"
+#include "../render/CommandList.h"
 
 #include <vector>
 
@@ -180,6 +181,11 @@ public:
 
     void draw() const;
 
+    /// Same as above, recorded into `list` instead of issued; safe on any thread
+    void useShader(CommandList& list) const { list.bindPipeline(m_Shader.id()); }
+    void bindTexture(CommandList& list) const { list.bindTexture(0, m_Texture.id()); }
+    void draw(CommandList& list) const;
+
 private:
     VertexArrayInfo m_posInfo;
     VertexArrayInfo m_texInfo;
@@ -190,6 +196,7 @@ private:
     Shader m_Shader;
     Texture m_Texture;
 
+    void _logVertexData();
     void _posOnlyCube();
     void _posTexCube();
     void _posNormCube();
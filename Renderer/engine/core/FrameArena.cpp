@@ -0,0 +1,87 @@
+#include "FrameArena.h"
+
+namespace {
+
+struct ArenaSlot {
+    const FrameArena* owner = nullptr;
+    void* arena = nullptr;
+};
+
+thread_local ArenaSlot t_arena;
+
+}
+
+FrameArena& FrameArena::get() {
+    static FrameArena arena;
+    return arena;
+}
+
+FrameArena::FrameArena()
+    : m_mutex(),
+      m_threads(),
+      m_generation(0),
+      m_reserve(0),
+      m_lastFrameBytes(0),
+      m_frame(0)
+{}
+
+FrameArena::ThreadArena& FrameArena::_thread() {
+    if (t_arena.owner == this) {
+        return *static_cast<ThreadArena*>(t_arena.arena);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threads.push_back(std::make_unique<ThreadArena>());
+    for (LinearAllocator& allocator : m_threads.back()->allocators) {
+        allocator.reserve(m_reserve);
+    }
+    t_arena = { this, m_threads.back().get() };
+    return *m_threads.back();
+}
+
+void FrameArena::reserve(size_t bytesPerThread) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reserve = bytesPerThread;
+    for (const std::unique_ptr<ThreadArena>& thread : m_threads) {
+        for (LinearAllocator& allocator : thread->allocators) {
+            allocator.reserve(bytesPerThread);
+        }
+    }
+}
+
+LinearAllocator& FrameArena::local() {
+    return _thread().allocators[m_generation.load(std::memory_order_relaxed)];
+}
+
+std::pmr::memory_resource* FrameArena::resource() {
+    return &_thread().resources[m_generation.load(std::memory_order_relaxed)];
+}
+
+void FrameArena::nextFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const unsigned int closing = m_generation.load(std::memory_order_relaxed);
+    const unsigned int next = closing ^ 1;
+
+    size_t bytes = 0;
+    for (const std::unique_ptr<ThreadArena>& thread : m_threads) {
+        bytes += thread->allocators[closing].used();
+        thread->allocators[next].reset();
+    }
+    m_lastFrameBytes = bytes;
+    m_generation.store(next, std::memory_order_relaxed);
+    m_frame++;
+}
+
+size_t FrameArena::capacity() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const std::unique_ptr<ThreadArena>& thread : m_threads) {
+        bytes += thread->allocators[0].capacity() + thread->allocators[1].capacity();
+    }
+    return bytes;
+}
+
+size_t FrameArena::threadCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_threads.size();
+}
@@ -0,0 +1,111 @@
+#ifndef _FRAME_ARENA_H_
+#define _FRAME_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "LinearAllocator.h"
+
+/**
+ * @brief std::pmr view of a LinearAllocator
+ *
+ * Deallocation does nothing, the memory comes back when the allocator is reset. Lets pmr
+ * containers (std::pmr::vector, std::pmr::string) put their storage in an arena.
+ */
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(LinearAllocator& allocator) : m_allocator(&allocator) {}
+
+private:
+    LinearAllocator* m_allocator;
+
+    void* do_allocate(size_t bytes, size_t alignment) override { return m_allocator->allocate(bytes, alignment); }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+/**
+ * @brief Per-thread bump allocators for data that only lives for a frame
+ *
+ * Every thread that calls `local` (the render thread, job system workers) gets its own
+ * pair of LinearAllocators on first use, so allocating takes no lock. Memory stays valid
+ * until the second `nextFrame` after it was allocated: an update running on a worker
+ * during frame N can hand arena data to the render of frame N+1.
+ *
+ *     std::pmr::vector<DrawItem> items(FrameArena::get().resource());
+ *     items.reserve(visible);             // no heap allocation once the arena warmed up
+ *
+ * Once every allocator has seen its biggest frame the arena never touches the heap again;
+ * the bench reports allocations per frame to keep it that way.
+ */
+class FrameArena {
+public:
+    static FrameArena& get();
+
+    FrameArena();
+
+    FrameArena(const FrameArena& other) = delete;
+
+    FrameArena& operator=(const FrameArena& other) = delete;
+
+    /// The calling thread's allocator for this frame
+    LinearAllocator& local();
+
+    /// pmr resource over `local()`, for this thread and this frame only
+    std::pmr::memory_resource* resource();
+
+    template <typename T>
+    T* allocateArray(size_t count) { return local().template allocateArray<T>(count); }
+
+    /**
+     * @brief Sizes every thread's allocators, present and future, for `bytesPerThread`
+     *
+     * Which thread runs which job changes from frame to frame, so without this a thread
+     * may still grow its arena long after start-up, the first time it gets a bigger share.
+     */
+    void reserve(size_t bytesPerThread);
+
+    /**
+     * @brief Starts a frame: frees what was allocated two frames ago
+     *
+     * Render thread, while no job that allocates from the arena is running (test::runFrame
+     * calls it right after syncing the pipelined update).
+     */
+    void nextFrame();
+
+    /// Bytes allocated on all threads during the last completed frame
+    size_t lastFrameBytes() const { return m_lastFrameBytes; }
+
+    /// Bytes held in blocks on all threads
+    size_t capacity() const;
+
+    size_t threadCount() const;
+
+    uint64_t frame() const { return m_frame; }
+
+private:
+    struct ThreadArena {
+        LinearAllocator allocators[2];
+        ArenaResource resources[2];
+
+        ThreadArena() : allocators(), resources{ ArenaResource(allocators[0]), ArenaResource(allocators[1]) } {}
+    };
+
+    mutable std::mutex m_mutex;     // guards m_threads, taken once per thread and in nextFrame
+    std::vector<std::unique_ptr<ThreadArena>> m_threads;
+    std::atomic<unsigned int> m_generation;
+    size_t m_reserve;
+    size_t m_lastFrameBytes;
+    uint64_t m_frame;
+
+    ThreadArena& _thread();
+};
+
+#endif // !_FRAME_ARENA_H_
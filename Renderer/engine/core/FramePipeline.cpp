@@ -0,0 +1,33 @@
+#include "FramePipeline.h"
+
+FramePipeline::FramePipeline(JobSystem& jobs)
+    : m_jobs(jobs),
+      m_counter(),
+      m_enabled(true),
+      m_pending(false),
+      m_runNs(0),
+      m_updateNs(0),
+      m_waitNs(0)
+{}
+
+FramePipeline::~FramePipeline() {
+    sync();
+}
+
+void FramePipeline::setEnabled(bool enabled) {
+    sync();
+    m_enabled = enabled;
+}
+
+void FramePipeline::sync() {
+    if (!m_pending) {
+        m_waitNs = 0;
+        return;
+    }
+
+    const Clock::time_point start = Clock::now();
+    m_jobs.wait(m_counter);
+    m_waitNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    m_updateNs = m_runNs;
+    m_pending = false;
+}
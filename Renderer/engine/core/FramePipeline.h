@@ -0,0 +1,114 @@
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @brief Per-frame data in two slots: one filled by the update, one read by the render
+ *
+ * The update of frame N+1 writes `write()` while the render of frame N reads `read()`;
+ * `publish` swaps them once that update is done. There is no locking here, the
+ * FramePipeline schedule is what keeps the two threads on different slots.
+ */
+template <typename T>
+class FramePackets {
+public:
+    T& write() { return m_packets[m_write]; }
+
+    const T& read() const { return m_packets[m_write ^ 1]; }
+
+    /// Render thread, between frames, with no update running
+    void publish() {
+        m_write ^= 1;
+        m_published++;
+    }
+
+    /// Packets published so far, 0 until the first update finished
+    uint64_t published() const { return m_published; }
+
+private:
+    T m_packets[2];
+    unsigned int m_write = 0;
+    uint64_t m_published = 0;
+};
+
+/**
+ * @brief Runs the update of the next frame on the job system while the caller renders
+ *
+ *     pipeline.sync();                    // the update of this frame is done
+ *     packets.publish();                  // its packet is now the one to draw
+ *     pipeline.kick([&]() { update(packets.write()); });
+ *     render(packets.read());             // overlaps with the update of the next frame
+ *
+ * Between `sync` and `kick` the caller owns all of the app state again, that is the place
+ * for input and GUI changes. Disabled, `kick` runs the update right away on the calling
+ * thread, so the same loop also runs serially.
+ */
+class FramePipeline {
+public:
+    explicit FramePipeline(JobSystem& jobs);
+
+    FramePipeline(const FramePipeline& other) = delete;
+
+    FramePipeline& operator=(const FramePipeline& other) = delete;
+
+    ~FramePipeline();
+
+    /// Waits for a pending update before switching
+    void setEnabled(bool enabled);
+
+    bool enabled() const { return m_enabled; }
+
+    /// True from `kick` until the next `sync`
+    bool pending() const { return m_pending; }
+
+    /**
+     * @brief Starts the update of the next frame, the previous one must have been synced
+     *
+     * The callable must fit a Job (capture pointers), and must not issue GL calls.
+     */
+    template <typename F>
+    void kick(F&& update) {
+        m_pending = true;
+        if (!m_enabled) {
+            _runUpdate(update);
+            return;
+        }
+        m_jobs.run([this, update]() { _runUpdate(update); }, &m_counter);
+    }
+
+    /**
+     * @brief Waits for the kicked update, running other jobs meanwhile
+     */
+    void sync();
+
+    /// Duration of the last synced update, wherever it ran
+    double updateMs() const { return m_updateNs * 1e-6; }
+
+    /// Time the last `sync` blocked the caller: the part of the update that did not overlap
+    double waitMs() const { return m_waitNs * 1e-6; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    JobSystem& m_jobs;
+    JobCounter m_counter;
+    bool m_enabled;
+    bool m_pending;
+    uint64_t m_runNs;       // written by the update, only read in `sync`
+    uint64_t m_updateNs;
+    uint64_t m_waitNs;
+
+    template <typename F>
+    void _runUpdate(F& update) {
+        const Clock::time_point start = Clock::now();
+        update();
+        m_runNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+};
+
+#endif // !_FRAME_PIPELINE_H_
@@ -0,0 +1,141 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+FrameStats::FrameStats(double budgetMs)
+    : m_samples{},
+      m_scratch{},
+      m_next(0),
+      m_count(0),
+      m_budget(budgetMs),
+      m_worst(0.0),
+      m_totalFrames(0),
+      m_totalHitches(0)
+{}
+
+void FrameStats::record(double frameMs) {
+    m_samples[m_next] = (float)frameMs;
+    m_next = (m_next + 1) % kCapacity;
+    if (m_count < kCapacity) {
+        m_count++;
+    }
+
+    m_totalFrames++;
+    if (frameMs > m_budget) {
+        m_totalHitches++;
+    }
+    if (frameMs > m_worst) {
+        m_worst = frameMs;
+    }
+}
+
+void FrameStats::reset() {
+    m_next = 0;
+    m_count = 0;
+    m_worst = 0.0;
+    m_totalFrames = 0;
+    m_totalHitches = 0;
+}
+
+FrameStatsSummary FrameStats::summary() const {
+    FrameStatsSummary result{};
+    result.count = m_count;
+    if (m_count == 0) {
+        return result;
+    }
+
+    double sum = 0.0;
+    result.min = m_samples[0];
+    result.max = m_samples[0];
+    for (size_t i = 0; i < m_count; i++) {
+        float sample = m_samples[i];
+        sum += sample;
+        result.min = std::min(result.min, (double)sample);
+        result.max = std::max(result.max, (double)sample);
+        if (sample > m_budget) {
+            result.hitches++;
+        }
+        m_scratch[i] = sample;
+    }
+    result.mean = sum / m_count;
+
+    // nearest rank: the smallest sample with at least p% of the samples at or below it.
+    // Percentiles are ascending, so each nth_element only has to look at the tail.
+    size_t begin = 0;
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)std::ceil(p * m_count);
+        size_t index = rank > 0 ? rank - 1 : 0;
+        std::nth_element(m_scratch + begin, m_scratch + index, m_scratch + m_count);
+        begin = index;
+        return (double)m_scratch[index];
+    };
+    result.p50 = percentile(0.50);
+    result.p95 = percentile(0.95);
+    result.p99 = percentile(0.99);
+
+    return result;
+}
+
+void FrameStats::histogram(float (&bins)[kHistogramBins], float& binWidthMs) const {
+    std::fill(std::begin(bins), std::end(bins), 0.0f);
+
+    float max = 0.0f;
+    for (size_t i = 0; i < m_count; i++) {
+        max = std::max(max, m_samples[i]);
+    }
+
+    binWidthMs = max > 0.0f ? max / kHistogramBins : 1.0f;
+    for (size_t i = 0; i < m_count; i++) {
+        size_t bin = (size_t)(m_samples[i] / binWidthMs);
+        bins[bin < kHistogramBins ? bin : kHistogramBins - 1] += 1.0f;
+    }
+}
+
+bool FrameStats::writeCsv(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "ERROR: could not open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    fprintf(file, "frame,frame_ms,over_budget\n");
+
+    uint64_t first = m_totalFrames - m_count;
+    for (size_t i = 0; i < m_count; i++) {
+        float sample = m_samples[(offset() + i) % kCapacity];
+        fprintf(file, "%llu,%.4f,%d\n", (unsigned long long)(first + i), sample, sample > m_budget ? 1 : 0);
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool FrameStats::appendSummaryCsv(const std::string& path, const std::string& label) const {
+    FILE* existing = fopen(path.c_str(), "r");
+    bool writeHeader = existing == nullptr;
+    if (existing) {
+        fclose(existing);
+    }
+
+    FILE* file = fopen(path.c_str(), "a");
+    if (!file) {
+        fprintf(stderr, "ERROR: could not open %s for appending\n", path.c_str());
+        return false;
+    }
+
+    if (writeHeader) {
+        fprintf(file, "timestamp,label,frames,window,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,budget_ms,hitches,total_hitches\n");
+    }
+
+    FrameStatsSummary s = summary();
+    fprintf(file, "%lld,%s,%llu,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%llu,%llu\n",
+        (long long)time(NULL), label.c_str(), (unsigned long long)m_totalFrames, s.count,
+        s.mean, s.p50, s.p95, s.p99, m_worst, m_budget,
+        (unsigned long long)s.hitches, (unsigned long long)m_totalHitches);
+
+    fclose(file);
+    return true;
+}
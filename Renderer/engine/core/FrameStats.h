@@ -0,0 +1,91 @@
+#ifndef _FRAME_STATS_H_
+#define _FRAME_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct FrameStatsSummary {
+    size_t count;       // samples the percentiles were computed over
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double min;
+    double max;
+    uint64_t hitches;   // samples over budget among `count`
+};
+
+/**
+ * @brief Frame time statistics
+ *
+ * Every frame time goes into a fixed-size ring (the last `kCapacity` frames), percentiles
+ * are computed over that window on demand. Frames slower than the budget are counted as
+ * hitches, both in the window and over the whole run.
+ *
+ * Nothing here allocates after construction.
+ */
+class FrameStats {
+public:
+    static constexpr size_t kCapacity = 1024;
+    static constexpr size_t kHistogramBins = 32;
+
+    explicit FrameStats(double budgetMs = 1000.0 / 60.0);
+
+    void record(double frameMs);
+
+    void reset();
+
+    void setBudget(double budgetMs) { m_budget = budgetMs; }
+
+    double budget() const { return m_budget; }
+
+    /// Samples currently in the ring
+    size_t count() const { return m_count; }
+
+    /// Raw ring storage and the index of the oldest sample, ImGui::PlotLines takes both as is
+    const float* samples() const { return m_samples; }
+    size_t offset() const { return m_count < kCapacity ? 0 : m_next; }
+
+    /// Frames recorded since construction / reset
+    uint64_t totalFrames() const { return m_totalFrames; }
+
+    uint64_t totalHitches() const { return m_totalHitches; }
+
+    double worstFrame() const { return m_worst; }
+
+    /**
+     * @brief Percentiles, mean and hitches over the ring (nearest-rank percentiles)
+     */
+    FrameStatsSummary summary() const;
+
+    /**
+     * @brief Buckets the ring into `kHistogramBins` bins spanning [0, max]
+     *
+     * @param bins output counts
+     * @param binWidthMs width of one bin
+     */
+    void histogram(float (&bins)[kHistogramBins], float& binWidthMs) const;
+
+    /**
+     * @brief Writes the ring, oldest first, as `frame,frame_ms,over_budget`
+     */
+    bool writeCsv(const std::string& path) const;
+
+    /**
+     * @brief Appends one summary row per run, creating the file (and its header) if needed
+     */
+    bool appendSummaryCsv(const std::string& path, const std::string& label) const;
+
+private:
+    float m_samples[kCapacity];
+    mutable float m_scratch[kCapacity];
+    size_t m_next;
+    size_t m_count;
+    double m_budget;
+    double m_worst;
+    uint64_t m_totalFrames;
+    uint64_t m_totalHitches;
+};
+
+#endif // !_FRAME_STATS_H_
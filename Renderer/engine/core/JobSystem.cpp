@@ -0,0 +1,455 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace {
+
+// rounds of failed stealing before an idle worker goes to sleep
+const int kSpinRounds = 64;
+
+// per-thread job free lists spill to the shared pool past this size, so jobs allocated on
+// one thread and finished on another do not pile up on the finishing side
+const size_t kLocalJobs = 256;
+const size_t kJobBatch = 64;
+
+struct WorkerSlot {
+    const JobSystem* system = nullptr;
+    int index = -1;
+};
+
+thread_local WorkerSlot t_worker;
+
+struct SharedJobPool {
+    std::mutex mutex;
+    std::vector<Job*> jobs;
+
+    ~SharedJobPool() {
+        for (Job* job : jobs) {
+            delete job;
+        }
+    }
+};
+
+SharedJobPool& shared_jobs() {
+    static SharedJobPool pool;
+    return pool;
+}
+
+struct LocalJobPool {
+    Job* head = nullptr;
+    size_t count = 0;
+
+    ~LocalJobPool() {
+        while (head) {
+            Job* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+};
+
+thread_local LocalJobPool t_jobs;
+
+uint32_t xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+}
+
+/**
+ * Chase-Lev deque, with the memory orders of Lê, Pop, Cohen and Zappa Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ * Arrays only grow; old ones stay alive until the deque dies since a thief may still be
+ * reading from one.
+ */
+class JobSystem::Deque {
+public:
+    explicit Deque(int64_t capacity)
+        : m_top(0), m_bottom(0), m_array(nullptr)
+    {
+        m_arrays.push_back(std::make_unique<Array>(capacity));
+        m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    /// Owner only
+    void push(Job* job) {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed);
+        const int64_t t = m_top.load(std::memory_order_acquire);
+        Array* array = m_array.load(std::memory_order_relaxed);
+        if (b - t > array->capacity - 1) {
+            array = _grow(array, t, b);
+        }
+        array->put(b, job);
+        // the paper's release fence followed by a relaxed store, as one release store
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    /// Owner only
+    Job* pop() {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* array = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job* job = array->get(b);
+        if (t == b) {
+            // last one: race the thieves for it
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    /// Any thread; null when empty or when another thread won the race
+    Job* steal() {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Array* array = m_array.load(std::memory_order_acquire);
+        Job* job = array->get(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    bool empty() const {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        int64_t capacity;
+        std::unique_ptr<std::atomic<Job*>[]> slots;
+
+        explicit Array(int64_t size) : capacity(size), slots(new std::atomic<Job*>[size]) {}
+
+        Job* get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+
+        void put(int64_t i, Job* job) { slots[i & (capacity - 1)].store(job, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    std::atomic<Array*> m_array;
+    std::vector<std::unique_ptr<Array>> m_arrays;   // owner only
+
+    Array* _grow(Array* array, int64_t top, int64_t bottom) {
+        m_arrays.push_back(std::make_unique<Array>(array->capacity * 2));
+        Array* grown = m_arrays.back().get();
+        for (int64_t i = top; i < bottom; i++) {
+            grown->put(i, array->get(i));
+        }
+        m_array.store(grown, std::memory_order_release);
+        return grown;
+    }
+};
+
+JobSystem& JobSystem::get() {
+    static JobSystem system(std::max(1u, std::thread::hardware_concurrency()));
+    return system;
+}
+
+JobSystem::JobSystem(unsigned int threads)
+    : m_previousOwner(nullptr),
+      m_previousIndex(-1),
+      m_externalExecuted(0),
+      m_queued(0),
+      m_sleepers(0),
+      m_stop(false)
+{
+    threads = std::max(1u, threads);
+    for (unsigned int i = 0; i < threads; i++) {
+        m_queues.push_back(std::make_unique<ThreadState>());
+        m_queues.back()->deque = std::make_unique<Deque>(1024);
+        m_queues.back()->random = 0x9e3779b9u * (i + 1);
+    }
+
+    // the constructing thread owns deque 0; it stays a member until the system is destroyed
+    m_previousOwner = t_worker.system;
+    m_previousIndex = t_worker.index;
+    t_worker.system = this;
+    t_worker.index = 0;
+
+    // jobs freed on a worker stay in its pool until it holds kLocalJobs: with only as many
+    // jobs as a frame needs, the submitting thread would keep allocating while the pools fill
+    if (threads > 1) {
+        SharedJobPool& shared = shared_jobs();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (size_t i = 0; i < threads * kLocalJobs + kJobBatch; i++) {
+            shared.jobs.push_back(new Job);
+        }
+    }
+
+    for (unsigned int i = 1; i < threads; i++) {
+        m_workers.emplace_back(&JobSystem::_workerLoop, this, (int)i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    m_stop.store(true, std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_all();
+    }
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    // whatever was never run
+    Job* job;
+    while ((job = _find(-1)) != nullptr) {
+        job->destroy(*job);
+        delete job;
+    }
+
+    if (t_worker.system == this) {
+        t_worker.system = m_previousOwner;
+        t_worker.index = m_previousIndex;
+    }
+}
+
+Job* JobSystem::_allocate() {
+    LocalJobPool& local = t_jobs;
+    if (!local.head) {
+        SharedJobPool& shared = shared_jobs();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (size_t i = 0; i < kJobBatch && !shared.jobs.empty(); i++) {
+            Job* job = shared.jobs.back();
+            shared.jobs.pop_back();
+            job->next = local.head;
+            local.head = job;
+            local.count++;
+        }
+    }
+    if (!local.head) {
+        return new Job;
+    }
+    Job* job = local.head;
+    local.head = job->next;
+    local.count--;
+    return job;
+}
+
+void JobSystem::_release(Job* job) {
+    LocalJobPool& local = t_jobs;
+    job->next = local.head;
+    local.head = job;
+    local.count++;
+
+    if (local.count > kLocalJobs) {
+        SharedJobPool& shared = shared_jobs();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (size_t i = 0; i < kJobBatch; i++) {
+            Job* spilled = local.head;
+            local.head = spilled->next;
+            local.count--;
+            shared.jobs.push_back(spilled);
+        }
+    }
+}
+
+int JobSystem::_threadIndex() const {
+    return t_worker.system == this ? t_worker.index : -1;
+}
+
+void JobSystem::_submit(Job* job) {
+    const int index = _threadIndex();
+    if (index >= 0) {
+        m_queues[index]->deque->push(job);
+    } else {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        m_inject.push_back(job);
+    }
+    m_queued.fetch_add(1, std::memory_order_seq_cst);
+    _wakeOne();
+}
+
+void JobSystem::_submitAfter(JobCounter& dependency, Job* job) {
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (dependency.m_pending.load(std::memory_order_acquire) != 0) {
+            job->next = dependency.m_waiters;
+            dependency.m_waiters = job;
+            return;
+        }
+    }
+    _submit(job);
+}
+
+void JobSystem::_wakeOne() {
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+Job* JobSystem::_find(int index) {
+    Job* job = nullptr;
+    if (index >= 0) {
+        job = m_queues[index]->deque->pop();
+    }
+
+    if (!job) {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        if (!m_inject.empty()) {
+            job = m_inject.front();
+            m_inject.pop_front();
+        }
+    }
+
+    if (!job) {
+        thread_local uint32_t externalRandom = 0x2545f491u;
+        uint32_t& random = index >= 0 ? m_queues[index]->random : externalRandom;
+        const size_t count = m_queues.size();
+        const size_t start = xorshift(random) % count;
+        for (size_t i = 0; i < count && !job; i++) {
+            const size_t victim = (start + i) % count;
+            if ((int)victim == index) {
+                continue;
+            }
+            job = m_queues[victim]->deque->steal();
+            if (job && index >= 0) {
+                m_queues[index]->steals.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    if (job) {
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void JobSystem::_execute(Job* job, int index) {
+    job->invoke(*job);
+    job->destroy(*job);
+    JobCounter* counter = job->counter;
+    _release(job);
+
+    if (index >= 0) {
+        m_queues[index]->executed.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_externalExecuted.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (counter) {
+        _finish(*counter);
+    }
+}
+
+void JobSystem::_finish(JobCounter& counter) {
+    // m_busy keeps `done` false until this thread no longer touches the counter, which the
+    // waiter may destroy as soon as it returns
+    counter.m_busy.fetch_add(1, std::memory_order_seq_cst);
+    if (counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Job* waiters;
+        {
+            std::lock_guard<std::mutex> lock(counter.m_mutex);
+            waiters = counter.m_waiters;
+            counter.m_waiters = nullptr;
+        }
+        while (waiters) {
+            Job* next = waiters->next;
+            waiters->next = nullptr;
+            _submit(waiters);
+            waiters = next;
+        }
+    }
+    counter.m_busy.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const int index = _threadIndex();
+    while (!counter.done()) {
+        if (Job* job = _find(index)) {
+            _execute(job, index);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::_workerLoop(int index) {
+    t_worker.system = this;
+    t_worker.index = index;
+
+    int idle = 0;
+    while (!m_stop.load(std::memory_order_acquire)) {
+        if (Job* job = _find(index)) {
+            _execute(job, index);
+            idle = 0;
+            continue;
+        }
+        if (++idle < kSpinRounds) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        m_wake.wait(lock, [&]() {
+            return m_stop.load(std::memory_order_seq_cst) || m_queued.load(std::memory_order_seq_cst) > 0;
+        });
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+void JobSystem::_rangeJob(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>* fn,
+                          JobCounter* counter)
+{
+    // keep the left half, hand the right half out, until one chunk is left
+    while (end - begin > grain) {
+        const size_t chunks = (end - begin + grain - 1) / grain;
+        const size_t mid = begin + chunks / 2 * grain;
+        run([this, mid, end, grain, fn, counter]() { _rangeJob(mid, end, grain, fn, counter); }, counter);
+        end = mid;
+    }
+    (*fn)(begin, end);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    // not worth queueing anything
+    if (m_queues.size() == 1 || count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    _rangeJob(0, count, grain, &fn, &counter);
+    wait(counter);
+}
+
+uint64_t JobSystem::jobsExecuted() const {
+    uint64_t total = m_externalExecuted.load(std::memory_order_relaxed);
+    for (const auto& state : m_queues) {
+        total += state->executed.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t JobSystem::steals() const {
+    uint64_t total = 0;
+    for (const auto& state : m_queues) {
+        total += state->steals.load(std::memory_order_relaxed);
+    }
+    return total;
+}
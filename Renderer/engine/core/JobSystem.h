@@ -0,0 +1,201 @@
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobSystem;
+
+/**
+ * @brief A unit of work: a callable stored in place, no allocation per job
+ */
+struct Job {
+    static constexpr size_t kStorageSize = 64;
+
+    void (*invoke)(Job& job);
+    void (*destroy)(Job& job);
+    class JobCounter* counter;
+    Job* next;                      // free list / waiters of a counter
+    alignas(std::max_align_t) unsigned char storage[kStorageSize];
+};
+
+/**
+ * @brief Counts unfinished jobs; the way to wait for work and to order it
+ *
+ * Every job run with a counter increments it on submission and decrements it when done.
+ * `JobSystem::wait` returns once it reaches zero, `JobSystem::runAfter` holds a job back
+ * until it does.
+ */
+class JobCounter {
+public:
+    JobCounter() : m_pending(0), m_busy(0), m_waiters(nullptr) {}
+
+    JobCounter(const JobCounter& other) = delete;
+
+    JobCounter& operator=(const JobCounter& other) = delete;
+
+    /// True once every job is done and no thread is still touching the counter
+    bool done() const {
+        return m_pending.load(std::memory_order_acquire) == 0 && m_busy.load(std::memory_order_acquire) == 0;
+    }
+
+    int pending() const { return m_pending.load(std::memory_order_relaxed); }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> m_pending;
+    std::atomic<int> m_busy;        // finishers between the decrement and releasing the waiters
+    std::mutex m_mutex;             // guards m_waiters
+    Job* m_waiters;
+};
+
+/**
+ * @brief Work-stealing job scheduler
+ *
+ * Every thread of the system (the workers plus the thread that created it) owns a
+ * Chase-Lev deque: it pushes and pops its own jobs at the bottom, LIFO, while idle threads
+ * steal from the top of a random victim. Threads outside the system submit through a
+ * shared queue and, while waiting, help by running jobs themselves.
+ *
+ *     JobCounter loaded;
+ *     jobs.run([&]() { decode(textures); }, &loaded);
+ *     jobs.runAfter(loaded, [&]() { buildMipmaps(textures); }, &ready);
+ *     jobs.parallelFor(count, 256, [&](size_t begin, size_t end) { ... });
+ *     jobs.wait(ready);
+ *
+ * Idle workers spin briefly, then sleep until new work is pushed.
+ */
+class JobSystem {
+public:
+    /// Shared system with one thread per hardware thread, the first caller included
+    static JobSystem& get();
+
+    /**
+     * @brief Starts `threads - 1` workers; the constructing thread is the remaining one
+     */
+    explicit JobSystem(unsigned int threads);
+
+    JobSystem(const JobSystem& other) = delete;
+
+    JobSystem& operator=(const JobSystem& other) = delete;
+
+    ~JobSystem();
+
+    /// Threads that run jobs: the workers plus the owning thread
+    unsigned int threadCount() const { return (unsigned int)m_queues.size(); }
+
+    /**
+     * @brief Queues `fn`; it must fit Job::kStorageSize, capture a pointer to anything bigger
+     */
+    template <typename F>
+    void run(F&& fn, JobCounter* counter = nullptr) {
+        _submit(_make(std::forward<F>(fn), counter));
+    }
+
+    /**
+     * @brief Queues `fn` once `dependency` reaches zero (right away if it already has)
+     */
+    template <typename F>
+    void runAfter(JobCounter& dependency, F&& fn, JobCounter* counter = nullptr) {
+        _submitAfter(dependency, _make(std::forward<F>(fn), counter));
+    }
+
+    /**
+     * @brief Runs other jobs until `counter` is done
+     */
+    void wait(JobCounter& counter);
+
+    /**
+     * @brief Runs fn over [0, count) in chunks of at least `grain`, returns when all ran
+     *
+     * The range is split in halves on demand: a thread keeps the left half and leaves the
+     * right one for thieves, so idle threads always take the biggest piece left.
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& fn);
+
+    /// Jobs run and jobs stolen since construction, summed over all threads
+    uint64_t jobsExecuted() const;
+    uint64_t steals() const;
+
+private:
+    class Deque;
+
+    struct alignas(64) ThreadState {
+        std::unique_ptr<Deque> deque;
+        std::atomic<uint64_t> executed{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+        uint32_t random = 0;
+    };
+
+    std::vector<std::unique_ptr<ThreadState>> m_queues;    // [0] is the owning thread
+    std::vector<std::thread> m_workers;
+    const JobSystem* m_previousOwner;   // system the constructing thread belonged to before
+    int m_previousIndex;
+    std::atomic<uint64_t> m_externalExecuted;
+
+    std::mutex m_injectMutex;       // jobs from threads outside the system
+    std::deque<Job*> m_inject;
+
+    std::atomic<int64_t> m_queued;  // submitted, not yet taken
+    std::atomic<int> m_sleepers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_stop;
+
+    template <typename F>
+    static Job* _make(F&& fn, JobCounter* counter) {
+        using Fn = typename std::decay<F>::type;
+        static_assert(sizeof(Fn) <= Job::kStorageSize, "job captures too much, capture a pointer to the state instead");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "over-aligned job");
+
+        Job* job = _allocate();
+        new (job->storage) Fn(std::forward<F>(fn));
+        job->invoke = [](Job& j) { (*reinterpret_cast<Fn*>(j.storage))(); };
+        job->destroy = [](Job& j) { reinterpret_cast<Fn*>(j.storage)->~Fn(); };
+        job->counter = counter;
+        job->next = nullptr;
+        if (counter) {
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    static Job* _allocate();
+
+    static void _release(Job* job);
+
+    void _submit(Job* job);
+
+    void _submitAfter(JobCounter& dependency, Job* job);
+
+    /// Index of the calling thread in m_queues, or -1 for threads outside the system
+    int _threadIndex() const;
+
+    /// Own deque, then the shared queue, then stealing; null when nothing was found
+    Job* _find(int index);
+
+    void _execute(Job* job, int index);
+
+    void _finish(JobCounter& counter);
+
+    void _wakeOne();
+
+    void _workerLoop(int index);
+
+    void _rangeJob(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>* fn,
+                   JobCounter* counter);
+};
+
+#endif // !_JOB_SYSTEM_H_
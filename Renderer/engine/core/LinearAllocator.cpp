@@ -0,0 +1,62 @@
+#include "LinearAllocator.h"
+
+#include <algorithm>
+
+LinearAllocator::LinearAllocator(size_t blockSize)
+    : m_blocks(),
+      m_blockSize(std::max<size_t>(blockSize, 256)),
+      m_current(0),
+      m_offset(0),
+      m_used(0),
+      m_capacity(0)
+{}
+
+LinearAllocator::~LinearAllocator() {
+    for (Block& block : m_blocks) {
+        delete[] block.data;
+    }
+}
+
+void* LinearAllocator::allocate(size_t size, size_t alignment) {
+    for (;;) {
+        if (m_current < m_blocks.size()) {
+            Block& block = m_blocks[m_current];
+            const uintptr_t base = (uintptr_t)block.data;
+            const uintptr_t aligned = (base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            const size_t end = (size_t)(aligned - base) + size;
+            if (end <= block.size) {
+                m_used += end - m_offset;
+                m_offset = end;
+                return (void*)aligned;
+            }
+            // try the next block, kept from an earlier frame
+            if (m_current + 1 < m_blocks.size()) {
+                m_current++;
+                m_offset = 0;
+                continue;
+            }
+        }
+
+        // out of blocks: oversized requests get a block of their own size
+        const size_t blockSize = std::max(m_blockSize, size + alignment);
+        m_blocks.push_back({ new unsigned char[blockSize], blockSize });
+        m_capacity += blockSize;
+        m_current = m_blocks.size() - 1;
+        m_offset = 0;
+    }
+}
+
+void LinearAllocator::reserve(size_t bytes) {
+    if (m_capacity >= bytes) {
+        return;
+    }
+    const size_t blockSize = std::max(m_blockSize, bytes - m_capacity);
+    m_blocks.push_back({ new unsigned char[blockSize], blockSize });
+    m_capacity += blockSize;
+}
+
+void LinearAllocator::reset() {
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
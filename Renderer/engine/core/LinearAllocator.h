@@ -0,0 +1,65 @@
+#ifndef _LINEAR_ALLOCATOR_H_
+#define _LINEAR_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Bump allocator over a chain of blocks
+ *
+ * `allocate` moves a pointer forward in the current block and starts the next block when
+ * it is full. `reset` rewinds to the first block and keeps all of them, so once an
+ * allocator has seen its biggest frame it stops touching the heap. Nothing is destroyed,
+ * only trivially destructible data belongs here.
+ *
+ * Not thread safe: one allocator per thread (or per command list).
+ */
+class LinearAllocator {
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    explicit LinearAllocator(size_t blockSize = kDefaultBlockSize);
+
+    LinearAllocator(const LinearAllocator& other) = delete;
+
+    LinearAllocator& operator=(const LinearAllocator& other) = delete;
+
+    ~LinearAllocator();
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "the allocator never runs destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /// Forgets every allocation, keeps the blocks
+    void reset();
+
+    /// Grows the blocks to at least `bytes` up front, so frames up to that size never allocate
+    void reserve(size_t bytes);
+
+    /// Bytes handed out since the last reset, padding included
+    size_t used() const { return m_used; }
+
+    /// Bytes held in blocks
+    size_t capacity() const { return m_capacity; }
+
+private:
+    struct Block {
+        unsigned char* data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_blockSize;
+    size_t m_current;       // block allocate() bumps in
+    size_t m_offset;        // into m_blocks[m_current]
+    size_t m_used;
+    size_t m_capacity;
+};
+
+#endif // !_LINEAR_ALLOCATOR_H_
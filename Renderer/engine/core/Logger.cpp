@@ -0,0 +1,271 @@
+#include "Logger.h"
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+const char* logLevelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info:  return "INFO";
+    case LogLevel::Warn:  return "WARN";
+    case LogLevel::Error: return "ERROR";
+    case LogLevel::Off:   return "OFF";
+    default:              return "UNKNOWN";
+    }
+}
+
+Logger& Logger::get() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : m_slots(new Slot[kCapacity]),
+      m_config{ "", LogLevel::Trace, true, 100 },
+      m_file(nullptr),
+      m_enqueuePos(0),
+      m_dequeuePos(0),
+      m_running(false),
+      m_level(static_cast<int>(LogLevel::Trace)),
+      m_urgent(false),
+      m_sleeping(false),
+      m_written(0),
+      m_truncated(0),
+      m_stalls(0),
+      m_flushedPos(0)
+{
+    for (size_t i = 0; i < kCapacity; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    close();
+    delete[] m_slots;
+}
+
+bool Logger::open(const LoggerConfig& config) {
+    close();
+
+    // make sure the sink directory exists, the default path is relative to the working directory
+    std::filesystem::path sink(config.path);
+    if (sink.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(sink.parent_path(), ec);
+    }
+
+    m_file = fopen(config.path.c_str(), "w");
+    if (!m_file) {
+        fprintf(stderr, "ERROR: could not open log file %s for writing\n", config.path.c_str());
+        return false;
+    }
+
+    // the flusher is the only writer, so a large fully-buffered stream is safe here
+    setvbuf(m_file, nullptr, _IOFBF, 1 << 16);
+
+    time_t now = time(NULL);
+    char* date = ctime(&now);
+    fprintf(m_file, "GL_LOG_FILE log. local time %s\n", date);
+    fflush(m_file);
+
+    m_config = config;
+    setLevel(config.level);
+    m_written.store(0, std::memory_order_relaxed);
+    m_truncated.store(0, std::memory_order_relaxed);
+    m_stalls.store(0, std::memory_order_relaxed);
+    m_flushedPos.store(m_dequeuePos, std::memory_order_relaxed);
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&Logger::_run, this);
+
+    return true;
+}
+
+void Logger::close() {
+    if (!m_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    _wake();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_flushMutex);
+        m_flushedPos.store(m_dequeuePos, std::memory_order_release);
+    }
+    m_flushed.notify_all();
+
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool Logger::log(LogLevel level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool result = vlog(level, format, args);
+    va_end(args);
+    return result;
+}
+
+bool Logger::vlog(LogLevel level, const char* format, va_list args) {
+    if (!enabled(level)) {
+        return true;
+    }
+
+    if (!isOpen()) {
+        // nowhere to write, don't lose errors though
+        if (level >= LogLevel::Warn) {
+            vfprintf(stderr, format, args);
+        }
+        return false;
+    }
+
+    // claim a slot
+    Slot* slot = nullptr;
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &m_slots[pos & kMask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // ring is full, give the flusher a chance to catch up
+            if (!isOpen()) {
+                return false;
+            }
+            m_stalls.fetch_add(1, std::memory_order_relaxed);
+            _wake();
+            std::this_thread::yield();
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+        else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    int length = vsnprintf(slot->text, kMessageSize, format, args);
+    if (length < 0) {
+        length = 0;
+    }
+    else if (static_cast<size_t>(length) >= kMessageSize) {
+        m_truncated.fetch_add(1, std::memory_order_relaxed);
+        length = kMessageSize - 1;
+    }
+
+    slot->level = level;
+    slot->length = static_cast<uint16_t>(length);
+
+    // publish
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    if (level >= LogLevel::Warn) {
+        m_urgent.store(true, std::memory_order_relaxed);
+        _wake();
+    }
+    else if (m_sleeping.load(std::memory_order_relaxed)) {
+        _wake();
+    }
+
+    return true;
+}
+
+void Logger::flush() {
+    if (!isOpen()) {
+        return;
+    }
+
+    size_t target = m_enqueuePos.load(std::memory_order_acquire);
+
+    m_urgent.store(true, std::memory_order_relaxed);
+    _wake();
+
+    std::unique_lock<std::mutex> lock(m_flushMutex);
+    m_flushed.wait(lock, [&]() {
+        return m_flushedPos.load(std::memory_order_acquire) >= target || !isOpen();
+    });
+}
+
+void Logger::_wake() {
+    m_wake.notify_one();
+}
+
+bool Logger::_ready() const {
+    const Slot& slot = m_slots[m_dequeuePos & kMask];
+    return slot.sequence.load(std::memory_order_acquire) == m_dequeuePos + 1;
+}
+
+size_t Logger::_drain() {
+    size_t count = 0;
+
+    for (;;) {
+        Slot& slot = m_slots[m_dequeuePos & kMask];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq != m_dequeuePos + 1) {
+            break;
+        }
+
+        fwrite(slot.text, 1, slot.length, m_file);
+        if (m_config.echoErrors && slot.level >= LogLevel::Warn) {
+            fwrite(slot.text, 1, slot.length, stderr);
+        }
+
+        // hand the slot back to producers one lap ahead
+        slot.sequence.store(m_dequeuePos + kCapacity, std::memory_order_release);
+        ++m_dequeuePos;
+        ++count;
+    }
+
+    if (count) {
+        m_written.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    return count;
+}
+
+void Logger::_run() {
+    using clock = std::chrono::steady_clock;
+
+    const auto interval = std::chrono::milliseconds(m_config.flushIntervalMs);
+    auto lastFlush = clock::now();
+
+    for (;;) {
+        size_t count = _drain();
+        bool running = m_running.load(std::memory_order_acquire);
+        bool urgent = m_urgent.exchange(false, std::memory_order_relaxed);
+
+        if (count == 0 || urgent || clock::now() - lastFlush >= interval) {
+            fflush(m_file);
+            lastFlush = clock::now();
+            {
+                std::lock_guard<std::mutex> lock(m_flushMutex);
+                m_flushedPos.store(m_dequeuePos, std::memory_order_release);
+            }
+            m_flushed.notify_all();
+        }
+
+        if (count == 0) {
+            if (!running) {
+                break;
+            }
+
+            // producers only pay for a notify while the flusher is actually asleep
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_sleeping.store(true, std::memory_order_relaxed);
+            m_wake.wait_for(lock, interval, [&]() {
+                return _ready() || m_urgent.load(std::memory_order_relaxed) || !m_running.load(std::memory_order_acquire);
+            });
+            m_sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#ifndef _LOGGER_H_
+#define _LOGGER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define LOGGER_PRINTF_FORMAT(fmt, args)
+#endif
+
+enum class LogLevel : int
+{
+    Trace = 0,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+const char* logLevelName(LogLevel level);
+
+struct LoggerConfig {
+    std::string path;
+    LogLevel level;
+    bool echoErrors;                 // copy Warn and Error messages to stderr
+    unsigned int flushIntervalMs;    // upper bound on how long a message sits in the file buffer
+};
+
+/**
+ * @brief Buffered, asynchronous logger
+ *
+ * Producers format their message into a slot of a fixed-size ring buffer and return
+ * immediately. A single background thread drains the ring into the sink file, so the
+ * calling thread never touches the file system.
+ *
+ * The ring is a bounded multi-producer/single-consumer queue: every slot carries a
+ * sequence number that tells producers whether the slot is free and tells the consumer
+ * whether it has been published. Claiming a slot is a single CAS on the enqueue position,
+ * no lock is taken on the hot path.
+ *
+ * If the ring is full, producers yield until the flusher frees a slot; messages are never
+ * dropped. Messages longer than `kMessageSize` are truncated.
+ *
+ * @note Messages are written verbatim, callers are responsible for their own newlines.
+ */
+class Logger {
+public:
+    static constexpr size_t kMessageSize = 256;
+    static constexpr size_t kCapacity = 4096; // must be a power of two
+
+    static Logger& get();
+
+    Logger();
+
+    Logger(const Logger& other) = delete;
+
+    Logger(Logger&& other) = delete;
+
+    ~Logger();
+
+    Logger& operator=(const Logger& other) = delete;
+
+    Logger& operator=(Logger&& other) = delete;
+
+    /**
+     * @brief Truncates the sink file, writes the log header and starts the flusher thread
+     *
+     * Calling `open` on a running logger drains it and switches to the new sink.
+     *
+     * @return false if the sink could not be opened
+     */
+    bool open(const LoggerConfig& config);
+
+    /**
+     * @brief Drains every pending message, stops the flusher thread and closes the sink
+     */
+    void close();
+
+    bool isOpen() const { return m_running.load(std::memory_order_acquire); }
+
+    void setLevel(LogLevel level) { m_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+    LogLevel level() const { return static_cast<LogLevel>(m_level.load(std::memory_order_relaxed)); }
+
+    bool enabled(LogLevel level) const { return static_cast<int>(level) >= m_level.load(std::memory_order_relaxed); }
+
+    const std::string& path() const { return m_config.path; }
+
+    bool log(LogLevel level, const char* format, ...) LOGGER_PRINTF_FORMAT(3, 4);
+
+    bool vlog(LogLevel level, const char* format, va_list args);
+
+    /**
+     * @brief Blocks until every message enqueued before the call is written to the sink
+     */
+    void flush();
+
+    /// Number of messages written to the sink since `open`
+    uint64_t written() const { return m_written.load(std::memory_order_relaxed); }
+
+    /// Number of messages that did not fit in `kMessageSize` and were cut
+    uint64_t truncated() const { return m_truncated.load(std::memory_order_relaxed); }
+
+    /// Number of times a producer found the ring full and had to wait for the flusher
+    uint64_t stalls() const { return m_stalls.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        uint16_t length;
+        char text[kMessageSize];
+    };
+
+    static constexpr size_t kMask = kCapacity - 1;
+    static_assert((kCapacity & kMask) == 0, "Logger capacity must be a power of two");
+
+    Slot* m_slots;
+    LoggerConfig m_config;
+    FILE* m_file;
+
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) size_t m_dequeuePos;
+
+    std::atomic<bool> m_running;
+    std::atomic<int> m_level;
+    std::atomic<bool> m_urgent;
+    std::atomic<bool> m_sleeping;
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_truncated;
+    std::atomic<uint64_t> m_stalls;
+    std::atomic<size_t> m_flushedPos;
+
+    std::thread m_thread;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::mutex m_flushMutex;
+    std::condition_variable m_flushed;
+
+    void _run();
+    bool _ready() const;
+    size_t _drain();
+    void _wake();
+};
+
+#endif // !_LOGGER_H_
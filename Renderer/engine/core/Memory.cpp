@@ -0,0 +1,420 @@
+#include "Memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+namespace {
+    const size_t kTags = MemorySnapshot::kTags;
+
+    // one cache line each, allocating threads should not bounce a shared line
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> value{ 0 };
+    };
+
+    struct alignas(64) TagCounters {
+        std::atomic<uint64_t> live{ 0 };
+        std::atomic<uint64_t> peak{ 0 };
+        std::atomic<uint64_t> allocations{ 0 };
+        std::atomic<uint64_t> frees{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+    };
+
+    Counter s_allocations;
+    Counter s_frees;
+    Counter s_bytes;
+    Counter s_live;
+    Counter s_peak;
+    TagCounters s_tags[kTags];
+
+    thread_local MemoryTag t_tag = MemoryTag::Untagged;
+
+    // in front of every block; 16 bytes keep the alignment malloc gives
+    struct alignas(16) BlockHeader {
+        uint64_t size;
+        uint32_t offset;    // from the start of the malloc block to the user pointer
+        MemoryTag tag;
+    };
+    static_assert(sizeof(BlockHeader) == 16, "BlockHeader must stay 16 bytes");
+
+    void raise_peak(std::atomic<uint64_t>& peak, uint64_t live) {
+        uint64_t current = peak.load(std::memory_order_relaxed);
+        while (live > current && !peak.compare_exchange_weak(current, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    void* counted_alloc(std::size_t size, std::size_t alignment, MemoryTag tag) {
+        const std::size_t offset = alignment > sizeof(BlockHeader) ? alignment : sizeof(BlockHeader);
+        void* block = nullptr;
+        if (alignment > alignof(std::max_align_t)) {
+            if (posix_memalign(&block, alignment, offset + size) != 0) {
+                return nullptr;
+            }
+        }
+        else if (!(block = std::malloc(offset + size))) {
+            return nullptr;
+        }
+
+        char* ptr = static_cast<char*>(block) + offset;
+        BlockHeader* header = reinterpret_cast<BlockHeader*>(ptr) - 1;
+        header->size = size;
+        header->offset = (uint32_t)offset;
+        header->tag = tag;
+
+        TagCounters& counters = s_tags[(size_t)tag];
+        s_allocations.value.fetch_add(1, std::memory_order_relaxed);
+        s_bytes.value.fetch_add(size, std::memory_order_relaxed);
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add(size, std::memory_order_relaxed);
+        raise_peak(counters.peak, counters.live.fetch_add(size, std::memory_order_relaxed) + size);
+        raise_peak(s_peak.value, s_live.value.fetch_add(size, std::memory_order_relaxed) + size);
+        return ptr;
+    }
+
+    void counted_free(void* ptr) {
+        if (ptr) {
+            const BlockHeader* header = static_cast<const BlockHeader*>(ptr) - 1;
+            const uint64_t size = header->size;
+            TagCounters& counters = s_tags[(size_t)header->tag];
+            s_frees.value.fetch_add(1, std::memory_order_relaxed);
+            s_live.value.fetch_sub(size, std::memory_order_relaxed);
+            counters.frees.fetch_add(1, std::memory_order_relaxed);
+            counters.live.fetch_sub(size, std::memory_order_relaxed);
+            std::free(static_cast<char*>(ptr) - header->offset);
+        }
+    }
+
+    void* throwing_alloc(std::size_t size, std::size_t alignment) {
+        void* ptr = counted_alloc(size, alignment, t_tag);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    struct GpuObject {
+        uint64_t bytes;
+        MemoryTag tag;
+        uint8_t format;
+    };
+
+    struct GpuRegistry {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, GpuObject> objects;    // kind << 32 | id
+        MemoryTagStats tags[kTags + 1] = {};
+        GpuFormatStats formats[MemorySnapshot::kMaxFormats] = {};
+        size_t formatCount = 0;
+    };
+
+    // never destroyed: Buffers and Textures owned by statics untrack during exit
+    GpuRegistry& gpu_registry() {
+        static GpuRegistry* registry = new GpuRegistry();
+        return *registry;
+    }
+
+    uint8_t gpu_format_index(GpuRegistry& registry, const char* format) {
+        for (size_t i = 0; i < registry.formatCount; i++) {
+            if (registry.formats[i].format == format || !strcmp(registry.formats[i].format, format)) {
+                return (uint8_t)i;
+            }
+        }
+        // the last slot collects whatever does not fit
+        if (registry.formatCount == MemorySnapshot::kMaxFormats - 1) {
+            registry.formats[registry.formatCount++].format = "other";
+        }
+        if (registry.formatCount == MemorySnapshot::kMaxFormats) {
+            return (uint8_t)(MemorySnapshot::kMaxFormats - 1);
+        }
+        registry.formats[registry.formatCount].format = format;
+        return (uint8_t)registry.formatCount++;
+    }
+
+    void gpu_release(GpuRegistry& registry, const GpuObject& object) {
+        for (MemoryTagStats* stats : { &registry.tags[(size_t)object.tag], &registry.tags[kTags] }) {
+            stats->liveBytes -= object.bytes;
+            stats->frees++;
+        }
+        GpuFormatStats& format = registry.formats[object.format];
+        format.liveBytes -= object.bytes;
+        format.resources--;
+    }
+
+    std::mutex s_budgetMutex;
+    MemoryBudget s_budgets[2][kTags + 1] = {};
+
+    const char* const s_tagNames[kTags + 1] = { "Untagged", "Mesh", "Texture", "Shader", "Model", "GUI", "total" };
+}
+
+const char* memory_tag_name(MemoryTag tag) {
+    return (size_t)tag <= kTags ? s_tagNames[(size_t)tag] : "invalid";
+}
+
+bool memory_tag_from_name(const char* name, MemoryTag& tag) {
+    for (size_t i = 0; i <= kTags; i++) {
+        if (!strcmp(name, s_tagNames[i])) {
+            tag = (MemoryTag)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+AllocationCounters Memory::counters() {
+    return {
+        s_allocations.value.load(std::memory_order_relaxed),
+        s_frees.value.load(std::memory_order_relaxed),
+        s_bytes.value.load(std::memory_order_relaxed)
+    };
+}
+
+MemoryTag Memory::currentTag() {
+    return t_tag;
+}
+
+void Memory::setCurrentTag(MemoryTag tag) {
+    t_tag = tag;
+}
+
+void* Memory::allocate(size_t bytes, MemoryTag tag) {
+    return counted_alloc(bytes, alignof(std::max_align_t), tag);
+}
+
+void Memory::deallocate(void* ptr) {
+    counted_free(ptr);
+}
+
+MemorySnapshot Memory::snapshot() {
+    MemorySnapshot snapshot{};
+    for (size_t i = 0; i < kTags; i++) {
+        const TagCounters& counters = s_tags[i];
+        snapshot.cpu[i] = {
+            counters.live.load(std::memory_order_relaxed),
+            counters.peak.load(std::memory_order_relaxed),
+            counters.allocations.load(std::memory_order_relaxed),
+            counters.frees.load(std::memory_order_relaxed),
+            counters.bytes.load(std::memory_order_relaxed)
+        };
+    }
+    snapshot.cpu[kTags] = {
+        s_live.value.load(std::memory_order_relaxed),
+        s_peak.value.load(std::memory_order_relaxed),
+        s_allocations.value.load(std::memory_order_relaxed),
+        s_frees.value.load(std::memory_order_relaxed),
+        s_bytes.value.load(std::memory_order_relaxed)
+    };
+
+    GpuRegistry& registry = gpu_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::copy(registry.tags, registry.tags + kTags + 1, snapshot.gpu);
+    std::copy(registry.formats, registry.formats + registry.formatCount, snapshot.formats);
+    snapshot.formatCount = registry.formatCount;
+    return snapshot;
+}
+
+void Memory::resetPeaks() {
+    for (TagCounters& counters : s_tags) {
+        counters.peak.store(counters.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    s_peak.value.store(s_live.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    GpuRegistry& registry = gpu_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (MemoryTagStats& stats : registry.tags) {
+        stats.peakBytes = stats.liveBytes;
+    }
+    for (size_t i = 0; i < registry.formatCount; i++) {
+        registry.formats[i].peakBytes = registry.formats[i].liveBytes;
+    }
+}
+
+void Memory::trackGpu(GpuResource kind, uint32_t id, uint64_t bytes, const char* format, MemoryTag tag) {
+    if (id == 0) {
+        return;
+    }
+    GpuRegistry& registry = gpu_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto inserted = registry.objects.try_emplace((uint64_t)kind << 32 | id);
+    GpuObject& object = inserted.first->second;
+    if (!inserted.second) {
+        gpu_release(registry, object);
+    }
+    object = { bytes, tag, gpu_format_index(registry, format) };
+
+    for (MemoryTagStats* stats : { &registry.tags[(size_t)tag], &registry.tags[kTags] }) {
+        stats->liveBytes += bytes;
+        stats->peakBytes = std::max(stats->peakBytes, stats->liveBytes);
+        stats->allocations++;
+        stats->allocatedBytes += bytes;
+    }
+    GpuFormatStats& stats = registry.formats[object.format];
+    stats.liveBytes += bytes;
+    stats.peakBytes = std::max(stats.peakBytes, stats.liveBytes);
+    stats.resources++;
+}
+
+void Memory::untrackGpu(GpuResource kind, uint32_t id) {
+    GpuRegistry& registry = gpu_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto it = registry.objects.find((uint64_t)kind << 32 | id);
+    if (it == registry.objects.end()) {
+        return;
+    }
+    gpu_release(registry, it->second);
+    registry.objects.erase(it);
+}
+
+void Memory::setBudget(const MemoryBudget& budget) {
+    std::lock_guard<std::mutex> lock(s_budgetMutex);
+    s_budgets[(size_t)budget.domain][(size_t)budget.tag] = budget;
+}
+
+bool Memory::budget(MemoryDomain domain, MemoryTag tag, MemoryBudget& budget) {
+    std::lock_guard<std::mutex> lock(s_budgetMutex);
+    budget = s_budgets[(size_t)domain][(size_t)tag];
+    return budget.bytes > 0;
+}
+
+size_t Memory::checkBudgets(const MemorySnapshot& snapshot, BudgetViolation* out, size_t capacity) {
+    std::lock_guard<std::mutex> lock(s_budgetMutex);
+    size_t count = 0;
+    for (const MemoryDomain domain : { MemoryDomain::Cpu, MemoryDomain::Gpu }) {
+        for (size_t tag = 0; tag <= kTags; tag++) {
+            const MemoryBudget& budget = s_budgets[(size_t)domain][tag];
+            const uint64_t peak = snapshot.stats(domain, (MemoryTag)tag).peakBytes;
+            if (budget.bytes > 0 && peak > budget.bytes && count < capacity) {
+                out[count++] = { budget, peak };
+            }
+        }
+    }
+    return count;
+}
+
+bool Memory::parseBudget(const char* spec, BudgetAction action, MemoryBudget& budget) {
+    const char* dot = strchr(spec, '.');
+    const char* equals = strchr(spec, '=');
+    if (!dot || !equals || equals < dot) {
+        return false;
+    }
+
+    if (dot - spec == 3 && !strncmp(spec, "cpu", 3)) {
+        budget.domain = MemoryDomain::Cpu;
+    }
+    else if (dot - spec == 3 && !strncmp(spec, "gpu", 3)) {
+        budget.domain = MemoryDomain::Gpu;
+    }
+    else {
+        return false;
+    }
+
+    char name[32];
+    const size_t length = (size_t)(equals - dot - 1);
+    if (length >= sizeof(name)) {
+        return false;
+    }
+    memcpy(name, dot + 1, length);
+    name[length] = '\0';
+    if (!memory_tag_from_name(name, budget.tag)) {
+        return false;
+    }
+
+    char* end = nullptr;
+    const double mib = strtod(equals + 1, &end);
+    if (end == equals + 1 || *end != '\0' || mib <= 0.0) {
+        return false;
+    }
+    budget.bytes = (uint64_t)(mib * 1024.0 * 1024.0);
+    budget.action = action;
+    return true;
+}
+
+void Memory::writeJson(FILE* file, const MemorySnapshot& snapshot, const MemorySnapshot& start, uint64_t frames,
+                       const char* indent)
+{
+    fprintf(file, "{\n%s  \"frames\": %llu,\n", indent, (unsigned long long)frames);
+
+    for (const MemoryDomain domain : { MemoryDomain::Cpu, MemoryDomain::Gpu }) {
+        fprintf(file, "%s  \"%s\": {\n", indent, domain == MemoryDomain::Cpu ? "cpu" : "gpu");
+        for (size_t tag = 0; tag <= kTags; tag++) {
+            const MemoryTagStats& now = snapshot.stats(domain, (MemoryTag)tag);
+            const MemoryTagStats& before = start.stats(domain, (MemoryTag)tag);
+            fprintf(file, "%s    \"%s\": { \"live\": %llu, \"peak\": %llu, \"allocations\": %llu, \"frees\": %llu, \"allocated_bytes\": %llu }%s\n",
+                indent, s_tagNames[tag], (unsigned long long)now.liveBytes, (unsigned long long)now.peakBytes,
+                (unsigned long long)(now.allocations - before.allocations), (unsigned long long)(now.frees - before.frees),
+                (unsigned long long)(now.allocatedBytes - before.allocatedBytes), tag < kTags ? "," : "");
+        }
+        fprintf(file, "%s  },\n", indent);
+    }
+
+    fprintf(file, "%s  \"gpu_formats\": [", indent);
+    for (size_t i = 0; i < snapshot.formatCount; i++) {
+        const GpuFormatStats& format = snapshot.formats[i];
+        fprintf(file, "%s\n%s    { \"format\": \"%s\", \"resources\": %u, \"live\": %llu, \"peak\": %llu }", i > 0 ? "," : "",
+            indent, format.format, format.resources, (unsigned long long)format.liveBytes, (unsigned long long)format.peakBytes);
+    }
+    if (snapshot.formatCount > 0) {
+        fprintf(file, "\n%s  ", indent);
+    }
+    fprintf(file, "],\n");
+
+    fprintf(file, "%s  \"budgets\": [", indent);
+    bool first = true;
+    for (const MemoryDomain domain : { MemoryDomain::Cpu, MemoryDomain::Gpu }) {
+        for (size_t tag = 0; tag <= kTags; tag++) {
+            MemoryBudget limit;
+            if (!budget(domain, (MemoryTag)tag, limit)) {
+                continue;
+            }
+            const uint64_t peak = snapshot.stats(domain, (MemoryTag)tag).peakBytes;
+            fprintf(file, "%s\n%s    { \"budget\": \"%s.%s\", \"bytes\": %llu, \"action\": \"%s\", \"peak\": %llu, \"exceeded\": %s }",
+                first ? "" : ",", indent, domain == MemoryDomain::Cpu ? "cpu" : "gpu", s_tagNames[tag],
+                (unsigned long long)limit.bytes, limit.action == BudgetAction::Fail ? "fail" : "warn",
+                (unsigned long long)peak, peak > limit.bytes ? "true" : "false");
+            first = false;
+        }
+    }
+    if (!first) {
+        fprintf(file, "\n%s  ", indent);
+    }
+    fprintf(file, "]\n%s}", indent);
+}
+
+bool Memory::writeReport(const char* path, uint64_t frames) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    const MemorySnapshot start{};
+    writeJson(file, snapshot(), start, frames, "");
+    fprintf(file, "\n");
+    fclose(file);
+    return true;
+}
+
+void* operator new(std::size_t size) { return throwing_alloc(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return throwing_alloc(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, alignof(std::max_align_t), t_tag); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, alignof(std::max_align_t), t_tag); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return throwing_alloc(size, (std::size_t)alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return throwing_alloc(size, (std::size_t)alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return counted_alloc(size, (std::size_t)alignment, t_tag); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return counted_alloc(size, (std::size_t)alignment, t_tag); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_free(ptr); }
@@ -0,0 +1,196 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+struct AllocationCounters {
+    uint64_t allocations;   // calls to operator new (all forms)
+    uint64_t frees;         // calls to operator delete with a non-null pointer
+    uint64_t bytes;         // bytes requested from operator new
+};
+
+/// Subsystem an allocation is charged to, see MemoryScope
+enum class MemoryTag : uint8_t {
+    Untagged,
+    Mesh,
+    Texture,
+    Shader,
+    Model,
+    GUI,
+    Count       // as an index or a budget tag: all tags together
+};
+
+enum class MemoryDomain : uint8_t {
+    Cpu,        // operator new/delete and ImGui
+    Gpu         // buffers and textures registered with Memory::trackGpu
+};
+
+enum class GpuResource : uint8_t {
+    Buffer,
+    Texture
+};
+
+enum class BudgetAction : uint8_t {
+    Warn,
+    Fail
+};
+
+const char* memory_tag_name(MemoryTag tag);
+
+/// Accepts the names of memory_tag_name and "total" for MemoryTag::Count
+bool memory_tag_from_name(const char* name, MemoryTag& tag);
+
+struct MemoryTagStats {
+    uint64_t liveBytes;
+    uint64_t peakBytes;         // highest liveBytes since start-up or the last resetPeaks
+    uint64_t allocations;       // monotonic, the churn is the difference of two snapshots
+    uint64_t frees;
+    uint64_t allocatedBytes;    // monotonic
+};
+
+struct GpuFormatStats {
+    const char* format;         // "GL_RGBA", "GL_ARRAY_BUFFER", ...
+    uint32_t resources;
+    uint64_t liveBytes;
+    uint64_t peakBytes;
+};
+
+/**
+ * @brief Every counter at one point in time, fixed size so taking one never allocates
+ *
+ * `cpu` and `gpu` are indexed by MemoryTag, `[MemoryTag::Count]` holds the sum of all tags
+ * (its peak is the peak of the sum, not the sum of the peaks).
+ */
+struct MemorySnapshot {
+    static const size_t kTags = (size_t)MemoryTag::Count;
+    static const size_t kMaxFormats = 16;
+
+    MemoryTagStats cpu[kTags + 1];
+    MemoryTagStats gpu[kTags + 1];
+    GpuFormatStats formats[kMaxFormats];
+    size_t formatCount;
+
+    const MemoryTagStats& stats(MemoryDomain domain, MemoryTag tag) const {
+        return domain == MemoryDomain::Cpu ? cpu[(size_t)tag] : gpu[(size_t)tag];
+    }
+};
+
+/// Upper bound on the peak bytes of one tag, or of all of them with MemoryTag::Count
+struct MemoryBudget {
+    MemoryDomain domain;
+    MemoryTag tag;
+    uint64_t bytes;
+    BudgetAction action;
+};
+
+struct BudgetViolation {
+    MemoryBudget budget;
+    uint64_t peakBytes;
+};
+
+/**
+ * @brief Process-wide heap and GPU memory accounting
+ *
+ * The engine replaces the global operator new/delete (Memory.cpp) with versions that
+ * count every call before forwarding to malloc/free, so anything linked against the
+ * engine - containers, std::string, third party code - shows up here. Each block carries
+ * a 16 byte header with its size and the MemoryTag that was current on the allocating
+ * thread, so a delete on any thread returns the bytes to the right tag.
+ *
+ * GPU memory can't be hooked that way; Buffer, Texture::load and asset::TextureFromFile
+ * report what they create and delete through `trackGpu` / `untrackGpu` (see
+ * gl_track_buffer and gl_track_texture in opengl/utils.h).
+ *
+ * `counters` and the MemoryTagStats allocation counts are monotonic; take a snapshot
+ * before and after the code of interest and subtract.
+ */
+class Memory {
+public:
+    static AllocationCounters counters();
+
+    /// Counters accumulated between two snapshots
+    static AllocationCounters delta(const AllocationCounters& before, const AllocationCounters& after) {
+        return { after.allocations - before.allocations, after.frees - before.frees, after.bytes - before.bytes };
+    }
+
+    /// Tag charged by allocations on the calling thread, set with MemoryScope
+    static MemoryTag currentTag();
+
+    static void setCurrentTag(MemoryTag tag);
+
+    /// Tagged allocation for code that takes an allocator callback (ImGui)
+    static void* allocate(size_t bytes, MemoryTag tag);
+
+    static void deallocate(void* ptr);
+
+    static MemorySnapshot snapshot();
+
+    /// Starts a new peak window: every peak becomes the current live size
+    static void resetPeaks();
+
+    /**
+     * @brief Records a GPU allocation; calling it again for the same object replaces the size
+     *
+     * @param format static string, the object is charged to that format and to `tag`
+     */
+    static void trackGpu(GpuResource kind, uint32_t id, uint64_t bytes, const char* format, MemoryTag tag);
+
+    /// Forgets an object passed to trackGpu, unknown ids are ignored
+    static void untrackGpu(GpuResource kind, uint32_t id);
+
+    /// Sets or replaces the budget of `budget.domain` and `budget.tag`; 0 bytes removes it
+    static void setBudget(const MemoryBudget& budget);
+
+    /// False if there is no budget for that domain and tag
+    static bool budget(MemoryDomain domain, MemoryTag tag, MemoryBudget& budget);
+
+    /**
+     * @brief Budgets whose peak in `snapshot` went over
+     *
+     * @return number of violations written to `out`, at most `capacity`
+     */
+    static size_t checkBudgets(const MemorySnapshot& snapshot, BudgetViolation* out, size_t capacity);
+
+    /**
+     * @brief Parses "cpu.Mesh=64" or "gpu.total=512", sizes in MiB
+     */
+    static bool parseBudget(const char* spec, BudgetAction action, MemoryBudget& budget);
+
+    /**
+     * @brief Writes a snapshot as a JSON object: live, peak and the allocations made since `start`
+     *
+     * Nested lines are prefixed with `indent`, the closing brace has no newline so the
+     * object can be embedded in another document.
+     */
+    static void writeJson(FILE* file, const MemorySnapshot& snapshot, const MemorySnapshot& start, uint64_t frames,
+                          const char* indent);
+
+    /// writeJson of the current state into its own file
+    static bool writeReport(const char* path, uint64_t frames);
+};
+
+/**
+ * @brief Charges the calling thread's allocations to `tag` until the scope ends
+ *
+ *     MemoryScope scope(MemoryTag::Texture);
+ *     std::vector<unsigned char> pixels(size);    // counted as Texture
+ *
+ * Scopes nest, the innermost one wins.
+ */
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryTag tag) : m_previous(Memory::currentTag()) { Memory::setCurrentTag(tag); }
+
+    ~MemoryScope() { Memory::setCurrentTag(m_previous); }
+
+    MemoryScope(const MemoryScope& other) = delete;
+
+    MemoryScope& operator=(const MemoryScope& other) = delete;
+
+private:
+    MemoryTag m_previous;
+};
+
+#endif // !_MEMORY_H_
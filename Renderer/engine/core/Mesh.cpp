@@ -110,6 +110,7 @@ unsigned long Mesh::indexByteCount() const {
 
 std::vector<Mesh::vertex_type::value_type> Mesh::data() {
     std::vector<float> vertices;
+    vertices.reserve(m_vertices.empty() ? 0 : size());
     for (size_t i = 0; i < vertexCount(); i++)
     {
         for (size_t j = 0; j < perVertexCount(); j++)
@@ -119,4 +120,15 @@ std::vector<Mesh::vertex_type::value_type> Mesh::data() {
     }
 
     return vertices;
-}
\ No newline at end of file
+}
+
+std::pmr::vector<Mesh::vertex_type::value_type> Mesh::data(std::pmr::memory_resource* resource) const {
+    std::pmr::vector<float> vertices(resource);
+    vertices.reserve(m_vertices.empty() ? 0 : size());
+    for (const Vertf& vertex : m_vertices)
+    {
+        vertices.insert(vertices.end(), vertex.data(), vertex.data() + vertex.size());
+    }
+
+    return vertices;
+}
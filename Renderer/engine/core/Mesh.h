@@ -11,6 +11,7 @@
 #include <array>
 #include <initializer_list>
 #include <memory>
+#include <memory_resource>
 
 #include "../opengl/utils.h"
 #include "Shader.h"
@@ -98,6 +99,9 @@ public:
 
     std::vector<vertex_type::value_type> data();
 
+    /// The same interleaved floats in memory from `resource`, e.g. FrameArena::get().resource()
+    std::pmr::vector<vertex_type::value_type> data(std::pmr::memory_resource* resource) const;
+
 private:
     std::vector<Vertf> m_vertices;
     std::vector<unsigned int> m_indices;
@@ -0,0 +1,219 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+static constexpr uint64_t kInvalidFrame = std::numeric_limits<uint64_t>::max();
+
+static uint64_t clock_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// nesting depth and thread slot of the calling thread
+static thread_local uint16_t t_depth = 0;
+static thread_local int t_threadIndex = -1;
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler()
+    : m_frameIndex(0),
+      m_completed(0),
+      m_inFrame(false),
+      m_enabled(true),
+      m_epoch(clock_ns()),
+      m_threadNames{},
+      m_threadCount(0)
+{
+    for (auto& frame : m_frames) {
+        frame.index = kInvalidFrame;
+        frame.start = frame.end = 0;
+        frame.gpuTime = 0;
+        frame.gpuResolved = false;
+        frame.cpuScopes.reserve(64);
+        frame.gpuScopes.reserve(32);
+    }
+}
+
+uint64_t Profiler::now() const {
+    return clock_ns() - m_epoch;
+}
+
+uint16_t Profiler::_threadIndex() {
+    if (t_threadIndex < 0) {
+        uint32_t index = m_threadCount.fetch_add(1, std::memory_order_relaxed);
+        t_threadIndex = index < kMaxThreads ? (int)index : (int)kMaxThreads - 1;
+    }
+    return (uint16_t)t_threadIndex;
+}
+
+void Profiler::setThreadName(const char* name) {
+    uint16_t index = _threadIndex();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadNames[index] = name;
+}
+
+void Profiler::beginFrame() {
+    if (!enabled()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ProfileFrame& frame = m_frames[m_frameIndex % kFrameHistory];
+    frame.index = m_frameIndex;
+    frame.start = now();
+    frame.end = frame.start;
+    frame.gpuTime = 0;
+    frame.gpuResolved = false;
+    frame.cpuScopes.clear();
+    frame.gpuScopes.clear();
+
+    m_inFrame = true;
+}
+
+void Profiler::endFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_inFrame) {
+        return;
+    }
+
+    ProfileFrame& frame = m_frames[m_frameIndex % kFrameHistory];
+    frame.end = now();
+
+    // close scopes that were left open so the frame stays consistent
+    for (auto& scope : frame.cpuScopes) {
+        if (scope.end < scope.start) {
+            scope.end = frame.end;
+        }
+    }
+
+    m_inFrame = false;
+    m_completed++;
+    m_frameIndex++;
+}
+
+Profiler::ScopeHandle Profiler::beginScope(const char* name) {
+    if (!enabled()) {
+        return { kInvalidFrame, 0 };
+    }
+
+    uint16_t thread = _threadIndex();
+    uint64_t start = now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_inFrame) {
+        return { kInvalidFrame, 0 };
+    }
+
+    ProfileFrame& frame = m_frames[m_frameIndex % kFrameHistory];
+    frame.cpuScopes.push_back({ name, start, 0, t_depth, thread });
+    t_depth++;
+
+    return { m_frameIndex, (uint32_t)(frame.cpuScopes.size() - 1) };
+}
+
+void Profiler::endScope(ScopeHandle handle) {
+    if (handle.frame == kInvalidFrame) {
+        return;
+    }
+
+    uint64_t end = now();
+    t_depth--;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // the frame may have ended (and been closed) while the scope was open
+    if (!m_inFrame || handle.frame != m_frameIndex) {
+        return;
+    }
+
+    ProfileFrame& frame = m_frames[m_frameIndex % kFrameHistory];
+    frame.cpuScopes[handle.index].end = end;
+}
+
+void Profiler::attachGpuScopes(uint64_t frameIndex, const std::vector<ProfileScopeRecord>& scopes, uint64_t gpuTime) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ProfileFrame& frame = m_frames[frameIndex % kFrameHistory];
+    if (frame.index != frameIndex) {
+        return;
+    }
+
+    frame.gpuScopes.clear();
+    for (const auto& scope : scopes) {
+        frame.gpuScopes.push_back({ scope.name, frame.start + scope.start, frame.start + scope.end, scope.depth, scope.thread });
+    }
+    frame.gpuTime = gpuTime;
+    frame.gpuResolved = true;
+}
+
+size_t Profiler::completedFrames() const {
+    return m_completed < kFrameHistory - 1 ? (size_t)m_completed : kFrameHistory - 1;
+}
+
+const ProfileFrame& Profiler::frame(size_t age) const {
+    return m_frames[(m_frameIndex - 1 - age) % kFrameHistory];
+}
+
+static void write_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "ERROR: could not open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    // CPU threads are tids of pid 0, the GPU timeline is pid 1
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}");
+
+    uint32_t threads = m_threadCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < threads && i < kMaxThreads; i++) {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", i);
+        if (m_threadNames[i]) {
+            write_json_string(file, m_threadNames[i]);
+        }
+        else {
+            fprintf(file, "\"Thread %u\"", i);
+        }
+        fprintf(file, "}}");
+    }
+
+    auto write_event = [file](const char* name, int pid, int tid, uint64_t start, uint64_t end) {
+        fprintf(file, ",\n{\"name\":");
+        write_json_string(file, name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            pid, tid, start * 1e-3, (end - start) * 1e-3);
+    };
+
+    for (size_t age = completedFrames(); age-- > 0;) {
+        const ProfileFrame& f = frame(age);
+        write_event("Frame", 0, 0, f.start, f.end);
+        for (const auto& scope : f.cpuScopes) {
+            write_event(scope.name, 0, scope.thread, scope.start, scope.end);
+        }
+        for (const auto& scope : f.gpuScopes) {
+            write_event(scope.name, 1, 0, scope.start, scope.end);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return true;
+}
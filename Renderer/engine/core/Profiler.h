@@ -0,0 +1,160 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One timed scope, either a CPU marker or a GPU query pair
+ *
+ * Times are nanoseconds on the profiler clock (see `Profiler::now`). GPU scopes are
+ * re-based onto the CPU frame that issued them, so both can share a timeline.
+ *
+ * @note `name` is not copied, it must outlive the profiler (string literals).
+ */
+struct ProfileScopeRecord {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint16_t depth;
+    uint16_t thread;
+};
+
+struct ProfileFrame {
+    uint64_t index;
+    uint64_t start;
+    uint64_t end;
+    uint64_t gpuTime;    // whole-frame GPU time (GL_TIME_ELAPSED), 0 until the results arrive
+    bool gpuResolved;
+    std::vector<ProfileScopeRecord> cpuScopes;
+    std::vector<ProfileScopeRecord> gpuScopes;
+
+    double durationMs() const { return (end - start) * 1e-6; }
+    double gpuMs() const { return gpuTime * 1e-6; }
+};
+
+/**
+ * @brief Frame profiler
+ *
+ * Collects nested CPU scopes between `beginFrame` and `endFrame` into a ring of the last
+ * `kFrameHistory` frames. Ring entries keep their storage between frames, so recording
+ * does not allocate once the ring has warmed up.
+ *
+ * Scopes can be opened from any thread; nesting depth is tracked per thread.
+ * GPU scopes are produced by `GpuProfiler` and attached to the frame that issued them
+ * once their queries resolve, a frame or two later.
+ *
+ * Use the `PROFILE_SCOPE("name")` macro rather than calling `beginScope`/`endScope`.
+ */
+class Profiler {
+public:
+    static constexpr size_t kFrameHistory = 128;
+    static constexpr size_t kMaxThreads = 64;
+
+    struct ScopeHandle {
+        uint64_t frame;
+        uint32_t index;
+    };
+
+    static Profiler& get();
+
+    Profiler();
+
+    Profiler(const Profiler& other) = delete;
+
+    Profiler& operator=(const Profiler& other) = delete;
+
+    /// Nanoseconds since the profiler was created
+    uint64_t now() const;
+
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void beginFrame();
+
+    void endFrame();
+
+    ScopeHandle beginScope(const char* name);
+
+    void endScope(ScopeHandle handle);
+
+    /**
+     * @brief Attaches resolved GPU scopes to a recorded frame
+     *
+     * `scopes` times are relative to the first GPU query of the frame, they are shifted
+     * onto the CPU frame start. Does nothing if the frame already left the ring.
+     */
+    void attachGpuScopes(uint64_t frameIndex, const std::vector<ProfileScopeRecord>& scopes, uint64_t gpuTime);
+
+    /// Index of the frame being recorded
+    uint64_t frameIndex() const { return m_frameIndex; }
+
+    /// Number of completed frames available, at most `kFrameHistory - 1`
+    size_t completedFrames() const;
+
+    /**
+     * @brief Returns a completed frame
+     *
+     * @param age 0 is the most recently completed frame, 1 the one before...
+     */
+    const ProfileFrame& frame(size_t age) const;
+
+    /**
+     * @brief Writes every completed frame in the ring as a Chrome trace (chrome://tracing, Perfetto)
+     */
+    bool exportChromeTrace(const std::string& path) const;
+
+    /// Short name shown for a recording thread, the main thread is "Main"
+    void setThreadName(const char* name);
+
+private:
+    ProfileFrame m_frames[kFrameHistory];
+    uint64_t m_frameIndex;
+    uint64_t m_completed;
+    bool m_inFrame;
+    std::atomic<bool> m_enabled;
+    uint64_t m_epoch;
+
+    const char* m_threadNames[kMaxThreads];
+    std::atomic<uint32_t> m_threadCount;
+
+    mutable std::mutex m_mutex;
+
+    uint16_t _threadIndex();
+};
+
+/**
+ * @brief RAII CPU scope marker
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : m_handle(Profiler::get().beginScope(name)) {}
+
+    ~ProfileScope() { Profiler::get().endScope(m_handle); }
+
+    ProfileScope(const ProfileScope& other) = delete;
+
+    ProfileScope& operator=(const ProfileScope& other) = delete;
+
+private:
+    Profiler::ScopeHandle m_handle;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifndef PROFILER_DISABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#endif
+
+#endif // !_PROFILER_H_
@@ -12,6 +12,13 @@ Shader::Shader(const std::string& vertexShaderPath, const std::string& fragmentS
     _setShaders(vertexShaderPath, fragmentShaderPath);
 }
 
+Shader::Shader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+               const std::vector<std::string>& defines)
+    : m_programID(0), m_vertexShaderID(0), m_fragmentShaderID(0)
+{
+    _setShaders(vertexShaderPath, fragmentShaderPath, defines);
+}
+
 Shader::~Shader() {
     glDeleteProgram(m_programID);
 }
@@ -19,55 +26,59 @@ Shader::~Shader() {
 
 // Set uniforms implementations
 
-void Shader::setUniform(const std::string& name, bool value) const {
+void Shader::setUniform(UniformName name, bool value) const {
     glUniform1i(glGetUniformLocation(m_programID, name.c_str()), (int)value);
 }
 
-void Shader::setUniform(const std::string& name, int value) const {
+void Shader::setUniform(UniformName name, int value) const {
     glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
 }
 
-void Shader::setUniform(const std::string& name, float value) const {
+void Shader::setUniform(UniformName name, float value) const {
     glUniform1f(glGetUniformLocation(m_programID, name.c_str()), value);
 }
 
-void Shader::setUniform(const std::string& name, const glm::vec2& value) const {
+void Shader::setUniform(UniformName name, const glm::vec2& value) const {
     glUniform2fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
 }
 
-void Shader::setUniform(const std::string& name, float x, float y) const {
+void Shader::setUniform(UniformName name, float x, float y) const {
     glUniform2f(glGetUniformLocation(m_programID, name.c_str()), x, y);
 }
 
-void Shader::setUniform(const std::string& name, const glm::vec3& value) const {
+void Shader::setUniform(UniformName name, const glm::vec3& value) const {
     glUniform3fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
 }
 
-void Shader::setUniform(const std::string& name, float x, float y, float z) const {
+void Shader::setUniform(UniformName name, const glm::uvec3& value) const {
+    glUniform3uiv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+}
+
+void Shader::setUniform(UniformName name, float x, float y, float z) const {
     glUniform3f(glGetUniformLocation(m_programID, name.c_str()), x, y, z);
 }
 
-void Shader::setUniform(const std::string& name, const glm::vec4& value) const {
+void Shader::setUniform(UniformName name, const glm::vec4& value) const {
     glUniform4fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
 }
 
-void Shader::setUniform(const std::string& name, float x, float y, float z, float w) const {
+void Shader::setUniform(UniformName name, float x, float y, float z, float w) const {
     glUniform4f(glGetUniformLocation(m_programID, name.c_str()), x, y, z, w);
 }
 
-void Shader::setUniform(const std::string& name, const glm::mat2& mat) const {
+void Shader::setUniform(UniformName name, const glm::mat2& mat) const {
     glUniformMatrix2fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::setUniform(const std::string& name, const glm::mat3& mat) const {
+void Shader::setUniform(UniformName name, const glm::mat3& mat) const {
     glUniformMatrix3fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::setUniform(const std::string& name, const glm::mat4& mat) const {
+void Shader::setUniform(UniformName name, const glm::mat4& mat) const {
     glUniformMatrix4fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-GLint Shader::getUniformLocation(const std::string& name) const {
+GLint Shader::getUniformLocation(UniformName name) const {
     return glGetUniformLocation(m_programID, name.c_str());
 }
 
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <glm/vec3.hpp>
@@ -12,10 +13,31 @@
 #include <glm/mat3x3.hpp>
 #include <glm/mat4x4.hpp>
 
+#include "Memory.h"
+#include "ShaderDefines.h"
+
 ///TODO: Forward declare glm classes declarations
 namespace glm {}
 
 
+/**
+ * @brief A uniform name as GL takes it: from a literal or a std::string, without a copy
+ *
+ * Taking a std::string copied literals longer than the small string buffer (15 characters
+ * with libstdc++) to the heap on every call.
+ */
+class UniformName {
+public:
+    UniformName(const char* name) : m_name(name) {}
+
+    UniformName(const std::string& name) : m_name(name.c_str()) {}
+
+    const char* c_str() const { return m_name; }
+
+private:
+    const char* m_name;
+};
+
 class Shader {
 public:
     Shader();
@@ -23,6 +45,12 @@ public:
     Shader(
         const std::string& vertexShaderPath,
         const std::string& fragmentShaderPath);
+
+    /// Compiles the permutation selected by `defines`, see shader_inject_defines
+    Shader(
+        const std::string& vertexShaderPath,
+        const std::string& fragmentShaderPath,
+        const std::vector<std::string>& defines);
     
     ~Shader();
 
@@ -33,26 +61,35 @@ public:
         _setShaders(vertexShaderPath, fragmentShaderPath);
     }
 
+    void setShaders(
+        const std::string& vertexShaderPath,
+        const std::string& fragmentShaderPath,
+        const std::vector<std::string>& defines)
+    {
+        _setShaders(vertexShaderPath, fragmentShaderPath, defines);
+    }
+
     inline constexpr unsigned int id() const { return m_programID;}
 
     void use() { glUseProgram(m_programID); }
 
     /// Set uniforms
-    void setUniform(const std::string& name, bool value) const;
-    void setUniform(const std::string& name, int value) const;
-    void setUniform(const std::string& name, float value) const;
-    void setUniform(const std::string& name, const glm::vec3& value) const;
-    void setUniform(const std::string& name, const glm::vec4& value) const;
-    void setUniform(const std::string& name, const glm::mat3& value) const;
-    void setUniform(const std::string& name, const glm::mat4& value) const;
-    void setUniform(const std::string& name, const glm::vec2& value) const;
-    void setUniform(const std::string& name, float x, float y) const;
-    void setUniform(const std::string& name, float x, float y, float z) const;
-    void setUniform(const std::string& name, float x, float y, float z, float w) const;
-    void setUniform(const std::string& name, const glm::mat2& mat) const;
+    void setUniform(UniformName name, bool value) const;
+    void setUniform(UniformName name, int value) const;
+    void setUniform(UniformName name, float value) const;
+    void setUniform(UniformName name, const glm::vec3& value) const;
+    void setUniform(UniformName name, const glm::vec4& value) const;
+    void setUniform(UniformName name, const glm::mat3& value) const;
+    void setUniform(UniformName name, const glm::mat4& value) const;
+    void setUniform(UniformName name, const glm::vec2& value) const;
+    void setUniform(UniformName name, float x, float y) const;
+    void setUniform(UniformName name, float x, float y, float z) const;
+    void setUniform(UniformName name, float x, float y, float z, float w) const;
+    void setUniform(UniformName name, const glm::mat2& mat) const;
+    void setUniform(UniformName name, const glm::uvec3& value) const;
 
     /// Get uniforms
-    GLint getUniformLocation(const std::string& name) const;
+    GLint getUniformLocation(UniformName name) const;
 
     /// Read uniform values
     bool getUniform(const std::string& name, bool& value) const;
@@ -80,7 +117,9 @@ private:
     };
 
 private:
-    void _setShaders(const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
+    void _setShaders(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+                     const std::vector<std::string>& defines = {}) {
+        MemoryScope scope(MemoryTag::Shader);
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -109,6 +148,8 @@ private:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        vertexCode = shader_inject_defines(vertexCode, defines);
+        fragmentCode = shader_inject_defines(fragmentCode, defines);
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
@@ -0,0 +1,37 @@
+#ifndef _SHADER_DEFINES_H_
+#define _SHADER_DEFINES_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Shader permutations: `#define` lines spliced into a GLSL source
+ *
+ * Each define is "NAME" or "NAME VALUE". They go right after the `#version` line (which must
+ * stay first), or at the top when the source has none. Used by both Shader classes, so the
+ * same file compiles to several variants, e.g. COMPRESSED_VERTICES for quantized meshes.
+ */
+inline std::string shader_inject_defines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+
+    std::string block;
+    for (const std::string& define : defines) {
+        block += "#define " + define + "\n";
+    }
+
+    size_t version = source.find("#version");
+    if (version == std::string::npos) {
+        return block + source;
+    }
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return source + "\n" + block;
+    }
+    std::string result = source;
+    result.insert(lineEnd + 1, block);
+    return result;
+}
+
+#endif // !_SHADER_DEFINES_H_
@@ -23,6 +23,7 @@ Texture::Texture(const std::string& fileLoc, GLenum textureUnit) :
 }
 
 void Texture::load(const std::string& fileLoc) {
+    MemoryScope scope(MemoryTag::Texture);
     m_textureBuffer = stbi_load(fileLoc.c_str(), &m_width, &m_height, &m_bitDepth, 0);
     stbi_set_flip_vertically_on_load(true);  
 
@@ -53,6 +54,7 @@ void Texture::load(const std::string& fileLoc) {
     GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, m_textureBuffer));
     
     GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
+    gl_track_texture(m_textureID, m_width, m_height, GL_RGB, true);
     
 
     /// unbind the texture. Why? 
@@ -81,6 +83,7 @@ void Texture::unbind() {
 }
 
 void Texture::clear() {
+    gl_untrack_texture(m_textureID);
     GL_CALL(glDeleteTextures(1, &m_textureID));
     
     m_textureID = 0;
@@ -81,6 +81,7 @@ public:
     void unbind();
     void clear();
 
+    GLuint id() const { return m_textureID; }
 
     int width() const { return m_width; }
     void setWidth(int width) { m_width = width; }
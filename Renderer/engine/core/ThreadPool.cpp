@@ -0,0 +1,18 @@
+#include "ThreadPool.h"
+
+ThreadPool& ThreadPool::get() {
+    static ThreadPool pool(JobSystem::get());
+    return pool;
+}
+
+ThreadPool::ThreadPool(unsigned int workers)
+    : m_owned(std::make_unique<JobSystem>(workers + 1)),
+      m_jobs(*m_owned)
+{}
+
+ThreadPool::ThreadPool(JobSystem& jobs)
+    : m_owned(),
+      m_jobs(jobs)
+{}
+
+ThreadPool::~ThreadPool() = default;
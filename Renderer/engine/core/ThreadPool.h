@@ -0,0 +1,47 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include "JobSystem.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Data-parallel loops on top of the job system
+ *
+ * `parallelFor` splits [0, count) into chunks of at least `grain` indices which the
+ * threads of the job system steal from each other; the call returns once every chunk has
+ * run. Loops may run concurrently and nest, a waiting caller runs other jobs meanwhile.
+ */
+class ThreadPool {
+public:
+    /// Shared pool over JobSystem::get()
+    static ThreadPool& get();
+
+    /// Pool with its own job system of `workers` threads plus the caller
+    explicit ThreadPool(unsigned int workers);
+
+    ThreadPool(const ThreadPool& other) = delete;
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    ~ThreadPool();
+
+    /// Threads that run chunks: the workers plus the caller
+    unsigned int threadCount() const { return m_jobs.threadCount(); }
+
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& fn) {
+        m_jobs.parallelFor(count, grain, fn);
+    }
+
+    JobSystem& jobs() { return m_jobs; }
+
+private:
+    std::unique_ptr<JobSystem> m_owned;
+    JobSystem& m_jobs;
+
+    explicit ThreadPool(JobSystem& jobs);
+};
+
+#endif // !_THREAD_POOL_H_
@@ -1,5 +1,7 @@
 #include "Triangle.h"
 
+#include "../opengl/RenderStats.h"
+
 
 Triangle::Triangle(float* vertices, const Shader& shader)
     : m_shader(shader)
@@ -33,4 +35,5 @@ void Triangle::Draw()
     m_shader.use();
     glBindVertexArray(m_vao);
     glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
 }
\ No newline at end of file
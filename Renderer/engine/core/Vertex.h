@@ -1,6 +1,8 @@
 #ifndef _VERTEX_H_
 #define _VERTEX_H_
 
+#include <cstddef>
+#include <initializer_list>
 #include <tuple>
 #include <vector>
 
@@ -159,6 +161,40 @@ public:
     Normal& operator=(Normal&& other) = default;
 };
 
+/**
+ * @brief Fixed capacity storage for the components of a Vertex
+ *
+ * Holds up to `_Capacity` values inline; a Vertex used to keep them in a std::vector and
+ * cost a heap allocation each.
+ */
+template<typename _Ty, size_t _Capacity>
+class VertexComponents {
+public:
+    VertexComponents() : m_values(), m_size(0) {}
+
+    VertexComponents(std::initializer_list<_Ty> values) : m_values(), m_size(0) {
+        for (const _Ty& value : values) {
+            if (m_size < _Capacity) {
+                m_values[m_size++] = value;
+            }
+        }
+    }
+
+    _Ty* data() { return m_values; }
+
+    const _Ty* data() const { return m_values; }
+
+    size_t size() const { return m_size; }
+
+    _Ty& operator[](size_t index) { return m_values[index]; }
+
+    const _Ty& operator[](size_t index) const { return m_values[index]; }
+
+private:
+    _Ty m_values[_Capacity];
+    size_t m_size;
+};
+
 template<typename _Ty>
 struct Vertex {
 public:
@@ -228,7 +264,7 @@ public:
         return *this;
     }
 
-    _Ty* data() const {
+    const _Ty* data() const {
         return m_data.data();
     }
 
@@ -331,7 +367,8 @@ public:
     }
 
 private:
-    std::vector<_Ty> m_data;
+    // position, color, uv, normal
+    VertexComponents<_Ty, 11> m_data;
 };
 
 #endif // !_VERTEX_H_
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "ClusterCulling.h"
+
+#include "../opengl/log.h"
+#include "../opengl/utils.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// GPU counters, in the order of the Stats block in meshlet_cull.comp
+enum StatsCounter {
+    kClusters,
+    kFrustumRejected,
+    kBackfaceRejected,
+    kTriangles,
+    kTrianglesRejected,
+    kCounterCount
+};
+
+}
+
+ClusterCullStats& ClusterCullStats::operator+=(const ClusterCullStats& other) {
+    clusters += other.clusters;
+    frustumRejected += other.frustumRejected;
+    backfaceRejected += other.backfaceRejected;
+    triangles += other.triangles;
+    trianglesRejected += other.trianglesRejected;
+    return *this;
+}
+
+ClusterView::ClusterView(const glm::mat4& viewProjection, const glm::mat4& model, const glm::vec3& eyeWorld)
+    : frustum(viewProjection * model),
+      eye(glm::vec3(glm::inverse(model) * glm::vec4(eyeWorld, 1.0f)))
+{}
+
+size_t cull_meshlets(const MeshletMesh& mesh, const ClusterView& view,
+                     std::vector<DrawElementsIndirectCommand>& commands, ClusterCullStats& stats)
+{
+    const size_t first = commands.size();
+    bool extend = false;
+
+    for (size_t i = 0; i < mesh.meshlets.size(); i++) {
+        const Meshlet& meshlet = mesh.meshlets[i];
+        const ClusterVisibility visibility = classify_meshlet(mesh.bounds[i], view);
+
+        stats.clusters++;
+        stats.triangles += meshlet.triangleCount;
+        if (visibility != ClusterVisibility::Visible) {
+            stats.trianglesRejected += meshlet.triangleCount;
+            if (visibility == ClusterVisibility::OutsideFrustum) {
+                stats.frustumRejected++;
+            } else {
+                stats.backfaceRejected++;
+            }
+            extend = false;
+            continue;
+        }
+
+        if (extend) {
+            commands.back().count += meshlet.triangleCount * 3;
+        } else {
+            commands.push_back({ meshlet.triangleCount * 3, 1, meshlet.triangleOffset * 3, 0, 0 });
+            extend = true;
+        }
+    }
+    return commands.size() - first;
+}
+
+GpuClusterCuller::GpuClusterCuller()
+    : m_program(0), m_statsBuffer(0), m_planesLocation(-1), m_eyeLocation(-1), m_meshletCountLocation(-1)
+{}
+
+GpuClusterCuller::~GpuClusterCuller() {
+    shutdown();
+}
+
+bool GpuClusterCuller::init(const std::string& computeShaderPath) {
+    shutdown();
+
+    std::ifstream file(computeShaderPath);
+    if (!file) {
+        gl_log_err("ERROR: could not open cluster culling shader %s\n", computeShaderPath.c_str());
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string source = stream.str();
+    const char* code = source.c_str();
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    GL_CALL(glShaderSource(shader, 1, &code, nullptr));
+    GL_CALL(glCompileShader(shader));
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        gl_log_err("ERROR: cluster culling shader %s failed to compile:\n%s\n", computeShaderPath.c_str(), infoLog);
+        glDeleteShader(shader);
+        return false;
+    }
+
+    m_program = glCreateProgram();
+    GL_CALL(glAttachShader(m_program, shader));
+    GL_CALL(glLinkProgram(m_program));
+    GL_CALL(glDeleteShader(shader));
+    glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(m_program, sizeof(infoLog), nullptr, infoLog);
+        gl_log_err("ERROR: cluster culling program failed to link:\n%s\n", infoLog);
+        shutdown();
+        return false;
+    }
+
+    m_planesLocation = glGetUniformLocation(m_program, "planes");
+    m_eyeLocation = glGetUniformLocation(m_program, "eye");
+    m_meshletCountLocation = glGetUniformLocation(m_program, "meshletCount");
+
+    GL_CALL(glGenBuffers(1, &m_statsBuffer));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, kCounterCount * sizeof(GLuint), nullptr, GL_DYNAMIC_READ));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    resetStats();
+    return true;
+}
+
+void GpuClusterCuller::shutdown() {
+    if (m_statsBuffer) {
+        GL_CALL(glDeleteBuffers(1, &m_statsBuffer));
+        m_statsBuffer = 0;
+    }
+    if (m_program) {
+        GL_CALL(glDeleteProgram(m_program));
+        m_program = 0;
+    }
+}
+
+void GpuClusterCuller::cull(GLuint meshletBuffer, GLuint boundsBuffer, GLuint commandBuffer, uint32_t meshletCount,
+                            const ClusterView& view)
+{
+    if (!m_program || meshletCount == 0) {
+        return;
+    }
+
+    GL_CALL(glUseProgram(m_program));
+    GL_CALL(glUniform4fv(m_planesLocation, 6, &view.frustum.planes[0][0]));
+    GL_CALL(glUniform3fv(m_eyeLocation, 1, &view.eye[0]));
+    GL_CALL(glUniform1ui(m_meshletCountLocation, meshletCount));
+
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kMeshletBinding, meshletBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kBoundsBinding, boundsBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, commandBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kStatsBinding, m_statsBuffer));
+
+    GL_CALL(glDispatchCompute((meshletCount + kGroupSize - 1) / kGroupSize, 1, 1));
+    // the draw reads the commands through GL_DRAW_INDIRECT_BUFFER, the counters may be read back
+    GL_CALL(glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT));
+}
+
+ClusterCullStats GpuClusterCuller::readStats() const {
+    ClusterCullStats stats;
+    if (!m_statsBuffer) {
+        return stats;
+    }
+
+    GLuint counters[kCounterCount] = {};
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer));
+    GL_CALL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), counters));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    stats.clusters = counters[kClusters];
+    stats.frustumRejected = counters[kFrustumRejected];
+    stats.backfaceRejected = counters[kBackfaceRejected];
+    stats.triangles = counters[kTriangles];
+    stats.trianglesRejected = counters[kTrianglesRejected];
+    return stats;
+}
+
+void GpuClusterCuller::resetStats() {
+    if (!m_statsBuffer) {
+        return;
+    }
+    const GLuint zeros[kCounterCount] = {};
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer));
+    GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+}
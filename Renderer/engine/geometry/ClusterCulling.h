@@ -0,0 +1,134 @@
+#ifndef _CLUSTER_CULLING_H_
+#define _CLUSTER_CULLING_H_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Meshlets.h"
+#include "../math/Frustum.h"
+
+/// Layout glMultiDrawElementsIndirect reads, 20 bytes
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+struct ClusterCullStats {
+    size_t clusters = 0;
+    size_t frustumRejected = 0;
+    size_t backfaceRejected = 0;
+    size_t triangles = 0;
+    size_t trianglesRejected = 0;
+
+    /// Share of the triangles that never reach the GPU's vertex stage
+    double rejectionRate() const { return triangles ? (double)trianglesRejected / triangles : 0.0; }
+
+    ClusterCullStats& operator+=(const ClusterCullStats& other);
+};
+
+/**
+ * @brief What a mesh is culled against, in the mesh's own space
+ *
+ * Bounds stay in model space: the frustum comes from `viewProjection * model` and the eye is
+ * brought into model space. The cone test assumes `model` has no non-uniform scale.
+ */
+struct ClusterView {
+    Frustum frustum;
+    glm::vec3 eye;
+
+    ClusterView() = default;
+
+    ClusterView(const glm::mat4& viewProjection, const glm::mat4& model, const glm::vec3& eyeWorld);
+};
+
+enum class ClusterVisibility : uint8_t {
+    Visible,
+    OutsideFrustum,
+    BackFacing
+};
+
+inline ClusterVisibility classify_meshlet(const MeshletBounds& bounds, const ClusterView& view) {
+    if (!view.frustum.intersectsSphere(bounds.center, bounds.radius)) {
+        return ClusterVisibility::OutsideFrustum;
+    }
+    const glm::vec3 toCenter = bounds.center - view.eye;
+    if (glm::dot(toCenter, bounds.coneAxis) >= bounds.coneCutoff * glm::length(toCenter) + bounds.radius) {
+        return ClusterVisibility::BackFacing;
+    }
+    return ClusterVisibility::Visible;
+}
+
+/**
+ * @brief Culls every meshlet on the CPU and appends draws for the survivors
+ *
+ * Consecutive visible meshlets are contiguous in MeshletMesh::indices and share one
+ * command. Returns the number of commands appended.
+ */
+size_t cull_meshlets(const MeshletMesh& mesh, const ClusterView& view,
+                     std::vector<DrawElementsIndirectCommand>& commands, ClusterCullStats& stats);
+
+/**
+ * @brief The same culling as a compute pass (assets/shaders/culling/meshlet_cull.comp)
+ *
+ * Reads a mesh's meshlets and bounds from two SSBOs and writes one command per meshlet,
+ * `instanceCount` 0 for rejected ones, so `glMultiDrawElementsIndirect` with the meshlet
+ * count draws the survivors without a CPU round trip. GL 4.5 has no indirect draw count,
+ * hence the zero-instance commands rather than a compacted list.
+ *
+ * @note Must be initialized and used on the thread that owns the GL context.
+ */
+class GpuClusterCuller {
+public:
+    static constexpr GLuint kMeshletBinding = 0;
+    static constexpr GLuint kBoundsBinding = 1;
+    static constexpr GLuint kCommandBinding = 2;
+    static constexpr GLuint kStatsBinding = 3;
+    static constexpr GLuint kGroupSize = 64;
+
+    GpuClusterCuller();
+
+    GpuClusterCuller(const GpuClusterCuller& other) = delete;
+
+    GpuClusterCuller& operator=(const GpuClusterCuller& other) = delete;
+
+    ~GpuClusterCuller();
+
+    /**
+     * @brief Compiles the compute shader and creates the counters, needs a current context
+     */
+    bool init(const std::string& computeShaderPath);
+
+    void shutdown();
+
+    bool initialized() const { return m_program != 0; }
+
+    /**
+     * @brief Writes `meshletCount` commands into `commandBuffer`
+     *
+     * Issues the GL_COMMAND_BARRIER_BIT barrier the indirect draw needs.
+     */
+    void cull(GLuint meshletBuffer, GLuint boundsBuffer, GLuint commandBuffer, uint32_t meshletCount,
+              const ClusterView& view);
+
+    /// Totals of every `cull` since the last reset; reads the counters back, so it waits for the GPU
+    ClusterCullStats readStats() const;
+
+    void resetStats();
+
+private:
+    GLuint m_program;
+    GLuint m_statsBuffer;
+    GLint m_planesLocation;
+    GLint m_eyeLocation;
+    GLint m_meshletCountLocation;
+};
+
+#endif // !_CLUSTER_CULLING_H_
@@ -0,0 +1,232 @@
+#include "Meshlets.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const uint32_t kUnassigned = UINT32_MAX;
+
+// unused triangles looked at when a meshlet has no adjacent triangle left
+const size_t kLookahead = 256;
+
+glm::vec3 position_at(const uint8_t* positions, size_t stride, uint32_t index) {
+    glm::vec3 p;
+    std::memcpy(&p, positions + index * stride, sizeof(p));
+    return p;
+}
+
+}
+
+MeshletBounds compute_meshlet_bounds(const void* positions, size_t stride, const uint32_t* indices, size_t triangleCount) {
+    const uint8_t* base = (const uint8_t*)positions;
+    MeshletBounds bounds;
+
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        const glm::vec3 p = position_at(base, stride, indices[i]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    bounds.center = triangleCount ? (lo + hi) * 0.5f : glm::vec3(0.0f);
+    float radius2 = 0.0f;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        const glm::vec3 d = position_at(base, stride, indices[i]) - bounds.center;
+        radius2 = std::fmax(radius2, glm::dot(d, d));
+    }
+    bounds.radius = std::sqrt(radius2);
+
+    // normal cone: the average normal, then how far the others stray from it
+    auto triangleNormal = [&](size_t t) {
+        const glm::vec3 p0 = position_at(base, stride, indices[t * 3 + 0]);
+        const glm::vec3 p1 = position_at(base, stride, indices[t * 3 + 1]);
+        const glm::vec3 p2 = position_at(base, stride, indices[t * 3 + 2]);
+        return glm::cross(p1 - p0, p2 - p0);
+    };
+
+    glm::vec3 sum(0.0f);
+    for (size_t t = 0; t < triangleCount; t++) {
+        const glm::vec3 n = triangleNormal(t);
+        const float length = glm::length(n);
+        if (length > 0.0f) {
+            sum += n / length;
+        }
+    }
+
+    bounds.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    bounds.coneCutoff = 1.0f;
+    const float sumLength = glm::length(sum);
+    if (sumLength < 1e-6f) {
+        return bounds;
+    }
+
+    const glm::vec3 axis = sum / sumLength;
+    float minDot = 1.0f;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const glm::vec3 n = triangleNormal(t);
+        const float length = glm::length(n);
+        // degenerate triangles are never rasterized, they don't constrain the cone
+        if (length > 0.0f) {
+            minDot = std::fmin(minDot, glm::dot(axis, n / length));
+        }
+    }
+    bounds.coneAxis = axis;
+    // past ~84 degrees of spread the test can never pass in practice, skip it outright
+    bounds.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    return bounds;
+}
+
+void build_meshlets(const void* positions, size_t stride, size_t vertexCount,
+                    const uint32_t* indices, size_t indexCount, MeshletMesh& out,
+                    size_t maxVertices, size_t maxTriangles)
+{
+    const uint8_t* base = (const uint8_t*)positions;
+    const size_t triangleCount = indexCount / 3;
+    maxVertices = maxVertices < 3 ? 3 : (maxVertices > 256 ? 256 : maxVertices);   // local indices are 8 bits
+    maxTriangles = maxTriangles < 1 ? 1 : maxTriangles;
+
+    out.meshlets.clear();
+    out.bounds.clear();
+    out.vertices.clear();
+    out.localIndices.clear();
+    out.indices.clear();
+    out.indices.reserve(triangleCount * 3);
+    out.localIndices.reserve(triangleCount * 3);
+
+    // vertex -> triangles using it
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        adjacencyOffsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++) {
+            adjacency[cursor[indices[i]]++] = (uint32_t)(i / 3);
+        }
+    }
+
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        centroids[t] = (position_at(base, stride, indices[t * 3]) + position_at(base, stride, indices[t * 3 + 1])
+                        + position_at(base, stride, indices[t * 3 + 2])) / 3.0f;
+    }
+
+    std::vector<uint8_t> used(triangleCount, 0);
+    std::vector<uint32_t> local(vertexCount, kUnassigned);
+    std::vector<uint32_t> candidateStamp(triangleCount, kUnassigned);
+    std::vector<uint32_t> candidates;
+    size_t scan = 0;
+
+    Meshlet current = { 0, 0, 0, 0 };
+    glm::vec3 centroidSum(0.0f);
+
+    auto newVertices = [&](uint32_t t) {
+        return (size_t)(local[indices[t * 3]] == kUnassigned) + (local[indices[t * 3 + 1]] == kUnassigned)
+             + (local[indices[t * 3 + 2]] == kUnassigned);
+    };
+
+    auto add = [&](uint32_t t) {
+        used[t] = 1;
+        for (int k = 0; k < 3; k++) {
+            const uint32_t v = indices[t * 3 + k];
+            if (local[v] == kUnassigned) {
+                local[v] = current.vertexCount++;
+                out.vertices.push_back(v);
+            }
+            out.localIndices.push_back((uint8_t)local[v]);
+            out.indices.push_back(v);
+
+            for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++) {
+                const uint32_t neighbour = adjacency[a];
+                if (!used[neighbour] && candidateStamp[neighbour] != (uint32_t)out.meshlets.size()) {
+                    candidateStamp[neighbour] = (uint32_t)out.meshlets.size();
+                    candidates.push_back(neighbour);
+                }
+            }
+        }
+        current.triangleCount++;
+        centroidSum += centroids[t];
+    };
+
+    auto flush = [&]() {
+        if (current.triangleCount == 0) {
+            return;
+        }
+        for (uint32_t i = current.vertexOffset; i < current.vertexOffset + current.vertexCount; i++) {
+            local[out.vertices[i]] = kUnassigned;
+        }
+        out.bounds.push_back(compute_meshlet_bounds(positions, stride, &out.indices[current.triangleOffset * 3], current.triangleCount));
+        out.meshlets.push_back(current);
+        current = { (uint32_t)out.vertices.size(), 0, (uint32_t)(out.indices.size() / 3), 0 };
+        candidates.clear();
+        centroidSum = glm::vec3(0.0f);
+    };
+
+    for (;;) {
+        while (scan < triangleCount && used[scan]) {
+            scan++;
+        }
+        if (scan == triangleCount) {
+            break;
+        }
+
+        uint32_t best = kUnassigned;
+        if (current.triangleCount == 0) {
+            best = (uint32_t)scan;
+        } else {
+            const glm::vec3 center = centroidSum / (float)current.triangleCount;
+            size_t bestNew = 4;
+            float bestDistance = FLT_MAX;
+
+            size_t kept = 0;
+            for (uint32_t c : candidates) {
+                if (used[c]) {
+                    continue;
+                }
+                candidates[kept++] = c;
+                const size_t added = newVertices(c);
+                if (current.vertexCount + added > maxVertices) {
+                    continue;
+                }
+                const glm::vec3 d = centroids[c] - center;
+                const float distance = glm::dot(d, d);
+                if (added < bestNew || (added == bestNew && distance < bestDistance)) {
+                    best = c;
+                    bestNew = added;
+                    bestDistance = distance;
+                }
+            }
+            candidates.resize(kept);
+
+            if (best == kUnassigned) {
+                for (size_t t = scan; t < triangleCount && t < scan + kLookahead; t++) {
+                    if (used[t] || current.vertexCount + newVertices((uint32_t)t) > maxVertices) {
+                        continue;
+                    }
+                    const glm::vec3 d = centroids[t] - center;
+                    const float distance = glm::dot(d, d);
+                    if (distance < bestDistance) {
+                        best = (uint32_t)t;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+
+        if (best == kUnassigned) {
+            flush();
+            continue;
+        }
+
+        add(best);
+        if (current.triangleCount == maxTriangles) {
+            flush();
+        }
+    }
+    flush();
+}
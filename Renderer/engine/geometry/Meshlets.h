@@ -0,0 +1,79 @@
+#ifndef _MESHLETS_H_
+#define _MESHLETS_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr size_t kMeshletMaxVertices = 64;
+constexpr size_t kMeshletMaxTriangles = 124;
+
+/**
+ * @brief A cluster of up to kMeshletMaxTriangles triangles over up to kMeshletMaxVertices vertices
+ *
+ * Laid out as a GLSL uvec4 so the array can be uploaded to a std430 buffer as is.
+ */
+struct Meshlet {
+    uint32_t vertexOffset;      // into MeshletMesh::vertices
+    uint32_t vertexCount;
+    uint32_t triangleOffset;    // in triangles, into MeshletMesh::localIndices / indices
+    uint32_t triangleCount;
+};
+
+/**
+ * @brief Bounding sphere and normal cone of a meshlet, two GLSL vec4s
+ *
+ * The cluster is back facing from `eye` (every triangle faces away) when
+ *
+ *     dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius
+ *
+ * coneCutoff is the sine of the cone's half angle; 1 means the normals spread too far for
+ * the test to ever pass.
+ */
+struct MeshletBounds {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+/**
+ * @brief A mesh split into meshlets
+ *
+ * Each meshlet's triangles are stored twice: as 8-bit indices into its own vertex list
+ * (the form a mesh-shader or software path wants), and as plain mesh indices, meshlet
+ * after meshlet, so one element buffer serves both a full draw and per-meshlet indirect
+ * draws of `triangleCount * 3` indices at `triangleOffset * 3`.
+ */
+struct MeshletMesh {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> localIndices;
+    std::vector<uint32_t> indices;
+
+    size_t triangleCount() const { return indices.size() / 3; }
+};
+
+/**
+ * @brief Greedily grows meshlets over shared vertices
+ *
+ * A meshlet starts from the first unused triangle and keeps adding the adjacent triangle
+ * that brings in the fewest new vertices (ties go to the one closest to the meshlet's
+ * centroid) until a limit is hit. When nothing adjacent is left, the closest of the next
+ * unused triangles in index order continues it, so disconnected CAD parts still fill up.
+ *
+ * `positions` is strided, e.g. `&vertices[0].Position` with `sizeof(Vertex)`.
+ */
+void build_meshlets(const void* positions, size_t stride, size_t vertexCount,
+                    const uint32_t* indices, size_t indexCount, MeshletMesh& out,
+                    size_t maxVertices = kMeshletMaxVertices, size_t maxTriangles = kMeshletMaxTriangles);
+
+/**
+ * @brief Bounding sphere and normal cone of `triangleCount` triangles
+ */
+MeshletBounds compute_meshlet_bounds(const void* positions, size_t stride, const uint32_t* indices, size_t triangleCount);
+
+#endif // !_MESHLETS_H_
@@ -0,0 +1,141 @@
+#include "VertexCompression.h"
+
+#include "../math/Quantize.h"
+
+#include <cfloat>
+#include <cstring>
+
+namespace {
+
+glm::vec3 read_vec3(const uint8_t* vertex, size_t offset, const glm::vec3& fallback) {
+    if (offset == VertexSourceLayout::kAbsent) {
+        return fallback;
+    }
+    glm::vec3 v;
+    std::memcpy(&v, vertex + offset, sizeof(v));
+    return v;
+}
+
+}
+
+void compress_vertices(const void* vertices, size_t count, const VertexSourceLayout& layout, CompressedVertices& out) {
+    const uint8_t* base = (const uint8_t*)vertices;
+
+    // bounds, and whether any vertex is actually skinned and how wide its joint indices are
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    int maxJoint = -1;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* vertex = base + i * layout.stride;
+        const glm::vec3 p = read_vec3(vertex, layout.position, glm::vec3(0.0f));
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+
+        if (layout.joints != VertexSourceLayout::kAbsent && layout.weights != VertexSourceLayout::kAbsent) {
+            int joints[4];
+            float weights[4];
+            std::memcpy(joints, vertex + layout.joints, sizeof(joints));
+            std::memcpy(weights, vertex + layout.weights, sizeof(weights));
+            for (int k = 0; k < 4; k++) {
+                if (joints[k] >= 0 && weights[k] > 0.0f && joints[k] > maxJoint) {
+                    maxJoint = joints[k];
+                }
+            }
+        }
+    }
+    if (count == 0) {
+        lo = hi = glm::vec3(0.0f);
+    }
+
+    out.count = count;
+    out.positionOffset = lo;
+    out.positionScale = hi - lo;
+    out.jointBytes = maxJoint < 0 ? 0 : (maxJoint < 256 ? 1 : 2);
+    out.jointOffset = sizeof(PackedVertex);
+    out.weightOffset = out.jointOffset + out.jointBytes * 4;
+    out.stride = out.jointBytes ? out.weightOffset + 4 : sizeof(PackedVertex);
+    out.data.assign(count * out.stride, 0);
+
+    const glm::vec3 inverseScale(
+        out.positionScale.x > 0.0f ? 1.0f / out.positionScale.x : 0.0f,
+        out.positionScale.y > 0.0f ? 1.0f / out.positionScale.y : 0.0f,
+        out.positionScale.z > 0.0f ? 1.0f / out.positionScale.z : 0.0f);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* vertex = base + i * layout.stride;
+        uint8_t* packed = out.data.data() + i * out.stride;
+
+        const glm::vec3 p = read_vec3(vertex, layout.position, glm::vec3(0.0f));
+        const glm::vec3 n = read_vec3(vertex, layout.normal, glm::vec3(0.0f, 0.0f, 1.0f));
+        const glm::vec3 t = read_vec3(vertex, layout.tangent, glm::vec3(0.0f));
+        const glm::vec3 b = read_vec3(vertex, layout.bitangent, glm::vec3(0.0f));
+
+        PackedVertex v{};
+        const glm::vec3 unit = (p - lo) * inverseScale;
+        v.position[0] = quantize_unorm16(unit.x);
+        v.position[1] = quantize_unorm16(unit.y);
+        v.position[2] = quantize_unorm16(unit.z);
+        v.position[3] = glm::dot(glm::cross(n, t), b) < 0.0f ? 0 : 65535;
+        oct_encode_snorm16(n, v.normal);
+        oct_encode_snorm16(t, v.tangent);
+
+        glm::vec2 uv(0.0f);
+        if (layout.texCoord != VertexSourceLayout::kAbsent) {
+            std::memcpy(&uv, vertex + layout.texCoord, sizeof(uv));
+        }
+        v.texCoord[0] = float_to_half(uv.x);
+        v.texCoord[1] = float_to_half(uv.y);
+        std::memcpy(packed, &v, sizeof(v));
+
+        if (out.jointBytes) {
+            int joints[4];
+            float weights[4];
+            std::memcpy(joints, vertex + layout.joints, sizeof(joints));
+            std::memcpy(weights, vertex + layout.weights, sizeof(weights));
+            for (int k = 0; k < 4; k++) {
+                // an unused slot keeps joint 0 with weight 0
+                if (joints[k] < 0) {
+                    joints[k] = 0;
+                    weights[k] = 0.0f;
+                }
+                if (out.jointBytes == 1) {
+                    packed[out.jointOffset + k] = (uint8_t)joints[k];
+                } else {
+                    const uint16_t joint = (uint16_t)joints[k];
+                    std::memcpy(packed + out.jointOffset + k * 2, &joint, sizeof(joint));
+                }
+            }
+            quantize_weights_unorm8(weights, packed + out.weightOffset);
+        }
+    }
+}
+
+void decompress_vertex(const CompressedVertices& compressed, size_t index, DecodedVertex& out) {
+    const uint8_t* packed = compressed.data.data() + index * compressed.stride;
+    PackedVertex v{};
+    std::memcpy(&v, packed, sizeof(v));
+
+    out.position = compressed.positionOffset + glm::vec3(
+        dequantize_unorm16(v.position[0]),
+        dequantize_unorm16(v.position[1]),
+        dequantize_unorm16(v.position[2])) * compressed.positionScale;
+    out.normal = oct_decode(glm::vec2(dequantize_snorm16(v.normal[0]), dequantize_snorm16(v.normal[1])));
+    out.tangent = oct_decode(glm::vec2(dequantize_snorm16(v.tangent[0]), dequantize_snorm16(v.tangent[1])));
+    const float sign = dequantize_unorm16(v.position[3]) > 0.5f ? 1.0f : -1.0f;
+    out.bitangent = glm::cross(out.normal, out.tangent) * sign;
+    out.texCoord = glm::vec2(half_to_float(v.texCoord[0]), half_to_float(v.texCoord[1]));
+
+    for (int k = 0; k < 4; k++) {
+        out.joints[k] = -1;
+        out.weights[k] = 0.0f;
+        if (compressed.jointBytes == 1) {
+            out.joints[k] = packed[compressed.jointOffset + k];
+        } else if (compressed.jointBytes == 2) {
+            uint16_t joint;
+            std::memcpy(&joint, packed + compressed.jointOffset + k * 2, sizeof(joint));
+            out.joints[k] = joint;
+        }
+        if (compressed.jointBytes) {
+            out.weights[k] = dequantize_unorm8(packed[compressed.weightOffset + k]);
+        }
+    }
+}
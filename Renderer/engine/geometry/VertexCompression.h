@@ -0,0 +1,88 @@
+#ifndef _VERTEX_COMPRESSION_H_
+#define _VERTEX_COMPRESSION_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Where each attribute sits inside an interleaved full-precision vertex, in bytes
+ *
+ * Missing attributes are `kAbsent`. Joints are four ints (negative = unused slot), weights
+ * four floats, as in SkinningLayout.
+ */
+struct VertexSourceLayout {
+    static constexpr size_t kAbsent = SIZE_MAX;
+
+    size_t stride;
+    size_t position;
+    size_t normal = kAbsent;
+    size_t texCoord = kAbsent;
+    size_t tangent = kAbsent;
+    size_t bitangent = kAbsent;
+    size_t joints = kAbsent;
+    size_t weights = kAbsent;
+};
+
+/**
+ * @brief The fixed 20-byte part of a compressed vertex
+ *
+ *   position  unorm16x4   xyz inside the mesh bounds, w = bitangent sign (0 -> -1, 1 -> +1)
+ *   normal    snorm16x2   octahedral
+ *   tangent   snorm16x2   octahedral, the bitangent is cross(normal, tangent) * sign
+ *   texCoord  half2
+ *
+ * Skinned meshes append joints (u8x4, or u16x4 past 256 joints) and unorm8x4 weights.
+ */
+struct PackedVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    int16_t tangent[2];
+    uint16_t texCoord[2];
+};
+
+/**
+ * @brief A compressed vertex buffer and what the shader needs to decode it
+ *
+ * Decode: position = positionOffset + aPos.xyz * positionScale.
+ */
+struct CompressedVertices {
+    std::vector<uint8_t> data;
+    size_t count = 0;
+    size_t stride = sizeof(PackedVertex);
+    size_t jointBytes = 0;              // per joint index: 0 (not skinned), 1 or 2
+    size_t jointOffset = 0;
+    size_t weightOffset = 0;
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(0.0f);
+
+    bool skinned() const { return jointBytes != 0; }
+};
+
+/// Full-precision attributes of one vertex, as decoded by the compressed-vertex shader path
+struct DecodedVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+    glm::vec2 texCoord;
+    int joints[4];
+    float weights[4];
+};
+
+/**
+ * @brief Quantizes `count` interleaved vertices
+ *
+ * Positions are quantized against the vertices' own AABB. Joints and weights are only
+ * stored when `layout` has them and some vertex actually has a weight.
+ */
+void compress_vertices(const void* vertices, size_t count, const VertexSourceLayout& layout, CompressedVertices& out);
+
+/**
+ * @brief CPU mirror of the shader decode, for validation
+ */
+void decompress_vertex(const CompressedVertices& compressed, size_t index, DecodedVertex& out);
+
+#endif // !_VERTEX_COMPRESSION_H_
@@ -0,0 +1,571 @@
+#include "BatchMath.h"
+
+#include <atomic>
+#include <cmath>
+
+#include "../scene/Components.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BATCH_MATH_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BATCH_MATH_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define BATCH_MATH_AVX2
+#endif
+
+// the kernels read and write glm types as plain float arrays
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "glm::mat4 must be 16 packed floats");
+static_assert(sizeof(glm::vec4) == 4 * sizeof(float), "glm::vec4 must be 4 packed floats");
+static_assert(sizeof(glm::quat) == 4 * sizeof(float), "glm::quat must be 4 packed floats (x, y, z, w)");
+
+static SimdLevel detect_simd_level() {
+#ifdef BATCH_MATH_X86
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    // SSE2 is part of every x86-64 CPU
+    return SimdLevel::SSE;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+static std::atomic<SimdLevel>& current_level() {
+    static std::atomic<SimdLevel> level(detect_simd_level());
+    return level;
+}
+
+SimdLevel simd_level() {
+    return current_level().load(std::memory_order_relaxed);
+}
+
+SimdLevel simd_supported() {
+    static const SimdLevel supported = detect_simd_level();
+    return supported;
+}
+
+SimdLevel set_simd_level(SimdLevel level) {
+    if ((uint8_t)level > (uint8_t)simd_supported()) {
+        level = simd_supported();
+    }
+    current_level().store(level, std::memory_order_relaxed);
+    return level;
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::SSE: return "SSE";
+    case SimdLevel::AVX2: return "AVX2";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------------------
+// scalar
+
+static void scalar_mat4_mul(const glm::mat4* a, size_t aStride, const glm::mat4* b, glm::mat4* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = a[i * aStride] * b[i];
+    }
+}
+
+static void scalar_mat4_transform(const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = m * in[i];
+    }
+}
+
+static void scalar_quat_nlerp(const glm::quat* a, const glm::quat* b, float t, glm::quat* out, size_t count) {
+    const float s = 1.0f - t;
+    for (size_t i = 0; i < count; i++) {
+        glm::quat q(a[i].w * s + b[i].w * t, a[i].x * s + b[i].x * t, a[i].y * s + b[i].y * t, a[i].z * s + b[i].z * t);
+        float inverseLength = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        out[i] = glm::quat(q.w * inverseLength, q.x * inverseLength, q.y * inverseLength, q.z * inverseLength);
+    }
+}
+
+static void scalar_compose(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                           glm::mat4* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = compose_transform(positions ? positions[i] : glm::vec3(0.0f), rotations[i],
+                                   scales ? scales[i] : glm::vec3(1.0f));
+    }
+}
+
+static void scalar_aabb(const glm::mat4* worlds, const uint32_t* worldIndices, const glm::vec3* centers,
+                        const glm::vec3* extents, glm::vec3* mins, glm::vec3* maxs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint32_t w = worldIndices ? worldIndices[i] : (uint32_t)i;
+        if (w == kNoWorld) {
+            mins[i] = centers[i] - extents[i];
+            maxs[i] = centers[i] + extents[i];
+            continue;
+        }
+
+        const glm::mat4& world = worlds[w];
+        glm::vec3 center(world[3]);
+        glm::vec3 extent(0.0f);
+        for (int column = 0; column < 3; column++) {
+            center += glm::vec3(world[column]) * centers[i][column];
+            extent += glm::abs(glm::vec3(world[column])) * extents[i][column];
+        }
+        mins[i] = center - extent;
+        maxs[i] = center + extent;
+    }
+}
+
+#ifdef BATCH_MATH_X86
+
+// ---------------------------------------------------------------------------------------
+// SSE, one matrix (or vector, or box) per iteration; quaternions four at a time
+
+#define SPLAT(v, i) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(i, i, i, i))
+
+static inline __m128 sse_combine(__m128 c0, __m128 c1, __m128 c2, __m128 c3, __m128 v) {
+    __m128 r = _mm_mul_ps(c0, SPLAT(v, 0));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, SPLAT(v, 1)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, SPLAT(v, 2)));
+    return _mm_add_ps(r, _mm_mul_ps(c3, SPLAT(v, 3)));
+}
+
+static void sse_mat4_mul(const glm::mat4* a, size_t aStride, const glm::mat4* b, glm::mat4* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float* pa = &a[i * aStride][0][0];
+        const float* pb = &b[i][0][0];
+        float* po = &out[i][0][0];
+
+        __m128 a0 = _mm_loadu_ps(pa), a1 = _mm_loadu_ps(pa + 4), a2 = _mm_loadu_ps(pa + 8), a3 = _mm_loadu_ps(pa + 12);
+        __m128 b0 = _mm_loadu_ps(pb), b1 = _mm_loadu_ps(pb + 4), b2 = _mm_loadu_ps(pb + 8), b3 = _mm_loadu_ps(pb + 12);
+        _mm_storeu_ps(po, sse_combine(a0, a1, a2, a3, b0));
+        _mm_storeu_ps(po + 4, sse_combine(a0, a1, a2, a3, b1));
+        _mm_storeu_ps(po + 8, sse_combine(a0, a1, a2, a3, b2));
+        _mm_storeu_ps(po + 12, sse_combine(a0, a1, a2, a3, b3));
+    }
+}
+
+static void sse_mat4_transform(const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count) {
+    const float* pm = &m[0][0];
+    __m128 c0 = _mm_loadu_ps(pm), c1 = _mm_loadu_ps(pm + 4), c2 = _mm_loadu_ps(pm + 8), c3 = _mm_loadu_ps(pm + 12);
+    for (size_t i = 0; i < count; i++) {
+        _mm_storeu_ps(&out[i][0], sse_combine(c0, c1, c2, c3, _mm_loadu_ps(&in[i][0])));
+    }
+}
+
+static void sse_quat_nlerp(const glm::quat* a, const glm::quat* b, float t, glm::quat* out, size_t count) {
+    const __m128 wa = _mm_set1_ps(1.0f - t);
+    const __m128 wb = _mm_set1_ps(t);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 q[4];
+        for (int k = 0; k < 4; k++) {
+            q[k] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&a[i + k].x), wa), _mm_mul_ps(_mm_loadu_ps(&b[i + k].x), wb));
+        }
+
+        // four squared lengths at once: square, transpose, add the rows
+        __m128 s0 = _mm_mul_ps(q[0], q[0]), s1 = _mm_mul_ps(q[1], q[1]), s2 = _mm_mul_ps(q[2], q[2]), s3 = _mm_mul_ps(q[3], q[3]);
+        _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+        __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3))));
+
+        _mm_storeu_ps(&out[i].x, _mm_mul_ps(q[0], SPLAT(inverseLength, 0)));
+        _mm_storeu_ps(&out[i + 1].x, _mm_mul_ps(q[1], SPLAT(inverseLength, 1)));
+        _mm_storeu_ps(&out[i + 2].x, _mm_mul_ps(q[2], SPLAT(inverseLength, 2)));
+        _mm_storeu_ps(&out[i + 3].x, _mm_mul_ps(q[3], SPLAT(inverseLength, 3)));
+    }
+
+    scalar_quat_nlerp(a + i, b + i, t, out + i, count - i);
+}
+
+// rotation * scale terms of four transforms, laid out one lane per transform
+struct Compose4 {
+    __m128 m00, m01, m02, m10, m11, m12, m20, m21, m22;
+};
+
+static inline Compose4 sse_rotation4(__m128 x, __m128 y, __m128 z, __m128 w, __m128 sx, __m128 sy, __m128 sz) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+    Compose4 r;
+    r.m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+    r.m01 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+    r.m02 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+    r.m10 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+    r.m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+    r.m12 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+    r.m20 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+    r.m21 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+    r.m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+    return r;
+}
+
+static void sse_compose(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                        glm::mat4* out, size_t count)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // xyzw per quaternion -> one register per component
+        __m128 x = _mm_loadu_ps(&rotations[i].x);
+        __m128 y = _mm_loadu_ps(&rotations[i + 1].x);
+        __m128 z = _mm_loadu_ps(&rotations[i + 2].x);
+        __m128 w = _mm_loadu_ps(&rotations[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        __m128 sx = one, sy = one, sz = one;
+        if (scales) {
+            const glm::vec3* s = scales + i;
+            sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+            sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+            sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+        }
+
+        __m128 px = zero, py = zero, pz = zero;
+        if (positions) {
+            const glm::vec3* p = positions + i;
+            px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+            py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+            pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+        }
+
+        Compose4 r = sse_rotation4(x, y, z, w, sx, sy, sz);
+
+        // and back: one register per column of each matrix
+        __m128 c0 = r.m00, c1 = r.m01, c2 = r.m02, c3 = zero;
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(&out[i][0][0], c0);
+        _mm_storeu_ps(&out[i + 1][0][0], c1);
+        _mm_storeu_ps(&out[i + 2][0][0], c2);
+        _mm_storeu_ps(&out[i + 3][0][0], c3);
+
+        c0 = r.m10; c1 = r.m11; c2 = r.m12; c3 = zero;
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(&out[i][1][0], c0);
+        _mm_storeu_ps(&out[i + 1][1][0], c1);
+        _mm_storeu_ps(&out[i + 2][1][0], c2);
+        _mm_storeu_ps(&out[i + 3][1][0], c3);
+
+        c0 = r.m20; c1 = r.m21; c2 = r.m22; c3 = zero;
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(&out[i][2][0], c0);
+        _mm_storeu_ps(&out[i + 1][2][0], c1);
+        _mm_storeu_ps(&out[i + 2][2][0], c2);
+        _mm_storeu_ps(&out[i + 3][2][0], c3);
+
+        c0 = px; c1 = py; c2 = pz; c3 = one;
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(&out[i][3][0], c0);
+        _mm_storeu_ps(&out[i + 1][3][0], c1);
+        _mm_storeu_ps(&out[i + 2][3][0], c2);
+        _mm_storeu_ps(&out[i + 3][3][0], c3);
+    }
+
+    scalar_compose(positions ? positions + i : nullptr, rotations + i, scales ? scales + i : nullptr, out + i, count - i);
+}
+
+static inline __m128 sse_abs(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+static inline void store_vec3(glm::vec3& out, __m128 v) {
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    out = glm::vec3(lanes[0], lanes[1], lanes[2]);
+}
+
+static void sse_aabb(const glm::mat4* worlds, const uint32_t* worldIndices, const glm::vec3* centers,
+                     const glm::vec3* extents, glm::vec3* mins, glm::vec3* maxs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint32_t w = worldIndices ? worldIndices[i] : (uint32_t)i;
+        if (w == kNoWorld) {
+            mins[i] = centers[i] - extents[i];
+            maxs[i] = centers[i] + extents[i];
+            continue;
+        }
+
+        const float* pw = &worlds[w][0][0];
+        __m128 c0 = _mm_loadu_ps(pw), c1 = _mm_loadu_ps(pw + 4), c2 = _mm_loadu_ps(pw + 8), c3 = _mm_loadu_ps(pw + 12);
+
+        const glm::vec3& c = centers[i];
+        const glm::vec3& e = extents[i];
+        __m128 center = _mm_add_ps(c3, _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(c.x)),
+                                   _mm_add_ps(_mm_mul_ps(c1, _mm_set1_ps(c.y)), _mm_mul_ps(c2, _mm_set1_ps(c.z)))));
+        __m128 extent = _mm_add_ps(_mm_mul_ps(sse_abs(c0), _mm_set1_ps(e.x)),
+                        _mm_add_ps(_mm_mul_ps(sse_abs(c1), _mm_set1_ps(e.y)), _mm_mul_ps(sse_abs(c2), _mm_set1_ps(e.z))));
+
+        store_vec3(mins[i], _mm_sub_ps(center, extent));
+        store_vec3(maxs[i], _mm_add_ps(center, extent));
+    }
+}
+
+#undef SPLAT
+
+// ---------------------------------------------------------------------------------------
+// AVX2 + FMA: two columns or vectors per 256-bit register (one per 128-bit lane),
+// quaternions eight at a time. The in-lane shuffles broadcast a component per lane.
+
+#define SPLAT8(v, i) _mm256_shuffle_ps((v), (v), _MM_SHUFFLE(i, i, i, i))
+
+BATCH_MATH_AVX2
+static inline __m256 avx_combine(__m256 c0, __m256 c1, __m256 c2, __m256 c3, __m256 v) {
+    __m256 r = _mm256_mul_ps(c0, SPLAT8(v, 0));
+    r = _mm256_fmadd_ps(c1, SPLAT8(v, 1), r);
+    r = _mm256_fmadd_ps(c2, SPLAT8(v, 2), r);
+    return _mm256_fmadd_ps(c3, SPLAT8(v, 3), r);
+}
+
+BATCH_MATH_AVX2
+static void avx2_mat4_mul(const glm::mat4* a, size_t aStride, const glm::mat4* b, glm::mat4* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float* pa = &a[i * aStride][0][0];
+        const float* pb = &b[i][0][0];
+        float* po = &out[i][0][0];
+
+        // a's columns in both lanes, b's columns two per register
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)pa);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)(pa + 4));
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)(pa + 8));
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)(pa + 12));
+        __m256 b01 = _mm256_loadu_ps(pb);
+        __m256 b23 = _mm256_loadu_ps(pb + 8);
+
+        _mm256_storeu_ps(po, avx_combine(a0, a1, a2, a3, b01));
+        _mm256_storeu_ps(po + 8, avx_combine(a0, a1, a2, a3, b23));
+    }
+}
+
+BATCH_MATH_AVX2
+static void avx2_mat4_transform(const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count) {
+    const float* pm = &m[0][0];
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)pm);
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)(pm + 4));
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)(pm + 8));
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)(pm + 12));
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 v01 = _mm256_loadu_ps(&in[i][0]);
+        __m256 v23 = _mm256_loadu_ps(&in[i + 2][0]);
+        _mm256_storeu_ps(&out[i][0], avx_combine(c0, c1, c2, c3, v01));
+        _mm256_storeu_ps(&out[i + 2][0], avx_combine(c0, c1, c2, c3, v23));
+    }
+    for (; i < count; i++) {
+        __m256 v = _mm256_castps128_ps256(_mm_loadu_ps(&in[i][0]));
+        _mm_storeu_ps(&out[i][0], _mm256_castps256_ps128(avx_combine(c0, c1, c2, c3, v)));
+    }
+}
+
+/// _MM_TRANSPOSE4_PS on each 128-bit lane
+BATCH_MATH_AVX2
+static inline void avx_transpose_lanes(__m256& a, __m256& b, __m256& c, __m256& d) {
+    __m256 t0 = _mm256_unpacklo_ps(a, b);
+    __m256 t1 = _mm256_unpacklo_ps(c, d);
+    __m256 t2 = _mm256_unpackhi_ps(a, b);
+    __m256 t3 = _mm256_unpackhi_ps(c, d);
+    a = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    b = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    c = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    d = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+/// Transposes four lane-per-transform registers and stores column `column` of eight matrices
+BATCH_MATH_AVX2
+static inline void avx_store_columns(glm::mat4* out, int column, __m256 a, __m256 b, __m256 c, __m256 d) {
+    avx_transpose_lanes(a, b, c, d);
+    const __m256 columns[4] = { a, b, c, d };
+    for (int k = 0; k < 4; k++) {
+        _mm_storeu_ps(&out[k][column][0], _mm256_castps256_ps128(columns[k]));
+        _mm_storeu_ps(&out[k + 4][column][0], _mm256_extractf128_ps(columns[k], 1));
+    }
+}
+
+BATCH_MATH_AVX2
+static inline __m256 avx_pair(const float* low, const float* high) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+BATCH_MATH_AVX2
+static inline void avx_store_pair(float* low, float* high, __m256 v) {
+    _mm_storeu_ps(low, _mm256_castps256_ps128(v));
+    _mm_storeu_ps(high, _mm256_extractf128_ps(v, 1));
+}
+
+BATCH_MATH_AVX2
+static void avx2_quat_nlerp(const glm::quat* a, const glm::quat* b, float t, glm::quat* out, size_t count) {
+    const __m256 wa = _mm256_set1_ps(1.0f - t);
+    const __m256 wb = _mm256_set1_ps(t);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // quaternions k and k + 4 share a register
+        __m256 q[4];
+        for (int k = 0; k < 4; k++) {
+            __m256 qa = avx_pair(&a[i + k].x, &a[i + k + 4].x);
+            __m256 qb = avx_pair(&b[i + k].x, &b[i + k + 4].x);
+            q[k] = _mm256_fmadd_ps(qa, wa, _mm256_mul_ps(qb, wb));
+        }
+
+        __m256 s0 = _mm256_mul_ps(q[0], q[0]), s1 = _mm256_mul_ps(q[1], q[1]), s2 = _mm256_mul_ps(q[2], q[2]), s3 = _mm256_mul_ps(q[3], q[3]);
+        avx_transpose_lanes(s0, s1, s2, s3);
+        __m256 inverseLength = _mm256_div_ps(_mm256_set1_ps(1.0f),
+            _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3))));
+
+        avx_store_pair(&out[i].x, &out[i + 4].x, _mm256_mul_ps(q[0], SPLAT8(inverseLength, 0)));
+        avx_store_pair(&out[i + 1].x, &out[i + 5].x, _mm256_mul_ps(q[1], SPLAT8(inverseLength, 1)));
+        avx_store_pair(&out[i + 2].x, &out[i + 6].x, _mm256_mul_ps(q[2], SPLAT8(inverseLength, 2)));
+        avx_store_pair(&out[i + 3].x, &out[i + 7].x, _mm256_mul_ps(q[3], SPLAT8(inverseLength, 3)));
+    }
+
+    sse_quat_nlerp(a + i, b + i, t, out + i, count - i);
+}
+
+BATCH_MATH_AVX2
+static void avx2_compose(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                         glm::mat4* out, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // lane 0 holds transforms i..i+3, lane 1 transforms i+4..i+7
+        const glm::quat* q = rotations + i;
+        __m256 x = avx_pair(&q[0].x, &q[4].x);
+        __m256 y = avx_pair(&q[1].x, &q[5].x);
+        __m256 z = avx_pair(&q[2].x, &q[6].x);
+        __m256 w = avx_pair(&q[3].x, &q[7].x);
+        avx_transpose_lanes(x, y, z, w);
+
+        __m256 sx = one, sy = one, sz = one;
+        if (scales) {
+            const glm::vec3* s = scales + i;
+            sx = _mm256_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x, s[4].x, s[5].x, s[6].x, s[7].x);
+            sy = _mm256_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y, s[4].y, s[5].y, s[6].y, s[7].y);
+            sz = _mm256_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z, s[4].z, s[5].z, s[6].z, s[7].z);
+        }
+
+        __m256 px = zero, py = zero, pz = zero;
+        if (positions) {
+            const glm::vec3* p = positions + i;
+            px = _mm256_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x, p[4].x, p[5].x, p[6].x, p[7].x);
+            py = _mm256_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y, p[4].y, p[5].y, p[6].y, p[7].y);
+            pz = _mm256_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z, p[4].z, p[5].z, p[6].z, p[7].z);
+        }
+
+        __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+        __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+        __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+        avx_store_columns(out + i, 0,
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+            zero);
+        avx_store_columns(out + i, 1,
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+            zero);
+        avx_store_columns(out + i, 2,
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz),
+            zero);
+        avx_store_columns(out + i, 3, px, py, pz, one);
+    }
+
+    sse_compose(positions ? positions + i : nullptr, rotations + i, scales ? scales + i : nullptr, out + i, count - i);
+}
+
+#undef SPLAT8
+
+#endif // BATCH_MATH_X86
+
+// ---------------------------------------------------------------------------------------
+// dispatch
+
+void mat4_mul_batch(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count) {
+    switch (simd_level()) {
+#ifdef BATCH_MATH_X86
+    case SimdLevel::AVX2: avx2_mat4_mul(a, 1, b, out, count); return;
+    case SimdLevel::SSE: sse_mat4_mul(a, 1, b, out, count); return;
+#endif
+    default: scalar_mat4_mul(a, 1, b, out, count); return;
+    }
+}
+
+void mat4_mul_batch(const glm::mat4& a, const glm::mat4* b, glm::mat4* out, size_t count) {
+    switch (simd_level()) {
+#ifdef BATCH_MATH_X86
+    case SimdLevel::AVX2: avx2_mat4_mul(&a, 0, b, out, count); return;
+    case SimdLevel::SSE: sse_mat4_mul(&a, 0, b, out, count); return;
+#endif
+    default: scalar_mat4_mul(&a, 0, b, out, count); return;
+    }
+}
+
+void mat4_transform_batch(const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count) {
+    switch (simd_level()) {
+#ifdef BATCH_MATH_X86
+    case SimdLevel::AVX2: avx2_mat4_transform(m, in, out, count); return;
+    case SimdLevel::SSE: sse_mat4_transform(m, in, out, count); return;
+#endif
+    default: scalar_mat4_transform(m, in, out, count); return;
+    }
+}
+
+void quat_nlerp_batch(const glm::quat* a, const glm::quat* b, float t, glm::quat* out, size_t count) {
+    switch (simd_level()) {
+#ifdef BATCH_MATH_X86
+    case SimdLevel::AVX2: avx2_quat_nlerp(a, b, t, out, count); return;
+    case SimdLevel::SSE: sse_quat_nlerp(a, b, t, out, count); return;
+#endif
+    default: scalar_quat_nlerp(a, b, t, out, count); return;
+    }
+}
+
+void quat_to_mat4_batch(const glm::quat* rotations, glm::mat4* out, size_t count) {
+    compose_transform_batch(nullptr, rotations, nullptr, out, count);
+}
+
+void compose_transform_batch(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                             glm::mat4* out, size_t count)
+{
+    switch (simd_level()) {
+#ifdef BATCH_MATH_X86
+    case SimdLevel::AVX2: avx2_compose(positions, rotations, scales, out, count); return;
+    case SimdLevel::SSE: sse_compose(positions, rotations, scales, out, count); return;
+#endif
+    default: scalar_compose(positions, rotations, scales, out, count); return;
+    }
+}
+
+void aabb_transform_batch(const glm::mat4* worlds, const uint32_t* worldIndices,
+                          const glm::vec3* centers, const glm::vec3* extents,
+                          glm::vec3* mins, glm::vec3* maxs, size_t count)
+{
+    switch (simd_level()) {
+#ifdef BATCH_MATH_X86
+    // AVX2 runs the SSE kernel: packing two boxes per 256-bit register costs more in shuffles than it saves
+    case SimdLevel::AVX2:
+    case SimdLevel::SSE: sse_aabb(worlds, worldIndices, centers, extents, mins, maxs, count); return;
+#endif
+    default: scalar_aabb(worlds, worldIndices, centers, extents, mins, maxs, count); return;
+    }
+}
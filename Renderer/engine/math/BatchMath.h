@@ -0,0 +1,75 @@
+#ifndef _BATCH_MATH_H_
+#define _BATCH_MATH_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Transform math over arrays
+ *
+ * Each function has a scalar version and, on x86, SSE and AVX2 (+FMA) kernels. The
+ * widest level the CPU supports is picked on first use; `set_simd_level` forces a lower
+ * one, which is how the benchmark compares them. Results match glm to within float
+ * rounding (FMA contracts a few products), not bit for bit.
+ *
+ * Arrays do not need any particular alignment and must not overlap unless noted.
+ */
+
+enum class SimdLevel : uint8_t {
+    Scalar,
+    SSE,
+    AVX2
+};
+
+/// Level the kernels currently run at
+SimdLevel simd_level();
+
+/// Widest level this CPU supports
+SimdLevel simd_supported();
+
+/// Selects a level, clamped to what the CPU supports; returns the level in use
+SimdLevel set_simd_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
+
+/// out[i] = a[i] * b[i]
+void mat4_mul_batch(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count);
+
+/// out[i] = a * b[i], e.g. projection * view * world for every instance
+void mat4_mul_batch(const glm::mat4& a, const glm::mat4* b, glm::mat4* out, size_t count);
+
+/// out[i] = m * in[i]; `out` may be `in`
+void mat4_transform_batch(const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count);
+
+/// Rotation matrices of unit quaternions
+void quat_to_mat4_batch(const glm::quat* rotations, glm::mat4* out, size_t count);
+
+/**
+ * @brief out[i] = normalize(mix(a[i], b[i], t)); `out` may be `a` or `b`
+ *
+ * Normalized lerp, the caller keeps a[i] and b[i] in the same hemisphere. For the short
+ * steps between animation samples it is indistinguishable from slerp.
+ */
+void quat_nlerp_batch(const glm::quat* a, const glm::quat* b, float t, glm::quat* out, size_t count);
+
+/// compose_transform (T * R * S) over arrays
+void compose_transform_batch(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+                             glm::mat4* out, size_t count);
+
+/// `aabb_transform_batch` index for boxes that have no world matrix
+constexpr uint32_t kNoWorld = UINT32_MAX;
+
+/**
+ * @brief World-space boxes of local center/extents boxes (Arvo's method)
+ *
+ * Box i uses worlds[worldIndices[i]], or worlds[i] when `worldIndices` is null; an index
+ * of kNoWorld leaves the box untransformed.
+ */
+void aabb_transform_batch(const glm::mat4* worlds, const uint32_t* worldIndices,
+                          const glm::vec3* centers, const glm::vec3* extents,
+                          glm::vec3* mins, glm::vec3* maxs, size_t count);
+
+#endif // !_BATCH_MATH_H_
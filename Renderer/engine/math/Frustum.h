@@ -0,0 +1,67 @@
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+/**
+ * @brief The six clip planes of a view-projection matrix
+ *
+ * Planes are (n, d) with n pointing inside, normalized so `dot(n, p) + d` is a distance.
+ * Extracted from `projection * view * model` they are in model space, which lets culling
+ * work on local bounds without transforming them.
+ */
+struct Frustum {
+    enum { Left, Right, Bottom, Top, Near, Far };
+
+    glm::vec4 planes[6];
+
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& m) {
+        // Gribb/Hartmann: rows of the matrix, GL clip space -w <= x, y, z <= w
+        const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        planes[Left] = row3 + row0;
+        planes[Right] = row3 - row0;
+        planes[Bottom] = row3 + row1;
+        planes[Top] = row3 - row1;
+        planes[Near] = row3 + row2;
+        planes[Far] = row3 - row2;
+
+        for (glm::vec4& plane : planes) {
+            const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+            if (length > 0.0f) {
+                plane = plane / length;
+            }
+        }
+    }
+
+    /// False only when the sphere is entirely outside one plane
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& plane : planes) {
+            if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// False only when the box is entirely outside one plane
+    bool intersectsBox(const glm::vec3& lo, const glm::vec3& hi) const {
+        for (const glm::vec4& plane : planes) {
+            // the corner furthest along the plane normal
+            const glm::vec3 p(plane.x >= 0.0f ? hi.x : lo.x, plane.y >= 0.0f ? hi.y : lo.y, plane.z >= 0.0f ? hi.z : lo.z);
+            if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif // !_FRUSTUM_H_
@@ -0,0 +1,209 @@
+#ifndef _QUANTIZE_H_
+#define _QUANTIZE_H_
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Scalar encoders/decoders for compact vertex attributes
+ *
+ * The decoders mirror what the GL does for normalized integer and half-float attributes, so
+ * the CPU can check exactly what a shader will see.
+ */
+
+inline uint16_t quantize_unorm16(float v) {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint16_t)(v * 65535.0f + 0.5f);
+}
+
+inline float dequantize_unorm16(uint16_t v) {
+    return v / 65535.0f;
+}
+
+inline int16_t quantize_snorm16(float v) {
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int16_t)std::lround(v * 32767.0f);
+}
+
+/// GL 4.2+ rule: c / 32767, clamped so -32768 also maps to -1
+inline float dequantize_snorm16(int16_t v) {
+    float f = v / 32767.0f;
+    return f < -1.0f ? -1.0f : f;
+}
+
+inline uint8_t quantize_unorm8(float v) {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+inline float dequantize_unorm8(uint8_t v) {
+    return v / 255.0f;
+}
+
+/**
+ * @brief IEEE binary16 from a float, round to nearest even
+ *
+ * Overflow goes to infinity, values below the smallest subnormal to signed zero.
+ */
+inline uint16_t float_to_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu) {
+        // inf stays inf, NaN stays a (quiet) NaN
+        return (uint16_t)(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+
+    const int halfExponent = (int)exponent - 127 + 15;
+    if (halfExponent >= 0x1f) {
+        return (uint16_t)(sign | 0x7c00u);
+    }
+
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) {
+            return (uint16_t)sign;
+        }
+        // subnormal: shift the implicit bit in, then round
+        mantissa |= 0x800000u;
+        const uint32_t shift = (uint32_t)(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) {
+            half++;
+        }
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;     // may carry into the exponent, which is still the right answer
+    }
+    return (uint16_t)(sign | half);
+}
+
+inline float half_to_float(uint16_t half) {
+    const uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1fu;
+    const uint32_t mantissa = half & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // subnormal half, normal float
+            float f = mantissa / 16777216.0f;   // mantissa * 2^-24
+            return sign ? -f : f;
+        }
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Unit vector to the [-1, 1]^2 octahedral square
+ *
+ * Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the
+ * diagonals. A zero vector encodes as (0, 0), which decodes to +Z.
+ */
+inline glm::vec2 oct_encode(const glm::vec3& n) {
+    const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (l1 == 0.0f) {
+        return glm::vec2(0.0f);
+    }
+
+    glm::vec2 p(n.x / l1, n.y / l1);
+    if (n.z < 0.0f) {
+        const float x = p.x, y = p.y;
+        p.x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        p.y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return p;
+}
+
+inline glm::vec3 oct_decode(const glm::vec2& e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    const float t = n.z < 0.0f ? -n.z : 0.0f;
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+/**
+ * @brief Octahedral snorm16x2 encoding that picks the best of the neighbouring codes
+ *
+ * Plain rounding is off by up to one code per axis after the fold; trying the four
+ * floor/ceil combinations and keeping the one that decodes closest halves the worst case.
+ * A zero vector, a missing tangent in practice, encodes as (0, 0) like `oct_encode`.
+ */
+inline void oct_encode_snorm16(const glm::vec3& n, int16_t out[2]) {
+    // NaN fails the comparison too, nothing would decode closer than the initial best
+    if (!(std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z) > 0.0f)) {
+        out[0] = out[1] = 0;
+        return;
+    }
+
+    const glm::vec2 e = oct_encode(n);
+    const float fx = std::floor(e.x * 32767.0f), fy = std::floor(e.y * 32767.0f);
+    const glm::vec3 unit = glm::normalize(n);
+
+    float best = -2.0f;
+    for (int i = 0; i < 4; i++) {
+        const float cx = fx + (float)(i & 1);
+        const float cy = fy + (float)(i >> 1);
+        const int16_t qx = (int16_t)glm::clamp(cx, -32767.0f, 32767.0f);
+        const int16_t qy = (int16_t)glm::clamp(cy, -32767.0f, 32767.0f);
+        const float d = glm::dot(unit, oct_decode(glm::vec2(dequantize_snorm16(qx), dequantize_snorm16(qy))));
+        if (d > best) {
+            best = d;
+            out[0] = qx;
+            out[1] = qy;
+        }
+    }
+}
+
+/**
+ * @brief Four weights to unorm8 summing to exactly 255
+ *
+ * Rounding each weight on its own can leave the sum at 254 or 256, which shows up as a
+ * vertex shrinking towards the origin; the remainder goes to the largest weight.
+ */
+inline void quantize_weights_unorm8(const float weights[4], uint8_t out[4]) {
+    float total = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        total += weights[i] > 0.0f ? weights[i] : 0.0f;
+    }
+    if (total <= 0.0f) {
+        out[0] = out[1] = out[2] = out[3] = 0;
+        return;
+    }
+
+    int sum = 0;
+    int largest = 0;
+    for (int i = 0; i < 4; i++) {
+        const float w = weights[i] > 0.0f ? weights[i] / total : 0.0f;
+        out[i] = (uint8_t)(w * 255.0f + 0.5f);
+        sum += out[i];
+        if (weights[i] > weights[largest]) {
+            largest = i;
+        }
+    }
+    out[largest] = (uint8_t)(out[largest] + (255 - sum));
+}
+
+#endif // !_QUANTIZE_H_
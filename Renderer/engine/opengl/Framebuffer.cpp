@@ -0,0 +1,191 @@
+#include "Framebuffer.h"
+
+#include <utility>
+
+Framebuffer::Framebuffer()
+    : m_id(0), m_colorTextures(), m_depthTexture(0), m_config{ 0, 0, {}, false, GL_DEPTH_COMPONENT24 }
+{}
+
+Framebuffer::Framebuffer(const FramebufferConfig& config)
+    : Framebuffer()
+{
+    create(config);
+}
+
+Framebuffer::Framebuffer(Framebuffer&& other)
+    : Framebuffer()
+{
+    *this = std::move(other);
+}
+
+Framebuffer::~Framebuffer() {
+    destroy();
+}
+
+Framebuffer& Framebuffer::operator=(Framebuffer&& other) {
+    if (this != &other) {
+        destroy();
+        m_id = std::exchange(other.m_id, 0);
+        m_colorTextures = std::move(other.m_colorTextures);
+        m_depthTexture = std::exchange(other.m_depthTexture, 0);
+        m_config = other.m_config;
+        other.m_colorTextures.clear();
+    }
+    return *this;
+}
+
+static void depth_transfer_format(GLenum internalFormat, GLenum& format, GLenum& type, GLenum& attachment) {
+    switch (internalFormat)
+    {
+    case GL_DEPTH24_STENCIL8:
+        format = GL_DEPTH_STENCIL;
+        type = GL_UNSIGNED_INT_24_8;
+        attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+        break;
+    case GL_DEPTH_COMPONENT32F:
+        format = GL_DEPTH_COMPONENT;
+        type = GL_FLOAT;
+        attachment = GL_DEPTH_ATTACHMENT;
+        break;
+    default:
+        format = GL_DEPTH_COMPONENT;
+        type = GL_UNSIGNED_INT;
+        attachment = GL_DEPTH_ATTACHMENT;
+        break;
+    }
+}
+
+bool Framebuffer::create(const FramebufferConfig& config) {
+    destroy();
+    m_config = config;
+
+    GL_CALL(glGenFramebuffers(1, &m_id));
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, m_id));
+
+    std::vector<GLenum> drawBuffers;
+    m_colorTextures.resize(config.colorAttachments.size(), 0);
+    for (size_t i = 0; i < config.colorAttachments.size(); i++) {
+        const FramebufferAttachment& attachment = config.colorAttachments[i];
+
+        GL_CALL(glGenTextures(1, &m_colorTextures[i]));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, m_colorTextures[i]));
+        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, attachment.internalFormat, config.width, config.height, 0, attachment.format, attachment.type, nullptr));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, attachment.filter));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, attachment.filter));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, GL_TEXTURE_2D, m_colorTextures[i], 0));
+        gl_track_texture(m_colorTextures[i], config.width, config.height, attachment.internalFormat, false);
+
+        drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)i);
+    }
+
+    if (config.depth) {
+        GLenum format, type, attachment;
+        depth_transfer_format(config.depthFormat, format, type, attachment);
+
+        GL_CALL(glGenTextures(1, &m_depthTexture));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, m_depthTexture));
+        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, config.depthFormat, config.width, config.height, 0, format, type, nullptr));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_depthTexture, 0));
+        gl_track_texture(m_depthTexture, config.width, config.height, config.depthFormat, false);
+    }
+
+    if (drawBuffers.empty()) {
+        // depth-only target
+        GL_CALL(glDrawBuffer(GL_NONE));
+        GL_CALL(glReadBuffer(GL_NONE));
+    }
+    else {
+        GL_CALL(glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data()));
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        gl_log_err("Framebuffer %u incomplete: 0x%x\n", m_id, status);
+        return false;
+    }
+
+    GL_LOG("Created framebuffer %u (%dx%d, %zu color attachments)\n", m_id, config.width, config.height, m_colorTextures.size());
+    return true;
+}
+
+void Framebuffer::destroy() {
+    if (!m_colorTextures.empty()) {
+        for (GLuint texture : m_colorTextures) {
+            gl_untrack_texture(texture);
+        }
+        GL_CALL(glDeleteTextures((GLsizei)m_colorTextures.size(), m_colorTextures.data()));
+        m_colorTextures.clear();
+    }
+    if (m_depthTexture) {
+        gl_untrack_texture(m_depthTexture);
+        GL_CALL(glDeleteTextures(1, &m_depthTexture));
+        m_depthTexture = 0;
+    }
+    if (m_id) {
+        GL_CALL(glDeleteFramebuffers(1, &m_id));
+        m_id = 0;
+    }
+}
+
+bool Framebuffer::resize(int width, int height) {
+    if (width == m_config.width && height == m_config.height && m_id) {
+        return true;
+    }
+
+    FramebufferConfig config = m_config;
+    config.width = width;
+    config.height = height;
+    return create(config);
+}
+
+void Framebuffer::bind() const {
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, m_id));
+    GL_CALL(glViewport(0, 0, m_config.width, m_config.height));
+}
+
+void Framebuffer::unbind(GLuint target) const {
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, target));
+}
+
+unsigned int Framebuffer::bytesPerPixel(GLenum internalFormat) {
+    return gl_texel_bytes(internalFormat);
+}
+
+unsigned long Framebuffer::byteSize() const {
+    unsigned long pixels = (unsigned long)m_config.width * (unsigned long)m_config.height;
+    unsigned long bytes = 0;
+    for (const auto& attachment : m_config.colorAttachments) {
+        bytes += pixels * bytesPerPixel(attachment.internalFormat);
+    }
+    if (m_config.depth) {
+        bytes += pixels * bytesPerPixel(m_config.depthFormat);
+    }
+    return bytes;
+}
+
+bool Framebuffer::readPixels(std::vector<unsigned char>& rgba, size_t attachment) const {
+    if (!m_id || attachment >= m_colorTextures.size()) {
+        return false;
+    }
+
+    rgba.resize((size_t)m_config.width * m_config.height * 4);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_id));
+    GL_CALL(glReadBuffer(GL_COLOR_ATTACHMENT0 + (GLenum)attachment));
+    GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GL_CALL(glReadPixels(0, 0, m_config.width, m_config.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data()));
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous));
+
+    return true;
+}
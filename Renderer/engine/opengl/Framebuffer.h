@@ -0,0 +1,108 @@
+#ifndef _FRAMEBUFFER_H_
+#define _FRAMEBUFFER_H_
+
+#include <GL/glew.h>
+
+#include <vector>
+
+#include "utils.h"
+
+struct FramebufferAttachment {
+    GLenum internalFormat;  // sized format, e.g. GL_RGBA8, GL_RGBA16F
+    GLenum format;          // pixel transfer format, e.g. GL_RGBA
+    GLenum type;            // pixel transfer type, e.g. GL_UNSIGNED_BYTE
+    GLenum filter;          // min/mag filter of the attachment texture
+};
+
+struct FramebufferConfig {
+    int width;
+    int height;
+    std::vector<FramebufferAttachment> colorAttachments;
+    bool depth;             // create a depth texture
+    GLenum depthFormat;     // GL_DEPTH_COMPONENT24, GL_DEPTH24_STENCIL8 or GL_DEPTH_COMPONENT32F
+};
+
+/**
+ * @brief Framebuffer object with texture attachments
+ *
+ * Every attachment is a texture, so the result of a pass can be sampled by the next one.
+ * Color attachment `i` is bound to GL_COLOR_ATTACHMENT0 + i and all of them are enabled
+ * as draw buffers.
+ */
+class Framebuffer {
+public:
+    Framebuffer();
+
+    explicit Framebuffer(const FramebufferConfig& config);
+
+    Framebuffer(const Framebuffer& other) = delete;
+
+    Framebuffer(Framebuffer&& other);
+
+    ~Framebuffer();
+
+    Framebuffer& operator=(const Framebuffer& other) = delete;
+
+    Framebuffer& operator=(Framebuffer&& other);
+
+    /**
+     * @brief (Re)creates the framebuffer and its attachments
+     *
+     * @return false if the framebuffer is incomplete
+     */
+    bool create(const FramebufferConfig& config);
+
+    void destroy();
+
+    /**
+     * @brief Recreates the attachments at a new size, keeping their formats
+     */
+    bool resize(int width, int height);
+
+    /**
+     * @brief Binds the framebuffer for drawing and sets the viewport to cover it
+     */
+    void bind() const;
+
+    /**
+     * @brief Binds `target` (the default framebuffer unless told otherwise)
+     */
+    void unbind(GLuint target = 0) const;
+
+    GLuint id() const { return m_id; }
+
+    GLuint colorTexture(size_t index = 0) const { return index < m_colorTextures.size() ? m_colorTextures[index] : 0; }
+
+    size_t colorCount() const { return m_colorTextures.size(); }
+
+    GLuint depthTexture() const { return m_depthTexture; }
+
+    int width() const { return m_config.width; }
+
+    int height() const { return m_config.height; }
+
+    const FramebufferConfig& config() const { return m_config; }
+
+    /// GPU memory used by the attachments, in bytes
+    unsigned long byteSize() const;
+
+    /**
+     * @brief Reads a color attachment back as tightly packed RGBA8, bottom row first
+     */
+    bool readPixels(std::vector<unsigned char>& rgba, size_t attachment = 0) const;
+
+    static FramebufferAttachment rgba8() { return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_LINEAR }; }
+
+    static FramebufferAttachment rgba16f() { return { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, GL_LINEAR }; }
+
+    /// Bytes per pixel of a sized internal format, 4 if unknown
+    static unsigned int bytesPerPixel(GLenum internalFormat);
+
+private:
+    GLuint m_id;
+    std::vector<GLuint> m_colorTextures;
+    GLuint m_depthTexture;
+    FramebufferConfig m_config;
+};
+
+#endif // !_FRAMEBUFFER_H_
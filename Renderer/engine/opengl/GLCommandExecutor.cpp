@@ -0,0 +1,167 @@
+#include "GLCommandExecutor.h"
+
+#include "RenderStats.h"
+#include "../core/Profiler.h"
+
+#include <chrono>
+
+namespace {
+
+GLenum gl_primitive(PrimitiveType primitive) {
+    switch (primitive) {
+    case PrimitiveType::Lines: return GL_LINES;
+    case PrimitiveType::Points: return GL_POINTS;
+    default: return GL_TRIANGLES;
+    }
+}
+
+// the packet snapshots always hold this many texture units
+const unsigned int kTextureUnits = CommandList::kMaxTextureUnits;
+
+}
+
+GLCommandExecutor::GLCommandExecutor()
+    : m_locations(), m_applied(), m_stats()
+{}
+
+GLint GLCommandExecutor::_location(uint32_t program, const UniformValue& uniform) {
+    const uint64_t key = uniform.nameHash ^ ((uint64_t)program * 0x9e3779b97f4a7c15ull);
+    auto found = m_locations.find(key);
+    if (found != m_locations.end()) {
+        return found->second;
+    }
+    const GLint location = glGetUniformLocation(program, uniform.name);
+    m_locations.emplace(key, location);
+    return location;
+}
+
+void GLCommandExecutor::_upload(GLint location, const UniformValue& uniform) {
+    const float* f = static_cast<const float*>(uniform.data);
+    switch (uniform.type) {
+    case UniformType::Int: glUniform1i(location, *static_cast<const int*>(uniform.data)); break;
+    case UniformType::Float: glUniform1f(location, *f); break;
+    case UniformType::Vec2: glUniform2fv(location, 1, f); break;
+    case UniformType::Vec3: glUniform3fv(location, 1, f); break;
+    case UniformType::Vec4: glUniform4fv(location, 1, f); break;
+    case UniformType::Mat3: glUniformMatrix3fv(location, 1, GL_FALSE, f); break;
+    case UniformType::Mat4: glUniformMatrix4fv(location, 1, GL_FALSE, f); break;
+    }
+    m_stats.uniformUploads++;
+}
+
+void GLCommandExecutor::execute(const CommandQueue& queue) {
+    PROFILE_SCOPE("replayCommands");
+    const auto start = std::chrono::steady_clock::now();
+    m_stats = CommandReplayStats();
+
+    // ~0 never names a GL object, so the first packet binds everything
+    uint32_t pipeline = ~0u;
+    uint32_t vertexArray = ~0u;
+    uint32_t textures[kTextureUnits];
+    for (uint32_t& texture : textures) {
+        texture = ~0u;
+    }
+    const uint32_t* textureSnapshot = nullptr;
+    uint8_t zeroed = 0, zeroedInt = 0;
+    GLenum activeUnit = GL_TEXTURE0;
+    glActiveTexture(GL_TEXTURE0);
+
+    for (const CommandQueue::Entry& entry : queue.entries()) {
+        const DrawPacket& packet = *entry.packet;
+
+        if (packet.pipeline != pipeline) {
+            pipeline = packet.pipeline;
+            glUseProgram(pipeline);
+            m_applied.clear();
+            m_stats.pipelineBinds++;
+        }
+        else {
+            m_stats.redundantSkipped++;
+        }
+
+        if (packet.vertexArray != vertexArray) {
+            vertexArray = packet.vertexArray;
+            glBindVertexArray(vertexArray);
+            m_stats.vertexArrayBinds++;
+        }
+        else {
+            m_stats.redundantSkipped++;
+        }
+
+        if (packet.textures != textureSnapshot) {
+            textureSnapshot = packet.textures;
+            for (unsigned int unit = 0; unit < kTextureUnits; unit++) {
+                // 0: the draw does not sample this unit
+                if (packet.textures[unit] == 0 || packet.textures[unit] == textures[unit]) {
+                    continue;
+                }
+                if (activeUnit != GL_TEXTURE0 + unit) {
+                    activeUnit = GL_TEXTURE0 + unit;
+                    glActiveTexture(activeUnit);
+                }
+                textures[unit] = packet.textures[unit];
+                glBindTexture(GL_TEXTURE_2D, textures[unit]);
+                m_stats.textureBinds++;
+            }
+        }
+
+        for (uint16_t i = 0; i < packet.uniformCount; i++) {
+            const UniformValue& uniform = *packet.uniforms[i];
+            const GLint location = _location(pipeline, uniform);
+            if (location < 0) {
+                continue;
+            }
+            if ((size_t)location >= m_applied.size()) {
+                m_applied.resize(location + 1, nullptr);
+            }
+            if (m_applied[location] == &uniform) {
+                m_stats.redundantSkipped++;
+                continue;
+            }
+            m_applied[location] = &uniform;
+            _upload(location, uniform);
+        }
+
+        // generic attribute values are context state, nothing in the replay changes them back
+        if ((packet.zeroAttributes & ~zeroed) || (packet.zeroIntAttributes & ~zeroedInt)) {
+            for (unsigned int location = 0; location < 8; location++) {
+                const uint8_t bit = (uint8_t)(1u << location);
+                if (packet.zeroAttributes & bit & ~zeroed) {
+                    glVertexAttrib4f(location, 0.0f, 0.0f, 0.0f, 0.0f);
+                }
+                if (packet.zeroIntAttributes & bit & ~zeroedInt) {
+                    glVertexAttribI4i(location, 0, 0, 0, 0);
+                }
+            }
+            // a location is either float or integer, setting one kind replaces the other
+            zeroed = (uint8_t)((zeroed & ~packet.zeroIntAttributes) | packet.zeroAttributes);
+            zeroedInt = (uint8_t)((zeroedInt & ~packet.zeroAttributes) | packet.zeroIntAttributes);
+        }
+
+        const GLenum mode = gl_primitive(packet.primitive);
+        if (packet.kind == DrawKind::Arrays) {
+            if (packet.instances == 1) {
+                glDrawArrays(mode, (GLint)packet.first, (GLsizei)packet.count);
+            }
+            else {
+                glDrawArraysInstanced(mode, (GLint)packet.first, (GLsizei)packet.count, (GLsizei)packet.instances);
+            }
+        }
+        else {
+            const GLenum indexType = packet.indexType == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            const void* offset = (const void*)(uintptr_t)packet.first;
+            if (packet.instances == 1) {
+                glDrawElements(mode, (GLsizei)packet.count, indexType, offset);
+            }
+            else {
+                glDrawElementsInstanced(mode, (GLsizei)packet.count, indexType, offset, (GLsizei)packet.instances);
+            }
+        }
+        RenderStats::get().recordDraw(mode, packet.count, packet.instances);
+        m_stats.draws++;
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    m_stats.replayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
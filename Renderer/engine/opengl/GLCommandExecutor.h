@@ -0,0 +1,60 @@
+#ifndef _GL_COMMAND_EXECUTOR_H_
+#define _GL_COMMAND_EXECUTOR_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../render/CommandList.h"
+
+struct CommandReplayStats {
+    uint64_t draws = 0;
+    uint64_t pipelineBinds = 0;
+    uint64_t vertexArrayBinds = 0;
+    uint64_t textureBinds = 0;
+    uint64_t uniformUploads = 0;
+    uint64_t redundantSkipped = 0;  // state changes the packets asked for that were already in place
+    double replayMs = 0.0;
+};
+
+/**
+ * @brief Replays a sorted CommandQueue through OpenGL
+ *
+ * Walks the packets in queue order, binding only what differs from the previous packet.
+ * Uniform locations are looked up once per (program, name) and cached; call `invalidate`
+ * when programs are deleted, since GL may hand their names out again.
+ *
+ * Nothing is assumed about the state before `execute`: the first packet binds everything.
+ * Afterwards vertex array 0 and texture unit 0 are current again, like the immediate
+ * draw paths leave them.
+ *
+ * @note GL thread only.
+ */
+class GLCommandExecutor {
+public:
+    GLCommandExecutor();
+
+    GLCommandExecutor(const GLCommandExecutor& other) = delete;
+
+    GLCommandExecutor& operator=(const GLCommandExecutor& other) = delete;
+
+    void execute(const CommandQueue& queue);
+
+    /// Counters of the last execute
+    const CommandReplayStats& stats() const { return m_stats; }
+
+    void invalidate() { m_locations.clear(); }
+
+private:
+    std::unordered_map<uint64_t, GLint> m_locations;
+    std::vector<const UniformValue*> m_applied;     // by location, for the current program
+    CommandReplayStats m_stats;
+
+    GLint _location(uint32_t program, const UniformValue& uniform);
+
+    void _upload(GLint location, const UniformValue& uniform);
+};
+
+#endif // !_GL_COMMAND_EXECUTOR_H_
@@ -0,0 +1,187 @@
+#include "GpuProfiler.h"
+
+#include "utils.h"
+
+#include <algorithm>
+
+GpuProfiler& GpuProfiler::get() {
+    static GpuProfiler profiler;
+    return profiler;
+}
+
+GpuProfiler::GpuProfiler()
+    : m_sets{},
+      m_current(nullptr),
+      m_depth(0),
+      m_initialized(false),
+      m_droppedFrames(0),
+      m_lastFrameTime(0),
+      m_lastFrameIndex(0),
+      m_resolvedFrames(0),
+      m_history{}
+{
+    m_resolved.reserve(kMaxScopes);
+}
+
+GpuProfiler::~GpuProfiler() {
+    // the context is usually gone by the time statics are destroyed, call `shutdown` before that
+}
+
+bool GpuProfiler::init() {
+    if (m_initialized) {
+        return true;
+    }
+
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0) {
+        gl_log_err("GpuProfiler: timestamp queries are not supported\n");
+        return false;
+    }
+
+    for (auto& set : m_sets) {
+        GL_CALL(glGenQueries(1, &set.elapsed));
+        GL_CALL(glGenQueries(1 + 2 * kMaxScopes, set.timestamps));
+        set.scopeCount = 0;
+        set.frameIndex = 0;
+        set.pending = false;
+    }
+
+    m_initialized = true;
+    return true;
+}
+
+void GpuProfiler::shutdown() {
+    if (!m_initialized) {
+        return;
+    }
+
+    for (auto& set : m_sets) {
+        GL_CALL(glDeleteQueries(1, &set.elapsed));
+        GL_CALL(glDeleteQueries(1 + 2 * kMaxScopes, set.timestamps));
+        set.pending = false;
+    }
+
+    m_current = nullptr;
+    m_initialized = false;
+}
+
+bool GpuProfiler::_collect(QuerySet& set) {
+    // queries complete in order, the elapsed query and the last timestamp are the last ones issued
+    GLint available = 0;
+    glGetQueryObjectiv(set.elapsed, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+    glGetQueryObjectiv(set.timestamps[2 * set.scopeCount], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+
+    GLuint64 elapsed = 0;
+    GLuint64 reference = 0;
+    glGetQueryObjectui64v(set.elapsed, GL_QUERY_RESULT, &elapsed);
+    glGetQueryObjectui64v(set.timestamps[0], GL_QUERY_RESULT, &reference);
+
+    m_resolved.clear();
+    for (unsigned int i = 0; i < set.scopeCount; i++) {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(set.timestamps[1 + 2 * i], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(set.timestamps[2 + 2 * i], GL_QUERY_RESULT, &end);
+        m_resolved.push_back({ set.names[i], start - reference, end - reference, set.depth[i], 0 });
+    }
+
+    Profiler::get().attachGpuScopes(set.frameIndex, m_resolved, elapsed);
+    m_lastFrameTime = elapsed;
+    m_lastFrameIndex = set.frameIndex;
+    m_history[m_resolvedFrames % kBufferCount] = { set.frameIndex, elapsed * 1e-6 };
+    m_resolvedFrames++;
+    set.pending = false;
+
+    return true;
+}
+
+void GpuProfiler::beginFrame(uint64_t frameIndex) {
+    if (!m_initialized || !Profiler::get().enabled()) {
+        return;
+    }
+
+    // pick up whatever finished since last frame, without waiting
+    collect();
+
+    QuerySet& set = m_sets[frameIndex % kBufferCount];
+    if (set.pending) {
+        // still in flight after a full frame, reusing the queries discards it
+        m_droppedFrames++;
+        set.pending = false;
+    }
+
+    set.frameIndex = frameIndex;
+    set.scopeCount = 0;
+    m_current = &set;
+    m_depth = 0;
+
+    // per-frame path: plain calls, GL_CALL's error polling would cost more than the queries
+    glBeginQuery(GL_TIME_ELAPSED, set.elapsed);
+    glQueryCounter(set.timestamps[0], GL_TIMESTAMP);
+}
+
+void GpuProfiler::collect() {
+    if (!m_initialized) {
+        return;
+    }
+
+    // oldest first, so lastFrameMs ends up on the newest frame
+    QuerySet* sets[kBufferCount];
+    unsigned int count = 0;
+    for (auto& set : m_sets) {
+        if (set.pending) {
+            sets[count++] = &set;
+        }
+    }
+    std::sort(sets, sets + count, [](const QuerySet* a, const QuerySet* b) { return a->frameIndex < b->frameIndex; });
+    for (unsigned int i = 0; i < count; i++) {
+        _collect(*sets[i]);
+    }
+}
+
+void GpuProfiler::endFrame() {
+    if (!m_current) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < m_current->scopeCount; i++) {
+        if (!m_current->closed[i]) {
+            glQueryCounter(m_current->timestamps[2 + 2 * i], GL_TIMESTAMP);
+            m_current->closed[i] = true;
+        }
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_current->pending = true;
+    m_current = nullptr;
+}
+
+int GpuProfiler::beginScope(const char* name) {
+    if (!m_current || m_current->scopeCount >= kMaxScopes) {
+        return -1;
+    }
+
+    int scope = (int)m_current->scopeCount++;
+    m_current->names[scope] = name;
+    m_current->depth[scope] = m_depth++;
+    m_current->closed[scope] = false;
+    glQueryCounter(m_current->timestamps[1 + 2 * scope], GL_TIMESTAMP);
+
+    return scope;
+}
+
+void GpuProfiler::endScope(int scope) {
+    if (scope < 0 || !m_current) {
+        return;
+    }
+
+    m_depth--;
+    glQueryCounter(m_current->timestamps[2 + 2 * scope], GL_TIMESTAMP);
+    m_current->closed[scope] = true;
+}
@@ -0,0 +1,140 @@
+#ifndef _GPU_PROFILER_H_
+#define _GPU_PROFILER_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "../core/Profiler.h"
+
+/**
+ * @brief GPU timing through OpenGL query objects
+ *
+ * Every frame owns a query set: one GL_TIME_ELAPSED query spanning the whole frame and a
+ * pair of GL_TIMESTAMP queries per scope (timestamps nest, elapsed queries don't).
+ *
+ * Query sets are double-buffered: frame N records into set N % 2 while the results of
+ * frame N - 1 are read back. Results are only fetched once GL_QUERY_RESULT_AVAILABLE says
+ * so, a set that is still in flight when its turn comes back is dropped rather than
+ * stalling the pipeline (see `droppedFrames`).
+ *
+ * Resolved scopes are handed to `Profiler::attachGpuScopes`.
+ *
+ * @note Must be initialized and used on the thread that owns the GL context.
+ */
+class GpuProfiler {
+public:
+    static constexpr unsigned int kBufferCount = 2;
+    static constexpr unsigned int kMaxScopes = 64;
+
+    struct ResolvedFrame {
+        uint64_t frameIndex;
+        double ms;
+    };
+
+    static GpuProfiler& get();
+
+    GpuProfiler();
+
+    GpuProfiler(const GpuProfiler& other) = delete;
+
+    GpuProfiler& operator=(const GpuProfiler& other) = delete;
+
+    ~GpuProfiler();
+
+    /**
+     * @brief Creates the query pools, needs a current context
+     */
+    bool init();
+
+    void shutdown();
+
+    bool initialized() const { return m_initialized; }
+
+    void beginFrame(uint64_t frameIndex);
+
+    /**
+     * @brief Resolves every frame whose queries are available, without waiting
+     *
+     * `beginFrame` does this on its own; call it after a glFinish to drain the last frames.
+     */
+    void collect();
+
+    void endFrame();
+
+    int beginScope(const char* name);
+
+    void endScope(int scope);
+
+    /// Frames whose queries were still pending when their buffer was reused
+    uint64_t droppedFrames() const { return m_droppedFrames; }
+
+    /// GPU time of the most recently resolved frame in milliseconds
+    double lastFrameMs() const { return m_lastFrameTime * 1e-6; }
+
+    /// Frame index of the most recently resolved frame
+    uint64_t lastFrameIndex() const { return m_lastFrameIndex; }
+
+    /// Frames resolved since init, changes whenever `lastFrameMs` does
+    uint64_t resolvedFrames() const { return m_resolvedFrames; }
+
+    /**
+     * @brief One of the last `kBufferCount` frames resolved, `age` 0 being the most recent
+     *
+     * A collect can resolve every buffer at once, `lastFrameMs` only shows the newest of them.
+     * `age` must be below both `kBufferCount` and `resolvedFrames`.
+     */
+    ResolvedFrame resolvedFrame(unsigned int age) const { return m_history[(m_resolvedFrames - 1 - age) % kBufferCount]; }
+
+private:
+    struct QuerySet {
+        GLuint elapsed;
+        GLuint timestamps[1 + 2 * kMaxScopes]; // [0] is the frame start reference
+        const char* names[kMaxScopes];
+        uint16_t depth[kMaxScopes];
+        bool closed[kMaxScopes];
+        unsigned int scopeCount;
+        uint64_t frameIndex;
+        bool pending;
+    };
+
+    QuerySet m_sets[kBufferCount];
+    QuerySet* m_current;
+    uint16_t m_depth;
+    bool m_initialized;
+    uint64_t m_droppedFrames;
+    uint64_t m_lastFrameTime;
+    uint64_t m_lastFrameIndex;
+    uint64_t m_resolvedFrames;
+    ResolvedFrame m_history[kBufferCount];      // by resolve count
+    std::vector<ProfileScopeRecord> m_resolved;
+
+    bool _collect(QuerySet& set);
+};
+
+/**
+ * @brief RAII GPU scope marker
+ */
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name)
+        : m_scope(GpuProfiler::get().beginScope(name)) {}
+
+    ~GpuProfileScope() { GpuProfiler::get().endScope(m_scope); }
+
+    GpuProfileScope(const GpuProfileScope& other) = delete;
+
+    GpuProfileScope& operator=(const GpuProfileScope& other) = delete;
+
+private:
+    int m_scope;
+};
+
+#ifndef PROFILER_DISABLED
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(_gpuProfileScope, __LINE__)(name)
+#else
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
+
+#endif // !_GPU_PROFILER_H_
@@ -5,9 +5,17 @@ OpenGLApp::OpenGLApp(const OpenGLConfig& config)
 {
     // start GLEW extension handler
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
+    GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // headless EGL contexts have no GLX display, the GL entry points are loaded regardless
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY) {
+        status = GLEW_OK;
+    }
+#endif
+    if (status != GLEW_OK) {
         std::cout << "Failed to initialize GLEW" << std::endl;
         m_initialized = false;
+        return;
     }
 
     if(config.logOpenGLInfo) {
@@ -2,6 +2,7 @@
 #define _OPENGL_PIPELINE_H_
 
 #include <GL/glew.h>
+#include <utility>
 #include <vector>
 #include "utils.h"
 
@@ -79,12 +80,14 @@ Buffer<_Ty>::Buffer(const BufferInfo<_Ty>& info)
     GL_CALL(glGenBuffers(1, &m_id));
     bind();
     GL_CALL(glBufferData(info.target, info.size, info.data.data(), info.usage));
+    gl_track_buffer(m_id, info.target, info.size);
     
 }
 
 template<typename _Ty>
 Buffer<_Ty>::~Buffer()
 {
+    gl_untrack_buffer(m_id);
     GL_CALL(glDeleteBuffers(1, &m_id));
     
 }
@@ -95,6 +98,7 @@ Buffer<_Ty>& Buffer<_Ty>::operator=(const BufferInfo<_Ty>& info)
     m_target = info.target;
     bind();
     GL_CALL(glBufferData(info.target, info.size, info.data.data(), info.usage));
+    gl_track_buffer(m_id, info.target, info.size);
     
     //unbind();
     return *this;
@@ -106,6 +110,7 @@ Buffer<_Ty>& Buffer<_Ty>::operator=(BufferInfo<_Ty>&& info)
     m_target = info.target;
     bind();
     GL_CALL(glBufferData(info.target, info.size, info.data.data(), info.usage));
+    gl_track_buffer(m_id, info.target, info.size);
     
     //unbind();
     return *this;
@@ -116,6 +121,7 @@ void Buffer<_Ty>::setBuffer(const BufferInfo<_Ty>& info) {
     m_target = info.target;
     bind();
     GL_CALL(glBufferData(info.target, info.size, info.data.data(), info.usage));
+    gl_track_buffer(m_id, info.target, info.size);
     
     //unbind();
 }
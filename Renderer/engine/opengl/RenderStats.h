@@ -0,0 +1,52 @@
+#ifndef _RENDER_STATS_H_
+#define _RENDER_STATS_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+
+/**
+ * @brief Per-frame draw counters
+ *
+ * Every draw call site reports itself here. Only touched from the GL thread, so plain
+ * counters are enough; whoever owns the frame loop calls `reset` at the start of a frame.
+ */
+class RenderStats {
+public:
+    static RenderStats& get() {
+        static RenderStats stats;
+        return stats;
+    }
+
+    void reset() {
+        m_drawCalls = 0;
+        m_vertices = 0;
+        m_triangles = 0;
+    }
+
+    /**
+     * @brief Records one draw call of `count` vertices (or indices) in primitive `mode`
+     */
+    void recordDraw(GLenum mode, uint64_t count, uint64_t instances = 1) {
+        m_drawCalls++;
+        m_vertices += count * instances;
+        if (mode == GL_TRIANGLES) {
+            m_triangles += count / 3 * instances;
+        }
+    }
+
+    uint64_t drawCalls() const { return m_drawCalls; }
+
+    uint64_t vertices() const { return m_vertices; }
+
+    uint64_t triangles() const { return m_triangles; }
+
+private:
+    RenderStats() : m_drawCalls(0), m_vertices(0), m_triangles(0) {}
+
+    uint64_t m_drawCalls;
+    uint64_t m_vertices;
+    uint64_t m_triangles;
+};
+
+#endif // !_RENDER_STATS_H_
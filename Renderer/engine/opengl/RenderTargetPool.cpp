@@ -0,0 +1,109 @@
+#include "RenderTargetPool.h"
+
+#include "../core/Memory.h"
+
+RenderTargetPool::RenderTargetPool()
+    : m_entries(), m_frame(0), m_frameStats(), m_lastFrameStats()
+{}
+
+RenderTargetPool::~RenderTargetPool() {
+    clear();
+}
+
+void RenderTargetPool::beginFrame() {
+    m_frame++;
+    m_lastFrameStats = m_frameStats;
+    m_frameStats = RenderTargetPoolStats();
+
+    for (size_t i = 0; i < m_entries.size();) {
+        const Entry& entry = m_entries[i];
+        if (!entry.inUse && m_frame - entry.lastFrame > kMaxIdleFrames) {
+            GL_LOG("Render target %u (%dx%d) idle for %llu frames, destroyed\n", entry.target->id(), entry.desc.width,
+                   entry.desc.height, (unsigned long long)(m_frame - entry.lastFrame));
+            m_entries[i] = std::move(m_entries.back());
+            m_entries.pop_back();
+            m_frameStats.destroyed++;
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+Framebuffer* RenderTargetPool::acquire(const RenderTargetDesc& desc) {
+    for (Entry& entry : m_entries) {
+        if (!entry.inUse && entry.desc == desc) {
+            entry.inUse = true;
+            entry.lastFrame = m_frame;
+            m_frameStats.acquired++;
+            m_frameStats.reused++;
+            m_frameStats.reusedBytes += byteSize(desc);
+            return entry.target.get();
+        }
+    }
+
+    MemoryScope scope(MemoryTag::Texture);
+    std::unique_ptr<Framebuffer> target = std::make_unique<Framebuffer>();
+    if (!target->create(framebufferConfig(desc))) {
+        gl_log_err("ERROR: could not create a %dx%d render target\n", desc.width, desc.height);
+        return nullptr;
+    }
+
+    m_entries.push_back({ std::move(target), desc, m_frame, true });
+    m_frameStats.acquired++;
+    m_frameStats.allocated++;
+    m_frameStats.allocatedBytes += byteSize(desc);
+    return m_entries.back().target.get();
+}
+
+void RenderTargetPool::release(const Framebuffer* target) {
+    for (Entry& entry : m_entries) {
+        if (entry.target.get() == target) {
+            entry.inUse = false;
+            return;
+        }
+    }
+    gl_log_err("ERROR: render target %u does not belong to the pool\n", target ? target->id() : 0);
+}
+
+void RenderTargetPool::clear() {
+    m_frameStats.destroyed += (uint32_t)m_entries.size();
+    m_entries.clear();
+}
+
+size_t RenderTargetPool::inUseCount() const {
+    size_t count = 0;
+    for (const Entry& entry : m_entries) {
+        count += entry.inUse;
+    }
+    return count;
+}
+
+uint64_t RenderTargetPool::byteSize() const {
+    uint64_t bytes = 0;
+    for (const Entry& entry : m_entries) {
+        bytes += byteSize(entry.desc);
+    }
+    return bytes;
+}
+
+FramebufferConfig RenderTargetPool::framebufferConfig(const RenderTargetDesc& desc) {
+    FramebufferConfig config{};
+    config.width = desc.width;
+    config.height = desc.height;
+    if (desc.colorFormat) {
+        const bool half = desc.colorFormat == GL_RGBA16F || desc.colorFormat == GL_RG16F || desc.colorFormat == GL_R16F ||
+                          desc.colorFormat == GL_R11F_G11F_B10F;
+        const bool full = desc.colorFormat == GL_RGBA32F || desc.colorFormat == GL_R32F;
+        const GLenum type = half ? GL_HALF_FLOAT : full ? GL_FLOAT : GL_UNSIGNED_BYTE;
+        config.colorAttachments = { { desc.colorFormat, GL_RGBA, type, desc.filter } };
+    }
+    config.depth = desc.depthFormat != 0;
+    config.depthFormat = desc.depthFormat ? desc.depthFormat : GL_DEPTH_COMPONENT24;
+    return config;
+}
+
+uint64_t RenderTargetPool::byteSize(const RenderTargetDesc& desc) {
+    const uint64_t pixels = (uint64_t)desc.width * desc.height;
+    return pixels * ((desc.colorFormat ? gl_texel_bytes(desc.colorFormat) : 0) + (desc.depthFormat ? gl_texel_bytes(desc.depthFormat) : 0));
+}
@@ -0,0 +1,115 @@
+#ifndef _RENDER_TARGET_POOL_H_
+#define _RENDER_TARGET_POOL_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Framebuffer.h"
+
+/**
+ * @brief What a transient render target is: its size, a color format and a depth format
+ *
+ * A format of 0 means no such attachment. Targets with equal descriptions are interchangeable.
+ */
+struct RenderTargetDesc {
+    int width;
+    int height;
+    GLenum colorFormat;     // sized, e.g. GL_RGBA8, GL_RGBA16F, or 0
+    GLenum depthFormat;     // GL_DEPTH_COMPONENT24, GL_DEPTH24_STENCIL8, GL_DEPTH_COMPONENT32F or 0
+    GLenum filter;          // min/mag filter of the color texture
+
+    bool operator==(const RenderTargetDesc& other) const {
+        return width == other.width && height == other.height && colorFormat == other.colorFormat &&
+               depthFormat == other.depthFormat && filter == other.filter;
+    }
+
+    bool operator!=(const RenderTargetDesc& other) const { return !(*this == other); }
+};
+
+struct RenderTargetPoolStats {
+    uint32_t acquired = 0;          // targets handed out
+    uint32_t reused = 0;            // of them, taken from the pool
+    uint32_t allocated = 0;         // of them, created
+    uint32_t destroyed = 0;         // idle for too long, or dropped by clear
+    uint64_t reusedBytes = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+/**
+ * @brief Pool of framebuffers for the passes of a frame
+ *
+ * A pass acquires the targets it writes and releases them once the last pass reading them
+ * ran; a released target goes back to the pool and is handed to the next acquire of the
+ * same description, in this frame or a later one. Steady frames therefore allocate nothing,
+ * and passes whose lifetimes don't overlap share the memory of their targets.
+ *
+ * Targets nobody acquired for kMaxIdleFrames frames are destroyed by beginFrame, so a size
+ * or format change does not keep the old targets alive.
+ *
+ * The stats count acquires and bytes since the last beginFrame: the GPU memory a frame
+ * allocated versus the memory it got back from earlier passes.
+ */
+class RenderTargetPool {
+public:
+    static constexpr uint64_t kMaxIdleFrames = 3;
+
+    RenderTargetPool();
+
+    RenderTargetPool(const RenderTargetPool& other) = delete;
+
+    RenderTargetPool& operator=(const RenderTargetPool& other) = delete;
+
+    ~RenderTargetPool();
+
+    /// Starts a frame: drops the targets idle for too long and resets the frame's stats
+    void beginFrame();
+
+    /**
+     * @brief A free target matching `desc`, created if there is none
+     *
+     * @return null if the framebuffer could not be created
+     */
+    Framebuffer* acquire(const RenderTargetDesc& desc);
+
+    /// Gives `target` back to the pool; its contents stay until someone else acquires it
+    void release(const Framebuffer* target);
+
+    /// Destroys every target, they must all be released
+    void clear();
+
+    /// Since the last beginFrame
+    const RenderTargetPoolStats& frameStats() const { return m_frameStats; }
+
+    /// Of the frame before, complete
+    const RenderTargetPoolStats& lastFrameStats() const { return m_lastFrameStats; }
+
+    /// Targets the pool holds, in use or not
+    size_t targetCount() const { return m_entries.size(); }
+
+    size_t inUseCount() const;
+
+    /// GPU memory of all the pool's targets
+    uint64_t byteSize() const;
+
+    static FramebufferConfig framebufferConfig(const RenderTargetDesc& desc);
+
+    static uint64_t byteSize(const RenderTargetDesc& desc);
+
+private:
+    struct Entry {
+        std::unique_ptr<Framebuffer> target;
+        RenderTargetDesc desc;
+        uint64_t lastFrame;
+        bool inUse;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t m_frame;
+    RenderTargetPoolStats m_frameStats;
+    RenderTargetPoolStats m_lastFrameStats;
+};
+
+#endif // !_RENDER_TARGET_POOL_H_
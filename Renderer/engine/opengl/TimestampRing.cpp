@@ -0,0 +1,75 @@
+#include "TimestampRing.h"
+
+#include "utils.h"
+
+#include <algorithm>
+
+TimestampRing::TimestampRing(size_t slotCount)
+    : m_slots(std::max(slotCount, (size_t)1), Slot{ {}, 0, false }),
+      m_times(),
+      m_timed(false),
+      m_frame(0)
+{}
+
+TimestampRing::~TimestampRing() {
+    for (Slot& slot : m_slots) {
+        if (!slot.queries.empty()) {
+            GL_CALL(glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data()));
+        }
+    }
+}
+
+bool TimestampRing::begin() {
+    Slot& slot = m_slots[this->slot()];
+    m_timed = !slot.pending;
+    if (m_timed) {
+        slot.count = 0;
+    }
+    return m_timed;
+}
+
+void TimestampRing::mark() {
+    if (!m_timed) {
+        return;
+    }
+
+    Slot& slot = m_slots[this->slot()];
+    if (slot.queries.size() <= slot.count) {
+        const size_t created = slot.queries.size();
+        slot.queries.resize(std::max(2 * created, (size_t)2));
+        GL_CALL(glGenQueries((GLsizei)(slot.queries.size() - created), slot.queries.data() + created));
+    }
+    glQueryCounter(slot.queries[slot.count++], GL_TIMESTAMP);
+}
+
+void TimestampRing::end() {
+    Slot& slot = m_slots[this->slot()];
+    if (m_timed && slot.count > 0) {
+        slot.pending = true;
+    }
+    m_timed = false;
+    m_frame++;
+}
+
+void TimestampRing::collect(const std::function<void(size_t slot, const GLuint64* times, size_t count)>& resolved) {
+    for (size_t age = 0; age < m_slots.size(); age++) {
+        const size_t index = (size_t)((m_frame + age) % m_slots.size());
+        Slot& slot = m_slots[index];
+        if (!slot.pending) {
+            continue;
+        }
+
+        GLint available = 0;
+        glGetQueryObjectiv(slot.queries[slot.count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        m_times.resize(slot.count);
+        for (size_t i = 0; i < slot.count; i++) {
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &m_times[i]);
+        }
+        slot.pending = false;
+        resolved(index, m_times.data(), slot.count);
+    }
+}
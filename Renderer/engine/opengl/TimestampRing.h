@@ -0,0 +1,75 @@
+#ifndef _TIMESTAMP_RING_H_
+#define _TIMESTAMP_RING_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief GL_TIMESTAMP queries of a pass, read back a few frames later without stalling
+ *
+ * Frame N writes its timestamps into slot N % slotCount. A slot still in flight when its
+ * turn comes back leaves that frame unmeasured, `mark` does nothing until the next `begin`.
+ * Queries are made on first use and grow with the number of marks a frame needs.
+ *
+ * Unlike GpuProfiler there is no frame query around the marks, so passes can time
+ * themselves inside a profiled frame.
+ *
+ * @note Must be used on the thread that owns the GL context.
+ */
+class TimestampRing {
+public:
+    /// `slotCount` frames may be in flight at once
+    explicit TimestampRing(size_t slotCount = 2);
+
+    TimestampRing(const TimestampRing& other) = delete;
+
+    TimestampRing& operator=(const TimestampRing& other) = delete;
+
+    ~TimestampRing();
+
+    /// Starts a frame; false if its slot is still in flight
+    bool begin();
+
+    /// Writes the next timestamp of the frame
+    void mark();
+
+    /// A frame with marks goes in flight
+    void end();
+
+    /// Whether the frame between `begin` and `end` is measured
+    bool timed() const { return m_timed; }
+
+    /// Of the current frame, for whatever an owner keeps next to its timestamps
+    size_t slot() const { return (size_t)(m_frame % m_slots.size()); }
+
+    /// Frames that may be in flight at once, and so the slots an owner keeps data for
+    size_t slotCount() const { return m_slots.size(); }
+
+    /// Marks of the current frame so far
+    size_t count() const { return m_slots[slot()].count; }
+
+    /**
+     * @brief Hands every slot that resolved to `resolved`, oldest first, and frees it
+     *
+     * Times are in nanoseconds, one per mark. Queries resolve in order, so the first slot
+     * not ready ends the walk.
+     */
+    void collect(const std::function<void(size_t slot, const GLuint64* times, size_t count)>& resolved);
+
+private:
+    struct Slot {
+        std::vector<GLuint> queries;
+        size_t count;
+        bool pending;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<GLuint64> m_times;
+    bool m_timed;
+    uint64_t m_frame;
+};
+
+#endif // !_TIMESTAMP_RING_H_
@@ -9,62 +9,32 @@
 #include <GLFW/glfw3.h>
 
 
-bool restart_gl_log() {
-    FILE* file = fopen(GL_LOG_FILE, "w");
-    if(!file) {
-        fprintf(stderr,
-            "ERROR: could not open GL_LOG_FILE log file %s for writing\n",
-            GL_LOG_FILE);
-        return false;
-    }
-
-    time_t now = time(NULL);
-    char* date = ctime(&now);
-    fprintf(file, "GL_LOG_FILE log. local time %s\n", date);
-    fclose(file);
-
-    return true;
+bool restart_gl_log(const char* path, LogLevel level) {
+    LoggerConfig config{};
+    config.path = path;
+    config.level = level;
+    config.echoErrors = true;
+    config.flushIntervalMs = 100;
+
+    return Logger::get().open(config);
 }
 
 bool gl_log(const char* message, ...) {
     va_list arg_ptr;
-    FILE* file = fopen(GL_LOG_FILE, "a");
-
-    if(!file) {
-        fprintf(stderr,
-            "ERROR: could not open GL_LOG_FILE %s file for appending\n",
-            GL_LOG_FILE);
-        return false;
-    }
-
     va_start(arg_ptr, message);
-    vfprintf(file, message, arg_ptr);
+    bool result = Logger::get().vlog(LogLevel::Info, message, arg_ptr);
     va_end(arg_ptr);
-    fclose(file);
 
-    return true;
+    return result;
 }
 
 bool gl_log_err(const char* message, ...) {
     va_list arg_ptr;
-    FILE* file = fopen(GL_LOG_FILE, "a");
-
-    if(!file) {
-        fprintf(stderr,
-            "ERROR: could not open GL_LOG_FILE %s file for appending\n",
-            GL_LOG_FILE);
-        return false;
-    }
-
-    va_start(arg_ptr, message);
-    vfprintf(file, message, arg_ptr);
-    va_end(arg_ptr);
     va_start(arg_ptr, message);
-    vfprintf(stderr, message, arg_ptr);
+    bool result = Logger::get().vlog(LogLevel::Error, message, arg_ptr);
     va_end(arg_ptr);
-    fclose(file);
 
-    return true;
+    return result;
 }
 
 void log_gl_params() {
@@ -9,17 +9,74 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#define GL_LOG_FILE "/home/zaki/Tutorials/cg-opengl/logs/gl.log"
+#include "../core/Logger.h"
 
-bool restart_gl_log();
+/// Default sink, relative to the working directory. Override with -DGL_LOG_FILE=... or pass a path to `restart_gl_log`.
+#ifndef GL_LOG_FILE
+#define GL_LOG_FILE "logs/gl.log"
+#endif
 
-bool gl_log(const char* message, ...);
+/// Compile-time log level, anything below it compiles to nothing.
+#define GL_LOG_LEVEL_TRACE 0
+#define GL_LOG_LEVEL_DEBUG 1
+#define GL_LOG_LEVEL_INFO  2
+#define GL_LOG_LEVEL_WARN  3
+#define GL_LOG_LEVEL_ERROR 4
+#define GL_LOG_LEVEL_OFF   5
 
-bool gl_log_err(const char* message, ...);
+#ifndef GL_LOG_LEVEL
+#ifdef _DEBUG
+#define GL_LOG_LEVEL GL_LOG_LEVEL_DEBUG
+#else
+#define GL_LOG_LEVEL GL_LOG_LEVEL_INFO
+#endif
+#endif
+
+#if GL_LOG_LEVEL <= GL_LOG_LEVEL_TRACE
+#define GL_LOG_TRACE(...) Logger::get().log(LogLevel::Trace, __VA_ARGS__)
+#else
+#define GL_LOG_TRACE(...) ((void)0)
+#endif
+
+#if GL_LOG_LEVEL <= GL_LOG_LEVEL_DEBUG
+#define GL_LOG_DEBUG(...) Logger::get().log(LogLevel::Debug, __VA_ARGS__)
+#else
+#define GL_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if GL_LOG_LEVEL <= GL_LOG_LEVEL_INFO
+#define GL_LOG_INFO(...) Logger::get().log(LogLevel::Info, __VA_ARGS__)
+#else
+#define GL_LOG_INFO(...) ((void)0)
+#endif
+
+#if GL_LOG_LEVEL <= GL_LOG_LEVEL_WARN
+#define GL_LOG_WARN(...) Logger::get().log(LogLevel::Warn, __VA_ARGS__)
+#else
+#define GL_LOG_WARN(...) ((void)0)
+#endif
+
+#if GL_LOG_LEVEL <= GL_LOG_LEVEL_ERROR
+#define GL_LOG_ERROR(...) Logger::get().log(LogLevel::Error, __VA_ARGS__)
+#else
+#define GL_LOG_ERROR(...) ((void)0)
+#endif
+
+/**
+ * @brief Starts the asynchronous logger on a fresh (truncated) log file
+ *
+ * @param path sink file, its directory is created if needed
+ * @param level runtime log level, messages below it are discarded when logged
+ */
+bool restart_gl_log(const char* path = GL_LOG_FILE, LogLevel level = LogLevel::Trace);
+
+bool gl_log(const char* message, ...) LOGGER_PRINTF_FORMAT(1, 2);
+
+bool gl_log_err(const char* message, ...) LOGGER_PRINTF_FORMAT(1, 2);
 
 void log_gl_params();
 
 const char* glGetErrorString(GLenum error);
 
 
-#endif // !_LOG_H_
\ No newline at end of file
+#endif // !_LOG_H_
@@ -60,24 +60,6 @@ void glfw_error_callback(int error, const char* description) {
     gl_log_err("GLFW ERROR: code %i msg: %s\n", error, description);
 }
 
-void _update_fps_counter(GLFWwindow* window) {
-    static double previous_seconds = glfwGetTime();
-    static int frame_count;
-    double current_seconds = glfwGetTime();
-    double elapsed_seconds = current_seconds - previous_seconds;
-
-    if (elapsed_seconds > 0.25) {
-        previous_seconds = current_seconds;
-        double fps = (double)frame_count / elapsed_seconds;
-        char tmp[128];
-        sprintf(tmp, "opengl @ fps: %.2f", fps);
-        glfwSetWindowTitle(window, tmp);
-        frame_count = 0;
-    }
-
-    frame_count++;
-}
-
 void _glCheckErrors(const char *filename, int line)
 {
     GLenum err;
@@ -94,4 +76,94 @@ void _update_delta_time(float* deltaTime, float* lastFrame) {
     float currentFrame = (float)glfwGetTime();
     *deltaTime = currentFrame - *lastFrame;
     *lastFrame = currentFrame;
-}
\ No newline at end of file
+}
+
+const char* gl_enum_name(GLenum value) {
+    switch (value)
+    {
+    case GL_RED:                        return "GL_RED";
+    case GL_RG:                         return "GL_RG";
+    case GL_RGB:                        return "GL_RGB";
+    case GL_RGBA:                       return "GL_RGBA";
+    case GL_R8:                         return "GL_R8";
+    case GL_RGBA8:                      return "GL_RGBA8";
+    case GL_SRGB8_ALPHA8:               return "GL_SRGB8_ALPHA8";
+    case GL_R16F:                       return "GL_R16F";
+    case GL_RG16F:                      return "GL_RG16F";
+    case GL_RGBA16F:                    return "GL_RGBA16F";
+    case GL_R32F:                       return "GL_R32F";
+    case GL_RGBA32F:                    return "GL_RGBA32F";
+    case GL_R11F_G11F_B10F:             return "GL_R11F_G11F_B10F";
+    case GL_RGB10_A2:                   return "GL_RGB10_A2";
+    case GL_DEPTH_COMPONENT24:          return "GL_DEPTH_COMPONENT24";
+    case GL_DEPTH24_STENCIL8:           return "GL_DEPTH24_STENCIL8";
+    case GL_DEPTH_COMPONENT32F:         return "GL_DEPTH_COMPONENT32F";
+    case GL_ARRAY_BUFFER:               return "GL_ARRAY_BUFFER";
+    case GL_ELEMENT_ARRAY_BUFFER:       return "GL_ELEMENT_ARRAY_BUFFER";
+    case GL_UNIFORM_BUFFER:             return "GL_UNIFORM_BUFFER";
+    case GL_SHADER_STORAGE_BUFFER:      return "GL_SHADER_STORAGE_BUFFER";
+    case GL_DRAW_INDIRECT_BUFFER:       return "GL_DRAW_INDIRECT_BUFFER";
+    case GL_DISPATCH_INDIRECT_BUFFER:   return "GL_DISPATCH_INDIRECT_BUFFER";
+    case GL_PIXEL_PACK_BUFFER:          return "GL_PIXEL_PACK_BUFFER";
+    case GL_PIXEL_UNPACK_BUFFER:        return "GL_PIXEL_UNPACK_BUFFER";
+    case GL_TEXTURE_BUFFER:             return "GL_TEXTURE_BUFFER";
+    default:                            return "other";
+    }
+}
+
+unsigned int gl_texel_bytes(GLenum format) {
+    switch (format)
+    {
+    case GL_RED:
+    case GL_R8:                  return 1;
+    case GL_RG:
+    case GL_RG8:
+    case GL_R16F:                return 2;
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_DEPTH_COMPONENT24:   return 3;
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB10_A2:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT32F:  return 4;
+    case GL_RGB16F:              return 6;
+    case GL_RGBA16F:
+    case GL_RG32F:               return 8;
+    case GL_RGBA32F:             return 16;
+    default:                     return 4;
+    }
+}
+
+uint64_t gl_texture_bytes(GLsizei width, GLsizei height, GLenum format, bool mipmaps) {
+    const uint64_t texel = gl_texel_bytes(format);
+    uint64_t bytes = 0;
+    for (;;) {
+        bytes += (uint64_t)width * height * texel;
+        if (!mipmaps || (width == 1 && height == 1)) {
+            return bytes;
+        }
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+void gl_track_buffer(GLuint id, GLenum target, uint64_t bytes) {
+    Memory::trackGpu(GpuResource::Buffer, id, bytes, gl_enum_name(target), Memory::currentTag());
+}
+
+void gl_untrack_buffer(GLuint id) {
+    Memory::untrackGpu(GpuResource::Buffer, id);
+}
+
+void gl_track_texture(GLuint id, GLsizei width, GLsizei height, GLenum format, bool mipmaps) {
+    Memory::trackGpu(GpuResource::Texture, id, gl_texture_bytes(width, height, format, mipmaps), gl_enum_name(format),
+                     MemoryTag::Texture);
+}
+
+void gl_untrack_texture(GLuint id) {
+    Memory::untrackGpu(GpuResource::Texture, id);
+}
@@ -8,10 +8,11 @@
 #include <iostream>
 
 #include "log.h"
+#include "../core/Memory.h"
 
 #define GL_CHECK_ERRORS() _glCheckErrors(__FILE__, __LINE__)
 #define GL_CLEAR_ERRORS() _glClearErrors()
-#define GL_LOG(message, ...) gl_log(message, ##__VA_ARGS__)
+#define GL_LOG(...) GL_LOG_INFO(__VA_ARGS__)
 
 #define GL_CALL(func) \
     GL_CLEAR_ERRORS(); \
@@ -34,12 +35,28 @@ void processInput(GLFWwindow *window);
 
 void gradualColorCycle(RGB rgb, glm::vec3* color);
 
-void _update_fps_counter(GLFWwindow* window);
-
 void _glCheckErrors(const char *filename, int line);
 
 void _glClearErrors();
 
 void _update_delta_time(float* deltaTime, float* lastFrame);
 
+/// Name of a buffer target or texture format for the memory report, "GL_RGBA", "GL_ARRAY_BUFFER", ...
+const char* gl_enum_name(GLenum value);
+
+/// Bytes per texel of a sized internal format, or of an unsized one with 8 bits per channel
+unsigned int gl_texel_bytes(GLenum format);
+
+/// Bytes of a 2D texture, with its mip chain if `mipmaps`
+uint64_t gl_texture_bytes(GLsizei width, GLsizei height, GLenum format, bool mipmaps);
+
+/// Reports a buffer's data store to Memory, charged to the calling thread's MemoryTag
+void gl_track_buffer(GLuint id, GLenum target, uint64_t bytes);
+
+void gl_untrack_buffer(GLuint id);
+
+void gl_track_texture(GLuint id, GLsizei width, GLsizei height, GLenum format, bool mipmaps);
+
+void gl_untrack_texture(GLuint id);
+
 #endif // !_UTILS_H_
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "ClusteredLighting.h"
+
+#include "../opengl/log.h"
+#include "../opengl/utils.h"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// GPU counters, in the order of the Counters block in cluster_lights.comp
+enum ClusterCounter {
+    kUsed,
+    kDropped,
+    kCounterCount
+};
+
+struct ViewLight {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 direction;
+    float cosOuter;
+};
+
+ViewLight to_view(const Light& light, const glm::mat4& view) {
+    ViewLight result;
+    result.center = glm::vec3(view * glm::vec4(glm::vec3(light.positionRadius), 1.0f));
+    result.radius = light.positionRadius.w;
+    result.direction = glm::mat3(view) * glm::vec3(light.spot);
+    result.cosOuter = light.spot.w;
+    return result;
+}
+
+}
+
+ClusterGrid::ClusterGrid()
+    : m_config(), m_bounds(), m_projection(1.0f), m_near(0.0f), m_far(0.0f), m_sliceScale(0.0f), m_sliceBias(0.0f)
+{}
+
+void ClusterGrid::build(const glm::mat4& projection, const ClusterGridConfig& config) {
+    m_config = config;
+    m_projection = projection;
+    // GL perspective: [2][2] = -(f + n) / (f - n), [3][2] = -2fn / (f - n)
+    m_near = projection[3][2] / (projection[2][2] - 1.0f);
+    m_far = projection[3][2] / (projection[2][2] + 1.0f);
+    const float logRange = std::log(m_far / m_near);
+    m_sliceScale = (float)config.slices / logRange;
+    m_sliceBias = -(float)config.slices * std::log(m_near) / logRange;
+
+    // view rays through the tile corners, scaled to each slice's depths
+    const glm::mat4 inverse = glm::inverse(projection);
+    auto ray = [&inverse](float x, float y) {
+        const glm::vec4 p = inverse * glm::vec4(x, y, -1.0f, 1.0f);
+        const glm::vec3 v = glm::vec3(p) / p.w;
+        return v / -v.z;
+    };
+
+    m_bounds.resize((size_t)config.tilesX * config.tilesY * config.slices);
+    for (uint32_t y = 0; y < config.tilesY; y++) {
+        for (uint32_t x = 0; x < config.tilesX; x++) {
+            const float x0 = -1.0f + 2.0f * x / config.tilesX, x1 = -1.0f + 2.0f * (x + 1) / config.tilesX;
+            const float y0 = -1.0f + 2.0f * y / config.tilesY, y1 = -1.0f + 2.0f * (y + 1) / config.tilesY;
+            const glm::vec3 corners[4] = { ray(x0, y0), ray(x1, y0), ray(x0, y1), ray(x1, y1) };
+
+            for (uint32_t slice = 0; slice < config.slices; slice++) {
+                const float depths[2] = { sliceDepth(slice), sliceDepth(slice + 1) };
+                glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+                for (const glm::vec3& corner : corners) {
+                    for (float depth : depths) {
+                        lo = glm::min(lo, corner * depth);
+                        hi = glm::max(hi, corner * depth);
+                    }
+                }
+                m_bounds[clusterIndex(x, y, slice)] = { glm::vec4(lo, 0.0f), glm::vec4(hi, 0.0f) };
+            }
+        }
+    }
+}
+
+float ClusterGrid::sliceDepth(uint32_t slice) const {
+    return m_near * std::pow(m_far / m_near, (float)slice / m_config.slices);
+}
+
+void assign_lights(const ClusterGrid& grid, const std::vector<Light>& lights, const glm::mat4& view, LightGrid& out) {
+    const ClusterGridConfig& config = grid.config();
+    out.ranges.assign(grid.clusterCount(), { 0, 0 });
+    out.indices.clear();
+    out.dropped = 0;
+
+    std::vector<ViewLight> viewLights;
+    viewLights.reserve(lights.size());
+    std::vector<std::vector<uint32_t>> sliceLights(config.slices);
+    for (uint32_t i = 0; i < (uint32_t)lights.size(); i++) {
+        viewLights.push_back(to_view(lights[i], view));
+        const ViewLight& light = viewLights.back();
+        const float front = -light.center.z - light.radius, back = -light.center.z + light.radius;
+        if (back <= grid.nearDepth() || front >= grid.farDepth()) {
+            continue;
+        }
+        // the slices the sphere's depth range overlaps, one either side for the rounding
+        const float first = std::floor(std::log(std::max(front, grid.nearDepth())) * grid.sliceScale() + grid.sliceBias());
+        const float last = std::floor(std::log(std::min(back, grid.farDepth())) * grid.sliceScale() + grid.sliceBias());
+        const uint32_t begin = (uint32_t)std::max(first - 1.0f, 0.0f);
+        const uint32_t end = (uint32_t)std::min(last + 1.0f, (float)config.slices - 1.0f);
+        for (uint32_t slice = begin; slice <= end; slice++) {
+            sliceLights[slice].push_back(i);
+        }
+    }
+
+    for (uint32_t slice = 0; slice < config.slices; slice++) {
+        for (uint32_t y = 0; y < config.tilesY; y++) {
+            for (uint32_t x = 0; x < config.tilesX; x++) {
+                const uint32_t cluster = grid.clusterIndex(x, y, slice);
+                const ClusterBounds& bounds = grid.bounds()[cluster];
+                ClusterRange& range = out.ranges[cluster];
+                range.offset = (uint32_t)out.indices.size();
+                for (uint32_t i : sliceLights[slice]) {
+                    const ViewLight& light = viewLights[i];
+                    if (light_touches_cluster(bounds, light.center, light.radius, light.direction, light.cosOuter)) {
+                        out.indices.push_back(i);
+                    }
+                }
+                range.count = (uint32_t)out.indices.size() - range.offset;
+            }
+        }
+    }
+}
+
+GpuLightClusterer::GpuLightClusterer()
+    : m_program(0),
+      m_boundsBuffer(0),
+      m_rangeBuffer(0),
+      m_indexBuffer(0),
+      m_counterBuffer(0),
+      m_clusterCount(0),
+      m_indexCapacity(0),
+      m_viewLocation(-1),
+      m_lightCountLocation(-1),
+      m_clusterCountLocation(-1),
+      m_indexCapacityLocation(-1)
+{}
+
+GpuLightClusterer::~GpuLightClusterer() {
+    shutdown();
+}
+
+bool GpuLightClusterer::init(const std::string& computeShaderPath) {
+    shutdown();
+
+    std::ifstream file(computeShaderPath);
+    if (!file) {
+        gl_log_err("ERROR: could not open light clustering shader %s\n", computeShaderPath.c_str());
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string source = stream.str();
+    const char* code = source.c_str();
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    GL_CALL(glShaderSource(shader, 1, &code, nullptr));
+    GL_CALL(glCompileShader(shader));
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        gl_log_err("ERROR: light clustering shader %s failed to compile:\n%s\n", computeShaderPath.c_str(), infoLog);
+        glDeleteShader(shader);
+        return false;
+    }
+
+    m_program = glCreateProgram();
+    GL_CALL(glAttachShader(m_program, shader));
+    GL_CALL(glLinkProgram(m_program));
+    GL_CALL(glDeleteShader(shader));
+    glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(m_program, sizeof(infoLog), nullptr, infoLog);
+        gl_log_err("ERROR: light clustering program failed to link:\n%s\n", infoLog);
+        shutdown();
+        return false;
+    }
+
+    m_viewLocation = glGetUniformLocation(m_program, "view");
+    m_lightCountLocation = glGetUniformLocation(m_program, "lightCount");
+    m_clusterCountLocation = glGetUniformLocation(m_program, "clusterCount");
+    m_indexCapacityLocation = glGetUniformLocation(m_program, "indexCapacity");
+
+    GL_CALL(glGenBuffers(1, &m_counterBuffer));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, kCounterCount * sizeof(GLuint), nullptr, GL_DYNAMIC_READ));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    gl_track_buffer(m_counterBuffer, GL_SHADER_STORAGE_BUFFER, kCounterCount * sizeof(GLuint));
+    return true;
+}
+
+void GpuLightClusterer::shutdown() {
+    _deleteBuffers();
+    if (m_counterBuffer) {
+        gl_untrack_buffer(m_counterBuffer);
+        GL_CALL(glDeleteBuffers(1, &m_counterBuffer));
+        m_counterBuffer = 0;
+    }
+    if (m_program) {
+        GL_CALL(glDeleteProgram(m_program));
+        m_program = 0;
+    }
+}
+
+void GpuLightClusterer::setGrid(const ClusterGrid& grid, size_t indexCapacity) {
+    if (!m_program) {
+        return;
+    }
+    _deleteBuffers();
+
+    m_clusterCount = (uint32_t)grid.clusterCount();
+    m_indexCapacity = indexCapacity ? indexCapacity : (size_t)m_clusterCount * 64;
+
+    const uint64_t boundsBytes = m_clusterCount * sizeof(ClusterBounds);
+    const uint64_t rangeBytes = m_clusterCount * sizeof(ClusterRange);
+    const uint64_t indexBytes = m_indexCapacity * sizeof(uint32_t);
+
+    GLuint buffers[3];
+    GL_CALL(glGenBuffers(3, buffers));
+    m_boundsBuffer = buffers[0];
+    m_rangeBuffer = buffers[1];
+    m_indexBuffer = buffers[2];
+
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, boundsBytes, grid.bounds().data(), GL_STATIC_DRAW));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_rangeBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, rangeBytes, nullptr, GL_DYNAMIC_COPY));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, indexBytes, nullptr, GL_DYNAMIC_COPY));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    gl_track_buffer(m_boundsBuffer, GL_SHADER_STORAGE_BUFFER, boundsBytes);
+    gl_track_buffer(m_rangeBuffer, GL_SHADER_STORAGE_BUFFER, rangeBytes);
+    gl_track_buffer(m_indexBuffer, GL_SHADER_STORAGE_BUFFER, indexBytes);
+}
+
+void GpuLightClusterer::bin(GLuint lightBuffer, uint32_t lightCount, const glm::mat4& view) {
+    if (!m_program || m_clusterCount == 0) {
+        return;
+    }
+
+    const GLuint zeros[kCounterCount] = {};
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer));
+    GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    GL_CALL(glUseProgram(m_program));
+    GL_CALL(glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, &view[0][0]));
+    GL_CALL(glUniform1ui(m_lightCountLocation, lightCount));
+    GL_CALL(glUniform1ui(m_clusterCountLocation, m_clusterCount));
+    GL_CALL(glUniform1ui(m_indexCapacityLocation, (GLuint)m_indexCapacity));
+
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kLightBinding, lightBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kBoundsBinding, m_boundsBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kRangeBinding, m_rangeBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kIndexBinding, m_indexBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCounterBinding, m_counterBuffer));
+
+    GL_CALL(glDispatchCompute((m_clusterCount + kGroupSize - 1) / kGroupSize, 1, 1));
+    // the fragment shaders read the lists as storage buffers, the counters may be read back
+    GL_CALL(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT));
+}
+
+void GpuLightClusterer::bindResults() const {
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kRangeBinding, m_rangeBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kIndexBinding, m_indexBuffer));
+}
+
+void GpuLightClusterer::read(LightGrid& grid) const {
+    grid.ranges.assign(m_clusterCount, { 0, 0 });
+    grid.indices.clear();
+    grid.dropped = 0;
+    if (!m_program || m_clusterCount == 0) {
+        return;
+    }
+
+    GLuint counters[kCounterCount] = {};
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer));
+    GL_CALL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), counters));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_rangeBuffer));
+    GL_CALL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_clusterCount * sizeof(ClusterRange), grid.ranges.data()));
+
+    // `used` keeps counting past the capacity
+    grid.indices.resize(std::min((size_t)counters[kUsed], m_indexCapacity));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexBuffer));
+    GL_CALL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, grid.indices.size() * sizeof(uint32_t), grid.indices.data()));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    grid.dropped = counters[kDropped];
+}
+
+uint64_t GpuLightClusterer::byteSize() const {
+    return m_clusterCount * (sizeof(ClusterBounds) + sizeof(ClusterRange)) + m_indexCapacity * sizeof(uint32_t);
+}
+
+void GpuLightClusterer::_deleteBuffers() {
+    for (GLuint* buffer : { &m_boundsBuffer, &m_rangeBuffer, &m_indexBuffer }) {
+        if (*buffer) {
+            gl_untrack_buffer(*buffer);
+            GL_CALL(glDeleteBuffers(1, buffer));
+            *buffer = 0;
+        }
+    }
+    m_clusterCount = 0;
+    m_indexCapacity = 0;
+}
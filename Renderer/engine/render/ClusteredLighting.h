@@ -0,0 +1,212 @@
+#ifndef _CLUSTERED_LIGHTING_H_
+#define _CLUSTERED_LIGHTING_H_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Light.h"
+
+struct ClusterGridConfig {
+    uint32_t tilesX = 16;
+    uint32_t tilesY = 9;
+    uint32_t slices = 24;
+};
+
+/// View space box of one froxel, std430 (vec4 for the alignment, w unused)
+struct ClusterBounds {
+    glm::vec4 minPoint;
+    glm::vec4 maxPoint;
+};
+
+/// Lights of one cluster: `count` entries of the index list from `offset`
+struct ClusterRange {
+    uint32_t offset;
+    uint32_t count;
+};
+
+/**
+ * @brief The froxels of a perspective projection: screen tiles times exponential depth slices
+ *
+ * Slice k covers view depths near * (far / near)^(k / slices) to the next one, so froxels
+ * stay about as deep as they are wide. A fragment at view depth d is in slice
+ * `log(d) * sliceScale() + sliceBias()`. Clusters are numbered x fastest, then y, then slice.
+ */
+class ClusterGrid {
+public:
+    ClusterGrid();
+
+    /// Recomputes every froxel box, near and far come from `projection`
+    void build(const glm::mat4& projection, const ClusterGridConfig& config);
+
+    const ClusterGridConfig& config() const { return m_config; }
+
+    size_t clusterCount() const { return m_bounds.size(); }
+
+    const std::vector<ClusterBounds>& bounds() const { return m_bounds; }
+
+    const glm::mat4& projection() const { return m_projection; }
+
+    float nearDepth() const { return m_near; }
+
+    float farDepth() const { return m_far; }
+
+    float sliceScale() const { return m_sliceScale; }
+
+    float sliceBias() const { return m_sliceBias; }
+
+    /// View depth where `slice` starts, sliceDepth(slices) is the far plane
+    float sliceDepth(uint32_t slice) const;
+
+    uint32_t clusterIndex(uint32_t x, uint32_t y, uint32_t slice) const {
+        return (slice * m_config.tilesY + y) * m_config.tilesX + x;
+    }
+
+private:
+    ClusterGridConfig m_config;
+    std::vector<ClusterBounds> m_bounds;
+    glm::mat4 m_projection;
+    float m_near;
+    float m_far;
+    float m_sliceScale;
+    float m_sliceBias;
+};
+
+/**
+ * @brief Whether a light reaches a froxel, in view space
+ *
+ * Sphere against the froxel box, then for spot lights the cone against the box's bounding
+ * sphere. Conservative: it may keep a light that misses, never drops one that hits.
+ * cluster_lights.comp runs the same test. `slack` grows (or shrinks, when negative) the light
+ * radius and the box's sphere, to tell float noise from real differences in validation.
+ */
+inline bool light_touches_cluster(const ClusterBounds& bounds, const glm::vec3& center, float radius,
+                                  const glm::vec3& direction, float cosOuter, float slack = 0.0f)
+{
+    const glm::vec3 lo(bounds.minPoint), hi(bounds.maxPoint);
+    const glm::vec3 closest = glm::min(glm::max(center, lo), hi);
+    const glm::vec3 offset = closest - center;
+    const float reach = std::max(radius + slack, 0.0f);
+    if (glm::dot(offset, offset) > reach * reach) {
+        return false;
+    }
+    if (cosOuter <= -1.0f) {
+        return true;
+    }
+
+    const glm::vec3 boxCenter = (lo + hi) * 0.5f;
+    const float boxRadius = std::max(glm::length(hi - lo) * 0.5f + slack, 0.0f);
+    const glm::vec3 toBox = boxCenter - center;
+    const float along = glm::dot(toBox, direction);
+    const float sinOuter = std::sqrt(std::max(1.0f - cosOuter * cosOuter, 0.0f));
+    const float fromCone = cosOuter * std::sqrt(std::max(glm::dot(toBox, toBox) - along * along, 0.0f)) - along * sinOuter;
+    return fromCone <= boxRadius && along >= -boxRadius;
+}
+
+/**
+ * @brief Light lists of every cluster: ranges into one flat index list
+ *
+ * Each cluster's lights are in ascending light order. `dropped` counts the entries that did
+ * not fit the GPU index list; a frame with drops misses light in some clusters.
+ */
+struct LightGrid {
+    std::vector<ClusterRange> ranges;
+    std::vector<uint32_t> indices;
+    size_t dropped = 0;
+};
+
+/**
+ * @brief CPU reference of the light binning, what GpuLightClusterer is validated against
+ *
+ * Lights are first sorted into the depth slices their sphere overlaps, then each cluster
+ * tests the lights of its slice.
+ */
+void assign_lights(const ClusterGrid& grid, const std::vector<Light>& lights, const glm::mat4& view, LightGrid& out);
+
+/**
+ * @brief Bins lights into the clusters of a ClusterGrid with a compute pass
+ * (assets/shaders/shading/cluster_lights.comp)
+ *
+ * One invocation per cluster tests every light, in batches the work group shares through
+ * shared memory, counts its lights, reserves that many entries of the index list with one
+ * atomic and writes them in a second sweep. The shading pass reads the ranges and indices
+ * from kRangeBinding and kIndexBinding (bindResults).
+ *
+ * @note Must be initialized and used on the thread that owns the GL context.
+ */
+class GpuLightClusterer {
+public:
+    static constexpr GLuint kLightBinding = 0;
+    static constexpr GLuint kBoundsBinding = 1;
+    static constexpr GLuint kRangeBinding = 2;
+    static constexpr GLuint kIndexBinding = 3;
+    static constexpr GLuint kCounterBinding = 4;
+    static constexpr GLuint kGroupSize = 64;
+
+    GpuLightClusterer();
+
+    GpuLightClusterer(const GpuLightClusterer& other) = delete;
+
+    GpuLightClusterer& operator=(const GpuLightClusterer& other) = delete;
+
+    ~GpuLightClusterer();
+
+    /**
+     * @brief Compiles the compute shader and creates the counters, needs a current context
+     */
+    bool init(const std::string& computeShaderPath);
+
+    void shutdown();
+
+    bool initialized() const { return m_program != 0; }
+
+    /**
+     * @brief Uploads the froxel boxes and sizes the outputs
+     *
+     * @param indexCapacity entries of the index list, 0 for 64 per cluster
+     */
+    void setGrid(const ClusterGrid& grid, size_t indexCapacity = 0);
+
+    /**
+     * @brief Bins the first `lightCount` lights of `lightBuffer` (the Light layout), seen from `view`
+     *
+     * Issues the GL_SHADER_STORAGE_BARRIER_BIT barrier the shading pass needs.
+     */
+    void bin(GLuint lightBuffer, uint32_t lightCount, const glm::mat4& view);
+
+    /// Binds the ranges and indices for the shading pass
+    void bindResults() const;
+
+    /// Reads the lists of the last `bin` back; waits for the GPU
+    void read(LightGrid& grid) const;
+
+    size_t clusterCount() const { return m_clusterCount; }
+
+    size_t indexCapacity() const { return m_indexCapacity; }
+
+    /// Bounds, ranges and index list
+    uint64_t byteSize() const;
+
+private:
+    GLuint m_program;
+    GLuint m_boundsBuffer;
+    GLuint m_rangeBuffer;
+    GLuint m_indexBuffer;
+    GLuint m_counterBuffer;
+    uint32_t m_clusterCount;
+    size_t m_indexCapacity;
+    GLint m_viewLocation;
+    GLint m_lightCountLocation;
+    GLint m_clusterCountLocation;
+    GLint m_indexCapacityLocation;
+
+    void _deleteBuffers();
+};
+
+#endif // !_CLUSTERED_LIGHTING_H_
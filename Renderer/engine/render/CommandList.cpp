@@ -0,0 +1,206 @@
+#include "CommandList.h"
+
+#include "../opengl/log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint64_t hash_name(const char* name, size_t& length) {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ull;
+    const char* c = name;
+    for (; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+    }
+    length = (size_t)(c - name);
+    return hash;
+}
+
+}
+
+CommandList::CommandList(size_t blockSize)
+    : m_allocator(blockSize),
+      m_packets(),
+      m_start(),
+      m_recordNs(0),
+      m_key(0),
+      m_pipeline(0),
+      m_vertexArray(0),
+      m_zeroAttributes(0),
+      m_zeroIntAttributes(0),
+      m_textures(),
+      m_uniforms(),
+      m_uniformCount(0),
+      m_textureSnapshot(nullptr),
+      m_uniformSnapshot(nullptr)
+{}
+
+void CommandList::begin() {
+    m_allocator.reset();
+    m_packets.clear();
+    m_key = 0;
+    m_pipeline = 0;
+    m_vertexArray = 0;
+    m_zeroAttributes = 0;
+    m_zeroIntAttributes = 0;
+    std::fill(m_textures, m_textures + kMaxTextureUnits, 0u);
+    m_uniformCount = 0;
+    m_textureSnapshot = nullptr;
+    m_uniformSnapshot = nullptr;
+    m_start = Clock::now();
+}
+
+void CommandList::end() {
+    m_recordNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+}
+
+void CommandList::bindPipeline(uint32_t pipeline) {
+    if (pipeline == m_pipeline) {
+        return;
+    }
+    m_pipeline = pipeline;
+    m_uniformCount = 0;
+    m_uniformSnapshot = nullptr;
+}
+
+void CommandList::bindVertexArray(uint32_t vertexArray) {
+    m_vertexArray = vertexArray;
+}
+
+void CommandList::bindTexture(unsigned int unit, uint32_t texture) {
+    if (unit >= kMaxTextureUnits) {
+        gl_log_err("ERROR: command list texture unit %u out of range (%u units)\n", unit, kMaxTextureUnits);
+        return;
+    }
+    if (m_textures[unit] != texture) {
+        m_textures[unit] = texture;
+        m_textureSnapshot = nullptr;
+    }
+}
+
+void CommandList::_setUniform(const char* name, UniformType type, const void* data, size_t size) {
+    size_t length = 0;
+    const uint64_t hash = hash_name(name, length);
+
+    UniformValue* value = m_allocator.allocateArray<UniformValue>(1);
+    char* nameCopy = m_allocator.allocateArray<char>(length + 1);
+    std::memcpy(nameCopy, name, length + 1);
+    void* dataCopy = m_allocator.allocate(size, alignof(float));
+    std::memcpy(dataCopy, data, size);
+    *value = { hash, nameCopy, dataCopy, type };
+
+    m_uniformSnapshot = nullptr;
+    for (uint16_t i = 0; i < m_uniformCount; i++) {
+        if (m_uniforms[i]->nameHash == hash) {
+            m_uniforms[i] = value;
+            return;
+        }
+    }
+    if (m_uniformCount == kMaxUniforms) {
+        gl_log_err("ERROR: command list holds at most %u uniforms per pipeline, dropped %s\n", kMaxUniforms, name);
+        return;
+    }
+    m_uniforms[m_uniformCount++] = value;
+}
+
+void CommandList::setUniform(const char* name, int value) {
+    _setUniform(name, UniformType::Int, &value, sizeof(value));
+}
+
+void CommandList::setUniform(const char* name, float value) {
+    _setUniform(name, UniformType::Float, &value, sizeof(value));
+}
+
+void CommandList::setUniform(const char* name, const glm::vec2& value) {
+    _setUniform(name, UniformType::Vec2, &value[0], sizeof(value));
+}
+
+void CommandList::setUniform(const char* name, const glm::vec3& value) {
+    _setUniform(name, UniformType::Vec3, &value[0], sizeof(value));
+}
+
+void CommandList::setUniform(const char* name, const glm::vec4& value) {
+    _setUniform(name, UniformType::Vec4, &value[0], sizeof(value));
+}
+
+void CommandList::setUniform(const char* name, const glm::mat3& value) {
+    _setUniform(name, UniformType::Mat3, &value[0][0], sizeof(value));
+}
+
+void CommandList::setUniform(const char* name, const glm::mat4& value) {
+    _setUniform(name, UniformType::Mat4, &value[0][0], sizeof(value));
+}
+
+DrawPacket& CommandList::_draw() {
+    if (!m_textureSnapshot) {
+        uint32_t* textures = m_allocator.allocateArray<uint32_t>(kMaxTextureUnits);
+        std::copy(m_textures, m_textures + kMaxTextureUnits, textures);
+        m_textureSnapshot = textures;
+    }
+    if (!m_uniformSnapshot) {
+        const UniformValue** uniforms = m_allocator.allocateArray<const UniformValue*>(std::max<size_t>(m_uniformCount, 1));
+        std::copy(m_uniforms, m_uniforms + m_uniformCount, uniforms);
+        m_uniformSnapshot = uniforms;
+    }
+
+    m_packets.emplace_back();
+    DrawPacket& packet = m_packets.back();
+    packet.key = m_key;
+    packet.sequence = (uint32_t)(m_packets.size() - 1);
+    packet.pipeline = m_pipeline;
+    packet.vertexArray = m_vertexArray;
+    packet.textures = m_textureSnapshot;
+    packet.uniforms = m_uniformSnapshot;
+    packet.uniformCount = m_uniformCount;
+    packet.zeroAttributes = m_zeroAttributes;
+    packet.zeroIntAttributes = m_zeroIntAttributes;
+    return packet;
+}
+
+void CommandList::drawArrays(PrimitiveType primitive, uint32_t first, uint32_t count, uint32_t instances) {
+    DrawPacket& packet = _draw();
+    packet.kind = DrawKind::Arrays;
+    packet.primitive = primitive;
+    packet.indexType = IndexType::UInt32;
+    packet.first = first;
+    packet.count = count;
+    packet.instances = instances;
+}
+
+void CommandList::drawElements(PrimitiveType primitive, uint32_t count, IndexType indexType, uint32_t byteOffset,
+                               uint32_t instances)
+{
+    DrawPacket& packet = _draw();
+    packet.kind = DrawKind::Elements;
+    packet.primitive = primitive;
+    packet.indexType = indexType;
+    packet.first = byteOffset;
+    packet.count = count;
+    packet.instances = instances;
+}
+
+void CommandQueue::clear() {
+    m_entries.clear();
+    m_lists = 0;
+    m_recordNs = 0;
+    m_sortNs = 0;
+}
+
+void CommandQueue::submit(const CommandList& list) {
+    const uint64_t listIndex = m_lists++;
+    const DrawPacket* packets = list.packets();
+    for (size_t i = 0; i < list.packetCount(); i++) {
+        m_entries.push_back({ packets[i].key, listIndex << 32 | packets[i].sequence, &packets[i] });
+    }
+    m_recordNs += (uint64_t)(list.recordMs() * 1e6);
+}
+
+void CommandQueue::sort() {
+    const auto start = std::chrono::steady_clock::now();
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key < b.key : a.order < b.order;
+    });
+    m_sortNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,221 @@
+#ifndef _COMMAND_LIST_H_
+#define _COMMAND_LIST_H_
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../core/LinearAllocator.h"
+
+enum class PrimitiveType : uint8_t {
+    Triangles,
+    Lines,
+    Points
+};
+
+enum class IndexType : uint8_t {
+    UInt16,
+    UInt32
+};
+
+enum class UniformType : uint8_t {
+    Int,
+    Float,
+    Vec2,
+    Vec3,
+    Vec4,
+    Mat3,
+    Mat4
+};
+
+/// One uniform value, immutable once recorded; draws that share it share the pointer
+struct UniformValue {
+    uint64_t nameHash;
+    const char* name;       // copied into the list's allocator
+    const void* data;
+    UniformType type;
+};
+
+enum class DrawKind : uint8_t {
+    Arrays,
+    Elements
+};
+
+/**
+ * @brief A draw with every piece of state it needs, so packets can replay in any order
+ *
+ * Handles are backend object names (GL names today). State is held as pointers to
+ * snapshots in the list's allocator: consecutive draws that changed nothing point at the
+ * same snapshot, which is also how the replay spots redundant state.
+ */
+struct DrawPacket {
+    uint64_t key;
+    uint32_t sequence;                  // record order, keeps equal keys stable
+    uint32_t pipeline;
+    uint32_t vertexArray;
+    const uint32_t* textures;           // kMaxTextureUnits names, 0 = unit not sampled
+    const UniformValue* const* uniforms;
+    uint16_t uniformCount;
+    uint8_t zeroAttributes;             // generic attribute locations that read zero, as float
+    uint8_t zeroIntAttributes;          // ... as integer (glVertexAttribIPointer inputs)
+    DrawKind kind;
+    PrimitiveType primitive;
+    IndexType indexType;
+    uint32_t first;                     // first vertex, or byte offset into the index buffer
+    uint32_t count;
+    uint32_t instances;
+};
+
+/**
+ * @brief Draws recorded on any thread, replayed later on the render thread
+ *
+ * Recording touches no graphics API: the list tracks the bound pipeline, vertex array,
+ * textures and uniforms like a context would and turns every draw into a DrawPacket.
+ * Uniforms belong to the pipeline they were set on; binding a different pipeline starts
+ * from none.
+ *
+ *     list.begin();
+ *     list.bindPipeline(shader.id());
+ *     list.bindTexture(0, texture.id());
+ *     list.setUniform("mvp", mvp);
+ *     list.drawArrays(PrimitiveType::Triangles, 0, 36);
+ *     list.end();
+ *     queue.submit(list);
+ *
+ * One list per recording thread; a list is not thread safe, and must stay alive (and not
+ * be reset) until the queue it was submitted to has been replayed.
+ */
+class CommandList {
+public:
+    static constexpr unsigned int kMaxTextureUnits = 8;
+    static constexpr unsigned int kMaxUniforms = 32;
+
+    explicit CommandList(size_t blockSize = LinearAllocator::kDefaultBlockSize);
+
+    CommandList(const CommandList& other) = delete;
+
+    CommandList& operator=(const CommandList& other) = delete;
+
+    /// Drops the previous recording and starts timing this one
+    void begin();
+
+    /// Stops timing, see recordMs
+    void end();
+
+    /// Replay order of the following draws, lowest first; see make_sort_key
+    void setSortKey(uint64_t key) { m_key = key; }
+
+    void bindPipeline(uint32_t pipeline);
+
+    void bindVertexArray(uint32_t vertexArray);
+
+    void bindTexture(unsigned int unit, uint32_t texture);
+
+    /// Generic vertex attributes in the masks read zero in the following draws (locations
+    /// the vertex array does not feed)
+    void setZeroAttributes(uint8_t floatMask, uint8_t integerMask) {
+        m_zeroAttributes = floatMask;
+        m_zeroIntAttributes = integerMask;
+    }
+
+    void setUniform(const char* name, int value);
+    void setUniform(const char* name, float value);
+    void setUniform(const char* name, const glm::vec2& value);
+    void setUniform(const char* name, const glm::vec3& value);
+    void setUniform(const char* name, const glm::vec4& value);
+    void setUniform(const char* name, const glm::mat3& value);
+    void setUniform(const char* name, const glm::mat4& value);
+
+    void drawArrays(PrimitiveType primitive, uint32_t first, uint32_t count, uint32_t instances = 1);
+
+    void drawElements(PrimitiveType primitive, uint32_t count, IndexType indexType, uint32_t byteOffset = 0,
+                      uint32_t instances = 1);
+
+    size_t packetCount() const { return m_packets.size(); }
+
+    const DrawPacket* packets() const { return m_packets.data(); }
+
+    /// Allocator bytes used by this recording
+    size_t bytesUsed() const { return m_allocator.used(); }
+
+    /// Time between begin and end
+    double recordMs() const { return m_recordNs * 1e-6; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    LinearAllocator m_allocator;
+    std::vector<DrawPacket> m_packets;  // capacity kept between recordings
+    Clock::time_point m_start;
+    uint64_t m_recordNs;
+
+    // current state, as a context would hold it
+    uint64_t m_key;
+    uint32_t m_pipeline;
+    uint32_t m_vertexArray;
+    uint8_t m_zeroAttributes;
+    uint8_t m_zeroIntAttributes;
+    uint32_t m_textures[kMaxTextureUnits];
+    const UniformValue* m_uniforms[kMaxUniforms];
+    uint16_t m_uniformCount;
+
+    // snapshots of the above, null once the state changed
+    const uint32_t* m_textureSnapshot;
+    const UniformValue* const* m_uniformSnapshot;
+
+    void _setUniform(const char* name, UniformType type, const void* data, size_t size);
+
+    DrawPacket& _draw();
+};
+
+/**
+ * @brief 64-bit key: layer, then pipeline, then material, then depth (front to back)
+ *
+ * Sorting packets by it groups draws by state so the replay binds each pipeline and
+ * material once per layer.
+ */
+inline uint64_t make_sort_key(uint8_t layer, uint32_t pipeline, uint32_t material, float depth01) {
+    const float clamped = depth01 < 0.0f ? 0.0f : (depth01 > 1.0f ? 1.0f : depth01);
+    return (uint64_t)layer << 56 | (uint64_t)(pipeline & 0xffff) << 40 | (uint64_t)(material & 0xffff) << 24 |
+           (uint64_t)(clamped * 16777215.0f);
+}
+
+/**
+ * @brief The lists of one frame, merged into a single sorted packet stream
+ */
+class CommandQueue {
+public:
+    struct Entry {
+        uint64_t key;
+        uint64_t order;     // list index, then record sequence
+        const DrawPacket* packet;
+    };
+
+    void clear();
+
+    /// Keeps a pointer to the list's packets, the list must outlive the replay
+    void submit(const CommandList& list);
+
+    /// Orders by key; equal keys keep submission, then record order
+    void sort();
+
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+    size_t listCount() const { return m_lists; }
+
+    /// Sum of the recordMs of the submitted lists
+    double recordMs() const { return m_recordNs * 1e-6; }
+
+    double sortMs() const { return m_sortNs * 1e-6; }
+
+private:
+    std::vector<Entry> m_entries;
+    size_t m_lists = 0;
+    uint64_t m_recordNs = 0;
+    uint64_t m_sortNs = 0;
+};
+
+#endif // !_COMMAND_LIST_H_
@@ -0,0 +1,329 @@
+#include "DeferredRenderer.h"
+
+#include "../core/Profiler.h"
+#include "../opengl/GpuProfiler.h"
+#include "../opengl/RenderStats.h"
+
+namespace {
+
+bool linked(const Shader& shader) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(shader.id(), GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+}
+
+const char* shading_path_name(ShadingPath path) {
+    switch (path)
+    {
+    case ShadingPath::Forward:              return "forward";
+    case ShadingPath::DeferredFullScreen:   return "deferred";
+    case ShadingPath::DeferredVolumes:      return "deferred volumes";
+    case ShadingPath::Clustered:            return "clustered";
+    default:                                return "unknown";
+    }
+}
+
+DeferredRenderer::DeferredRenderer()
+    : m_initialized(false),
+      m_forward(),
+      m_geometry(),
+      m_fullScreen(),
+      m_volume(),
+      m_clustered(),
+      m_gbuffer(),
+      m_lights(),
+      m_lightInfo(),
+      m_lightCount(0),
+      m_emptyVAO(),
+      m_volumeVAO(),
+      m_volumeVertices(),
+      m_volumeIndices(),
+      m_clusterConfig(),
+      m_clusterGrid(),
+      m_clusterer(),
+      m_ambient(0.05f),
+      m_sunDirection(0.0f, -1.0f, 0.0f),
+      m_sunColor(0.0f),
+      m_shadows(nullptr)
+{}
+
+bool DeferredRenderer::init(const std::string& shaderDirectory) {
+    const std::string geometryVert = shaderDirectory + "/geometry.vert";
+    const std::string lightVert = shaderDirectory + "/light.vert";
+    const std::string lightingFrag = shaderDirectory + "/lighting.frag";
+
+    m_forward = std::make_unique<Shader>(geometryVert, lightingFrag, std::vector<std::string>{ "FORWARD" });
+    m_geometry = std::make_unique<Shader>(geometryVert, shaderDirectory + "/gbuffer.frag");
+    m_fullScreen = std::make_unique<Shader>(lightVert, lightingFrag);
+    m_volume = std::make_unique<Shader>(lightVert, lightingFrag, std::vector<std::string>{ "LIGHT_VOLUME" });
+    m_clustered = std::make_unique<Shader>(geometryVert, lightingFrag, std::vector<std::string>{ "FORWARD", "CLUSTERED" });
+
+    for (const Shader* shader : { m_forward.get(), m_geometry.get(), m_fullScreen.get(), m_volume.get(), m_clustered.get() }) {
+        if (!linked(*shader)) {
+            gl_log_err("ERROR: could not build the shading shaders in %s\n", shaderDirectory.c_str());
+            return false;
+        }
+    }
+
+    if (!m_clusterer.init(shaderDirectory + "/cluster_lights.comp")) {
+        return false;
+    }
+    _createVolumeMesh();
+
+    m_lightInfo.type = SHADER_STORAGE_BUFFER;
+    m_lightInfo.target = GL_SHADER_STORAGE_BUFFER;
+    m_lightInfo.usage = GL_DYNAMIC_DRAW;
+    setLights({});
+
+    m_initialized = true;
+    return true;
+}
+
+void DeferredRenderer::setLights(const std::vector<Light>& lights) {
+    m_lightCount = lights.size();
+    // never empty, binding a zero sized buffer is an error
+    m_lightInfo.data.assign(lights.begin(), lights.end());
+    if (m_lightInfo.data.empty()) {
+        m_lightInfo.data.push_back(point_light(glm::vec3(0.0f), 0.0f, glm::vec3(0.0f)));
+    }
+    m_lightInfo.size = (unsigned long)(m_lightInfo.data.size() * sizeof(Light));
+    m_lights.setBuffer(m_lightInfo);
+}
+
+void DeferredRenderer::setSun(const glm::vec3& direction, const glm::vec3& color) {
+    m_sunDirection = glm::normalize(direction);
+    m_sunColor = color;
+}
+
+void DeferredRenderer::setClusterConfig(const ClusterGridConfig& config) {
+    m_clusterConfig = config;
+    // rebuilt by the next clustered frame
+    m_clusterGrid = ClusterGrid();
+}
+
+void DeferredRenderer::setMaterial(const Shader& shader, const glm::vec3& albedo, float specular, float shininess) {
+    shader.setUniform("albedo", albedo);
+    shader.setUniform("specular", specular);
+    shader.setUniform("shininess", shininess);
+}
+
+void DeferredRenderer::render(ShadingPath path, const ShadingView& view, const std::function<void(const Shader&)>& drawScene) {
+    if (!m_initialized) {
+        return;
+    }
+
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    const GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_lights.id());
+
+    if (path == ShadingPath::Forward) {
+        _renderForward(view, drawScene);
+    }
+    else if (path == ShadingPath::Clustered) {
+        _renderClustered(view, drawScene);
+    }
+    else {
+        _renderDeferred(path, view, drawScene);
+    }
+
+    for (GLuint binding = 0; binding <= ShadowRenderer::kViewBinding; binding++) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+    }
+    if (m_shadows) {
+        glActiveTexture(GL_TEXTURE0 + ShadowRenderer::kAtlasUnit);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+}
+
+void DeferredRenderer::_renderForward(const ShadingView& view, const std::function<void(const Shader&)>& drawScene) {
+    PROFILE_SCOPE("forward shading");
+    PROFILE_GPU_SCOPE("forward shading");
+
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    m_forward->use();
+    m_forward->setUniform("viewProjection", view.projection * view.view);
+    _applyLighting(*m_forward, view);
+    m_forward->setUniform("lightCount", (int)m_lightCount);
+    drawScene(*m_forward);
+}
+
+void DeferredRenderer::_renderClustered(const ShadingView& view, const std::function<void(const Shader&)>& drawScene) {
+    if (m_clusterGrid.clusterCount() == 0 || m_clusterGrid.projection() != view.projection) {
+        m_clusterGrid.build(view.projection, m_clusterConfig);
+        m_clusterer.setGrid(m_clusterGrid);
+    }
+
+    {
+        PROFILE_SCOPE("light binning");
+        PROFILE_GPU_SCOPE("light binning");
+        m_clusterer.bin(m_lights.id(), (uint32_t)m_lightCount, view.view);
+    }
+
+    PROFILE_SCOPE("clustered shading");
+    PROFILE_GPU_SCOPE("clustered shading");
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const ClusterGridConfig& config = m_clusterGrid.config();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GpuLightClusterer::kLightBinding, m_lights.id());
+    m_clusterer.bindResults();
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    m_clustered->use();
+    m_clustered->setUniform("viewProjection", view.projection * view.view);
+    m_clustered->setUniform("view", view.view);
+    _applyLighting(*m_clustered, view);
+    m_clustered->setUniform("clusterGrid", glm::uvec3(config.tilesX, config.tilesY, config.slices));
+    m_clustered->setUniform("clusterTileSize", glm::vec2((float)viewport[2] / config.tilesX, (float)viewport[3] / config.tilesY));
+    m_clustered->setUniform("clusterSliceScale", m_clusterGrid.sliceScale());
+    m_clustered->setUniform("clusterSliceBias", m_clusterGrid.sliceBias());
+    drawScene(*m_clustered);
+}
+
+void DeferredRenderer::_renderDeferred(ShadingPath path, const ShadingView& view, const std::function<void(const Shader&)>& drawScene) {
+    GLint target = 0;
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (!_fitGBuffer(viewport[2], viewport[3])) {
+        return;
+    }
+
+    const glm::mat4 viewProjection = view.projection * view.view;
+    {
+        PROFILE_SCOPE("gbuffer");
+        PROFILE_GPU_SCOPE("gbuffer");
+
+        m_gbuffer.bind();
+        // background pixels keep depth 1, the lighting passes skip them
+        const GLfloat farDepth = 1.0f;
+        glClearBufferfv(GL_DEPTH, 0, &farDepth);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        m_geometry->use();
+        m_geometry->setUniform("viewProjection", viewProjection);
+        drawScene(*m_geometry);
+    }
+
+    PROFILE_SCOPE("light accumulation");
+    PROFILE_GPU_SCOPE("light accumulation");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)target);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glDisable(GL_DEPTH_TEST);
+    for (GLuint i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, m_gbuffer.colorTexture(i));
+    }
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, m_gbuffer.depthTexture());
+
+    // the full-screen pass lights everything, or only adds the ambient term under the volumes
+    const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    m_fullScreen->use();
+    m_fullScreen->setUniform("inverseViewProjection", inverseViewProjection);
+    _applyLighting(*m_fullScreen, view);
+    m_fullScreen->setUniform("lightCount", path == ShadingPath::DeferredFullScreen ? (int)m_lightCount : 0);
+    m_emptyVAO.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+
+    if (path == ShadingPath::DeferredVolumes && m_lightCount > 0) {
+        // back faces: a volume the camera is inside of still covers the screen
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        m_volume->use();
+        m_volume->setUniform("viewProjection", viewProjection);
+        m_volume->setUniform("inverseViewProjection", inverseViewProjection);
+        _applyLighting(*m_volume, view);
+        m_volumeVAO.bind();
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr, (GLsizei)m_lightCount);
+        RenderStats::get().recordDraw(GL_TRIANGLES, 36, (uint64_t)m_lightCount);
+
+        glCullFace(GL_BACK);
+    }
+
+    glBindVertexArray(0);
+    for (GLuint i = 0; i < 4; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void DeferredRenderer::_applyLighting(const Shader& shader, const ShadingView& view) const {
+    shader.setUniform("viewPosition", view.position);
+    shader.setUniform("ambient", m_ambient);
+    shader.setUniform("sunDirection", m_sunDirection);
+    shader.setUniform("sunColor", m_sunColor);
+    if (m_shadows && m_shadows->initialized()) {
+        m_shadows->apply(shader);
+    }
+    else {
+        shader.setUniform("shadowsEnabled", false);
+    }
+}
+
+void DeferredRenderer::_createVolumeMesh() {
+    // corner i has x, y, z = bits 0, 1, 2 of i
+    BufferInfo<float> vertices{};
+    vertices.type = VERTEX_BUFFER;
+    vertices.target = GL_ARRAY_BUFFER;
+    vertices.usage = GL_STATIC_DRAW;
+    for (int i = 0; i < 8; i++) {
+        vertices.data.push_back(i & 1 ? 1.0f : -1.0f);
+        vertices.data.push_back(i & 2 ? 1.0f : -1.0f);
+        vertices.data.push_back(i & 4 ? 1.0f : -1.0f);
+    }
+    vertices.size = (unsigned long)(vertices.data.size() * sizeof(float));
+
+    BufferInfo<unsigned int> indices{};
+    indices.type = INDEX_BUFFER;
+    indices.target = GL_ELEMENT_ARRAY_BUFFER;
+    indices.usage = GL_STATIC_DRAW;
+    indices.data = {
+        0, 2, 3,  0, 3, 1,      // -z
+        4, 5, 7,  4, 7, 6,      // +z
+        0, 4, 6,  0, 6, 2,      // -x
+        1, 3, 7,  1, 7, 5,      // +x
+        0, 1, 5,  0, 5, 4,      // -y
+        2, 6, 7,  2, 7, 3       // +y
+    };
+    indices.size = (unsigned long)(indices.data.size() * sizeof(unsigned int));
+
+    m_volumeVAO.bind();
+    m_volumeVertices.setBuffer(vertices);
+    m_volumeIndices.setBuffer(indices);
+    m_volumeVAO.linkAttribFast({ 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0 });
+    m_volumeVAO.unbind();
+}
+
+bool DeferredRenderer::_fitGBuffer(int width, int height) {
+    if (m_gbuffer.id() && m_gbuffer.width() == width && m_gbuffer.height() == height) {
+        return true;
+    }
+
+    FramebufferConfig config{};
+    config.width = width;
+    config.height = height;
+    config.colorAttachments = {
+        { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_NEAREST },        // albedo
+        { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, GL_NEAREST },         // normal
+        { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_NEAREST }         // material
+    };
+    config.depth = true;
+    config.depthFormat = GL_DEPTH_COMPONENT32F;
+    return m_gbuffer.create(config);
+}
@@ -0,0 +1,146 @@
+#ifndef _DEFERRED_RENDERER_H_
+#define _DEFERRED_RENDERER_H_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/Shader.h"
+#include "../opengl/Framebuffer.h"
+#include "../opengl/OpenGLPipeline.h"
+#include "ClusteredLighting.h"
+#include "Light.h"
+#include "Shadows.h"
+
+enum class ShadingPath : uint8_t {
+    Forward,                // every object's fragments loop over all lights
+    DeferredFullScreen,     // G-buffer, then one full-screen pass looping over all lights
+    DeferredVolumes,        // G-buffer, then one box per light, only its pixels pay for it
+    Clustered               // lights binned into froxels by a compute pass, fragments loop over theirs
+};
+
+const char* shading_path_name(ShadingPath path);
+
+struct ShadingView {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 position;
+};
+
+/**
+ * @brief Lights a scene with many point and spot lights, forward, clustered forward or deferred
+ *
+ * The scene is a callback that draws every object with the shader it is given, after
+ * setting `model` and the material (setMaterial); it runs once per frame on either path.
+ *
+ * Forward shades each fragment the rasterizer produces, overdraw included, with every
+ * light. Deferred draws the scene once into a G-buffer (albedo RGBA8, normal RGBA16F,
+ * material RGBA8, depth 32F) and lights each visible pixel once: with a full-screen pass
+ * that still loops over every light, or with light volumes, where each light only covers
+ * the pixels of its bounding box on screen. The G-buffer follows the size of the viewport.
+ *
+ * Clustered forward bins the lights into the froxels of the projection (GpuLightClusterer)
+ * and draws the scene once, each fragment looping over the lights of its froxel only. It
+ * needs no G-buffer, so unlike deferred it also works for blended and multisampled targets.
+ *
+ * Every path also adds a directional sun (setSun) and, given a ShadowRenderer (setShadows),
+ * reads the sun's cascades and the shadow views of the lights that have one.
+ *
+ * The lit image goes to the bound framebuffer; on the deferred paths its depth buffer is
+ * left alone, so forward passes drawn afterwards do not depth test against the scene.
+ */
+class DeferredRenderer {
+public:
+    DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer& other) = delete;
+
+    ~DeferredRenderer() = default;
+
+    DeferredRenderer& operator=(const DeferredRenderer& other) = delete;
+
+    /**
+     * @brief Builds the shaders in `shaderDirectory` (geometry.vert, gbuffer.frag, light.vert, lighting.frag)
+     *
+     * @return false if one of them does not compile or link
+     */
+    bool init(const std::string& shaderDirectory = "assets/shaders/shading");
+
+    bool initialized() const { return m_initialized; }
+
+    /// Uploads the lights; call when they change, not necessarily every frame
+    void setLights(const std::vector<Light>& lights);
+
+    size_t lightCount() const { return m_lightCount; }
+
+    void setAmbient(const glm::vec3& ambient) { m_ambient = ambient; }
+
+    /// `direction` is where the sun's light travels; a black sun is skipped
+    void setSun(const glm::vec3& direction, const glm::vec3& color);
+
+    /// Shadows the next frames sample, null for none; `shadows` must outlive them
+    void setShadows(const ShadowRenderer* shadows) { m_shadows = shadows; }
+
+    /**
+     * @brief Draws the scene lit by the current lights into the bound framebuffer
+     */
+    void render(ShadingPath path, const ShadingView& view, const std::function<void(const Shader&)>& drawScene);
+
+    static void setMaterial(const Shader& shader, const glm::vec3& albedo, float specular, float shininess);
+
+    /// Froxel layout of the clustered path, applied on its next frame
+    void setClusterConfig(const ClusterGridConfig& config);
+
+    const ClusterGrid& clusterGrid() const { return m_clusterGrid; }
+
+    const GpuLightClusterer& clusterer() const { return m_clusterer; }
+
+    const Framebuffer& gbuffer() const { return m_gbuffer; }
+
+    /// G-buffer GPU memory, 0 until the first deferred frame
+    unsigned long gbufferBytes() const { return m_gbuffer.id() ? m_gbuffer.byteSize() : 0; }
+
+private:
+    bool m_initialized;
+    std::unique_ptr<Shader> m_forward;
+    std::unique_ptr<Shader> m_geometry;
+    std::unique_ptr<Shader> m_fullScreen;
+    std::unique_ptr<Shader> m_volume;
+    std::unique_ptr<Shader> m_clustered;
+    Framebuffer m_gbuffer;
+    Buffer<Light> m_lights;
+    BufferInfo<Light> m_lightInfo;
+    size_t m_lightCount;
+    VertexArray m_emptyVAO;
+    // box around the unit sphere, wound counter-clockwise seen from outside
+    VertexArray m_volumeVAO;
+    Buffer<float> m_volumeVertices;
+    Buffer<unsigned int> m_volumeIndices;
+    ClusterGridConfig m_clusterConfig;
+    ClusterGrid m_clusterGrid;
+    GpuLightClusterer m_clusterer;
+    glm::vec3 m_ambient;
+    glm::vec3 m_sunDirection;
+    glm::vec3 m_sunColor;
+    const ShadowRenderer* m_shadows;
+
+    /// Uniforms every lighting shader shares: eye, ambient, sun and shadows
+    void _applyLighting(const Shader& shader, const ShadingView& view) const;
+
+    void _renderForward(const ShadingView& view, const std::function<void(const Shader&)>& drawScene);
+
+    void _renderClustered(const ShadingView& view, const std::function<void(const Shader&)>& drawScene);
+
+    void _renderDeferred(ShadingPath path, const ShadingView& view, const std::function<void(const Shader&)>& drawScene);
+
+    void _createVolumeMesh();
+
+    bool _fitGBuffer(int width, int height);
+};
+
+#endif // !_DEFERRED_RENDERER_H_
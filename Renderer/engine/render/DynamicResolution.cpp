@@ -0,0 +1,218 @@
+#include "DynamicResolution.h"
+
+#include "../core/Profiler.h"
+#include "../opengl/GpuProfiler.h"
+#include "../opengl/RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+bool linked(const Shader& shader) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(shader.id(), GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+}
+
+const char* upscale_filter_name(UpscaleFilter filter) {
+    switch (filter)
+    {
+    case UpscaleFilter::Bilinear:   return "bilinear";
+    case UpscaleFilter::Sharpen:    return "sharpen";
+    default:                        return "unknown";
+    }
+}
+
+DynamicResolution::DynamicResolution()
+    : m_initialized(false),
+      m_settings(),
+      m_stats(),
+      m_scale(1.0f),
+      m_underFrames(0),
+      m_timestamps(kLatency),
+      m_slotScales()
+{}
+
+bool DynamicResolution::init() {
+    if (m_initialized) {
+        return true;
+    }
+
+    m_scale = _quantize(m_settings.maxScale);
+    m_initialized = true;
+    return true;
+}
+
+float DynamicResolution::scale() const {
+    const float scale = m_settings.enabled ? m_scale : m_settings.scale;
+    return std::clamp(scale, std::max(m_settings.minScale, 0.05f), std::max(m_settings.maxScale, m_settings.minScale));
+}
+
+int DynamicResolution::renderWidth(int nativeWidth) {
+    m_stats.scale = scale();
+    m_stats.width = std::max((int)(nativeWidth * m_stats.scale + 0.5f), 1);
+    return m_stats.width;
+}
+
+int DynamicResolution::renderHeight(int nativeHeight) {
+    m_stats.scale = scale();
+    m_stats.height = std::max((int)(nativeHeight * m_stats.scale + 0.5f), 1);
+    return m_stats.height;
+}
+
+void DynamicResolution::beginFrame() {
+    if (!m_initialized) {
+        return;
+    }
+
+    // a query still in flight after kLatency frames: this frame goes unmeasured
+    if (m_timestamps.begin()) {
+        m_timestamps.mark();
+        m_slotScales[m_timestamps.slot()] = scale();
+    }
+}
+
+void DynamicResolution::endFrame() {
+    if (!m_initialized) {
+        return;
+    }
+
+    m_timestamps.mark();
+    m_timestamps.end();
+    _collectTiming();
+}
+
+void DynamicResolution::update(double gpuMs, float frameScale) {
+    // cost is taken to follow the pixel count, so samples at any scale feed one estimate
+    const float measured = std::max(frameScale, 0.01f);
+    const double fullMs = gpuMs / ((double)measured * measured);
+    const double smoothing = std::clamp((double)m_settings.smoothing, 0.01, 1.0);
+    // a rise is taken as it comes so a spike is over the target for the latency alone,
+    // a fall is smoothed so one cheap frame doesn't raise the scale
+    m_stats.fullMs = m_stats.samples == 0 || fullMs > m_stats.fullMs ? fullMs : m_stats.fullMs + smoothing * (fullMs - m_stats.fullMs);
+    m_stats.gpuMs = gpuMs;
+    m_stats.gpuScale = measured;
+    m_stats.samples++;
+
+    float next = m_scale;
+    if (!m_settings.enabled) {
+        // picks up from the manual scale once turned back on
+        next = _quantize(m_settings.scale);
+        m_underFrames = 0;
+    }
+    else {
+        const double target = std::max((double)m_settings.targetMs, 0.1);
+        const double headroom = std::clamp((double)m_settings.headroom, 0.0, 0.9);
+        const double predicted = m_stats.fullMs * m_scale * m_scale;
+        const float step = std::max(m_settings.step, 0.01f);
+        if (predicted > target) {
+            // down right away, to the middle of the band the scale then stays in
+            next = _quantize((float)std::sqrt(target * (1.0 - 0.5 * headroom) / std::max(m_stats.fullMs, 1e-6)));
+            m_underFrames = 0;
+        }
+        else if (predicted < target * (1.0 - headroom)) {
+            // up one step at a time, and only when the step itself is expected to fit
+            const float up = _quantize(m_scale + step * 1.5f);
+            if (++m_underFrames >= m_settings.raiseDelay && m_stats.fullMs * up * up <= target * (1.0 - 0.5 * headroom)) {
+                next = up;
+                m_underFrames = 0;
+            }
+        }
+        else {
+            m_underFrames = 0;
+        }
+    }
+    if (next != m_scale) {
+        m_scale = next;
+        m_stats.changes++;
+    }
+    m_stats.scale = scale();
+
+    const size_t index = (m_stats.historyOffset + m_stats.historyCount) % DynamicResolutionStats::kHistory;
+    m_stats.scaleHistory[index] = measured;
+    m_stats.gpuHistory[index] = (float)gpuMs;
+    if (m_stats.historyCount < DynamicResolutionStats::kHistory) {
+        m_stats.historyCount++;
+    }
+    else {
+        m_stats.historyOffset = (m_stats.historyOffset + 1) % DynamicResolutionStats::kHistory;
+    }
+}
+
+float DynamicResolution::_quantize(float scale) const {
+    const float step = std::max(m_settings.step, 0.01f);
+    const float minScale = std::max(m_settings.minScale, 0.05f);
+    const float maxScale = std::max(m_settings.maxScale, minScale);
+    // down to a multiple of the step, a rounding error short of one counts as one
+    const float quantized = std::floor(scale / step + 1e-3f) * step;
+    return std::clamp(quantized, minScale, maxScale);
+}
+
+void DynamicResolution::_collectTiming() {
+    m_timestamps.collect([this](size_t slot, const GLuint64* times, size_t count) {
+        update((double)(times[count - 1] - times[0]) * 1e-6, m_slotScales[slot]);
+    });
+}
+
+Upscaler::Upscaler()
+    : m_initialized(false),
+      m_bilinear(),
+      m_sharpen(),
+      m_emptyVAO()
+{}
+
+bool Upscaler::init(const std::string& shaderDirectory) {
+    if (m_initialized) {
+        return true;
+    }
+
+    const std::string vert = shaderDirectory + "/fullscreen.vert";
+    m_bilinear = std::make_unique<Shader>(vert, shaderDirectory + "/upscale.frag");
+    m_sharpen = std::make_unique<Shader>(vert, shaderDirectory + "/upscale.frag", std::vector<std::string>{ "SHARPEN" });
+    if (!linked(*m_bilinear) || !linked(*m_sharpen)) {
+        gl_log_err("ERROR: could not build the upscaling shaders in %s\n", shaderDirectory.c_str());
+        return false;
+    }
+
+    m_initialized = true;
+    return true;
+}
+
+void Upscaler::render(GLuint source, int sourceWidth, int sourceHeight, GLuint target, int width, int height,
+                      UpscaleFilter filter, float sharpness)
+{
+    if (!m_initialized || sourceWidth <= 0 || sourceHeight <= 0) {
+        return;
+    }
+
+    PROFILE_SCOPE("upscale");
+    PROFILE_GPU_SCOPE("upscale");
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    const GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_CULL_FACE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(0, 0, width, height);
+    Shader& shader = filter == UpscaleFilter::Sharpen && sharpness > 0.0f ? *m_sharpen : *m_bilinear;
+    shader.use();
+    shader.setUniform("texelSize", glm::vec2(1.0f / sourceWidth, 1.0f / sourceHeight));
+    shader.setUniform("sharpness", sharpness);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    m_emptyVAO.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+}
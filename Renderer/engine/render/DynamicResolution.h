@@ -0,0 +1,154 @@
+#ifndef _DYNAMIC_RESOLUTION_H_
+#define _DYNAMIC_RESOLUTION_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../core/Shader.h"
+#include "../opengl/OpenGLPipeline.h"
+#include "../opengl/TimestampRing.h"
+
+enum class UpscaleFilter : uint8_t {
+    Bilinear,
+    Sharpen         // bilinear, then an unsharp mask clamped to the source neighbourhood
+};
+
+const char* upscale_filter_name(UpscaleFilter filter);
+
+struct DynamicResolutionSettings {
+    bool enabled = true;            // off: the scale stays where `scale` puts it
+    float targetMs = 16.0f;         // GPU time per frame to hold, a little under the vsync interval
+    float minScale = 0.5f;          // of the width and of the height
+    float maxScale = 1.0f;
+    float scale = 1.0f;             // when the controller is off
+    float step = 0.05f;             // scales are multiples of it, so render targets come back from the pool
+    float headroom = 0.15f;         // the scale only goes up once the GPU time is this far under the target
+    float smoothing = 0.2f;         // weight of a cheaper sample in the running cost estimate, dearer ones count at once
+    int raiseDelay = 30;            // frames in a row under the target with headroom before stepping up
+    UpscaleFilter filter = UpscaleFilter::Sharpen;
+    float sharpness = 0.5f;
+};
+
+struct DynamicResolutionStats {
+    static constexpr size_t kHistory = 240;
+
+    float scale = 1.0f;             // the next frame renders at
+    int width = 0;                  // of the next frame at the last native size asked for
+    int height = 0;
+    double gpuMs = 0.0;             // of the most recent frame that resolved
+    float gpuScale = 1.0f;          // that frame rendered at
+    double fullMs = 0.0;            // running estimate of a frame at scale 1
+    uint32_t changes = 0;           // of the scale, since init
+    uint64_t samples = 0;           // frames measured
+    float scaleHistory[kHistory] = {};
+    float gpuHistory[kHistory] = {};
+    size_t historyCount = 0;
+    size_t historyOffset = 0;       // of the oldest entry once full
+};
+
+/**
+ * @brief Picks the render scale of the scene from the GPU time of the frames before
+ *
+ * The frame is bracketed with timestamp queries, read back a few frames later without
+ * stalling. Each sample is divided by the pixel count it rendered at, scale squared, into
+ * an estimate of what a full resolution frame costs; the samples of frames in flight at an
+ * older scale stay comparable that way. The estimate follows a rising cost at once and a
+ * falling one smoothed.
+ *
+ * Over the target the scale drops right away to what the estimate says fits, with half
+ * the headroom to spare. Under the target by the headroom for `raiseDelay` frames in a
+ * row it goes up one step. Scales are quantized to `step` so a few target sizes repeat.
+ *
+ * `update` is the controller on its own, for benchmarks that feed it synthetic times.
+ */
+class DynamicResolution {
+public:
+    static constexpr size_t kLatency = 4;           // frames a query may take to resolve
+
+    DynamicResolution();
+
+    DynamicResolution(const DynamicResolution& other) = delete;
+
+    DynamicResolution& operator=(const DynamicResolution& other) = delete;
+
+    /// Timer queries; without them the controller only moves on `update`
+    bool init();
+
+    bool initialized() const { return m_initialized; }
+
+    DynamicResolutionSettings& settings() { return m_settings; }
+
+    const DynamicResolutionSettings& settings() const { return m_settings; }
+
+    void setSettings(const DynamicResolutionSettings& settings) { m_settings = settings; }
+
+    /// Scale of the frame about to be built
+    float scale() const;
+
+    /// `nativeWidth` at the current scale, at least 1; also noted in the stats
+    int renderWidth(int nativeWidth);
+
+    int renderHeight(int nativeHeight);
+
+    /// Around the GPU work of a frame; endFrame reads back the frames that resolved
+    void beginFrame();
+
+    void endFrame();
+
+    /// One sample: a frame rendered at `frameScale` took `gpuMs` on the GPU
+    void update(double gpuMs, float frameScale);
+
+    const DynamicResolutionStats& stats() const { return m_stats; }
+
+private:
+    bool m_initialized;
+    DynamicResolutionSettings m_settings;
+    DynamicResolutionStats m_stats;
+    float m_scale;
+    int m_underFrames;
+    TimestampRing m_timestamps;
+    float m_slotScales[kLatency];       // of the frame in each slot of the ring
+
+    float _quantize(float scale) const;
+
+    void _collectTiming();
+};
+
+/**
+ * @brief Full-screen pass taking a scene rendered at a lower resolution to the display
+ *
+ * Bilinear, or bilinear followed by a sharpening of the detail the upscale softened. The
+ * sharpened color is clamped to the source texels around it so edges don't ring.
+ */
+class Upscaler {
+public:
+    Upscaler();
+
+    Upscaler(const Upscaler& other) = delete;
+
+    Upscaler& operator=(const Upscaler& other) = delete;
+
+    bool init(const std::string& shaderDirectory = "assets/shaders/post");
+
+    bool initialized() const { return m_initialized; }
+
+    /**
+     * @brief Draws `source`, `sourceWidth` x `sourceHeight`, over the `width` x `height`
+     * viewport of framebuffer `target`
+     *
+     * Leaves `target` bound. Depth test, blending and culling are restored.
+     */
+    void render(GLuint source, int sourceWidth, int sourceHeight, GLuint target, int width, int height,
+                UpscaleFilter filter, float sharpness);
+
+private:
+    bool m_initialized;
+    std::unique_ptr<Shader> m_bilinear;
+    std::unique_ptr<Shader> m_sharpen;
+    VertexArray m_emptyVAO;
+};
+
+#endif // !_DYNAMIC_RESOLUTION_H_
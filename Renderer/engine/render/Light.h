@@ -0,0 +1,49 @@
+#ifndef _LIGHT_H_
+#define _LIGHT_H_
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+/**
+ * @brief A point or spot light, std430 layout of the light buffer every lighting shader reads
+ *
+ * Intensity fades to 0 at `radius` (windowed inverse square). A spot light also fades from
+ * its inner to its outer cone; a point light has an outer cosine of -2, so every direction
+ * is inside.
+ *
+ * A light asks for a shadow with castShadows(); ShadowRenderer::update then stores where its
+ * shadow views start, or -1 when the atlas had no room left.
+ */
+struct Light {
+    glm::vec4 positionRadius;   // xyz world position, w radius
+    glm::vec4 color;            // rgb intensity, w cosine of the inner cone half angle
+    glm::vec4 spot;             // xyz direction the cone points at, w cosine of the outer half angle
+    glm::vec4 shadow;           // x first shadow view or -1, y 1 if the light casts shadows
+
+    bool isSpot() const { return spot.w > -1.0f; }
+
+    bool castsShadows() const { return shadow.y > 0.0f; }
+
+    int shadowView() const { return (int)shadow.x; }
+
+    Light& castShadows(bool enable = true) {
+        shadow.y = enable ? 1.0f : 0.0f;
+        return *this;
+    }
+};
+
+inline Light point_light(const glm::vec3& position, float radius, const glm::vec3& color) {
+    return { glm::vec4(position, radius), glm::vec4(color, 1.0f), glm::vec4(0.0f, 0.0f, -1.0f, -2.0f),
+             glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f) };
+}
+
+/// `innerAngle` and `outerAngle` are half angles in radians, inner < outer < pi / 2
+inline Light spot_light(const glm::vec3& position, float radius, const glm::vec3& color, const glm::vec3& direction,
+                        float innerAngle, float outerAngle)
+{
+    return { glm::vec4(position, radius), glm::vec4(color, std::cos(innerAngle)),
+             glm::vec4(glm::normalize(direction), std::cos(outerAngle)), glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f) };
+}
+
+#endif // !_LIGHT_H_
@@ -0,0 +1,477 @@
+#include "OcclusionCulling.h"
+
+#include "../math/Frustum.h"
+#include "../opengl/RenderStats.h"
+#include "../opengl/log.h"
+#include "../opengl/utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// GPU counters, in the order of the Stats block in occlusion_cull.comp
+enum OcclusionCounter {
+    kInstances,
+    kFrustumCulled,
+    kOccluded,
+    kDrawnEarly,
+    kDrawnLate,
+    kCounterCount
+};
+
+GLuint compile_compute(const std::string& path, const char* what) {
+    std::ifstream file(path);
+    if (!file) {
+        gl_log_err("ERROR: could not open %s shader %s\n", what, path.c_str());
+        return 0;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string source = stream.str();
+    const char* code = source.c_str();
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    GL_CALL(glShaderSource(shader, 1, &code, nullptr));
+    GL_CALL(glCompileShader(shader));
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        gl_log_err("ERROR: %s shader %s failed to compile:\n%s\n", what, path.c_str(), infoLog);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    GL_CALL(glAttachShader(program, shader));
+    GL_CALL(glLinkProgram(program));
+    GL_CALL(glDeleteShader(shader));
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        gl_log_err("ERROR: %s program failed to link:\n%s\n", what, infoLog);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+glm::ivec2 level_size(glm::ivec2 base, int level) {
+    return glm::ivec2(std::max(base.x >> level, 1), std::max(base.y >> level, 1));
+}
+
+}
+
+void DepthPyramid::resize(int width, int height) {
+    const glm::ivec2 base(pyramid_base_size(width), pyramid_base_size(height));
+    const int levels = (int)std::log2((float)std::max(base.x, base.y)) + 1;
+    m_sizes.resize(levels);
+    m_levels.resize(levels);
+    for (int level = 0; level < levels; level++) {
+        m_sizes[level] = level_size(base, level);
+        m_levels[level].assign((size_t)m_sizes[level].x * m_sizes[level].y, 0.0f);
+    }
+}
+
+void DepthPyramid::build(const float* depth, int width, int height) {
+    resize(width, height);
+
+    // level 0: each texel covers between 1 and 2 depth texels per axis, partly
+    const glm::ivec2 base = m_sizes[0];
+    for (int y = 0; y < base.y; y++) {
+        const int y0 = y * height / base.y;
+        const int y1 = ((y + 1) * height + base.y - 1) / base.y - 1;
+        for (int x = 0; x < base.x; x++) {
+            const int x0 = x * width / base.x;
+            const int x1 = ((x + 1) * width + base.x - 1) / base.x - 1;
+            float farthest = 0.0f;
+            for (int sy = y0; sy <= y1; sy++) {
+                for (int sx = x0; sx <= x1; sx++) {
+                    farthest = std::max(farthest, depth[(size_t)sy * width + sx]);
+                }
+            }
+            m_levels[0][(size_t)y * base.x + x] = farthest;
+        }
+    }
+
+    for (size_t level = 1; level < m_levels.size(); level++) {
+        const glm::ivec2 source = m_sizes[level - 1];
+        const glm::ivec2 size = m_sizes[level];
+        for (int y = 0; y < size.y; y++) {
+            for (int x = 0; x < size.x; x++) {
+                float farthest = 0.0f;
+                for (int sy = 2 * y; sy <= std::min(2 * y + 1, source.y - 1); sy++) {
+                    for (int sx = 2 * x; sx <= std::min(2 * x + 1, source.x - 1); sx++) {
+                        farthest = std::max(farthest, texel(level - 1, sx, sy));
+                    }
+                }
+                m_levels[level][(size_t)y * size.x + x] = farthest;
+            }
+        }
+    }
+}
+
+ProjectedBox project_box(const glm::vec3& lo, const glm::vec3& hi, const glm::mat4& viewProjection) {
+    ProjectedBox box;
+    box.uvMin = glm::vec2(1.0f);
+    box.uvMax = glm::vec2(0.0f);
+    box.nearestDepth = 1.0f;
+    box.crossesNear = false;
+    box.outside = !Frustum(viewProjection).intersectsBox(lo, hi);
+    if (box.outside) {
+        return box;
+    }
+
+    for (int corner = 0; corner < 8; corner++) {
+        const glm::vec4 position(corner & 1 ? hi.x : lo.x, corner & 2 ? hi.y : lo.y, corner & 4 ? hi.z : lo.z, 1.0f);
+        const glm::vec4 clip = viewProjection * position;
+        if (clip.w <= 1e-5f) {
+            box.crossesNear = true;
+            return box;
+        }
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        const glm::vec2 uv = glm::vec2(ndc) * 0.5f + 0.5f;
+        box.uvMin = glm::min(box.uvMin, uv);
+        box.uvMax = glm::max(box.uvMax, uv);
+        box.nearestDepth = std::min(box.nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+    box.uvMin = glm::max(box.uvMin, glm::vec2(0.0f));
+    box.uvMax = glm::min(box.uvMax, glm::vec2(1.0f));
+    return box;
+}
+
+bool box_occluded(const DepthPyramid& pyramid, const ProjectedBox& box, float slack) {
+    if (box.outside || box.crossesNear || pyramid.levelCount() == 0) {
+        return false;
+    }
+
+    // the level where the box covers at most 2x2 texels, one higher if it straddles more
+    const glm::vec2 extent = (box.uvMax - box.uvMin) * glm::vec2(pyramid.levelSize(0));
+    const int top = (int)pyramid.levelCount() - 1;
+    int level = std::min((int)std::ceil(std::log2(std::max(std::max(extent.x, extent.y), 1.0f))), top);
+    glm::ivec2 lo, hi;
+    for (;;) {
+        const glm::ivec2 size = pyramid.levelSize(level);
+        lo = glm::min(glm::ivec2(glm::vec2(size) * box.uvMin), size - 1);
+        hi = glm::min(glm::ivec2(glm::vec2(size) * box.uvMax), size - 1);
+        if ((hi.x - lo.x <= 1 && hi.y - lo.y <= 1) || level == top) {
+            break;
+        }
+        level++;
+    }
+
+    float farthest = 0.0f;
+    for (int y = lo.y; y <= hi.y; y++) {
+        for (int x = lo.x; x <= hi.x; x++) {
+            farthest = std::max(farthest, pyramid.texel(level, x, y));
+        }
+    }
+    return box.nearestDepth + slack > farthest;
+}
+
+GpuOcclusionCuller::GpuOcclusionCuller()
+    : m_buildProgram(0),
+      m_cullProgram(0),
+      m_boundsBuffer(0),
+      m_visibilityBuffer(0),
+      m_commandBuffers{},
+      m_statsBuffer(0),
+      m_pyramid(0),
+      m_depthSize(0),
+      m_pyramidSize(0),
+      m_pyramidLevels(0),
+      m_instanceCount(0),
+      m_indexCount(0),
+      m_viewProjectionLocation(-1),
+      m_planesLocation(-1),
+      m_passLocation(-1),
+      m_instanceCountLocation(-1),
+      m_pyramidSizeLocation(-1),
+      m_pyramidLevelsLocation(-1),
+      m_buildLevelLocation(-1),
+      m_buildSourceSizeLocation(-1),
+      m_buildSizeLocation(-1)
+{}
+
+GpuOcclusionCuller::~GpuOcclusionCuller() {
+    shutdown();
+}
+
+bool GpuOcclusionCuller::init(const std::string& shaderDirectory) {
+    shutdown();
+
+    m_buildProgram = compile_compute(shaderDirectory + "/hiz_build.comp", "Hi-Z build");
+    m_cullProgram = compile_compute(shaderDirectory + "/occlusion_cull.comp", "occlusion culling");
+    if (!m_buildProgram || !m_cullProgram) {
+        shutdown();
+        return false;
+    }
+
+    m_viewProjectionLocation = glGetUniformLocation(m_cullProgram, "viewProjection");
+    m_planesLocation = glGetUniformLocation(m_cullProgram, "planes");
+    m_passLocation = glGetUniformLocation(m_cullProgram, "pass");
+    m_instanceCountLocation = glGetUniformLocation(m_cullProgram, "instanceCount");
+    m_pyramidSizeLocation = glGetUniformLocation(m_cullProgram, "pyramidSize");
+    m_pyramidLevelsLocation = glGetUniformLocation(m_cullProgram, "pyramidLevels");
+    m_buildLevelLocation = glGetUniformLocation(m_buildProgram, "level");
+    m_buildSourceSizeLocation = glGetUniformLocation(m_buildProgram, "sourceSize");
+    m_buildSizeLocation = glGetUniformLocation(m_buildProgram, "size");
+
+    GL_CALL(glGenBuffers(1, &m_statsBuffer));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, kCounterCount * sizeof(GLuint), nullptr, GL_DYNAMIC_READ));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    gl_track_buffer(m_statsBuffer, GL_SHADER_STORAGE_BUFFER, kCounterCount * sizeof(GLuint));
+    resetStats();
+    return true;
+}
+
+void GpuOcclusionCuller::shutdown() {
+    _deleteInstances();
+    if (m_pyramid) {
+        gl_untrack_texture(m_pyramid);
+        GL_CALL(glDeleteTextures(1, &m_pyramid));
+        m_pyramid = 0;
+        m_depthSize = glm::ivec2(0);
+    }
+    if (m_statsBuffer) {
+        gl_untrack_buffer(m_statsBuffer);
+        GL_CALL(glDeleteBuffers(1, &m_statsBuffer));
+        m_statsBuffer = 0;
+    }
+    for (GLuint* program : { &m_buildProgram, &m_cullProgram }) {
+        if (*program) {
+            GL_CALL(glDeleteProgram(*program));
+            *program = 0;
+        }
+    }
+}
+
+void GpuOcclusionCuller::_deleteInstances() {
+    GLuint* buffers[] = { &m_boundsBuffer, &m_visibilityBuffer, &m_commandBuffers[0], &m_commandBuffers[1] };
+    for (GLuint* buffer : buffers) {
+        if (*buffer) {
+            gl_untrack_buffer(*buffer);
+            GL_CALL(glDeleteBuffers(1, buffer));
+            *buffer = 0;
+        }
+    }
+    m_instanceCount = 0;
+}
+
+void GpuOcclusionCuller::setInstances(const std::vector<OcclusionBounds>& bounds, uint32_t indexCount) {
+    if (!m_cullProgram) {
+        return;
+    }
+    _deleteInstances();
+    if (bounds.empty()) {
+        return;
+    }
+
+    m_instanceCount = (uint32_t)bounds.size();
+    m_indexCount = indexCount;
+    const uint64_t boundsBytes = m_instanceCount * sizeof(OcclusionBounds);
+    const uint64_t visibilityBytes = m_instanceCount * sizeof(uint32_t);
+    const uint64_t commandBytes = m_instanceCount * sizeof(DrawElementsIndirectCommand);
+
+    // commands stay per instance: index count and base instance never change, only instanceCount
+    std::vector<DrawElementsIndirectCommand> commands(m_instanceCount);
+    for (uint32_t i = 0; i < m_instanceCount; i++) {
+        commands[i] = { indexCount, 0, 0, 0, i };
+    }
+    const std::vector<uint32_t> hidden(m_instanceCount, 0);
+
+    GLuint buffers[4];
+    GL_CALL(glGenBuffers(4, buffers));
+    m_boundsBuffer = buffers[0];
+    m_visibilityBuffer = buffers[1];
+    m_commandBuffers[0] = buffers[2];
+    m_commandBuffers[1] = buffers[3];
+
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, boundsBytes, bounds.data(), GL_DYNAMIC_DRAW));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilityBuffer));
+    GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, visibilityBytes, hidden.data(), GL_DYNAMIC_COPY));
+    for (GLuint buffer : m_commandBuffers) {
+        GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer));
+        GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, commandBytes, commands.data(), GL_DYNAMIC_COPY));
+    }
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    gl_track_buffer(m_boundsBuffer, GL_SHADER_STORAGE_BUFFER, boundsBytes);
+    gl_track_buffer(m_visibilityBuffer, GL_SHADER_STORAGE_BUFFER, visibilityBytes);
+    gl_track_buffer(m_commandBuffers[0], GL_DRAW_INDIRECT_BUFFER, commandBytes);
+    gl_track_buffer(m_commandBuffers[1], GL_DRAW_INDIRECT_BUFFER, commandBytes);
+}
+
+void GpuOcclusionCuller::updateBounds(const std::vector<OcclusionBounds>& bounds) {
+    if (!m_boundsBuffer || bounds.size() != m_instanceCount) {
+        return;
+    }
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer));
+    GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bounds.size() * sizeof(OcclusionBounds), bounds.data()));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+}
+
+void GpuOcclusionCuller::_createPyramid(int width, int height) {
+    if (m_pyramid) {
+        gl_untrack_texture(m_pyramid);
+        GL_CALL(glDeleteTextures(1, &m_pyramid));
+    }
+
+    m_depthSize = glm::ivec2(width, height);
+    m_pyramidSize = glm::ivec2(pyramid_base_size(width), pyramid_base_size(height));
+    m_pyramidLevels = (int)std::log2((float)std::max(m_pyramidSize.x, m_pyramidSize.y)) + 1;
+
+    GL_CALL(glGenTextures(1, &m_pyramid));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, m_pyramid));
+    GL_CALL(glTexStorage2D(GL_TEXTURE_2D, m_pyramidLevels, GL_R32F, m_pyramidSize.x, m_pyramidSize.y));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    gl_track_texture(m_pyramid, m_pyramidSize.x, m_pyramidSize.y, GL_R32F, true);
+}
+
+void GpuOcclusionCuller::buildPyramid(GLuint depthTexture, int width, int height) {
+    if (!m_buildProgram || width <= 0 || height <= 0) {
+        return;
+    }
+    if (!m_pyramid || m_depthSize != glm::ivec2(width, height)) {
+        _createPyramid(width, height);
+    }
+
+    GL_CALL(glUseProgram(m_buildProgram));
+    GL_CALL(glActiveTexture(GL_TEXTURE0 + kPyramidUnit));
+    for (int level = 0; level < m_pyramidLevels; level++) {
+        const glm::ivec2 size = level_size(m_pyramidSize, level);
+        const glm::ivec2 source = level == 0 ? m_depthSize : level_size(m_pyramidSize, level - 1);
+
+        // level 0 reads the depth buffer, the others the level below, written by the dispatch before
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, level == 0 ? depthTexture : m_pyramid));
+        GL_CALL(glBindImageTexture(0, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F));
+        GL_CALL(glUniform1i(m_buildLevelLocation, level));
+        GL_CALL(glUniform2i(m_buildSourceSizeLocation, source.x, source.y));
+        GL_CALL(glUniform2i(m_buildSizeLocation, size.x, size.y));
+        GL_CALL(glDispatchCompute((size.x + kBuildGroupSize - 1) / kBuildGroupSize, (size.y + kBuildGroupSize - 1) / kBuildGroupSize, 1));
+        GL_CALL(glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT));
+    }
+    GL_CALL(glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void GpuOcclusionCuller::cull(OcclusionPass pass, const glm::mat4& viewProjection) {
+    if (!m_cullProgram || m_instanceCount == 0) {
+        return;
+    }
+
+    // without a pyramid yet nothing can be hidden, test the frustum only
+    if (pass == OcclusionPass::Late && !m_pyramid) {
+        pass = OcclusionPass::FrustumOnly;
+    }
+
+    const Frustum frustum(viewProjection);
+    GL_CALL(glUseProgram(m_cullProgram));
+    GL_CALL(glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]));
+    GL_CALL(glUniform4fv(m_planesLocation, 6, &frustum.planes[0][0]));
+    GL_CALL(glUniform1ui(m_passLocation, (GLuint)pass));
+    GL_CALL(glUniform1ui(m_instanceCountLocation, m_instanceCount));
+    GL_CALL(glUniform2i(m_pyramidSizeLocation, m_pyramidSize.x, m_pyramidSize.y));
+    GL_CALL(glUniform1i(m_pyramidLevelsLocation, m_pyramidLevels));
+
+    GL_CALL(glActiveTexture(GL_TEXTURE0 + kPyramidUnit));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, m_pyramid));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kBoundsBinding, m_boundsBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibilityBinding, m_visibilityBuffer));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, m_commandBuffers[pass == OcclusionPass::Early ? 0 : 1]));
+    GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kStatsBinding, m_statsBuffer));
+
+    GL_CALL(glDispatchCompute((m_instanceCount + kGroupSize - 1) / kGroupSize, 1, 1));
+    // the draw reads the commands through GL_DRAW_INDIRECT_BUFFER, the next pass the visibility
+    GL_CALL(glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    for (GLuint binding = kBoundsBinding; binding <= kStatsBinding; binding++) {
+        GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0));
+    }
+}
+
+void GpuOcclusionCuller::draw(OcclusionPass pass) const {
+    if (m_instanceCount == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffers[pass == OcclusionPass::Early ? 0 : 1]);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)m_instanceCount, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    // the survivors are only known on the GPU: count the upper bound
+    RenderStats::get().recordDraw(GL_TRIANGLES, m_indexCount, m_instanceCount);
+}
+
+OcclusionStats GpuOcclusionCuller::readStats() const {
+    OcclusionStats stats;
+    if (!m_statsBuffer) {
+        return stats;
+    }
+
+    GLuint counters[kCounterCount] = {};
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer));
+    GL_CALL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), counters));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    stats.instances = counters[kInstances];
+    stats.frustumCulled = counters[kFrustumCulled];
+    stats.occluded = counters[kOccluded];
+    stats.drawnEarly = counters[kDrawnEarly];
+    stats.drawnLate = counters[kDrawnLate];
+    return stats;
+}
+
+void GpuOcclusionCuller::resetStats() {
+    if (!m_statsBuffer) {
+        return;
+    }
+    const GLuint zeros[kCounterCount] = {};
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer));
+    GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+}
+
+void GpuOcclusionCuller::readPyramid(DepthPyramid& pyramid) const {
+    if (!m_pyramid) {
+        return;
+    }
+
+    pyramid.resize(m_depthSize.x, m_depthSize.y);
+    GL_CALL(glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, m_pyramid));
+    GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+    for (size_t level = 0; level < pyramid.levelCount(); level++) {
+        GL_CALL(glGetTexImage(GL_TEXTURE_2D, (GLint)level, GL_RED, GL_FLOAT, pyramid.level(level).data()));
+    }
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void GpuOcclusionCuller::readVisibility(std::vector<uint32_t>& visibility) const {
+    visibility.assign(m_instanceCount, 0);
+    if (!m_visibilityBuffer) {
+        return;
+    }
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilityBuffer));
+    GL_CALL(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, visibility.size() * sizeof(uint32_t), visibility.data()));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+}
+
+uint64_t GpuOcclusionCuller::byteSize() const {
+    uint64_t bytes = (uint64_t)m_instanceCount * (sizeof(OcclusionBounds) + sizeof(uint32_t) + 2 * sizeof(DrawElementsIndirectCommand));
+    if (m_pyramid) {
+        // a full mip chain is a third more than its base
+        bytes += (uint64_t)m_pyramidSize.x * m_pyramidSize.y * sizeof(float) * 4 / 3;
+    }
+    return bytes;
+}
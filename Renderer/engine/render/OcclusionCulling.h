@@ -0,0 +1,220 @@
+#ifndef _OCCLUSION_CULLING_H_
+#define _OCCLUSION_CULLING_H_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../geometry/ClusterCulling.h"
+
+/// World space box of one instance, std430 (vec4 for the alignment, w unused)
+struct OcclusionBounds {
+    glm::vec4 minPoint;
+    glm::vec4 maxPoint;
+};
+
+/**
+ * @brief Max-depth mip chain of a depth buffer (Hi-Z), the CPU reference of GpuOcclusionCuller's
+ *
+ * Level 0 is the largest power of two that fits in the depth buffer, each texel the farthest
+ * depth of the depth texels it overlaps; every level above halves it down to 1x1, keeping the
+ * farthest of four. A box whose nearest depth is farther than every texel it covers is hidden.
+ */
+class DepthPyramid {
+public:
+    /// `depth` is `width * height` window depths, bottom row first
+    void build(const float* depth, int width, int height);
+
+    size_t levelCount() const { return m_levels.size(); }
+
+    glm::ivec2 levelSize(size_t level) const { return m_sizes[level]; }
+
+    float texel(size_t level, int x, int y) const { return m_levels[level][(size_t)y * m_sizes[level].x + x]; }
+
+    const std::vector<float>& level(size_t level) const { return m_levels[level]; }
+
+    std::vector<float>& level(size_t level) { return m_levels[level]; }
+
+    /// Sizes the levels for a `width` x `height` depth buffer without filling them
+    void resize(int width, int height);
+
+private:
+    std::vector<std::vector<float>> m_levels;
+    std::vector<glm::ivec2> m_sizes;
+};
+
+/// Largest power of two not above `value`, at least 1
+inline int pyramid_base_size(int value) {
+    int result = 1;
+    while (result * 2 <= value) {
+        result *= 2;
+    }
+    return result;
+}
+
+/**
+ * @brief What a box covers on screen: uv rectangle and nearest window depth
+ *
+ * `crossesNear` is set when a corner is behind the eye: the projection of such a box is
+ * unbounded and it can't be tested. `outside` is a frustum rejection.
+ */
+struct ProjectedBox {
+    glm::vec2 uvMin;
+    glm::vec2 uvMax;
+    float nearestDepth;
+    bool crossesNear;
+    bool outside;
+};
+
+ProjectedBox project_box(const glm::vec3& lo, const glm::vec3& hi, const glm::mat4& viewProjection);
+
+/**
+ * @brief Whether a box is hidden behind the pyramid
+ *
+ * Reads the level where the box covers at most 2x2 texels, as occlusion_cull.comp does.
+ * `slack` moves the box's depth away (positive) or closer, to tell float noise from real
+ * differences in validation.
+ */
+bool box_occluded(const DepthPyramid& pyramid, const ProjectedBox& box, float slack = 0.0f);
+
+enum class OcclusionPass : uint8_t {
+    Early,          // instances visible last frame, frustum tested
+    Late,           // every instance against the pyramid of the early pass, the ones not drawn early
+    FrustumOnly     // frustum test only, all survivors
+};
+
+struct OcclusionStats {
+    size_t instances = 0;
+    size_t frustumCulled = 0;
+    size_t occluded = 0;        // in the frustum, hidden behind the pyramid
+    size_t drawnEarly = 0;
+    size_t drawnLate = 0;       // newly visible, drawn in the same frame they appeared
+
+    size_t drawn() const { return drawnEarly + drawnLate; }
+};
+
+/**
+ * @brief Two-phase Hi-Z occlusion culling of instances, on the GPU
+ * (assets/shaders/culling/hiz_build.comp, occlusion_cull.comp)
+ *
+ * Each frame:
+ *
+ *     culler.cull(OcclusionPass::Early, viewProjection);  // last frame's visible set
+ *     culler.draw(OcclusionPass::Early);
+ *     culler.buildPyramid(depthTexture, width, height);   // of what the early pass drew
+ *     culler.cull(OcclusionPass::Late, viewProjection);   // everything against it
+ *     culler.draw(OcclusionPass::Late);
+ *
+ * The late pass tests every instance in the frustum against the pyramid of this frame's
+ * early depth; whatever passes and was not drawn early is drawn now, so an object coming
+ * out from behind an occluder shows in the frame it appears rather than one frame late.
+ * Its result is the visible set of the next frame.
+ *
+ * Draws are one DrawElementsIndirectCommand per instance (`instanceCount` 0 when culled,
+ * `baseInstance` the instance index), like GpuClusterCuller's.
+ *
+ * @note Must be initialized and used on the thread that owns the GL context.
+ */
+class GpuOcclusionCuller {
+public:
+    static constexpr GLuint kBoundsBinding = 0;
+    static constexpr GLuint kVisibilityBinding = 1;
+    static constexpr GLuint kCommandBinding = 2;
+    static constexpr GLuint kStatsBinding = 3;
+    static constexpr GLuint kPyramidUnit = 0;
+    static constexpr GLuint kGroupSize = 64;
+    static constexpr GLuint kBuildGroupSize = 8;
+
+    GpuOcclusionCuller();
+
+    GpuOcclusionCuller(const GpuOcclusionCuller& other) = delete;
+
+    GpuOcclusionCuller& operator=(const GpuOcclusionCuller& other) = delete;
+
+    ~GpuOcclusionCuller();
+
+    /**
+     * @brief Compiles the compute shaders in `shaderDirectory` and creates the counters
+     */
+    bool init(const std::string& shaderDirectory = "assets/shaders/culling");
+
+    void shutdown();
+
+    bool initialized() const { return m_cullProgram != 0; }
+
+    /**
+     * @brief Uploads the instance boxes; all of them start out hidden
+     *
+     * @param indexCount indices of the mesh every command draws
+     */
+    void setInstances(const std::vector<OcclusionBounds>& bounds, uint32_t indexCount);
+
+    /// Replaces the boxes of the instances, their count must not change
+    void updateBounds(const std::vector<OcclusionBounds>& bounds);
+
+    /**
+     * @brief Writes the commands of `pass`
+     *
+     * Issues the barrier the indirect draw needs.
+     */
+    void cull(OcclusionPass pass, const glm::mat4& viewProjection);
+
+    /// Draws the commands of `pass` with the bound program and vertex array
+    void draw(OcclusionPass pass) const;
+
+    /**
+     * @brief Builds the pyramid from a depth texture of `width` x `height`
+     */
+    void buildPyramid(GLuint depthTexture, int width, int height);
+
+    /// Totals of every `cull` since the last reset; reads the counters back, so it waits for the GPU
+    OcclusionStats readStats() const;
+
+    void resetStats();
+
+    /// The pyramid as it is on the GPU; waits for it
+    void readPyramid(DepthPyramid& pyramid) const;
+
+    /// 1 for the instances the last late or frustum pass found visible; waits for the GPU
+    void readVisibility(std::vector<uint32_t>& visibility) const;
+
+    size_t instanceCount() const { return m_instanceCount; }
+
+    GLuint pyramidTexture() const { return m_pyramid; }
+
+    /// Bounds, visibility, commands and pyramid
+    uint64_t byteSize() const;
+
+private:
+    GLuint m_buildProgram;
+    GLuint m_cullProgram;
+    GLuint m_boundsBuffer;
+    GLuint m_visibilityBuffer;
+    GLuint m_commandBuffers[2];     // early, late (the frustum pass writes the late one)
+    GLuint m_statsBuffer;
+    GLuint m_pyramid;
+    glm::ivec2 m_depthSize;
+    glm::ivec2 m_pyramidSize;
+    int m_pyramidLevels;
+    uint32_t m_instanceCount;
+    uint32_t m_indexCount;
+    GLint m_viewProjectionLocation;
+    GLint m_planesLocation;
+    GLint m_passLocation;
+    GLint m_instanceCountLocation;
+    GLint m_pyramidSizeLocation;
+    GLint m_pyramidLevelsLocation;
+    GLint m_buildLevelLocation;
+    GLint m_buildSourceSizeLocation;
+    GLint m_buildSizeLocation;
+
+    void _deleteInstances();
+
+    void _createPyramid(int width, int height);
+};
+
+#endif // !_OCCLUSION_CULLING_H_
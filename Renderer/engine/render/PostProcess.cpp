@@ -0,0 +1,280 @@
+#include "PostProcess.h"
+
+#include "../core/Profiler.h"
+#include "../opengl/GpuProfiler.h"
+#include "../opengl/RenderStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMaxBloomLevels = 8;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool linked(const Shader& shader) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(shader.id(), GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+void bind_source(GLuint unit, GLuint texture) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+}
+
+const char* post_pass_name(PostPass pass) {
+    switch (pass)
+    {
+    case PostPass::Bloom:       return "bloom";
+    case PostPass::ToneMap:     return "tone map";
+    case PostPass::Grading:     return "grading";
+    case PostPass::FXAA:        return "fxaa";
+    default:                    return "unknown";
+    }
+}
+
+const char* tone_mapper_name(ToneMapper toneMapper) {
+    switch (toneMapper)
+    {
+    case ToneMapper::Clamp:     return "clamp";
+    case ToneMapper::Reinhard:  return "Reinhard";
+    case ToneMapper::ACES:      return "ACES";
+    default:                    return "unknown";
+    }
+}
+
+PostProcessor::PostProcessor()
+    : m_initialized(false),
+      m_prefilter(),
+      m_downsample(),
+      m_upsample(),
+      m_toneMap(),
+      m_grading(),
+      m_fxaa(),
+      m_emptyVAO(),
+      m_settings(),
+      m_stats(),
+      m_timestamps()
+{}
+
+bool PostProcessor::init(const std::string& shaderDirectory) {
+    if (m_initialized) {
+        return true;
+    }
+
+    const std::string vert = shaderDirectory + "/fullscreen.vert";
+    m_prefilter = std::make_unique<Shader>(vert, shaderDirectory + "/bloom_down.frag", std::vector<std::string>{ "PREFILTER" });
+    m_downsample = std::make_unique<Shader>(vert, shaderDirectory + "/bloom_down.frag");
+    m_upsample = std::make_unique<Shader>(vert, shaderDirectory + "/bloom_up.frag");
+    m_toneMap = std::make_unique<Shader>(vert, shaderDirectory + "/tonemap.frag");
+    m_grading = std::make_unique<Shader>(vert, shaderDirectory + "/grade.frag");
+    m_fxaa = std::make_unique<Shader>(vert, shaderDirectory + "/fxaa.frag");
+
+    for (const Shader* shader : { m_prefilter.get(), m_downsample.get(), m_upsample.get(), m_toneMap.get(), m_grading.get(), m_fxaa.get() }) {
+        if (!linked(*shader)) {
+            gl_log_err("ERROR: could not build the post-processing shaders in %s\n", shaderDirectory.c_str());
+            return false;
+        }
+    }
+
+    m_initialized = true;
+    return true;
+}
+
+void PostProcessor::render(const Framebuffer& scene, GLuint target, int width, int height, RenderTargetPool& pool) {
+    if (!m_initialized || scene.colorCount() == 0) {
+        return;
+    }
+
+    PROFILE_SCOPE("post-processing");
+    PROFILE_GPU_SCOPE("post-processing");
+    const Clock::time_point start = Clock::now();
+
+    _collectTiming();
+    m_timestamps.begin();
+    m_timestamps.mark();
+
+    m_stats.passes = 0;
+    m_stats.draws = 0;
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    const GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_CULL_FACE);
+    m_emptyVAO.bind();
+
+    const Framebuffer* bloom = _bloom(scene, pool);
+    m_timestamps.mark();
+
+    // LDR passes in order, each writing into a pooled target or, the last one, into `target`
+    const bool grading = m_settings.grading;
+    const bool fxaa = m_settings.fxaa;
+    const bool toneMap = m_settings.toneMap || bloom || grading || fxaa;
+    const RenderTargetDesc ldr = { scene.width(), scene.height(), GL_RGBA8, 0, GL_LINEAR };
+    const Framebuffer* source = &scene;
+    bool done = false;
+    auto output = [&](bool last) -> const Framebuffer* {
+        Framebuffer* next = last ? nullptr : pool.acquire(ldr);
+        if (next) {
+            next->bind();
+        }
+        else {
+            // out of targets, the chain ends here
+            glBindFramebuffer(GL_FRAMEBUFFER, target);
+            glViewport(0, 0, width, height);
+            done = true;
+        }
+        m_stats.passes++;
+        return next;
+    };
+    auto consumed = [&](const Framebuffer* next) {
+        if (source != &scene) {
+            pool.release(source);
+        }
+        source = next;
+    };
+
+    if (toneMap) {
+        PROFILE_GPU_SCOPE("tone map");
+        const Framebuffer* next = output(!grading && !fxaa);
+        // tone mapping off but another pass on: the same pass with a plain clamp and no exposure
+        const bool curve = m_settings.toneMap;
+        m_toneMap->use();
+        m_toneMap->setUniform("exposure", curve ? m_settings.exposure : 1.0f);
+        m_toneMap->setUniform("toneMapper", curve ? (int)m_settings.toneMapper : (int)ToneMapper::Clamp);
+        m_toneMap->setUniform("bloomIntensity", bloom ? m_settings.bloomIntensity : 0.0f);
+        bind_source(0, source->colorTexture());
+        bind_source(1, bloom ? bloom->colorTexture() : 0);
+        _draw();
+        if (bloom) {
+            pool.release(bloom);
+        }
+        consumed(next);
+    }
+    m_timestamps.mark();
+
+    if (grading && !done) {
+        PROFILE_GPU_SCOPE("grading");
+        const Framebuffer* next = output(!fxaa);
+        m_grading->use();
+        m_grading->setUniform("tint", m_settings.tint);
+        m_grading->setUniform("contrast", m_settings.contrast);
+        m_grading->setUniform("saturation", m_settings.saturation);
+        bind_source(0, source->colorTexture());
+        _draw();
+        consumed(next);
+    }
+    m_timestamps.mark();
+
+    if (fxaa && !done) {
+        PROFILE_GPU_SCOPE("fxaa");
+        output(true);
+        m_fxaa->use();
+        m_fxaa->setUniform("texelSize", glm::vec2(1.0f / source->width(), 1.0f / source->height()));
+        bind_source(0, source->colorTexture());
+        _draw();
+        consumed(nullptr);
+    }
+    m_timestamps.mark();
+
+    if (!toneMap) {
+        // every pass off
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, scene.id());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+        glBlitFramebuffer(0, 0, scene.width(), scene.height(), 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, width, height);
+    }
+
+    glBindVertexArray(0);
+    bind_source(1, 0);
+    bind_source(0, 0);
+    depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+
+    m_timestamps.end();
+    m_stats.cpuMs = elapsed_ms(start);
+}
+
+const Framebuffer* PostProcessor::_bloom(const Framebuffer& scene, RenderTargetPool& pool) {
+    if (!m_settings.bloom || m_settings.bloomIntensity <= 0.0f) {
+        return nullptr;
+    }
+
+    PROFILE_GPU_SCOPE("bloom");
+    // levels down to a few texels at most
+    const Framebuffer* levels[kMaxBloomLevels] = {};
+    int count = 0;
+    int width = scene.width(), height = scene.height();
+    const int maxLevels = std::min(std::max(m_settings.bloomLevels, 1), kMaxBloomLevels);
+    while (count < maxLevels && width > 8 && height > 8) {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        levels[count] = pool.acquire({ width, height, GL_RGBA16F, 0, GL_LINEAR });
+        if (!levels[count]) {
+            break;
+        }
+        count++;
+    }
+    if (count == 0) {
+        return nullptr;
+    }
+
+    const float knee = std::max(m_settings.bloomKnee * m_settings.bloomThreshold, 1e-4f);
+    const Framebuffer* source = &scene;
+    for (int i = 0; i < count; i++) {
+        Shader& shader = i == 0 ? *m_prefilter : *m_downsample;
+        levels[i]->bind();
+        shader.use();
+        shader.setUniform("texelSize", glm::vec2(1.0f / source->width(), 1.0f / source->height()));
+        if (i == 0) {
+            shader.setUniform("threshold", glm::vec4(m_settings.bloomThreshold, m_settings.bloomThreshold - knee, 2.0f * knee, 0.25f / knee));
+        }
+        bind_source(0, source->colorTexture());
+        _draw();
+        source = levels[i];
+    }
+
+    // each level adds the blurred one below it, from the smallest up
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    m_upsample->use();
+    m_upsample->setUniform("radius", m_settings.bloomRadius);
+    for (int i = count - 1; i > 0; i--) {
+        levels[i - 1]->bind();
+        m_upsample->setUniform("texelSize", glm::vec2(1.0f / levels[i]->width(), 1.0f / levels[i]->height()));
+        bind_source(0, levels[i]->colorTexture());
+        _draw();
+        pool.release(levels[i]);
+    }
+    glDisable(GL_BLEND);
+
+    m_stats.passes++;
+    return levels[0];
+}
+
+void PostProcessor::_draw() {
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+    m_stats.draws++;
+}
+
+void PostProcessor::_collectTiming() {
+    // one timestamp at the start, then one after each pass, skipped ones too
+    m_timestamps.collect([this](size_t, const GLuint64* times, size_t count) {
+        for (size_t pass = 0; pass + 1 < count && pass < PostStats::kPasses; pass++) {
+            m_stats.gpuMs[pass] = (double)(times[pass + 1] - times[pass]) * 1e-6;
+        }
+    });
+}
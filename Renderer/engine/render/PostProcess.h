@@ -0,0 +1,132 @@
+#ifndef _POST_PROCESS_H_
+#define _POST_PROCESS_H_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../core/Shader.h"
+#include "../opengl/Framebuffer.h"
+#include "../opengl/OpenGLPipeline.h"
+#include "../opengl/RenderTargetPool.h"
+#include "../opengl/TimestampRing.h"
+
+enum class ToneMapper : uint8_t {
+    Clamp,          // no curve: at exposure 1 the scene looks as it did without post-processing
+    Reinhard,
+    ACES
+};
+
+enum class PostPass : uint8_t {
+    Bloom,
+    ToneMap,
+    Grading,
+    FXAA,
+    Count
+};
+
+const char* post_pass_name(PostPass pass);
+
+const char* tone_mapper_name(ToneMapper toneMapper);
+
+struct PostSettings {
+    bool bloom = true;
+    float bloomThreshold = 1.0f;        // scene brightness where bloom starts
+    float bloomKnee = 0.5f;             // width of the soft transition below the threshold
+    float bloomIntensity = 0.5f;
+    float bloomRadius = 1.0f;           // of the upsampling tent, in texels of the smaller level
+    int bloomLevels = 5;                // halvings of the chain, fewer on small targets
+
+    bool toneMap = true;
+    ToneMapper toneMapper = ToneMapper::ACES;
+    float exposure = 1.0f;
+
+    bool grading = true;
+    glm::vec3 tint = glm::vec3(1.0f);
+    float contrast = 1.0f;
+    float saturation = 1.0f;
+
+    bool fxaa = true;
+};
+
+struct PostStats {
+    static constexpr size_t kPasses = (size_t)PostPass::Count;
+
+    uint32_t passes = 0;                // run last frame, skipped ones don't count
+    uint32_t draws = 0;                 // full-screen triangles drawn last frame
+    double cpuMs = 0.0;
+    double gpuMs[kPasses] = {};         // of the most recent frame that resolved, 0 for skipped passes
+};
+
+/**
+ * @brief Post-processing chain, from an HDR scene target to the display
+ *
+ *   bloom      bright-pass and 13-tap downsampling into a chain of half sized RGBA16F
+ *              targets, then tent upsampling added back up the chain
+ *   tone map   scene plus bloom, exposure and a curve, to RGBA8
+ *   grading    tint, contrast and saturation
+ *   FXAA       edge-directed anti-aliasing of the final image
+ *
+ * Every pass is one full-screen triangle. Intermediate targets come from a RenderTargetPool
+ * and go back to it as soon as the next pass consumed them, so the chain allocates nothing
+ * once the size settles and the LDR ping-pong targets are shared. The last enabled pass
+ * writes straight into the destination; with every pass off the scene is blitted.
+ *
+ * Per-pass GPU times come from timestamp pairs read back a frame or two later, as the
+ * shadow renderer does.
+ */
+class PostProcessor {
+public:
+    PostProcessor();
+
+    PostProcessor(const PostProcessor& other) = delete;
+
+    PostProcessor& operator=(const PostProcessor& other) = delete;
+
+    bool init(const std::string& shaderDirectory = "assets/shaders/post");
+
+    bool initialized() const { return m_initialized; }
+
+    PostSettings& settings() { return m_settings; }
+
+    const PostSettings& settings() const { return m_settings; }
+
+    void setSettings(const PostSettings& settings) { m_settings = settings; }
+
+    /**
+     * @brief Runs the chain on the first color attachment of `scene`
+     *
+     * Writes the result to framebuffer `target` over the `width` x `height` viewport at its
+     * origin, and leaves `target` bound. Depth test and blending are restored.
+     */
+    void render(const Framebuffer& scene, GLuint target, int width, int height, RenderTargetPool& pool);
+
+    /// Of the last render
+    const PostStats& stats() const { return m_stats; }
+
+private:
+    bool m_initialized;
+    std::unique_ptr<Shader> m_prefilter;
+    std::unique_ptr<Shader> m_downsample;
+    std::unique_ptr<Shader> m_upsample;
+    std::unique_ptr<Shader> m_toneMap;
+    std::unique_ptr<Shader> m_grading;
+    std::unique_ptr<Shader> m_fxaa;
+    VertexArray m_emptyVAO;
+    PostSettings m_settings;
+    PostStats m_stats;
+
+    TimestampRing m_timestamps;
+
+    /// Bloom chain of the scene, its largest level; null if bloom is off
+    const Framebuffer* _bloom(const Framebuffer& scene, RenderTargetPool& pool);
+
+    void _draw();
+
+    void _collectTiming();
+};
+
+#endif // !_POST_PROCESS_H_
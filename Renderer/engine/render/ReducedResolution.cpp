@@ -0,0 +1,286 @@
+#include "ReducedResolution.h"
+
+#include "../core/Profiler.h"
+#include "../opengl/GpuProfiler.h"
+#include "../opengl/RenderStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool linked(const Shader& shader) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(shader.id(), GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+void bind_source(GLuint unit, GLuint texture) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+int reduced_size(int size, PassResolution resolution) {
+    const int divisor = pass_resolution_divisor(resolution);
+    return std::max((size + divisor - 1) / divisor, 1);
+}
+
+}
+
+const char* pass_resolution_name(PassResolution resolution) {
+    switch (resolution)
+    {
+    case PassResolution::Full:      return "full";
+    case PassResolution::Half:      return "half";
+    case PassResolution::Quarter:   return "quarter";
+    default:                        return "unknown";
+    }
+}
+
+int pass_resolution_divisor(PassResolution resolution) {
+    switch (resolution)
+    {
+    case PassResolution::Half:      return 2;
+    case PassResolution::Quarter:   return 4;
+    default:                        return 1;
+    }
+}
+
+const char* composite_mode_name(CompositeMode mode) {
+    switch (mode)
+    {
+    case CompositeMode::Add:        return "add";
+    case CompositeMode::Multiply:   return "multiply";
+    case CompositeMode::Over:       return "over";
+    default:                        return "unknown";
+    }
+}
+
+ReducedResolution::ReducedResolution()
+    : m_initialized(false),
+      m_reduceDepth(),
+      m_bilateral(),
+      m_bilinear(),
+      m_emptyVAO(),
+      m_settings(),
+      m_pool(nullptr),
+      m_sceneDepth(0),
+      m_width(0),
+      m_height(0),
+      m_depths(),
+      m_passes(),
+      m_depthMs(),
+      m_timestamps(),
+      m_intervals(m_timestamps.slotCount())
+{}
+
+bool ReducedResolution::init(const std::string& shaderDirectory) {
+    if (m_initialized) {
+        return true;
+    }
+
+    const std::string vert = shaderDirectory + "/fullscreen.vert";
+    m_reduceDepth = std::make_unique<Shader>(vert, shaderDirectory + "/depth_reduce.frag");
+    m_bilateral = std::make_unique<Shader>(vert, shaderDirectory + "/bilateral_upsample.frag", std::vector<std::string>{ "BILATERAL" });
+    m_bilinear = std::make_unique<Shader>(vert, shaderDirectory + "/bilateral_upsample.frag");
+    for (const Shader* shader : { m_reduceDepth.get(), m_bilateral.get(), m_bilinear.get() }) {
+        if (!linked(*shader)) {
+            gl_log_err("ERROR: could not build the reduced resolution shaders in %s\n", shaderDirectory.c_str());
+            return false;
+        }
+    }
+
+    m_initialized = true;
+    return true;
+}
+
+void ReducedResolution::beginFrame(GLuint sceneDepth, int width, int height, RenderTargetPool& pool) {
+    m_pool = &pool;
+    m_sceneDepth = sceneDepth;
+    m_width = width;
+    m_height = height;
+    if (!m_initialized) {
+        return;
+    }
+
+    _collectTiming();
+    // the intervals of a slot still in flight are what its timestamps get read back against
+    if (m_timestamps.begin()) {
+        m_intervals[m_timestamps.slot()].clear();
+    }
+}
+
+void ReducedResolution::render(const char* name, PassResolution resolution, CompositeMode mode, GLuint target,
+                               const std::function<void(const ReducedPassView&)>& draw)
+{
+    if (!m_initialized || !m_pool || !m_sceneDepth) {
+        return;
+    }
+
+    PROFILE_SCOPE(name);
+    PROFILE_GPU_SCOPE(name);
+    const Clock::time_point start = Clock::now();
+    ReducedPassStats& stats = _stats(name);
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    const GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+
+    const Framebuffer* depth = _depth(resolution);
+    const int width = reduced_size(m_width, resolution);
+    const int height = reduced_size(m_height, resolution);
+    Framebuffer* output = depth ? m_pool->acquire({ width, height, m_settings.colorFormat, 0, GL_LINEAR }) : nullptr;
+    if (!output) {
+        gl_log_err("ERROR: no %dx%d target for pass %s\n", width, height, name);
+        return;
+    }
+
+    _begin(name, resolution, false);
+    output->bind();
+    // what the composite turns into no change at all
+    const float identity = mode == CompositeMode::Multiply ? 1.0f : 0.0f;
+    const GLfloat clear[4] = { identity, identity, identity, identity };
+    glClearBufferfv(GL_COLOR, 0, clear);
+    draw({ width, height, resolution, depth->colorTexture() });
+    _end();
+
+    _begin(name, resolution, true);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(0, 0, m_width, m_height);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    switch (mode)
+    {
+    case CompositeMode::Add:        glBlendFunc(GL_ONE, GL_ONE); break;
+    case CompositeMode::Multiply:   glBlendFunc(GL_DST_COLOR, GL_ZERO); break;
+    case CompositeMode::Over:       glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); break;
+    default:                        break;
+    }
+    // at full resolution there is nothing to upsample
+    Shader& shader = m_settings.bilateral && resolution != PassResolution::Full ? *m_bilateral : *m_bilinear;
+    shader.use();
+    shader.setUniform("depthRange", glm::vec2(m_settings.nearPlane, m_settings.farPlane));
+    shader.setUniform("depthTolerance", std::max(m_settings.depthTolerance, 1e-4f));
+    bind_source(0, output->colorTexture());
+    bind_source(1, m_sceneDepth);
+    bind_source(2, depth->colorTexture());
+    _draw();
+    _end();
+
+    glBindVertexArray(0);
+    bind_source(2, 0);
+    bind_source(1, 0);
+    bind_source(0, 0);
+    m_pool->release(output);
+    depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+
+    stats.resolution = resolution;
+    stats.width = width;
+    stats.height = height;
+    stats.cpuMs = elapsed_ms(start);
+}
+
+void ReducedResolution::endFrame() {
+    for (Framebuffer*& depth : m_depths) {
+        if (depth) {
+            m_pool->release(depth);
+            depth = nullptr;
+        }
+    }
+    if (!m_initialized) {
+        return;
+    }
+
+    m_timestamps.end();
+}
+
+const Framebuffer* ReducedResolution::_depth(PassResolution resolution) {
+    Framebuffer*& depth = m_depths[(size_t)resolution];
+    if (depth) {
+        return depth;
+    }
+
+    const int width = reduced_size(m_width, resolution);
+    const int height = reduced_size(m_height, resolution);
+    depth = m_pool->acquire({ width, height, GL_R32F, 0, GL_NEAREST });
+    if (!depth) {
+        return nullptr;
+    }
+
+    PROFILE_GPU_SCOPE("reduce depth");
+    _begin(nullptr, resolution, false);
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    depth->bind();
+    m_reduceDepth->use();
+    m_reduceDepth->setUniform("divisor", pass_resolution_divisor(resolution));
+    m_reduceDepth->setUniform("depthRange", glm::vec2(m_settings.nearPlane, m_settings.farPlane));
+    bind_source(0, m_sceneDepth);
+    _draw();
+    bind_source(0, 0);
+    depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    _end();
+    return depth;
+}
+
+ReducedPassStats& ReducedResolution::_stats(const char* name) {
+    for (ReducedPassStats& stats : m_passes) {
+        if (stats.name == name || !strcmp(stats.name, name)) {
+            return stats;
+        }
+    }
+    m_passes.push_back(ReducedPassStats());
+    m_passes.back().name = name;
+    return m_passes.back();
+}
+
+void ReducedResolution::_begin(const char* name, PassResolution resolution, bool composite) {
+    if (!m_timestamps.timed()) {
+        return;
+    }
+
+    m_timestamps.mark();
+    m_intervals[m_timestamps.slot()].push_back({ name, resolution, composite });
+}
+
+void ReducedResolution::_end() {
+    m_timestamps.mark();
+}
+
+void ReducedResolution::_draw() {
+    m_emptyVAO.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    RenderStats::get().recordDraw(GL_TRIANGLES, 3);
+}
+
+void ReducedResolution::_collectTiming() {
+    m_timestamps.collect([this](size_t slot, const GLuint64* times, size_t count) {
+        const std::vector<Interval>& intervals = m_intervals[slot];
+        for (size_t i = 0; i < count / 2; i++) {
+            const double ms = (double)(times[2 * i + 1] - times[2 * i]) * 1e-6;
+            const Interval& interval = intervals[i];
+            const size_t resolution = (size_t)interval.resolution;
+            if (!interval.name) {
+                m_depthMs[resolution] = ms;
+            }
+            else if (interval.composite) {
+                _stats(interval.name).compositeMs[resolution] = ms;
+            }
+            else {
+                _stats(interval.name).drawMs[resolution] = ms;
+            }
+        }
+    });
+}
@@ -0,0 +1,169 @@
+#ifndef _REDUCED_RESOLUTION_H_
+#define _REDUCED_RESOLUTION_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/Shader.h"
+#include "../opengl/Framebuffer.h"
+#include "../opengl/OpenGLPipeline.h"
+#include "../opengl/RenderTargetPool.h"
+#include "../opengl/TimestampRing.h"
+
+enum class PassResolution : uint8_t {
+    Full,
+    Half,
+    Quarter,
+    Count
+};
+
+const char* pass_resolution_name(PassResolution resolution);
+
+/// 1, 2 or 4
+int pass_resolution_divisor(PassResolution resolution);
+
+/// How the output of a pass goes onto the target
+enum class CompositeMode : uint8_t {
+    Add,            // light: volumetric scattering, additive particles
+    Multiply,       // attenuation: ambient occlusion, its output is the factor
+    Over            // premultiplied alpha: fog, alpha blended particles
+};
+
+const char* composite_mode_name(CompositeMode mode);
+
+/// What a pass draws with, its target bound with a viewport covering it
+struct ReducedPassView {
+    int width;
+    int height;
+    PassResolution resolution;
+    GLuint depth;               // R32F linear view depth of the scene at this resolution
+};
+
+struct ReducedResolutionSettings {
+    float nearPlane = 0.1f;             // of the projection the scene depth was rendered with
+    float farPlane = 100.0f;
+    float depthTolerance = 0.05f;       // depth difference, relative to the pixel's, that halves a texel's weight
+    bool bilateral = true;              // off: plain bilinear upsampling
+    GLenum colorFormat = GL_RGBA16F;    // of the pass outputs
+};
+
+struct ReducedPassStats {
+    static constexpr size_t kResolutions = (size_t)PassResolution::Count;
+
+    const char* name = nullptr;
+    PassResolution resolution = PassResolution::Full;   // of the last frame
+    int width = 0;
+    int height = 0;
+    double cpuMs = 0.0;                     // of the last frame, draw and composite
+    double drawMs[kResolutions] = {};       // GPU, of the most recent frame that resolved at each resolution
+    double compositeMs[kResolutions] = {};
+};
+
+/**
+ * @brief Runs passes that don't need every pixel at half or quarter resolution and
+ * composites them back onto the full resolution target
+ *
+ * A frame starts on the depth of the scene. A pass draws into a pooled target of its
+ * resolution, cleared to what leaves the target unchanged under its composite mode, with
+ * the scene depth reduced to the same resolution to test against or sample. Reduced depths
+ * are linear view depth, one texel per block: the nearest one, so thin foreground survives.
+ * They are made the first time a resolution is asked for in a frame and shared by its passes.
+ *
+ * The composite is a depth-aware bilateral upsample: each full resolution pixel blends the
+ * four reduced texels around it by their bilinear weight, lowered the further their depth
+ * is from the pixel's. Across a silhouette the texels on the pixel's own side win, so the
+ * effect does not bleed over edges the way bilinear upsampling does.
+ *
+ * GPU times of the draw and of the composite are kept per pass and resolution, read back a
+ * frame or two later, so switching a pass between resolutions shows what each one costs.
+ */
+class ReducedResolution {
+public:
+    ReducedResolution();
+
+    ReducedResolution(const ReducedResolution& other) = delete;
+
+    ReducedResolution& operator=(const ReducedResolution& other) = delete;
+
+    bool init(const std::string& shaderDirectory = "assets/shaders/post");
+
+    bool initialized() const { return m_initialized; }
+
+    ReducedResolutionSettings& settings() { return m_settings; }
+
+    const ReducedResolutionSettings& settings() const { return m_settings; }
+
+    void setSettings(const ReducedResolutionSettings& settings) { m_settings = settings; }
+
+    /// `sceneDepth` is the depth texture of the scene, the size of the targets passes composite onto
+    void beginFrame(GLuint sceneDepth, int width, int height, RenderTargetPool& pool);
+
+    /**
+     * @brief Runs `draw` at `resolution` and composites its output onto framebuffer `target`
+     *
+     * `name` must outlive the renderer, a string literal in practice. Leaves `target` bound
+     * with a full viewport; depth test, blending and culling are restored.
+     */
+    void render(const char* name, PassResolution resolution, CompositeMode mode, GLuint target,
+                const std::function<void(const ReducedPassView&)>& draw);
+
+    /// Gives the reduced depths back to the pool
+    void endFrame();
+
+    size_t passCount() const { return m_passes.size(); }
+
+    /// In the order they first ran
+    const ReducedPassStats& pass(size_t index) const { return m_passes[index]; }
+
+    /// GPU time of reducing the depth to `resolution`, 0 if no pass used it lately
+    double depthMs(PassResolution resolution) const { return m_depthMs[(size_t)resolution]; }
+
+private:
+    static constexpr size_t kResolutions = ReducedPassStats::kResolutions;
+
+    /// A timestamp pair: the depth reduction, or the draw or composite of a pass
+    struct Interval {
+        const char* name;           // null for the depth
+        PassResolution resolution;
+        bool composite;
+    };
+
+    bool m_initialized;
+    std::unique_ptr<Shader> m_reduceDepth;
+    std::unique_ptr<Shader> m_bilateral;
+    std::unique_ptr<Shader> m_bilinear;
+    VertexArray m_emptyVAO;
+    ReducedResolutionSettings m_settings;
+
+    RenderTargetPool* m_pool;
+    GLuint m_sceneDepth;
+    int m_width;
+    int m_height;
+    Framebuffer* m_depths[kResolutions];
+
+    std::vector<ReducedPassStats> m_passes;
+    double m_depthMs[kResolutions];
+
+    TimestampRing m_timestamps;
+    std::vector<std::vector<Interval>> m_intervals;     // of each slot of the ring, a timestamp pair each
+
+    /// Of this frame, made on first use; null if no target could be had
+    const Framebuffer* _depth(PassResolution resolution);
+
+    ReducedPassStats& _stats(const char* name);
+
+    void _begin(const char* name, PassResolution resolution, bool composite);
+
+    void _end();
+
+    void _draw();
+
+    void _collectTiming();
+};
+
+#endif // !_REDUCED_RESOLUTION_H_
@@ -0,0 +1,785 @@
+#include "RenderGraph.h"
+
+#include "../core/Memory.h"
+#include "../core/Profiler.h"
+#include "../opengl/GpuProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kUnscheduled = UINT32_MAX;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// Image and storage writes bypass the caches the other accesses go through
+bool incoherent(ResourceAccess access) {
+    return access == ResourceAccess::Image || access == ResourceAccess::Storage;
+}
+
+/// What makes earlier incoherent writes visible to `access`
+GLbitfield barrier_bits(ResourceAccess access, bool buffer) {
+    switch (access)
+    {
+    case ResourceAccess::Attachment:    return GL_FRAMEBUFFER_BARRIER_BIT;
+    case ResourceAccess::Sampled:       return GL_TEXTURE_FETCH_BARRIER_BIT;
+    case ResourceAccess::Image:         return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    case ResourceAccess::Storage:       return GL_SHADER_STORAGE_BARRIER_BIT;
+    case ResourceAccess::Uniform:       return GL_UNIFORM_BARRIER_BIT;
+    case ResourceAccess::Indirect:      return GL_COMMAND_BARRIER_BIT;
+    case ResourceAccess::Vertex:        return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT;
+    case ResourceAccess::Transfer:
+        return (buffer ? GL_BUFFER_UPDATE_BARRIER_BIT : GL_TEXTURE_UPDATE_BARRIER_BIT) | GL_PIXEL_BUFFER_BARRIER_BIT;
+    default:                            return GL_ALL_BARRIER_BITS;
+    }
+}
+
+/// Anything outside the graph may do with an imported resource
+GLbitfield exit_barrier_bits(bool buffer) {
+    if (buffer) {
+        return GL_SHADER_STORAGE_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+               GL_ELEMENT_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+    }
+    return GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+           GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+}
+
+/// Escapes `text` for a quoted DOT label
+void append_label(std::string& dot, const char* text) {
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            dot += '\\';
+        }
+        dot += *c;
+    }
+}
+
+}
+
+const char* resource_access_name(ResourceAccess access) {
+    switch (access)
+    {
+    case ResourceAccess::Attachment:    return "attachment";
+    case ResourceAccess::Sampled:       return "sampled";
+    case ResourceAccess::Image:         return "image";
+    case ResourceAccess::Storage:       return "storage";
+    case ResourceAccess::Uniform:       return "uniform";
+    case ResourceAccess::Indirect:      return "indirect";
+    case ResourceAccess::Vertex:        return "vertex";
+    case ResourceAccess::Transfer:      return "transfer";
+    default:                            return "unknown";
+    }
+}
+
+std::string memory_barrier_names(GLbitfield barriers) {
+    static const std::pair<GLbitfield, const char*> kBits[] = {
+        { GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT, "vertex" },
+        { GL_ELEMENT_ARRAY_BARRIER_BIT, "element" },
+        { GL_UNIFORM_BARRIER_BIT, "uniform" },
+        { GL_TEXTURE_FETCH_BARRIER_BIT, "texture fetch" },
+        { GL_SHADER_IMAGE_ACCESS_BARRIER_BIT, "image" },
+        { GL_COMMAND_BARRIER_BIT, "command" },
+        { GL_PIXEL_BUFFER_BARRIER_BIT, "pixel buffer" },
+        { GL_TEXTURE_UPDATE_BARRIER_BIT, "texture update" },
+        { GL_BUFFER_UPDATE_BARRIER_BIT, "buffer update" },
+        { GL_FRAMEBUFFER_BARRIER_BIT, "framebuffer" },
+        { GL_TRANSFORM_FEEDBACK_BARRIER_BIT, "transform feedback" },
+        { GL_ATOMIC_COUNTER_BARRIER_BIT, "atomic counter" },
+        { GL_SHADER_STORAGE_BARRIER_BIT, "storage" },
+    };
+
+    std::string names;
+    for (const auto& bit : kBits) {
+        if (barriers & bit.first) {
+            names += names.empty() ? "" : " | ";
+            names += bit.second;
+        }
+    }
+    return names;
+}
+
+RenderGraph::RenderGraph(RenderTargetPool& pool)
+    : m_pool(pool),
+      m_resources(),
+      m_resourceCount(0),
+      m_passes(),
+      m_passCount(0),
+      m_accesses(),
+      m_edges(),
+      m_schedule(),
+      m_released(),
+      m_exitBarriers(0),
+      m_compiled(false),
+      m_stats(),
+      m_buffers(),
+      m_timestamps(),
+      m_timedNames(m_timestamps.slotCount()),
+      m_gpuTimes(),
+      m_frame(0)
+{}
+
+RenderGraph::~RenderGraph() {
+    for (const PooledBuffer& buffer : m_buffers) {
+        gl_untrack_buffer(buffer.id);
+        GL_CALL(glDeleteBuffers(1, &buffer.id));
+    }
+}
+
+void RenderGraph::reset() {
+    m_resourceCount = 0;
+    m_passCount = 0;
+    m_accesses.clear();
+    m_schedule.clear();
+    m_exitBarriers = 0;
+    m_compiled = false;
+}
+
+RenderGraphResource RenderGraph::createTexture(const char* name, const RenderTargetDesc& desc) {
+    if (desc.width <= 0 || desc.height <= 0 || (!desc.colorFormat && !desc.depthFormat)) {
+        gl_log_err("ERROR: render graph: texture %s is %dx%d without a format\n", name, desc.width, desc.height);
+        return RenderGraphResource();
+    }
+
+    Resource& resource = _addResource(name, Kind::Texture, false);
+    resource.desc = desc;
+    resource.width = desc.width;
+    resource.height = desc.height;
+    return { (uint32_t)(m_resourceCount - 1) };
+}
+
+RenderGraphResource RenderGraph::createBuffer(const char* name, size_t size) {
+    if (size == 0) {
+        gl_log_err("ERROR: render graph: buffer %s is empty\n", name);
+        return RenderGraphResource();
+    }
+
+    Resource& resource = _addResource(name, Kind::Buffer, false);
+    resource.size = size;
+    return { (uint32_t)(m_resourceCount - 1) };
+}
+
+RenderGraphResource RenderGraph::importTarget(const char* name, GLuint framebuffer, int width, int height, GLuint texture) {
+    Resource& resource = _addResource(name, Kind::Texture, true);
+    resource.framebuffer = framebuffer;
+    resource.texture = texture;
+    resource.width = width;
+    resource.height = height;
+    resource.lastObject = framebuffer;
+    return { (uint32_t)(m_resourceCount - 1) };
+}
+
+RenderGraphResource RenderGraph::importTarget(const char* name, const Framebuffer& framebuffer) {
+    const GLuint texture = framebuffer.colorCount() ? framebuffer.colorTexture() : framebuffer.depthTexture();
+    return importTarget(name, framebuffer.id(), framebuffer.width(), framebuffer.height(), texture);
+}
+
+RenderGraphResource RenderGraph::importBuffer(const char* name, GLuint buffer, size_t size) {
+    Resource& resource = _addResource(name, Kind::Buffer, true);
+    resource.buffer = buffer;
+    resource.size = size;
+    resource.lastObject = buffer;
+    return { (uint32_t)(m_resourceCount - 1) };
+}
+
+RenderGraphPass RenderGraph::addPass(const char* name, std::function<void(const RenderGraph&)> execute) {
+    if (m_passCount == m_passes.size()) {
+        m_passes.emplace_back();
+    }
+    Pass& pass = m_passes[m_passCount++];
+    pass.name = name;
+    pass.execute = std::move(execute);
+    pass.sideEffect = false;
+    pass.culled = true;
+    pass.order = kUnscheduled;
+    pass.firstAccess = 0;
+    pass.accessCount = 0;
+    pass.pending = 0;
+    pass.barriers = 0;
+    pass.acquires.clear();
+    pass.releases.clear();
+    pass.cpuMs = 0.0;
+    pass.gpuMs = 0.0;
+    m_compiled = false;
+    return (RenderGraphPass)(m_passCount - 1);
+}
+
+void RenderGraph::read(RenderGraphPass pass, RenderGraphResource resource, ResourceAccess access) {
+    _access(pass, resource, access, false);
+}
+
+void RenderGraph::write(RenderGraphPass pass, RenderGraphResource resource, ResourceAccess access) {
+    _access(pass, resource, access, true);
+}
+
+void RenderGraph::setSideEffect(RenderGraphPass pass) {
+    if (pass < m_passCount) {
+        m_passes[pass].sideEffect = true;
+        m_compiled = false;
+    }
+}
+
+bool RenderGraph::compile() {
+    const Clock::time_point start = Clock::now();
+    m_compiled = false;
+    m_schedule.clear();
+    m_edges.clear();
+    m_exitBarriers = 0;
+    m_stats = RenderGraphStats();
+    m_stats.passes = (uint32_t)m_passCount;
+
+    // accesses grouped by pass, in declaration order within it
+    // (usually already are, and stable_sort allocates)
+    auto byPass = [](const Access& a, const Access& b) { return a.pass < b.pass; };
+    if (!std::is_sorted(m_accesses.begin(), m_accesses.end(), byPass)) {
+        std::stable_sort(m_accesses.begin(), m_accesses.end(), byPass);
+    }
+    for (size_t i = 0; i < m_passCount; i++) {
+        Pass& pass = m_passes[i];
+        pass.culled = true;
+        pass.order = kUnscheduled;
+        pass.accessCount = 0;
+        pass.pending = 0;
+        pass.barriers = 0;
+        pass.acquires.clear();
+        pass.releases.clear();
+        pass.cpuMs = 0.0;
+        pass.gpuMs = 0.0;
+    }
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        m_resources[i].writers.clear();
+        m_resources[i].readers.clear();
+    }
+    for (size_t i = 0; i < m_accesses.size(); i++) {
+        const Access& access = m_accesses[i];
+        Pass& pass = m_passes[access.pass];
+        if (pass.accessCount++ == 0) {
+            pass.firstAccess = (uint32_t)i;
+        }
+        std::vector<RenderGraphPass>& passes = access.write ? m_resources[access.resource].writers : m_resources[access.resource].readers;
+        if (passes.empty() || passes.back() != access.pass) {
+            passes.push_back(access.pass);
+        }
+    }
+    auto writes = [](const Resource& resource, RenderGraphPass pass) {
+        return std::binary_search(resource.writers.begin(), resource.writers.end(), pass);
+    };
+
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        const Resource& resource = m_resources[i];
+        if (!resource.imported && resource.writers.empty() && !resource.readers.empty()) {
+            gl_log_err("ERROR: render graph: pass %s reads %s, which no pass writes\n", m_passes[resource.readers[0]].name, resource.name);
+            return false;
+        }
+    }
+
+    // culling: from the passes with an effect outside the graph back to what they read
+    std::vector<RenderGraphPass>& work = m_schedule;
+    for (size_t i = 0; i < m_passCount; i++) {
+        Pass& pass = m_passes[i];
+        bool keep = pass.sideEffect;
+        for (uint32_t a = pass.firstAccess; a < pass.firstAccess + pass.accessCount && !keep; a++) {
+            keep = m_accesses[a].write && m_resources[m_accesses[a].resource].imported;
+        }
+        if (keep) {
+            pass.culled = false;
+            work.push_back((RenderGraphPass)i);
+        }
+    }
+    while (!work.empty()) {
+        const Pass& pass = m_passes[work.back()];
+        const RenderGraphPass index = work.back();
+        work.pop_back();
+        for (uint32_t a = pass.firstAccess; a < pass.firstAccess + pass.accessCount; a++) {
+            // the writers before it: writes may be partial, a pass writing a resource keeps the ones before too
+            for (RenderGraphPass writer : m_resources[m_accesses[a].resource].writers) {
+                if (writer == index) {
+                    break;
+                }
+                if (m_passes[writer].culled) {
+                    m_passes[writer].culled = false;
+                    work.push_back(writer);
+                }
+            }
+        }
+    }
+
+    // dependencies between kept passes: writers in order, readers after the last writer
+    size_t kept = 0;
+    for (size_t i = 0; i < m_passCount; i++) {
+        kept += !m_passes[i].culled;
+    }
+    m_stats.culled = (uint32_t)(m_passCount - kept);
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        const Resource& resource = m_resources[i];
+        RenderGraphPass lastWriter = kUnscheduled;
+        for (RenderGraphPass writer : resource.writers) {
+            if (m_passes[writer].culled) {
+                continue;
+            }
+            if (lastWriter != kUnscheduled) {
+                m_edges.push_back({ lastWriter, writer });
+            }
+            lastWriter = writer;
+        }
+        for (RenderGraphPass reader : resource.readers) {
+            if (lastWriter != kUnscheduled && !m_passes[reader].culled && !writes(resource, reader)) {
+                m_edges.push_back({ lastWriter, reader });
+            }
+        }
+    }
+    std::sort(m_edges.begin(), m_edges.end());
+    m_edges.erase(std::unique(m_edges.begin(), m_edges.end()), m_edges.end());
+    for (const auto& edge : m_edges) {
+        m_passes[edge.second].pending++;
+    }
+
+    // schedule: of the passes whose dependencies ran, the one declared first
+    std::vector<RenderGraphPass>& ready = m_released;
+    ready.clear();
+    for (size_t i = 0; i < m_passCount; i++) {
+        if (!m_passes[i].culled && m_passes[i].pending == 0) {
+            ready.push_back((RenderGraphPass)i);
+        }
+    }
+    std::make_heap(ready.begin(), ready.end(), std::greater<RenderGraphPass>());
+    while (!ready.empty()) {
+        std::pop_heap(ready.begin(), ready.end(), std::greater<RenderGraphPass>());
+        const RenderGraphPass next = ready.back();
+        ready.pop_back();
+
+        m_passes[next].order = (uint32_t)m_schedule.size();
+        m_schedule.push_back(next);
+        auto edge = std::lower_bound(m_edges.begin(), m_edges.end(), std::make_pair(next, (RenderGraphPass)0));
+        for (; edge != m_edges.end() && edge->first == next; ++edge) {
+            if (--m_passes[edge->second].pending == 0) {
+                ready.push_back(edge->second);
+                std::push_heap(ready.begin(), ready.end(), std::greater<RenderGraphPass>());
+            }
+        }
+    }
+    if (m_schedule.size() < kept) {
+        for (size_t i = 0; i < m_passCount; i++) {
+            if (!m_passes[i].culled && m_passes[i].order == kUnscheduled) {
+                gl_log_err("ERROR: render graph: pass %s is part of a dependency cycle\n", m_passes[i].name);
+                break;
+            }
+        }
+        m_schedule.clear();
+        return false;
+    }
+
+    // lifetimes of the transients, from their first kept pass to their last
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        const Resource& resource = m_resources[i];
+        if (resource.imported) {
+            continue;
+        }
+        uint32_t first = kUnscheduled, last = 0;
+        for (const std::vector<RenderGraphPass>* passes : { &resource.writers, &resource.readers }) {
+            for (RenderGraphPass pass : *passes) {
+                if (!m_passes[pass].culled) {
+                    first = std::min(first, m_passes[pass].order);
+                    last = std::max(last, m_passes[pass].order);
+                }
+            }
+        }
+        if (first != kUnscheduled) {
+            m_passes[m_schedule[first]].acquires.push_back((uint32_t)i);
+            m_passes[m_schedule[last]].releases.push_back((uint32_t)i);
+        }
+    }
+
+    // walk the schedule as the pools will serve it: a released target comes back for the
+    // same description, a released buffer for anything that fits. Memory a released
+    // transient wrote incoherently may come back under another name, so its barrier state
+    // goes along.
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        m_resources[i].dirty = false;
+        m_resources[i].issued = 0;
+    }
+    m_released.clear();
+    for (RenderGraphPass index : m_schedule) {
+        Pass& pass = m_passes[index];
+        for (uint32_t acquired : pass.acquires) {
+            Resource& resource = m_resources[acquired];
+            const bool buffer = resource.kind == Kind::Buffer;
+            const uint64_t bytes = buffer ? resource.size : RenderTargetPool::byteSize(resource.desc);
+            m_stats.transientTextures += !buffer;
+            m_stats.transientBuffers += buffer;
+            m_stats.transientBytes += bytes;
+
+            auto reused = std::find_if(m_released.begin(), m_released.end(), [&](uint32_t released) {
+                const Resource& other = m_resources[released];
+                return other.kind == resource.kind && (buffer ? other.size >= resource.size : other.desc == resource.desc);
+            });
+            if (reused != m_released.end()) {
+                resource.dirty = m_resources[*reused].dirty;
+                resource.issued = m_resources[*reused].issued;
+                m_released.erase(reused);
+            }
+            else {
+                m_stats.aliasedBytes += bytes;
+            }
+        }
+
+        GLbitfield bits = 0;
+        for (uint32_t a = pass.firstAccess; a < pass.firstAccess + pass.accessCount; a++) {
+            const Resource& resource = m_resources[m_accesses[a].resource];
+            if (resource.dirty) {
+                bits |= barrier_bits(m_accesses[a].access, resource.kind == Kind::Buffer) & ~resource.issued;
+            }
+        }
+        if (bits) {
+            // a barrier covers every write issued before it, not only the ones it was for
+            pass.barriers = bits;
+            m_stats.barriers++;
+            for (size_t i = 0; i < m_resourceCount; i++) {
+                m_resources[i].issued |= m_resources[i].dirty ? bits : 0;
+            }
+        }
+        for (uint32_t a = pass.firstAccess; a < pass.firstAccess + pass.accessCount; a++) {
+            if (m_accesses[a].write && incoherent(m_accesses[a].access)) {
+                m_resources[m_accesses[a].resource].dirty = true;
+                m_resources[m_accesses[a].resource].issued = 0;
+            }
+        }
+
+        for (uint32_t released : pass.releases) {
+            m_released.push_back(released);
+        }
+    }
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        const Resource& resource = m_resources[i];
+        if (resource.imported && resource.dirty) {
+            m_exitBarriers |= exit_barrier_bits(resource.kind == Kind::Buffer) & ~resource.issued;
+        }
+    }
+    m_stats.barriers += m_exitBarriers != 0;
+
+    m_compiled = true;
+    m_stats.compileMs = elapsed_ms(start);
+    return true;
+}
+
+bool RenderGraph::execute() {
+    if (!m_compiled && !compile()) {
+        return false;
+    }
+
+    PROFILE_SCOPE("render graph");
+    const Clock::time_point start = Clock::now();
+    _collectTiming();
+
+    // pooled buffers nobody wanted for a while
+    for (size_t i = 0; i < m_buffers.size();) {
+        if (!m_buffers[i].inUse && m_frame - m_buffers[i].lastFrame > RenderTargetPool::kMaxIdleFrames) {
+            gl_untrack_buffer(m_buffers[i].id);
+            GL_CALL(glDeleteBuffers(1, &m_buffers[i].id));
+            m_buffers[i] = m_buffers.back();
+            m_buffers.pop_back();
+        }
+        else {
+            i++;
+        }
+    }
+
+    const bool timed = m_timestamps.begin();
+    std::vector<const char*>& timedNames = m_timedNames[m_timestamps.slot()];
+    if (timed) {
+        timedNames.clear();
+        m_timestamps.mark();
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < m_schedule.size() && ok; i++) {
+        Pass& pass = m_passes[m_schedule[i]];
+        for (uint32_t acquired : pass.acquires) {
+            ok = ok && _realize(m_resources[acquired]);
+        }
+        if (!ok) {
+            gl_log_err("ERROR: render graph: could not create the transients of pass %s, the frame ends before it\n", pass.name);
+            break;
+        }
+
+        if (pass.barriers) {
+            glMemoryBarrier(pass.barriers);
+        }
+        const Clock::time_point passStart = Clock::now();
+        {
+            PROFILE_SCOPE(pass.name);
+            PROFILE_GPU_SCOPE(pass.name);
+            pass.execute(*this);
+        }
+        pass.cpuMs = elapsed_ms(passStart);
+        pass.gpuMs = _gpuMs(pass.name);
+        if (timed) {
+            m_timestamps.mark();
+            timedNames.push_back(pass.name);
+        }
+
+        for (uint32_t released : pass.releases) {
+            _retire(m_resources[released]);
+        }
+    }
+
+    if (!ok) {
+        for (size_t i = 0; i < m_resourceCount; i++) {
+            _retire(m_resources[i]);
+        }
+    }
+    else if (m_exitBarriers) {
+        glMemoryBarrier(m_exitBarriers);
+    }
+    m_timestamps.end();
+    m_frame++;
+    m_stats.executeMs = elapsed_ms(start);
+    return ok;
+}
+
+Framebuffer* RenderGraph::target(RenderGraphResource resource) const {
+    return resource.index < m_resourceCount ? m_resources[resource.index].target : nullptr;
+}
+
+GLuint RenderGraph::framebuffer(RenderGraphResource resource) const {
+    return resource.index < m_resourceCount ? m_resources[resource.index].framebuffer : 0;
+}
+
+GLuint RenderGraph::texture(RenderGraphResource resource) const {
+    return resource.index < m_resourceCount ? m_resources[resource.index].texture : 0;
+}
+
+GLuint RenderGraph::buffer(RenderGraphResource resource) const {
+    return resource.index < m_resourceCount ? m_resources[resource.index].buffer : 0;
+}
+
+int RenderGraph::width(RenderGraphResource resource) const {
+    return resource.index < m_resourceCount ? m_resources[resource.index].width : 0;
+}
+
+int RenderGraph::height(RenderGraphResource resource) const {
+    return resource.index < m_resourceCount ? m_resources[resource.index].height : 0;
+}
+
+void RenderGraph::bindTarget(RenderGraphResource resource) const {
+    if (resource.index >= m_resourceCount || m_resources[resource.index].kind != Kind::Texture) {
+        return;
+    }
+    const Resource& target = m_resources[resource.index];
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glViewport(0, 0, target.width, target.height);
+}
+
+RenderGraphPassInfo RenderGraph::pass(size_t index) const {
+    const Pass& pass = m_passes[index];
+    return { pass.name, pass.culled, pass.order, pass.barriers, pass.cpuMs, pass.gpuMs };
+}
+
+std::string RenderGraph::toDot() const {
+    std::string dot = "digraph \"render graph\" {\n    rankdir=LR;\n    node [fontname=\"Helvetica\", fontsize=10];\n"
+                      "    edge [fontname=\"Helvetica\", fontsize=9];\n";
+    char line[256];
+    for (size_t i = 0; i < m_passCount; i++) {
+        const Pass& pass = m_passes[i];
+        snprintf(line, sizeof(line), "    p%zu [shape=box, %slabel=\"", i, pass.culled ? "style=dashed, color=gray, fontcolor=gray, " : "style=filled, fillcolor=lightblue, ");
+        dot += line;
+        append_label(dot, pass.name);
+        if (pass.culled) {
+            dot += "\\nculled";
+        }
+        else {
+            snprintf(line, sizeof(line), "\\n#%u, %.3f ms CPU, %.3f ms GPU", pass.order, pass.cpuMs, pass.gpuMs);
+            dot += line;
+        }
+        if (pass.barriers) {
+            dot += "\\nbarrier: " + memory_barrier_names(pass.barriers);
+        }
+        dot += "\"];\n";
+    }
+
+    for (size_t i = 0; i < m_resourceCount; i++) {
+        const Resource& resource = m_resources[i];
+        snprintf(line, sizeof(line), "    r%zu [shape=%s, label=\"", i, resource.imported ? "doubleoctagon" : "ellipse");
+        dot += line;
+        append_label(dot, resource.name);
+        if (resource.kind == Kind::Buffer) {
+            snprintf(line, sizeof(line), "\\n%.1f KB buffer", resource.size / 1024.0);
+        }
+        else if (resource.imported) {
+            snprintf(line, sizeof(line), "\\n%dx%d", resource.width, resource.height);
+        }
+        else {
+            snprintf(line, sizeof(line), "\\n%dx%d %s%s%s", resource.width, resource.height,
+                     resource.desc.colorFormat ? gl_enum_name(resource.desc.colorFormat) : "",
+                     resource.desc.colorFormat && resource.desc.depthFormat ? " + " : "",
+                     resource.desc.depthFormat ? gl_enum_name(resource.desc.depthFormat) : "");
+        }
+        dot += line;
+        // transients that got the same object share memory
+        if (resource.imported) {
+            dot += "\\nimported";
+        }
+        else if (resource.lastObject) {
+            snprintf(line, sizeof(line), "\\n%s %u", resource.kind == Kind::Buffer ? "buffer" : "framebuffer", resource.lastObject);
+            dot += line;
+        }
+        dot += "\"];\n";
+    }
+
+    for (const Access& access : m_accesses) {
+        if (access.write) {
+            snprintf(line, sizeof(line), "    p%u -> r%u [label=\"%s\"%s];\n", access.pass, access.resource,
+                     resource_access_name(access.access), m_passes[access.pass].culled ? ", style=dashed, color=gray" : "");
+        }
+        else {
+            snprintf(line, sizeof(line), "    r%u -> p%u [label=\"%s\"%s];\n", access.resource, access.pass,
+                     resource_access_name(access.access), m_passes[access.pass].culled ? ", style=dashed, color=gray" : "");
+        }
+        dot += line;
+    }
+    dot += "}\n";
+    return dot;
+}
+
+bool RenderGraph::writeDot(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    const std::string dot = toDot();
+    fwrite(dot.data(), 1, dot.size(), file);
+    fclose(file);
+    return true;
+}
+
+RenderGraph::Resource& RenderGraph::_addResource(const char* name, Kind kind, bool imported) {
+    if (m_resourceCount == m_resources.size()) {
+        m_resources.emplace_back();
+    }
+    Resource& resource = m_resources[m_resourceCount++];
+    resource.name = name;
+    resource.kind = kind;
+    resource.imported = imported;
+    resource.desc = RenderTargetDesc{};
+    resource.size = 0;
+    resource.framebuffer = 0;
+    resource.texture = 0;
+    resource.buffer = 0;
+    resource.width = 0;
+    resource.height = 0;
+    resource.target = nullptr;
+    resource.lastObject = 0;
+    resource.writers.clear();
+    resource.readers.clear();
+    resource.dirty = false;
+    resource.issued = 0;
+    m_compiled = false;
+    return resource;
+}
+
+void RenderGraph::_access(RenderGraphPass pass, RenderGraphResource resource, ResourceAccess access, bool write) {
+    if (pass >= m_passCount || resource.index >= m_resourceCount) {
+        gl_log_err("ERROR: render graph: access to an unknown %s\n", pass >= m_passCount ? "pass" : "resource");
+        return;
+    }
+    const bool buffer = m_resources[resource.index].kind == Kind::Buffer;
+    const bool textureAccess = access == ResourceAccess::Attachment || access == ResourceAccess::Sampled ||
+                               access == ResourceAccess::Image || access == ResourceAccess::Transfer;
+    const bool bufferAccess = access != ResourceAccess::Attachment && access != ResourceAccess::Sampled;
+    if (buffer ? !bufferAccess : !textureAccess) {
+        gl_log_err("ERROR: render graph: pass %s cannot use %s as %s\n", m_passes[pass].name, m_resources[resource.index].name,
+                   resource_access_name(access));
+        return;
+    }
+
+    m_accesses.push_back({ pass, resource.index, access, write });
+    m_compiled = false;
+}
+
+bool RenderGraph::_realize(Resource& resource) {
+    if (resource.imported) {
+        return true;
+    }
+
+    if (resource.kind == Kind::Texture) {
+        resource.target = m_pool.acquire(resource.desc);
+        if (!resource.target) {
+            return false;
+        }
+        resource.framebuffer = resource.target->id();
+        resource.texture = resource.target->colorCount() ? resource.target->colorTexture() : resource.target->depthTexture();
+        resource.lastObject = resource.framebuffer;
+        return true;
+    }
+
+    // the smallest free buffer that fits
+    PooledBuffer* best = nullptr;
+    for (PooledBuffer& buffer : m_buffers) {
+        if (!buffer.inUse && buffer.size >= resource.size && (!best || buffer.size < best->size)) {
+            best = &buffer;
+        }
+    }
+    if (!best) {
+        PooledBuffer buffer = { 0, resource.size, false, m_frame };
+        GL_CALL(glGenBuffers(1, &buffer.id));
+        GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id));
+        GL_CALL(glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)buffer.size, nullptr, GL_DYNAMIC_COPY));
+        GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+        gl_track_buffer(buffer.id, GL_SHADER_STORAGE_BUFFER, buffer.size);
+        m_buffers.push_back(buffer);
+        best = &m_buffers.back();
+    }
+    best->inUse = true;
+    best->lastFrame = m_frame;
+    resource.buffer = best->id;
+    resource.lastObject = best->id;
+    return true;
+}
+
+void RenderGraph::_retire(Resource& resource) {
+    if (resource.imported) {
+        return;
+    }
+
+    if (resource.target) {
+        m_pool.release(resource.target);
+        resource.target = nullptr;
+    }
+    if (resource.buffer) {
+        for (PooledBuffer& buffer : m_buffers) {
+            if (buffer.id == resource.buffer) {
+                buffer.inUse = false;
+            }
+        }
+    }
+    resource.framebuffer = 0;
+    resource.texture = 0;
+    resource.buffer = 0;
+}
+
+void RenderGraph::_collectTiming() {
+    m_timestamps.collect([this](size_t slot, const GLuint64* times, size_t count) {
+        // the first timestamp is the start of the frame, one per pass after it
+        const std::vector<const char*>& names = m_timedNames[slot];
+        m_gpuTimes.clear();
+        for (size_t i = 0; i + 1 < count; i++) {
+            m_gpuTimes.push_back({ names[i], (double)(times[i + 1] - times[i]) * 1e-6 });
+        }
+    });
+}
+
+double RenderGraph::_gpuMs(const char* name) const {
+    for (const auto& time : m_gpuTimes) {
+        if (time.first == name || !strcmp(time.first, name)) {
+            return time.second;
+        }
+    }
+    return 0.0;
+}
@@ -0,0 +1,254 @@
+#ifndef _RENDER_GRAPH_H_
+#define _RENDER_GRAPH_H_
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../opengl/Framebuffer.h"
+#include "../opengl/RenderTargetPool.h"
+#include "../opengl/TimestampRing.h"
+
+/// How a pass touches a resource
+enum class ResourceAccess : uint8_t {
+    Attachment,     // rendered into, cleared or blitted as a framebuffer
+    Sampled,        // texture fetches
+    Image,          // imageLoad / imageStore
+    Storage,        // shader storage buffer
+    Uniform,        // uniform buffer
+    Indirect,       // draw or dispatch indirect arguments
+    Vertex,         // vertex or index data
+    Transfer        // copies, uploads and read backs
+};
+
+const char* resource_access_name(ResourceAccess access);
+
+/// "storage | command" for the bits of a glMemoryBarrier, for dumps and GUIs
+std::string memory_barrier_names(GLbitfield barriers);
+
+struct RenderGraphResource {
+    static constexpr uint32_t kInvalid = UINT32_MAX;
+
+    uint32_t index = kInvalid;
+
+    bool valid() const { return index != kInvalid; }
+};
+
+using RenderGraphPass = uint32_t;
+
+/// A declared pass after compile and execute
+struct RenderGraphPassInfo {
+    const char* name;
+    bool culled;            // nothing kept reads what it writes
+    uint32_t order;         // in the schedule, UINT32_MAX if culled
+    GLbitfield barriers;    // glMemoryBarrier issued before it
+    double cpuMs;           // of its execute callback, this frame
+    double gpuMs;           // of the most recent frame that resolved, 0 until then
+};
+
+struct RenderGraphStats {
+    uint32_t passes = 0;            // declared
+    uint32_t culled = 0;
+    uint32_t barriers = 0;          // glMemoryBarrier calls, the one after the last pass included
+    uint32_t transientTextures = 0;
+    uint32_t transientBuffers = 0;
+    uint64_t transientBytes = 0;    // of the transients used, each on its own
+    uint64_t aliasedBytes = 0;      // once transients whose lifetimes don't overlap share memory
+    double compileMs = 0.0;
+    double executeMs = 0.0;         // CPU
+};
+
+/**
+ * @brief Frame graph: passes declare the resources they read and write, the graph orders, culls and runs them
+ *
+ * A frame resets the graph, declares its resources and passes, and executes it. Resources
+ * are transient (targets from the RenderTargetPool, buffers from the graph's own pool) or
+ * imported (the window, a shadow atlas, a buffer owned elsewhere).
+ *
+ * A resource has one content per frame: its writers run in declaration order, then its
+ * readers. A pass both reading and writing a resource sees the writes of the writers
+ * declared before it. Passes may be declared in any order as long as this has no cycle.
+ *
+ * compile:
+ *   culling    a pass is kept if it writes an imported resource, is marked as having a
+ *              side effect, or writes what a kept pass reads; the others don't run
+ *   schedule   kept passes in dependency order, declaration order where free
+ *   lifetimes  a transient is acquired right before its first pass and released after
+ *              its last one, so passes that don't overlap get the same memory back
+ *   barriers   Image and Storage writes are incoherent: the first pass touching the
+ *              resource afterwards gets the glMemoryBarrier bits of how it does so, bits
+ *              an earlier barrier already covered are not issued again
+ *
+ * Pass and resource names must outlive the graph, string literals in practice: the
+ * profiler keeps them and steady frames should not allocate for them.
+ */
+class RenderGraph {
+public:
+    /// Transient textures come from `pool`; calling its beginFrame stays up to the owner
+    explicit RenderGraph(RenderTargetPool& pool);
+
+    RenderGraph(const RenderGraph& other) = delete;
+
+    RenderGraph& operator=(const RenderGraph& other) = delete;
+
+    ~RenderGraph();
+
+    /// Drops the passes and resources of the frame before, the pools and timings stay
+    void reset();
+
+    RenderGraphResource createTexture(const char* name, const RenderTargetDesc& desc);
+
+    RenderGraphResource createBuffer(const char* name, size_t size);
+
+    /// A framebuffer owned elsewhere, 0 for the window; `texture` if passes sample it
+    RenderGraphResource importTarget(const char* name, GLuint framebuffer, int width, int height, GLuint texture = 0);
+
+    RenderGraphResource importTarget(const char* name, const Framebuffer& framebuffer);
+
+    RenderGraphResource importBuffer(const char* name, GLuint buffer, size_t size);
+
+    RenderGraphPass addPass(const char* name, std::function<void(const RenderGraph&)> execute);
+
+    void read(RenderGraphPass pass, RenderGraphResource resource, ResourceAccess access);
+
+    void write(RenderGraphPass pass, RenderGraphResource resource, ResourceAccess access);
+
+    /// Kept even when nothing reads what it writes: read backs, queries, debug output
+    void setSideEffect(RenderGraphPass pass);
+
+    /**
+     * @brief Culls, schedules and places lifetimes and barriers
+     *
+     * @return false if a pass reads a transient nobody writes or the dependencies have a cycle
+     */
+    bool compile();
+
+    /// Compiles if needed, then runs the kept passes
+    bool execute();
+
+    // while a pass executes
+
+    /// Of a transient texture, null outside its lifetime
+    Framebuffer* target(RenderGraphResource resource) const;
+
+    GLuint framebuffer(RenderGraphResource resource) const;
+
+    GLuint texture(RenderGraphResource resource) const;
+
+    GLuint buffer(RenderGraphResource resource) const;
+
+    int width(RenderGraphResource resource) const;
+
+    int height(RenderGraphResource resource) const;
+
+    /// Binds the framebuffer of `resource` with a viewport covering it
+    void bindTarget(RenderGraphResource resource) const;
+
+    RenderTargetPool& pool() const { return m_pool; }
+
+    // after execute
+
+    size_t passCount() const { return m_passCount; }
+
+    RenderGraphPassInfo pass(size_t index) const;
+
+    const RenderGraphStats& stats() const { return m_stats; }
+
+    /// Graphviz: passes are boxes, culled ones dashed, resources ellipses with the GL object they got
+    std::string toDot() const;
+
+    bool writeDot(const std::string& path) const;
+
+private:
+    enum class Kind : uint8_t {
+        Texture,
+        Buffer
+    };
+
+    struct Resource {
+        const char* name;
+        Kind kind;
+        bool imported;
+        RenderTargetDesc desc;          // transient textures
+        size_t size;                    // buffers
+        GLuint framebuffer;             // imported or realized
+        GLuint texture;
+        GLuint buffer;
+        int width;
+        int height;
+        Framebuffer* target;            // realized transient texture
+        GLuint lastObject;              // framebuffer or buffer it last got, for the dump
+        std::vector<RenderGraphPass> writers;
+        std::vector<RenderGraphPass> readers;
+        bool dirty;                     // incoherent write no barrier covered fully yet
+        GLbitfield issued;              // bits issued since
+    };
+
+    struct Access {
+        RenderGraphPass pass;
+        uint32_t resource;
+        ResourceAccess access;
+        bool write;
+    };
+
+    struct Pass {
+        const char* name;
+        std::function<void(const RenderGraph&)> execute;
+        bool sideEffect;
+        bool culled;
+        uint32_t order;
+        uint32_t firstAccess;
+        uint32_t accessCount;
+        uint32_t pending;               // unscheduled dependencies, while compiling
+        GLbitfield barriers;
+        std::vector<uint32_t> acquires;
+        std::vector<uint32_t> releases;
+        double cpuMs;
+        double gpuMs;
+    };
+
+    struct PooledBuffer {
+        GLuint id;
+        size_t size;
+        bool inUse;
+        uint64_t lastFrame;
+    };
+
+    RenderTargetPool& m_pool;
+    std::vector<Resource> m_resources;      // slots are reused from frame to frame,
+    size_t m_resourceCount;                 // so steady frames don't allocate
+    std::vector<Pass> m_passes;
+    size_t m_passCount;
+    std::vector<Access> m_accesses;
+    std::vector<std::pair<RenderGraphPass, RenderGraphPass>> m_edges;
+    std::vector<RenderGraphPass> m_schedule;
+    std::vector<uint32_t> m_released;       // while compiling: passes ready to run, then transients whose lifetime ended
+    GLbitfield m_exitBarriers;
+    bool m_compiled;
+    RenderGraphStats m_stats;
+
+    std::vector<PooledBuffer> m_buffers;
+
+    TimestampRing m_timestamps;
+    std::vector<std::vector<const char*>> m_timedNames;         // of each slot of the ring
+    std::vector<std::pair<const char*, double>> m_gpuTimes;     // of the last frame that resolved
+    uint64_t m_frame;
+
+    Resource& _addResource(const char* name, Kind kind, bool imported);
+
+    void _access(RenderGraphPass pass, RenderGraphResource resource, ResourceAccess access, bool write);
+
+    bool _realize(Resource& resource);
+
+    void _retire(Resource& resource);
+
+    void _collectTiming();
+
+    double _gpuMs(const char* name) const;
+};
+
+#endif // !_RENDER_GRAPH_H_
@@ -0,0 +1,535 @@
+#include "Shadows.h"
+
+#include "../core/Profiler.h"
+#include "../opengl/GpuProfiler.h"
+#include "../opengl/log.h"
+#include "../opengl/utils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool linked(const Shader& shader) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(shader.id(), GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+// local lights see from a little in front of their center, so casters touching it still count
+const float kLocalNear = 0.05f;
+
+// slope scaled and constant offsets of the depth written into the atlas
+const float kSlopeBias = 2.0f;
+const float kConstantBias = 4.0f;
+
+// normal offset of the lookups, in texels at the receiver
+const float kNormalOffsetTexels = 1.5f;
+
+glm::vec3 up_for(const glm::vec3& direction) {
+    return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+uint32_t floor_pow2(float value) {
+    uint32_t result = 1;
+    while ((float)(result * 2) <= value) {
+        result *= 2;
+    }
+    return result;
+}
+
+uint64_t tile_key(const ShadowRect& rect) {
+    return (uint64_t)rect.x | ((uint64_t)rect.y << 20) | ((uint64_t)rect.size << 40);
+}
+
+bool overlap(const ShadowRect& a, const ShadowRect& b) {
+    return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+}
+
+}
+
+ShadowCameraView shadow_camera_view(const Camera& camera, float aspect, float nearPlane, float farPlane) {
+    ShadowCameraView view;
+    view.view = glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up);
+    view.position = camera.Position;
+    view.fovY = glm::radians(camera.Zoom);
+    view.aspect = aspect;
+    view.nearPlane = nearPlane;
+    view.farPlane = farPlane;
+    return view;
+}
+
+void cascade_splits(float nearPlane, float farPlane, uint32_t count, float lambda, float* splits) {
+    splits[0] = nearPlane;
+    for (uint32_t i = 1; i < count; i++) {
+        const float p = (float)i / (float)count;
+        const float logarithmic = nearPlane * std::pow(farPlane / nearPlane, p);
+        const float uniform = nearPlane + (farPlane - nearPlane) * p;
+        splits[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+    }
+    splits[count] = farPlane;
+}
+
+Cascade fit_cascade(const ShadowCameraView& camera, float splitNear, float splitFar, const glm::vec3& lightDirection,
+                    uint32_t resolution, float casterReach)
+{
+    Cascade cascade;
+    cascade.splitNear = splitNear;
+    cascade.splitFar = splitFar;
+
+    // the sphere is found in view space, where turning the camera changes nothing
+    const float tanY = std::tan(camera.fovY * 0.5f);
+    const float tanX = tanY * camera.aspect;
+    const glm::vec3 corners[2] = {
+        glm::vec3(splitNear * tanX, splitNear * tanY, -splitNear),
+        glm::vec3(splitFar * tanX, splitFar * tanY, -splitFar)
+    };
+    const glm::vec3 center(0.0f, 0.0f, -(splitNear + splitFar) * 0.5f);
+    float radius = std::max(glm::length(corners[0] - center), glm::length(corners[1] - center));
+    // in 1/16 units, so float noise in the corners can't change the size of the box
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    // the grid the origin snaps to is an eighth of the box, which grows by a cell to keep the sphere inside
+    const float halfExtent = radius * 8.0f / 7.0f;
+    const float cell = halfExtent / 8.0f;
+    cascade.texelSize = 2.0f * halfExtent / (float)resolution;
+
+    const glm::vec3 direction = glm::normalize(lightDirection);
+    const glm::mat4 rotation = glm::lookAt(glm::vec3(0.0f), direction, up_for(direction));
+    const glm::vec3 worldCenter = glm::vec3(glm::inverse(camera.view) * glm::vec4(center, 1.0f));
+    const glm::vec3 lightCenter = glm::vec3(rotation * glm::vec4(worldCenter, 1.0f));
+    const glm::vec3 snapped = glm::floor(lightCenter / cell + 0.5f) * cell;
+
+    cascade.center = worldCenter;
+    cascade.radius = radius;
+    cascade.view = glm::translate(glm::mat4(1.0f), -snapped) * rotation;
+    // light space looks down -z, the light is behind +z
+    cascade.projection = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, -(halfExtent + casterReach), halfExtent);
+    cascade.viewProjection = cascade.projection * cascade.view;
+    return cascade;
+}
+
+void ShadowAtlas::reset(uint32_t size) {
+    m_size = size;
+    m_nextY = 0;
+    m_used = 0;
+    m_shelves.clear();
+}
+
+bool ShadowAtlas::allocate(uint32_t tileSize, ShadowRect& rect) {
+    if (tileSize == 0 || tileSize > m_size) {
+        return false;
+    }
+
+    for (Shelf& shelf : m_shelves) {
+        if (shelf.height == tileSize && shelf.cursor + tileSize <= m_size) {
+            rect = { shelf.cursor, shelf.y, tileSize };
+            shelf.cursor += tileSize;
+            m_used += (uint64_t)tileSize * tileSize;
+            return true;
+        }
+    }
+
+    if (m_nextY + tileSize > m_size) {
+        return false;
+    }
+    m_shelves.push_back({ m_nextY, tileSize, tileSize });
+    rect = { 0, m_nextY, tileSize };
+    m_nextY += tileSize;
+    m_used += (uint64_t)tileSize * tileSize;
+    return true;
+}
+
+void point_light_views(const glm::vec3& position, float radius, glm::mat4 viewProjections[6]) {
+    static const glm::vec3 directions[6] = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    static const glm::vec3 ups[6] = {
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+    };
+
+    // a little wider than 90 degrees, so the filter taps at a face's edge have depth to read
+    const glm::mat4 projection = glm::perspective(2.0f * std::atan(1.05f), 1.0f, kLocalNear, std::max(radius, kLocalNear * 2.0f));
+    for (int face = 0; face < 6; face++) {
+        viewProjections[face] = projection * glm::lookAt(position, position + directions[face], ups[face]);
+    }
+}
+
+glm::mat4 spot_light_view(const Light& light) {
+    const glm::vec3 position(light.positionRadius);
+    const glm::vec3 direction(light.spot);
+    const float fov = std::min(2.0f * std::acos(light.spot.w) + 0.1f, 3.0f);
+    return glm::perspective(fov, 1.0f, kLocalNear, std::max(light.positionRadius.w, kLocalNear * 2.0f))
+        * glm::lookAt(position, position + direction, up_for(direction));
+}
+
+ShadowRenderer::ShadowRenderer()
+    : m_initialized(false),
+      m_settings(),
+      m_depth(),
+      m_atlas(),
+      m_staticAtlas(),
+      m_viewBuffer(0),
+      m_viewCapacity(0),
+      m_packer(),
+      m_cascades(),
+      m_cascadeCount(0),
+      m_views(),
+      m_gpuViews(),
+      m_cache(),
+      m_staticVersion(0),
+      m_timestamps(),
+      m_stats{}
+{}
+
+ShadowRenderer::~ShadowRenderer() {
+    if (!m_initialized) {
+        return;
+    }
+    if (m_viewBuffer) {
+        gl_untrack_buffer(m_viewBuffer);
+        GL_CALL(glDeleteBuffers(1, &m_viewBuffer));
+    }
+}
+
+bool ShadowRenderer::init(const ShadowSettings& settings, const std::string& shaderDirectory) {
+    if (m_initialized) {
+        return true;
+    }
+
+    m_settings = settings;
+    m_settings.cascadeCount = std::min(m_settings.cascadeCount, (uint32_t)ShadowStats::kMaxCascades);
+    if (m_settings.cascadeCount * m_settings.cascadeResolution > m_settings.atlasSize) {
+        gl_log_err("ERROR: %u shadow cascades of %u texels don't fit a %u atlas\n", m_settings.cascadeCount,
+                   m_settings.cascadeResolution, m_settings.atlasSize);
+        return false;
+    }
+
+    m_depth = std::make_unique<Shader>(shaderDirectory + "/depth.vert", shaderDirectory + "/depth.frag");
+    if (!linked(*m_depth)) {
+        gl_log_err("ERROR: could not build the shadow shaders in %s\n", shaderDirectory.c_str());
+        return false;
+    }
+    if (!_createAtlases()) {
+        return false;
+    }
+
+    GL_CALL(glGenBuffers(1, &m_viewBuffer));
+    m_packer.reset(m_settings.atlasSize);
+    m_initialized = true;
+    return true;
+}
+
+bool ShadowRenderer::_createAtlases() {
+    FramebufferConfig config{};
+    config.width = (int)m_settings.atlasSize;
+    config.height = (int)m_settings.atlasSize;
+    config.depth = true;
+    config.depthFormat = GL_DEPTH_COMPONENT32F;
+    if (!m_atlas.create(config) || !m_staticAtlas.create(config)) {
+        gl_log_err("ERROR: could not create the %u shadow atlas\n", m_settings.atlasSize);
+        return false;
+    }
+
+    // read through sampler2DShadow: compared, and bilinear filtered by the hardware
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, m_atlas.depthTexture()));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    m_cache.clear();
+    return true;
+}
+
+void ShadowRenderer::update(const ShadowCameraView& camera, const glm::vec3& sunDirection, std::vector<Light>& lights) {
+    if (!m_initialized) {
+        return;
+    }
+
+    PROFILE_SCOPE("shadow planning");
+    const Clock::time_point start = Clock::now();
+
+    const double gpuMs = m_stats.gpuMs;
+    m_stats = ShadowStats{};
+    m_stats.gpuMs = gpuMs;
+    m_views.clear();
+    m_gpuViews.clear();
+    m_packer.reset(m_settings.atlasSize);
+
+    m_cascadeCount = 0;
+    if (glm::dot(sunDirection, sunDirection) > 0.0f) {
+        float splits[ShadowStats::kMaxCascades + 1];
+        const uint32_t count = m_settings.cascadeCount;
+        cascade_splits(camera.nearPlane, std::min(m_settings.shadowDistance, camera.farPlane), count, m_settings.splitLambda, splits);
+        for (uint32_t i = 0; i < count; i++) {
+            ShadowRect rect;
+            m_packer.allocate(m_settings.cascadeResolution, rect);
+            const Cascade cascade = fit_cascade(camera, splits[i], splits[i + 1], sunDirection, m_settings.cascadeResolution,
+                                                m_settings.casterReach);
+            m_cascades[m_cascadeCount++] = cascade;
+            // half a texel of depth, the slope part is the polygon offset
+            const float depthRange = cascade.texelSize * m_settings.cascadeResolution + m_settings.casterReach;
+            _addView(cascade.viewProjection, rect, (int)i, 0.5f * cascade.texelSize / depthRange,
+                     kNormalOffsetTexels * cascade.texelSize, false);
+        }
+    }
+
+    // local lights: the closer to the camera, the bigger the tile; tiles are handed out largest first
+    struct Request {
+        size_t light;
+        uint32_t tileSize;
+        float distance;
+    };
+    std::vector<Request> requests;
+    for (size_t i = 0; i < lights.size(); i++) {
+        Light& light = lights[i];
+        light.shadow.x = -1.0f;
+        if (!light.castsShadows()) {
+            continue;
+        }
+
+        const float radius = light.positionRadius.w;
+        const float distance = glm::length(glm::vec3(light.positionRadius) - camera.position);
+        uint32_t size = floor_pow2((float)m_settings.maxLocalResolution * radius / std::max(distance, radius));
+        size = std::min(std::max(size, m_settings.minLocalResolution), m_settings.maxLocalResolution);
+        requests.push_back({ i, light.isSpot() ? size : std::max(size / 2, 1u), distance });
+    }
+    std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+        return a.tileSize != b.tileSize ? a.tileSize > b.tileSize : a.distance < b.distance;
+    });
+
+    for (const Request& request : requests) {
+        Light& light = lights[request.light];
+        const uint32_t faces = light.isSpot() ? 1 : 6;
+        const uint32_t minTile = light.isSpot() ? m_settings.minLocalResolution : std::max(m_settings.minLocalResolution / 2, 1u);
+
+        // a point light gets all its faces or none, what a failed attempt took is given back
+        ShadowRect rects[6];
+        bool placed = false;
+        for (uint32_t tile = request.tileSize; tile >= minTile && !placed; tile /= 2) {
+            const ShadowAtlas saved = m_packer;
+            placed = true;
+            for (uint32_t face = 0; face < faces && placed; face++) {
+                placed = m_packer.allocate(tile, rects[face]);
+            }
+            if (!placed) {
+                m_packer = saved;
+            }
+        }
+        if (!placed) {
+            m_stats.lightsDropped++;
+            continue;
+        }
+
+        light.shadow.x = (float)m_views.size();
+        m_stats.lightsShadowed++;
+        const float texelAngle = 2.0f * 1.05f / (float)rects[0].size;
+        if (light.isSpot()) {
+            const float tanHalf = std::tan(std::min(2.0f * std::acos(light.spot.w) + 0.1f, 3.0f) * 0.5f);
+            _addView(spot_light_view(light), rects[0], -1, 2e-4f, kNormalOffsetTexels * 2.0f * tanHalf / (float)rects[0].size, true);
+        }
+        else {
+            glm::mat4 viewProjections[6];
+            point_light_views(glm::vec3(light.positionRadius), light.positionRadius.w, viewProjections);
+            for (int face = 0; face < 6; face++) {
+                _addView(viewProjections[face], rects[face], -1, 2e-4f, kNormalOffsetTexels * texelAngle, true);
+            }
+        }
+    }
+
+    // upload, never empty: binding a zero sized buffer is an error
+    if (m_gpuViews.empty()) {
+        m_gpuViews.push_back(GpuView{});
+    }
+    const size_t bytes = m_gpuViews.size() * sizeof(GpuView);
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_viewBuffer));
+    if (bytes > m_viewCapacity) {
+        m_viewCapacity = std::max(bytes, m_viewCapacity * 2);
+        GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER, m_viewCapacity, nullptr, GL_DYNAMIC_DRAW));
+        gl_track_buffer(m_viewBuffer, GL_SHADER_STORAGE_BUFFER, m_viewCapacity);
+    }
+    GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, m_gpuViews.data()));
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    m_stats.views = (uint32_t)m_views.size();
+    m_stats.atlasUsage = (float)((double)m_packer.usedTexels() / ((double)m_settings.atlasSize * m_settings.atlasSize));
+    m_stats.cpuMs = elapsed_ms(start);
+}
+
+void ShadowRenderer::_addView(const glm::mat4& viewProjection, const ShadowRect& rect, int cascade, float depthBias,
+                              float normalOffset, bool perspective)
+{
+    View view;
+    view.viewProjection = viewProjection;
+    view.rect = rect;
+    view.frustum = Frustum(viewProjection);
+    view.cascade = cascade;
+    m_views.push_back(view);
+
+    const float scale = (float)rect.size / (float)m_settings.atlasSize;
+    GpuView gpu;
+    gpu.viewProjection = viewProjection;
+    gpu.rect = glm::vec4((float)rect.x / (float)m_settings.atlasSize, (float)rect.y / (float)m_settings.atlasSize, scale, (float)rect.size);
+    gpu.params = glm::vec4(depthBias, normalOffset, perspective ? 1.0f : 0.0f, 0.0f);
+    m_gpuViews.push_back(gpu);
+}
+
+void ShadowRenderer::render(const std::vector<ShadowCaster>& casters, const std::function<void(const Shader&, size_t)>& drawCaster) {
+    if (!m_initialized) {
+        return;
+    }
+
+    PROFILE_SCOPE("shadows");
+    PROFILE_GPU_SCOPE("shadows");
+    const Clock::time_point start = Clock::now();
+
+    _collectTiming();
+    m_timestamps.begin();
+    m_timestamps.mark();
+
+    GLint framebuffer = 0;
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    const GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    const GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    const GLboolean polygonOffset = glIsEnabled(GL_POLYGON_OFFSET_FILL);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+
+    // the scene's meshes are not consistently wound, both faces cast
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+    glEnable(GL_SCISSOR_TEST);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(kSlopeBias, kConstantBias);
+    m_depth->use();
+
+    const bool cache = m_settings.cacheStatic;
+    if (cache) {
+        // static casters of the views that moved go to the static atlas, then every view's tile is copied over
+        m_staticAtlas.bind();
+        for (const View& view : m_views) {
+            if (_cached(view)) {
+                m_stats.viewsCached++;
+                continue;
+            }
+
+            glViewport(view.rect.x, view.rect.y, view.rect.size, view.rect.size);
+            glScissor(view.rect.x, view.rect.y, view.rect.size, view.rect.size);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            _drawCasters(view, casters, true, drawCaster);
+            m_stats.viewsRendered++;
+        }
+        for (const View& view : m_views) {
+            glCopyImageSubData(m_staticAtlas.depthTexture(), GL_TEXTURE_2D, 0, view.rect.x, view.rect.y, 0,
+                               m_atlas.depthTexture(), GL_TEXTURE_2D, 0, view.rect.x, view.rect.y, 0,
+                               view.rect.size, view.rect.size, 1);
+        }
+    }
+
+    m_atlas.bind();
+    for (const View& view : m_views) {
+        glViewport(view.rect.x, view.rect.y, view.rect.size, view.rect.size);
+        glScissor(view.rect.x, view.rect.y, view.rect.size, view.rect.size);
+        if (!cache) {
+            glClear(GL_DEPTH_BUFFER_BIT);
+            _drawCasters(view, casters, true, drawCaster);
+            m_stats.viewsRendered++;
+        }
+        _drawCasters(view, casters, false, drawCaster);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    cullFace ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+    scissorTest ? glEnable(GL_SCISSOR_TEST) : glDisable(GL_SCISSOR_TEST);
+    polygonOffset ? glEnable(GL_POLYGON_OFFSET_FILL) : glDisable(GL_POLYGON_OFFSET_FILL);
+    blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+
+    m_timestamps.mark();
+    m_timestamps.end();
+    m_stats.cpuMs += elapsed_ms(start);
+}
+
+bool ShadowRenderer::_cached(const View& view) {
+    const uint64_t key = tile_key(view.rect);
+    auto it = m_cache.find(key);
+    if (it != m_cache.end() && it->second.staticVersion == m_staticVersion && it->second.viewProjection == view.viewProjection) {
+        return true;
+    }
+
+    // drawn again now: tiles of earlier layouts it overlaps no longer hold what they did
+    for (it = m_cache.begin(); it != m_cache.end();) {
+        if (overlap(it->second.rect, view.rect)) {
+            it = m_cache.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    m_cache[key] = { view.viewProjection, view.rect, m_staticVersion };
+    return false;
+}
+
+void ShadowRenderer::_drawCasters(const View& view, const std::vector<ShadowCaster>& casters, bool isStatic,
+                                  const std::function<void(const Shader&, size_t)>& drawCaster)
+{
+    m_depth->setUniform("viewProjection", view.viewProjection);
+    for (size_t i = 0; i < casters.size(); i++) {
+        const ShadowCaster& caster = casters[i];
+        if (caster.isStatic != isStatic) {
+            continue;
+        }
+        if (!view.frustum.intersectsBox(caster.boundsMin, caster.boundsMax)) {
+            m_stats.castersCulled++;
+            continue;
+        }
+
+        drawCaster(*m_depth, i);
+        m_stats.castersDrawn++;
+        if (view.cascade >= 0) {
+            m_stats.cascadeCasters[view.cascade]++;
+        }
+    }
+}
+
+void ShadowRenderer::_collectTiming() {
+    m_timestamps.collect([this](size_t, const GLuint64* times, size_t count) {
+        m_stats.gpuMs = (double)(times[count - 1] - times[0]) * 1e-6;
+    });
+}
+
+void ShadowRenderer::apply(const Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + kAtlasUnit);
+    glBindTexture(GL_TEXTURE_2D, m_atlas.depthTexture());
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kViewBinding, m_viewBuffer);
+    shader.setUniform("shadowsEnabled", m_initialized && !m_views.empty());
+    shader.setUniform("cascadeCount", (int)m_cascadeCount);
+}
+
+uint64_t ShadowRenderer::byteSize() const {
+    if (!m_initialized) {
+        return 0;
+    }
+    return (uint64_t)m_atlas.byteSize() + m_staticAtlas.byteSize() + m_viewCapacity;
+}
@@ -0,0 +1,285 @@
+#ifndef _SHADOWS_H_
+#define _SHADOWS_H_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/Camera.hpp"
+#include "../core/Shader.h"
+#include "../math/Frustum.h"
+#include "../opengl/Framebuffer.h"
+#include "../opengl/TimestampRing.h"
+#include "Light.h"
+
+/// The part of a camera cascades are fitted to
+struct ShadowCameraView {
+    glm::mat4 view;
+    glm::vec3 position;
+    float fovY;             // radians
+    float aspect;
+    float nearPlane;
+    float farPlane;
+};
+
+ShadowCameraView shadow_camera_view(const Camera& camera, float aspect, float nearPlane, float farPlane);
+
+/**
+ * @brief Split depths of `count` cascades between `nearPlane` and `farPlane`, `count + 1` values
+ *
+ * The practical split scheme: `lambda` 1 is logarithmic (even texel density per depth),
+ * 0 uniform.
+ */
+void cascade_splits(float nearPlane, float farPlane, uint32_t count, float lambda, float* splits);
+
+struct Cascade {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec3 center;       // of the slice's bounding sphere
+    float radius;
+    float splitNear;
+    float splitFar;
+    float texelSize;        // world units per shadow map texel
+};
+
+/**
+ * @brief Orthographic light view of one depth slice of the camera, fitted to stay stable
+ *
+ * The box holds the bounding sphere of the slice, whose size does not change as the camera
+ * turns, and its origin is snapped in light space to a grid of an eighth of the box (a
+ * whole number of texels; the box is padded so the sphere stays inside). Moving the camera
+ * shifts the shadow map by whole texels, so edges don't shimmer, and as long as the sphere
+ * stays in its grid cell the matrix is the same bit for bit, which ShadowRenderer's static
+ * cache relies on. Casters up to `casterReach` towards the light from the box are kept.
+ *
+ * @param lightDirection the direction the light travels
+ */
+Cascade fit_cascade(const ShadowCameraView& camera, float splitNear, float splitFar, const glm::vec3& lightDirection,
+                    uint32_t resolution, float casterReach);
+
+/// Pixel rectangle of one shadow view in the atlas
+struct ShadowRect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t size;
+};
+
+/**
+ * @brief Shelf packing of square power of two tiles into a square atlas
+ *
+ * Tiles go into a shelf of their own height, left to right; a new shelf opens under the
+ * last one. Handing out tiles largest first leaves no gaps.
+ */
+class ShadowAtlas {
+public:
+    explicit ShadowAtlas(uint32_t size = 0) { reset(size); }
+
+    void reset(uint32_t size);
+
+    bool allocate(uint32_t tileSize, ShadowRect& rect);
+
+    uint32_t size() const { return m_size; }
+
+    /// Texels handed out since reset
+    uint64_t usedTexels() const { return m_used; }
+
+private:
+    struct Shelf {
+        uint32_t y;
+        uint32_t height;
+        uint32_t cursor;
+    };
+
+    uint32_t m_size;
+    uint32_t m_nextY;
+    uint64_t m_used;
+    std::vector<Shelf> m_shelves;
+};
+
+/// The six 90 degree views of a point light, in GL cube map face order (+x, -x, +y, -y, +z, -z)
+void point_light_views(const glm::vec3& position, float radius, glm::mat4 viewProjections[6]);
+
+/// The perspective view of a spot light's cone
+glm::mat4 spot_light_view(const Light& light);
+
+/**
+ * @brief One object that casts shadows: its world bounds, for the per view culling
+ *
+ * Static casters are drawn into the static cache and only redrawn when their view moves
+ * or ShadowRenderer::invalidateStatic is called.
+ */
+struct ShadowCaster {
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    bool isStatic;
+};
+
+struct ShadowSettings {
+    uint32_t atlasSize = 4096;
+    uint32_t cascadeCount = 4;          // at most kMaxCascades
+    uint32_t cascadeResolution = 1024;  // cascades take the atlas' first row
+    float shadowDistance = 60.0f;       // cascades end here, or at the camera's far plane
+    float splitLambda = 0.75f;
+    float casterReach = 60.0f;          // how far towards the sun casters outside a cascade still count
+    uint32_t maxLocalResolution = 512;  // spot lights, point light faces get half
+    uint32_t minLocalResolution = 64;
+    bool cacheStatic = true;
+};
+
+struct ShadowStats {
+    static const size_t kMaxCascades = 4;
+
+    uint32_t views;                     // cascades and local light views this frame
+    uint32_t viewsRendered;             // static casters drawn again
+    uint32_t viewsCached;               // static depth copied from the cache
+    uint32_t lightsShadowed;
+    uint32_t lightsDropped;             // asked for a shadow, found no room in the atlas
+    uint64_t castersDrawn;              // draws over every view
+    uint64_t castersCulled;
+    uint64_t cascadeCasters[kMaxCascades];
+    double cpuMs;                       // planning, culling and submission
+    double gpuMs;                       // GPU time of the most recent frame that resolved
+    float atlasUsage;                   // share of the atlas handed out
+};
+
+/**
+ * @brief Shadow maps of a directional light (cascades) and of spot and point lights (atlas)
+ *
+ * Every shadow view is a tile of one depth atlas: the cascades along the first row, local
+ * lights packed under them, a spot light one tile, a point light six. Each frame:
+ *
+ *     shadows.update(cameraView, sunDirection, lights);   // plans views, sets light.shadow
+ *     shadows.render(casters, drawCaster);                 // fills the atlas
+ *     renderer.setShadows(&shadows);                       // the lighting samples it
+ *
+ * Casters are culled against each view's frustum. With `cacheStatic` the static casters are
+ * drawn into a second atlas; a view whose matrix and tile did not change since it was drawn
+ * only copies its static depth over and draws the dynamic casters on top.
+ *
+ * The lighting shaders read the views from kViewBinding and the atlas from kAtlasUnit,
+ * see `apply`.
+ *
+ * @note Must be initialized and used on the thread that owns the GL context.
+ */
+class ShadowRenderer {
+public:
+    static constexpr GLuint kAtlasUnit = 4;
+    static constexpr GLuint kViewBinding = 5;
+
+    ShadowRenderer();
+
+    ShadowRenderer(const ShadowRenderer& other) = delete;
+
+    ShadowRenderer& operator=(const ShadowRenderer& other) = delete;
+
+    ~ShadowRenderer();
+
+    /**
+     * @brief Creates the atlases and builds the depth shader in `shaderDirectory`
+     */
+    bool init(const ShadowSettings& settings, const std::string& shaderDirectory = "assets/shaders/shadows");
+
+    bool initialized() const { return m_initialized; }
+
+    const ShadowSettings& settings() const { return m_settings; }
+
+    /// Takes effect on the next render
+    void setCacheStatic(bool enable) { m_settings.cacheStatic = enable; }
+
+    /// Static casters moved or changed: every cached view is drawn again
+    void invalidateStatic() { m_staticVersion++; }
+
+    /**
+     * @brief Plans this frame's views
+     *
+     * Fits the cascades to `camera` for a sun travelling along `sunDirection` (a zero
+     * vector turns the sun's shadows off) and gives each light that casts shadows its tiles,
+     * biggest for the lights closest to the camera. Writes light.shadow.x.
+     */
+    void update(const ShadowCameraView& camera, const glm::vec3& sunDirection, std::vector<Light>& lights);
+
+    /**
+     * @brief Draws the casters into every view planned by update
+     *
+     * `drawCaster(shader, i)` sets `model` and draws caster i.
+     */
+    void render(const std::vector<ShadowCaster>& casters, const std::function<void(const Shader&, size_t)>& drawCaster);
+
+    /// Binds the atlas and the views and sets the shadow uniforms of `shader` (bound)
+    void apply(const Shader& shader) const;
+
+    const Cascade& cascade(size_t i) const { return m_cascades[i]; }
+
+    size_t cascadeCount() const { return m_cascadeCount; }
+
+    const ShadowStats& stats() const { return m_stats; }
+
+    GLuint atlasTexture() const { return m_atlas.depthTexture(); }
+
+    uint64_t byteSize() const;
+
+private:
+    /// std430 layout of the ShadowViews block in lighting.frag
+    struct GpuView {
+        glm::mat4 viewProjection;
+        glm::vec4 rect;         // uv offset and scale of the tile
+        glm::vec4 params;       // x depth bias, y normal offset per unit of distance, z 1 for perspective
+    };
+
+    struct View {
+        glm::mat4 viewProjection;
+        ShadowRect rect;
+        Frustum frustum;
+        int cascade;            // -1 for local lights
+    };
+
+    /// What the static atlas holds in one tile
+    struct CachedTile {
+        glm::mat4 viewProjection;
+        ShadowRect rect;
+        uint64_t staticVersion;
+    };
+
+    bool m_initialized;
+    ShadowSettings m_settings;
+    std::unique_ptr<Shader> m_depth;
+    Framebuffer m_atlas;
+    Framebuffer m_staticAtlas;
+    GLuint m_viewBuffer;
+    size_t m_viewCapacity;
+    ShadowAtlas m_packer;
+
+    Cascade m_cascades[ShadowStats::kMaxCascades];
+    size_t m_cascadeCount;
+    std::vector<View> m_views;
+    std::vector<GpuView> m_gpuViews;
+    std::unordered_map<uint64_t, CachedTile> m_cache;    // by tile position and size
+    uint64_t m_staticVersion;
+
+    // timestamps around the pass, GpuProfiler's frame query may already be open
+    TimestampRing m_timestamps;
+    ShadowStats m_stats;
+
+    bool _createAtlases();
+
+    void _addView(const glm::mat4& viewProjection, const ShadowRect& rect, int cascade, float depthBias, float normalOffset,
+                  bool perspective);
+
+    /// Whether the static atlas already holds `view`; if not, forgets the tiles it overlaps
+    bool _cached(const View& view);
+
+    void _drawCasters(const View& view, const std::vector<ShadowCaster>& casters, bool isStatic,
+                      const std::function<void(const Shader&, size_t)>& drawCaster);
+
+    void _collectTiming();
+};
+
+#endif // !_SHADOWS_H_
@@ -0,0 +1,642 @@
+#include "SoftwareRasterizer.h"
+
+#include "../core/Mesh.h"
+#include "../core/ThreadPool.h"
+#include "../math/BatchMath.h"
+#include "../opengl/log.h"
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RASTER_X86
+#include <immintrin.h>
+#endif
+
+// AVX2 only: with FMA the compiler could fuse the depth interpolation and break the
+// bit-for-bit match with the other levels
+#if defined(__GNUC__) || defined(__clang__)
+#define RASTER_AVX2 __attribute__((target("avx2")))
+#else
+#define RASTER_AVX2
+#endif
+
+namespace {
+
+constexpr int kSubpixel = 1 << SoftwareRasterizer::kSubpixelBits;
+constexpr int kHalfPixel = kSubpixel / 2;
+// clip x and y at 4 times the viewport's half extent: far enough that few triangles need it,
+// close enough that the snapped coordinates' products fit the edge functions' 64 bits and
+// a tile's worth of steps their 32
+constexpr float kGuardBand = 4.0f;
+constexpr size_t kBatchTriangles = 1024;
+constexpr size_t kMaxBatches = 64;
+constexpr int kMaxClipVertices = 9;
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+/// Floor of a / b for b > 0
+int32_t floor_div(int64_t a, int64_t b) {
+    return (int32_t)(a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+uint32_t pack_rgba(const glm::vec3& color) {
+    uint32_t rgba = 0xff000000u;
+    for (int c = 0; c < 3; c++) {
+        const float value = std::min(std::max(color[c], 0.0f), 1.0f);
+        rgba |= (uint32_t)(value * 255.0f + 0.5f) << (8 * c);
+    }
+    return rgba;
+}
+
+/**
+ * One triangle over one tile: the edges the region is not entirely inside of, stepping one
+ * pixel in x and y, and the depth plane from the region's first pixel center.
+ */
+struct RasterJob {
+    float* depth;
+    uint32_t* color;            // null for depth only
+    int stride;
+    int tileX;                  // first column of the tile, SIMD groups are aligned to it
+    int rx0, rx1, ry0, ry1;     // inclusive pixel region
+    int edges;
+    int32_t e[3];
+    int32_t stepX[3];
+    int32_t stepY[3];
+    float zt;
+    float dzdx;
+    float dzdy;
+    uint32_t rgba;
+};
+
+// ---------------------------------------------------------------------------------------
+// scalar; the SIMD kernels compute the same integers and do the same float operations in
+// the same order, so they write the same bits
+
+uint64_t scalar_raster(const RasterJob& job) {
+    uint64_t written = 0;
+    for (int y = job.ry0; y <= job.ry1; y++) {
+        const int dy = y - job.ry0;
+        int32_t row[3];
+        for (int p = 0; p < job.edges; p++) {
+            row[p] = job.e[p] + job.stepY[p] * dy;
+        }
+        const float zr = job.zt + job.dzdy * (float)dy;
+        float* depth = job.depth + (size_t)y * job.stride;
+        uint32_t* color = job.color ? job.color + (size_t)y * job.stride : nullptr;
+
+        for (int x = job.rx0; x <= job.rx1; x++) {
+            const int dx = x - job.rx0;
+            bool inside = true;
+            for (int p = 0; p < job.edges; p++) {
+                inside = inside && row[p] + job.stepX[p] * dx >= 0;
+            }
+            if (!inside) {
+                continue;
+            }
+            const float z = zr + job.dzdx * (float)dx;
+            if (z < depth[x]) {
+                depth[x] = z;
+                if (color) {
+                    color[x] = job.rgba;
+                }
+                written++;
+            }
+        }
+    }
+    return written;
+}
+
+#ifdef RASTER_X86
+
+// ---------------------------------------------------------------------------------------
+// SSE2, four pixels of a row at a time
+
+uint64_t sse_raster(const RasterJob& job) {
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128i minusOne = _mm_set1_epi32(-1);
+    const __m128i first = _mm_set1_epi32(job.rx0 - 1);
+    const __m128i last = _mm_set1_epi32(job.rx1 + 1);
+    const __m128 dzdx = _mm_set1_ps(job.dzdx);
+    const __m128i rgba = _mm_set1_epi32((int)job.rgba);
+    // groups start on multiples of 4 from the tile's first column: they never leave the tile
+    const int gx0 = job.tileX + (job.rx0 - job.tileX) / 4 * 4;
+
+    __m128i laneStep[3], groupStep[3];
+    for (int p = 0; p < job.edges; p++) {
+        laneStep[p] = _mm_setr_epi32(0, job.stepX[p], 2 * job.stepX[p], 3 * job.stepX[p]);
+        groupStep[p] = _mm_set1_epi32(4 * job.stepX[p]);
+    }
+
+    uint64_t written = 0;
+    for (int y = job.ry0; y <= job.ry1; y++) {
+        const int dy = y - job.ry0;
+        const float zr = job.zt + job.dzdy * (float)dy;
+        float* depth = job.depth + (size_t)y * job.stride;
+        uint32_t* color = job.color ? job.color + (size_t)y * job.stride : nullptr;
+
+        __m128i e[3];
+        for (int p = 0; p < job.edges; p++) {
+            e[p] = _mm_add_epi32(_mm_set1_epi32(job.e[p] + job.stepY[p] * dy + job.stepX[p] * (gx0 - job.rx0)), laneStep[p]);
+        }
+        __m128i xs = _mm_add_epi32(_mm_set1_epi32(gx0), lanes);
+        __m128i dxs = _mm_add_epi32(_mm_set1_epi32(gx0 - job.rx0), lanes);
+        const __m128 zRow = _mm_set1_ps(zr);
+
+        for (int x = gx0; x <= job.rx1; x += 4) {
+            __m128i mask = _mm_and_si128(_mm_cmpgt_epi32(xs, first), _mm_cmpgt_epi32(last, xs));
+            for (int p = 0; p < job.edges; p++) {
+                mask = _mm_and_si128(mask, _mm_cmpgt_epi32(e[p], minusOne));
+                e[p] = _mm_add_epi32(e[p], groupStep[p]);
+            }
+            if (_mm_movemask_epi8(mask)) {
+                const __m128 z = _mm_add_ps(zRow, _mm_mul_ps(dzdx, _mm_cvtepi32_ps(dxs)));
+                const __m128 old = _mm_loadu_ps(depth + x);
+                const __m128 pass = _mm_and_ps(_mm_castsi128_ps(mask), _mm_cmplt_ps(z, old));
+                const int bits = _mm_movemask_ps(pass);
+                if (bits) {
+                    _mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, old)));
+                    if (color) {
+                        const __m128i passI = _mm_castps_si128(pass);
+                        const __m128i previous = _mm_loadu_si128((const __m128i*)(color + x));
+                        _mm_storeu_si128((__m128i*)(color + x), _mm_or_si128(_mm_and_si128(passI, rgba), _mm_andnot_si128(passI, previous)));
+                    }
+                    written += std::bitset<4>((unsigned)bits).count();
+                }
+            }
+            xs = _mm_add_epi32(xs, four);
+            dxs = _mm_add_epi32(dxs, four);
+        }
+    }
+    return written;
+}
+
+// ---------------------------------------------------------------------------------------
+// AVX2, eight pixels of a row at a time
+
+RASTER_AVX2
+uint64_t avx2_raster(const RasterJob& job) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i eight = _mm256_set1_epi32(8);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    const __m256i first = _mm256_set1_epi32(job.rx0 - 1);
+    const __m256i last = _mm256_set1_epi32(job.rx1 + 1);
+    const __m256 dzdx = _mm256_set1_ps(job.dzdx);
+    const __m256i rgba = _mm256_set1_epi32((int)job.rgba);
+    const int gx0 = job.tileX + (job.rx0 - job.tileX) / 8 * 8;
+
+    __m256i laneStep[3], groupStep[3];
+    for (int p = 0; p < job.edges; p++) {
+        laneStep[p] = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(job.stepX[p]));
+        groupStep[p] = _mm256_set1_epi32(8 * job.stepX[p]);
+    }
+
+    uint64_t written = 0;
+    for (int y = job.ry0; y <= job.ry1; y++) {
+        const int dy = y - job.ry0;
+        const float zr = job.zt + job.dzdy * (float)dy;
+        float* depth = job.depth + (size_t)y * job.stride;
+        uint32_t* color = job.color ? job.color + (size_t)y * job.stride : nullptr;
+
+        __m256i e[3];
+        for (int p = 0; p < job.edges; p++) {
+            e[p] = _mm256_add_epi32(_mm256_set1_epi32(job.e[p] + job.stepY[p] * dy + job.stepX[p] * (gx0 - job.rx0)), laneStep[p]);
+        }
+        __m256i xs = _mm256_add_epi32(_mm256_set1_epi32(gx0), lanes);
+        __m256i dxs = _mm256_add_epi32(_mm256_set1_epi32(gx0 - job.rx0), lanes);
+        const __m256 zRow = _mm256_set1_ps(zr);
+
+        for (int x = gx0; x <= job.rx1; x += 8) {
+            __m256i mask = _mm256_and_si256(_mm256_cmpgt_epi32(xs, first), _mm256_cmpgt_epi32(last, xs));
+            for (int p = 0; p < job.edges; p++) {
+                mask = _mm256_and_si256(mask, _mm256_cmpgt_epi32(e[p], minusOne));
+                e[p] = _mm256_add_epi32(e[p], groupStep[p]);
+            }
+            if (!_mm256_testz_si256(mask, mask)) {
+                const __m256 z = _mm256_add_ps(zRow, _mm256_mul_ps(dzdx, _mm256_cvtepi32_ps(dxs)));
+                const __m256 old = _mm256_loadu_ps(depth + x);
+                const __m256 pass = _mm256_and_ps(_mm256_castsi256_ps(mask), _mm256_cmp_ps(z, old, _CMP_LT_OQ));
+                const int bits = _mm256_movemask_ps(pass);
+                if (bits) {
+                    _mm256_storeu_ps(depth + x, _mm256_blendv_ps(old, z, pass));
+                    if (color) {
+                        const __m256i previous = _mm256_loadu_si256((const __m256i*)(color + x));
+                        _mm256_storeu_si256((__m256i*)(color + x), _mm256_blendv_epi8(previous, rgba, _mm256_castps_si256(pass)));
+                    }
+                    written += std::bitset<8>((unsigned)bits).count();
+                }
+            }
+            xs = _mm256_add_epi32(xs, eight);
+            dxs = _mm256_add_epi32(dxs, eight);
+        }
+    }
+    return written;
+}
+
+#endif
+
+uint64_t raster(const RasterJob& job) {
+    switch (simd_level()) {
+#ifdef RASTER_X86
+    case SimdLevel::AVX2: return avx2_raster(job);
+    case SimdLevel::SSE: return sse_raster(job);
+#endif
+    default: return scalar_raster(job);
+    }
+}
+
+/// Signed distances of a clip space vertex to the planes it is clipped against, inside >= 0
+void clip_distances(const glm::vec4& v, float* d) {
+    d[0] = v.z + v.w;                   // near
+    d[1] = v.w - v.z;                   // far
+    d[2] = kGuardBand * v.w - v.x;
+    d[3] = kGuardBand * v.w + v.x;
+    d[4] = kGuardBand * v.w - v.y;
+    d[5] = kGuardBand * v.w + v.y;
+}
+
+/// Sutherland-Hodgman against one plane; returns the new vertex count
+int clip_polygon(const glm::vec4* in, int count, glm::vec4* out, int plane) {
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        const glm::vec4& a = in[i];
+        const glm::vec4& b = in[(i + 1) % count];
+        float da[6], db[6];
+        clip_distances(a, da);
+        clip_distances(b, db);
+        if (da[plane] >= 0.0f) {
+            out[written++] = a;
+        }
+        if ((da[plane] >= 0.0f) != (db[plane] >= 0.0f)) {
+            const float t = da[plane] / (da[plane] - db[plane]);
+            out[written++] = a + (b - a) * t;
+        }
+    }
+    return written;
+}
+
+}
+
+SoftwareRasterizer::SoftwareRasterizer(ThreadPool* pool)
+    : m_pool(pool ? pool : &ThreadPool::get()),
+      m_width(0),
+      m_height(0),
+      m_stride(0),
+      m_tilesX(0),
+      m_tilesY(0),
+      m_depth(),
+      m_color(),
+      m_clip(),
+      m_triangles(),
+      m_positions(),
+      m_batches(),
+      m_batchCount(0),
+      m_tilePixels(),
+      m_colorEnabled(true),
+      m_cull(RasterCull::None),
+      m_lightDirection(glm::normalize(glm::vec3(-0.4f, -1.0f, -0.25f))),
+      m_ambient(0.3f),
+      m_stats()
+{}
+
+SoftwareRasterizer::~SoftwareRasterizer() {}
+
+unsigned int SoftwareRasterizer::threadCount() const {
+    return m_pool->threadCount();
+}
+
+bool SoftwareRasterizer::resize(int width, int height) {
+    if (width <= 0 || height <= 0 || width > kMaxSize || height > kMaxSize) {
+        gl_log_err("ERROR: software rasterizer size %dx%d is outside 1..%d\n", width, height, kMaxSize);
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + kTileSize - 1) / kTileSize;
+    m_tilesY = (height + kTileSize - 1) / kTileSize;
+    m_stride = m_tilesX * kTileSize;
+    m_depth.assign((size_t)m_stride * height, 1.0f);
+    m_color.assign((size_t)m_stride * height, 0xff000000u);
+    for (Batch& batch : m_batches) {
+        batch.bins.assign((size_t)m_tilesX * m_tilesY, std::vector<uint32_t>());
+    }
+    return true;
+}
+
+void SoftwareRasterizer::clear(float depth, uint32_t rgba) {
+    std::fill(m_depth.begin(), m_depth.end(), depth);
+    if (m_colorEnabled) {
+        std::fill(m_color.begin(), m_color.end(), rgba);
+    }
+}
+
+void SoftwareRasterizer::setLight(const glm::vec3& direction, float ambient) {
+    m_lightDirection = glm::normalize(direction);
+    m_ambient = ambient;
+}
+
+void SoftwareRasterizer::submit(const Mesh& mesh, const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& color) {
+    m_positions.clear();
+    const Vertf* vertices = mesh.vertices();
+    for (unsigned int i = 0; i < mesh.vertexCount(); i++) {
+        m_positions.push_back(glm::vec3(vertices[i][0], vertices[i][1], vertices[i][2]));
+    }
+    if (m_positions.empty()) {
+        return;
+    }
+    submit(&m_positions[0].x, sizeof(glm::vec3), m_positions.size(), mesh.indexCount() ? mesh.indices() : nullptr,
+           mesh.indexCount(), model, viewProjection, color);
+}
+
+void SoftwareRasterizer::submit(const float* positions, size_t stride, size_t vertexCount, const uint32_t* indices,
+                                size_t indexCount, const glm::mat4& model, const glm::mat4& viewProjection,
+                                const glm::vec3& color)
+{
+    const uint32_t base = (uint32_t)m_clip.size();
+    const glm::mat4 modelViewProjection = viewProjection * model;
+    const unsigned char* bytes = (const unsigned char*)positions;
+    for (size_t i = 0; i < vertexCount; i++) {
+        const float* p = (const float*)(bytes + i * stride);
+        m_clip.push_back(modelViewProjection * glm::vec4(p[0], p[1], p[2], 1.0f));
+    }
+
+    const size_t count = indices ? indexCount : vertexCount;
+    const uint32_t albedo = pack_rgba(color);
+    for (size_t i = 0; i + 2 < count; i += 3) {
+        Triangle triangle;
+        for (int k = 0; k < 3; k++) {
+            triangle.vertices[k] = base + (indices ? indices[i + k] : (uint32_t)(i + k));
+        }
+        triangle.color = albedo;
+        if (m_colorEnabled) {
+            // flat, two-sided: the Cube's faces are not wound consistently
+            glm::vec3 world[3];
+            for (int k = 0; k < 3; k++) {
+                const float* p = (const float*)(bytes + (triangle.vertices[k] - base) * stride);
+                world[k] = glm::vec3(model * glm::vec4(p[0], p[1], p[2], 1.0f));
+            }
+            const glm::vec3 normal = glm::cross(world[1] - world[0], world[2] - world[0]);
+            const float length = glm::length(normal);
+            const float diffuse = length > 0.0f ? std::abs(glm::dot(normal, m_lightDirection)) / length : 0.0f;
+            triangle.color = pack_rgba(color * (m_ambient + (1.0f - m_ambient) * diffuse));
+        }
+        m_triangles.push_back(triangle);
+    }
+}
+
+void SoftwareRasterizer::render() {
+    m_stats = RasterStats();
+    m_stats.triangles = m_triangles.size();
+    if (m_triangles.empty() || m_width == 0) {
+        m_clip.clear();
+        m_triangles.clear();
+        return;
+    }
+
+    const size_t count = m_triangles.size();
+    const size_t tiles = (size_t)m_tilesX * m_tilesY;
+    m_batchCount = std::min(kMaxBatches, (count + kBatchTriangles - 1) / kBatchTriangles);
+    if (m_batches.size() < m_batchCount) {
+        m_batches.resize(m_batchCount);
+    }
+    for (size_t b = 0; b < m_batchCount; b++) {
+        m_batches[b].bins.resize(tiles);
+    }
+
+    const auto binStart = Clock::now();
+    m_pool->parallelFor(m_batchCount, 1, [this, count](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            _bin(m_batches[b], count * b / m_batchCount, count * (b + 1) / m_batchCount);
+        }
+    });
+    const auto rasterStart = Clock::now();
+    m_tilePixels.assign(tiles, 0);
+    m_pool->parallelFor(tiles, 1, [this](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++) {
+            m_tilePixels[tile] = _rasterTile((int)tile);
+        }
+    });
+    m_stats.binMs = milliseconds(rasterStart - binStart);
+    m_stats.rasterMs = milliseconds(Clock::now() - rasterStart);
+
+    for (size_t b = 0; b < m_batchCount; b++) {
+        const Batch& batch = m_batches[b];
+        m_stats.clipped += batch.clipped;
+        m_stats.culled += batch.culled;
+        m_stats.binned += batch.triangles.size();
+        m_stats.tileTriangles += batch.tileTriangles;
+    }
+    for (uint64_t pixels : m_tilePixels) {
+        m_stats.pixels += pixels;
+    }
+    m_clip.clear();
+    m_triangles.clear();
+}
+
+void SoftwareRasterizer::_bin(Batch& batch, size_t begin, size_t end) {
+    batch.triangles.clear();
+    for (std::vector<uint32_t>& bin : batch.bins) {
+        bin.clear();
+    }
+    batch.clipped = 0;
+    batch.culled = 0;
+    batch.tileTriangles = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        const Triangle& triangle = m_triangles[i];
+        glm::vec4 clip[3];
+        float distances[3][6];
+        bool inside = true;
+        for (int k = 0; k < 3; k++) {
+            clip[k] = m_clip[triangle.vertices[k]];
+            clip_distances(clip[k], distances[k]);
+            for (int plane = 0; plane < 6; plane++) {
+                inside = inside && distances[k][plane] >= 0.0f;
+            }
+        }
+
+        // off screen: all three vertices outside the same side of the view volume
+        bool outside = false;
+        for (int axis = 0; axis < 3 && !outside; axis++) {
+            for (float side : { -1.0f, 1.0f }) {
+                if (side * clip[0][axis] > clip[0].w && side * clip[1][axis] > clip[1].w && side * clip[2][axis] > clip[2].w) {
+                    outside = true;
+                }
+            }
+        }
+        if (outside) {
+            batch.culled++;
+            continue;
+        }
+
+        if (inside) {
+            _setup(batch, clip, triangle.color);
+            continue;
+        }
+
+        batch.clipped++;
+        glm::vec4 polygon[2][kMaxClipVertices];
+        int vertices = 3;
+        std::copy(clip, clip + 3, polygon[0]);
+        int current = 0;
+        for (int plane = 0; plane < 6 && vertices >= 3; plane++) {
+            vertices = clip_polygon(polygon[current], vertices, polygon[1 - current], plane);
+            current = 1 - current;
+        }
+        for (int k = 1; k + 1 < vertices; k++) {
+            const glm::vec4 fan[3] = { polygon[current][0], polygon[current][k], polygon[current][k + 1] };
+            _setup(batch, fan, triangle.color);
+        }
+    }
+}
+
+void SoftwareRasterizer::_setup(Batch& batch, const glm::vec4* clip, uint32_t color) {
+    SetupTriangle t;
+    float z[3];
+    for (int k = 0; k < 3; k++) {
+        const float inverseW = 1.0f / clip[k].w;
+        const float sx = (clip[k].x * inverseW * 0.5f + 0.5f) * (float)m_width;
+        const float sy = (clip[k].y * inverseW * 0.5f + 0.5f) * (float)m_height;
+        t.x[k] = (int32_t)std::floor(sx * kSubpixel + 0.5f);
+        t.y[k] = (int32_t)std::floor(sy * kSubpixel + 0.5f);
+        z[k] = clip[k].z * inverseW * 0.5f + 0.5f;
+    }
+
+    int64_t area = (int64_t)(t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (int64_t)(t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+    if (area == 0 || (area < 0 && m_cull == RasterCull::Back)) {
+        batch.culled++;
+        return;
+    }
+    if (area < 0) {
+        std::swap(t.x[1], t.x[2]);
+        std::swap(t.y[1], t.y[2]);
+        std::swap(z[1], z[2]);
+    }
+
+    // pixels whose center is in the bounding box
+    const int32_t minX = std::min(std::min(t.x[0], t.x[1]), t.x[2]);
+    const int32_t maxX = std::max(std::max(t.x[0], t.x[1]), t.x[2]);
+    const int32_t minY = std::min(std::min(t.y[0], t.y[1]), t.y[2]);
+    const int32_t maxY = std::max(std::max(t.y[0], t.y[1]), t.y[2]);
+    t.minX = std::max(floor_div(minX - kHalfPixel + kSubpixel - 1, kSubpixel), 0);
+    t.maxX = std::min(floor_div(maxX - kHalfPixel, kSubpixel), m_width - 1);
+    t.minY = std::max(floor_div(minY - kHalfPixel + kSubpixel - 1, kSubpixel), 0);
+    t.maxY = std::min(floor_div(maxY - kHalfPixel, kSubpixel), m_height - 1);
+    if (t.minX > t.maxX || t.minY > t.maxY) {
+        batch.culled++;
+        return;
+    }
+
+    // depth plane in pixels, from the snapped positions
+    const float scale = 1.0f / kSubpixel;
+    const float x1 = (t.x[1] - t.x[0]) * scale, y1 = (t.y[1] - t.y[0]) * scale, z1 = z[1] - z[0];
+    const float x2 = (t.x[2] - t.x[0]) * scale, y2 = (t.y[2] - t.y[0]) * scale, z2 = z[2] - z[0];
+    const float inverseArea = 1.0f / (x1 * y2 - x2 * y1);
+    t.z0 = z[0];
+    t.dzdx = (z1 * y2 - z2 * y1) * inverseArea;
+    t.dzdy = (x1 * z2 - x2 * z1) * inverseArea;
+    t.color = color;
+
+    const uint32_t index = (uint32_t)batch.triangles.size();
+    batch.triangles.push_back(t);
+    for (int ty = t.minY / kTileSize; ty <= t.maxY / kTileSize; ty++) {
+        for (int tx = t.minX / kTileSize; tx <= t.maxX / kTileSize; tx++) {
+            batch.bins[(size_t)ty * m_tilesX + tx].push_back(index);
+            batch.tileTriangles++;
+        }
+    }
+}
+
+uint64_t SoftwareRasterizer::_rasterTile(int tile) {
+    const int tileX = (tile % m_tilesX) * kTileSize;
+    const int tileY = (tile / m_tilesX) * kTileSize;
+    const int tileMaxX = std::min(tileX + kTileSize, m_width) - 1;
+    const int tileMaxY = std::min(tileY + kTileSize, m_height) - 1;
+
+    RasterJob job;
+    job.depth = m_depth.data();
+    job.color = m_colorEnabled ? m_color.data() : nullptr;
+    job.stride = m_stride;
+    job.tileX = tileX;
+
+    uint64_t written = 0;
+    for (size_t b = 0; b < m_batchCount; b++) {
+        const Batch& batch = m_batches[b];
+        for (uint32_t index : batch.bins[tile]) {
+            const SetupTriangle& t = batch.triangles[index];
+            job.rx0 = std::max(tileX, t.minX);
+            job.rx1 = std::min(tileMaxX, t.maxX);
+            job.ry0 = std::max(tileY, t.minY);
+            job.ry1 = std::min(tileMaxY, t.maxY);
+
+            // E(p) = A px + B py + C, >= 0 inside a counter-clockwise triangle; the edges that are
+            // not top or left lose 1 so a pixel center on a shared edge goes to one triangle only
+            const int64_t px = (int64_t)job.rx0 * kSubpixel + kHalfPixel;
+            const int64_t py = (int64_t)job.ry0 * kSubpixel + kHalfPixel;
+            job.edges = 0;
+            bool rejected = false;
+            for (int k = 0; k < 3 && !rejected; k++) {
+                const int a = k, c = (k + 1) % 3;
+                const int64_t A = (int64_t)t.y[a] - t.y[c];
+                const int64_t B = (int64_t)t.x[c] - t.x[a];
+                const bool topLeft = A > 0 || (A == 0 && B < 0);
+                const int64_t E = A * (px - t.x[a]) + B * (py - t.y[a]) - (topLeft ? 0 : 1);
+                const int64_t stepX = A * kSubpixel;
+                const int64_t stepY = B * kSubpixel;
+                const int64_t spanX = stepX * (job.rx1 - job.rx0);
+                const int64_t spanY = stepY * (job.ry1 - job.ry0);
+                const int64_t lowest = E + std::min<int64_t>(spanX, 0) + std::min<int64_t>(spanY, 0);
+                const int64_t highest = E + std::max<int64_t>(spanX, 0) + std::max<int64_t>(spanY, 0);
+                if (highest < 0) {
+                    rejected = true;
+                } else if (lowest < 0) {
+                    // straddles the region: its values over it fit 32 bits
+                    job.e[job.edges] = (int32_t)E;
+                    job.stepX[job.edges] = (int32_t)stepX;
+                    job.stepY[job.edges] = (int32_t)stepY;
+                    job.edges++;
+                }
+            }
+            if (rejected) {
+                continue;
+            }
+
+            const float scale = 1.0f / kSubpixel;
+            job.zt = t.z0 + t.dzdx * ((float)job.rx0 + 0.5f - t.x[0] * scale) + t.dzdy * ((float)job.ry0 + 0.5f - t.y[0] * scale);
+            job.dzdx = t.dzdx;
+            job.dzdy = t.dzdy;
+            job.rgba = t.color;
+            written += raster(job);
+        }
+    }
+    return written;
+}
+
+void SoftwareRasterizer::readDepth(std::vector<float>& depth) const {
+    depth.resize((size_t)m_width * m_height);
+    for (int y = 0; y < m_height; y++) {
+        std::copy_n(m_depth.begin() + (size_t)y * m_stride, m_width, depth.begin() + (size_t)y * m_width);
+    }
+}
+
+void SoftwareRasterizer::readColor(std::vector<unsigned char>& rgba) const {
+    rgba.resize((size_t)m_width * m_height * 4);
+    for (int y = 0; y < m_height; y++) {
+        for (int x = 0; x < m_width; x++) {
+            const uint32_t pixel = m_color[(size_t)y * m_stride + x];
+            unsigned char* out = &rgba[((size_t)y * m_width + x) * 4];
+            out[0] = (unsigned char)(pixel & 0xff);
+            out[1] = (unsigned char)((pixel >> 8) & 0xff);
+            out[2] = (unsigned char)((pixel >> 16) & 0xff);
+            out[3] = (unsigned char)(pixel >> 24);
+        }
+    }
+}
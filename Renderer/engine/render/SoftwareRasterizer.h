@@ -0,0 +1,180 @@
+#ifndef _SOFTWARE_RASTERIZER_H_
+#define _SOFTWARE_RASTERIZER_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+class ThreadPool;
+
+enum class RasterCull : uint8_t {
+    None,           // the Cube vertex data does not wind its faces consistently
+    Back            // counter-clockwise front faces, as GL's default
+};
+
+struct RasterStats {
+    size_t triangles = 0;       // submitted
+    size_t clipped = 0;         // crossed the near or far plane or the guard band
+    size_t culled = 0;          // back facing, degenerate or off screen
+    size_t binned = 0;          // set up and binned, after clipping
+    size_t tileTriangles = 0;   // bin entries, a triangle counts once per tile it overlaps
+    uint64_t pixels = 0;        // passed the depth test
+    double binMs = 0.0;
+    double rasterMs = 0.0;
+};
+
+/**
+ * @brief Tiled software rasterizer, depth and flat colors, with no GL involved
+ *
+ * Triangles are queued with `submit`, clip space from the same matrices the GL path uses,
+ * then `render` runs two parallel passes on the thread pool:
+ *
+ *   - binning: batches of triangles, in submission order, are clipped, snapped to 1/16 pixel,
+ *     set up and appended to the bin of every 32x32 tile they overlap, one bin per batch and
+ *     tile, so no lock is taken
+ *   - rasterization: each tile walks its bins batch after batch and tests the integer edge
+ *     functions and the depth of 4 (SSE) or 8 (AVX2) pixels at once, with GL's LESS depth test
+ *
+ * Coverage follows a top-left fill rule at pixel centers, so triangles sharing an edge cover
+ * each pixel once. Depth is window depth interpolated linearly in screen space, like GL. The
+ * result does not depend on the number of threads or the SIMD level (`set_simd_level` in
+ * BatchMath.h picks it for both), so images can be compared bit for bit.
+ *
+ * Depth only, it rasterizes occluders for DepthPyramid; with colors it shades every triangle
+ * with a flat two-sided Lambert term, enough for golden images of test scenes.
+ *
+ * The buffers are bottom row first, as glReadPixels returns them.
+ */
+class SoftwareRasterizer {
+public:
+    static constexpr int kTileSize = 32;
+    static constexpr int kSubpixelBits = 4;
+    static constexpr int kMaxSize = 4096;
+
+    /// Runs its passes on `pool`, the shared one if null
+    explicit SoftwareRasterizer(ThreadPool* pool = nullptr);
+
+    SoftwareRasterizer(const SoftwareRasterizer& other) = delete;
+
+    SoftwareRasterizer& operator=(const SoftwareRasterizer& other) = delete;
+
+    ~SoftwareRasterizer();
+
+    /**
+     * @brief Sizes the buffers, clearing them
+     *
+     * @return false above kMaxSize, the limit of the edge functions' fixed point range
+     */
+    bool resize(int width, int height);
+
+    /// Depth to `depth`, colors to `rgba` (0xAABBGGRR, as RGBA8 bytes in memory)
+    void clear(float depth = 1.0f, uint32_t rgba = 0xff000000u);
+
+    /// Depth only skips the color buffer and the shading
+    void setColorEnabled(bool enable) { m_colorEnabled = enable; }
+
+    bool colorEnabled() const { return m_colorEnabled; }
+
+    void setCull(RasterCull cull) { m_cull = cull; }
+
+    /// World space direction the light travels and the ambient term of the flat shading
+    void setLight(const glm::vec3& direction, float ambient);
+
+    /**
+     * @brief Queues the triangles of `mesh`, its indices if it has any
+     *
+     * The first three floats of each vertex are its position. `color` is the albedo.
+     */
+    void submit(const Mesh& mesh, const glm::mat4& model, const glm::mat4& viewProjection,
+                const glm::vec3& color = glm::vec3(1.0f));
+
+    /**
+     * @brief Queues triangles of `vertexCount` positions `stride` bytes apart
+     *
+     * @param indices `indexCount` indices, or null for a plain triangle list of the vertices
+     */
+    void submit(const float* positions, size_t stride, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+                const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& color = glm::vec3(1.0f));
+
+    /// Rasterizes everything queued since the last call into the buffers
+    void render();
+
+    int width() const { return m_width; }
+
+    int height() const { return m_height; }
+
+    float depthAt(int x, int y) const { return m_depth[(size_t)y * m_stride + x]; }
+
+    uint32_t colorAt(int x, int y) const { return m_color[(size_t)y * m_stride + x]; }
+
+    /// `width * height` depths, for DepthPyramid::build
+    void readDepth(std::vector<float>& depth) const;
+
+    /// `width * height` RGBA8 pixels, as Framebuffer::readPixels
+    void readColor(std::vector<unsigned char>& rgba) const;
+
+    /// Of the last render
+    const RasterStats& stats() const { return m_stats; }
+
+    /// Threads the passes run on
+    unsigned int threadCount() const;
+
+private:
+    struct Triangle {
+        uint32_t vertices[3];
+        uint32_t color;
+    };
+
+    /// A triangle ready to rasterize, see SoftwareRasterizer.cpp
+    struct SetupTriangle {
+        int32_t x[3];
+        int32_t y[3];
+        float z0;
+        float dzdx;
+        float dzdy;
+        uint32_t color;
+        int32_t minX, minY, maxX, maxY;     // pixels, inclusive
+    };
+
+    /// What one binning batch produced: its triangles and their index per tile
+    struct Batch {
+        std::vector<SetupTriangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;
+        size_t clipped = 0;
+        size_t culled = 0;
+        size_t tileTriangles = 0;
+    };
+
+    ThreadPool* m_pool;
+    int m_width;
+    int m_height;
+    int m_stride;               // pixels per row, whole tiles so a SIMD group never leaves its tile
+    int m_tilesX;
+    int m_tilesY;
+    std::vector<float> m_depth;
+    std::vector<uint32_t> m_color;
+
+    std::vector<glm::vec4> m_clip;
+    std::vector<Triangle> m_triangles;
+    std::vector<glm::vec3> m_positions;   // scratch of submit(Mesh)
+    std::vector<Batch> m_batches;
+    size_t m_batchCount;        // of the render in flight
+    std::vector<uint64_t> m_tilePixels;
+
+    bool m_colorEnabled;
+    RasterCull m_cull;
+    glm::vec3 m_lightDirection;
+    float m_ambient;
+    RasterStats m_stats;
+
+    void _bin(Batch& batch, size_t begin, size_t end);
+
+    void _setup(Batch& batch, const glm::vec4* clip, uint32_t color);
+
+    uint64_t _rasterTile(int tile);
+};
+
+#endif // !_SOFTWARE_RASTERIZER_H_
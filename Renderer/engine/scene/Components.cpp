@@ -0,0 +1,112 @@
+#include "Components.h"
+
+void TransformStorage::add(Entity entity, const Transform& transform) {
+    if (contains(entity)) {
+        uint32_t i = index(entity);
+        positions[i] = transform.position;
+        rotations[i] = transform.rotation;
+        scales[i] = transform.scale;
+        return;
+    }
+
+    _insert(entity);
+    positions.push_back(transform.position);
+    rotations.push_back(transform.rotation);
+    scales.push_back(transform.scale);
+    worlds.push_back(compose_transform(transform.position, transform.rotation, transform.scale));
+}
+
+void TransformStorage::remove(Entity entity) {
+    if (!contains(entity)) {
+        return;
+    }
+
+    uint32_t i = _erase(entity);
+    swap_remove(positions, i);
+    swap_remove(rotations, i);
+    swap_remove(scales, i);
+    swap_remove(worlds, i);
+}
+
+void TransformStorage::reserve(size_t count) {
+    _reserve(count);
+    positions.reserve(count);
+    rotations.reserve(count);
+    scales.reserve(count);
+    worlds.reserve(count);
+}
+
+void BoundsStorage::add(Entity entity, const Bounds& bounds) {
+    if (contains(entity)) {
+        uint32_t i = index(entity);
+        centers[i] = bounds.center;
+        extents[i] = bounds.extents;
+        return;
+    }
+
+    _insert(entity);
+    centers.push_back(bounds.center);
+    extents.push_back(bounds.extents);
+    worldMins.push_back(bounds.center - bounds.extents);
+    worldMaxs.push_back(bounds.center + bounds.extents);
+}
+
+void BoundsStorage::remove(Entity entity) {
+    if (!contains(entity)) {
+        return;
+    }
+
+    uint32_t i = _erase(entity);
+    swap_remove(centers, i);
+    swap_remove(extents, i);
+    swap_remove(worldMins, i);
+    swap_remove(worldMaxs, i);
+}
+
+void BoundsStorage::reserve(size_t count) {
+    _reserve(count);
+    centers.reserve(count);
+    extents.reserve(count);
+    worldMins.reserve(count);
+    worldMaxs.reserve(count);
+}
+
+void RenderableStorage::add(Entity entity, const Renderable& renderable) {
+    if (contains(entity)) {
+        uint32_t i = index(entity);
+        kinds[i] = renderable.kind;
+        cubes[i] = renderable.cube;
+        models[i] = renderable.model;
+        shaders[i] = renderable.shader;
+        return;
+    }
+
+    _insert(entity);
+    kinds.push_back(renderable.kind);
+    cubes.push_back(renderable.cube);
+    models.push_back(renderable.model);
+    shaders.push_back(renderable.shader);
+    visible.push_back(1);
+}
+
+void RenderableStorage::remove(Entity entity) {
+    if (!contains(entity)) {
+        return;
+    }
+
+    uint32_t i = _erase(entity);
+    swap_remove(kinds, i);
+    swap_remove(cubes, i);
+    swap_remove(models, i);
+    swap_remove(shaders, i);
+    swap_remove(visible, i);
+}
+
+void RenderableStorage::reserve(size_t count) {
+    _reserve(count);
+    kinds.reserve(count);
+    cubes.reserve(count);
+    models.reserve(count);
+    shaders.reserve(count);
+    visible.reserve(count);
+}
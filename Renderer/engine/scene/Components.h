@@ -0,0 +1,160 @@
+#ifndef _COMPONENTS_H_
+#define _COMPONENTS_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "SparseSet.h"
+
+class Cube;
+
+namespace asset {
+    class Model;
+    class Shader;
+}
+
+/// Local transform, as handed to `TransformStorage::add`
+struct Transform {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+/// Local-space axis aligned box
+struct Bounds {
+    glm::vec3 center = glm::vec3(0.0f);
+    glm::vec3 extents = glm::vec3(0.5f);
+};
+
+enum class RenderableKind : uint8_t {
+    Cube,
+    Model
+};
+
+/**
+ * @brief What to draw for an entity
+ *
+ * The scene does not own the resources: a Cube carries its own shader and texture, a Model
+ * is drawn with `shader`.
+ */
+struct Renderable {
+    RenderableKind kind = RenderableKind::Cube;
+    Cube* cube = nullptr;
+    asset::Model* model = nullptr;
+    asset::Shader* shader = nullptr;
+};
+
+/**
+ * @brief T * R * S as a column-major matrix, without going through three mat4 products
+ */
+inline glm::mat4 compose_transform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+
+    glm::mat4 result;
+    result[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f);
+    result[1] = glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f);
+    result[2] = glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f);
+    result[3] = glm::vec4(position, 1.0f);
+    return result;
+}
+
+/**
+ * @brief Splits a T * R * S matrix (no shear) back into its parts
+ *
+ * An axis scaled to zero, a joint collapsed by its animation say, has no direction. With one
+ * such axis the rotation is completed from the other two; with more `rotation` keeps the
+ * value it came in with, so callers pass the last valid one (or identity).
+ */
+inline void decompose_transform(const glm::mat4& m, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) {
+    constexpr float kMinScale = 1e-6f;
+
+    position = glm::vec3(m[3]);
+    glm::mat3 basis = glm::mat3(m);
+    scale = glm::vec3(glm::length(basis[0]), glm::length(basis[1]), glm::length(basis[2]));
+
+    // a mirrored basis keeps a proper rotation by flipping one axis
+    if (glm::dot(glm::cross(basis[0], basis[1]), basis[2]) < 0.0f) {
+        scale.x = -scale.x;
+    }
+
+    int degenerate = -1;
+    int degenerateCount = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        if (std::fabs(scale[axis]) < kMinScale) {
+            basis[axis] = glm::mat3(1.0f)[axis];
+            degenerate = axis;
+            degenerateCount++;
+        }
+        else {
+            basis[axis] = basis[axis] / scale[axis];
+        }
+    }
+    if (degenerateCount > 1) {
+        return;
+    }
+    if (degenerateCount == 1) {
+        basis[degenerate] = glm::cross(basis[(degenerate + 1) % 3], basis[(degenerate + 2) % 3]);
+    }
+    rotation = glm::normalize(glm::quat_cast(basis));
+}
+
+/**
+ * @brief Transforms, one column per field
+ *
+ * `positions[i]`, `rotations[i]`, `scales[i]` and `worlds[i]` all belong to `entities()[i]`.
+ * Systems that only need positions touch only the positions array.
+ */
+class TransformStorage : public SparseSet {
+public:
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> worlds;      // written by Scene::updateTransforms
+
+    void add(Entity entity, const Transform& transform);
+
+    void remove(Entity entity);
+
+    void reserve(size_t count);
+};
+
+/**
+ * @brief Local bounds and the world-space boxes derived from them
+ */
+class BoundsStorage : public SparseSet {
+public:
+    std::vector<glm::vec3> centers;
+    std::vector<glm::vec3> extents;
+    std::vector<glm::vec3> worldMins;   // written by Scene::updateBounds
+    std::vector<glm::vec3> worldMaxs;
+
+    void add(Entity entity, const Bounds& bounds);
+
+    void remove(Entity entity);
+
+    void reserve(size_t count);
+};
+
+class RenderableStorage : public SparseSet {
+public:
+    std::vector<RenderableKind> kinds;
+    std::vector<Cube*> cubes;
+    std::vector<asset::Model*> models;
+    std::vector<asset::Shader*> shaders;
+    std::vector<uint8_t> visible;
+
+    void add(Entity entity, const Renderable& renderable);
+
+    void remove(Entity entity);
+
+    void reserve(size_t count);
+};
+
+#endif // !_COMPONENTS_H_
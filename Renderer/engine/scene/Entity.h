@@ -0,0 +1,27 @@
+#ifndef _ENTITY_H_
+#define _ENTITY_H_
+
+#include <cstdint>
+
+/**
+ * @brief Entity handle: a slot index and the generation of that slot
+ *
+ * Slots are recycled when entities are destroyed; the generation is bumped on every reuse
+ * so stale handles to a recycled slot no longer compare equal.
+ */
+using Entity = uint32_t;
+
+constexpr uint32_t kEntityIndexBits = 24;
+constexpr uint32_t kEntityIndexMask = (1u << kEntityIndexBits) - 1;
+constexpr uint32_t kEntityGenerationMask = 0xFFu;
+constexpr Entity kNullEntity = 0xFFFFFFFFu;
+
+inline uint32_t entity_index(Entity entity) { return entity & kEntityIndexMask; }
+
+inline uint32_t entity_generation(Entity entity) { return entity >> kEntityIndexBits; }
+
+inline Entity make_entity(uint32_t index, uint32_t generation) {
+    return (Entity)(((generation & kEntityGenerationMask) << kEntityIndexBits) | (index & kEntityIndexMask));
+}
+
+#endif // !_ENTITY_H_
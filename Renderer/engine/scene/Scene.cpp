@@ -0,0 +1,103 @@
+#include "Scene.h"
+
+#include "../core/Cube.hpp"
+#include "../math/BatchMath.h"
+
+Scene::Scene()
+    : m_generations(), m_freeSlots(), m_alive(0), m_transforms(), m_bounds(), m_renderables(),
+      m_boundsWorlds(), m_mvps()
+{}
+
+Scene::~Scene() {}
+
+Entity Scene::create() {
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        slot = (uint32_t)m_generations.size();
+        m_generations.push_back(0);
+    }
+
+    m_alive++;
+    return make_entity(slot, m_generations[slot]);
+}
+
+void Scene::destroy(Entity entity) {
+    if (!alive(entity)) {
+        return;
+    }
+
+    m_transforms.remove(entity);
+    m_bounds.remove(entity);
+    m_renderables.remove(entity);
+
+    uint32_t slot = entity_index(entity);
+    m_generations[slot] = (m_generations[slot] + 1) & kEntityGenerationMask;
+    m_freeSlots.push_back(slot);
+    m_alive--;
+}
+
+bool Scene::alive(Entity entity) const {
+    uint32_t slot = entity_index(entity);
+    return entity != kNullEntity && slot < m_generations.size() && m_generations[slot] == entity_generation(entity);
+}
+
+void Scene::reserve(size_t count) {
+    m_generations.reserve(count);
+    m_transforms.reserve(count);
+    m_bounds.reserve(count);
+    m_renderables.reserve(count);
+}
+
+void Scene::updateTransforms() {
+    compose_transform_batch(m_transforms.positions.data(), m_transforms.rotations.data(), m_transforms.scales.data(),
+                            m_transforms.worlds.data(), m_transforms.size());
+}
+
+void Scene::updateBounds() {
+    const size_t count = m_bounds.size();
+    const Entity* entities = m_bounds.entities();
+
+    // boxes and transforms are stored in different orders, look up each box's matrix once
+    m_boundsWorlds.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        m_boundsWorlds[i] = m_transforms.contains(entities[i]) ? m_transforms.index(entities[i]) : kNoWorld;
+    }
+
+    aabb_transform_batch(m_transforms.worlds.data(), m_boundsWorlds.data(), m_bounds.centers.data(), m_bounds.extents.data(),
+                         m_bounds.worldMins.data(), m_bounds.worldMaxs.data(), count);
+}
+
+void Scene::draw(const glm::mat4& view, const glm::mat4& projection) const {
+    const size_t count = m_renderables.size();
+    const Entity* entities = m_renderables.entities();
+    const glm::mat4 identity(1.0f);
+    const glm::mat4 viewProjection = projection * view;
+
+    // one MVP per transform, instead of three matrix products per vertex in the shader
+    m_mvps.resize(m_transforms.size());
+    mat4_mul_batch(viewProjection, m_transforms.worlds.data(), m_mvps.data(), m_mvps.size());
+
+    for (size_t i = 0; i < count; i++) {
+        if (!m_renderables.visible[i]) {
+            continue;
+        }
+
+        const bool hasTransform = m_transforms.contains(entities[i]);
+        const glm::mat4& world = hasTransform ? m_transforms.worlds[m_transforms.index(entities[i])] : identity;
+
+        if (m_renderables.kinds[i] == RenderableKind::Cube && m_renderables.cubes[i]) {
+            Cube& cube = *m_renderables.cubes[i];
+            cube.bindTexture();
+            cube.useShader();
+            cube.getShader().setUniform("mvp", hasTransform ? m_mvps[m_transforms.index(entities[i])] : viewProjection);
+            cube.draw();
+        }
+        else if (m_renderables.kinds[i] == RenderableKind::Model && m_renderables.models[i] && m_renderables.shaders[i]) {
+            _drawModel(*m_renderables.models[i], *m_renderables.shaders[i], world, view, projection);
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef _SCENE_H_
+#define _SCENE_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "Entity.h"
+#include "Components.h"
+
+/**
+ * @brief Entities and their components
+ *
+ * Each component type lives in its own sparse-set storage with the data split into
+ * per-field arrays (see Components.h). Systems are plain member functions that walk those
+ * arrays front to back.
+ *
+ *     Scene scene;
+ *     Entity e = scene.create();
+ *     scene.transforms().add(e, { position, rotation, scale });
+ *     scene.renderables().add(e, { RenderableKind::Cube, &cube });
+ *     ...
+ *     scene.updateTransforms();
+ *     scene.draw(view, projection);
+ */
+class Scene {
+public:
+    Scene();
+
+    Scene(const Scene& other) = delete;
+
+    Scene(Scene&& other) = default;
+
+    ~Scene();
+
+    Scene& operator=(const Scene& other) = delete;
+
+    Scene& operator=(Scene&& other) = default;
+
+    Entity create();
+
+    /**
+     * @brief Removes the entity and all of its components, its slot is recycled
+     */
+    void destroy(Entity entity);
+
+    bool alive(Entity entity) const;
+
+    size_t entityCount() const { return m_alive; }
+
+    /// Reserves room for `count` entities in every storage
+    void reserve(size_t count);
+
+    TransformStorage& transforms() { return m_transforms; }
+    const TransformStorage& transforms() const { return m_transforms; }
+
+    BoundsStorage& bounds() { return m_bounds; }
+    const BoundsStorage& bounds() const { return m_bounds; }
+
+    RenderableStorage& renderables() { return m_renderables; }
+    const RenderableStorage& renderables() const { return m_renderables; }
+
+    /**
+     * @brief Recomputes every world matrix from position, rotation and scale
+     */
+    void updateTransforms();
+
+    /**
+     * @brief Recomputes world-space boxes of entities that have both bounds and a transform
+     */
+    void updateBounds();
+
+    /**
+     * @brief Draws every visible renderable with its world matrix
+     *
+     * Cubes get a precomputed `mvp` uniform; models get `model`, `view` and `projection`.
+     */
+    void draw(const glm::mat4& view, const glm::mat4& projection) const;
+
+private:
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_freeSlots;
+    size_t m_alive;
+
+    TransformStorage m_transforms;
+    BoundsStorage m_bounds;
+    RenderableStorage m_renderables;
+
+    // scratch, reused every frame
+    std::vector<uint32_t> m_boundsWorlds;
+    mutable std::vector<glm::mat4> m_mvps;
+
+    // SceneModels.cpp, kept apart so the asset headers stay out of this translation unit
+    void _drawModel(asset::Model& model, asset::Shader& shader, const glm::mat4& world,
+                    const glm::mat4& view, const glm::mat4& projection) const;
+};
+
+#endif // !_SCENE_H_
@@ -0,0 +1,12 @@
+#include "Scene.h"
+
+#include "../asset/model.h"
+
+void Scene::_drawModel(asset::Model& model, asset::Shader& shader, const glm::mat4& world,
+                       const glm::mat4& view, const glm::mat4& projection) const
+{
+    shader.use();
+    shader.setMat4("view", view);
+    shader.setMat4("projection", projection);
+    model.Draw(shader, world);
+}
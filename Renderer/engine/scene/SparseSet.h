@@ -0,0 +1,126 @@
+#ifndef _SPARSE_SET_H_
+#define _SPARSE_SET_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Entity.h"
+
+/**
+ * @brief Moves the last element into `index` and drops the last slot
+ */
+template <typename T>
+inline void swap_remove(std::vector<T>& values, size_t index) {
+    if (index + 1 != values.size()) {
+        values[index] = std::move(values.back());
+    }
+    values.pop_back();
+}
+
+/**
+ * @brief Entity to dense index mapping
+ *
+ * `m_sparse` is indexed by entity slot and points into `m_dense`, which lists the entities
+ * that own a component, packed. Component storages derive from this and keep their data in
+ * columns parallel to `m_dense`, so iterating a component is a linear walk over arrays.
+ *
+ * Removal swaps the last element into the hole: dense order is not stable.
+ */
+class SparseSet {
+public:
+    static constexpr uint32_t kInvalid = 0xFFFFFFFFu;
+
+    bool contains(Entity entity) const {
+        uint32_t slot = entity_index(entity);
+        return slot < m_sparse.size() && m_sparse[slot] != kInvalid && m_dense[m_sparse[slot]] == entity;
+    }
+
+    /// Dense index of `entity`, which must be contained
+    uint32_t index(Entity entity) const { return m_sparse[entity_index(entity)]; }
+
+    size_t size() const { return m_dense.size(); }
+
+    bool empty() const { return m_dense.empty(); }
+
+    /// Owning entities, parallel to the component columns
+    const Entity* entities() const { return m_dense.data(); }
+
+protected:
+    /**
+     * @brief Appends `entity`, the caller appends one element to each column
+     *
+     * @return the new dense index
+     */
+    uint32_t _insert(Entity entity) {
+        uint32_t slot = entity_index(entity);
+        if (slot >= m_sparse.size()) {
+            m_sparse.resize(slot + 1, kInvalid);
+        }
+        m_sparse[slot] = (uint32_t)m_dense.size();
+        m_dense.push_back(entity);
+        return m_sparse[slot];
+    }
+
+    /**
+     * @brief Removes `entity`, the caller does `swap_remove(column, index)` on each column
+     *
+     * @return the dense index that was vacated
+     */
+    uint32_t _erase(Entity entity) {
+        uint32_t slot = entity_index(entity);
+        uint32_t index = m_sparse[slot];
+
+        Entity last = m_dense.back();
+        m_sparse[entity_index(last)] = index;
+        m_sparse[slot] = kInvalid;
+        swap_remove(m_dense, index);
+
+        return index;
+    }
+
+    void _reserve(size_t count) { m_dense.reserve(count); }
+
+    std::vector<uint32_t> m_sparse;
+    std::vector<Entity> m_dense;
+};
+
+/**
+ * @brief Sparse-set storage for a single component type, one packed array
+ */
+template <typename T>
+class ComponentPool : public SparseSet {
+public:
+    T& add(Entity entity, const T& value) {
+        if (contains(entity)) {
+            return m_values[index(entity)] = value;
+        }
+        _insert(entity);
+        m_values.push_back(value);
+        return m_values.back();
+    }
+
+    void remove(Entity entity) {
+        if (contains(entity)) {
+            swap_remove(m_values, _erase(entity));
+        }
+    }
+
+    T& get(Entity entity) { return m_values[index(entity)]; }
+
+    const T& get(Entity entity) const { return m_values[index(entity)]; }
+
+    T* data() { return m_values.data(); }
+
+    const T* data() const { return m_values.data(); }
+
+    void reserve(size_t count) {
+        _reserve(count);
+        m_values.reserve(count);
+    }
+
+private:
+    std::vector<T> m_values;
+};
+
+#endif // !_SPARSE_SET_H_
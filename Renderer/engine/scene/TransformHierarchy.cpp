@@ -0,0 +1,201 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+#include "Components.h"
+#include "../core/ThreadPool.h"
+
+TransformHierarchy::TransformHierarchy()
+    : m_recomputed(0),
+      m_updatedSubtrees(0)
+{
+}
+
+uint32_t TransformHierarchy::add(uint32_t parent, const glm::mat4& local) {
+    uint32_t node = parent == kNoParent ? (uint32_t)size() : m_ends[parent];
+
+    // everything from `node` on moves up one slot; a no-op when appending
+    for (uint32_t& p : m_parents) {
+        if (p != kNoParent && p >= node) {
+            p++;
+        }
+    }
+    for (uint32_t& end : m_ends) {
+        if (end > node) {
+            end++;
+        }
+    }
+    for (uint32_t& d : m_dirtyNodes) {
+        if (d >= node) {
+            d++;
+        }
+    }
+
+    // ancestors whose subtree ended right where the node goes now end after it
+    for (uint32_t p = parent; p != kNoParent; p = m_parents[p]) {
+        if (m_ends[p] == node) {
+            m_ends[p]++;
+        }
+    }
+
+    m_parents.insert(m_parents.begin() + node, parent);
+    m_ends.insert(m_ends.begin() + node, node + 1);
+    m_locals.insert(m_locals.begin() + node, local);
+    m_worlds.insert(m_worlds.begin() + node, glm::mat4(1.0f));
+    m_dirty.insert(m_dirty.begin() + node, 0);
+    _markDirty(node);
+    return node;
+}
+
+void TransformHierarchy::reserve(size_t count) {
+    m_parents.reserve(count);
+    m_ends.reserve(count);
+    m_locals.reserve(count);
+    m_worlds.reserve(count);
+    m_dirty.reserve(count);
+}
+
+void TransformHierarchy::clear() {
+    m_parents.clear();
+    m_ends.clear();
+    m_locals.clear();
+    m_worlds.clear();
+    m_dirty.clear();
+    m_dirtyNodes.clear();
+    m_recomputed = 0;
+    m_updatedSubtrees = 0;
+}
+
+void TransformHierarchy::setLocal(uint32_t node, const glm::mat4& local) {
+    m_locals[node] = local;
+    _markDirty(node);
+}
+
+void TransformHierarchy::setLocal(uint32_t node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    setLocal(node, compose_transform(position, rotation, scale));
+}
+
+void TransformHierarchy::_markDirty(uint32_t node) {
+    if (!m_dirty[node]) {
+        m_dirty[node] = 1;
+        m_dirtyNodes.push_back(node);
+    }
+}
+
+void TransformHierarchy::_collectRanges() {
+    m_ranges.clear();
+
+    // a dirty node inside an earlier dirty subtree is recomputed with it
+    if (m_dirtyNodes.size() > size() / 16) {
+        // most of the tree changed: scanning the flags beats sorting the list
+        for (uint32_t node = 0; node < size();) {
+            if (m_dirty[node]) {
+                m_ranges.push_back({ node, m_ends[node] });
+                std::fill(m_dirty.begin() + node, m_dirty.begin() + m_ends[node], 0);
+                node = m_ends[node];
+            }
+            else {
+                node++;
+            }
+        }
+    }
+    else {
+        std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+
+        uint32_t covered = 0;
+        for (uint32_t node : m_dirtyNodes) {
+            m_dirty[node] = 0;
+            if (node < covered) {
+                continue;
+            }
+            m_ranges.push_back({ node, m_ends[node] });
+            covered = m_ends[node];
+        }
+    }
+    m_dirtyNodes.clear();
+    m_updatedSubtrees = m_ranges.size();
+}
+
+void TransformHierarchy::_updateNode(uint32_t node) {
+    uint32_t parent = m_parents[node];
+    m_worlds[node] = parent == kNoParent ? m_locals[node] : m_worlds[parent] * m_locals[node];
+}
+
+void TransformHierarchy::_updateRange(uint32_t begin, uint32_t end) {
+    // depth first order: the parent is either outside the range (and clean) or already done
+    for (uint32_t node = begin; node < end; node++) {
+        _updateNode(node);
+    }
+}
+
+void TransformHierarchy::update() {
+    if (m_dirtyNodes.empty()) {
+        m_recomputed = 0;
+        m_updatedSubtrees = 0;
+        return;
+    }
+
+    _collectRanges();
+
+    size_t count = 0;
+    for (const Range& range : m_ranges) {
+        _updateRange(range.begin, range.end);
+        count += range.end - range.begin;
+    }
+    m_recomputed = count;
+}
+
+void TransformHierarchy::update(ThreadPool& pool) {
+    if (m_dirtyNodes.empty()) {
+        m_recomputed = 0;
+        m_updatedSubtrees = 0;
+        return;
+    }
+
+    _collectRanges();
+
+    size_t count = 0;
+    for (const Range& range : m_ranges) {
+        count += range.end - range.begin;
+    }
+    m_recomputed = count;
+
+    if (pool.threadCount() == 1 || count < 2 * kParallelGrain) {
+        for (const Range& range : m_ranges) {
+            _updateRange(range.begin, range.end);
+        }
+        return;
+    }
+
+    // split the biggest subtree until there is enough to go around: its root is resolved
+    // here, its children become independent ranges
+    const size_t target = (size_t)pool.threadCount() * 4;
+    for (int splits = 0; m_ranges.size() < target && splits < 256; splits++) {
+        auto largest = std::max_element(m_ranges.begin(), m_ranges.end(), [](const Range& a, const Range& b) {
+            return a.end - a.begin < b.end - b.begin;
+        });
+        if (largest->end - largest->begin <= kParallelGrain) {
+            break;
+        }
+
+        Range range = *largest;
+        *largest = m_ranges.back();
+        m_ranges.pop_back();
+
+        _updateNode(range.begin);
+        for (uint32_t child = range.begin + 1; child < range.end; child = m_ends[child]) {
+            m_ranges.push_back({ child, m_ends[child] });
+        }
+    }
+
+    // biggest first so the tail of the loop is made of small pieces
+    std::sort(m_ranges.begin(), m_ranges.end(), [](const Range& a, const Range& b) {
+        return a.end - a.begin > b.end - b.begin;
+    });
+
+    pool.parallelFor(m_ranges.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            _updateRange(m_ranges[i].begin, m_ranges[i].end);
+        }
+    });
+}
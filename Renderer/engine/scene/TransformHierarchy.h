@@ -0,0 +1,110 @@
+#ifndef _TRANSFORM_HIERARCHY_H_
+#define _TRANSFORM_HIERARCHY_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief Parent/child transforms stored depth first
+ *
+ * Every node sits before its descendants and a node's subtree is the contiguous range
+ * [i, subtreeEnd(i)), so one front-to-back pass sees every parent before its children.
+ * Changing a local transform marks the node dirty; `update` recomputes the world matrices
+ * of dirty subtrees only and leaves the rest of the arrays alone.
+ *
+ * Nodes are addressed by position. `add` inserts at the end of the parent's subtree, which
+ * is an append when the hierarchy is built depth first (as Model does), and otherwise
+ * shifts every later node up by one.
+ */
+class TransformHierarchy {
+public:
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    /// Subtrees smaller than this are not worth handing to another thread
+    static constexpr size_t kParallelGrain = 1024;
+
+    TransformHierarchy();
+
+    /**
+     * @brief Adds a node under `parent` (or a new root for kNoParent) and returns its index
+     */
+    uint32_t add(uint32_t parent, const glm::mat4& local);
+
+    void reserve(size_t count);
+
+    void clear();
+
+    size_t size() const { return m_locals.size(); }
+
+    uint32_t parent(uint32_t node) const { return m_parents[node]; }
+
+    /// One past the last node of `node`'s subtree
+    uint32_t subtreeEnd(uint32_t node) const { return m_ends[node]; }
+
+    const glm::mat4& local(uint32_t node) const { return m_locals[node]; }
+
+    /// Valid for nodes that were not changed since the last `update`
+    const glm::mat4& world(uint32_t node) const { return m_worlds[node]; }
+
+    const std::vector<glm::mat4>& worlds() const { return m_worlds; }
+
+    void setLocal(uint32_t node, const glm::mat4& local);
+
+    void setLocal(uint32_t node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+    bool dirty(uint32_t node) const { return m_dirty[node] != 0; }
+
+    bool hasDirty() const { return !m_dirtyNodes.empty(); }
+
+    /**
+     * @brief Recomputes the world matrices of every dirty node and its descendants
+     */
+    void update();
+
+    /**
+     * @brief Same as `update`, with independent subtrees spread over the pool
+     *
+     * Large subtrees are split by resolving their root first and handing out the child
+     * subtrees, so a single moved root still keeps every thread busy.
+     */
+    void update(ThreadPool& pool);
+
+    /// World matrices recomputed by the last update
+    size_t recomputed() const { return m_recomputed; }
+
+    /// Subtrees the last update started from
+    size_t updatedSubtrees() const { return m_updatedSubtrees; }
+
+private:
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_ends;
+    std::vector<glm::mat4> m_locals;
+    std::vector<glm::mat4> m_worlds;
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint32_t> m_dirtyNodes;     // unordered, each node at most once
+    std::vector<Range> m_ranges;            // scratch, kept to avoid reallocating per frame
+    size_t m_recomputed;
+    size_t m_updatedSubtrees;
+
+    void _markDirty(uint32_t node);
+
+    /// Turns the dirty list into disjoint subtree ranges and clears the flags
+    void _collectRanges();
+
+    void _updateRange(uint32_t begin, uint32_t end);
+
+    void _updateNode(uint32_t node);
+};
+
+#endif // !_TRANSFORM_HIERARCHY_H_
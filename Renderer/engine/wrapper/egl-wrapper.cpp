@@ -0,0 +1,286 @@
+#include "egl-wrapper.h"
+
+#ifdef HEADLESS_ENABLED
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "../opengl/Framebuffer.h"
+#include "../opengl/log.h"
+
+EGLWrapper::EGLWrapper(const EGLWrapperConfig& config, int width, int height, const std::string& title)
+    : m_display(EGL_NO_DISPLAY),
+      m_context(EGL_NO_CONTEXT),
+      m_framebuffer(),
+      m_config(config),
+      m_width(width),
+      m_height(height),
+      m_frame(0),
+      m_shouldClose(false),
+      m_initialized(false),
+      m_title(title)
+{
+    if (m_config.outputInterval == 0) {
+        m_config.outputInterval = 1;
+    }
+
+    if (!_createDisplay()) {
+        std::cerr << "Failed to open an EGL display" << std::endl;
+        return;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL: desktop OpenGL is not supported" << std::endl;
+        return;
+    }
+
+    // the window system never sees this config, it only has to describe the context
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig eglConfig;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(m_display, configAttribs, &eglConfig, 1, &numConfigs) || numConfigs == 0) {
+        std::cerr << "EGL: no matching framebuffer config" << std::endl;
+        return;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, config.majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, config.minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        config.coreProfile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    m_context = eglCreateContext(m_display, eglConfig, EGL_NO_CONTEXT, contextAttribs);
+    if (m_context == EGL_NO_CONTEXT) {
+        std::cerr << "EGL: failed to create an OpenGL " << (int)config.majorVersion << "." << (int)config.minorVersion
+                  << " context (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return;
+    }
+
+    m_initialized = true;
+}
+
+EGLWrapper::~EGLWrapper() {
+    destroy();
+}
+
+bool EGLWrapper::_createDisplay() {
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        // prefer a real device; Mesa's surfaceless platform covers GPU-less CI machines
+        auto queryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+        if (queryDevices) {
+            EGLDeviceEXT devices[8];
+            EGLint count = 0;
+            if (queryDevices(8, devices, &count) && count > 0) {
+                display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[0], nullptr);
+            }
+        }
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+        if (display == EGL_NO_DISPLAY) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+#endif
+    }
+
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        return false;
+    }
+
+    gl_log("EGL %d.%d, vendor %s\n", major, minor, eglQueryString(display, EGL_VENDOR));
+    m_display = display;
+    return true;
+}
+
+bool EGLWrapper::initialized() const {
+    return m_initialized;
+}
+
+void EGLWrapper::destroy() {
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    if (m_context != EGL_NO_CONTEXT) {
+        // the framebuffer's GL objects need the context
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context);
+        m_framebuffer.reset();
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+
+    eglTerminate(m_display);
+    m_display = EGL_NO_DISPLAY;
+    m_initialized = false;
+}
+
+bool EGLWrapper::shouldClose() const {
+    return m_shouldClose || (m_config.frameCount > 0 && m_frame >= m_config.frameCount);
+}
+
+void EGLWrapper::setShouldClose(bool value) {
+    m_shouldClose = value;
+}
+
+void EGLWrapper::swapBuffers() {
+    if (!m_framebuffer) {
+        return;
+    }
+
+    if (!m_config.outputDirectory.empty() && m_frame % m_config.outputInterval == 0) {
+        _writeFrame();
+    }
+    m_frame++;
+
+    // nothing is presented, the next frame renders into the same target
+    m_framebuffer->bind();
+}
+
+void EGLWrapper::pollEvents() {
+}
+
+std::pair<int, int> EGLWrapper::getSize() const {
+    return std::make_pair(m_width, m_height);
+}
+
+void EGLWrapper::setSize(int width, int height) {
+    m_width = width;
+    m_height = height;
+    if (m_framebuffer) {
+        m_framebuffer->resize(width, height);
+        m_framebuffer->bind();
+    }
+}
+
+std::pair<int, int> EGLWrapper::getFramebufferSize() const {
+    return std::make_pair(m_width, m_height);
+}
+
+void* EGLWrapper::getWindow() const {
+    return m_context;
+}
+
+void EGLWrapper::setTitle(const std::string& title) {
+    m_title = title;
+}
+
+std::string EGLWrapper::getTitle() const {
+    return m_title;
+}
+
+void EGLWrapper::makeContextCurrent() {
+    if (!m_initialized) {
+        return;
+    }
+
+    // EGL_KHR_surfaceless_context: no pbuffer, everything goes to the offscreen target
+    if (!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+        std::cerr << "EGL: surfaceless contexts are not supported (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        m_initialized = false;
+        return;
+    }
+
+    if (m_framebuffer) {
+        m_framebuffer->bind();
+        return;
+    }
+
+    // the framebuffer needs GL entry points before OpenGLApp gets to load them
+    glewExperimental = GL_TRUE;
+    GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY) {
+        status = GLEW_OK;
+    }
+#endif
+    if (status != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        m_initialized = false;
+        return;
+    }
+
+    FramebufferConfig config{};
+    config.width = m_width;
+    config.height = m_height;
+    config.colorAttachments = { Framebuffer::rgba8() };
+    config.depth = true;
+    config.depthFormat = GL_DEPTH24_STENCIL8;
+
+    m_framebuffer = std::make_unique<Framebuffer>();
+    if (!m_framebuffer->create(config)) {
+        std::cerr << "Failed to create the offscreen framebuffer" << std::endl;
+        m_initialized = false;
+        return;
+    }
+    m_framebuffer->bind();
+}
+
+unsigned int EGLWrapper::defaultFramebuffer() const {
+    return m_framebuffer ? m_framebuffer->id() : 0;
+}
+
+uint64_t EGLWrapper::frame() const {
+    return m_frame;
+}
+
+bool EGLWrapper::_writeFrame() const {
+    std::vector<unsigned char> rgba;
+    if (!m_framebuffer->readPixels(rgba)) {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_config.outputDirectory, error);
+
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%05llu.ppm", (unsigned long long)m_frame);
+    std::string path = (std::filesystem::path(m_config.outputDirectory) / name).string();
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        gl_log_err("ERROR: could not open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    // PPM rows go top to bottom, GL rows bottom to top
+    fprintf(file, "P6\n%d %d\n255\n", m_width, m_height);
+    std::vector<unsigned char> row((size_t)m_width * 3);
+    for (int y = m_height - 1; y >= 0; y--) {
+        const unsigned char* src = rgba.data() + (size_t)y * m_width * 4;
+        for (int x = 0; x < m_width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        fwrite(row.data(), 1, row.size(), file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+#endif // HEADLESS_ENABLED
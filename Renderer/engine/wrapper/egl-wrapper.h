@@ -0,0 +1,107 @@
+#ifndef _EGL_WRAPPER_H_
+#define _EGL_WRAPPER_H_
+
+#ifdef HEADLESS_ENABLED
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+class Framebuffer;
+
+struct EGLWrapperConfig {
+    uint8_t majorVersion;
+    uint8_t minorVersion;
+    bool coreProfile;
+    uint64_t frameCount;            // shouldClose() turns true after this many frames, 0 runs until told otherwise
+    std::string outputDirectory;    // frames are written here as PPM, empty disables writing
+    unsigned int outputInterval;    // write every n-th frame
+};
+
+/**
+ * @brief Headless window handler
+ *
+ * Drop-in replacement for `GLFWWrapper` in `Window<WindowHandler, Config>`: a surfaceless
+ * EGL context (no display server needed) rendering into an offscreen framebuffer of the
+ * requested size. `swapBuffers` optionally reads the frame back and writes it to disk,
+ * there is no vsync so frames run as fast as the GPU allows.
+ *
+ * The offscreen framebuffer is the "default framebuffer" of this window: it is bound when
+ * the context is made current and after every swap, passes that render to the screen
+ * should bind `defaultFramebuffer()` instead of 0.
+ */
+class EGLWrapper {
+public:
+    using WindowType = void;
+    using WindowPtr = void*;
+    using ConfigType = EGLWrapperConfig;
+
+
+    EGLWrapper(const EGLWrapperConfig& config, int width, int height, const std::string& title);
+
+    EGLWrapper(const EGLWrapper& other) = delete;
+
+    EGLWrapper(EGLWrapper&& other) = delete;
+
+    ~EGLWrapper();
+
+    EGLWrapper& operator=(const EGLWrapper& other) = delete;
+
+    EGLWrapper& operator=(EGLWrapper&& other) = delete;
+
+    bool initialized() const;
+
+    void destroy();
+
+    bool shouldClose() const;
+
+    void setShouldClose(bool value);
+
+    void swapBuffers();
+
+    void pollEvents();
+
+    std::pair<int, int> getSize() const;
+
+    void setSize(int width, int height);
+
+    std::string getTitle() const;
+
+    void setTitle(const std::string& title);
+
+    /// The EGL context, there is no native window
+    void* getWindow() const;
+
+    std::pair<int, int> getFramebufferSize() const;
+
+    /**
+     * @brief Makes the context current, loads GL entry points and binds the offscreen target
+     */
+    void makeContextCurrent();
+
+    unsigned int defaultFramebuffer() const;
+
+    /// Frames presented so far
+    uint64_t frame() const;
+
+private:
+    bool _createDisplay();
+
+    bool _writeFrame() const;
+
+    void* m_display;
+    void* m_context;
+    std::unique_ptr<Framebuffer> m_framebuffer;
+    EGLWrapperConfig m_config;
+    int m_width;
+    int m_height;
+    uint64_t m_frame;
+    bool m_shouldClose;
+    bool m_initialized;
+    std::string m_title;
+};
+
+#endif // HEADLESS_ENABLED
+
+#endif // !_EGL_WRAPPER_H_
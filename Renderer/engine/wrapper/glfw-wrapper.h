@@ -66,6 +66,9 @@ public:
 
     void makeContextCurrent();
 
+    /// Framebuffer that ends up on screen
+    unsigned int defaultFramebuffer() const { return 0; }
+
 private:
     GLFWwindow* m_window;
     bool m_initialized;
@@ -1,11 +1,21 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <vector>
 
 // Engine Window Wrapper
 #include "engine/wrapper/glfw-wrapper.h"
+#include "engine/wrapper/egl-wrapper.h"
 
 // OpenGL
 #include "engine/opengl/OpenGLApp.h"
 #include "engine/opengl/OpenGLPipeline.h"
+#include "engine/opengl/GpuProfiler.h"
+#include "engine/opengl/RenderTargetPool.h"
 
 // Engine Gui
 #include "engine/Gui/gui.h"
@@ -19,10 +29,20 @@
 #include "engine/core/Mesh.h"
 #include "engine/core/Cube.hpp"
 #include "engine/core/Camera.hpp"
+#include "engine/core/Profiler.h"
+#include "engine/core/FrameStats.h"
+#include "engine/core/FramePipeline.h"
+#include "engine/core/JobSystem.h"
+#include "engine/core/FrameArena.h"
+#include "engine/core/Memory.h"
+
+// Engine Render
+#include "engine/render/DynamicResolution.h"
+#include "engine/render/PostProcess.h"
+#include "engine/render/RenderGraph.h"
 
 // tests
-#include "apps/TestClearColor.h"
-#include "apps/TestTexture2D.h"
+#include "apps/TestApp.h"
 
 // GLM
 #include <glm/glm.hpp>
@@ -42,9 +62,363 @@ using Colorf = Color<float>;
 float deltaTime = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
 
-int main()
+struct Options {
+    bool headless = false;
+    bool pipelined = false;
+    bool post = true;
+    uint64_t frames = 600;
+    std::string test;
+    std::string output;
+    std::string memoryReport;
+    std::string graphDot;
+    float targetMs = 0.0f;          // dynamic resolution off when 0
+    float renderScale = 1.0f;
+    unsigned int outputInterval = 1;
+    int width = SCR_WIDTH;
+    int height = SCR_HEIGHT;
+};
+
+static void print_usage(const char* program) {
+    std::cout << "usage: " << program << " [--headless] [--pipelined] [--no-post] [--test NAME] [--frames N] [--output DIR] [--every N]\n"
+              << "       [--size WxH] [--memory-report FILE] [--graph-dot FILE] [--dynamic-res MS] [--render-scale S]\n"
+              << "  --headless    render offscreen through EGL, no window or display server\n"
+              << "  --pipelined   update the next frame on a worker while rendering this one\n"
+              << "  --no-post     render straight into the default framebuffer, no post-processing\n"
+              << "  --test NAME   test to run headless\n"
+              << "  --frames N    frames to render headless, at a fixed 1/60 s step (default 600)\n"
+              << "  --output DIR  write frames to DIR as PPM\n"
+              << "  --every N     only write every N-th frame\n"
+              << "  --size WxH    offscreen target size\n"
+              << "  --memory-report FILE  write live, peak and allocated bytes per tag as JSON at exit\n"
+              << "  --graph-dot FILE      write the last frame's render graph as Graphviz DOT\n"
+              << "  --dynamic-res MS      scale the scene resolution to hold MS of GPU time per frame\n"
+              << "  --render-scale S      render the scene at S times the target size and upscale it" << std::endl;
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "--headless")) {
+            options.headless = true;
+        }
+        else if (!strcmp(arg, "--pipelined")) {
+            options.pipelined = true;
+        }
+        else if (!strcmp(arg, "--no-post")) {
+            options.post = false;
+        }
+        else if (!strcmp(arg, "--test") && hasValue) {
+            options.test = argv[++i];
+        }
+        else if (!strcmp(arg, "--frames") && hasValue) {
+            options.frames = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(arg, "--output") && hasValue) {
+            options.output = argv[++i];
+        }
+        else if (!strcmp(arg, "--memory-report") && hasValue) {
+            options.memoryReport = argv[++i];
+        }
+        else if (!strcmp(arg, "--graph-dot") && hasValue) {
+            options.graphDot = argv[++i];
+        }
+        else if (!strcmp(arg, "--dynamic-res") && hasValue) {
+            options.targetMs = strtof(argv[++i], nullptr);
+            if (options.targetMs <= 0.0f) {
+                std::cerr << "Invalid frame time " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--render-scale") && hasValue) {
+            options.renderScale = strtof(argv[++i], nullptr);
+            if (options.renderScale <= 0.0f || options.renderScale > 1.0f) {
+                std::cerr << "Invalid render scale " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--every") && hasValue) {
+            options.outputInterval = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(arg, "--size") && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0) {
+                std::cerr << "Invalid size " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Declares the frame: the test renders into the HDR scene target, post-processing takes it to `display`
+ *
+ * Scene and post-processing run at the scale `resolution` picked, the upscale pass takes
+ * their result to the `width` x `height` display; at scale 1 there is no upscale. Without
+ * post-processing the test renders straight into `display`, or into a target the upscale
+ * reads when scaled. `drawTest` clears the target it finds bound and draws the test; it runs
+ * when the graph executes.
+ */
+static void build_frame_graph(RenderGraph& graph, PostProcessor& post, DynamicResolution& resolution, Upscaler& upscaler,
+                              GLuint display, int width, int height, std::function<void()> drawTest)
+{
+    graph.reset();
+    const RenderGraphResource window = graph.importTarget("display", display, width, height);
+    const int renderWidth = upscaler.initialized() ? resolution.renderWidth(width) : width;
+    const int renderHeight = upscaler.initialized() ? resolution.renderHeight(height) : height;
+    const bool scaled = renderWidth != width || renderHeight != height;
+
+    RenderGraphResource scene = window;
+    if (post.initialized()) {
+        scene = graph.createTexture("scene", { renderWidth, renderHeight, GL_RGBA16F, GL_DEPTH24_STENCIL8, GL_LINEAR });
+    }
+    else if (scaled) {
+        scene = graph.createTexture("scene", { renderWidth, renderHeight, GL_RGBA8, GL_DEPTH24_STENCIL8, GL_LINEAR });
+    }
+
+    const RenderGraphPass test = graph.addPass("test", [scene, drawTest = std::move(drawTest)](const RenderGraph& frame) {
+        frame.bindTarget(scene);
+        drawTest();
+    });
+    graph.write(test, scene, ResourceAccess::Attachment);
+
+    // what the display shows, at the render scale
+    RenderGraphResource image = scene;
+    if (post.initialized()) {
+        image = scaled ? graph.createTexture("post output", { renderWidth, renderHeight, GL_RGBA8, 0, GL_LINEAR }) : window;
+        const RenderGraphPass postPass = graph.addPass("post-processing", [scene, image, &post](const RenderGraph& frame) {
+            post.render(*frame.target(scene), frame.framebuffer(image), frame.width(image), frame.height(image), frame.pool());
+        });
+        graph.read(postPass, scene, ResourceAccess::Sampled);
+        graph.write(postPass, image, ResourceAccess::Attachment);
+    }
+
+    if (scaled) {
+        const RenderGraphPass upscale = graph.addPass("upscale", [image, display, width, height, &resolution, &upscaler](const RenderGraph& frame) {
+            const DynamicResolutionSettings& settings = resolution.settings();
+            upscaler.render(frame.texture(image), frame.width(image), frame.height(image), display, width, height,
+                            settings.filter, settings.sharpness);
+        });
+        graph.read(upscale, image, ResourceAccess::Sampled);
+        graph.write(upscale, window, ResourceAccess::Attachment);
+    }
+}
+
+#ifdef HEADLESS_ENABLED
+/**
+ * @brief Runs one test offscreen for a fixed number of frames with a fixed time step
+ * 
+ * No GUI, no vsync: frames go as fast as the GPU allows, which makes the CPU frame times
+ * comparable between runs. The same frame stats and profiler output as the windowed path
+ * are written at the end.
+ */
+static int run_headless(const Options& options)
 {
-    assert(restart_gl_log());
+    EGLWrapperConfig egl_config{};
+    // 4.5 rather than 4.6: software rasterizers on CI machines (llvmpipe) stop there
+    egl_config.majorVersion = 4;
+    egl_config.minorVersion = 5;
+    egl_config.coreProfile = true;
+    egl_config.frameCount = options.frames;
+    egl_config.outputDirectory = options.output;
+    egl_config.outputInterval = options.outputInterval;
+
+    Window<EGLWrapper, EGLWrapperConfig> window(egl_config, options.width, options.height, "LearnOpenGL");
+    window.makeContextCurrent();
+    if (!window.initialized()) {
+        std::cerr << "Failed to create a headless context" << std::endl;
+        return -1;
+    }
+
+    OpenGLApp app({ true, GL_LESS, false, GL_BACK, true, true });
+    if (!app.initialized()) {
+        std::cerr << "Failed to initialize OpenGLApp" << std::endl;
+        return -1;
+    }
+
+    Profiler::get().setThreadName("Main");
+    if (!GpuProfiler::get().init()) {
+        std::cerr << "GPU profiling unavailable" << std::endl;
+    }
+
+    RenderTargetPool renderTargets;
+    RenderGraph frameGraph(renderTargets);
+    PostProcessor post;
+    if (options.post && !post.init()) {
+        std::cerr << "Post-processing unavailable" << std::endl;
+    }
+    DynamicResolution resolution;
+    Upscaler upscaler;
+    resolution.settings().enabled = options.targetMs > 0.0f;
+    resolution.settings().targetMs = options.targetMs;
+    resolution.settings().scale = options.renderScale;
+    resolution.settings().minScale = std::min(resolution.settings().minScale, options.renderScale);
+    if ((options.targetMs > 0.0f || options.renderScale < 1.0f) && (!resolution.init() || !upscaler.init())) {
+        std::cerr << "Dynamic resolution unavailable" << std::endl;
+    }
+
+    test::TestApp* currentTest = nullptr;
+    test::TestMenu testMenu(currentTest);
+    test::registerTests(testMenu);
+
+    currentTest = testMenu.create(options.test);
+    if (!currentTest) {
+        std::cerr << "Unknown test '" << options.test << "', available tests:" << std::endl;
+        for (const auto& name : testMenu.names()) {
+            std::cerr << "  " << name << std::endl;
+        }
+        return -1;
+    }
+
+    const float step = 1.0f / 60.0f;
+    FrameStats frameStats;
+    FramePipeline pipeline(JobSystem::get());
+    pipeline.setEnabled(options.pipelined);
+    double updateMs = 0.0, waitMs = 0.0;
+    uint64_t allocations = 0, lastAllocations = 0;
+    size_t arenaBytes = 0;
+    uint64_t targetsAllocated = 0, targetsReused = 0;
+    std::vector<double> passCpuMs, passGpuMs;
+    double scaleSum = 0.0;
+    float scaleMin = 1.0f;
+
+    while (!window.shouldClose())
+    {
+        AllocationCounters before = Memory::counters();
+        auto frameStart = std::chrono::steady_clock::now();
+        Profiler::get().beginFrame();
+        GpuProfiler::get().beginFrame(Profiler::get().frameIndex());
+
+        renderTargets.beginFrame();
+        build_frame_graph(frameGraph, post, resolution, upscaler, window.defaultFramebuffer(), options.width, options.height, [&]() {
+            app.setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            app.clear();
+            test::runFrame(*currentTest, pipeline, step);
+        });
+        resolution.beginFrame();
+        frameGraph.execute();
+        resolution.endFrame();
+        scaleSum += resolution.stats().scale;
+        scaleMin = std::min(scaleMin, resolution.stats().scale);
+        passCpuMs.resize(std::max(passCpuMs.size(), frameGraph.passCount()));
+        passGpuMs.resize(passCpuMs.size());
+        for (size_t i = 0; i < frameGraph.passCount(); i++) {
+            passCpuMs[i] += frameGraph.pass(i).cpuMs;
+            passGpuMs[i] += frameGraph.pass(i).gpuMs;
+        }
+        targetsAllocated += renderTargets.frameStats().allocatedBytes;
+        targetsReused += renderTargets.frameStats().reusedBytes;
+
+        GpuProfiler::get().endFrame();
+
+        {
+            PROFILE_SCOPE("swapBuffers");
+            window.swapBuffers();
+        }
+
+        Profiler::get().endFrame();
+        frameStats.record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        updateMs += pipeline.updateMs();
+        waitMs += pipeline.waitMs();
+        lastAllocations = Memory::delta(before, Memory::counters()).allocations;
+        allocations += lastAllocations;
+        arenaBytes += FrameArena::get().lastFrameBytes();
+    }
+
+    // GL objects of the test go before the context does
+    pipeline.sync();
+    delete currentTest;
+    GpuProfiler::get().shutdown();
+
+    FrameStatsSummary summary = frameStats.summary();
+    printf("%s%s: %llu frames, mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+        options.test.c_str(), options.pipelined ? " (pipelined)" : "", (unsigned long long)frameStats.totalFrames(),
+        summary.mean, summary.p50, summary.p95, summary.p99, frameStats.worstFrame());
+    if (options.pipelined && frameStats.totalFrames() > 0) {
+        // the update time the render thread did not wait for is what pipelining won
+        printf("update %.3f ms/frame, render thread waited %.3f ms/frame for it\n",
+            updateMs / frameStats.totalFrames(), waitMs / frameStats.totalFrames());
+    }
+    if (frameStats.totalFrames() > 0) {
+        // steady state should not touch the heap: transient data goes to the FrameArena
+        printf("heap %.2f allocations/frame (%llu in the last frame), frame arena %.1f KB/frame\n",
+            (double)allocations / frameStats.totalFrames(), (unsigned long long)lastAllocations,
+            arenaBytes / 1024.0 / frameStats.totalFrames());
+    }
+    if (post.initialized() && frameStats.totalFrames() > 0) {
+        // after the first frame every target should come from the pool
+        printf("render targets %.2f MB allocated, %.2f MB reused per frame, %.2f MB held by the pool\n",
+            targetsAllocated / 1048576.0 / frameStats.totalFrames(), targetsReused / 1048576.0 / frameStats.totalFrames(),
+            renderTargets.byteSize() / 1048576.0);
+    }
+    if (frameStats.totalFrames() > 0) {
+        // GPU times lag a frame or two, the first frames count as 0
+        const RenderGraphStats& graph = frameGraph.stats();
+        printf("render graph: %u passes, %u culled, %u barriers, transients %.2f MB, %.2f MB aliased\n", graph.passes,
+            graph.culled, graph.barriers, graph.transientBytes / 1048576.0, graph.aliasedBytes / 1048576.0);
+        for (size_t i = 0; i < frameGraph.passCount(); i++) {
+            printf("  %-16s %.3f ms CPU, %.3f ms GPU per frame\n", frameGraph.pass(i).name,
+                passCpuMs[i] / frameStats.totalFrames(), passGpuMs[i] / frameStats.totalFrames());
+        }
+    }
+    if (upscaler.initialized() && frameStats.totalFrames() > 0) {
+        const DynamicResolutionStats& scaling = resolution.stats();
+        if (resolution.settings().enabled) {
+            printf("dynamic resolution: target %.2f ms, scale %.2f at the end (mean %.2f, min %.2f), %u changes\n",
+                resolution.settings().targetMs, scaling.scale, scaleSum / frameStats.totalFrames(), scaleMin, scaling.changes);
+        }
+        else {
+            printf("render scale %.2f\n", scaling.scale);
+        }
+        printf("  %dx%d upscaled (%s), last GPU frame %.3f ms at scale %.2f, %.3f ms estimated at full resolution\n",
+            scaling.width, scaling.height, upscale_filter_name(resolution.settings().filter), scaling.gpuMs, scaling.gpuScale,
+            scaling.fullMs);
+    }
+    if (!options.graphDot.empty() && !frameGraph.writeDot(options.graphDot)) {
+        std::cerr << "Failed to write " << options.graphDot << std::endl;
+    }
+
+    const MemorySnapshot memory = Memory::snapshot();
+    const MemoryTagStats& cpu = memory.cpu[MemorySnapshot::kTags];
+    const MemoryTagStats& gpu = memory.gpu[MemorySnapshot::kTags];
+    printf("memory peak: cpu %.2f MB, gpu %.2f MB (%.2f MB textures, %.2f MB meshes)\n",
+        cpu.peakBytes / 1048576.0, gpu.peakBytes / 1048576.0,
+        memory.gpu[(size_t)MemoryTag::Texture].peakBytes / 1048576.0, memory.gpu[(size_t)MemoryTag::Mesh].peakBytes / 1048576.0);
+    if (!options.memoryReport.empty() && !Memory::writeReport(options.memoryReport.c_str(), frameStats.totalFrames())) {
+        std::cerr << "Failed to write " << options.memoryReport << std::endl;
+    }
+
+    frameStats.writeCsv("frame_times.csv");
+    frameStats.appendSummaryCsv("frame_stats.csv", "glrenderer-headless:" + options.test + (options.pipelined ? ":pipelined" : ""));
+
+    return 0;
+}
+#endif // HEADLESS_ENABLED
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if (!restart_gl_log()) {
+        std::cerr << "Failed to open log file " << GL_LOG_FILE << std::endl;
+    }
+
+    if (options.headless) {
+#ifdef HEADLESS_ENABLED
+        return run_headless(options);
+#else
+        std::cerr << "Built without EGL, headless mode is unavailable" << std::endl;
+        return -1;
+#endif
+    }
 
     GLFWConfig glfw_config{};
     glfw_config.majorVersion = 4;
@@ -55,7 +429,7 @@ int main()
     glfw_config.errorCallback = glfw_error_callback;
     glfw_config.framebufferSizeCallback = NULL;
 
-    Window<GLFWWrapper, GLFWConfig> window(glfw_config, SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL");
+    Window<GLFWWrapper, GLFWConfig> window(glfw_config, options.width, options.height, "LearnOpenGL");
     if (!window.initialized()) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         return -1;
@@ -71,59 +445,176 @@ int main()
         return -1;
     }
 
+    Profiler::get().setThreadName("Main");
+    if (!GpuProfiler::get().init()) {
+        std::cerr << "GPU profiling unavailable" << std::endl;
+    }
+
     bool show_gui = true;
+    bool show_profiler = true;
+    bool show_memory = false;
+    bool show_post = false;
+    bool show_graph = false;
+    bool show_resolution = false;
+    bool pipelined = options.pipelined;
+    FrameStats frameStats;
+    FramePipeline pipeline(JobSystem::get());
+    pipeline.setEnabled(pipelined);
     EngineGui gui(window.getWindow());
 
+    RenderTargetPool renderTargets;
+    RenderGraph frameGraph(renderTargets);
+    PostProcessor post;
+    if (options.post && !post.init()) {
+        std::cerr << "Post-processing unavailable" << std::endl;
+    }
+    // on by default: slow GPUs drop resolution instead of frames, fast ones stay at scale 1
+    DynamicResolution resolution;
+    Upscaler upscaler;
+    if (options.targetMs > 0.0f) {
+        resolution.settings().targetMs = options.targetMs;
+    }
+    if (options.renderScale < 1.0f) {
+        resolution.settings().enabled = false;
+        resolution.settings().scale = options.renderScale;
+        resolution.settings().minScale = std::min(resolution.settings().minScale, options.renderScale);
+    }
+    if (!resolution.init() || !upscaler.init()) {
+        std::cerr << "Dynamic resolution unavailable" << std::endl;
+    }
+
     test::TestApp* currentTest = nullptr;
     test::TestMenu* testMenu = new test::TestMenu(currentTest);
     currentTest = testMenu;
 
-    testMenu->registerTest<test::TestClearColor>("Clear Color");
-    testMenu->registerTest<test::TestTexture2D>("Container Cube");
-    
+    test::registerTests(*testMenu);
+
 
     // render loop
     // -----------
+    AllocationCounters frameAllocations = Memory::counters();
+    uint64_t lastAllocations = 0;
     while (!window.shouldClose())
     {
-        _update_fps_counter(window.getWindow());
+        const AllocationCounters now = Memory::counters();
+        lastAllocations = Memory::delta(frameAllocations, now).allocations;
+        frameAllocations = now;
+
+        Profiler::get().beginFrame();
+        GpuProfiler::get().beginFrame(Profiler::get().frameIndex());
+
+        // the first delta spans start-up, not a frame
+        bool firstFrame = lastFrame == 0.0f;
         _update_delta_time(&deltaTime, &lastFrame);
+        if (!firstFrame) {
+            frameStats.record(deltaTime * 1000.0);
+        }
+
+        {
+            PROFILE_SCOPE("pollEvents");
+            window.pollEvents();
+        }
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window.getWindow(), &width, &height);
+        renderTargets.beginFrame();
 
-        window.pollEvents();
-        app.setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        app.clear();
-        
         // ---- Begin Gui Render
         gui.render();
 
-        // render
-        // ------
-
         // -- Begin Main UI
         // ----------------
-        if(gui.beginMainUI(&show_gui)) {
-
-            if (currentTest) {
-                currentTest->onUpdate(deltaTime);
-                currentTest->onRender();
-                
-                if(currentTest != testMenu && ImGui::Button("Back <")) {
-                    delete currentTest;
-                    currentTest = testMenu;
-                }
+        const bool mainUI = gui.beginMainUI(&show_gui);
+        if (mainUI) {
+            gui.drawFrameStats(frameStats);
 
-                currentTest->onGuiRender();
+            if (ImGui::Checkbox("Pipelined update", &pipelined)) {
+                pipeline.setEnabled(pipelined);
+            }
+            if (pipelined) {
+                ImGui::Text("update %.3f ms, waited %.3f ms", pipeline.updateMs(), pipeline.waitMs());
             }
+            ImGui::Text("heap allocations %llu/frame, frame arena %.1f KB", (unsigned long long)lastAllocations,
+                FrameArena::get().lastFrameBytes() / 1024.0);
+            ImGui::Checkbox("Memory", &show_memory);
+            ImGui::SameLine();
+            ImGui::Checkbox("Render graph", &show_graph);
+            if (post.initialized()) {
+                ImGui::SameLine();
+                ImGui::Checkbox("Post-processing", &show_post);
+            }
+            if (upscaler.initialized()) {
+                ImGui::SameLine();
+                ImGui::Checkbox("Resolution", &show_resolution);
+            }
+        }
 
+        // render
+        // ------
+        // the test's GUI goes into the main UI, which stays open until the frame graph ran
+        bool back = false;
+        if (width > 0 && height > 0) {
+            build_frame_graph(frameGraph, post, resolution, upscaler, 0, width, height, [&]() {
+                app.setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+                app.clear();
+                if (mainUI && currentTest) {
+                    test::runFrame(*currentTest, pipeline, deltaTime, [&]() {
+                        back = currentTest != testMenu && ImGui::Button("Back <");
+                        currentTest->onGuiRender();
+                    });
+                }
+            });
+            resolution.beginFrame();
+            frameGraph.execute();
+            resolution.endFrame();
+        }
+        if (back) {
+            pipeline.sync();
+            delete currentTest;
+            currentTest = testMenu;
+        }
+        if (mainUI) {
             gui.endMainUI();
         }
 
+        if (show_profiler) {
+            gui.drawProfiler(&show_profiler);
+        }
+        if (show_memory) {
+            gui.drawMemory(&show_memory);
+        }
+        if (show_graph) {
+            gui.drawRenderGraph(&show_graph, frameGraph);
+        }
+        if (show_post) {
+            gui.drawPostProcessing(&show_post, post.settings(), post.stats(), renderTargets);
+        }
+        if (show_resolution) {
+            gui.drawDynamicResolution(&show_resolution, resolution.settings(), resolution.stats());
+        }
 
+        // the GUI goes on top of the post-processed image at native resolution, untouched by it
         // ---- End Gui Render
-        gui.renderEnd();
-        
-        window.swapBuffers();
+        {
+            PROFILE_SCOPE("gui");
+            PROFILE_GPU_SCOPE("gui");
+            gui.renderEnd();
+        }
+
+        GpuProfiler::get().endFrame();
+
+        {
+            PROFILE_SCOPE("swapBuffers");
+            window.swapBuffers();
+        }
+
+        Profiler::get().endFrame();
     }
 
+    pipeline.sync();
+    GpuProfiler::get().shutdown();
+
+    frameStats.writeCsv("frame_times.csv");
+    frameStats.appendSummaryCsv("frame_stats.csv", "glrenderer");
+
     return 0;
 }
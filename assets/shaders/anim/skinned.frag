@@ -0,0 +1,14 @@
+#version 450
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+out vec4 FragColor;
+
+uniform sampler2D texture_diffuse1;
+
+void main() {
+    vec3 lightDir = normalize(vec3(0.4, 1.0, 0.6));
+    float diffuse = max(dot(normalize(Normal), lightDir), 0.0) * 0.8 + 0.2;
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb * diffuse, 1.0);
+}
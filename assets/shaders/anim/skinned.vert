@@ -0,0 +1,64 @@
+#version 450
+
+// COMPRESSED_VERTICES: attributes as uploaded by asset::Mesh with VertexFormat::Compressed
+#ifdef COMPRESSED_VERTICES
+layout (location = 0) in vec4 aPos;         // unorm16, inside the mesh bounds
+layout (location = 1) in vec2 aNormal;      // octahedral snorm16
+#else
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+#endif
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 aBoneIDs;
+layout (location = 6) in vec4 aWeights;
+
+// every instance's palette back to back, see AnimationSystem
+layout (std430, binding = 0) readonly buffer Palettes {
+    mat4 palettes[];
+};
+
+uniform mat4 mvp;
+uniform mat4 model;
+uniform int paletteOffset;
+
+#ifdef COMPRESSED_VERTICES
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+void main() {
+#ifdef COMPRESSED_VERTICES
+    vec3 position = positionOffset + aPos.xyz * positionScale;
+    vec3 normal = octDecode(aNormal);
+#else
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+#endif
+
+    mat4 skin = mat4(0.0);
+    float total = 0.0;
+    for (int i = 0; i < 4; i++) {
+        if (aBoneIDs[i] < 0) {
+            continue;
+        }
+        skin += palettes[paletteOffset + aBoneIDs[i]] * aWeights[i];
+        total += aWeights[i];
+    }
+    if (total == 0.0) {
+        skin = mat4(1.0);
+    }
+
+    gl_Position = mvp * skin * vec4(position, 1.0);
+    Normal = mat3(model) * mat3(skin) * normal;
+    TexCoords = aTexCoords;
+}
@@ -0,0 +1,18 @@
+#version 430 core
+// Boxes of TestOcclusion: one indirect command per instance, its baseInstance picks the instance attributes
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aCenter;
+layout (location = 3) in vec3 aSize;
+layout (location = 4) in vec3 aAlbedo;
+
+uniform mat4 viewProjection;
+
+out vec3 normal;
+out vec3 albedo;
+
+void main() {
+    normal = aNormal;
+    albedo = aAlbedo;
+    gl_Position = viewProjection * vec4(aCenter + aPos * aSize, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 430 core
+in vec3 normal;
+
+uniform vec3 albedo;
+uniform vec3 sunDirection;
+
+out vec4 FragColor;
+
+void main() {
+    float diffuse = max(dot(normalize(normal), -sunDirection), 0.0);
+    FragColor = vec4(albedo * (0.3 + 0.7 * diffuse), 1.0);
+}
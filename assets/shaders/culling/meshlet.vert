@@ -0,0 +1,15 @@
+#version 430 core
+// Spheres of TestMeshletCulling: asset::Mesh vertices, drawn whole or one indirect command per meshlet
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 normal;
+
+void main() {
+    normal = mat3(model) * aNormal;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
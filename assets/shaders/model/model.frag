@@ -0,0 +1,21 @@
+#version 450
+
+in vec2 TexCoords;
+in mat3 TBN;
+
+out vec4 FragColor;
+
+uniform sampler2D texture_diffuse1;
+uniform sampler2D texture_normal1;
+uniform bool normalMapped;
+
+void main() {
+    vec3 normal = TBN[2];
+    if (normalMapped) {
+        normal = TBN * (texture(texture_normal1, TexCoords).rgb * 2.0 - 1.0);
+    }
+
+    vec3 lightDir = normalize(vec3(0.4, 1.0, 0.6));
+    float diffuse = max(dot(normalize(normal), lightDir), 0.0) * 0.8 + 0.2;
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb * diffuse, 1.0);
+}
@@ -0,0 +1,53 @@
+#version 450
+
+// COMPRESSED_VERTICES: attributes as uploaded by asset::Mesh with VertexFormat::Compressed
+#ifdef COMPRESSED_VERTICES
+layout (location = 0) in vec4 aPos;         // unorm16 inside the mesh bounds, w = bitangent sign
+layout (location = 1) in vec2 aNormal;      // octahedral snorm16
+layout (location = 2) in vec2 aTexCoords;   // half float
+layout (location = 3) in vec2 aTangent;     // octahedral snorm16
+#else
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+#endif
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+#ifdef COMPRESSED_VERTICES
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
+
+out vec2 TexCoords;
+out mat3 TBN;
+
+void main() {
+#ifdef COMPRESSED_VERTICES
+    vec3 position = positionOffset + aPos.xyz * positionScale;
+    vec3 normal = octDecode(aNormal);
+    vec3 tangent = octDecode(aTangent);
+    vec3 bitangent = cross(normal, tangent) * (aPos.w > 0.5 ? 1.0 : -1.0);
+#else
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+    vec3 tangent = aTangent;
+    vec3 bitangent = aBitangent;
+#endif
+
+    mat3 normalMatrix = mat3(model);
+    TBN = mat3(normalMatrix * tangent, normalMatrix * bitangent, normalMatrix * normal);
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
@@ -0,0 +1,55 @@
+#version 430 core
+// Output of a reduced resolution pass back to full resolution. With BILATERAL each of the
+// four texels around the pixel has its bilinear weight lowered by how far its depth is
+// from the pixel's, so the result does not bleed across silhouettes; without, bilinear.
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D source;
+layout (binding = 1) uniform sampler2D sceneDepth;      // full resolution, as rendered
+layout (binding = 2) uniform sampler2D reducedDepth;    // linear, at the source's resolution
+
+uniform vec2 depthRange;        // near and far plane
+uniform float depthTolerance;   // relative depth difference that halves a weight
+
+out vec4 fragColor;
+
+float linearize(float depth) {
+    return depthRange.x * depthRange.y / (depthRange.y - depth * (depthRange.y - depthRange.x));
+}
+
+void main() {
+#ifdef BILATERAL
+    float depth = linearize(texelFetch(sceneDepth, ivec2(gl_FragCoord.xy), 0).r);
+    ivec2 size = textureSize(source, 0);
+    vec2 position = uv * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = fract(position);
+    // the four reduced depths in one fetch, gather order is (0,1) (1,1) (1,0) (0,0)
+    vec4 gathered = textureGather(reducedDepth, (vec2(base) + 1.0) / vec2(size), 0);
+    float depths[4] = float[](gathered.w, gathered.z, gathered.x, gathered.y);
+
+    vec4 sum = vec4(0.0);
+    float weights = 0.0;
+    float closest = 1e30;
+    vec4 nearest = vec4(0.0);
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), size - 1);
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float difference = abs(depths[i] - depth) / (depthTolerance * depth);
+        float weight = bilinear.x * bilinear.y / (1.0 + difference * difference);
+        vec4 value = texelFetch(source, texel, 0);
+        sum += value * weight;
+        weights += weight;
+        if (difference < closest) {
+            closest = difference;
+            nearest = value;
+        }
+    }
+    // every texel far from the pixel's depth: the closest one alone
+    fragColor = weights > 1e-6 ? sum / weights : nearest;
+#else
+    fragColor = texture(source, uv);
+#endif
+}
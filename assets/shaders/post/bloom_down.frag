@@ -0,0 +1,41 @@
+#version 430 core
+// One step down the bloom chain, to half the size of the source:
+//   PREFILTER  from the scene, keeping what is brighter than the threshold (soft knee)
+//   (default)  from the level above
+// 13 taps in overlapping 2x2 boxes, weighted as in Jimenez's "Next generation post
+// processing in Call of Duty", which keeps bright texels from flickering as they move.
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D source;
+
+uniform vec2 texelSize;         // of the source
+uniform vec4 threshold;         // x threshold, y threshold - knee, z 2 knee, w 0.25 / knee
+
+out vec4 fragColor;
+
+vec3 tap(vec2 offset) {
+    return texture(source, uv + offset * texelSize).rgb;
+}
+
+void main() {
+    vec3 a = tap(vec2(-2.0, -2.0)), b = tap(vec2(0.0, -2.0)), c = tap(vec2(2.0, -2.0));
+    vec3 d = tap(vec2(-1.0, -1.0)), e = tap(vec2(1.0, -1.0));
+    vec3 f = tap(vec2(-2.0, 0.0)), g = tap(vec2(0.0, 0.0)), h = tap(vec2(2.0, 0.0));
+    vec3 i = tap(vec2(-1.0, 1.0)), j = tap(vec2(1.0, 1.0));
+    vec3 k = tap(vec2(-2.0, 2.0)), l = tap(vec2(0.0, 2.0)), m = tap(vec2(2.0, 2.0));
+
+    vec3 color = (d + e + i + j) * 0.125;
+    color += (a + b + f + g) * 0.03125;
+    color += (b + c + g + h) * 0.03125;
+    color += (f + g + k + l) * 0.03125;
+    color += (g + h + l + m) * 0.03125;
+
+#ifdef PREFILTER
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - threshold.y, 0.0, threshold.z);
+    soft = soft * soft * threshold.w;
+    color *= max(soft, brightness - threshold.x) / max(brightness, 1e-4);
+#endif
+    fragColor = vec4(color, 1.0);
+}
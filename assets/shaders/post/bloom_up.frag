@@ -0,0 +1,22 @@
+#version 430 core
+// One step up the bloom chain: a 3x3 tent over the smaller level, added to the level
+// it is drawn into by the blend state
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D source;
+
+uniform vec2 texelSize;         // of the source
+uniform float radius;           // in source texels
+
+out vec4 fragColor;
+
+void main() {
+    vec2 offset = texelSize * radius;
+    vec3 color = texture(source, uv).rgb * 4.0;
+    color += (texture(source, uv + vec2(-offset.x, 0.0)).rgb + texture(source, uv + vec2(offset.x, 0.0)).rgb +
+              texture(source, uv + vec2(0.0, -offset.y)).rgb + texture(source, uv + vec2(0.0, offset.y)).rgb) * 2.0;
+    color += texture(source, uv - offset).rgb + texture(source, uv + offset).rgb +
+             texture(source, uv + vec2(-offset.x, offset.y)).rgb + texture(source, uv + vec2(offset.x, -offset.y)).rgb;
+    fragColor = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 430 core
+// Scene depth to linear view depth at 1/divisor resolution: of each divisor x divisor block,
+// the texel nearest the camera, so thin foreground survives the reduction
+
+layout (binding = 0) uniform sampler2D sceneDepth;
+
+uniform int divisor;
+uniform vec2 depthRange;    // near and far plane
+
+out float linearDepth;
+
+void main() {
+    ivec2 size = textureSize(sceneDepth, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * divisor;
+    float nearest = 1.0;
+    for (int y = 0; y < divisor; y++) {
+        for (int x = 0; x < divisor; x++) {
+            ivec2 texel = min(base + ivec2(x, y), size - 1);
+            nearest = min(nearest, texelFetch(sceneDepth, texel, 0).r);
+        }
+    }
+    linearDepth = depthRange.x * depthRange.y / (depthRange.y - nearest * (depthRange.y - depthRange.x));
+}
@@ -0,0 +1,118 @@
+#version 430 core
+// FXAA, after Lottes' FXAA 3.11 quality preset: finds the local edge from the luma of the
+// 3x3 neighbourhood, walks along it both ways to its ends and blends across it by how far
+// the pixel is from the nearer end, plus a subpixel term for single pixel features
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D source;
+
+uniform vec2 texelSize;
+
+out vec4 fragColor;
+
+const float kEdgeThreshold = 0.125;
+const float kEdgeThresholdMin = 0.0312;
+const float kSubpixel = 0.75;
+const int kSearchSteps = 10;
+const float kSearchStep[kSearchSteps] = float[](1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 4.0, 8.0);
+
+float luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+float lumaAt(vec2 position) {
+    return luma(texture(source, position).rgb);
+}
+
+void main() {
+    vec3 center = texture(source, uv).rgb;
+    float m = luma(center);
+    float n = lumaAt(uv + vec2(0.0, texelSize.y));
+    float s = lumaAt(uv - vec2(0.0, texelSize.y));
+    float e = lumaAt(uv + vec2(texelSize.x, 0.0));
+    float w = lumaAt(uv - vec2(texelSize.x, 0.0));
+
+    float highest = max(max(max(n, s), max(e, w)), m);
+    float lowest = min(min(min(n, s), min(e, w)), m);
+    float range = highest - lowest;
+    if (range < max(kEdgeThresholdMin, highest * kEdgeThreshold)) {
+        fragColor = vec4(center, 1.0);
+        return;
+    }
+
+    float ne = lumaAt(uv + texelSize);
+    float nw = lumaAt(uv + vec2(-texelSize.x, texelSize.y));
+    float se = lumaAt(uv + vec2(texelSize.x, -texelSize.y));
+    float sw = lumaAt(uv - texelSize);
+
+    // subpixel blend from the contrast of the pixel with its neighbourhood's average
+    float average = (2.0 * (n + s + e + w) + ne + nw + se + sw) / 12.0;
+    float subpixel = clamp(abs(average - m) / range, 0.0, 1.0);
+    subpixel = smoothstep(0.0, 1.0, subpixel);
+    subpixel = subpixel * subpixel * kSubpixel;
+
+    float horizontal = abs(nw + sw - 2.0 * w) + 2.0 * abs(n + s - 2.0 * m) + abs(ne + se - 2.0 * e);
+    float vertical = abs(nw + ne - 2.0 * n) + 2.0 * abs(w + e - 2.0 * m) + abs(sw + se - 2.0 * s);
+    bool isHorizontal = horizontal >= vertical;
+
+    // the side of the edge with the larger gradient
+    float positive = isHorizontal ? n : e;
+    float negative = isHorizontal ? s : w;
+    float gradientPositive = abs(positive - m);
+    float gradientNegative = abs(negative - m);
+    bool towardsPositive = gradientPositive >= gradientNegative;
+    float gradient = max(gradientPositive, gradientNegative);
+    float stepLength = isHorizontal ? texelSize.y : texelSize.x;
+    float edgeLuma = 0.5 * (m + (towardsPositive ? positive : negative));
+    if (!towardsPositive) {
+        stepLength = -stepLength;
+    }
+
+    // walk the edge, halfway between the pixel and its neighbour across it
+    vec2 edge = uv;
+    vec2 along;
+    if (isHorizontal) {
+        edge.y += 0.5 * stepLength;
+        along = vec2(texelSize.x, 0.0);
+    }
+    else {
+        edge.x += 0.5 * stepLength;
+        along = vec2(0.0, texelSize.y);
+    }
+    float scaledGradient = 0.25 * gradient;
+
+    vec2 positiveEnd = edge + along;
+    vec2 negativeEnd = edge - along;
+    float deltaPositive = lumaAt(positiveEnd) - edgeLuma;
+    float deltaNegative = lumaAt(negativeEnd) - edgeLuma;
+    bool donePositive = abs(deltaPositive) >= scaledGradient;
+    bool doneNegative = abs(deltaNegative) >= scaledGradient;
+    for (int i = 1; i < kSearchSteps && !(donePositive && doneNegative); i++) {
+        if (!donePositive) {
+            positiveEnd += along * kSearchStep[i];
+            deltaPositive = lumaAt(positiveEnd) - edgeLuma;
+            donePositive = abs(deltaPositive) >= scaledGradient;
+        }
+        if (!doneNegative) {
+            negativeEnd -= along * kSearchStep[i];
+            deltaNegative = lumaAt(negativeEnd) - edgeLuma;
+            doneNegative = abs(deltaNegative) >= scaledGradient;
+        }
+    }
+
+    float distancePositive = isHorizontal ? positiveEnd.x - uv.x : positiveEnd.y - uv.y;
+    float distanceNegative = isHorizontal ? uv.x - negativeEnd.x : uv.y - negativeEnd.y;
+    bool positiveNearer = distancePositive < distanceNegative;
+    float nearest = min(distancePositive, distanceNegative);
+    float span = distancePositive + distanceNegative;
+
+    // only blend where the edge end's luma goes the other way than the pixel's
+    bool mBelow = m - edgeLuma < 0.0;
+    bool endBelow = (positiveNearer ? deltaPositive : deltaNegative) < 0.0;
+    float edgeBlend = endBelow != mBelow ? 0.5 - nearest / span : 0.0;
+
+    float blend = max(edgeBlend, subpixel);
+    vec2 offset = isHorizontal ? vec2(0.0, blend * stepLength) : vec2(blend * stepLength, 0.0);
+    fragColor = vec4(texture(source, uv + offset).rgb, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 430 core
+// Color grading of the display range image: white balance tint, contrast around mid grey,
+// then saturation around the luminance
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D source;
+
+uniform vec3 tint;
+uniform float contrast;
+uniform float saturation;
+
+out vec4 fragColor;
+
+void main() {
+    vec3 color = texture(source, uv).rgb * tint;
+    color = (color - 0.5) * contrast + 0.5;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    color = mix(vec3(luminance), color, saturation);
+    fragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,37 @@
+#version 430 core
+// HDR scene (and bloom) to display range
+//   toneMapper 0  clamp, the look of the scene without post-processing at exposure 1
+//              1  Reinhard on luminance
+//              2  ACES, Narkowicz's fit of the RRT and ODT
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D scene;
+layout (binding = 1) uniform sampler2D bloom;
+
+uniform float exposure;
+uniform float bloomIntensity;   // 0 when bloom is off
+uniform int toneMapper;
+
+out vec4 fragColor;
+
+vec3 aces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main() {
+    vec3 color = texture(scene, uv).rgb;
+    if (bloomIntensity > 0.0) {
+        color += texture(bloom, uv).rgb * bloomIntensity;
+    }
+    color *= exposure;
+
+    if (toneMapper == 1) {
+        float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+        color *= 1.0 / (1.0 + luminance);
+    }
+    else if (toneMapper == 2) {
+        color = aces(color);
+    }
+    fragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,27 @@
+#version 430 core
+// Upscale of a lower resolution image to the display: bilinear, and with SHARPEN an unsharp
+// mask over the source texels around, clamped to their range so edges don't ring
+
+in vec2 uv;
+
+layout (binding = 0) uniform sampler2D source;
+
+uniform vec2 texelSize;     // of the source
+uniform float sharpness;
+
+out vec4 fragColor;
+
+void main() {
+    vec3 color = texture(source, uv).rgb;
+#ifdef SHARPEN
+    vec3 north = texture(source, uv + vec2(0.0, texelSize.y)).rgb;
+    vec3 south = texture(source, uv - vec2(0.0, texelSize.y)).rgb;
+    vec3 east = texture(source, uv + vec2(texelSize.x, 0.0)).rgb;
+    vec3 west = texture(source, uv - vec2(texelSize.x, 0.0)).rgb;
+    vec3 low = min(color, min(min(north, south), min(east, west)));
+    vec3 high = max(color, max(max(north, south), max(east, west)));
+    vec3 blurred = (north + south + east + west) * 0.25;
+    color = clamp(color + (color - blurred) * sharpness, low, high);
+#endif
+    fragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 430 core
+in vec3 worldPosition;
+in vec3 worldNormal;
+
+layout (location = 0) out vec4 gAlbedo;     // rgb albedo
+layout (location = 1) out vec4 gNormal;     // xyz world normal
+layout (location = 2) out vec4 gMaterial;   // r specular strength, g shininess / 255
+
+uniform vec3 albedo;
+uniform float specular;
+uniform float shininess;
+
+void main() {
+    gAlbedo = vec4(albedo, 1.0);
+    gNormal = vec4(normalize(worldNormal), 0.0);
+    gMaterial = vec4(specular, shininess / 255.0, 0.0, 0.0);
+}
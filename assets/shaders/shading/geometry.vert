@@ -0,0 +1,17 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+out vec3 worldPosition;
+out vec3 worldNormal;
+
+uniform mat4 model;
+uniform mat4 viewProjection;
+
+void main() {
+    vec4 world = model * vec4(aPos, 1.0);
+    worldPosition = world.xyz;
+    // no inverse transpose: the scenes only scale boxes along their own axes, face normals keep their direction
+    worldNormal = mat3(model) * aNormal;
+    gl_Position = viewProjection * world;
+}
@@ -0,0 +1,33 @@
+#version 430 core
+
+#ifdef LIGHT_VOLUME
+layout (location = 0) in vec3 aPos;
+
+struct Light {
+    vec4 positionRadius;
+    vec4 color;
+    vec4 spot;
+    vec4 shadow;
+};
+
+layout (std430, binding = 0) readonly buffer Lights {
+    Light lights[];
+};
+
+uniform mat4 viewProjection;
+
+flat out int lightIndex;
+
+void main() {
+    // the [-1, 1] box, scaled to enclose the light's sphere (a spot's cone is inside it)
+    Light light = lights[gl_InstanceID];
+    gl_Position = viewProjection * vec4(light.positionRadius.xyz + aPos * light.positionRadius.w, 1.0);
+    lightIndex = gl_InstanceID;
+}
+#else
+// one triangle covering the screen, no vertex buffer
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+#endif
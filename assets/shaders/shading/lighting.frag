@@ -0,0 +1,207 @@
+#version 430 core
+// Light shading for every path:
+//   FORWARD            the object's own fragments, all lights in a loop
+//   FORWARD CLUSTERED  the object's own fragments, the lights binned into its froxel
+//   (default)          full-screen pass over the G-buffer, all lights in a loop
+//   LIGHT_VOLUME       one light volume per instance over the G-buffer, blended additively
+// Every path adds the sun, and when shadowsEnabled samples ShadowRenderer's atlas.
+
+struct Light {
+    vec4 positionRadius;    // xyz position, w radius where the light fades to 0
+    vec4 color;             // rgb intensity, w cosine of the inner cone
+    vec4 spot;              // xyz cone direction, w cosine of the outer cone, -2 for point lights
+    vec4 shadow;            // x first shadow view or -1, y 1 if the light casts shadows
+};
+
+layout (std430, binding = 0) readonly buffer Lights {
+    Light lights[];
+};
+
+// the cascades first, then the views of the local lights, see ShadowRenderer
+struct ShadowView {
+    mat4 viewProjection;
+    vec4 rect;              // xy uv offset in the atlas, z uv scale, w tile size in texels
+    vec4 params;            // x depth bias, y normal offset (per unit of distance if z is 1), z 1 for perspective
+};
+
+layout (std430, binding = 5) readonly buffer ShadowViews {
+    ShadowView shadowViews[];
+};
+
+layout (binding = 4) uniform sampler2DShadow shadowAtlas;
+
+uniform vec3 viewPosition;
+uniform vec3 ambient;
+uniform int lightCount;
+uniform vec3 sunDirection;  // the direction the light travels
+uniform vec3 sunColor;
+uniform bool shadowsEnabled;
+uniform int cascadeCount;
+
+out vec4 fragColor;
+
+// 3x3 PCF of the bilinear compare, the taps kept inside the view's tile
+float shadowVisibility(int index, vec3 position, vec3 normal, float distance) {
+    ShadowView view = shadowViews[index];
+    float offset = view.params.y * (view.params.z > 0.0 ? distance : 1.0);
+    vec4 clip = view.viewProjection * vec4(position + normal * offset, 1.0);
+    vec3 ndc = clip.xyz / clip.w * 0.5 + 0.5;
+
+    float inset = 1.5 / view.rect.w;
+    vec2 uv = view.rect.xy + clamp(ndc.xy, vec2(inset), vec2(1.0 - inset)) * view.rect.z;
+    vec2 texel = vec2(view.rect.z / view.rect.w);
+    float depth = ndc.z - view.params.x;
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+            lit += texture(shadowAtlas, vec3(uv + vec2(x, y) * texel, depth));
+    return lit / 9.0;
+}
+
+// the first cascade the point is inside of, lit past the last one
+float sunVisibility(vec3 position, vec3 normal) {
+    for (int i = 0; i < cascadeCount; i++) {
+        vec3 ndc = (shadowViews[i].viewProjection * vec4(position, 1.0)).xyz;
+        if (all(lessThan(abs(ndc), vec3(0.98))))
+            return shadowVisibility(i, position, normal, 0.0);
+    }
+    return 1.0;
+}
+
+// a spot light has one view, a point light six, picked by the major axis like a cube map face
+float lightVisibility(Light light, vec3 position, vec3 normal, float distance) {
+    int view = int(light.shadow.x);
+    if (light.spot.w <= -1.0) {
+        vec3 d = position - light.positionRadius.xyz;
+        vec3 a = abs(d);
+        if (a.x >= a.y && a.x >= a.z)
+            view += d.x > 0.0 ? 0 : 1;
+        else if (a.y >= a.z)
+            view += d.y > 0.0 ? 2 : 3;
+        else
+            view += d.z > 0.0 ? 4 : 5;
+    }
+    return shadowVisibility(view, position, normal, distance);
+}
+
+// Blinn-Phong with a windowed falloff, nothing past the radius or outside the cone
+vec3 shade(Light light, vec3 position, vec3 normal, vec3 albedo, float specular, float shininess) {
+    vec3 toLight = light.positionRadius.xyz - position;
+    float distance2 = dot(toLight, toLight);
+    float radius2 = light.positionRadius.w * light.positionRadius.w;
+    if (distance2 >= radius2)
+        return vec3(0.0);
+
+    float falloff = 1.0 - distance2 / radius2;
+    falloff *= falloff;
+
+    vec3 lightDir = toLight * inversesqrt(distance2);
+    if (light.spot.w > -1.0)
+        falloff *= smoothstep(light.spot.w, light.color.w, dot(-lightDir, light.spot.xyz));
+    if (shadowsEnabled && light.shadow.x >= 0.0 && falloff > 0.0)
+        falloff *= lightVisibility(light, position, normal, sqrt(distance2));
+
+    vec3 viewDir = normalize(viewPosition - position);
+    vec3 halfway = normalize(lightDir + viewDir);
+    float diffuse = max(dot(normal, lightDir), 0.0);
+    float highlight = specular * pow(max(dot(normal, halfway), 0.0), shininess);
+    return (diffuse * albedo + highlight) * light.color.rgb * falloff;
+}
+
+vec3 shadeSun(vec3 position, vec3 normal, vec3 albedo, float specular, float shininess) {
+    if (dot(sunColor, sunColor) == 0.0)
+        return vec3(0.0);
+
+    vec3 lightDir = -sunDirection;
+    float diffuse = max(dot(normal, lightDir), 0.0);
+    if (diffuse == 0.0)
+        return vec3(0.0);
+
+    vec3 viewDir = normalize(viewPosition - position);
+    vec3 halfway = normalize(lightDir + viewDir);
+    float highlight = specular * pow(max(dot(normal, halfway), 0.0), shininess);
+    float visibility = shadowsEnabled && cascadeCount > 0 ? sunVisibility(position, normal) : 1.0;
+    return (diffuse * albedo + highlight) * sunColor * visibility;
+}
+
+#ifdef FORWARD
+in vec3 worldPosition;
+in vec3 worldNormal;
+
+uniform vec3 albedo;
+uniform float specular;
+uniform float shininess;
+
+#ifdef CLUSTERED
+// written by cluster_lights.comp, see GpuLightClusterer
+layout (std430, binding = 2) readonly buffer ClusterRanges {
+    uvec2 ranges[];     // offset, count into indices
+};
+
+layout (std430, binding = 3) readonly buffer ClusterIndices {
+    uint indices[];
+};
+
+uniform mat4 view;
+uniform uvec3 clusterGrid;      // tiles x, tiles y, depth slices
+uniform vec2 clusterTileSize;   // pixels
+uniform float clusterSliceScale;
+uniform float clusterSliceBias;
+#endif
+
+void main() {
+    vec3 normal = normalize(worldNormal);
+    vec3 color = ambient * albedo + shadeSun(worldPosition, normal, albedo, specular, shininess);
+#ifdef CLUSTERED
+    // slices are exponential in view depth, see ClusterGrid
+    float depth = -(view * vec4(worldPosition, 1.0)).z;
+    uvec3 froxel = uvec3(gl_FragCoord.xy / clusterTileSize, uint(max(log(depth) * clusterSliceScale + clusterSliceBias, 0.0)));
+    froxel = min(froxel, clusterGrid - 1u);
+    uvec2 range = ranges[(froxel.z * clusterGrid.y + froxel.y) * clusterGrid.x + froxel.x];
+    for (uint i = 0u; i < range.y; i++)
+        color += shade(lights[indices[range.x + i]], worldPosition, normal, albedo, specular, shininess);
+#else
+    for (int i = 0; i < lightCount; i++)
+        color += shade(lights[i], worldPosition, normal, albedo, specular, shininess);
+#endif
+    fragColor = vec4(color, 1.0);
+}
+#else
+layout (binding = 0) uniform sampler2D gAlbedo;
+layout (binding = 1) uniform sampler2D gNormal;
+layout (binding = 2) uniform sampler2D gMaterial;
+layout (binding = 3) uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+
+#ifdef LIGHT_VOLUME
+flat in int lightIndex;
+#endif
+
+void main() {
+    // the G-buffer has the size of the target, one texel per fragment
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    if (depth == 1.0)
+        discard;
+
+    vec3 albedo = texelFetch(gAlbedo, texel, 0).rgb;
+    vec3 normal = normalize(texelFetch(gNormal, texel, 0).xyz);
+    vec4 material = texelFetch(gMaterial, texel, 0);
+    float specular = material.r;
+    float shininess = material.g * 255.0;
+
+    vec2 uv = (vec2(texel) + 0.5) / vec2(textureSize(gDepth, 0));
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 position = world.xyz / world.w;
+
+#ifdef LIGHT_VOLUME
+    fragColor = vec4(shade(lights[lightIndex], position, normal, albedo, specular, shininess), 0.0);
+#else
+    vec3 color = ambient * albedo + shadeSun(position, normal, albedo, specular, shininess);
+    for (int i = 0; i < lightCount; i++)
+        color += shade(lights[i], position, normal, albedo, specular, shininess);
+    fragColor = vec4(color, 1.0);
+#endif
+}
+#endif
@@ -0,0 +1,5 @@
+#version 430 core
+// depth only, the atlas has no color attachment
+
+void main() {
+}
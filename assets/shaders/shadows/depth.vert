@@ -0,0 +1,10 @@
+#version 430 core
+// Shadow casters into one tile of the shadow atlas, see ShadowRenderer
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 viewProjection;
+
+void main() {
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+}
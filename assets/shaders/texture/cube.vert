@@ -5,11 +5,10 @@ layout (location = 1) in vec2 aTex;
 
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// projection * view * model, computed once per instance on the CPU
+uniform mat4 mvp;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = mvp * vec4(aPos, 1.0);
     TexCoord = vec2(aTex.x, aTex.y);
 }
\ No newline at end of file
@@ -0,0 +1,192 @@
+// Batch math benchmark and accuracy check
+//
+// Runs every BatchMath kernel at each SIMD level the CPU supports against the same work
+// done one glm call at a time:
+//   mat4 * mat4        out[i] = a[i] * b[i]
+//   viewProj * world   out[i] = viewProj * b[i] (per-instance MVP)
+//   mat4 * vec4        out[i] = m * v[i]
+//   quat nlerp         normalized lerp between two pose samples
+//   quat -> mat4       rotation matrices
+//   compose TRS        translate * rotate * scale
+//   AABB transform     world-space boxes of local boxes
+// Every result is compared with glm first; the run fails if any element is off by more
+// than a few float ulps relative to the magnitude of the values.
+//
+// usage: batch-math [iterations] [count]   (default: 50 100000)
+
+#include "engine/math/BatchMath.h"
+#include "engine/scene/Components.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static const float kTolerance = 1e-5f;
+
+template<typename T>
+static float max_error(const std::vector<T>& expected, const std::vector<T>& actual) {
+    const size_t floats = sizeof(T) / sizeof(float);
+    float error = 0.0f;
+    for (size_t i = 0; i < expected.size(); i++) {
+        const float* e = (const float*)&expected[i];
+        const float* a = (const float*)&actual[i];
+        for (size_t k = 0; k < floats; k++) {
+            // relative for large values, absolute near zero
+            error = std::fmax(error, std::fabs(e[k] - a[k]) / std::fmax(1.0f, std::fabs(e[k])));
+        }
+    }
+    return error;
+}
+
+struct Kernel {
+    const char* name;
+    std::function<void()> reference;     // glm, one element at a time
+    std::function<void()> batch;
+    std::function<float()> error;        // batch output vs reference output
+};
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 50;
+    size_t count = argc > 2 ? (size_t)strtoull(argv[2], nullptr, 10) : 100000;
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+    std::vector<glm::vec3> positions(count), scales(count), centers(count), extents(count);
+    std::vector<glm::quat> rotations(count), nextRotations(count);
+    std::vector<glm::mat4> a(count), b(count);
+    std::vector<glm::vec4> vectors(count);
+    std::vector<uint32_t> worldIndices(count);
+
+    for (size_t i = 0; i < count; i++) {
+        positions[i] = glm::vec3(value(rng), value(rng), value(rng));
+        scales[i] = glm::vec3(scale(rng), scale(rng), scale(rng));
+        rotations[i] = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(value(rng), value(rng), value(rng) + 0.1f)));
+        // a small step away and in the same hemisphere, like consecutive animation samples
+        nextRotations[i] = glm::normalize(rotations[i] * glm::angleAxis(0.2f, glm::vec3(0.0f, 1.0f, 0.0f)));
+        centers[i] = glm::vec3(value(rng), value(rng), value(rng));
+        extents[i] = glm::vec3(scale(rng), scale(rng), scale(rng));
+        vectors[i] = glm::vec4(value(rng), value(rng), value(rng), 1.0f);
+        a[i] = compose_transform(positions[i], rotations[i], scales[i]);
+        worldIndices[i] = i % 16 == 15 ? kNoWorld : (uint32_t)(rng() % count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        b[i] = a[(i * 7919) % count];
+    }
+
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+        * glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::vector<glm::mat4> matsRef(count), mats(count);
+    std::vector<glm::vec4> vecsRef(count), vecs(count);
+    std::vector<glm::vec3> minsRef(count), maxsRef(count), mins(count), maxs(count);
+    std::vector<glm::quat> quatsRef(count), quats(count);
+
+    const Kernel kernels[] = {
+        { "mat4 * mat4",
+          [&]() { for (size_t i = 0; i < count; i++) matsRef[i] = a[i] * b[i]; },
+          [&]() { mat4_mul_batch(a.data(), b.data(), mats.data(), count); },
+          [&]() { return max_error(matsRef, mats); } },
+        { "viewProj * world",
+          [&]() { for (size_t i = 0; i < count; i++) matsRef[i] = viewProjection * b[i]; },
+          [&]() { mat4_mul_batch(viewProjection, b.data(), mats.data(), count); },
+          [&]() { return max_error(matsRef, mats); } },
+        { "mat4 * vec4",
+          [&]() { for (size_t i = 0; i < count; i++) vecsRef[i] = viewProjection * vectors[i]; },
+          [&]() { mat4_transform_batch(viewProjection, vectors.data(), vecs.data(), count); },
+          [&]() { return max_error(vecsRef, vecs); } },
+        { "quat nlerp",
+          [&]() { for (size_t i = 0; i < count; i++) quatsRef[i] = glm::normalize(rotations[i] * 0.7f + nextRotations[i] * 0.3f); },
+          [&]() { quat_nlerp_batch(rotations.data(), nextRotations.data(), 0.3f, quats.data(), count); },
+          [&]() { return max_error(quatsRef, quats); } },
+        { "quat -> mat4",
+          [&]() { for (size_t i = 0; i < count; i++) matsRef[i] = glm::mat4_cast(rotations[i]); },
+          [&]() { quat_to_mat4_batch(rotations.data(), mats.data(), count); },
+          [&]() { return max_error(matsRef, mats); } },
+        { "compose TRS",
+          [&]() {
+              for (size_t i = 0; i < count; i++) {
+                  glm::mat4 m = glm::translate(glm::mat4(1.0f), positions[i]) * glm::mat4_cast(rotations[i]);
+                  matsRef[i] = glm::scale(m, scales[i]);
+              }
+          },
+          [&]() { compose_transform_batch(positions.data(), rotations.data(), scales.data(), mats.data(), count); },
+          [&]() { return max_error(matsRef, mats); } },
+        { "AABB transform",
+          [&]() {
+              for (size_t i = 0; i < count; i++) {
+                  glm::vec3 center = centers[i], extent = extents[i];
+                  if (worldIndices[i] != kNoWorld) {
+                      const glm::mat4& m = a[worldIndices[i]];
+                      center = glm::vec3(m * glm::vec4(centers[i], 1.0f));
+                      glm::mat3 r(m);
+                      extent = glm::vec3(0.0f);
+                      for (int c = 0; c < 3; c++) {
+                          extent += glm::abs(r[c]) * extents[i][c];
+                      }
+                  }
+                  minsRef[i] = center - extent;
+                  maxsRef[i] = center + extent;
+              }
+          },
+          [&]() { aabb_transform_batch(a.data(), worldIndices.data(), centers.data(), extents.data(), mins.data(), maxs.data(), count); },
+          [&]() { return std::fmax(max_error(minsRef, mins), max_error(maxsRef, maxs)); } },
+    };
+
+    std::vector<SimdLevel> levels = { SimdLevel::Scalar };
+    if ((int)simd_supported() >= (int)SimdLevel::SSE) {
+        levels.push_back(SimdLevel::SSE);
+    }
+    if ((int)simd_supported() >= (int)SimdLevel::AVX2) {
+        levels.push_back(SimdLevel::AVX2);
+    }
+
+    printf("%zu elements, %d iterations, widest level %s\n\n", count, iterations, simd_level_name(simd_supported()));
+    printf("%-18s %-8s %10s %10s %9s %10s\n", "kernel", "level", "ns/elem", "glm ns", "speedup", "max error");
+
+    bool failed = false;
+    for (const Kernel& kernel : kernels) {
+        auto start = Clock::now();
+        for (int it = 0; it < iterations; it++) {
+            kernel.reference();
+        }
+        double reference = seconds(Clock::now() - start) / ((double)count * iterations) * 1e9;
+
+        for (SimdLevel level : levels) {
+            set_simd_level(level);
+            kernel.batch();
+            float error = kernel.error();
+
+            start = Clock::now();
+            for (int it = 0; it < iterations; it++) {
+                kernel.batch();
+            }
+            double batch = seconds(Clock::now() - start) / ((double)count * iterations) * 1e9;
+
+            printf("%-18s %-8s %10.2f %10.2f %8.2fx %10.2g%s\n", kernel.name, simd_level_name(level),
+                batch, reference, reference / batch, error, error > kTolerance ? "  FAILED" : "");
+            failed |= error > kTolerance;
+        }
+    }
+    set_simd_level(simd_supported());
+
+    if (failed) {
+        fprintf(stderr, "ERROR: batch kernels disagree with glm\n");
+        return 1;
+    }
+    return 0;
+}
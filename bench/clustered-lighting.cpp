@@ -0,0 +1,337 @@
+// Clustered lighting benchmark
+//
+// Bins 256, 1024 and 4096 point and spot lights (one in four a spot) spread over a city
+// block into the 16x9x24 froxels of a 60 degree perspective with the CPU reference
+// (assign_lights), and prints the time per binning and the lights per cluster. The binning
+// must be conservative: for random points in the view frustum, every light that reaches the
+// point has to be in the list of the point's cluster.
+//
+// With a headless context the compute binning (GpuLightClusterer) runs on the same lights
+// and must agree with the reference, up to lights within float noise of a cluster's
+// boundary. Then the "Deferred Lights" scene is rendered with forward (up to 1024 lights),
+// deferred light volumes and clustered forward shading; clustered images must match the
+// forward ones, or the deferred ones where forward is too slow to run.
+//
+// usage: clustered-lighting [width] [height] [frames]   (default: 480 270 3)
+
+#include "engine/render/ClusteredLighting.h"
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestDeferredLights.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/opengl/OpenGLPipeline.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static const int kLightCounts[] = { 256, 1024, 4096 };
+
+static std::vector<Light> make_lights(int count) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Light> lights;
+    for (int i = 0; i < count; i++) {
+        const glm::vec3 position(34.0f * (unit(rng) - 0.5f), 0.3f + 2.5f * unit(rng), 34.0f * (unit(rng) - 0.5f));
+        const glm::vec3 color(unit(rng), unit(rng), unit(rng));
+        if (i % 4 == 3) {
+            lights.push_back(spot_light(position, 6.0f, color, glm::vec3(unit(rng) - 0.5f, -1.0f, unit(rng) - 0.5f), 0.35f, 0.6f));
+        }
+        else {
+            lights.push_back(point_light(position, 4.0f, color));
+        }
+    }
+    return lights;
+}
+
+struct GridStats {
+    size_t nonEmpty;
+    double average;     // lights per non-empty cluster
+    uint32_t max;
+};
+
+static GridStats grid_stats(const LightGrid& grid) {
+    GridStats stats{};
+    size_t total = 0;
+    for (const ClusterRange& range : grid.ranges) {
+        stats.nonEmpty += range.count > 0;
+        stats.max = std::max(stats.max, range.count);
+        total += range.count;
+    }
+    stats.average = stats.nonEmpty ? (double)total / stats.nonEmpty : 0.0;
+    return stats;
+}
+
+static bool in_list(const LightGrid& grid, uint32_t cluster, uint32_t light) {
+    const ClusterRange& range = grid.ranges[cluster];
+    const uint32_t* begin = grid.indices.data() + range.offset;
+    return std::binary_search(begin, begin + range.count, light);
+}
+
+/// Points in the frustum lit by a light missing from their cluster's list
+static size_t missed_lights(const ClusterGrid& grid, const LightGrid& lists, const std::vector<Light>& lights,
+                            const glm::mat4& view, int samples)
+{
+    const ClusterGridConfig& config = grid.config();
+    const glm::mat4 inverseView = glm::inverse(view);
+    const glm::mat4 inverseProjection = glm::inverse(grid.projection());
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    size_t missed = 0;
+    for (int s = 0; s < samples; s++) {
+        // as the fragment shader finds its cluster: tile from the screen position, slice from the depth
+        const float u = unit(rng), v = unit(rng);
+        const float depth = grid.nearDepth() * std::pow(60.0f / grid.nearDepth(), unit(rng));
+        const glm::vec4 onNear = inverseProjection * glm::vec4(u * 2.0f - 1.0f, v * 2.0f - 1.0f, -1.0f, 1.0f);
+        const glm::vec3 ray = glm::vec3(onNear) / onNear.w;
+        const glm::vec3 viewPoint = ray * (depth / -ray.z);
+        const glm::vec3 world = glm::vec3(inverseView * glm::vec4(viewPoint, 1.0f));
+
+        const uint32_t x = std::min((uint32_t)(u * config.tilesX), config.tilesX - 1);
+        const uint32_t y = std::min((uint32_t)(v * config.tilesY), config.tilesY - 1);
+        const float slice = std::max(std::log(depth) * grid.sliceScale() + grid.sliceBias(), 0.0f);
+        const uint32_t cluster = grid.clusterIndex(x, y, std::min((uint32_t)slice, config.slices - 1));
+
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); i++) {
+            const Light& light = lights[i];
+            const glm::vec3 toLight = glm::vec3(light.positionRadius) - world;
+            const float distance = glm::length(toLight);
+            if (distance >= light.positionRadius.w) {
+                continue;
+            }
+            if (light.isSpot() && distance > 0.0f && glm::dot(-toLight / distance, glm::vec3(light.spot)) <= light.spot.w) {
+                continue;
+            }
+            missed += !in_list(lists, cluster, i);
+        }
+    }
+    return missed;
+}
+
+#ifdef HEADLESS_ENABLED
+struct Agreement {
+    size_t missing;     // lights the reference keeps, even shrunk by the slack, the GPU lacks
+    size_t extra;       // lights the GPU keeps the reference rejects, even grown by the slack
+};
+
+static Agreement compare_lists(const ClusterGrid& grid, const LightGrid& reference, const LightGrid& gpu,
+                               const std::vector<Light>& lights, const glm::mat4& view)
+{
+    const float slack = 1e-3f;
+    Agreement agreement{};
+    for (uint32_t cluster = 0; cluster < (uint32_t)grid.clusterCount(); cluster++) {
+        const ClusterBounds& bounds = grid.bounds()[cluster];
+        auto touches = [&](uint32_t i, float s) {
+            const Light& light = lights[i];
+            const glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(light.positionRadius), 1.0f));
+            const glm::vec3 direction = glm::mat3(view) * glm::vec3(light.spot);
+            return light_touches_cluster(bounds, center, light.positionRadius.w, direction, light.spot.w, s);
+        };
+
+        const ClusterRange& expected = reference.ranges[cluster];
+        for (uint32_t k = 0; k < expected.count; k++) {
+            const uint32_t i = reference.indices[expected.offset + k];
+            agreement.missing += touches(i, -slack) && !in_list(gpu, cluster, i);
+        }
+        const ClusterRange& found = gpu.ranges[cluster];
+        for (uint32_t k = 0; k < found.count; k++) {
+            const uint32_t i = gpu.indices[found.offset + k];
+            agreement.extra += !touches(i, slack);
+        }
+    }
+    return agreement;
+}
+
+static double time_path(test::TestDeferredLights& app, ShadingPath path, const Framebuffer& target, int frames,
+                        std::vector<unsigned char>& image)
+{
+    app.setPath(path);
+    double ms = 0.0;
+    for (int frame = 0; frame <= frames; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+        const auto start = Clock::now();
+        app.onRender();
+        glFinish();
+        // frame 0 builds the G-buffer or the froxel grid
+        if (frame > 0) {
+            ms += seconds(Clock::now() - start) * 1e3;
+        }
+    }
+    target.readPixels(image);
+    return ms / frames;
+}
+
+static size_t differing_pixels(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int tolerance) {
+    size_t pixels = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        int worst = 0;
+        for (size_t c = 0; c < 3; c++) {
+            worst = std::max(worst, std::abs((int)a[i + c] - (int)b[i + c]));
+        }
+        pixels += worst > tolerance;
+    }
+    return pixels;
+}
+
+static bool run_gl(int width, int height, int frames, const ClusterGrid& grid, const glm::mat4& view) {
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, width, height, "clustered-lighting");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return false;
+    }
+    window.makeContextCurrent();
+    bool ok = true;
+
+    GpuLightClusterer clusterer;
+    if (!clusterer.init("assets/shaders/shading/cluster_lights.comp")) {
+        printf("FAILED: could not build assets/shaders/shading/cluster_lights.comp\n");
+        return false;
+    }
+    clusterer.setGrid(grid);
+
+    printf("\nGL (%s), compute binning into %zu clusters, %.2f MB of lists:\n", glGetString(GL_RENDERER),
+           grid.clusterCount(), clusterer.byteSize() / (1024.0 * 1024.0));
+    printf("%-8s %12s %10s %10s %10s\n", "lights", "gpu ms", "missing", "extra", "dropped");
+    for (int count : kLightCounts) {
+        const std::vector<Light> lights = make_lights(count);
+        BufferInfo<Light> info{ SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER, (unsigned long)(lights.size() * sizeof(Light)), lights, GL_STATIC_DRAW };
+        Buffer<Light> buffer(info);
+
+        double ms = 0.0;
+        for (int frame = 0; frame <= frames; frame++) {
+            glFinish();
+            const auto start = Clock::now();
+            clusterer.bin(buffer.id(), (uint32_t)lights.size(), view);
+            glFinish();
+            if (frame > 0) {
+                ms += seconds(Clock::now() - start) * 1e3;
+            }
+        }
+
+        LightGrid reference, gpu;
+        assign_lights(grid, lights, view, reference);
+        clusterer.read(gpu);
+        const Agreement agreement = compare_lists(grid, reference, gpu, lights, view);
+        printf("%-8d %12.3f %10zu %10zu %10zu\n", count, ms / frames, agreement.missing, agreement.extra, gpu.dropped);
+        if (agreement.missing || agreement.extra || gpu.dropped) {
+            printf("FAILED: the compute binning disagrees with the reference for %d lights\n", count);
+            ok = false;
+        }
+    }
+
+    FramebufferConfig targetConfig{};
+    targetConfig.width = width;
+    targetConfig.height = height;
+    targetConfig.colorAttachments = { Framebuffer::rgba16f() };
+    targetConfig.depth = true;
+    targetConfig.depthFormat = GL_DEPTH_COMPONENT24;
+    Framebuffer target;
+    if (!target.create(targetConfig)) {
+        printf("FAILED: could not create the %dx%d target\n", width, height);
+        return false;
+    }
+
+    test::TestDeferredLights app;
+    if (!app.renderer().initialized()) {
+        printf("FAILED: could not build assets/shaders/shading\n");
+        return false;
+    }
+    target.bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+
+    printf("\n\"Deferred Lights\" at %dx%d, RGBA16F target, %d frames per path:\n", width, height, frames);
+    printf("%-8s %-18s %12s %10s %14s\n", "lights", "path", "ms/frame", "speedup", "diff pixels");
+    for (int count : { 64, 1024, 4096 }) {
+        app.setLightCount(count);
+        app.onUpdate(0.0f);
+
+        std::vector<unsigned char> forward, volumes, clustered;
+        double forwardMs = 0.0;
+        if (count <= 1024) {
+            forwardMs = time_path(app, ShadingPath::Forward, target, frames, forward);
+            printf("%-8d %-18s %12.3f %10s %14s\n", count, "forward", forwardMs, "1.00x", "-");
+        }
+        const double volumesMs = time_path(app, ShadingPath::DeferredVolumes, target, frames, volumes);
+        const double clusteredMs = time_path(app, ShadingPath::Clustered, target, frames, clustered);
+        const double baseMs = forwardMs > 0.0 ? forwardMs : volumesMs;
+        printf("%-8d %-18s %12.3f %9.2fx %14s\n", count, "deferred volumes", volumesMs, baseMs / volumesMs, "-");
+
+        // forward and clustered run the same shader over the same lights, bar the ones that add 0
+        const size_t differing = differing_pixels(forward.empty() ? volumes : clustered, forward.empty() ? clustered : forward, 3);
+        printf("%-8d %-18s %12.3f %9.2fx %8zu vs %s\n", count, "clustered", clusteredMs, baseMs / clusteredMs, differing,
+               forward.empty() ? "deferred" : "forward");
+        if (differing * 100 > (size_t)width * height) {
+            printf("FAILED: clustered differs on %zu pixels with %d lights\n", differing, count);
+            ok = false;
+        }
+    }
+    return ok;
+}
+#endif
+
+int main(int argc, char** argv) {
+    const int width = argc > 1 ? atoi(argv[1]) : 480;
+    const int height = argc > 2 ? atoi(argv[2]) : 270;
+    const int frames = argc > 3 ? atoi(argv[3]) : 3;
+
+    // the camera of the "Deferred Lights" test
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 14.0f, 30.0f), glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)1200 / (float)900, 0.1f, 100.0f);
+    ClusterGrid grid;
+    grid.build(projection, ClusterGridConfig());
+    const ClusterGridConfig& config = grid.config();
+    printf("%ux%ux%u froxels, depth %.1f to %.1f\n\n", config.tilesX, config.tilesY, config.slices, grid.nearDepth(), grid.farDepth());
+
+    bool ok = true;
+    printf("%-8s %12s %12s %12s %10s %10s\n", "lights", "cpu ms", "non-empty", "avg/cluster", "max", "missed");
+    for (int count : kLightCounts) {
+        const std::vector<Light> lights = make_lights(count);
+        LightGrid lists;
+        const int repeats = 5;
+        const auto start = Clock::now();
+        for (int r = 0; r < repeats; r++) {
+            assign_lights(grid, lights, view, lists);
+        }
+        const double ms = seconds(Clock::now() - start) * 1e3 / repeats;
+
+        const GridStats stats = grid_stats(lists);
+        const size_t missed = missed_lights(grid, lists, lights, view, 20000);
+        printf("%-8d %12.3f %12zu %12.1f %10u %10zu\n", count, ms, stats.nonEmpty, stats.average, stats.max, missed);
+        if (missed) {
+            printf("FAILED: %zu lit points miss a light in their cluster with %d lights\n", missed, count);
+            ok = false;
+        }
+    }
+
+#ifdef HEADLESS_ENABLED
+    ok = run_gl(width, height, frames, grid, view) && ok;
+#else
+    (void)width;
+    (void)height;
+    (void)frames;
+#endif
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+// Command list recording and replay benchmark
+//
+// Records N draws (pipeline, texture, one mat4 uniform each, like a Cube Field frame) into
+// command lists, split evenly over 1 list on one thread and then one list per job thread,
+// merges them into a CommandQueue and sorts it. Prints record and sort time per frame and
+// the allocator bytes used; the sorted stream must hold every draw once, in key order,
+// equal keys in record order, and bind each pipeline once.
+//
+// With a headless context the same cubes are also drawn to a 256x256 target immediately
+// (Cube::draw with Shader::setUniform) and through GLCommandExecutor in the same order; both
+// images must be identical, and the immediate and replay times are printed next to each other.
+//
+// usage: command-lists [draws] [frames] [threads]   (default: 16384 60, hardware threads)
+
+#include "engine/core/JobSystem.h"
+#include "engine/render/CommandList.h"
+
+#ifdef HEADLESS_ENABLED
+#include "engine/core/Cube.hpp"
+#include "engine/opengl/GLCommandExecutor.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static const uint32_t kPipelines = 4;
+static const uint32_t kTextures = 8;
+
+struct Draw {
+    glm::mat4 mvp;
+    uint32_t pipeline;
+    uint32_t texture;
+    float depth;
+};
+
+static std::vector<Draw> make_draws(size_t count) {
+    std::vector<Draw> draws(count);
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 200.0f) *
+                                     glm::lookAt(glm::vec3(0.0f, 30.0f, 70.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    for (size_t i = 0; i < count; i++) {
+        const float angle = 0.618034f * 6.2831853f * i;
+        const glm::vec3 position(40.0f * std::cos(angle), std::sin(angle * 3.0f), 40.0f * std::sin(angle));
+        draws[i].mvp = viewProjection * glm::translate(glm::mat4(1.0f), position);
+        draws[i].pipeline = 1 + (uint32_t)(i * 7 % kPipelines);
+        draws[i].texture = 1 + (uint32_t)(i * 13 % kTextures);
+        draws[i].depth = draws[i].mvp[3][3] / 200.0f;
+    }
+    return draws;
+}
+
+static void record(CommandList& list, const std::vector<Draw>& draws, size_t begin, size_t end) {
+    list.begin();
+    list.bindVertexArray(1);
+    for (size_t i = begin; i < end; i++) {
+        const Draw& draw = draws[i];
+        list.setSortKey(make_sort_key(0, draw.pipeline, draw.texture, draw.depth));
+        list.bindPipeline(draw.pipeline);
+        list.bindTexture(0, draw.texture);
+        list.setUniform("mvp", draw.mvp);
+        list.drawArrays(PrimitiveType::Triangles, 0, 36);
+    }
+    list.end();
+}
+
+struct RecordResult {
+    double recordMs;        // wall, all lists
+    double listMs;          // sum of the lists' own record times
+    double sortMs;
+    size_t bytes;
+};
+
+static RecordResult run(const std::vector<Draw>& draws, size_t listCount, int frames, JobSystem& jobs, bool& ok) {
+    std::vector<std::unique_ptr<CommandList>> lists;
+    for (size_t i = 0; i < listCount; i++) {
+        lists.push_back(std::make_unique<CommandList>());
+    }
+    CommandQueue queue;
+
+    RecordResult result{};
+    for (int frame = 0; frame < frames; frame++) {
+        const auto start = Clock::now();
+        jobs.parallelFor(listCount, 1, [&](size_t begin, size_t end) {
+            for (size_t l = begin; l < end; l++) {
+                record(*lists[l], draws, draws.size() * l / listCount, draws.size() * (l + 1) / listCount);
+            }
+        });
+        result.recordMs += seconds(Clock::now() - start) * 1e3;
+
+        queue.clear();
+        for (const std::unique_ptr<CommandList>& list : lists) {
+            queue.submit(*list);
+            result.bytes += list->bytesUsed();
+        }
+        queue.sort();
+        result.listMs += queue.recordMs();
+        result.sortMs += queue.sortMs();
+    }
+
+    const std::vector<CommandQueue::Entry>& entries = queue.entries();
+    size_t pipelineChanges = 0;
+    bool ordered = entries.size() == draws.size();
+    for (size_t i = 0; ordered && i < entries.size(); i++) {
+        if (i > 0) {
+            const CommandQueue::Entry& a = entries[i - 1];
+            const CommandQueue::Entry& b = entries[i];
+            ordered = a.key < b.key || (a.key == b.key && a.order < b.order);
+            pipelineChanges += a.packet->pipeline != b.packet->pipeline;
+        }
+    }
+    if (!ordered || pipelineChanges + 1 != kPipelines) {
+        printf("FAILED: %zu lists: %zu packets for %zu draws, %s, %zu pipeline changes\n", listCount, entries.size(),
+               draws.size(), ordered ? "ordered" : "out of order", pipelineChanges);
+        ok = false;
+    }
+
+    result.recordMs /= frames;
+    result.listMs /= frames;
+    result.sortMs /= frames;
+    result.bytes /= frames;
+    return result;
+}
+
+#ifdef HEADLESS_ENABLED
+static bool compare_gl(size_t count, int frames) {
+    const int size = 256;
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, size, size, "command-lists");
+    if (!window.initialized()) {
+        return true;
+    }
+    window.makeContextCurrent();
+
+    Cube cube(CubeType::POS_TEX);
+    cube.setShaders("assets/shaders/texture/cube.vert", "assets/shaders/texture/cube.frag");
+    cube.setTexture("assets/images/container.jpg");
+    if (cube.getShader().id() == 0) {
+        printf("FAILED: could not build assets/shaders/texture/cube.*\n");
+        return false;
+    }
+
+    // one key for all draws: the queue keeps record order, which is the immediate order, so
+    // depth ties between overlapping cubes resolve the same way and the images match exactly
+    std::vector<Draw> draws = make_draws(count);
+    glViewport(0, 0, size, size);
+    glEnable(GL_DEPTH_TEST);
+
+    std::vector<unsigned char> immediate(size * size * 4), replayed(size * size * 4);
+    double immediateMs = 0.0, recordMs = 0.0, sortMs = 0.0, replayMs = 0.0;
+    CommandList list;
+    CommandQueue queue;
+    GLCommandExecutor executor;
+    for (int frame = 0; frame < frames; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+        auto start = Clock::now();
+        cube.bindTexture();
+        cube.useShader();
+        for (const Draw& draw : draws) {
+            cube.getShader().setUniform("mvp", draw.mvp);
+            cube.draw();
+        }
+        glFinish();
+        immediateMs += seconds(Clock::now() - start) * 1e3;
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, immediate.data());
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glUseProgram(0);
+        glFinish();
+        list.begin();
+        cube.bindTexture(list);
+        cube.useShader(list);
+        for (const Draw& draw : draws) {
+            list.setSortKey(make_sort_key(0, cube.getShader().id(), 0, 0.0f));
+            list.setUniform("mvp", draw.mvp);
+            cube.draw(list);
+        }
+        list.end();
+        queue.clear();
+        queue.submit(list);
+        queue.sort();
+        start = Clock::now();
+        executor.execute(queue);
+        glFinish();
+        replayMs += seconds(Clock::now() - start) * 1e3;
+        recordMs += queue.recordMs();
+        sortMs += queue.sortMs();
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, replayed.data());
+    }
+
+    size_t differing = 0;
+    for (size_t i = 0; i < immediate.size(); i += 4) {
+        differing += immediate[i] != replayed[i] || immediate[i + 1] != replayed[i + 1] || immediate[i + 2] != replayed[i + 2];
+    }
+    const CommandReplayStats& stats = executor.stats();
+    printf("\nGL (%s), %zu cubes at %dx%d:\n", glGetString(GL_RENDERER), count, size, size);
+    printf("%-10s %12s\n", "path", "ms/frame");
+    printf("%-10s %12.3f\n", "immediate", immediateMs / frames);
+    printf("%-10s %12.3f   record %.3f + sort %.3f + replay %.3f\n", "recorded", (recordMs + sortMs + replayMs) / frames,
+           recordMs / frames, sortMs / frames, replayMs / frames);
+    printf("replay: %llu draws, %llu pipeline binds, %llu texture binds, %llu uniform uploads, %llu redundant skipped\n",
+           (unsigned long long)stats.draws, (unsigned long long)stats.pipelineBinds, (unsigned long long)stats.textureBinds,
+           (unsigned long long)stats.uniformUploads, (unsigned long long)stats.redundantSkipped);
+    printf("%zu of %d pixels differ\n", differing, size * size);
+    return differing == 0;
+}
+#endif
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? (size_t)atol(argv[1]) : 16384;
+    const int frames = argc > 2 ? atoi(argv[2]) : 60;
+    const unsigned int threads = argc > 3 ? (unsigned int)atoi(argv[3]) : std::thread::hardware_concurrency();
+
+    JobSystem jobs(threads);
+    const std::vector<Draw> draws = make_draws(count);
+    printf("%zu draws, %d frames, %u job threads\n\n", count, frames, jobs.threadCount());
+
+    bool ok = true;
+    printf("%-8s %12s %12s %12s %10s %12s\n", "lists", "record ms", "list ms", "sort ms", "ns/draw", "bytes/frame");
+    for (size_t listCount : { (size_t)1, (size_t)jobs.threadCount() }) {
+        const RecordResult r = run(draws, listCount, frames, jobs, ok);
+        printf("%-8zu %12.3f %12.3f %12.3f %10.1f %12zu\n", listCount, r.recordMs, r.listMs, r.sortMs,
+               r.recordMs * 1e6 / count, r.bytes);
+        if (jobs.threadCount() == 1) {
+            break;
+        }
+    }
+
+#ifdef HEADLESS_ENABLED
+    ok = compare_gl(count, frames < 10 ? frames : 10) && ok;
+#endif
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
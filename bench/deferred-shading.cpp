@@ -0,0 +1,160 @@
+// Deferred shading benchmark
+//
+// Renders the "Deferred Lights" scene (257 boxes, most of them partly hidden behind the
+// rows in front) with 1, 64 and 1024 lights through forward and both deferred paths:
+//   forward            every rasterized fragment loops over all lights
+//   deferred           G-buffer, then a full-screen pass looping over all lights
+//   deferred volumes   G-buffer, then one instanced box per light, blended additively
+// and prints GPU time per frame (glFinish bracketed) and the speedup over forward. The
+// target is RGBA16F like a real HDR target, so hundreds of additive light volumes don't
+// pile up 8 bit rounding. Both deferred images must match the forward one: the G-buffer
+// stores albedo in 8 bits and normals in 16 bit floats, so a channel may be off by a few
+// levels, but no more than 1% of the pixels by more than 3.
+//
+// Needs a headless EGL build (HEADLESS_ENABLED), GPU timings mean little on a software
+// rasterizer, compare the ratios.
+//
+// usage: deferred-shading [width] [height] [frames]   (default: 480 270 5)
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestDeferredLights.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+#ifdef HEADLESS_ENABLED
+static const ShadingPath kPaths[] = { ShadingPath::Forward, ShadingPath::DeferredFullScreen, ShadingPath::DeferredVolumes };
+static const int kLightCounts[] = { 1, 64, 1024 };
+
+struct Difference {
+    size_t pixels;      // pixels with a channel off by more than the tolerance
+    int maxChannel;
+};
+
+static Difference compare(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int tolerance) {
+    Difference difference{};
+    for (size_t i = 0; i < a.size(); i += 4) {
+        int worst = 0;
+        for (size_t c = 0; c < 3; c++) {
+            worst = std::max(worst, std::abs((int)a[i + c] - (int)b[i + c]));
+        }
+        difference.pixels += worst > tolerance;
+        difference.maxChannel = std::max(difference.maxChannel, worst);
+    }
+    return difference;
+}
+
+/// Milliseconds per frame of `path`, the last frame's pixels in `image`
+static double time_path(test::TestDeferredLights& app, ShadingPath path, const Framebuffer& target, int frames,
+                        std::vector<unsigned char>& image)
+{
+    app.setPath(path);
+    double ms = 0.0;
+    for (int frame = 0; frame <= frames; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+        const auto start = Clock::now();
+        app.onRender();
+        glFinish();
+        // frame 0 builds the G-buffer and warms the shader caches
+        if (frame > 0) {
+            ms += seconds(Clock::now() - start) * 1e3;
+        }
+    }
+    target.readPixels(image);
+    return ms / frames;
+}
+#endif
+
+int main(int argc, char** argv) {
+#ifdef HEADLESS_ENABLED
+    const int width = argc > 1 ? atoi(argv[1]) : 480;
+    const int height = argc > 2 ? atoi(argv[2]) : 270;
+    const int frames = argc > 3 ? atoi(argv[3]) : 5;
+
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, width, height, "deferred-shading");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    FramebufferConfig targetConfig{};
+    targetConfig.width = width;
+    targetConfig.height = height;
+    targetConfig.colorAttachments = { Framebuffer::rgba16f() };
+    targetConfig.depth = true;
+    targetConfig.depthFormat = GL_DEPTH_COMPONENT24;
+    Framebuffer target;
+    if (!target.create(targetConfig)) {
+        printf("FAILED: could not create the %dx%d target\n", width, height);
+        return 1;
+    }
+
+    test::TestDeferredLights app;
+    if (!app.renderer().initialized()) {
+        printf("FAILED: could not build assets/shaders/shading\n");
+        return 1;
+    }
+
+    target.bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    printf("GL (%s), %dx%d RGBA16F target, %d frames per path\n\n", glGetString(GL_RENDERER), width, height, frames);
+
+    const int tolerance = 3;
+    bool ok = true;
+    printf("%-8s %-18s %12s %10s %14s\n", "lights", "path", "ms/frame", "speedup", "diff pixels");
+    for (int lights : kLightCounts) {
+        app.setLightCount(lights);
+        app.onUpdate(0.0f);
+
+        std::vector<unsigned char> reference, image;
+        double forwardMs = 0.0;
+        for (ShadingPath path : kPaths) {
+            const double ms = time_path(app, path, target, frames, path == ShadingPath::Forward ? reference : image);
+            if (path == ShadingPath::Forward) {
+                forwardMs = ms;
+                printf("%-8d %-18s %12.3f %10s %14s\n", lights, shading_path_name(path), ms, "1.00x", "-");
+                continue;
+            }
+
+            const Difference difference = compare(reference, image, tolerance);
+            printf("%-8d %-18s %12.3f %9.2fx %8zu (max %d)\n", lights, shading_path_name(path), ms, forwardMs / ms,
+                   difference.pixels, difference.maxChannel);
+            if (difference.pixels * 100 > (size_t)width * height) {
+                printf("FAILED: %s differs from forward on %zu pixels with %d lights\n", shading_path_name(path),
+                       difference.pixels, lights);
+                ok = false;
+            }
+        }
+    }
+    printf("\nG-buffer: %.2f MB (albedo RGBA8, normal RGBA16F, material RGBA8, depth 32F)\n",
+           app.renderer().gbufferBytes() / (1024.0 * 1024.0));
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    (void)seconds;
+    printf("deferred-shading needs a headless EGL build (HEADLESS_ENABLED)\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,329 @@
+// Dynamic resolution benchmark
+//
+// Runs the controller against a simulated GPU whose frame time is a fixed part plus a part
+// growing with the pixel count, read back two frames late and with some noise:
+//   - a light load stays at full resolution without a single change
+//   - a heavy load settles under the target, inside the headroom band, and stays there
+//   - a load spike is over the target for a few frames only, and full resolution comes back
+//     once the spike is gone
+// and prints the frames over the target, the scale changes and the cost of an update.
+//
+// With a headless context it then checks the upscale pass: a flat image stays flat, the
+// sharpened upscale of a hard edge has a steeper step than the bilinear one and never
+// leaves the range of the source. Last, it renders "Deferred Lights" at a few fixed scales,
+// upscaled to the same size, and closes the loop with a target between the cheapest and
+// the dearest.
+//
+// usage: dynamic-resolution [frames]   (default: 8)
+
+#include "engine/render/DynamicResolution.h"
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestDeferredLights.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/opengl/RenderTargetPool.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+/// GPU time of a frame: `fixedMs` whatever the scale, `fullMs` more at full resolution
+struct SimulatedLoad {
+    double fixedMs;
+    double fullMs;
+};
+
+struct SimulationResult {
+    float finalScale;
+    double settledMs;           // mean over the last quarter of the frames
+    float settledMinScale;      // over the last quarter
+    float settledMaxScale;
+    int overTarget;             // frames
+    uint32_t changes;
+};
+
+/**
+ * @brief `frames` frames of `load(frame)`, each sample reaching the controller two frames
+ * after its frame was built, the way the timer queries do
+ */
+template <typename Load>
+static SimulationResult simulate(const DynamicResolutionSettings& settings, int frames, Load load) {
+    DynamicResolution controller;
+    controller.setSettings(settings);
+    std::mt19937 random(7);
+    std::normal_distribution<double> noise(0.0, 0.03);
+
+    SimulationResult result = { 1.0f, 0.0, 1.0f, 0.0f, 0, 0 };
+    std::vector<std::pair<double, float>> inFlight;
+    const int settled = frames - frames / 4;
+    for (int frame = 0; frame < frames; frame++) {
+        const float scale = controller.scale();
+        const SimulatedLoad frameLoad = load(frame);
+        const double ms = (frameLoad.fixedMs + frameLoad.fullMs * scale * scale) * (1.0 + noise(random));
+        inFlight.push_back({ ms, scale });
+        if (inFlight.size() > 2) {
+            controller.update(inFlight.front().first, inFlight.front().second);
+            inFlight.erase(inFlight.begin());
+        }
+
+        result.overTarget += ms > settings.targetMs ? 1 : 0;
+        if (frame >= settled) {
+            result.settledMs += ms / (frames - settled);
+            result.settledMinScale = std::min(result.settledMinScale, scale);
+            result.settledMaxScale = std::max(result.settledMaxScale, scale);
+        }
+    }
+    result.finalScale = controller.scale();
+    result.changes = controller.stats().changes;
+    return result;
+}
+
+static void print_result(const char* name, const SimulationResult& result) {
+    printf("%-28s %8.2f %10.2f %6.2f-%.2f %8d %8u\n", name, result.finalScale, result.settledMs, result.settledMinScale,
+           result.settledMaxScale, result.overTarget, result.changes);
+}
+
+static bool check_controller() {
+    DynamicResolutionSettings settings;
+    settings.targetMs = 16.0f;
+    const int frames = 1200;
+
+    printf("%-28s %8s %10s %11s %8s %8s\n", "load (target 16 ms)", "scale", "settled ms", "range", "over", "changes");
+    const SimulationResult light = simulate(settings, frames, [](int) { return SimulatedLoad{ 1.0, 8.0 }; });
+    print_result("light, 9 ms at full", light);
+    const SimulationResult heavy = simulate(settings, frames, [](int) { return SimulatedLoad{ 2.0, 40.0 }; });
+    print_result("heavy, 42 ms at full", heavy);
+    const SimulationResult spike = simulate(settings, frames, [](int frame) {
+        return frame >= 300 && frame < 600 ? SimulatedLoad{ 1.0, 30.0 } : SimulatedLoad{ 1.0, 10.0 };
+    });
+    print_result("30 ms spike, frames 300-600", spike);
+
+    bool ok = true;
+    if (light.finalScale != 1.0f || light.changes != 0 || light.overTarget != 0) {
+        printf("FAILED: a light load left full resolution\n");
+        ok = false;
+    }
+    const double low = settings.targetMs * (1.0 - settings.headroom) * 0.9;
+    if (heavy.settledMs > settings.targetMs || heavy.settledMs < low || heavy.settledMaxScale != heavy.settledMinScale) {
+        printf("FAILED: a heavy load does not settle under the target\n");
+        ok = false;
+    }
+    // two frames of latency and one to react, a few more for noise around the edge
+    if (spike.overTarget > 10 || spike.finalScale != 1.0f) {
+        printf("FAILED: the spike was over the target for %d frames, the scale ended at %.2f\n", spike.overTarget,
+               spike.finalScale);
+        ok = false;
+    }
+
+    DynamicResolution controller;
+    controller.setSettings(settings);
+    const int updates = 1000000;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < updates; i++) {
+        controller.update(10.0 + (i % 16), controller.scale());
+    }
+    printf("update %.1f ns\n", seconds(Clock::now() - start) * 1e9 / updates);
+    return ok;
+}
+
+#ifdef HEADLESS_ENABLED
+
+static int channel(const std::vector<unsigned char>& pixels, int width, int x, int y, int c) {
+    return pixels[((size_t)y * width + x) * 4 + c];
+}
+
+/// Largest difference between neighbours along row `y`, and the row's range
+static int edge_step(const std::vector<unsigned char>& pixels, int width, int y, int& low, int& high) {
+    int step = 0;
+    low = 255;
+    high = 0;
+    for (int x = 0; x < width; x++) {
+        const int value = channel(pixels, width, x, y, 0);
+        if (x > 0) {
+            step = std::max(step, std::abs(value - channel(pixels, width, x - 1, y, 0)));
+        }
+        low = std::min(low, value);
+        high = std::max(high, value);
+    }
+    return step;
+}
+
+static bool check_upscale(Upscaler& upscaler) {
+    const int sourceSize = 32, size = 96;
+    Framebuffer source({ sourceSize, sourceSize, { Framebuffer::rgba8() }, false, GL_DEPTH_COMPONENT24 });
+    Framebuffer output({ size, size, { Framebuffer::rgba8() }, false, GL_DEPTH_COMPONENT24 });
+    if (!source.id() || !output.id()) {
+        printf("FAILED: could not create the targets\n");
+        return false;
+    }
+    std::vector<unsigned char> pixels;
+
+    // flat
+    source.bind();
+    glClearColor(0.4f, 0.4f, 0.4f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    upscaler.render(source.colorTexture(), sourceSize, sourceSize, output.id(), size, size, UpscaleFilter::Sharpen, 1.0f);
+    output.readPixels(pixels);
+    int flat = 0;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            flat += std::abs(channel(pixels, size, x, y, 0) - 102) > 1 ? 1 : 0;
+        }
+    }
+
+    // dark left half, bright right half
+    const int dark = 51, bright = 204;
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    source.bind();
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(sourceSize / 2, 0, sourceSize / 2, sourceSize);
+    glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+
+    int low = 0, high = 0;
+    upscaler.render(source.colorTexture(), sourceSize, sourceSize, output.id(), size, size, UpscaleFilter::Bilinear, 0.0f);
+    output.readPixels(pixels);
+    const int bilinear = edge_step(pixels, size, size / 2, low, high);
+    upscaler.render(source.colorTexture(), sourceSize, sourceSize, output.id(), size, size, UpscaleFilter::Sharpen, 1.0f);
+    output.readPixels(pixels);
+    const int sharpened = edge_step(pixels, size, size / 2, low, high);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    printf("upscale %dx%d to %dx%d: %d flat pixels changed, edge step %d bilinear, %d sharpened, range %d-%d of %d-%d\n",
+           sourceSize, sourceSize, size, size, flat, bilinear, sharpened, low, high, dark, bright);
+    if (flat != 0) {
+        printf("FAILED: the upscale changes a flat image\n");
+        return false;
+    }
+    if (sharpened <= bilinear || low < dark - 1 || high > bright + 1) {
+        printf("FAILED: sharpening does not steepen the edge within the source range\n");
+        return false;
+    }
+    return true;
+}
+
+/// One frame of the test at `scale` of `output`, upscaled into it
+static void render_scaled(test::TestDeferredLights& app, DynamicResolution& resolution, Upscaler& upscaler,
+                          RenderTargetPool& pool, const Framebuffer& output) {
+    pool.beginFrame();
+    const int width = resolution.renderWidth(output.width());
+    const int height = resolution.renderHeight(output.height());
+    Framebuffer* scene = pool.acquire({ width, height, GL_RGBA8, GL_DEPTH24_STENCIL8, GL_LINEAR });
+    resolution.beginFrame();
+    scene->bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    app.onUpdate(1.0f / 60.0f);
+    app.onRender();
+    upscaler.render(scene->colorTexture(), width, height, output.id(), output.width(), output.height(),
+                    resolution.settings().filter, resolution.settings().sharpness);
+    resolution.endFrame();
+    pool.release(scene);
+    glFinish();
+}
+
+#endif
+
+int main(int argc, char** argv) {
+    printf("controller\n");
+    if (!check_controller()) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+#ifdef HEADLESS_ENABLED
+    const int frames = argc > 1 ? atoi(argv[1]) : 8;
+
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, 64, 64, "dynamic-resolution");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    Upscaler upscaler;
+    if (!upscaler.init()) {
+        printf("FAILED: could not build assets/shaders/post/upscale.frag\n");
+        return 1;
+    }
+
+    printf("\nGL (%s)\n\nchecks\n", glGetString(GL_RENDERER));
+    if (!check_upscale(upscaler)) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    test::TestDeferredLights app;
+    app.setPath(ShadingPath::DeferredFullScreen);
+    app.setLightCount(64);
+    RenderTargetPool pool;
+    const int width = 640, height = 360;
+    Framebuffer output({ width, height, { Framebuffer::rgba8() }, false, GL_DEPTH_COMPONENT24 });
+
+    printf("\n\"Deferred Lights\" upscaled to %dx%d, %d frames per scale\n\n", width, height, frames);
+    printf("%-8s %10s %10s %12s\n", "scale", "size", "gpu ms", "full res ms");
+    double dearest = 0.0, cheapest = 0.0;
+    for (const float scale : { 1.0f, 0.75f, 0.5f }) {
+        DynamicResolution resolution;
+        resolution.settings().enabled = false;
+        resolution.settings().scale = scale;
+        resolution.init();
+        double gpuMs = 0.0;
+        int timed = 0;
+        for (int frame = 0; frame < frames + 2; frame++) {
+            const uint64_t samples = resolution.stats().samples;
+            render_scaled(app, resolution, upscaler, pool, output);
+            // the first frames warm up caches and the pool
+            if (frame >= 2 && resolution.stats().samples > samples) {
+                gpuMs += resolution.stats().gpuMs;
+                timed++;
+            }
+        }
+        gpuMs /= std::max(timed, 1);
+        char size[32];
+        snprintf(size, sizeof(size), "%dx%d", resolution.stats().width, resolution.stats().height);
+        printf("%-8.2f %10s %10.3f %12.3f\n", scale, size, gpuMs, resolution.stats().fullMs);
+        dearest = scale == 1.0f ? gpuMs : dearest;
+        cheapest = gpuMs;
+    }
+
+    // closed loop, a target half way: the scale has to come down from 1 and stay above 0.5
+    DynamicResolution resolution;
+    resolution.settings().targetMs = (float)(cheapest + dearest) * 0.5f;
+    resolution.settings().raiseDelay = 4;
+    resolution.init();
+    const int loopFrames = std::max(frames * 4, 16);
+    for (int frame = 0; frame < loopFrames; frame++) {
+        render_scaled(app, resolution, upscaler, pool, output);
+    }
+    const DynamicResolutionStats& stats = resolution.stats();
+    printf("\nclosed loop, target %.3f ms: scale %.2f (%dx%d) after %d frames, %u changes, last frame %.3f ms\n",
+           resolution.settings().targetMs, stats.scale, stats.width, stats.height, loopFrames, stats.changes, stats.gpuMs);
+    if (stats.scale >= 1.0f || stats.changes == 0) {
+        printf("FAILED: the controller did not lower the scale\n");
+        return 1;
+    }
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    printf("\nthe upscale checks need a headless EGL build (HEADLESS_ENABLED)\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,190 @@
+// Frame arena benchmark
+//
+// A transient per-frame workload on the job system: every chunk of entities builds a list
+// of visible items with a label each (the kind of scratch data culling and draw sorting
+// make), sorts it and folds it into a checksum. Runs the same frames with
+//   heap    std::vector and std::string, rebuilt every frame
+//   arena   std::pmr::vector and std::pmr::string on FrameArena::get().resource()
+// and prints frame time and heap allocations per frame (Memory counters). After the
+// warm-up frames the arena run must not allocate at all, and both runs must produce the
+// same checksums. Any thread may end up with every chunk of a frame, so the arenas are
+// reserved for that up front.
+//
+// usage: frame-arena [frames] [entities] [threads]   (default: 300 65536, hardware threads)
+
+#include "engine/core/FrameArena.h"
+#include "engine/core/JobSystem.h"
+#include "engine/core/Memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static const size_t kChunk = 2048;
+static const int kWarmup = 10;
+
+struct Item {
+    float depth;
+    uint32_t entity;
+};
+
+static float depth_of(uint32_t entity, int frame) {
+    uint32_t h = entity * 2654435761u ^ (uint32_t)frame * 40503u;
+    h ^= h >> 15;
+    return (h & 0xffff) / 65535.0f;
+}
+
+// labels longer than the small string buffer, as debug names and uniform names often are
+template <typename String>
+static void make_label(String& label, uint32_t entity) {
+    char text[48];
+    snprintf(text, sizeof(text), "entity_%u/visible_item", entity);
+    label = text;
+}
+
+template <typename Vector, typename String>
+static uint64_t chunk_checksum(Vector& items, std::vector<String>* heapLabels, String& label, size_t begin, size_t end,
+                               int frame)
+{
+    for (size_t e = begin; e < end; e++) {
+        const float depth = depth_of((uint32_t)e, frame);
+        if (depth < 0.6f) {
+            items.push_back({ depth, (uint32_t)e });
+        }
+    }
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.depth != b.depth ? a.depth < b.depth : a.entity < b.entity;
+    });
+
+    uint64_t hash = 1469598103934665603ull;
+    for (const Item& item : items) {
+        make_label(label, item.entity);
+        if (heapLabels) {
+            heapLabels->push_back(label);
+        }
+        for (char c : label) {
+            hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+struct FrameWork {
+    bool arena;
+    size_t entities;
+    int frame;
+    std::atomic<uint64_t>* sums;
+};
+
+static void run_chunks(const FrameWork& work, size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+        const size_t first = c * kChunk, last = std::min(work.entities, first + kChunk);
+        uint64_t sum;
+        if (work.arena) {
+            std::pmr::memory_resource* resource = FrameArena::get().resource();
+            std::pmr::vector<Item> items(resource);
+            items.reserve(last - first);
+            std::pmr::string label(resource);
+            sum = chunk_checksum(items, (std::vector<std::pmr::string>*)nullptr, label, first, last, work.frame);
+        }
+        else {
+            std::vector<Item> items;
+            std::vector<std::string> labels;
+            std::string label;
+            sum = chunk_checksum(items, &labels, label, first, last, work.frame);
+        }
+        work.sums[c].store(sum, std::memory_order_relaxed);
+    }
+}
+
+struct RunResult {
+    double seconds;
+    double allocations;         // per measured frame
+    uint64_t maxAllocations;
+    double arenaBytes;
+    std::vector<uint64_t> checksums;
+};
+
+static RunResult run(bool arena, int frames, size_t entities, JobSystem& jobs) {
+    const size_t chunks = (entities + kChunk - 1) / kChunk;
+    std::vector<std::atomic<uint64_t>> sums(chunks);
+
+    RunResult result{};
+    result.checksums.reserve(frames);
+    Clock::duration measured{};
+    for (int frame = 0; frame < frames + kWarmup; frame++) {
+        const AllocationCounters before = Memory::counters();
+        const auto start = Clock::now();
+
+        FrameArena::get().nextFrame();
+        // one pointer capture keeps the std::function itself off the heap
+        const FrameWork work = { arena, entities, frame, sums.data() };
+        const FrameWork* shared = &work;
+        jobs.parallelFor(chunks, 1, [shared](size_t begin, size_t end) { run_chunks(*shared, begin, end); });
+
+        uint64_t checksum = 0;
+        for (size_t c = 0; c < chunks; c++) {
+            checksum = checksum * 31 + sums[c].load(std::memory_order_relaxed);
+        }
+
+        if (frame >= kWarmup) {
+            measured += Clock::now() - start;
+            const AllocationCounters allocated = Memory::delta(before, Memory::counters());
+            result.allocations += (double)allocated.allocations;
+            result.maxAllocations = std::max(result.maxAllocations, allocated.allocations);
+            result.checksums.push_back(checksum);
+        }
+    }
+    FrameArena::get().nextFrame();
+    result.arenaBytes = (double)FrameArena::get().lastFrameBytes();
+
+    result.seconds = seconds(measured);
+    result.allocations /= frames;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? atoi(argv[1]) : 300;
+    const size_t entities = argc > 2 ? (size_t)atol(argv[2]) : 65536;
+    const unsigned int threads = argc > 3 ? (unsigned int)atoi(argv[3]) : std::thread::hardware_concurrency();
+
+    JobSystem jobs(threads);
+    const size_t chunks = (entities + kChunk - 1) / kChunk;
+    FrameArena::get().reserve(chunks * (kChunk * sizeof(Item) + 1024));
+    printf("%d frames (+%d warm-up), %zu entities, %u job threads\n\n", frames, kWarmup, entities, jobs.threadCount());
+
+    RunResult heap = run(false, frames, entities, jobs);
+    RunResult arena = run(true, frames, entities, jobs);
+
+    printf("%-8s %12s %14s %14s %12s\n", "mode", "ms/frame", "allocs/frame", "max allocs", "arena KB");
+    for (const RunResult* r : { &heap, &arena }) {
+        printf("%-8s %12.3f %14.1f %14llu %12.1f\n", r == &heap ? "heap" : "arena", r->seconds * 1e3 / frames,
+               r->allocations, (unsigned long long)r->maxAllocations, r == &arena ? r->arenaBytes / 1024.0 : 0.0);
+    }
+    printf("\narena: %zu threads, %.1f KB held\n", FrameArena::get().threadCount(), FrameArena::get().capacity() / 1024.0);
+    printf("speedup %.2fx\n", heap.seconds / arena.seconds);
+
+    bool ok = true;
+    if (heap.checksums != arena.checksums) {
+        printf("FAILED: arena frames differ from the heap ones\n");
+        ok = false;
+    }
+    if (arena.maxAllocations != 0) {
+        printf("FAILED: the arena run allocated %llu times in a steady state frame\n", (unsigned long long)arena.maxAllocations);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// Frame pipeline throughput benchmark
+//
+// A CPU-bound frame without a GL context: the update moves N entities through the Scene
+// (transforms, bounds), culls them and writes one MVP per survivor into a frame packet;
+// the render walks the packet and spends a fixed cost per draw, standing in for the
+// uniform and draw call submission of TestCubeField. Runs the same frames
+//   serial      update, then render, on one thread
+//   pipelined   FramePipeline: the update of frame N+1 on the job system while the
+//               caller renders frame N from the other packet
+// and prints frames per second for both. Every rendered frame leaves a checksum; the
+// pipelined run has to render exactly the frames the serial one did.
+//
+// usage: frame-pipeline [frames] [entities] [ns per draw] [threads]   (default: 300 32768 150, hardware threads)
+
+#include "engine/core/FramePipeline.h"
+#include "engine/core/JobSystem.h"
+#include "engine/math/Frustum.h"
+#include "engine/scene/Scene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+struct Packet {
+    std::vector<glm::mat4> mvps;
+};
+
+class Simulation {
+public:
+    Simulation(size_t count, JobSystem& jobs) : m_jobs(jobs), m_time(0.0f) {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        m_scene.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            Entity entity = m_scene.create();
+            m_scene.transforms().add(entity, { glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.4f) });
+            m_scene.bounds().add(entity, Bounds());
+            m_radii.push_back(4.0f + 56.0f * std::sqrt(unit(rng)));
+            m_speeds.push_back((0.2f + unit(rng)) / std::sqrt(m_radii.back()));
+            m_phases.push_back(6.2831853f * unit(rng));
+        }
+    }
+
+    void update(float dt, Packet& packet) {
+        m_time += dt;
+        const float time = m_time;
+        m_jobs.parallelFor(m_radii.size(), 1024, [this, time](size_t begin, size_t end) {
+            TransformStorage& transforms = m_scene.transforms();
+            for (size_t i = begin; i < end; i++) {
+                const float angle = m_phases[i] + m_speeds[i] * time;
+                transforms.positions[i] = glm::vec3(m_radii[i] * std::cos(angle), std::sin(angle * 3.0f), m_radii[i] * std::sin(angle));
+                transforms.rotations[i] = glm::angleAxis(angle * 4.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+        });
+        m_scene.updateTransforms();
+        m_scene.updateBounds();
+
+        const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 30.0f, 70.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 200.0f) * view;
+        const Frustum frustum(viewProjection);
+
+        // entities were added in the same order to both storages and never removed
+        const TransformStorage& transforms = m_scene.transforms();
+        const BoundsStorage& bounds = m_scene.bounds();
+        packet.mvps.clear();
+        for (size_t i = 0; i < bounds.size(); i++) {
+            if (frustum.intersectsBox(bounds.worldMins[i], bounds.worldMaxs[i])) {
+                packet.mvps.push_back(viewProjection * transforms.worlds[i]);
+            }
+        }
+    }
+
+private:
+    JobSystem& m_jobs;
+    Scene m_scene;
+    std::vector<float> m_radii;
+    std::vector<float> m_speeds;
+    std::vector<float> m_phases;
+    float m_time;
+};
+
+// stands in for setUniform + glDrawArrays: busy for `nsPerDraw`, folds the matrix into a hash
+static uint64_t render(const Packet& packet, double nsPerDraw) {
+    uint64_t hash = 1469598103934665603ull;
+    for (const glm::mat4& mvp : packet.mvps) {
+        const auto until = Clock::now() + std::chrono::nanoseconds((int64_t)nsPerDraw);
+        const uint32_t* words = reinterpret_cast<const uint32_t*>(&mvp[0][0]);
+        for (int k = 0; k < 16; k++) {
+            hash = (hash ^ words[k]) * 1099511628211ull;
+        }
+        while (Clock::now() < until) {
+        }
+    }
+    return hash ^ packet.mvps.size();
+}
+
+struct RunResult {
+    double seconds;
+    double updateMs;
+    double waitMs;
+    size_t draws;
+    std::vector<uint64_t> checksums;
+};
+
+static RunResult run(bool pipelined, int frames, size_t entities, double nsPerDraw, JobSystem& jobs) {
+    Simulation simulation(entities, jobs);
+    FramePackets<Packet> packets;
+    FramePipeline pipeline(jobs);
+    pipeline.setEnabled(pipelined);
+    const float dt = 1.0f / 60.0f;
+
+    RunResult result{};
+    result.checksums.reserve(frames);
+    auto start = Clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        // the schedule of test::runFrame
+        if (pipeline.pending()) {
+            pipeline.sync();
+        } else {
+            simulation.update(dt, packets.write());
+        }
+        packets.publish();
+        result.waitMs += pipeline.waitMs();
+        result.updateMs += pipeline.updateMs();
+
+        // disabled, the pipeline runs this right here and the frame is serial
+        Packet* next = &packets.write();
+        Simulation* sim = &simulation;
+        pipeline.kick([sim, next, dt]() { sim->update(dt, *next); });
+
+        result.checksums.push_back(render(packets.read(), nsPerDraw));
+        result.draws += packets.read().mvps.size();
+    }
+    pipeline.sync();
+    result.seconds = seconds(Clock::now() - start);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? atoi(argv[1]) : 300;
+    const size_t entities = argc > 2 ? (size_t)atol(argv[2]) : 32768;
+    const double nsPerDraw = argc > 3 ? atof(argv[3]) : 150.0;
+    const unsigned int threads = argc > 4 ? (unsigned int)atoi(argv[4]) : std::thread::hardware_concurrency();
+
+    JobSystem jobs(threads);
+    printf("%d frames, %zu entities, %.0f ns per draw, %u job threads\n\n", frames, entities, nsPerDraw, jobs.threadCount());
+
+    RunResult serial = run(false, frames, entities, nsPerDraw, jobs);
+    RunResult pipelined = run(true, frames, entities, nsPerDraw, jobs);
+
+    printf("%-10s %10s %12s %12s %12s %10s\n", "mode", "fps", "ms/frame", "update ms", "waited ms", "draws/fr");
+    for (const RunResult* r : { &serial, &pipelined }) {
+        printf("%-10s %10.1f %12.3f %12.3f %12.3f %10.0f\n", r == &serial ? "serial" : "pipelined", frames / r->seconds,
+               r->seconds * 1e3 / frames, r->updateMs / frames, r->waitMs / frames, (double)r->draws / frames);
+    }
+    printf("\nthroughput gain %.2fx\n", serial.seconds / pipelined.seconds);
+
+    if (serial.checksums != pipelined.checksums) {
+        printf("FAILED: pipelined frames differ from the serial ones\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+// Job system scaling benchmark
+//
+// Runs a few workloads on a JobSystem of 1, 2, 4, ... up to N threads:
+//   parallel for   evenly expensive items, the ideal case for splitting a range
+//   unbalanced     nested parallelFor over groups whose cost grows quadratically, so the
+//                  threads that finish early have to steal from the others
+//   tiny jobs      individually submitted jobs doing next to nothing: scheduler overhead
+//   dependency     a reduction tree, every node a job held back by runAfter until the
+//                  counter of its children reaches zero
+// Prints the time, the speedup over one thread, the jobs run and how many were stolen.
+// Every result is checked against a serial computation.
+//
+// usage: job-system [max threads] [repeats]   (default: hardware threads, 5)
+
+#include "engine/core/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// a few hundred nanoseconds of dependent math per call
+static double work(size_t i, int iterations) {
+    double x = (double)(i % 1024) * 0.001 + 0.5;
+    for (int k = 0; k < iterations; k++) {
+        x = std::sqrt(x * x + 0.25) * 0.75 + std::sin(x) * 0.1;
+    }
+    return x;
+}
+
+struct Workload {
+    const char* name;
+    double (*run)(JobSystem& jobs);
+    double expected;
+};
+
+static const size_t kItems = 1 << 16;
+static const int kItemIterations = 64;
+
+static double run_parallel_for(JobSystem& jobs) {
+    static std::vector<double> out(kItems);
+    jobs.parallelFor(kItems, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            out[i] = work(i, kItemIterations);
+        }
+    });
+    double sum = 0.0;
+    for (double v : out) {
+        sum += v;
+    }
+    return sum;
+}
+
+static const size_t kGroups = 64;
+
+static size_t group_size(size_t g) {
+    return 16 + g * g * 2;
+}
+
+static double run_unbalanced(JobSystem& jobs) {
+    static std::vector<double> out(kGroups);
+    jobs.parallelFor(kGroups, 1, [&](size_t begin, size_t end) {
+        for (size_t g = begin; g < end; g++) {
+            const size_t count = group_size(g);
+            std::vector<double> partial(count);
+            jobs.parallelFor(count, 64, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; i++) {
+                    partial[i] = work(g * 131 + i, kItemIterations);
+                }
+            });
+            double sum = 0.0;
+            for (double v : partial) {
+                sum += v;
+            }
+            out[g] = sum;
+        }
+    });
+    double sum = 0.0;
+    for (double v : out) {
+        sum += v;
+    }
+    return sum;
+}
+
+static const size_t kTinyJobs = 1 << 17;
+
+static double run_tiny(JobSystem& jobs) {
+    static std::vector<uint32_t> out(kTinyJobs);
+    JobCounter counter;
+    for (size_t i = 0; i < kTinyJobs; i++) {
+        uint32_t* slot = &out[i];
+        jobs.run([slot, i]() { *slot = (uint32_t)(i * 3 + 1); }, &counter);
+    }
+    jobs.wait(counter);
+    double sum = 0.0;
+    for (uint32_t v : out) {
+        sum += v;
+    }
+    return sum;
+}
+
+static const size_t kLeaves = 4096;
+static const int kLeafIterations = 2048;
+
+struct TreeNode {
+    double value = 0.0;
+    JobCounter children;
+};
+
+static double run_dependency(JobSystem& jobs) {
+    // heap layout, node n has children 2n+1 and 2n+2, the leaves are the last kLeaves nodes
+    static std::vector<TreeNode> nodes(kLeaves * 2 - 1);
+    const size_t firstLeaf = kLeaves - 1;
+    JobCounter done;
+
+    // children first, so each runAfter sees its children already counted
+    for (size_t n = nodes.size(); n-- > 0;) {
+        TreeNode* node = &nodes[n];
+        JobCounter* parent = n == 0 ? &done : &nodes[(n - 1) / 2].children;
+        if (n >= firstLeaf) {
+            const size_t leaf = n - firstLeaf;
+            jobs.run([node, leaf]() { node->value = work(leaf, kLeafIterations); }, parent);
+        } else {
+            TreeNode* left = &nodes[2 * n + 1];
+            TreeNode* right = &nodes[2 * n + 2];
+            jobs.runAfter(node->children, [node, left, right]() { node->value = left->value + right->value; }, parent);
+        }
+    }
+    jobs.wait(done);
+    return nodes[0].value;
+}
+
+static double serial_parallel_for() {
+    double sum = 0.0;
+    for (size_t i = 0; i < kItems; i++) {
+        sum += work(i, kItemIterations);
+    }
+    return sum;
+}
+
+static double serial_unbalanced() {
+    double sum = 0.0;
+    for (size_t g = 0; g < kGroups; g++) {
+        double group = 0.0;
+        for (size_t i = 0; i < group_size(g); i++) {
+            group += work(g * 131 + i, kItemIterations);
+        }
+        sum += group;
+    }
+    return sum;
+}
+
+static double serial_tiny() {
+    double sum = 0.0;
+    for (size_t i = 0; i < kTinyJobs; i++) {
+        sum += (uint32_t)(i * 3 + 1);
+    }
+    return sum;
+}
+
+// same pairing order as the tree, so the sums match bit for bit
+static double serial_dependency() {
+    std::vector<double> values(kLeaves * 2 - 1);
+    const size_t firstLeaf = kLeaves - 1;
+    for (size_t n = values.size(); n-- > 0;) {
+        values[n] = n >= firstLeaf ? work(n - firstLeaf, kLeafIterations) : values[2 * n + 1] + values[2 * n + 2];
+    }
+    return values[0];
+}
+
+int main(int argc, char** argv) {
+    unsigned int maxThreads = argc > 1 ? (unsigned int)std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    maxThreads = std::max(1u, maxThreads);
+    repeats = std::max(1, repeats);
+
+    Workload workloads[] = {
+        { "parallel for", run_parallel_for, serial_parallel_for() },
+        { "unbalanced", run_unbalanced, serial_unbalanced() },
+        { "tiny jobs", run_tiny, serial_tiny() },
+        { "dependency", run_dependency, serial_dependency() },
+    };
+
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    printf("job system scaling, %u hardware threads, best of %d\n\n", std::thread::hardware_concurrency(), repeats);
+    printf("%-14s %8s %10s %8s %10s %10s %8s\n", "workload", "threads", "ms", "speedup", "jobs", "stolen", "ns/job");
+
+    bool ok = true;
+    for (const Workload& workload : workloads) {
+        double baseline = 0.0;
+        for (unsigned int threads : threadCounts) {
+            JobSystem jobs(threads);
+            workload.run(jobs);     // warm up the pools and wake the workers
+
+            const uint64_t jobsBefore = jobs.jobsExecuted();
+            const uint64_t stealsBefore = jobs.steals();
+            double best = 1e30;
+            for (int r = 0; r < repeats; r++) {
+                auto start = Clock::now();
+                const double result = workload.run(jobs);
+                best = std::min(best, seconds(Clock::now() - start));
+
+                if (std::fabs(result - workload.expected) > 1e-9 * std::fabs(workload.expected)) {
+                    printf("FAILED: %s on %u threads: %.17g, expected %.17g\n", workload.name, threads, result, workload.expected);
+                    ok = false;
+                }
+            }
+            const double jobsRun = (double)(jobs.jobsExecuted() - jobsBefore) / repeats;
+            const double stolen = (double)(jobs.steals() - stealsBefore) / repeats;
+
+            if (threads == 1) {
+                baseline = best;
+            }
+            printf("%-14s %8u %10.3f %7.2fx %10.0f %10.0f %8.1f\n", workload.name, threads, best * 1e3, baseline / best,
+                   jobsRun, stolen, jobsRun > 0.0 ? best * 1e9 / jobsRun : 0.0);
+        }
+        printf("\n");
+    }
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
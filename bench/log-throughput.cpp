@@ -0,0 +1,114 @@
+// Logger throughput benchmark
+//
+// Compares the old open/append/close-per-message logging with the asynchronous ring-buffer
+// logger, for 1 to N producer threads. Reports messages/second both for the producer side
+// (time until every thread returned from its last `log` call) and end-to-end (time until
+// `flush` confirmed everything reached the file).
+//
+// usage: log-throughput [messages-per-thread] [max-threads]
+
+#include "engine/core/Logger.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// The logging scheme this benchmark replaces: one fopen/fclose per message
+static bool legacy_log(const char* path, const char* message, ...) {
+    va_list arg_ptr;
+    FILE* file = fopen(path, "a");
+    if (!file) {
+        return false;
+    }
+
+    va_start(arg_ptr, message);
+    vfprintf(file, message, arg_ptr);
+    va_end(arg_ptr);
+    fclose(file);
+
+    return true;
+}
+
+static void bench_legacy(const std::string& path, int messages) {
+    fclose(fopen(path.c_str(), "w"));
+
+    auto start = Clock::now();
+    for (int i = 0; i < messages; i++) {
+        legacy_log(path.c_str(), "%f ", (float)i * 0.5f);
+    }
+    double elapsed = seconds(Clock::now() - start);
+
+    printf("%-28s threads %2d  %10d msgs  %8.3f s  %12.0f msgs/s\n",
+        "fopen per message", 1, messages, elapsed, messages / elapsed);
+}
+
+static void bench_logger(const std::string& path, int threads, int messagesPerThread) {
+    LoggerConfig config{};
+    config.path = path;
+    config.level = LogLevel::Trace;
+    config.echoErrors = false;
+    config.flushIntervalMs = 100;
+
+    Logger& logger = Logger::get();
+    if (!logger.open(config)) {
+        fprintf(stderr, "could not open %s\n", path.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::thread> producers;
+    producers.reserve(threads);
+
+    auto start = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        producers.emplace_back([t, messagesPerThread, &logger]() {
+            for (int i = 0; i < messagesPerThread; i++) {
+                logger.log(LogLevel::Debug, "[%d] vertex %d %f %f %f\n", t, i, (float)i, (float)i * 0.5f, (float)i * 0.25f);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    double produced = seconds(Clock::now() - start);
+
+    logger.flush();
+    double flushed = seconds(Clock::now() - start);
+
+    long total = (long)threads * messagesPerThread;
+    printf("%-28s threads %2d  %10ld msgs  %8.3f s  %12.0f msgs/s  (end-to-end %.0f msgs/s, %llu stalls)\n",
+        "async ring buffer", threads, total, produced, total / produced, total / flushed,
+        (unsigned long long)logger.stalls());
+
+    logger.close();
+}
+
+int main(int argc, char** argv) {
+    int messagesPerThread = argc > 1 ? atoi(argv[1]) : 1000000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "log-throughput.log").string();
+
+    // the legacy path is orders of magnitude slower, keep it short
+    bench_legacy(path, messagesPerThread / 50 > 0 ? messagesPerThread / 50 : 1);
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        bench_logger(path, threads, messagesPerThread);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
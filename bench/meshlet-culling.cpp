@@ -0,0 +1,289 @@
+// Meshlet build and cluster culling benchmark
+//
+// Builds a CAD-like mesh (a grid of finely tessellated closed parts), splits it into meshlets
+// and checks the result: every triangle exactly once, limits respected, local indices and
+// bounding spheres consistent. Then culls the meshlets from a few cameras and reports how
+// many clusters each test rejects and the triangle rejection rate, next to the share of
+// triangles a per-triangle test would reject. Every rejected meshlet is verified by brute
+// force: all of its triangles back facing, or all outside one frustum plane.
+//
+// With a headless context the compute variant runs on the same views and must agree.
+//
+// usage: meshlet-culling [parts per side] [segments] [cull shader]
+//        (default: 8 96 assets/shaders/culling/meshlet_cull.comp)
+
+#include "engine/geometry/ClusterCulling.h"
+#include "engine/geometry/Meshlets.h"
+
+#ifdef HEADLESS_ENABLED
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+struct Geometry {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+// counter-clockwise seen from outside, like the GL default front face
+static void add_sphere(Geometry& geometry, const glm::vec3& center, float radius, int segments) {
+    const uint32_t base = (uint32_t)geometry.positions.size();
+    const int rings = segments / 2;
+    for (int r = 0; r <= rings; r++) {
+        const float phi = 3.14159265f * r / rings;
+        for (int s = 0; s <= segments; s++) {
+            const float theta = 6.2831853f * s / segments;
+            geometry.positions.push_back(center + radius * glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi),
+                                                                     -std::sin(phi) * std::sin(theta)));
+        }
+    }
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            const uint32_t a = base + r * (segments + 1) + s, b = a + segments + 1;
+            if (r != 0) {
+                geometry.indices.insert(geometry.indices.end(), { a, b, a + 1 });
+            }
+            if (r != rings - 1) {
+                geometry.indices.insert(geometry.indices.end(), { a + 1, b, b + 1 });
+            }
+        }
+    }
+}
+
+static bool validate(const Geometry& geometry, const MeshletMesh& mesh) {
+    bool ok = true;
+
+    // same triangles, each once
+    std::vector<std::array<uint32_t, 3>> before, after;
+    for (size_t i = 0; i < geometry.indices.size(); i += 3) {
+        before.push_back({ geometry.indices[i], geometry.indices[i + 1], geometry.indices[i + 2] });
+    }
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        after.push_back({ mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] });
+    }
+    std::sort(before.begin(), before.end());
+    std::sort(after.begin(), after.end());
+    if (before != after) {
+        printf("  FAILED: meshlet triangles differ from the mesh's\n");
+        ok = false;
+    }
+
+    size_t triangles = 0;
+    for (size_t m = 0; m < mesh.meshlets.size(); m++) {
+        const Meshlet& meshlet = mesh.meshlets[m];
+        const MeshletBounds& bounds = mesh.bounds[m];
+        if (meshlet.vertexCount > kMeshletMaxVertices || meshlet.triangleCount > kMeshletMaxTriangles
+            || meshlet.triangleOffset != triangles) {
+            printf("  FAILED: meshlet %zu breaks the limits or is out of order\n", m);
+            ok = false;
+        }
+        triangles += meshlet.triangleCount;
+
+        for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++) {
+            const size_t at = meshlet.triangleOffset * 3 + i;
+            const uint32_t vertex = mesh.vertices[meshlet.vertexOffset + mesh.localIndices[at]];
+            if (vertex != mesh.indices[at]) {
+                printf("  FAILED: meshlet %zu local index %u does not match\n", m, i);
+                ok = false;
+                break;
+            }
+            if (glm::length(geometry.positions[vertex] - bounds.center) > bounds.radius * 1.0001f + 1e-6f) {
+                printf("  FAILED: meshlet %zu sphere does not contain vertex %u\n", m, vertex);
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+static bool back_facing(const Geometry& geometry, const uint32_t* triangle, const glm::vec3& eye) {
+    const glm::vec3 p0 = geometry.positions[triangle[0]];
+    const glm::vec3 n = glm::cross(geometry.positions[triangle[1]] - p0, geometry.positions[triangle[2]] - p0);
+    return glm::dot(n, eye - p0) <= 0.0f;
+}
+
+static bool outside_one_plane(const Geometry& geometry, const uint32_t* triangle, const Frustum& frustum) {
+    for (const glm::vec4& plane : frustum.planes) {
+        bool outside = true;
+        for (int k = 0; k < 3; k++) {
+            const glm::vec3 p = geometry.positions[triangle[k]];
+            outside = outside && glm::dot(glm::vec3(plane), p) + plane.w < 0.0f;
+        }
+        if (outside) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Camera {
+    const char* name;
+    glm::vec3 eye;
+    glm::vec3 target;
+};
+
+int main(int argc, char** argv) {
+    const int parts = argc > 1 ? atoi(argv[1]) : 8;
+    const int segments = argc > 2 ? atoi(argv[2]) : 96;
+    const std::string shaderPath = argc > 3 ? argv[3] : "assets/shaders/culling/meshlet_cull.comp";
+    if (parts < 1 || segments < 4) {
+        fprintf(stderr, "usage: meshlet-culling [parts per side >= 1] [segments >= 4] [cull shader]\n");
+        return 1;
+    }
+
+    Geometry geometry;
+    for (int z = 0; z < parts; z++) {
+        for (int x = 0; x < parts; x++) {
+            add_sphere(geometry, glm::vec3(x * 3.0f - parts * 1.5f, 0.0f, -z * 3.0f), 1.2f, segments);
+        }
+    }
+    const size_t triangleCount = geometry.indices.size() / 3;
+
+    MeshletMesh mesh;
+    auto start = Clock::now();
+    build_meshlets(geometry.positions.data(), sizeof(glm::vec3), geometry.positions.size(),
+                   geometry.indices.data(), geometry.indices.size(), mesh);
+    const double build = seconds(Clock::now() - start);
+
+    size_t coneless = 0;
+    for (const MeshletBounds& bounds : mesh.bounds) {
+        coneless += bounds.coneCutoff >= 1.0f;
+    }
+    printf("%zu triangles, %zu vertices -> %zu meshlets in %.1f ms (%.2f M triangles/s)\n", triangleCount,
+        geometry.positions.size(), mesh.meshlets.size(), build * 1e3, triangleCount / build * 1e-6);
+    printf("  %.1f vertices, %.1f triangles per meshlet (limits %zu / %zu), %zu without a usable cone\n\n",
+        (double)mesh.vertices.size() / mesh.meshlets.size(), (double)triangleCount / mesh.meshlets.size(),
+        kMeshletMaxVertices, kMeshletMaxTriangles, coneless);
+
+    bool ok = validate(geometry, mesh);
+
+    const float aspect = 16.0f / 9.0f;
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 500.0f);
+    const Camera cameras[] = {
+        { "overview", glm::vec3(0.0f, 20.0f, 25.0f), glm::vec3(0.0f, 0.0f, -parts * 1.5f) },
+        { "street level", glm::vec3(-parts * 1.5f - 4.0f, 0.5f, 4.0f), glm::vec3(0.0f, 0.0f, -parts * 1.5f) },
+        { "close up", glm::vec3(0.0f, 0.3f, 2.5f), glm::vec3(0.0f, 0.0f, 0.0f) },
+    };
+
+    printf("%-14s %9s %9s %9s %10s %10s %10s %10s\n", "view", "clusters", "frustum", "backface",
+        "rejected", "per-tri", "cull us", "commands");
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<std::vector<ClusterVisibility>> expected;
+    for (const Camera& camera : cameras) {
+        const glm::mat4 viewProjection = projection * glm::lookAt(camera.eye, camera.target, glm::vec3(0.0f, 1.0f, 0.0f));
+        const ClusterView view(viewProjection, glm::mat4(1.0f), camera.eye);
+
+        // the best any per-triangle test could do: back facing or entirely outside one plane
+        size_t ideal = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            const uint32_t* triangle = &geometry.indices[t * 3];
+            ideal += back_facing(geometry, triangle, camera.eye) || outside_one_plane(geometry, triangle, view.frustum);
+        }
+
+        const int repeats = 20;
+        ClusterCullStats stats;
+        start = Clock::now();
+        for (int r = 0; r < repeats; r++) {
+            commands.clear();
+            stats = ClusterCullStats();
+            cull_meshlets(mesh, view, commands, stats);
+        }
+        const double cull = seconds(Clock::now() - start) / repeats;
+
+        printf("%-14s %9zu %9zu %9zu %9.1f%% %9.1f%% %10.1f %10zu\n", camera.name, stats.clusters,
+            stats.frustumRejected, stats.backfaceRejected, stats.rejectionRate() * 100.0,
+            100.0 * ideal / triangleCount, cull * 1e6, commands.size());
+
+        // every rejection must be one a per-triangle test agrees with
+        std::vector<ClusterVisibility> visibility(mesh.meshlets.size());
+        for (size_t m = 0; m < mesh.meshlets.size(); m++) {
+            visibility[m] = classify_meshlet(mesh.bounds[m], view);
+            const Meshlet& meshlet = mesh.meshlets[m];
+            for (uint32_t t = 0; t < meshlet.triangleCount && visibility[m] != ClusterVisibility::Visible; t++) {
+                const uint32_t* triangle = &mesh.indices[(meshlet.triangleOffset + t) * 3];
+                const bool rejected = visibility[m] == ClusterVisibility::BackFacing
+                    ? back_facing(geometry, triangle, camera.eye)
+                    : outside_one_plane(geometry, triangle, view.frustum);
+                if (!rejected) {
+                    printf("  FAILED: meshlet %zu rejected but triangle %u is visible\n", m, t);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        expected.push_back(visibility);
+    }
+
+#ifdef HEADLESS_ENABLED
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, 64, 64, "meshlet-culling");
+    if (window.initialized()) {
+        window.makeContextCurrent();
+        GpuClusterCuller culler;
+        if (!culler.init(shaderPath)) {
+            printf("FAILED: could not build %s\n", shaderPath.c_str());
+            return 1;
+        }
+
+        GLuint buffers[3];
+        glGenBuffers(3, buffers);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, mesh.meshlets.size() * sizeof(Meshlet), mesh.meshlets.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[1]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, mesh.bounds.size() * sizeof(MeshletBounds), mesh.bounds.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[2]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, mesh.meshlets.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_READ);
+
+        printf("\ncompute variant (%s):\n", glGetString(GL_RENDERER));
+        std::vector<DrawElementsIndirectCommand> gpuCommands(mesh.meshlets.size());
+        for (size_t c = 0; c < expected.size(); c++) {
+            const Camera& camera = cameras[c];
+            const glm::mat4 viewProjection = projection * glm::lookAt(camera.eye, camera.target, glm::vec3(0.0f, 1.0f, 0.0f));
+            const ClusterView view(viewProjection, glm::mat4(1.0f), camera.eye);
+
+            culler.resetStats();
+            culler.cull(buffers[0], buffers[1], buffers[2], (uint32_t)mesh.meshlets.size(), view);
+            const ClusterCullStats stats = culler.readStats();
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[2]);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuCommands.size() * sizeof(DrawElementsIndirectCommand), gpuCommands.data());
+
+            // float rounding may flip a cluster sitting exactly on a boundary, nothing more
+            size_t disagreements = 0;
+            for (size_t m = 0; m < mesh.meshlets.size(); m++) {
+                const bool visible = expected[c][m] == ClusterVisibility::Visible;
+                disagreements += visible != (gpuCommands[m].instanceCount != 0);
+            }
+            const bool agree = disagreements <= mesh.meshlets.size() / 1000;
+            printf("%-14s %9zu %9zu %9zu %9.1f%%   %zu disagreements with the CPU%s\n", camera.name, stats.clusters,
+                stats.frustumRejected, stats.backfaceRejected, stats.rejectionRate() * 100.0, disagreements,
+                agree ? "" : "  FAILED");
+            ok = ok && agree;
+        }
+        glDeleteBuffers(3, buffers);
+    }
+#endif
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
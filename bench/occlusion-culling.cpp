@@ -0,0 +1,324 @@
+// Hi-Z occlusion culling benchmark
+//
+// CPU checks of the depth pyramid:
+//   - every level is the farthest depth of the texels it covers, on odd sized depth buffers
+//   - a box the pyramid hides is hidden behind every depth texel it covers (never a false
+//     "occluded"), and how many of the truly hidden boxes it finds
+// then, with a headless context, walks through the "Occlusion Culling" level (rooms behind
+// tall walls, thousands of props) with each culling mode and prints the frame time, the
+// instances culled by the frustum and by the pyramid, the ones drawn in the early and the
+// late pass and the gain over frustum culling alone:
+//   none          every instance, one instanced draw
+//   frustum       frustum culled on the GPU
+//   two-phase     frustum and Hi-Z, last frame's visible set first, then what appeared
+// The pyramid built on the GPU must match the CPU one built from the same depth, the late
+// pass must agree with box_occluded, and every frame of the walk must look the same with
+// and without occlusion culling (nothing pops in a frame late).
+//
+// usage: occlusion-culling [width] [height] [frames]   (default: 480 270 8)
+
+#include "engine/render/OcclusionCulling.h"
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestOcclusion.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+/// Farthest depth texel a uv rectangle touches, by brute force
+static float farthest_covered(const std::vector<float>& depth, int width, int height, const ProjectedBox& box) {
+    const int x0 = std::min((int)(box.uvMin.x * width), width - 1);
+    const int x1 = std::min((int)(box.uvMax.x * width), width - 1);
+    const int y0 = std::min((int)(box.uvMin.y * height), height - 1);
+    const int y1 = std::min((int)(box.uvMax.y * height), height - 1);
+    float farthest = 0.0f;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            farthest = std::max(farthest, depth[(size_t)y * width + x]);
+        }
+    }
+    return farthest;
+}
+
+static bool check_pyramid(int width, int height) {
+    std::mt19937 rng(width * 31 + height);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // a few "walls" in front of a far background
+    std::vector<float> depth((size_t)width * height, 0.999f);
+    for (int wall = 0; wall < 12; wall++) {
+        const int x0 = (int)(unit(rng) * width), x1 = std::min(width, x0 + 1 + (int)(unit(rng) * width * 0.5f));
+        const int y0 = (int)(unit(rng) * height), y1 = std::min(height, y0 + 1 + (int)(unit(rng) * height * 0.7f));
+        const float z = 0.9f + 0.09f * unit(rng);
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                depth[(size_t)y * width + x] = std::min(depth[(size_t)y * width + x], z);
+            }
+        }
+    }
+
+    DepthPyramid pyramid;
+    pyramid.build(depth.data(), width, height);
+    const glm::ivec2 top = pyramid.levelSize(pyramid.levelCount() - 1);
+    if (top.x != 1 || top.y != 1) {
+        printf("FAILED: the top of the %dx%d pyramid is %dx%d\n", width, height, top.x, top.y);
+        return false;
+    }
+    const float farthest = *std::max_element(depth.begin(), depth.end());
+    if (pyramid.texel(pyramid.levelCount() - 1, 0, 0) != farthest) {
+        printf("FAILED: the top of the %dx%d pyramid is not the farthest depth\n", width, height);
+        return false;
+    }
+
+    size_t hidden = 0, found = 0;
+    for (int trial = 0; trial < 20000; trial++) {
+        ProjectedBox box;
+        const glm::vec2 a(unit(rng), unit(rng));
+        const glm::vec2 extent = glm::vec2(unit(rng), unit(rng)) * (unit(rng) < 0.8f ? 0.05f : 0.5f);
+        box.uvMin = a;
+        box.uvMax = glm::min(a + extent, glm::vec2(1.0f));
+        box.nearestDepth = 0.9f + 0.1f * unit(rng);
+        box.crossesNear = false;
+        box.outside = false;
+
+        const bool occluded = box.nearestDepth > farthest_covered(depth, width, height, box);
+        if (box_occluded(pyramid, box) && !occluded) {
+            printf("FAILED: the %dx%d pyramid hides a visible box (%.4f %.4f to %.4f %.4f at %.4f)\n", width, height,
+                   box.uvMin.x, box.uvMin.y, box.uvMax.x, box.uvMax.y, box.nearestDepth);
+            return false;
+        }
+        hidden += occluded;
+        found += occluded && box_occluded(pyramid, box);
+    }
+    printf("  %4dx%-4d %2zu levels, base %4dx%-4d  conservative, finds %5.1f%% of %zu hidden boxes\n", width, height,
+           pyramid.levelCount(), pyramid.levelSize(0).x, pyramid.levelSize(0).y, 100.0 * found / std::max<size_t>(hidden, 1),
+           hidden);
+    return true;
+}
+
+#ifdef HEADLESS_ENABLED
+struct Result {
+    double frameMs;
+    OcclusionStats stats;
+};
+
+static const char* kModeNames[] = { "none", "frustum", "two-phase" };
+
+static Result run(test::TestOcclusion& app, test::OcclusionMode mode, int frames) {
+    Result result{};
+    app.setMode(mode);
+    app.setTime(0.0f);
+    app.setWalking(true);
+    for (int frame = 0; frame <= frames; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+        const auto start = Clock::now();
+        app.onRender();
+        glFinish();
+        app.onUpdate(1.0f / 5.0f);
+        // frame 0 warms the shader caches and, culling, gets the first visible set
+        if (frame == 0) {
+            app.culler().resetStats();
+            continue;
+        }
+        result.frameMs += seconds(Clock::now() - start) * 1e3;
+    }
+    result.frameMs /= frames;
+
+    if (mode == test::OcclusionMode::None) {
+        result.stats.instances = app.bounds().size() * frames;
+        result.stats.drawnEarly = app.bounds().size() * frames;
+    } else {
+        result.stats = app.culler().readStats();
+    }
+    return result;
+}
+
+/// Pixels with a channel off by more than `tolerance`
+static size_t compare(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int tolerance) {
+    size_t pixels = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        int worst = 0;
+        for (size_t c = 0; c < 3; c++) {
+            worst = std::max(worst, std::abs((int)a[i + c] - (int)b[i + c]));
+        }
+        pixels += worst > tolerance;
+    }
+    return pixels;
+}
+
+/// The GPU pyramid of the last frame's final depth against the CPU one, then the late pass against box_occluded
+static bool check_gpu(test::TestOcclusion& app) {
+    const Framebuffer& frame = app.target();
+    std::vector<float> depth((size_t)frame.width() * frame.height());
+    glBindTexture(GL_TEXTURE_2D, frame.depthTexture());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GpuOcclusionCuller& culler = app.culler();
+    culler.buildPyramid(frame.depthTexture(), frame.width(), frame.height());
+    DepthPyramid cpu, gpu;
+    cpu.build(depth.data(), frame.width(), frame.height());
+    culler.readPyramid(gpu);
+    size_t texels = 0, differing = 0;
+    for (size_t level = 0; level < cpu.levelCount(); level++) {
+        for (size_t i = 0; i < cpu.level(level).size(); i++) {
+            differing += cpu.level(level)[i] != gpu.level(level)[i];
+        }
+        texels += cpu.level(level).size();
+    }
+    printf("\nGPU vs CPU pyramid             %zu of %zu texels differ over %zu levels\n", differing, texels, cpu.levelCount());
+    if (differing != 0) {
+        printf("FAILED: the pyramids differ\n");
+        return false;
+    }
+
+    // the late pass writes the visibility of what it tested: in the frustum and not occluded
+    const glm::mat4 viewProjection = app.viewProjection();
+    culler.cull(OcclusionPass::Late, viewProjection);
+    std::vector<uint32_t> visibility;
+    culler.readVisibility(visibility);
+    const std::vector<OcclusionBounds>& bounds = app.bounds();
+    size_t occluded = 0, noise = 0, mismatches = 0;
+    for (size_t i = 0; i < bounds.size(); i++) {
+        const ProjectedBox box = project_box(glm::vec3(bounds[i].minPoint), glm::vec3(bounds[i].maxPoint), viewProjection);
+        const bool hiddenFar = box.outside || box_occluded(cpu, box, 1e-6f);
+        const bool hiddenNear = box.outside || box_occluded(cpu, box, -1e-6f);
+        const bool visible = visibility[i] != 0;
+        occluded += !box.outside && box_occluded(cpu, box);
+        if (hiddenFar != hiddenNear) {
+            noise++;
+        } else if (visible == hiddenFar) {
+            mismatches++;
+        }
+    }
+    printf("late pass vs box_occluded      %zu of %zu instances disagree, %zu within float noise, %zu occluded\n",
+           mismatches, bounds.size(), noise, occluded);
+    // float noise the depth slack can't see: a box right on a texel or a frustum plane
+    if (mismatches * 1000 > bounds.size()) {
+        printf("FAILED: the GPU and the CPU occlusion tests disagree\n");
+        return false;
+    }
+    return true;
+}
+#endif
+
+int main(int argc, char** argv) {
+    printf("depth pyramid\n");
+    for (const glm::ivec2 size : { glm::ivec2(320, 180), glm::ivec2(331, 187), glm::ivec2(1920, 1080), glm::ivec2(97, 403) }) {
+        if (!check_pyramid(size.x, size.y)) {
+            printf("FAILED\n");
+            return 1;
+        }
+    }
+
+#ifdef HEADLESS_ENABLED
+    const int width = argc > 1 ? atoi(argv[1]) : 480;
+    const int height = argc > 2 ? atoi(argv[2]) : 270;
+    const int frames = argc > 3 ? atoi(argv[3]) : 8;
+
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, width, height, "occlusion-culling");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    FramebufferConfig targetConfig{};
+    targetConfig.width = width;
+    targetConfig.height = height;
+    targetConfig.colorAttachments = { Framebuffer::rgba8() };
+    targetConfig.depth = true;
+    targetConfig.depthFormat = GL_DEPTH_COMPONENT24;
+    Framebuffer target;
+    if (!target.create(targetConfig)) {
+        printf("FAILED: could not create the %dx%d target\n", width, height);
+        return 1;
+    }
+
+    test::TestOcclusion app;
+    if (!app.culler().initialized()) {
+        printf("FAILED: could not build assets/shaders/culling\n");
+        return 1;
+    }
+
+    target.bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    printf("\nGL (%s), %dx%d target, %zu instances, %d frames per run\n\n", glGetString(GL_RENDERER), width, height,
+           app.bounds().size(), frames);
+
+    printf("%-10s %9s %10s %10s %10s %10s %10s %10s\n", "culling", "frame ms", "instances", "frustum", "occluded",
+           "drawn", "early", "late");
+    printf("%-10s %9s %10s %10s %10s %10s %10s %10s\n", "", "", "", "culled", "", "", "", "");
+    Result results[3];
+    for (int mode = 0; mode < 3; mode++) {
+        results[mode] = run(app, (test::OcclusionMode)mode, frames);
+        const OcclusionStats& stats = results[mode].stats;
+        printf("%-10s %9.3f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", kModeNames[mode], results[mode].frameMs,
+               (double)stats.instances / frames, (double)stats.frustumCulled / frames, (double)stats.occluded / frames,
+               (double)stats.drawn() / frames, (double)stats.drawnEarly / frames, (double)stats.drawnLate / frames);
+    }
+    const double frustumMs = results[(int)test::OcclusionMode::Frustum].frameMs;
+    const double twoPhaseMs = results[(int)test::OcclusionMode::TwoPhase].frameMs;
+    printf("\ntwo-phase vs frustum only      %.3f ms per frame saved (%.0f%%), %.2fx vs no culling\n",
+           frustumMs - twoPhaseMs, 100.0 * (frustumMs - twoPhaseMs) / frustumMs,
+           results[(int)test::OcclusionMode::None].frameMs / twoPhaseMs);
+    printf("culling buffers and pyramid    %.2f MB\n", app.culler().byteSize() / (1024.0 * 1024.0));
+
+    if (!check_gpu(app)) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    // the walk again, every frame with and without culling from the same spot
+    bool ok = true;
+    size_t worst = 0;
+    std::vector<unsigned char> culled, reference;
+    app.setWalking(false);
+    for (int frame = 0; frame < frames; frame++) {
+        app.setTime(frame / 5.0f);
+        app.setMode(test::OcclusionMode::TwoPhase);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        app.onRender();
+        target.readPixels(culled);
+        app.setMode(test::OcclusionMode::None);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        app.onRender();
+        target.readPixels(reference);
+        worst = std::max(worst, compare(culled, reference, 0));
+    }
+    printf("two-phase vs no culling        at most %zu differing pixels per frame over %d frames\n", worst, frames);
+    if (worst * 2000 > (size_t)width * height) {
+        printf("FAILED: occlusion culling changes the image\n");
+        ok = false;
+    }
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    (void)seconds;
+    printf("\nthe culling timings need a headless EGL build (HEADLESS_ENABLED)\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,301 @@
+// Post-processing chain benchmark
+//
+// With a headless context, checks the chain on synthetic HDR images first:
+//   - with only tone mapping on, clamp and ACES match the curve computed on the CPU
+//   - bloom spreads a small very bright square into the black around it, and nothing
+//     below the threshold blooms
+//   - FXAA leaves flat areas alone and softens a hard diagonal edge
+//   - the render target pool allocates on the first frame only, reuses every target after,
+//     and drops the targets of an old size once they sat idle
+// then post-processes the "Deferred Lights" scene at a few sizes and prints the GPU time of
+// each pass and the render target bytes allocated and reused per frame.
+//
+// usage: post-processing [frames]   (default: 8)
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestDeferredLights.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/opengl/RenderTargetPool.h"
+#include "engine/render/PostProcess.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+#ifdef HEADLESS_ENABLED
+
+static const RenderTargetDesc kSceneTarget = { 0, 0, GL_RGBA16F, GL_DEPTH24_STENCIL8, GL_LINEAR };
+
+static RenderTargetDesc scene_desc(int width, int height) {
+    RenderTargetDesc desc = kSceneTarget;
+    desc.width = width;
+    desc.height = height;
+    return desc;
+}
+
+/// Fills `rect` of the bound framebuffer with an HDR color
+static void fill(int x, int y, int width, int height, const glm::vec4& color) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x, y, width, height);
+    glClearBufferfv(GL_COLOR, 0, &color.x);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+/// Post-processes the bound scene into `output`, read back as RGBA8
+static void run_chain(PostProcessor& post, RenderTargetPool& pool, const Framebuffer& scene, const Framebuffer& output,
+                      std::vector<unsigned char>& pixels) {
+    post.render(scene, output.id(), output.width(), output.height(), pool);
+    output.readPixels(pixels);
+}
+
+static int channel(const std::vector<unsigned char>& pixels, int width, int x, int y, int c) {
+    return pixels[((size_t)y * width + x) * 4 + c];
+}
+
+static float aces(float x) {
+    return std::min(std::max((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f), 0.0f), 1.0f);
+}
+
+static bool check_chain(PostProcessor& post, RenderTargetPool& pool) {
+    const int size = 128;
+    Framebuffer* scene = pool.acquire(scene_desc(size, size));
+    Framebuffer output({ size, size, { Framebuffer::rgba8() }, false, GL_DEPTH_COMPONENT24 });
+    if (!scene || !output.id()) {
+        printf("FAILED: could not create the targets\n");
+        return false;
+    }
+    std::vector<unsigned char> pixels;
+    bool ok = true;
+
+    // tone mapping alone, four flat quadrants
+    const glm::vec4 quadrants[4] = { glm::vec4(0.25f, 0.5f, 0.75f, 1.0f), glm::vec4(0.9f, 1.5f, 3.0f, 1.0f),
+                                     glm::vec4(6.0f, 0.1f, 0.0f, 1.0f), glm::vec4(0.02f, 0.04f, 12.0f, 1.0f) };
+    scene->bind();
+    for (int q = 0; q < 4; q++) {
+        fill((q % 2) * size / 2, (q / 2) * size / 2, size / 2, size / 2, quadrants[q]);
+    }
+    PostSettings settings;
+    settings.bloom = false;
+    settings.grading = false;
+    settings.fxaa = false;
+    for (ToneMapper toneMapper : { ToneMapper::Clamp, ToneMapper::ACES }) {
+        settings.toneMapper = toneMapper;
+        post.setSettings(settings);
+        run_chain(post, pool, *scene, output, pixels);
+        int worst = 0;
+        for (int q = 0; q < 4; q++) {
+            const int x = (q % 2) * size / 2 + size / 4, y = (q / 2) * size / 2 + size / 4;
+            for (int c = 0; c < 3; c++) {
+                const float value = quadrants[q][c];
+                const float expected = toneMapper == ToneMapper::ACES ? aces(value) : std::min(value, 1.0f);
+                worst = std::max(worst, std::abs(channel(pixels, size, x, y, c) - (int)std::lround(expected * 255.0f)));
+            }
+        }
+        printf("  tone map %-8s off by at most %d/255 from the CPU curve\n", tone_mapper_name(toneMapper), worst);
+        // RGBA16F input: a couple of steps of rounding
+        if (worst > 2) {
+            printf("FAILED: the %s curve is wrong\n", tone_mapper_name(toneMapper));
+            ok = false;
+        }
+    }
+
+    // bloom: a very bright square and a dim one on black
+    scene->bind();
+    fill(0, 0, size, size, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    fill(size / 4 - 2, size / 2 - 2, 4, 4, glm::vec4(40.0f, 40.0f, 40.0f, 1.0f));
+    fill(3 * size / 4 - 2, size / 2 - 2, 4, 4, glm::vec4(0.4f, 0.4f, 0.4f, 1.0f));
+    settings.toneMapper = ToneMapper::Clamp;
+    settings.bloom = true;
+    settings.bloomThreshold = 1.0f;
+    settings.bloomKnee = 0.1f;
+    post.setSettings(settings);
+    run_chain(post, pool, *scene, output, pixels);
+    const int glow = channel(pixels, size, size / 4 + 8, size / 2, 0);
+    const int dimGlow = channel(pixels, size, 3 * size / 4 + 8, size / 2, 0);
+    printf("  bloom: 8 pixels from the bright square %d/255, from the dim one %d/255\n", glow, dimGlow);
+    if (glow < 8 || dimGlow != 0) {
+        printf("FAILED: bloom does not spread what it should\n");
+        ok = false;
+    }
+
+    // FXAA: a hard diagonal edge, stair stepped, white over black
+    scene->bind();
+    fill(0, 0, size, size, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    for (int y = 0; y < size; y++) {
+        fill(0, y, y * 3 / 5, 1, glm::vec4(1.0f));
+    }
+    settings.bloom = false;
+    std::vector<unsigned char> aliased;
+    for (bool fxaa : { false, true }) {
+        settings.fxaa = fxaa;
+        post.setSettings(settings);
+        run_chain(post, pool, *scene, output, fxaa ? pixels : aliased);
+    }
+    size_t smoothed = 0, changedFlat = 0;
+    for (int y = 2; y < size - 2; y++) {
+        for (int x = 2; x < size - 2; x++) {
+            const int before = channel(aliased, size, x, y, 0), after = channel(pixels, size, x, y, 0);
+            const bool nearEdge = std::abs(x - y * 3 / 5) <= 2;
+            smoothed += nearEdge && before != after && after != 0 && after != 255;
+            changedFlat += !nearEdge && before != after;
+        }
+    }
+    printf("  fxaa: %zu edge pixels blended, %zu pixels away from the edge changed\n", smoothed, changedFlat);
+    if (smoothed < (size_t)size / 2 || changedFlat) {
+        printf("FAILED: FXAA does not smooth the edge alone\n");
+        ok = false;
+    }
+
+    pool.release(scene);
+    return ok;
+}
+
+static bool check_pool(PostProcessor& post, RenderTargetPool& pool) {
+    PostSettings settings;
+    post.setSettings(settings);
+    Framebuffer output({ 96, 64, { Framebuffer::rgba8() }, false, GL_DEPTH_COMPONENT24 });
+    pool.clear();
+
+    bool ok = true;
+    uint64_t firstBytes = 0;
+    for (int frame = 0; frame < 4; frame++) {
+        pool.beginFrame();
+        Framebuffer* scene = pool.acquire(scene_desc(96, 64));
+        post.render(*scene, output.id(), 96, 64, pool);
+        pool.release(scene);
+        const RenderTargetPoolStats& stats = pool.frameStats();
+        if (frame == 0) {
+            firstBytes = stats.allocatedBytes;
+            printf("  first frame: %u targets allocated, %.1f KB, %u reused\n", stats.allocated, stats.allocatedBytes / 1024.0,
+                   stats.reused);
+        }
+        else if (stats.allocated != 0 || stats.reusedBytes < firstBytes) {
+            printf("FAILED: frame %d allocated %u targets, reused %.1f KB\n", frame, stats.allocated, stats.reusedBytes / 1024.0);
+            ok = false;
+        }
+    }
+    printf("  later frames: nothing allocated, %.1f KB reused each, %zu targets in the pool\n",
+           pool.frameStats().reusedBytes / 1024.0, pool.targetCount());
+
+    // a new size: the old targets go once idle, leaving what a fresh pool would hold
+    const uint64_t before = pool.byteSize();
+    for (uint64_t frame = 0; frame <= RenderTargetPool::kMaxIdleFrames + 1; frame++) {
+        pool.beginFrame();
+        Framebuffer* scene = pool.acquire(scene_desc(48, 32));
+        post.render(*scene, output.id(), 96, 64, pool);
+        pool.release(scene);
+    }
+    RenderTargetPool fresh;
+    Framebuffer* scene = fresh.acquire(scene_desc(48, 32));
+    post.render(*scene, output.id(), 96, 64, fresh);
+    fresh.release(scene);
+    printf("  after a resize: pool %.1f KB, was %.1f KB, a fresh pool %.1f KB\n", pool.byteSize() / 1024.0, before / 1024.0,
+           fresh.byteSize() / 1024.0);
+    if (pool.byteSize() != fresh.byteSize() || pool.targetCount() != fresh.targetCount()) {
+        printf("FAILED: the targets of the old size are still alive\n");
+        ok = false;
+    }
+    pool.clear();
+    return ok;
+}
+
+#endif
+
+int main(int argc, char** argv) {
+#ifdef HEADLESS_ENABLED
+    const int frames = argc > 1 ? atoi(argv[1]) : 8;
+
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, 64, 64, "post-processing");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    PostProcessor post;
+    if (!post.init()) {
+        printf("FAILED: could not build assets/shaders/post\n");
+        return 1;
+    }
+    RenderTargetPool pool;
+
+    printf("GL (%s)\n\nchecks\n", glGetString(GL_RENDERER));
+    if (!check_chain(post, pool) || !check_pool(post, pool)) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    test::TestDeferredLights app;
+    app.setPath(ShadingPath::DeferredFullScreen);
+    app.setLightCount(64);
+    post.setSettings(PostSettings());
+
+    printf("\n\"Deferred Lights\", all passes on, %d frames per size\n\n", frames);
+    printf("%-10s", "size");
+    for (size_t pass = 0; pass < PostStats::kPasses; pass++) {
+        printf(" %10s", post_pass_name((PostPass)pass));
+    }
+    printf(" %10s %10s %8s %12s %12s %10s\n", "total ms", "cpu ms", "draws", "alloc KB/f", "reused KB/f", "pool MB");
+    for (const glm::ivec2 size : { glm::ivec2(320, 180), glm::ivec2(640, 360), glm::ivec2(1280, 720) }) {
+        Framebuffer output({ size.x, size.y, { Framebuffer::rgba8() }, false, GL_DEPTH_COMPONENT24 });
+        double gpuMs[PostStats::kPasses] = {};
+        double cpuMs = 0.0;
+        uint64_t allocated = 0, reused = 0;
+        int timed = 0;
+        for (int frame = 0; frame < frames + 2; frame++) {
+            pool.beginFrame();
+            Framebuffer* scene = pool.acquire(scene_desc(size.x, size.y));
+            scene->bind();
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glEnable(GL_DEPTH_TEST);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            app.onUpdate(1.0f / 60.0f);
+            app.onRender();
+            post.render(*scene, output.id(), size.x, size.y, pool);
+            pool.release(scene);
+            glFinish();
+            // the first frame allocates, the second's timings come from the first
+            if (frame >= 2) {
+                for (size_t pass = 0; pass < PostStats::kPasses; pass++) {
+                    gpuMs[pass] += post.stats().gpuMs[pass];
+                }
+                cpuMs += post.stats().cpuMs;
+                timed++;
+            }
+            allocated += pool.frameStats().allocatedBytes;
+            reused += pool.frameStats().reusedBytes;
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "%dx%d", size.x, size.y);
+        printf("%-10s", label);
+        double total = 0.0;
+        for (size_t pass = 0; pass < PostStats::kPasses; pass++) {
+            printf(" %10.3f", gpuMs[pass] / timed);
+            total += gpuMs[pass] / timed;
+        }
+        printf(" %10.3f %10.3f %8u %12.1f %12.1f %10.2f\n", total, cpuMs / timed, post.stats().draws,
+               allocated / 1024.0 / (frames + 2), reused / 1024.0 / (frames + 2), pool.byteSize() / 1048576.0);
+    }
+    (void)seconds;
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    (void)seconds;
+    printf("the post-processing checks need a headless EGL build (HEADLESS_ENABLED)\n");
+    return 0;
+#endif
+}
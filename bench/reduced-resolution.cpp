@@ -0,0 +1,421 @@
+// Reduced resolution passes benchmark
+//
+// With a headless context, checks the passes on a synthetic depth buffer with a foreground
+// on the left and the background on the right, split off the 4 pixel grid:
+//   - reduced depth is linear view depth, the nearest texel of each block
+//   - a pass that draws nothing leaves the target as it was, whatever the composite mode
+//   - an effect on the foreground alone, run at quarter resolution, matches the full
+//     resolution one once upsampled bilaterally; upsampled bilinearly it bleeds onto the
+//     background along the silhouette
+//   - passes at the same resolution share one reduced depth, and a steady frame takes
+//     every target from the pool
+// then renders "Deferred Lights" and runs three stand-ins for the effects that don't need
+// every pixel at full, half and quarter resolution, and prints the GPU time of the depth
+// reduction, the draw and the composite of each:
+//   ambient occlusion   16 depth taps per pixel, multiplied in
+//   volumetric fog      32 ray-march steps through a procedural density, over the scene
+//   particles           4096 soft point sprites faded against the depth, added
+//
+// usage: reduced-resolution [frames]   (default: 8)
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestDeferredLights.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/opengl/RenderTargetPool.h"
+#include "engine/render/ReducedResolution.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+#ifdef HEADLESS_ENABLED
+
+static GLuint build_program(const char* vertex, const char* fragment) {
+    const GLuint program = glCreateProgram();
+    const std::pair<GLenum, const char*> stages[] = { { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment } };
+    for (const auto& stage : stages) {
+        const GLuint shader = glCreateShader(stage.first);
+        glShaderSource(shader, 1, &stage.second, nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = {};
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        printf("program failed to link:\n%s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static const char* kFullScreen = R"(#version 450
+out vec2 uv;
+void main() {
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// white where the reduced depth is the foreground's
+static const char* kForeground = R"(#version 450
+layout(binding = 0) uniform sampler2D depth;
+out vec4 color;
+void main() {
+    color = texelFetch(depth, ivec2(gl_FragCoord.xy), 0).r < 1.0 ? vec4(1.0) : vec4(0.0);
+}
+)";
+
+static const char* kAmbientOcclusion = R"(#version 450
+layout(binding = 0) uniform sampler2D depth;
+uniform float radius;
+in vec2 uv;
+out vec4 color;
+void main() {
+    float z = texture(depth, uv).r;
+    float occlusion = 0.0;
+    for (int i = 0; i < 16; i++) {
+        float angle = float(i) * 2.399963;
+        vec2 offset = vec2(cos(angle), sin(angle)) * (float(i) + 0.5) / 16.0 * radius / z;
+        float difference = z - texture(depth, uv + offset).r;
+        occlusion += difference > 0.02 * z && difference < 2.0 ? 1.0 : 0.0;
+    }
+    float ao = 1.0 - 0.8 * occlusion / 16.0;
+    color = vec4(ao, ao, ao, 1.0);
+}
+)";
+
+static const char* kFog = R"(#version 450
+layout(binding = 0) uniform sampler2D depth;
+in vec2 uv;
+out vec4 color;
+float density(vec3 p) {
+    return 0.02 * (1.0 + sin(p.x * 3.1 + p.z * 0.7) * sin(p.y * 5.3 - p.z * 0.4));
+}
+void main() {
+    float z = min(texture(depth, uv).r, 30.0);
+    float transmittance = 1.0;
+    vec3 light = vec3(0.0);
+    for (int i = 0; i < 32; i++) {
+        float t = (float(i) + 0.5) / 32.0 * z;
+        float extinction = density(vec3(uv * 4.0, t)) * z / 32.0;
+        light += transmittance * extinction * vec3(0.6, 0.7, 0.9);
+        transmittance *= exp(-extinction);
+    }
+    color = vec4(light, 1.0 - transmittance);
+}
+)";
+
+static const char* kParticlesVertex = R"(#version 450
+uniform vec2 depthRange;
+uniform float pointSize;
+out float particleDepth;
+float hash(uint n) {
+    n = (n << 13u) ^ n;
+    n = n * (n * n * 15731u + 789221u) + 1376312589u;
+    return float(n & 0x7fffffffu) / float(0x7fffffff);
+}
+void main() {
+    uint id = uint(gl_VertexID);
+    particleDepth = mix(1.0, 30.0, hash(id * 3u + 2u));
+    float n = depthRange.x, f = depthRange.y;
+    float ndc = (f + n - 2.0 * n * f / particleDepth) / (f - n);
+    gl_Position = vec4(hash(id * 3u) * 2.0 - 1.0, hash(id * 3u + 1u) * 2.0 - 1.0, ndc, 1.0);
+    gl_PointSize = max(pointSize / particleDepth, 1.0);
+}
+)";
+
+static const char* kParticlesFragment = R"(#version 450
+layout(binding = 0) uniform sampler2D depth;
+in float particleDepth;
+out vec4 color;
+void main() {
+    vec2 p = gl_PointCoord * 2.0 - 1.0;
+    float shape = max(1.0 - dot(p, p), 0.0);
+    float scene = texelFetch(depth, ivec2(gl_FragCoord.xy), 0).r;
+    float soft = clamp((scene - particleDepth) * 2.0, 0.0, 1.0);
+    color = vec4(vec3(1.0, 0.6, 0.3) * 0.15 * shape * soft, 0.0);
+}
+)";
+
+static float linearize(float depth, float nearPlane, float farPlane) {
+    return nearPlane * farPlane / (farPlane - depth * (farPlane - nearPlane));
+}
+
+static int channel(const std::vector<unsigned char>& pixels, int width, int x, int y, int c) {
+    return pixels[((size_t)y * width + x) * 4 + c];
+}
+
+/// Foreground depth left of `edge`, background right of it
+static void fill_depth(const Framebuffer& scene, int edge, float foreground, float background) {
+    scene.bind();
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, edge, scene.height());
+    glClearBufferfv(GL_DEPTH, 0, &foreground);
+    glScissor(edge, 0, scene.width() - edge, scene.height());
+    glClearBufferfv(GL_DEPTH, 0, &background);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void clear_color(const Framebuffer& target, float value) {
+    const GLfloat color[4] = { value, value, value, 1.0f };
+    target.bind();
+    glClearBufferfv(GL_COLOR, 0, color);
+}
+
+static bool check_passes(ReducedResolution& reduced, RenderTargetPool& pool, GLuint foregroundProgram) {
+    const int width = 256, height = 64, edge = 102;
+    const float foreground = 0.5f, background = 0.999f;
+    const ReducedResolutionSettings& settings = reduced.settings();
+    Framebuffer scene({ width, height, { Framebuffer::rgba8() }, true, GL_DEPTH24_STENCIL8 });
+    if (!scene.id()) {
+        printf("FAILED: could not create the targets\n");
+        return false;
+    }
+    fill_depth(scene, edge, foreground, background);
+    std::vector<unsigned char> pixels, reference;
+    auto nothing = [](const ReducedPassView&) {};
+    auto draw_foreground = [&](const ReducedPassView& view) {
+        glUseProgram(foregroundProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, view.depth);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    };
+
+    // reduced depth, the quarter block across the edge takes the foreground
+    std::vector<float> depth;
+    pool.beginFrame();
+    reduced.beginFrame(scene.depthTexture(), width, height, pool);
+    reduced.render("read depth", PassResolution::Quarter, CompositeMode::Add, scene.id(), [&](const ReducedPassView& view) {
+        depth.resize((size_t)view.width * view.height);
+        glBindTexture(GL_TEXTURE_2D, view.depth);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, depth.data());
+    });
+    reduced.endFrame();
+    const float near = linearize(foreground, settings.nearPlane, settings.farPlane);
+    const float far = linearize(background, settings.nearPlane, settings.farPlane);
+    int wrong = 0;
+    for (int x = 0; x < width / 4; x++) {
+        const float expected = x * 4 < edge ? near : far;
+        wrong += std::abs(depth[x] - expected) > 1e-3f * expected ? 1 : 0;
+    }
+    printf("reduced depth: %d of %d quarter texels wrong (foreground %.3f, background %.3f)\n", wrong, width / 4, near, far);
+    if (wrong != 0) {
+        printf("FAILED: the reduced depth is not the nearest of each block\n");
+        return false;
+    }
+
+    // a pass drawing nothing
+    int changed = 0;
+    for (const CompositeMode mode : { CompositeMode::Add, CompositeMode::Multiply, CompositeMode::Over }) {
+        clear_color(scene, 0.5f);
+        pool.beginFrame();
+        reduced.beginFrame(scene.depthTexture(), width, height, pool);
+        reduced.render("nothing", PassResolution::Half, mode, scene.id(), nothing);
+        reduced.endFrame();
+        scene.readPixels(pixels);
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            changed += std::abs(pixels[i] - 128) > 1 ? 1 : 0;
+        }
+    }
+    printf("empty passes: %d pixels changed\n", changed);
+    if (changed != 0) {
+        printf("FAILED: an empty pass changes the target\n");
+        return false;
+    }
+
+    // the foreground effect at full resolution, then at quarter both ways
+    auto run = [&](PassResolution resolution, bool bilateral, std::vector<unsigned char>& result) {
+        reduced.settings().bilateral = bilateral;
+        clear_color(scene, 0.0f);
+        pool.beginFrame();
+        reduced.beginFrame(scene.depthTexture(), width, height, pool);
+        reduced.render("foreground", resolution, CompositeMode::Add, scene.id(), draw_foreground);
+        reduced.endFrame();
+        scene.readPixels(result);
+    };
+    auto errors = [&](const std::vector<unsigned char>& result) {
+        int count = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                count += std::abs(channel(result, width, x, y, 0) - channel(reference, width, x, y, 0)) > 25 ? 1 : 0;
+            }
+        }
+        return count;
+    };
+    run(PassResolution::Full, true, reference);
+    run(PassResolution::Quarter, false, pixels);
+    const int bilinear = errors(pixels);
+    run(PassResolution::Quarter, true, pixels);
+    const int bilateral = errors(pixels);
+    reduced.settings().bilateral = true;
+    printf("quarter resolution foreground: %d pixels off bilinear, %d bilateral, of %d\n", bilinear, bilateral, width * height);
+    if (bilateral != 0 || bilinear < height) {
+        printf("FAILED: the bilateral upsample does not keep the effect off the background\n");
+        return false;
+    }
+
+    // two passes at half resolution, the second frame allocates nothing
+    for (int frame = 0; frame < 2; frame++) {
+        pool.beginFrame();
+        reduced.beginFrame(scene.depthTexture(), width, height, pool);
+        reduced.render("first", PassResolution::Half, CompositeMode::Add, scene.id(), nothing);
+        reduced.render("second", PassResolution::Half, CompositeMode::Add, scene.id(), nothing);
+        reduced.endFrame();
+    }
+    const RenderTargetPoolStats& frame = pool.frameStats();
+    printf("two half resolution passes: %u targets acquired, %u allocated\n", frame.acquired, frame.allocated);
+    if (frame.acquired != 3 || frame.allocated != 0) {
+        printf("FAILED: the reduced depth is not shared, or the pool does not reuse targets\n");
+        return false;
+    }
+    return true;
+}
+
+struct Effect {
+    const char* name;
+    CompositeMode mode;
+    GLuint program;
+    bool points;
+};
+
+#endif
+
+int main(int argc, char** argv) {
+#ifdef HEADLESS_ENABLED
+    const int frames = argc > 1 ? atoi(argv[1]) : 8;
+
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, 64, 64, "reduced-resolution");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    ReducedResolution reduced;
+    if (!reduced.init()) {
+        printf("FAILED: could not build assets/shaders/post\n");
+        return 1;
+    }
+    const GLuint foreground = build_program(kFullScreen, kForeground);
+    const Effect effects[] = {
+        { "ambient occlusion", CompositeMode::Multiply, build_program(kFullScreen, kAmbientOcclusion), false },
+        { "volumetric fog", CompositeMode::Over, build_program(kFullScreen, kFog), false },
+        { "particles", CompositeMode::Add, build_program(kParticlesVertex, kParticlesFragment), true }
+    };
+    for (const Effect& effect : effects) {
+        if (!foreground || !effect.program) {
+            printf("FAILED: could not build the effects\n");
+            return 1;
+        }
+    }
+    RenderTargetPool pool;
+    GLuint emptyVAO = 0;
+    glGenVertexArrays(1, &emptyVAO);
+    glBindVertexArray(emptyVAO);
+
+    printf("GL (%s)\n\nchecks\n", glGetString(GL_RENDERER));
+    if (!check_passes(reduced, pool, foreground)) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    test::TestDeferredLights app;
+    app.setPath(ShadingPath::DeferredFullScreen);
+    app.setLightCount(64);
+    const int width = 640, height = 360;
+    const float pointSize = 96.0f;      // pixels across at depth 1, full resolution
+
+    printf("\n\"Deferred Lights\" at %dx%d, %d frames per pass and resolution, GPU ms\n\n", width, height, frames);
+    printf("%-18s %-8s %10s %8s %8s %10s %8s %9s\n", "pass", "res", "size", "depth", "draw", "composite", "total", "of full");
+    const Clock::time_point start = Clock::now();
+    for (const Effect& effect : effects) {
+        double fullMs = 0.0;
+        for (size_t r = 0; r < ReducedPassStats::kResolutions; r++) {
+            const PassResolution resolution = (PassResolution)r;
+            double depthMs = 0.0, drawMs = 0.0, compositeMs = 0.0;
+            int timed = 0;
+            for (int frame = 0; frame < frames + 2; frame++) {
+                pool.beginFrame();
+                Framebuffer* scene = pool.acquire({ width, height, GL_RGBA16F, GL_DEPTH24_STENCIL8, GL_LINEAR });
+                scene->bind();
+                glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                glEnable(GL_DEPTH_TEST);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                app.onUpdate(1.0f / 60.0f);
+                app.onRender();
+
+                reduced.beginFrame(scene->depthTexture(), width, height, pool);
+                reduced.render(effect.name, resolution, effect.mode, scene->id(), [&](const ReducedPassView& view) {
+                    glUseProgram(effect.program);
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, view.depth);
+                    glBindVertexArray(emptyVAO);
+                    if (effect.points) {
+                        glEnable(GL_PROGRAM_POINT_SIZE);
+                        glEnable(GL_BLEND);
+                        glBlendFunc(GL_ONE, GL_ONE);
+                        glUniform2f(glGetUniformLocation(effect.program, "depthRange"), reduced.settings().nearPlane,
+                                    reduced.settings().farPlane);
+                        glUniform1f(glGetUniformLocation(effect.program, "pointSize"), pointSize / pass_resolution_divisor(view.resolution));
+                        glDrawArrays(GL_POINTS, 0, 4096);
+                        glDisable(GL_PROGRAM_POINT_SIZE);
+                    }
+                    else {
+                        glUniform1f(glGetUniformLocation(effect.program, "radius"), 0.05f);
+                        glDrawArrays(GL_TRIANGLES, 0, 3);
+                    }
+                });
+                reduced.endFrame();
+                pool.release(scene);
+                glFinish();
+                // the times of a frame come back a frame later
+                if (frame >= 2) {
+                    depthMs += reduced.depthMs(resolution);
+                    drawMs += reduced.pass(reduced.passCount() - 1).drawMs[r];
+                    compositeMs += reduced.pass(reduced.passCount() - 1).compositeMs[r];
+                    timed++;
+                }
+            }
+
+            const ReducedPassStats& stats = reduced.pass(reduced.passCount() - 1);
+            const double totalMs = (depthMs + drawMs + compositeMs) / timed;
+            fullMs = resolution == PassResolution::Full ? totalMs : fullMs;
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%d", stats.width, stats.height);
+            printf("%-18s %-8s %10s %8.3f %8.3f %10.3f %8.3f %8.0f%%\n", effect.name, pass_resolution_name(resolution), size,
+                   depthMs / timed, drawMs / timed, compositeMs / timed, totalMs, fullMs > 0.0 ? 100.0 * totalMs / fullMs : 0.0);
+        }
+    }
+    printf("\n%.1f s\n", seconds(Clock::now() - start));
+
+    glDeleteVertexArrays(1, &emptyVAO);
+    glDeleteProgram(foreground);
+    for (const Effect& effect : effects) {
+        glDeleteProgram(effect.program);
+    }
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    (void)seconds;
+    printf("the reduced resolution checks need a headless EGL build (HEADLESS_ENABLED)\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,485 @@
+// Render graph benchmark
+//
+// CPU checks on a deferred frame declared out of order: post-processing first, the shadow
+// pass last, a debug view nobody reads and a GPU culling pass feeding the G-buffer draws:
+//   - the schedule runs every writer before its readers, in declaration order where free
+//   - the debug view is culled, the passes writing the window or marked as side effects stay
+//   - transients whose lifetimes don't overlap share memory: the bloom targets come back
+//   - only incoherent writes get barriers, with the bits of the reader: command for the
+//     indirect draws, uniform for the exposure, none for attachments sampled later; the
+//     exposure buffer gets the culling pass's buffer back, so writing it waits for a
+//     storage barrier
+//   - cycles and transients read before anyone writes them don't compile
+// then the cost of declaring and compiling a graph of 16 to 1024 passes, and the heap
+// allocations of a steady rebuild.
+//
+// With a headless context, executes a compute pass writing a storage buffer, a pass
+// drawing from it and a read back, and checks the picture: the barrier the graph inserts
+// is the only one. Two targets with disjoint lifetimes must get the same framebuffer.
+//
+// usage: render-graph [dot-file]   (writes the deferred frame's graph when given)
+
+#include "engine/core/Memory.h"
+#include "engine/render/RenderGraph.h"
+
+#ifdef HEADLESS_ENABLED
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+struct DeferredFrame {
+    RenderGraphPass post, bloomBright, bloomBlur, bloomBlend, lighting, exposure, gbuffer, cull, shadows, debug;
+};
+
+/// The passes of a deferred frame, declared in an order that is not the one they can run in
+static DeferredFrame declare_deferred(RenderGraph& graph) {
+    const int width = 1280, height = 720;
+    auto none = [](const RenderGraph&) {};
+    DeferredFrame frame{};
+
+    const RenderGraphResource display = graph.importTarget("display", 0, width, height);
+    const RenderGraphResource atlas = graph.importTarget("shadow atlas", 1, 2048, 2048, 1);
+    const RenderGraphResource lit = graph.createTexture("lit", { width, height, GL_RGBA16F, 0, GL_LINEAR });
+    const RenderGraphResource albedo = graph.createTexture("albedo", { width, height, GL_RGBA8, GL_DEPTH24_STENCIL8, GL_NEAREST });
+    const RenderGraphResource normal = graph.createTexture("normal", { width, height, GL_RGBA16F, 0, GL_NEAREST });
+    const RenderGraphResource draws = graph.createBuffer("draw commands", 4096 * 20);
+    const RenderGraphResource luminance = graph.createBuffer("exposure", 256);
+    const RenderGraphResource debug = graph.createTexture("debug view", { width, height, GL_RGBA8, 0, GL_NEAREST });
+    // the bloom chain: bright and blend are the same kind of target, alive at different times
+    const RenderGraphResource bright = graph.createTexture("bloom bright", { width / 2, height / 2, GL_RGBA16F, 0, GL_LINEAR });
+    const RenderGraphResource blur = graph.createTexture("bloom blur", { width / 4, height / 4, GL_RGBA16F, 0, GL_LINEAR });
+    const RenderGraphResource blurred = graph.createTexture("bloom", { width / 2, height / 2, GL_RGBA16F, 0, GL_LINEAR });
+
+    frame.post = graph.addPass("post", none);
+    graph.read(frame.post, lit, ResourceAccess::Sampled);
+    graph.read(frame.post, blurred, ResourceAccess::Sampled);
+    graph.read(frame.post, luminance, ResourceAccess::Uniform);
+    graph.write(frame.post, display, ResourceAccess::Attachment);
+
+    frame.bloomBlend = graph.addPass("bloom blend", none);
+    graph.read(frame.bloomBlend, blur, ResourceAccess::Sampled);
+    graph.write(frame.bloomBlend, blurred, ResourceAccess::Attachment);
+
+    frame.bloomBlur = graph.addPass("bloom blur", none);
+    graph.read(frame.bloomBlur, bright, ResourceAccess::Sampled);
+    graph.write(frame.bloomBlur, blur, ResourceAccess::Attachment);
+
+    frame.bloomBright = graph.addPass("bloom bright", none);
+    graph.read(frame.bloomBright, lit, ResourceAccess::Sampled);
+    graph.write(frame.bloomBright, bright, ResourceAccess::Attachment);
+
+    frame.exposure = graph.addPass("exposure", none);
+    graph.read(frame.exposure, lit, ResourceAccess::Sampled);
+    graph.write(frame.exposure, luminance, ResourceAccess::Storage);
+
+    frame.lighting = graph.addPass("lighting", none);
+    graph.read(frame.lighting, albedo, ResourceAccess::Sampled);
+    graph.read(frame.lighting, normal, ResourceAccess::Sampled);
+    graph.read(frame.lighting, atlas, ResourceAccess::Sampled);
+    graph.write(frame.lighting, lit, ResourceAccess::Attachment);
+
+    frame.debug = graph.addPass("debug normals", none);
+    graph.read(frame.debug, normal, ResourceAccess::Sampled);
+    graph.write(frame.debug, debug, ResourceAccess::Attachment);
+
+    frame.gbuffer = graph.addPass("gbuffer", none);
+    graph.read(frame.gbuffer, draws, ResourceAccess::Indirect);
+    graph.write(frame.gbuffer, albedo, ResourceAccess::Attachment);
+    graph.write(frame.gbuffer, normal, ResourceAccess::Attachment);
+
+    frame.cull = graph.addPass("gpu culling", none);
+    graph.write(frame.cull, draws, ResourceAccess::Storage);
+
+    frame.shadows = graph.addPass("shadows", none);
+    graph.write(frame.shadows, atlas, ResourceAccess::Attachment);
+    return frame;
+}
+
+static bool check_deferred(const char* dotPath) {
+    RenderTargetPool pool;
+    RenderGraph graph(pool);
+    const DeferredFrame frame = declare_deferred(graph);
+    if (!graph.compile()) {
+        printf("FAILED: the deferred frame does not compile\n");
+        return false;
+    }
+
+    bool ok = true;
+    auto order = [&](RenderGraphPass pass) { return graph.pass(pass).order; };
+    const std::pair<RenderGraphPass, RenderGraphPass> before[] = {
+        { frame.cull, frame.gbuffer }, { frame.gbuffer, frame.lighting }, { frame.shadows, frame.lighting },
+        { frame.lighting, frame.bloomBright }, { frame.bloomBright, frame.bloomBlur }, { frame.bloomBlur, frame.bloomBlend },
+        { frame.bloomBlend, frame.post }, { frame.lighting, frame.exposure }, { frame.exposure, frame.post },
+    };
+    for (const auto& edge : before) {
+        if (order(edge.first) >= order(edge.second)) {
+            printf("FAILED: %s runs after %s\n", graph.pass(edge.first).name, graph.pass(edge.second).name);
+            ok = false;
+        }
+    }
+    printf("  schedule:");
+    for (uint32_t position = 0; position < graph.passCount(); position++) {
+        for (size_t i = 0; i < graph.passCount(); i++) {
+            if (graph.pass(i).order == position) {
+                printf("%s %s", position ? "," : "", graph.pass(i).name);
+            }
+        }
+    }
+    printf("\n");
+
+    const RenderGraphStats& stats = graph.stats();
+    printf("  culled %u: %s%s\n", stats.culled, graph.pass(frame.debug).culled ? graph.pass(frame.debug).name : "",
+           graph.pass(frame.debug).culled ? "" : "nothing");
+    if (stats.culled != 1 || !graph.pass(frame.debug).culled) {
+        printf("FAILED: only the debug view should be culled\n");
+        ok = false;
+    }
+
+    printf("  transients: %u targets and %u buffers, %.2f MB on their own, %.2f MB aliased\n", stats.transientTextures,
+           stats.transientBuffers, stats.transientBytes / 1048576.0, stats.aliasedBytes / 1048576.0);
+    // the bloom targets, and the exposure buffer inside the draw commands
+    const uint64_t shared = RenderTargetPool::byteSize({ 640, 360, GL_RGBA16F, 0, GL_LINEAR }) + 256;
+    if (stats.transientBytes - stats.aliasedBytes != shared) {
+        printf("FAILED: the bloom targets and the buffers should share memory, saved %.2f MB\n",
+               (stats.transientBytes - stats.aliasedBytes) / 1048576.0);
+        ok = false;
+    }
+
+    for (size_t i = 0; i < graph.passCount(); i++) {
+        const RenderGraphPassInfo pass = graph.pass(i);
+        if (pass.barriers) {
+            printf("  barrier before %-14s %s\n", pass.name, memory_barrier_names(pass.barriers).c_str());
+        }
+    }
+    if (graph.pass(frame.gbuffer).barriers != GL_COMMAND_BARRIER_BIT || graph.pass(frame.exposure).barriers != GL_SHADER_STORAGE_BARRIER_BIT ||
+        graph.pass(frame.post).barriers != GL_UNIFORM_BARRIER_BIT || stats.barriers != 3) {
+        printf("FAILED: expected command before the G-buffer, storage before the exposure and uniform before post\n");
+        ok = false;
+    }
+
+    if (dotPath) {
+        if (graph.writeDot(dotPath)) {
+            printf("  wrote %s\n", dotPath);
+        }
+        else {
+            printf("FAILED: could not write %s\n", dotPath);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static bool check_errors() {
+    RenderTargetPool pool;
+    RenderGraph graph(pool);
+    auto none = [](const RenderGraph&) {};
+    bool ok = true;
+
+    // a reads what b writes and the other way around
+    const RenderGraphResource display = graph.importTarget("display", 0, 64, 64);
+    const RenderGraphResource x = graph.createTexture("x", { 64, 64, GL_RGBA8, 0, GL_LINEAR });
+    const RenderGraphResource y = graph.createTexture("y", { 64, 64, GL_RGBA8, 0, GL_LINEAR });
+    const RenderGraphPass a = graph.addPass("a", none);
+    graph.read(a, x, ResourceAccess::Sampled);
+    graph.write(a, y, ResourceAccess::Attachment);
+    const RenderGraphPass b = graph.addPass("b", none);
+    graph.read(b, y, ResourceAccess::Sampled);
+    graph.write(b, x, ResourceAccess::Attachment);
+    graph.write(b, display, ResourceAccess::Attachment);
+    if (graph.compile()) {
+        printf("FAILED: a cycle compiled\n");
+        ok = false;
+    }
+
+    graph.reset();
+    const RenderGraphResource target = graph.importTarget("display", 0, 64, 64);
+    const RenderGraphResource never = graph.createTexture("never written", { 64, 64, GL_RGBA8, 0, GL_LINEAR });
+    const RenderGraphPass reader = graph.addPass("reader", none);
+    graph.read(reader, never, ResourceAccess::Sampled);
+    graph.write(reader, target, ResourceAccess::Attachment);
+    if (graph.compile()) {
+        printf("FAILED: a read of a transient nobody writes compiled\n");
+        ok = false;
+    }
+    printf("  a cycle and a read of an unwritten transient are refused\n");
+    return ok;
+}
+
+/// `passes` passes in a chain of full-screen steps, each also reading two earlier results
+static void declare_chain(RenderGraph& graph, int passes, std::mt19937& random, std::vector<RenderGraphResource>& results) {
+    static const char* kNames[] = { "pass a", "pass b", "pass c", "pass d" };
+    auto none = [](const RenderGraph&) {};
+    results.clear();
+    const RenderGraphResource display = graph.importTarget("display", 0, 1280, 720);
+    for (int i = 0; i < passes; i++) {
+        const int scale = 1 << (i % 3);
+        const RenderGraphResource result = i + 1 < passes ? graph.createTexture("result", { 1280 / scale, 720 / scale, GL_RGBA16F, 0, GL_LINEAR }) : display;
+        const RenderGraphPass pass = graph.addPass(kNames[i % 4], none);
+        if (!results.empty()) {
+            graph.read(pass, results.back(), ResourceAccess::Sampled);
+            graph.read(pass, results[random() % results.size()], ResourceAccess::Sampled);
+            graph.read(pass, results[random() % results.size()], ResourceAccess::Sampled);
+        }
+        graph.write(pass, result, ResourceAccess::Attachment);
+        results.push_back(result);
+    }
+}
+
+static void bench_compile() {
+    printf("\n%-8s %14s %14s %12s %18s\n", "passes", "declare us", "compile us", "us/pass", "allocations/frame");
+    RenderTargetPool pool;
+    RenderGraph graph(pool);
+    std::vector<RenderGraphResource> results;
+    for (int passes : { 16, 64, 256, 1024 }) {
+        const int frames = std::max(8, 4096 / passes);
+        double declare = 0.0, compile = 0.0;
+        uint64_t allocations = 0;
+        for (int frame = 0; frame < frames + 2; frame++) {
+            // the same graph every frame
+            std::mt19937 random(7);
+            const AllocationCounters before = Memory::counters();
+            const Clock::time_point start = Clock::now();
+            graph.reset();
+            declare_chain(graph, passes, random, results);
+            const Clock::time_point declared = Clock::now();
+            graph.compile();
+            const Clock::time_point compiled = Clock::now();
+            // the first frames grow the graph's storage
+            if (frame >= 2) {
+                declare += seconds(declared - start);
+                compile += seconds(compiled - declared);
+                allocations += Memory::delta(before, Memory::counters()).allocations;
+            }
+        }
+        printf("%-8d %14.1f %14.1f %12.3f %18.1f\n", passes, declare * 1e6 / frames, compile * 1e6 / frames,
+               (declare + compile) * 1e6 / frames / passes, (double)allocations / frames);
+    }
+}
+
+#ifdef HEADLESS_ENABLED
+
+static GLuint build_program(const char* vertex, const char* fragment, const char* compute) {
+    const GLuint program = glCreateProgram();
+    const std::pair<GLenum, const char*> stages[] = { { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment }, { GL_COMPUTE_SHADER, compute } };
+    for (const auto& stage : stages) {
+        if (!stage.second) {
+            continue;
+        }
+        const GLuint shader = glCreateShader(stage.first);
+        glShaderSource(shader, 1, &stage.second, nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = {};
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        printf("program failed to link:\n%s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static const char* kFill = R"(#version 450
+layout(local_size_x = 4) in;
+layout(std430, binding = 0) buffer Colors { vec4 colors[]; };
+uniform float frame;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    colors[i] = vec4(float(i & 1u), float(i >> 1u), fract(frame * 0.25), 1.0);
+}
+)";
+
+static const char* kFullScreen = R"(#version 450
+out vec2 uv;
+void main() {
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char* kQuadrants = R"(#version 450
+layout(std430, binding = 0) readonly buffer Colors { vec4 colors[]; };
+in vec2 uv;
+out vec4 color;
+void main() {
+    color = colors[uint(uv.x >= 0.5) + 2u * uint(uv.y >= 0.5)];
+}
+)";
+
+static const char* kCopy = R"(#version 450
+layout(binding = 0) uniform sampler2D source;
+in vec2 uv;
+out vec4 color;
+void main() {
+    color = texture(source, uv);
+}
+)";
+
+/// fill (compute, storage) -> quadrants (fragment reads storage) -> copy -> copy again -> read back
+static bool check_execute() {
+    const GLuint fill = build_program(nullptr, nullptr, kFill);
+    const GLuint quadrants = build_program(kFullScreen, kQuadrants, nullptr);
+    const GLuint copy = build_program(kFullScreen, kCopy, nullptr);
+    if (!fill || !quadrants || !copy) {
+        printf("FAILED: could not build the test programs\n");
+        return false;
+    }
+    GLuint emptyVAO = 0;
+    glGenVertexArrays(1, &emptyVAO);
+
+    RenderTargetPool pool;
+    RenderGraph graph(pool);
+    const int size = 64;
+    std::vector<unsigned char> pixels;
+    GLuint firstTarget = 0, thirdTarget = 0;
+    bool ok = true;
+    for (int frame = 0; frame < 4; frame++) {
+        pool.beginFrame();
+        graph.reset();
+        const RenderTargetDesc desc = { size, size, GL_RGBA8, 0, GL_NEAREST };
+        const RenderGraphResource colors = graph.createBuffer("colors", 4 * sizeof(float) * 4);
+        const RenderGraphResource first = graph.createTexture("quadrants", desc);
+        const RenderGraphResource second = graph.createTexture("copy", desc);
+        const RenderGraphResource third = graph.createTexture("copy again", desc);
+
+        const RenderGraphPass fillPass = graph.addPass("fill", [&](const RenderGraph& g) {
+            glUseProgram(fill);
+            glUniform1f(glGetUniformLocation(fill, "frame"), (float)frame);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g.buffer(colors));
+            glDispatchCompute(1, 1, 1);
+        });
+        graph.write(fillPass, colors, ResourceAccess::Storage);
+
+        const RenderGraphPass drawPass = graph.addPass("quadrants", [&](const RenderGraph& g) {
+            g.bindTarget(first);
+            glUseProgram(quadrants);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g.buffer(colors));
+            glBindVertexArray(emptyVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            firstTarget = g.framebuffer(first);
+        });
+        graph.read(drawPass, colors, ResourceAccess::Storage);
+        graph.write(drawPass, first, ResourceAccess::Attachment);
+
+        auto copyPass = [&](const char* name, RenderGraphResource from, RenderGraphResource to) {
+            const RenderGraphPass pass = graph.addPass(name, [&, from, to](const RenderGraph& g) {
+                g.bindTarget(to);
+                glUseProgram(copy);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, g.texture(from));
+                glBindVertexArray(emptyVAO);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                if (to.index == third.index) {
+                    thirdTarget = g.framebuffer(to);
+                }
+            });
+            graph.read(pass, from, ResourceAccess::Sampled);
+            graph.write(pass, to, ResourceAccess::Attachment);
+        };
+        copyPass("copy", first, second);
+        copyPass("copy again", second, third);
+
+        const RenderGraphPass readBack = graph.addPass("read back", [&](const RenderGraph& g) {
+            g.target(third)->readPixels(pixels);
+        });
+        graph.read(readBack, third, ResourceAccess::Transfer);
+        graph.setSideEffect(readBack);
+
+        if (!graph.execute()) {
+            printf("FAILED: the graph did not execute\n");
+            ok = false;
+            break;
+        }
+
+        const int blue = (int)std::lround((frame * 0.25 - std::floor(frame * 0.25)) * 255.0);
+        const int expected[4][3] = { { 0, 0, blue }, { 255, 0, blue }, { 0, 255, blue }, { 255, 255, blue } };
+        for (int q = 0; q < 4 && ok; q++) {
+            const int x = (q & 1) * size / 2 + size / 4, y = (q >> 1) * size / 2 + size / 4;
+            for (int c = 0; c < 3; c++) {
+                if (std::abs(pixels[((size_t)y * size + x) * 4 + c] - expected[q][c]) > 1) {
+                    printf("FAILED: frame %d quadrant %d channel %d is %d, expected %d\n", frame, q, c,
+                           pixels[((size_t)y * size + x) * 4 + c], expected[q][c]);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    printf("  compute -> storage -> draw -> copy -> copy -> read back: %s, barrier before quadrants: %s\n", ok ? "correct" : "wrong",
+           memory_barrier_names(graph.pass(1).barriers).c_str());
+    printf("  quadrants and copy again got framebuffer %u and %u, %u targets in the pool\n", firstTarget, thirdTarget,
+           (unsigned)pool.targetCount());
+    if (graph.pass(1).barriers != GL_SHADER_STORAGE_BARRIER_BIT) {
+        printf("FAILED: the draw reading the buffer needs a storage barrier, and only that\n");
+        ok = false;
+    }
+    if (firstTarget != thirdTarget || pool.targetCount() != 2) {
+        printf("FAILED: the first and third target don't overlap, they should share a framebuffer\n");
+        ok = false;
+    }
+
+    double gpu = 0.0;
+    for (size_t i = 0; i < graph.passCount(); i++) {
+        gpu += graph.pass(i).gpuMs;
+    }
+    printf("  %zu passes, %.3f ms GPU, compile %.3f ms, execute %.3f ms CPU\n", graph.passCount(), gpu,
+           graph.stats().compileMs, graph.stats().executeMs);
+
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &emptyVAO);
+    glDeleteProgram(fill);
+    glDeleteProgram(quadrants);
+    glDeleteProgram(copy);
+    return ok;
+}
+
+#endif
+
+int main(int argc, char** argv) {
+    const char* dotPath = argc > 1 ? argv[1] : nullptr;
+
+    printf("checks\n");
+    if (!check_deferred(dotPath) || !check_errors()) {
+        printf("FAILED\n");
+        return 1;
+    }
+    bench_compile();
+
+#ifdef HEADLESS_ENABLED
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, 64, 64, "render-graph");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    printf("\nGL (%s)\n", glGetString(GL_RENDERER));
+    if (!check_execute()) {
+        printf("FAILED\n");
+        return 1;
+    }
+#else
+    printf("\nexecuting the graph needs a headless EGL build (HEADLESS_ENABLED)\n");
+#endif
+    return 0;
+}
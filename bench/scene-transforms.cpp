@@ -0,0 +1,153 @@
+// Scene transform update benchmark
+//
+// Updates N transforms per iteration three ways:
+//   heap objects  one object per entity holding a heap-allocated model matrix (what
+//                 TestTexture2D used to do), matrix rebuilt with glm::translate/rotate/scale
+//   AoS array     one struct per entity in a contiguous array, compose_transform
+//   Scene SoA     Scene::updateTransforms over the per-field arrays
+// and, separately, a position-only "move" pass (p += v * dt) over AoS and SoA layouts, the
+// case where SoA only streams the arrays it needs.
+//
+// usage: scene-transforms [iterations] [entity counts...]   (default: 20 100000 1000000)
+
+#include "engine/scene/Scene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+struct HeapObject {
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+    glm::vec3 velocity;
+    std::unique_ptr<glm::mat4> model;
+};
+
+struct AosTransform {
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+    glm::vec3 velocity;
+    glm::mat4 world;
+};
+
+static Transform random_transform(std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    Transform t;
+    t.position = glm::vec3(position(rng), position(rng), position(rng));
+    t.rotation = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(position(rng), position(rng), position(rng) + 0.1f)));
+    t.scale = glm::vec3(scale(rng));
+    return t;
+}
+
+static void report(const char* name, size_t count, int iterations, double elapsed, float checksum) {
+    double perEntity = elapsed / ((double)count * iterations) * 1e9;
+    printf("%-20s %9zu entities  %8.3f ms/update  %7.2f ns/entity  %8.1f M entities/s  (checksum %g)\n",
+        name, count, elapsed / iterations * 1e3, perEntity, 1e3 / perEntity, checksum);
+}
+
+static void bench(size_t count, int iterations) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+    const float dt = 1.0f / 60.0f;
+
+    std::vector<HeapObject> heap(count);
+    std::vector<AosTransform> aos(count);
+    std::vector<glm::vec3> velocities(count);
+    Scene scene;
+    scene.reserve(count);
+
+    for (size_t i = 0; i < count; i++) {
+        Transform t = random_transform(rng);
+        glm::vec3 v(speed(rng), speed(rng), speed(rng));
+
+        heap[i] = { t.position, t.rotation, t.scale, v, std::make_unique<glm::mat4>(1.0f) };
+        aos[i] = { t.position, t.rotation, t.scale, v, glm::mat4(1.0f) };
+        velocities[i] = v;
+
+        Entity e = scene.create();
+        scene.transforms().add(e, t);
+    }
+
+    // full world matrix rebuild
+    auto start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (HeapObject& object : heap) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), object.position);
+            model = model * glm::mat4_cast(object.rotation);
+            *object.model = glm::scale(model, object.scale);
+        }
+    }
+    report("heap objects", count, iterations, seconds(Clock::now() - start), (*heap[count / 2].model)[3][0]);
+
+    start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (AosTransform& t : aos) {
+            t.world = compose_transform(t.position, t.rotation, t.scale);
+        }
+    }
+    report("AoS array", count, iterations, seconds(Clock::now() - start), aos[count / 2].world[3][0]);
+
+    start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        scene.updateTransforms();
+    }
+    report("Scene SoA", count, iterations, seconds(Clock::now() - start), scene.transforms().worlds[count / 2][3][0]);
+
+    // position-only pass
+    start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (AosTransform& t : aos) {
+            t.position += t.velocity * dt;
+        }
+    }
+    report("move AoS", count, iterations, seconds(Clock::now() - start), aos[count / 2].position.x);
+
+    start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        glm::vec3* positions = scene.transforms().positions.data();
+        const glm::vec3* v = velocities.data();
+        for (size_t i = 0; i < count; i++) {
+            positions[i] += v[i] * dt;
+        }
+    }
+    report("move SoA", count, iterations, seconds(Clock::now() - start), scene.transforms().positions[count / 2].x);
+
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    std::vector<size_t> counts;
+    for (int i = 2; i < argc; i++) {
+        counts.push_back((size_t)strtoull(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = { 100000, 1000000 };
+    }
+
+    printf("sizeof: HeapObject %zu (+%zu heap), AosTransform %zu, SoA %zu per entity\n\n",
+        sizeof(HeapObject), sizeof(glm::mat4), sizeof(AosTransform),
+        sizeof(glm::vec3) * 2 + sizeof(glm::quat) + sizeof(glm::mat4));
+
+    for (size_t count : counts) {
+        bench(count, iterations);
+    }
+
+    return 0;
+}
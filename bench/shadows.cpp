@@ -0,0 +1,388 @@
+// Shadow mapping benchmark
+//
+// CPU checks of the cascade fitting and the atlas packing:
+//   - a cascade's size does not change when the camera turns
+//   - moving the camera moves each cascade by whole texels, and its matrix only changes
+//     when the camera leaves the snapping cell (how often is printed, it is what the
+//     static cache can hope for on a moving camera)
+//   - every corner of a depth slice is inside its cascade
+//   - tiles handed out by the atlas stay inside it and never overlap
+// then, with a headless context, renders the "Shadows" scene (static yard, moving boxes, a
+// sun with cascades, two spot and two point lights with shadows) and prints the shadow pass
+// cost per frame, CPU and GPU, views drawn or copied from the static cache and casters drawn
+// or culled per cascade:
+//   still camera      the static casters come from the cache, only the moving boxes are drawn
+//   orbiting camera   the cascades that moved are drawn again, the others cached
+//   cache off         every view draws every caster, every frame
+// A still frame must look the same with and without the cache, the shadows must darken part
+// of the image, and every shading path must read the same shadows.
+//
+// usage: shadows [width] [height] [frames]   (default: 480 270 8)
+
+#include "engine/render/Shadows.h"
+
+#ifdef HEADLESS_ENABLED
+#include "apps/TestShadows.h"
+#include "engine/opengl/Framebuffer.h"
+#include "engine/wrapper/egl-wrapper.h"
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static const uint32_t kCascades = 4;
+static const uint32_t kResolution = 1024;
+
+static ShadowCameraView camera_at(const glm::vec3& position, float yaw, float pitch) {
+    Camera camera(position, glm::vec3(0.0f, 1.0f, 0.0f), yaw, pitch);
+    return shadow_camera_view(camera, 16.0f / 9.0f, 0.1f, 100.0f);
+}
+
+static void fit_all(const ShadowCameraView& camera, const glm::vec3& sun, Cascade* cascades) {
+    float splits[kCascades + 1];
+    cascade_splits(camera.nearPlane, 60.0f, kCascades, 0.75f, splits);
+    for (uint32_t i = 0; i < kCascades; i++) {
+        cascades[i] = fit_cascade(camera, splits[i], splits[i + 1], sun, kResolution, 60.0f);
+    }
+}
+
+/// Sizes don't change with the camera's orientation
+static bool check_rotation(const glm::vec3& sun) {
+    Cascade reference[kCascades], cascades[kCascades];
+    fit_all(camera_at(glm::vec3(3.0f, 5.0f, 7.0f), -90.0f, -10.0f), sun, reference);
+    for (int step = 0; step < 72; step++) {
+        fit_all(camera_at(glm::vec3(3.0f, 5.0f, 7.0f), step * 5.0f, -40.0f + step * 1.1f), sun, cascades);
+        for (uint32_t i = 0; i < kCascades; i++) {
+            if (cascades[i].radius != reference[i].radius || cascades[i].texelSize != reference[i].texelSize) {
+                printf("FAILED: cascade %u is %.6f wide at yaw %d, %.6f at -90\n", i, cascades[i].radius, step * 5,
+                       reference[i].radius);
+                return false;
+            }
+        }
+    }
+    printf("  radius under rotation         %-8s", "stable");
+    for (uint32_t i = 0; i < kCascades; i++) {
+        printf("  c%u %.3f", i, reference[i].radius);
+    }
+    printf("\n");
+    return true;
+}
+
+/// The light space origin moves by whole texels; prints how often each cascade changes
+static bool check_translation(const glm::vec3& sun) {
+    const int steps = 2000;
+    Cascade previous[kCascades], cascades[kCascades];
+    int changes[kCascades] = {};
+    fit_all(camera_at(glm::vec3(0.0f, 5.0f, 0.0f), -60.0f, -15.0f), sun, previous);
+    for (int step = 1; step <= steps; step++) {
+        // 1 cm per step, along a diagonal
+        const glm::vec3 position(0.01f * step, 5.0f + 0.002f * step, -0.007f * step);
+        fit_all(camera_at(position, -60.0f, -15.0f), sun, cascades);
+        for (uint32_t i = 0; i < kCascades; i++) {
+            const glm::vec3 shift = glm::vec3(cascades[i].view[3] - previous[i].view[3]) / cascades[i].texelSize;
+            for (int axis = 0; axis < 2; axis++) {
+                if (std::abs(shift[axis] - std::round(shift[axis])) > 1e-2f) {
+                    printf("FAILED: cascade %u moved by %.4f texels at step %d\n", i, shift[axis], step);
+                    return false;
+                }
+            }
+            changes[i] += cascades[i].viewProjection != previous[i].viewProjection;
+            previous[i] = cascades[i];
+        }
+    }
+    printf("  translation                   %-8s", "texels");
+    for (uint32_t i = 0; i < kCascades; i++) {
+        printf("  c%u %d/%d", i, changes[i], steps);
+    }
+    printf(" steps change the matrix\n");
+    return true;
+}
+
+/// Each slice's corners are inside its cascade's box
+static bool check_coverage(const glm::vec3& sun) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int trial = 0; trial < 500; trial++) {
+        const glm::vec3 position(40.0f * unit(rng) - 20.0f, 1.0f + 10.0f * unit(rng), 40.0f * unit(rng) - 20.0f);
+        const ShadowCameraView camera = camera_at(position, 360.0f * unit(rng), 160.0f * unit(rng) - 80.0f);
+        Cascade cascades[kCascades];
+        fit_all(camera, sun, cascades);
+
+        const glm::mat4 inverseView = glm::inverse(camera.view);
+        const float tanY = std::tan(camera.fovY * 0.5f);
+        for (uint32_t i = 0; i < kCascades; i++) {
+            for (int corner = 0; corner < 8; corner++) {
+                const float depth = corner & 4 ? cascades[i].splitFar : cascades[i].splitNear;
+                const glm::vec4 local((corner & 1 ? 1.0f : -1.0f) * depth * tanY * camera.aspect,
+                                      (corner & 2 ? 1.0f : -1.0f) * depth * tanY, -depth, 1.0f);
+                const glm::vec4 clip = cascades[i].viewProjection * (inverseView * local);
+                if (std::abs(clip.x) > 1.0f || std::abs(clip.y) > 1.0f || std::abs(clip.z) > 1.0f) {
+                    printf("FAILED: corner %d of slice %u is outside its cascade (%.3f %.3f %.3f)\n", corner, i, clip.x,
+                           clip.y, clip.z);
+                    return false;
+                }
+            }
+        }
+    }
+    printf("  slice corners inside          %-8s  500 random cameras\n", "ok");
+    return true;
+}
+
+static bool check_atlas() {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> exponent(5, 9);
+    ShadowAtlas atlas(4096);
+    std::vector<uint32_t> sizes;
+    for (int i = 0; i < 400; i++) {
+        sizes.push_back(1u << exponent(rng));
+    }
+    std::sort(sizes.begin(), sizes.end(), [](uint32_t a, uint32_t b) { return a > b; });
+
+    std::vector<ShadowRect> rects;
+    for (uint32_t size : sizes) {
+        ShadowRect rect;
+        if (atlas.allocate(size, rect)) {
+            rects.push_back(rect);
+        }
+    }
+    for (size_t i = 0; i < rects.size(); i++) {
+        const ShadowRect& a = rects[i];
+        if (a.x + a.size > atlas.size() || a.y + a.size > atlas.size()) {
+            printf("FAILED: tile %zu is outside the atlas\n", i);
+            return false;
+        }
+        for (size_t j = i + 1; j < rects.size(); j++) {
+            const ShadowRect& b = rects[j];
+            if (a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size) {
+                printf("FAILED: tiles %zu and %zu overlap\n", i, j);
+                return false;
+            }
+        }
+    }
+    printf("  atlas packing                 %-8s  %zu of %zu tiles placed, %.1f%% used\n", "ok", rects.size(), sizes.size(),
+           100.0 * atlas.usedTexels() / (4096.0 * 4096.0));
+    return true;
+}
+
+#ifdef HEADLESS_ENABLED
+struct Scenario {
+    const char* name;
+    bool orbit;
+    bool cache;
+};
+
+struct Result {
+    double frameMs;
+    double cpuMs;
+    double gpuMs;
+    double viewsRendered;
+    double viewsCached;
+    double castersDrawn;
+    double castersCulled;
+    double cascadeCasters[ShadowStats::kMaxCascades];
+};
+
+static Result run(test::TestShadows& app, int frames) {
+    Result result{};
+    int gpuFrames = 0;
+    for (int frame = 0; frame <= frames; frame++) {
+        app.onUpdate(1.0f / 30.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+        const auto start = Clock::now();
+        app.onRender();
+        glFinish();
+        // frame 0 warms the shader caches and fills the static cache
+        if (frame == 0) {
+            continue;
+        }
+
+        const ShadowStats& stats = app.shadows().stats();
+        result.frameMs += seconds(Clock::now() - start) * 1e3;
+        result.cpuMs += stats.cpuMs;
+        // resolved one frame late, the first timed frame reports the warm-up
+        if (frame > 1) {
+            result.gpuMs += stats.gpuMs;
+            gpuFrames++;
+        }
+        result.viewsRendered += stats.viewsRendered;
+        result.viewsCached += stats.viewsCached;
+        result.castersDrawn += (double)stats.castersDrawn;
+        result.castersCulled += (double)stats.castersCulled;
+        for (size_t i = 0; i < ShadowStats::kMaxCascades; i++) {
+            result.cascadeCasters[i] += (double)stats.cascadeCasters[i];
+        }
+    }
+
+    result.frameMs /= frames;
+    result.cpuMs /= frames;
+    result.gpuMs = gpuFrames ? result.gpuMs / gpuFrames : 0.0;
+    result.viewsRendered /= frames;
+    result.viewsCached /= frames;
+    result.castersDrawn /= frames;
+    result.castersCulled /= frames;
+    for (double& casters : result.cascadeCasters) {
+        casters /= frames;
+    }
+    return result;
+}
+
+/// Pixels with a channel off by more than `tolerance`
+static size_t compare(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int tolerance) {
+    size_t pixels = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        int worst = 0;
+        for (size_t c = 0; c < 3; c++) {
+            worst = std::max(worst, std::abs((int)a[i + c] - (int)b[i + c]));
+        }
+        pixels += worst > tolerance;
+    }
+    return pixels;
+}
+
+/// One still frame of `path`
+static void still_frame(test::TestShadows& app, ShadingPath path, const Framebuffer& target, std::vector<unsigned char>& image) {
+    app.setPath(path);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    app.onRender();
+    target.readPixels(image);
+}
+#endif
+
+int main(int argc, char** argv) {
+    const glm::vec3 sun = glm::normalize(glm::vec3(-0.5f, -1.0f, -0.35f));
+    printf("cascade fitting (%u cascades of %u texels, 60 units)\n", kCascades, kResolution);
+    if (!check_rotation(sun) || !check_translation(sun) || !check_coverage(sun) || !check_atlas()) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+#ifdef HEADLESS_ENABLED
+    const int width = argc > 1 ? atoi(argv[1]) : 480;
+    const int height = argc > 2 ? atoi(argv[2]) : 270;
+    const int frames = argc > 3 ? atoi(argv[3]) : 8;
+
+    EGLWrapperConfig config = { 4, 5, true, 0, "", 1 };
+    EGLWrapper window(config, width, height, "shadows");
+    if (!window.initialized()) {
+        printf("FAILED: no EGL context\n");
+        return 1;
+    }
+    window.makeContextCurrent();
+
+    FramebufferConfig targetConfig{};
+    targetConfig.width = width;
+    targetConfig.height = height;
+    targetConfig.colorAttachments = { Framebuffer::rgba16f() };
+    targetConfig.depth = true;
+    targetConfig.depthFormat = GL_DEPTH_COMPONENT24;
+    Framebuffer target;
+    if (!target.create(targetConfig)) {
+        printf("FAILED: could not create the %dx%d target\n", width, height);
+        return 1;
+    }
+
+    // a small atlas, software rasterizers fill depth slowly
+    ShadowSettings settings;
+    settings.atlasSize = 1024;
+    settings.cascadeResolution = 256;
+    settings.maxLocalResolution = 256;
+    settings.minLocalResolution = 32;
+    test::TestShadows app(settings);
+    if (!app.renderer().initialized() || !app.shadows().initialized()) {
+        printf("FAILED: could not build assets/shaders/shading or assets/shaders/shadows\n");
+        return 1;
+    }
+
+    target.bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    printf("\nGL (%s), %dx%d RGBA16F target, %u atlas, %zu casters, %d frames per run\n\n", glGetString(GL_RENDERER),
+           width, height, settings.atlasSize, app.casters().size(), frames);
+
+    static const Scenario scenarios[] = {
+        { "still camera", false, true },
+        { "orbiting camera", true, true },
+        { "cache off", true, false },
+    };
+    printf("%-16s %9s %9s %9s %9s %8s %9s %9s   %s\n", "run", "frame ms", "shadow", "shadow", "views", "views", "casters",
+           "casters", "casters per cascade");
+    printf("%-16s %9s %9s %9s %9s %8s %9s %9s\n", "", "", "CPU ms", "GPU ms", "drawn", "cached", "drawn", "culled");
+    for (const Scenario& scenario : scenarios) {
+        app.setOrbit(scenario.orbit);
+        app.setCacheStatic(scenario.cache);
+        const Result result = run(app, frames);
+        printf("%-16s %9.3f %9.3f %9.3f %9.1f %8.1f %9.1f %9.1f  ", scenario.name, result.frameMs, result.cpuMs,
+               result.gpuMs, result.viewsRendered, result.viewsCached, result.castersDrawn, result.castersCulled);
+        for (size_t i = 0; i < app.shadows().cascadeCount(); i++) {
+            printf(" %.0f", result.cascadeCasters[i]);
+        }
+        printf("\n");
+    }
+    const ShadowStats& stats = app.shadows().stats();
+    printf("\n%u views, %u lights shadowed, %u dropped, atlas %.0f%% used, %.2f MB with the static cache\n", stats.views,
+           stats.lightsShadowed, stats.lightsDropped, stats.atlasUsage * 100.0f, app.shadows().byteSize() / (1024.0 * 1024.0));
+
+    // still frames: cached and uncached must be the same image, the shadows must show
+    bool ok = true;
+    app.setOrbit(false);
+    app.onUpdate(0.0f);
+    std::vector<unsigned char> cached, uncached, unshadowed, image;
+    app.setCacheStatic(true);
+    still_frame(app, ShadingPath::Forward, target, cached);
+    still_frame(app, ShadingPath::Forward, target, cached);
+    app.setCacheStatic(false);
+    still_frame(app, ShadingPath::Forward, target, uncached);
+    const size_t cacheDifference = compare(cached, uncached, 0);
+    printf("\ncached vs drawn again          %zu differing pixels\n", cacheDifference);
+    if (cacheDifference != 0) {
+        printf("FAILED: the static cache changes the image\n");
+        ok = false;
+    }
+
+    app.renderer().setShadows(nullptr);
+    still_frame(app, ShadingPath::Forward, target, unshadowed);
+    app.renderer().setShadows(&app.shadows());
+    const size_t shadowed = compare(uncached, unshadowed, 8);
+    printf("shadowed vs unshadowed         %.1f%% of the pixels darker\n", 100.0 * shadowed / ((double)width * height));
+    if (shadowed * 50 < (size_t)width * height) {
+        printf("FAILED: the shadows cover less than 2%% of the image\n");
+        ok = false;
+    }
+
+    for (ShadingPath path : { ShadingPath::DeferredFullScreen, ShadingPath::DeferredVolumes, ShadingPath::Clustered }) {
+        still_frame(app, path, target, image);
+        const size_t difference = compare(uncached, image, 3);
+        printf("%-30s %zu pixels differ from forward\n", shading_path_name(path), difference);
+        if (difference * 100 > (size_t)width * height) {
+            printf("FAILED: %s reads different shadows\n", shading_path_name(path));
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    (void)seconds;
+    printf("\nthe shadow pass timings need a headless EGL build (HEADLESS_ENABLED)\n");
+    return 0;
+#endif
+}
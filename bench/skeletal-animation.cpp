@@ -0,0 +1,329 @@
+// Skeletal animation benchmark
+//
+// A procedural character (a depth-first joint tree with sparse keyframes on a 30 fps grid,
+// like an imported rig) is instanced N times, each instance playing one of a few clips from
+// its own start time. Every frame samples the clips and rebuilds all skinning palettes:
+//   scalar     one thread, scalar kernels
+//   SIMD       one thread, widest BatchMath level
+//   SIMD pool  instances spread over the thread pool
+// Checks, before timing:
+//   - SIMD palettes against the scalar ones
+//   - resampled clips against direct keyframe evaluation (slerp), reported as an error
+//   - CPU skinning of the bind pose gives back the input vertices
+//   - joints bound with an axis scaled to zero keep a finite rotation
+//   - a clip that ends between two frames plays its last one at the right time
+// and finally times CPU skinning of the character's mesh, the validation path.
+//
+// usage: skeletal-animation [frames] [characters] [joints] [vertices]   (default: 200 1000 64 4000)
+
+#include "engine/anim/AnimationClip.h"
+#include "engine/anim/AnimationSystem.h"
+#include "engine/anim/Skeleton.h"
+#include "engine/anim/Skinning.h"
+#include "engine/core/ThreadPool.h"
+#include "engine/math/BatchMath.h"
+#include "engine/scene/Components.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+struct SkinnedVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    int joints[4];
+    float weights[4];
+};
+
+static glm::quat random_rotation(std::mt19937& rng, float maxAngle) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    glm::vec3 axis = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng) + 0.01f));
+    return glm::angleAxis(unit(rng) * maxAngle, axis);
+}
+
+static void build_skeleton(Skeleton& skeleton, size_t joints, std::mt19937& rng) {
+    std::vector<uint32_t> stack;
+    for (size_t j = 0; j < joints; j++) {
+        if (stack.size() > 1 && rng() % 3 == 0) {
+            stack.resize(1 + rng() % (stack.size() - 1));
+        }
+        uint32_t parent = stack.empty() ? Skeleton::kNoJoint : stack.back();
+        glm::vec3 offset = parent == Skeleton::kNoJoint ? glm::vec3(0.0f) : glm::vec3(0.0f, 0.2f, 0.0f);
+        uint32_t joint = skeleton.addJoint("joint" + std::to_string(j), parent,
+                                           compose_transform(offset, random_rotation(rng, 0.5f), glm::vec3(1.0f)));
+        stack.push_back(joint);
+    }
+
+    // inverse binds from the bind pose in world space
+    std::vector<glm::mat4> worlds(joints);
+    for (size_t j = 0; j < joints; j++) {
+        glm::mat4 local = compose_transform(skeleton.bindTranslations()[j], skeleton.bindRotations()[j], skeleton.bindScales()[j]);
+        uint32_t parent = skeleton.parents()[j];
+        worlds[j] = parent == Skeleton::kNoJoint ? local : worlds[parent] * local;
+        skeleton.setInverseBind((uint32_t)j, glm::inverse(worlds[j]));
+    }
+}
+
+static std::vector<JointTrack> random_tracks(const Skeleton& skeleton, float duration, std::mt19937& rng) {
+    std::vector<JointTrack> tracks(skeleton.jointCount());
+
+    // keys on a 30 fps grid with gaps, the way exporters bake them
+    const int lastFrame = (int)std::round(duration * 30.0f);
+    for (size_t j = 0; j < tracks.size(); j++) {
+        JointTrack& track = tracks[j];
+        for (int frame = 0;; frame += 3 + (int)(rng() % 7)) {
+            frame = std::min(frame, lastFrame);
+            float time = frame / 30.0f;
+            track.rotationTimes.push_back(time);
+            track.rotations.push_back(skeleton.bindRotations()[j] * random_rotation(rng, 0.4f));
+            if (frame == lastFrame) {
+                break;
+            }
+        }
+        // the root also moves
+        if (j == 0) {
+            track.positionTimes = { 0.0f, duration * 0.5f, duration };
+            track.positions = { glm::vec3(0.0f), glm::vec3(0.0f, 0.1f, 1.0f), glm::vec3(0.0f) };
+        }
+    }
+    return tracks;
+}
+
+static glm::quat evaluate_rotation(const JointTrack& track, float time) {
+    auto next = std::upper_bound(track.rotationTimes.begin(), track.rotationTimes.end(), time);
+    if (next == track.rotationTimes.end()) {
+        return track.rotations.back();
+    }
+    size_t key = std::max<size_t>(1, next - track.rotationTimes.begin()) - 1;
+    float blend = (time - track.rotationTimes[key]) / (track.rotationTimes[key + 1] - track.rotationTimes[key]);
+    return glm::normalize(glm::slerp(track.rotations[key], track.rotations[key + 1], blend));
+}
+
+// Rotation error in degrees of joints bound with one axis scaled to zero, NaN if any joint
+// with more collapsed axes did not keep the identity it was given
+static float zero_scale_error(std::mt19937& rng) {
+    const glm::vec3 scales[] = { glm::vec3(0.0f, 1.0f, 2.0f), glm::vec3(1.5f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 0.0f),
+                                 glm::vec3(-1.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f) };
+    Skeleton skeleton;
+    std::vector<glm::quat> rotations;
+    for (const glm::vec3& scale : scales) {
+        rotations.push_back(random_rotation(rng, 3.0f));
+        skeleton.addJoint("collapsed", Skeleton::kNoJoint, compose_transform(glm::vec3(1.0f), rotations.back(), scale));
+    }
+
+    float error = 0.0f;
+    for (size_t j = 0; j < skeleton.jointCount(); j++) {
+        const glm::quat r = skeleton.bindRotations()[j];
+        const bool oneAxis = (scales[j].x == 0.0f) + (scales[j].y == 0.0f) + (scales[j].z == 0.0f) == 1;
+        glm::quat expected = oneAxis ? rotations[j] : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        // -x next to a collapsed y reads back as x and y both flipped: a half turn about z, same matrix
+        if (scales[j].x < 0.0f) {
+            expected = expected * glm::quat(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        const float d = std::fabs(glm::dot(r, expected));
+        if (std::isnan(d)) {
+            return d;
+        }
+        error = std::fmax(error, 2.0f * std::acos(std::fmin(1.0f, d)));
+    }
+    return error * 57.29578f;
+}
+
+// Position error of a clip that is not a whole number of frames long, its root moving at a
+// constant speed: resampling a straight line is exact, so any error is in the frame times
+static float partial_frame_error() {
+    Skeleton skeleton;
+    skeleton.addJoint("root", Skeleton::kNoJoint, glm::mat4(1.0f));
+
+    const float duration = 1.01f;           // 30.3 frames at 30 Hz
+    JointTrack track;
+    track.positionTimes = { 0.0f, duration };
+    track.positions = { glm::vec3(0.0f), glm::vec3(duration, 0.0f, 0.0f) };
+    AnimationClip clip;
+    clip.build("partial", duration, skeleton, { track });
+
+    glm::vec3 t, s;
+    glm::quat r;
+    float error = 0.0f;
+    for (int i = 0; i <= 101; i++) {
+        const float time = duration * i / 101.0f;
+        clip.sample(time, false, &t, &r, &s);
+        error = std::fmax(error, std::fabs(t.x - time));
+    }
+    return error;
+}
+
+static float max_difference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b) {
+    float result = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                result = std::fmax(result, std::fabs(a[i][c][r] - b[i][c][r]));
+            }
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    size_t characters = argc > 2 ? (size_t)strtoull(argv[2], nullptr, 10) : 1000;
+    size_t jointCount = argc > 3 ? (size_t)strtoull(argv[3], nullptr, 10) : 64;
+    size_t vertexCount = argc > 4 ? (size_t)strtoull(argv[4], nullptr, 10) : 4000;
+
+    std::mt19937 rng(11);
+    Skeleton skeleton;
+    build_skeleton(skeleton, jointCount, rng);
+
+    const float durations[] = { 1.2f, 2.0f, 3.5f };
+    std::vector<std::vector<JointTrack>> tracks;
+    std::vector<AnimationClip> clips(3);
+    size_t clipBytes = 0;
+    for (size_t c = 0; c < clips.size(); c++) {
+        tracks.push_back(random_tracks(skeleton, durations[c], rng));
+        clips[c].build("clip" + std::to_string(c), durations[c], skeleton, tracks[c], AnimationClip::suggestedSampleRate(tracks[c]));
+        clipBytes += clips[c].byteSize();
+    }
+
+    // resampling error against the original keys, at the default rate and at the key rate
+    auto resample_error = [&](float rate) {
+        AnimationClip clip;
+        clip.build("check", durations[0], skeleton, tracks[0], rate);
+
+        std::vector<glm::vec3> t(jointCount), s(jointCount);
+        std::vector<glm::quat> r(jointCount);
+        std::mt19937 timeRng(9);
+        std::uniform_real_distribution<float> when(0.0f, durations[0]);
+        float error = 0.0f;
+        for (int i = 0; i < 200; i++) {
+            float time = when(timeRng);
+            clip.sample(time, false, t.data(), r.data(), s.data());
+            for (size_t j = 0; j < jointCount; j++) {
+                float d = std::fabs(glm::dot(r[j], evaluate_rotation(tracks[0][j], time)));
+                error = std::fmax(error, 2.0f * std::acos(std::fmin(1.0f, d)));
+            }
+        }
+        return error * 57.29578f;
+    };
+    const float keyRate = AnimationClip::suggestedSampleRate(tracks[0]);
+    const float defaultRateError = resample_error(AnimationClip::kDefaultSampleRate);
+    const float keyRateError = resample_error(keyRate);
+
+    std::uniform_real_distribution<float> start(0.0f, 4.0f);
+    std::uniform_real_distribution<float> speed(0.8f, 1.25f);
+    auto populate = [&](AnimationSystem& system) {
+        std::mt19937 instanceRng(5);
+        for (size_t i = 0; i < characters; i++) {
+            system.add(skeleton, clips[i % clips.size()], start(instanceRng), speed(instanceRng));
+        }
+    };
+
+    AnimationSystem scalar, simd, pooled;
+    populate(scalar);
+    populate(simd);
+    populate(pooled);
+
+    ThreadPool& pool = ThreadPool::get();
+    const float dt = 1.0f / 60.0f;
+
+    printf("%zu characters, %zu joints, %zu palette matrices (%.1f KB per frame upload), clips %.1f KB, %u threads\n",
+        characters, jointCount, scalar.jointsEvaluated(), scalar.jointsEvaluated() * sizeof(glm::mat4) / 1024.0,
+        clipBytes / 1024.0, pool.threadCount());
+    printf("resampling error vs keyframes: %.3f deg max at %.0f Hz, %.3f deg at the suggested %.0f Hz\n\n",
+        defaultRateError, AnimationClip::kDefaultSampleRate, keyRateError, keyRate);
+
+    // one checked frame first
+    set_simd_level(SimdLevel::Scalar);
+    scalar.update(dt);
+    set_simd_level(simd_supported());
+    simd.update(dt);
+    pooled.update(dt, pool);
+    float simdError = std::fmax(max_difference(scalar.palettes(), simd.palettes()), max_difference(scalar.palettes(), pooled.palettes()));
+
+    double scalarTime = 0.0, simdTime = 0.0, pooledTime = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        set_simd_level(SimdLevel::Scalar);
+        auto begin = Clock::now();
+        scalar.update(dt);
+        scalarTime += seconds(Clock::now() - begin);
+
+        set_simd_level(simd_supported());
+        begin = Clock::now();
+        simd.update(dt);
+        simdTime += seconds(Clock::now() - begin);
+
+        begin = Clock::now();
+        pooled.update(dt, pool);
+        pooledTime += seconds(Clock::now() - begin);
+    }
+
+    printf("%-12s %10s %14s %14s\n", "path", "ms/frame", "us/character", "M joints/s");
+    auto report = [&](const char* name, double total) {
+        double perFrame = total / frames;
+        printf("%-12s %10.3f %14.3f %14.1f\n", name, perFrame * 1e3, perFrame / characters * 1e6,
+            scalar.jointsEvaluated() / perFrame * 1e-6);
+    };
+    report("scalar", scalarTime);
+    report(simd_level_name(simd_supported()), simdTime);
+    report("SIMD pool", pooledTime);
+    printf("SIMD vs scalar palettes: max difference %g\n\n", simdError);
+
+    // CPU skinning: a blob of vertices around the joints, up to four influences each
+    std::vector<SkinnedVertex> vertices(vertexCount);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (SkinnedVertex& v : vertices) {
+        v.position = glm::vec3(unit(rng), unit(rng) + 1.0f, unit(rng));
+        v.normal = glm::normalize(v.position);
+        float total = 0.0f;
+        for (int k = 0; k < 4; k++) {
+            v.joints[k] = k < 3 ? (int)(rng() % jointCount) : -1;
+            v.weights[k] = k < 3 ? 0.1f + std::fabs(unit(rng)) : 0.0f;
+            total += v.weights[k];
+        }
+        for (float& w : v.weights) {
+            w /= total;
+        }
+    }
+    const SkinningLayout layout = { sizeof(SkinnedVertex), offsetof(SkinnedVertex, position), offsetof(SkinnedVertex, normal),
+                                    offsetof(SkinnedVertex, joints), offsetof(SkinnedVertex, weights) };
+
+    std::vector<glm::vec3> positions(vertexCount), normals(vertexCount);
+    std::vector<glm::mat4> identity(jointCount, glm::mat4(1.0f));
+    skin_vertices(vertices.data(), vertexCount, layout, identity.data(), positions.data(), normals.data());
+    float bindError = 0.0f;
+    for (size_t i = 0; i < vertexCount; i++) {
+        bindError = std::fmax(bindError, glm::length(positions[i] - vertices[i].position));
+    }
+
+    const size_t skinned = std::min<size_t>(characters, 100);
+    auto begin = Clock::now();
+    for (size_t i = 0; i < skinned; i++) {
+        skin_vertices(vertices.data(), vertexCount, layout, simd.palette((uint32_t)i), positions.data(), normals.data());
+    }
+    double skinTime = seconds(Clock::now() - begin);
+    printf("CPU skinning: %zu characters x %zu vertices in %.3f ms (%.1f M vertices/s), bind pose error %g\n",
+        skinned, vertexCount, skinTime * 1e3, skinned * vertexCount / skinTime * 1e-6, bindError);
+
+    const float zeroScaleError = zero_scale_error(rng);
+    printf("joints bound with an axis scaled to zero: rotation error %.4f deg\n", zeroScaleError);
+
+    const float partialFrameError = partial_frame_error();
+    printf("clip of 30.3 frames, moving at a constant speed: position error %g\n", partialFrameError);
+
+    if (simdError > 1e-3f || bindError > 1e-5f || !(zeroScaleError < 0.01f) || partialFrameError > 1e-5f) {
+        fprintf(stderr, "ERROR: animation results disagree (palettes %g, bind pose %g, zero scale %g, partial frame %g)\n",
+                simdError, bindError, zeroScaleError, partialFrameError);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,301 @@
+// Software rasterizer benchmark, no GPU needed
+//
+// Checks first:
+//   - watertightness: a screen-sized grid of jittered triangles, each one nearer than the one
+//     before, must write every pixel exactly once (a hole leaves the clear depth, a pixel
+//     covered twice is written twice)
+//   - the cube field renders to the same depth and color bits at every SIMD level and thread
+//     count, and at the default size and cube count to the golden hashes below
+// then renders the cube field (Mesh of the Cube vertex data, Camera matrices, as the GL path)
+// and prints the triangles per second per core of every SIMD level on one thread and on the
+// whole pool, depth only and with colors, with the bin and raster split.
+// Finally the depth only image is used as occluders: it builds a DepthPyramid and counts the
+// boxes of a second, farther field it hides, none of which may be in front of a texel it covers.
+//
+// usage: software-rasterizer [width] [height] [cubes] [frames]   (default: 640 360 4000 20)
+
+#include "engine/core/Camera.hpp"
+#include "engine/core/Cube.hpp"
+#include "engine/core/Mesh.h"
+#include "engine/core/ThreadPool.h"
+#include "engine/math/BatchMath.h"
+#include "engine/render/OcclusionCulling.h"
+#include "engine/render/SoftwareRasterizer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// the default scene, 640x360 with 4000 cubes; a change that means to alter the image updates these
+static const int kGoldenWidth = 640;
+static const int kGoldenHeight = 360;
+static const int kGoldenCubes = 4000;
+static const uint64_t kGoldenDepth = 0xfa5f7191d1292529ull;
+static const uint64_t kGoldenColor = 0xa8e97cca043b6aefull;
+
+/// FNV-1a of a buffer
+static uint64_t hash_bytes(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+struct CubeField {
+    Mesh cube;
+    std::vector<glm::mat4> models;
+    std::vector<glm::vec3> albedos;
+    glm::mat4 viewProjection;
+};
+
+/// Cubes scattered in front of the camera, rotated and scaled, some crossing the near plane
+static void build_field(CubeField& field, int count, float aspect) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    field.models.clear();
+    field.albedos.clear();
+    for (int i = 0; i < count; i++) {
+        const glm::vec3 position(unit(rng) * 80.0f - 40.0f, unit(rng) * 30.0f - 15.0f, -unit(rng) * 90.0f + 6.5f);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, unit(rng) * 6.28f, glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + 0.1f));
+        model = glm::scale(model, glm::vec3(0.5f + unit(rng) * 2.5f));
+        field.models.push_back(model);
+        field.albedos.push_back(glm::vec3(0.2f + 0.8f * unit(rng), 0.2f + 0.8f * unit(rng), 0.2f + 0.8f * unit(rng)));
+    }
+
+    Camera camera(glm::vec3(0.0f, 2.0f, 6.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+    field.viewProjection = projection * camera.GetViewMatrix();
+}
+
+static void draw_field(SoftwareRasterizer& raster, const CubeField& field) {
+    raster.clear(1.0f, 0xff302010u);
+    for (size_t i = 0; i < field.models.size(); i++) {
+        raster.submit(field.cube, field.models[i], field.viewProjection, field.albedos[i]);
+    }
+    raster.render();
+}
+
+static bool check_watertight(ThreadPool& pool, int width, int height) {
+    SoftwareRasterizer raster(&pool);
+    raster.setColorEnabled(false);
+    raster.resize(width, height);
+    raster.clear();
+
+    // grid vertices in NDC, interior ones jittered so the edges are at every angle
+    const int cells = 23;
+    std::mt19937 rng(width + height);
+    std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+    std::vector<glm::vec2> grid((cells + 1) * (cells + 1));
+    for (int y = 0; y <= cells; y++) {
+        for (int x = 0; x <= cells; x++) {
+            const bool border = x == 0 || y == 0 || x == cells || y == cells;
+            grid[y * (cells + 1) + x] = glm::vec2((x + (border ? 0.0f : jitter(rng))) / cells * 2.0f - 1.0f,
+                                                  (y + (border ? 0.0f : jitter(rng))) / cells * 2.0f - 1.0f);
+        }
+    }
+
+    // one submit per triangle, each nearer than the last, so the depth test never hides a second write
+    size_t triangles = 0;
+    const glm::mat4 identity(1.0f);
+    for (int y = 0; y < cells; y++) {
+        for (int x = 0; x < cells; x++) {
+            const glm::vec2 corners[4] = { grid[y * (cells + 1) + x], grid[y * (cells + 1) + x + 1],
+                                           grid[(y + 1) * (cells + 1) + x + 1], grid[(y + 1) * (cells + 1) + x] };
+            const int split[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+            for (const int* corner : split) {
+                const float z = 0.9f - triangles * 1e-4f;
+                float positions[9];
+                for (int k = 0; k < 3; k++) {
+                    positions[k * 3 + 0] = corners[corner[k]].x;
+                    positions[k * 3 + 1] = corners[corner[k]].y;
+                    positions[k * 3 + 2] = z;
+                }
+                raster.submit(positions, 3 * sizeof(float), 3, nullptr, 0, identity, identity);
+                triangles++;
+            }
+        }
+    }
+    raster.render();
+
+    size_t holes = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            holes += raster.depthAt(x, y) == 1.0f;
+        }
+    }
+    const uint64_t pixels = (uint64_t)width * height;
+    printf("  %4dx%-4d %-6s %zu triangles: %llu pixels written for %llu, %zu holes\n", width, height,
+           simd_level_name(simd_level()), triangles, (unsigned long long)raster.stats().pixels,
+           (unsigned long long)pixels, holes);
+    if (holes || raster.stats().pixels != pixels) {
+        printf("FAILED: the grid is not covered exactly once\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int width = argc > 1 ? atoi(argv[1]) : 640;
+    const int height = argc > 2 ? atoi(argv[2]) : 360;
+    const int cubes = argc > 3 ? atoi(argv[3]) : 4000;
+    const int frames = argc > 4 ? atoi(argv[4]) : 20;
+
+    std::vector<SimdLevel> levels = { SimdLevel::Scalar };
+    if ((int)simd_supported() >= (int)SimdLevel::SSE) {
+        levels.push_back(SimdLevel::SSE);
+    }
+    if ((int)simd_supported() >= (int)SimdLevel::AVX2) {
+        levels.push_back(SimdLevel::AVX2);
+    }
+
+    ThreadPool single(0);
+    ThreadPool& pool = ThreadPool::get();
+    ThreadPool* pools[2] = { &single, &pool };
+    // more threads than cores, for the determinism check on small machines
+    ThreadPool oversubscribed(4);
+
+    printf("watertightness\n");
+    for (SimdLevel level : levels) {
+        set_simd_level(level);
+        for (const glm::ivec2 size : { glm::ivec2(97, 61), glm::ivec2(320, 180), glm::ivec2(width, height) }) {
+            if (!check_watertight(pool, size.x, size.y)) {
+                printf("FAILED\n");
+                return 1;
+            }
+        }
+    }
+
+    CubeField field{ Mesh(CUBE_VERTICES_POS_NORM), {}, {}, glm::mat4(1.0f) };
+    build_field(field, cubes, (float)width / height);
+
+    // golden images: every level and thread count must agree to the bit, and with the committed hashes
+    printf("\n%dx%d, %d cubes, %u triangles each\n\n", width, height, cubes, field.cube.vertexCount() / 3);
+    uint64_t depthHash = 0, colorHash = 0;
+    bool ok = true;
+    std::vector<float> depth;
+    std::vector<unsigned char> color;
+    for (SimdLevel level : levels) {
+        set_simd_level(level);
+        for (ThreadPool* threads : { &single, &pool, &oversubscribed }) {
+            SoftwareRasterizer raster(threads);
+            raster.resize(width, height);
+            draw_field(raster, field);
+            raster.readDepth(depth);
+            raster.readColor(color);
+            const uint64_t d = hash_bytes(depth.data(), depth.size() * sizeof(float));
+            const uint64_t c = hash_bytes(color.data(), color.size());
+            if (depthHash == 0) {
+                depthHash = d;
+                colorHash = c;
+                const RasterStats& stats = raster.stats();
+                printf("triangles %zu, clipped %zu, culled %zu, binned %zu, %.2f tiles per triangle, %llu pixels written\n",
+                       stats.triangles, stats.clipped, stats.culled, stats.binned,
+                       (double)stats.tileTriangles / std::max<size_t>(stats.binned, 1), (unsigned long long)stats.pixels);
+                printf("depth %016llx, color %016llx\n", (unsigned long long)d, (unsigned long long)c);
+                if (width != kGoldenWidth || height != kGoldenHeight || cubes != kGoldenCubes) {
+                    printf("no golden hashes for this scene, only the levels and thread counts are compared\n\n");
+                } else if (d != kGoldenDepth || c != kGoldenColor) {
+                    printf("FAILED: the golden hashes are depth %016llx, color %016llx\n\n", (unsigned long long)kGoldenDepth,
+                           (unsigned long long)kGoldenColor);
+                    ok = false;
+                } else {
+                    printf("matches the golden hashes\n\n");
+                }
+            } else if (d != depthHash || c != colorHash) {
+                printf("FAILED: %s on %u threads renders %016llx / %016llx\n", simd_level_name(level),
+                       raster.threadCount(), (unsigned long long)d, (unsigned long long)c);
+                ok = false;
+            }
+        }
+    }
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    printf("%-7s %-6s %8s %9s %8s %10s %12s %9s\n", "buffers", "simd", "threads", "frame ms", "bin ms", "raster ms",
+           "Mtris/s", "per core");
+    for (bool colors : { false, true }) {
+        for (SimdLevel level : levels) {
+            set_simd_level(level);
+            for (ThreadPool* threads : pools) {
+                SoftwareRasterizer raster(threads);
+                raster.setColorEnabled(colors);
+                raster.resize(width, height);
+                draw_field(raster, field);
+
+                double binMs = 0.0, rasterMs = 0.0;
+                const auto start = Clock::now();
+                for (int frame = 0; frame < frames; frame++) {
+                    draw_field(raster, field);
+                    binMs += raster.stats().binMs;
+                    rasterMs += raster.stats().rasterMs;
+                }
+                const double elapsed = seconds(Clock::now() - start);
+                const double trianglesPerSecond = (double)raster.stats().triangles * frames / elapsed;
+                printf("%-7s %-6s %8u %9.3f %8.3f %10.3f %12.2f %9.2f\n", colors ? "color" : "depth",
+                       simd_level_name(level), raster.threadCount(), elapsed * 1000.0 / frames, binMs / frames,
+                       rasterMs / frames, trianglesPerSecond * 1e-6, trianglesPerSecond * 1e-6 / raster.threadCount());
+            }
+        }
+    }
+    set_simd_level(simd_supported());
+
+    // occluders: the depth only image hides a farther field of small cubes
+    SoftwareRasterizer raster(&pool);
+    raster.setColorEnabled(false);
+    raster.resize(width, height);
+    draw_field(raster, field);
+    raster.readDepth(depth);
+    DepthPyramid pyramid;
+    const auto buildStart = Clock::now();
+    pyramid.build(depth.data(), width, height);
+    const double buildMs = seconds(Clock::now() - buildStart) * 1000.0;
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    int tested = 0, hidden = 0;
+    size_t wrong = 0;
+    for (int i = 0; i < 10000; i++) {
+        const glm::vec3 center(unit(rng) * 60.0f - 30.0f, unit(rng) * 20.0f - 10.0f, -60.0f - unit(rng) * 30.0f);
+        const ProjectedBox box = project_box(center - 0.5f, center + 0.5f, field.viewProjection);
+        if (box.outside || box.crossesNear) {
+            continue;
+        }
+        tested++;
+        if (!box_occluded(pyramid, box)) {
+            continue;
+        }
+        hidden++;
+        // never hidden by a texel the box is in front of
+        const int x0 = std::min((int)(box.uvMin.x * width), width - 1), x1 = std::min((int)(box.uvMax.x * width), width - 1);
+        const int y0 = std::min((int)(box.uvMin.y * height), height - 1), y1 = std::min((int)(box.uvMax.y * height), height - 1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                wrong += depth[(size_t)y * width + x] > box.nearestDepth;
+            }
+        }
+    }
+    printf("\noccluders: pyramid built in %.3f ms, %d of %d boxes in the frustum hidden (%.0f%%)\n", buildMs, hidden,
+           tested, 100.0 * hidden / std::max(tested, 1));
+    if (wrong) {
+        printf("FAILED: %zu depth texels are behind boxes the pyramid hides\n", wrong);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Transform hierarchy update benchmark
+//
+// Builds a forest of characters, each a random tree of nodes, and runs a few frame
+// patterns through TransformHierarchy:
+//   static        nothing changes
+//   animated 1%   1% of the nodes get a new local transform
+//   roots moved   every character root moves, all nodes below follow
+//   all dirty     every node changes
+// For each pattern the dirty-flag update runs serially and on the thread pool, next to a
+// full recompute of every node (what a hierarchy without dirty flags pays every frame).
+// Prints the matrices recomputed per frame; the parallel results are checked against the
+// serial ones.
+//
+// usage: transform-hierarchy [frames] [characters] [nodes per character]   (default: 100 2000 64)
+
+#include "engine/scene/TransformHierarchy.h"
+#include "engine/scene/Components.h"
+#include "engine/core/ThreadPool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static glm::mat4 random_local(std::mt19937& rng) {
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    glm::vec3 axis = glm::normalize(glm::vec3(offset(rng), offset(rng), offset(rng) + 2.0f));
+    return compose_transform(glm::vec3(offset(rng), offset(rng), offset(rng)), glm::angleAxis(angle(rng), axis), glm::vec3(1.0f));
+}
+
+static void build(TransformHierarchy& hierarchy, std::vector<uint32_t>& roots, size_t characters, size_t nodesPerCharacter) {
+    std::mt19937 rng(7);
+    hierarchy.reserve(characters * nodesPerCharacter);
+
+    for (size_t c = 0; c < characters; c++) {
+        uint32_t root = hierarchy.add(TransformHierarchy::kNoParent, random_local(rng));
+        roots.push_back(root);
+
+        // depth first like a skeleton: mostly chains, sometimes branching back up
+        std::vector<uint32_t> stack = { root };
+        for (size_t n = 1; n < nodesPerCharacter; n++) {
+            if (stack.size() > 1 && rng() % 4 == 0) {
+                stack.resize(1 + rng() % (stack.size() - 1));
+            }
+            stack.push_back(hierarchy.add(stack.back(), random_local(rng)));
+        }
+    }
+    hierarchy.update();
+}
+
+static void full_recompute(const TransformHierarchy& hierarchy, std::vector<glm::mat4>& worlds) {
+    for (uint32_t i = 0; i < hierarchy.size(); i++) {
+        uint32_t parent = hierarchy.parent(i);
+        worlds[i] = parent == TransformHierarchy::kNoParent ? hierarchy.local(i) : worlds[parent] * hierarchy.local(i);
+    }
+}
+
+static float max_difference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b) {
+    float result = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                result = std::fmax(result, std::fabs(a[i][c][r] - b[i][c][r]));
+            }
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 100;
+    size_t characters = argc > 2 ? (size_t)strtoull(argv[2], nullptr, 10) : 2000;
+    size_t nodesPerCharacter = argc > 3 ? (size_t)strtoull(argv[3], nullptr, 10) : 64;
+
+    ThreadPool& pool = ThreadPool::get();
+
+    // two identical hierarchies fed the same changes: one updated serially, one in parallel
+    TransformHierarchy serial, parallel;
+    std::vector<uint32_t> roots, unused;
+    build(serial, roots, characters, nodesPerCharacter);
+    build(parallel, unused, characters, nodesPerCharacter);
+    const size_t nodeCount = serial.size();
+
+    std::vector<glm::mat4> fullWorlds(nodeCount);
+    printf("%zu characters x %zu nodes = %zu nodes, %u threads\n\n", characters, nodesPerCharacter, nodeCount, pool.threadCount());
+    printf("%-12s %14s %12s %12s %12s %10s %10s\n", "pattern", "recomputed/fr", "subtrees/fr", "full ms", "serial ms", "pool ms", "max diff");
+
+    struct Pattern {
+        const char* name;
+        std::function<void(TransformHierarchy&, std::mt19937&)> change;
+    };
+
+    const Pattern patterns[] = {
+        { "static", [](TransformHierarchy&, std::mt19937&) {} },
+        { "animated 1%", [&](TransformHierarchy& h, std::mt19937& rng) {
+            for (size_t i = 0; i < nodeCount / 100; i++) {
+                h.setLocal(rng() % nodeCount, random_local(rng));
+            }
+        } },
+        { "roots moved", [&](TransformHierarchy& h, std::mt19937& rng) {
+            for (uint32_t root : roots) {
+                h.setLocal(root, random_local(rng));
+            }
+        } },
+        { "all dirty", [&](TransformHierarchy& h, std::mt19937& rng) {
+            for (uint32_t i = 0; i < nodeCount; i++) {
+                h.setLocal(i, random_local(rng));
+            }
+        } },
+    };
+
+    for (const Pattern& pattern : patterns) {
+        std::mt19937 serialRng(1), parallelRng(1);
+        double fullTime = 0.0, serialTime = 0.0, parallelTime = 0.0;
+        size_t recomputed = 0, subtrees = 0;
+
+        for (int frame = 0; frame < frames; frame++) {
+            // only the update is timed, not the changes
+            pattern.change(serial, serialRng);
+            pattern.change(parallel, parallelRng);
+
+            auto start = Clock::now();
+            full_recompute(serial, fullWorlds);
+            fullTime += seconds(Clock::now() - start);
+
+            start = Clock::now();
+            serial.update();
+            serialTime += seconds(Clock::now() - start);
+
+            start = Clock::now();
+            parallel.update(pool);
+            parallelTime += seconds(Clock::now() - start);
+
+            recomputed += serial.recomputed();
+            subtrees += serial.updatedSubtrees();
+        }
+
+        float diff = std::fmax(max_difference(serial.worlds(), parallel.worlds()), max_difference(serial.worlds(), fullWorlds));
+        printf("%-12s %14zu %12zu %12.3f %12.3f %10.3f %10g\n", pattern.name,
+            recomputed / frames, subtrees / frames,
+            fullTime / frames * 1e3, serialTime / frames * 1e3, parallelTime / frames * 1e3, diff);
+        if (diff > 1e-3f) {
+            fprintf(stderr, "ERROR: %s: hierarchy update disagrees with a full recompute (%g)\n", pattern.name, diff);
+            return 1;
+        }
+    }
+
+    return 0;
+}
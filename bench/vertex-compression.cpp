@@ -0,0 +1,249 @@
+// Vertex compression benchmark
+//
+// Builds a sphere grid with the same attributes as asset::Vertex (position, normal, UV, tangent,
+// bitangent, 4 joints + weights), compresses it with compress_vertices and decodes it back the
+// way the COMPRESSED_VERTICES shaders do. Reports bytes per vertex, the memory saved, encode and
+// decode throughput, and the worst error per attribute; exits 1 if an error is out of bounds.
+// Also round-trips every half float bit pattern, and checks that meshes without tangents
+// pack a defined tangent code.
+//
+// usage: vertex-compression [grid size] [joint count]   (default: 512 64; 300+ joints use 16-bit IDs)
+
+#include "engine/geometry/VertexCompression.h"
+#include "engine/math/Quantize.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// same layout as asset::Vertex, without pulling in GL headers
+struct SourceVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+    int joints[4];
+    float weights[4];
+};
+
+static const VertexSourceLayout kLayout = {
+    sizeof(SourceVertex), offsetof(SourceVertex, position), offsetof(SourceVertex, normal),
+    offsetof(SourceVertex, texCoord), offsetof(SourceVertex, tangent), offsetof(SourceVertex, bitangent),
+    offsetof(SourceVertex, joints), offsetof(SourceVertex, weights)
+};
+
+static std::vector<SourceVertex> make_sphere(int grid, int jointCount, bool skinned, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<int> joint(0, jointCount - 1);
+    const float pi = 3.14159265f;
+    const float radius = 1.7f;
+    const glm::vec3 center(12.0f, -3.0f, 40.0f);
+
+    std::vector<SourceVertex> vertices;
+    vertices.reserve((size_t)grid * grid);
+    for (int y = 0; y < grid; y++) {
+        for (int x = 0; x < grid; x++) {
+            const float u = (float)x / (grid - 1), v = (float)y / (grid - 1);
+            const float theta = u * 2.0f * pi, phi = v * pi;
+
+            SourceVertex vertex;
+            vertex.normal = glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            vertex.position = center + vertex.normal * radius;
+            // tiled UVs, to exercise half precision above 1
+            vertex.texCoord = glm::vec2(u * 4.0f, v * 2.0f);
+            glm::vec3 tangent(-std::sin(theta), 0.0f, std::cos(theta));
+            vertex.tangent = glm::normalize(tangent - vertex.normal * glm::dot(vertex.normal, tangent) + glm::vec3(1e-6f));
+            // mirrored UVs on half the sphere flip the bitangent
+            const float sign = x < grid / 2 ? 1.0f : -1.0f;
+            vertex.bitangent = glm::cross(vertex.normal, vertex.tangent) * sign;
+
+            float total = 0.0f;
+            const int influences = skinned ? 1 + (int)(unit(rng) * 4.0f) % 4 : 0;
+            for (int k = 0; k < 4; k++) {
+                vertex.joints[k] = k < influences ? joint(rng) : -1;
+                vertex.weights[k] = k < influences ? unit(rng) + 0.01f : 0.0f;
+                total += vertex.weights[k];
+            }
+            for (int k = 0; k < influences; k++) {
+                vertex.weights[k] /= total;
+            }
+            vertices.push_back(vertex);
+        }
+    }
+    return vertices;
+}
+
+// in double: a float acos near 1 alone is off by ~0.02 degrees
+static double angle_degrees(const glm::vec3& a, const glm::vec3& b) {
+    const double ax = a.x, ay = a.y, az = a.z, bx = b.x, by = b.y, bz = b.z;
+    const double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+    const double dot = ax * bx + ay * by + az * bz;
+    return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 57.29577951308232;
+}
+
+static bool check(const char* what, double error, double limit) {
+    const bool ok = error <= limit;
+    printf("  %-18s max error %12.6g  (limit %g)%s\n", what, error, limit, ok ? "" : "  FAILED");
+    return ok;
+}
+
+static bool bench(const char* name, const std::vector<SourceVertex>& vertices) {
+    const size_t count = vertices.size();
+
+    CompressedVertices packed;
+    auto start = Clock::now();
+    compress_vertices(vertices.data(), count, kLayout, packed);
+    const double encode = seconds(Clock::now() - start);
+
+    std::vector<DecodedVertex> decoded(count);
+    start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        decompress_vertex(packed, i, decoded[i]);
+    }
+    const double decode = seconds(Clock::now() - start);
+
+    const size_t full = count * sizeof(SourceVertex);
+    printf("%s: %zu vertices, %zu -> %zu bytes/vertex (%s joints), %.1f -> %.1f MB, %.1f MB saved (%.0f%%)\n",
+        name, count, sizeof(SourceVertex), packed.stride,
+        packed.jointBytes == 0 ? "no" : (packed.jointBytes == 1 ? "8-bit" : "16-bit"),
+        full / 1048576.0, packed.data.size() / 1048576.0, (full - packed.data.size()) / 1048576.0,
+        100.0 * (full - packed.data.size()) / full);
+    printf("  encode %7.2f ms  (%6.1f M vertices/s)   decode %7.2f ms  (%6.1f M vertices/s)\n",
+        encode * 1e3, count / encode * 1e-6, decode * 1e3, count / decode * 1e-6);
+
+    double position = 0.0, normal = 0.0, tangent = 0.0, uv = 0.0, weight = 0.0;
+    size_t signErrors = 0, jointErrors = 0;
+    for (size_t i = 0; i < count; i++) {
+        const SourceVertex& in = vertices[i];
+        const DecodedVertex& out = decoded[i];
+
+        position = std::fmax(position, glm::length(out.position - in.position));
+        normal = std::fmax(normal, angle_degrees(in.normal, out.normal));
+        tangent = std::fmax(tangent, angle_degrees(in.tangent, out.tangent));
+        if (glm::dot(in.bitangent, out.bitangent) <= 0.0f) {
+            signErrors++;
+        }
+        // half keeps 11 significant bits: relative error 2^-12
+        uv = std::fmax(uv, std::fabs(out.texCoord.x - in.texCoord.x) / std::fmax(std::fabs(in.texCoord.x), 1.0f));
+        uv = std::fmax(uv, std::fabs(out.texCoord.y - in.texCoord.y) / std::fmax(std::fabs(in.texCoord.y), 1.0f));
+
+        if (packed.skinned()) {
+            float total = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                if (in.joints[k] >= 0 && out.joints[k] != in.joints[k]) {
+                    jointErrors++;
+                }
+                weight = std::fmax(weight, std::fabs(out.weights[k] - in.weights[k]));
+                total += out.weights[k];
+            }
+            // the unorm8 weights must sum to exactly 255/255
+            if (std::fabs(total - 1.0f) > 1e-5f) {
+                jointErrors++;
+            }
+        }
+    }
+
+    const glm::vec3 extent = packed.positionScale;
+    const double quantum = glm::length(extent) / 65535.0;
+    bool ok = true;
+    ok &= check("position", position, quantum);
+    ok &= check("normal (degrees)", normal, 0.01);
+    ok &= check("tangent (degrees)", tangent, 0.01);
+    ok &= check("uv (relative)", uv, 1.0 / 2048.0);
+    if (packed.skinned()) {
+        ok &= check("weight", weight, 2.0 / 255.0);
+    }
+    ok &= check("bitangent signs", (double)signErrors, 0.0);
+    ok &= check("joints/weight sums", (double)jointErrors, 0.0);
+    printf("\n");
+    return ok;
+}
+
+static bool check_halves() {
+    size_t mismatches = 0;
+    for (uint32_t bits = 0; bits < 65536; bits++) {
+        const uint16_t half = (uint16_t)bits;
+        const float value = half_to_float(half);
+        if (value != value) {
+            continue;   // NaN payloads need not round-trip
+        }
+        if (float_to_half(value) != half) {
+            mismatches++;
+        }
+    }
+    printf("half round trip: %zu of 65536 bit patterns mismatch\n\n", mismatches);
+    return mismatches == 0;
+}
+
+/// Meshes without tangents: zero tangents and an absent tangent attribute pack as code (0, 0)
+static bool check_missing_tangents() {
+    std::vector<SourceVertex> vertices(4);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        SourceVertex& vertex = vertices[i];
+        vertex.position = glm::vec3((float)i, 0.0f, 1.0f);
+        vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        vertex.texCoord = glm::vec2(0.0f);
+        vertex.tangent = glm::vec3(0.0f);
+        vertex.bitangent = glm::vec3(0.0f);
+    }
+
+    VertexSourceLayout noTangents = kLayout;
+    noTangents.tangent = VertexSourceLayout::kAbsent;
+    noTangents.bitangent = VertexSourceLayout::kAbsent;
+    noTangents.joints = VertexSourceLayout::kAbsent;
+    noTangents.weights = VertexSourceLayout::kAbsent;
+    VertexSourceLayout zeroTangents = noTangents;
+    zeroTangents.tangent = kLayout.tangent;
+    zeroTangents.bitangent = kLayout.bitangent;
+
+    size_t bad = 0;
+    for (const VertexSourceLayout& layout : { zeroTangents, noTangents }) {
+        CompressedVertices packed;
+        compress_vertices(vertices.data(), vertices.size(), layout, packed);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            PackedVertex v;
+            std::memcpy(&v, packed.data.data() + i * packed.stride, sizeof(v));
+            DecodedVertex decoded;
+            decompress_vertex(packed, i, decoded);
+            const bool finite = std::isfinite(decoded.tangent.x) && std::isfinite(decoded.tangent.y) && std::isfinite(decoded.tangent.z);
+            bad += v.tangent[0] != 0 || v.tangent[1] != 0 || !finite ? 1 : 0;
+        }
+    }
+    printf("missing tangents: %zu of %zu vertices with a tangent code other than (0, 0)\n\n", bad, 2 * vertices.size());
+    return bad == 0;
+}
+
+int main(int argc, char** argv) {
+    int grid = argc > 1 ? atoi(argv[1]) : 512;
+    int joints = argc > 2 ? atoi(argv[2]) : 64;
+    if (grid < 2 || joints < 1) {
+        fprintf(stderr, "usage: vertex-compression [grid size >= 2] [joint count >= 1]\n");
+        return 1;
+    }
+
+    bool ok = check_halves();
+    ok &= check_missing_tangents();
+
+    std::mt19937 rng(7);
+    ok &= bench("static mesh", make_sphere(grid, joints, false, rng));
+    ok &= bench("skinned mesh", make_sphere(grid, joints, true, rng));
+    ok &= bench("skinned mesh, 300 joints", make_sphere(grid, 300, true, rng));
+
+    if (!ok) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}